@@ -27,9 +27,12 @@
 
 #include "harness_export.h"
 
+#include <ctime>
 #include <memory>
 #include <string>
 
+#include <sys/stat.h>
+#include <sys/types.h>
 
 namespace mysql_harness {
 
@@ -476,6 +479,35 @@ int delete_dir_recursive(const std::string& dir) noexcept;
 HARNESS_EXPORT
 std::string get_tmp_dir(const std::string& name = "router");
 
+/**
+ * What identifies the content of a file without reading it.
+ *
+ * @ingroup Filesystem
+ *
+ * Used to tell if a cached copy of a file is still current. The inode
+ * catches files replaced by rename() within the resolution of the
+ * modification time.
+ */
+struct HARNESS_EXPORT FileVersion {
+  time_t mtime;
+  long mtime_nsec;
+  ino_t ino;
+  // -1 if the file doesn't exist
+  off_t size;
+
+  /**
+   * Version of a file from what stat() returned for it.
+   */
+  static FileVersion from_stat(const struct stat& st);
+
+  bool operator==(const FileVersion& other) const {
+    return mtime == other.mtime && mtime_nsec == other.mtime_nsec &&
+           ino == other.ino && size == other.size;
+  }
+
+  bool operator!=(const FileVersion& other) const { return !(*this == other); }
+};
+
 } // namespace mysql_harness
 
 #endif /* MYSQL_HARNESS_FILESYSTEM_INCLUDED */
@@ -28,10 +28,16 @@
 #include "mysql/harness/logging/logging.h"
 #include "harness_export.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace mysql_harness {
 
@@ -65,6 +71,13 @@ class HARNESS_EXPORT Handler {
 
   void handle(const Record& record);
 
+  /**
+   * Handle several records at once.
+   *
+   * Used by AsyncHandler to pass on the records it collected.
+   */
+  void handle_batch(const std::vector<Record>& records);
+
   void set_level(LogLevel level) { level_ = level; }
   LogLevel get_level() const { return level_; }
 
@@ -86,6 +99,16 @@ class HARNESS_EXPORT Handler {
    */
   virtual void do_log(const Record& record) = 0;
 
+  /**
+   * Log several records.
+   *
+   * Calls do_log() for each record by default. Handlers can override
+   * it to write the records in one go.
+   *
+   * @param records Records in the order they shall be logged.
+   */
+  virtual void do_log_batch(const std::vector<Record>& records);
+
   /**
    * Flags if log messages should be formatted (prefixed with log level,
    * timestamp, etc) before logging.
@@ -121,6 +144,7 @@ class HARNESS_EXPORT StreamHandler : public Handler {
 
  private:
   void do_log(const Record& record) override;
+  void do_log_batch(const std::vector<Record>& records) override;
 };
 
 /**
@@ -145,6 +169,76 @@ class HARNESS_EXPORT FileHandler : public StreamHandler {
   std::ofstream fstream_;
 };
 
+/**
+ * Handler that passes the records to another handler in a background thread.
+ *
+ * Logging threads append the record to a ring-buffer of their own without
+ * taking a lock and return. A writer thread collects the records of all
+ * threads and passes them in batches to the wrapped handler.
+ *
+ * If the ring-buffer of a thread is full, the record is dropped. Dropped
+ * records are counted and reported to the wrapped handler.
+ *
+ * @code
+ * registry.add_handler("async", std::make_shared<AsyncHandler>(
+ *     std::make_shared<FileHandler>("/var/log/router.log")));
+ * @endcode
+ */
+class HARNESS_EXPORT AsyncHandler : public Handler {
+ public:
+  static constexpr const char* kDefaultName = "async";
+
+  /**
+   * @param handler handler to pass the records to
+   * @param ring_size records a thread can log before the writer catches up
+   */
+  explicit AsyncHandler(std::shared_ptr<Handler> handler,
+                        size_t ring_size = 4096);
+
+  /**
+   * Passes on the pending records and stops the writer thread.
+   */
+  ~AsyncHandler();
+
+  /**
+   * Wait until all records logged so far are passed to the wrapped handler.
+   */
+  void flush();
+
+  /**
+   * Number of records dropped as a ring-buffer was full.
+   */
+  uint64_t get_dropped() const { return dropped_.load(); }
+
+ private:
+  class Ring;
+
+  void do_log(const Record& record) override;
+
+  Ring& get_thread_ring();
+
+  void run_writer();
+
+  std::shared_ptr<Handler> handler_;
+  const size_t ring_size_;
+
+  // identifies the rings of this handler in the thread-local storage
+  const uint64_t id_;
+
+  std::atomic<uint64_t> dropped_{0};
+  uint64_t dropped_reported_{0};
+
+  // protects rings_ and the writer's state below
+  std::mutex mtx_;
+  std::condition_variable cond_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  bool stop_{false};
+  uint64_t flush_requested_{0};
+  uint64_t flush_done_{0};
+
+  std::thread writer_;
+};
+
 
 }  // namespace logging
 
@@ -34,10 +34,13 @@
 #include "mysql/harness/filesystem.h"
 #include "harness_export.h"
 
+#include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <mutex>
 #include <list>
 #include <string>
+#include <thread>
 #include <cstdarg>
 
 #ifndef _WIN32
@@ -85,6 +88,12 @@ const size_t kLogMessageMaxSize = 4096;
 constexpr char kConfigOptionLogLevel[] = "level";
 constexpr char kConfigSectionLogger[] = "logger";
 
+/**
+ * Option in the [logger] section to write the log in a background thread
+ * (see AsyncHandler).
+ */
+constexpr char kConfigOptionLogAsync[] = "async";
+
 /**
  * Special names reserved for "main" program logger. It will use one of the
  * two handlers, depending on whether logging_folder is empty or not.
@@ -157,13 +166,42 @@ const char* const kRawLogLevelName = "info";
  * The log record is passed to the handlers together with message.
  */
 struct Record {
+  Record(LogLevel level_, pid_t process_id_, time_t created_,
+         std::string domain_, std::string message_,
+         std::thread::id thread_id_ = std::this_thread::get_id())
+      : level(level_), process_id(process_id_), created(created_),
+        domain(std::move(domain_)), message(std::move(message_)),
+        thread_id(thread_id_) {}
+
   LogLevel level;
   pid_t process_id;
   time_t created;
   std::string domain;
   std::string message;
+  // thread which logged the record, handlers may run in another thread
+  std::thread::id thread_id;
 };
 
+/**
+ * Generation of the log levels.
+ *
+ * Incremented by the Registry whenever loggers are created, removed or
+ * updated, which invalidates the levels cached by log_level_is_handled().
+ */
+HARNESS_EXPORT
+extern std::atomic<uint64_t> g_log_level_generation;
+
+/**
+ * Get the log level up to which messages of a log domain are handled.
+ *
+ * Messages of a domain without logger are logged as the main application
+ * domain, hence its level is returned for them. Before the logging facility
+ * is ready, LogLevel::kNotSet is returned.
+ *
+ * @param domain Log domain
+ */
+HARNESS_EXPORT
+LogLevel get_log_level_for_domain(const char *domain);
 
 
 /**
@@ -203,12 +241,43 @@ static inline void log_warning(const char *fmt, ...) ATTRIBUTE_GCC_FORMAT(printf
 static inline void log_info(const char *fmt, ...) ATTRIBUTE_GCC_FORMAT(printf, 1, 2);
 static inline void log_debug(const char *fmt, ...) ATTRIBUTE_GCC_FORMAT(printf, 1, 2);
 
+/**
+ * Check if messages of a log level are handled for the module's log domain.
+ *
+ * log_error() and friends return right away for disabled levels, but their
+ * arguments are still evaluated. Guard arguments which are expensive to
+ * compute with this check:
+ *
+ *     if (log_level_is_handled(LogLevel::kDebug)) {
+ *       log_debug("Executing query: %s", filter(query).c_str());
+ *     }
+ *
+ * The level of the domain is cached per module until the loggers change,
+ * which makes the check a couple of loads and compares.
+ */
+static inline bool log_level_is_handled(LogLevel level) {
+  // generation in the upper bits, level in the lowest byte
+  static std::atomic<uint64_t> cached_level{0};
+
+  const uint64_t generation = g_log_level_generation.load(std::memory_order_acquire);
+  uint64_t cached = cached_level.load(std::memory_order_relaxed);
+  if ((cached >> 8) != generation) {
+    cached = (generation << 8) |
+             static_cast<uint64_t>(get_log_level_for_domain(MYSQL_ROUTER_LOG_DOMAIN));
+    cached_level.store(cached, std::memory_order_relaxed);
+  }
+
+  return level <= static_cast<LogLevel>(cached & 0xff);
+}
+
 /*
  * Define inline functions that pick up the log domain defined for the module.
  */
 
 static inline void log_error(const char* fmt, ...) {
   extern void log_message(LogLevel level, const char* module, const char* fmt, va_list ap);
+  if (!log_level_is_handled(LogLevel::kError)) return;
+
   va_list ap;
   va_start(ap, fmt);
   log_message(LogLevel::kError, MYSQL_ROUTER_LOG_DOMAIN, fmt, ap);
@@ -217,6 +286,8 @@ static inline void log_error(const char* fmt, ...) {
 
 static inline void log_warning(const char* fmt, ...) {
   extern void log_message(LogLevel level, const char* module, const char* fmt, va_list ap);
+  if (!log_level_is_handled(LogLevel::kWarning)) return;
+
   va_list ap;
   va_start(ap, fmt);
   log_message(LogLevel::kWarning, MYSQL_ROUTER_LOG_DOMAIN, fmt, ap);
@@ -225,6 +296,8 @@ static inline void log_warning(const char* fmt, ...) {
 
 static inline void log_info(const char* fmt, ...) {
   extern void log_message(LogLevel level, const char* module, const char* fmt, va_list ap);
+  if (!log_level_is_handled(LogLevel::kInfo)) return;
+
   va_list ap;
   va_start(ap, fmt);
   log_message(LogLevel::kInfo, MYSQL_ROUTER_LOG_DOMAIN, fmt, ap);
@@ -233,6 +306,8 @@ static inline void log_info(const char* fmt, ...) {
 
 static inline void log_debug(const char* fmt, ...) {
   extern void log_message(LogLevel level, const char* module, const char* fmt, va_list ap);
+  if (!log_level_is_handled(LogLevel::kDebug)) return;
+
   va_list ap;
   va_start(ap, fmt);
   log_message(LogLevel::kDebug, MYSQL_ROUTER_LOG_DOMAIN, fmt, ap);
@@ -256,6 +331,7 @@ static inline void log_debug(const char* fmt, ...) {
 using mysql_harness::logging::log_error;    \
 using mysql_harness::logging::log_warning;  \
 using mysql_harness::logging::log_info;     \
-using mysql_harness::logging::log_debug;
+using mysql_harness::logging::log_debug;    \
+using mysql_harness::logging::log_level_is_handled;
 
 #endif // MYSQL_HARNESS_LOGGING_INCLUDED
@@ -33,8 +33,10 @@
 
 #include <atomic>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace mysql_harness {
 
@@ -51,11 +53,30 @@ class HARNESS_EXPORT Registry {
  public:
   const static std::map<std::string, LogLevel> kLogLevels;
 
-  Registry() = default;
+  /**
+   * Immutable copy of the loggers and handlers, used to log a message
+   *
+   * A new snapshot is published whenever loggers or handlers change, which
+   * lets log_message() find the handlers of a logger without the registry's
+   * lock.
+   */
+  struct Snapshot {
+    struct ResolvedLogger {
+      LogLevel level;
+      std::vector<std::shared_ptr<Handler>> handlers;  // handlers that exist
+    };
+
+    std::map<std::string, ResolvedLogger> loggers;  // key = log domain
+    std::map<std::string, std::shared_ptr<Handler>> handlers;  // key = id
+  };
+
+  Registry() : snapshot_(std::make_shared<const Snapshot>()) {
+    ++g_log_level_generation;
+  }
   Registry(const Registry&) = delete;
   Registry& operator=(const Registry&) = delete;
 
-  ~Registry() = default;
+  ~Registry() { ++g_log_level_generation; }
 
 //----[ logger CRUD ]-----------------------------------------------------------
 
@@ -146,6 +167,15 @@ class HARNESS_EXPORT Registry {
    */
   std::set<std::string> get_handler_names() const;
 
+  /**
+   * Return the loggers and handlers as of their last change
+   *
+   * Doesn't lock, the snapshot is read with an atomic load.
+   */
+  std::shared_ptr<const Snapshot> get_snapshot() const {
+    return std::atomic_load(&snapshot_);
+  }
+
   /**
    * Flag that the registry has been initialized
    *
@@ -155,7 +185,10 @@ class HARNESS_EXPORT Registry {
    * However, a logging function (i.e. log_message()) might want to query
    * this flag when called and do whatever it deems appropriate.
    */
-  void set_ready() noexcept { ready_ = true; }
+  void set_ready() noexcept {
+    ready_ = true;
+    ++g_log_level_generation;
+  }
 
   /**
    * Query if logging facility is ready to use
@@ -166,9 +199,13 @@ class HARNESS_EXPORT Registry {
   bool is_ready() const noexcept { return ready_; }
 
  private:
+  // rebuilds snapshot_ and bumps g_log_level_generation; mtx_ must be held
+  void publish_snapshot();
+
   mutable std::mutex mtx_;
   std::map<std::string, Logger> loggers_; // key = log domain
   std::map<std::string, std::shared_ptr<Handler>> handlers_; // key = handler id
+  std::shared_ptr<const Snapshot> snapshot_;
   std::atomic<bool> ready_{false};
 
 }; // class Registry
@@ -277,6 +314,8 @@ class HARNESS_EXPORT Registry {
    * @param logging_folder logging_folder provided in configuration file
    * @param format_messages If set to true, log messages will be formatted
    *        (prefixed with log level, timestamp, etc) before logging
+   * @param async If set to true, log messages are written by a background
+   *        thread (see AsyncHandler)
    *
    * @throws std::runtime_error if opening log file fails
    */
@@ -284,7 +323,8 @@ class HARNESS_EXPORT Registry {
   void create_main_logfile_handler(Registry& registry,
                                    const std::string& program,
                                    const std::string& logging_folder,
-                                   bool format_messages);
+                                   bool format_messages,
+                                   bool async = false);
 
 
 
@@ -65,6 +65,7 @@ class HARNESS_EXPORT SocketOperationsBase {
   virtual int getaddrinfo(const char *node, const char *service, const addrinfo *hints, addrinfo **res) = 0;
   virtual int bind(int fd, const struct sockaddr *addr, socklen_t len) = 0;
   virtual int socket(int domain, int type, int protocol) = 0;
+  virtual int connect(int fd, const struct sockaddr *addr, socklen_t len) = 0;
   virtual int setsockopt(int fd, int level, int optname,
                          const void *optval, socklen_t optlen) = 0;
   virtual int listen(int fd, int n) = 0;
@@ -146,6 +147,9 @@ class HARNESS_EXPORT SocketOperations : public SocketOperationsBase {
   /** @brief Thin wrapper around socket library socket() */
   int socket(int domain, int type, int protocol) override;
 
+  /** @brief Thin wrapper around socket library connect() */
+  int connect(int fd, const struct sockaddr *addr, socklen_t len) override;
+
   /** @brief Thin wrapper around socket library setsockopt() */
   int setsockopt(int fd, int level, int optname,
                  const void *optval, socklen_t optlen) override;
@@ -206,4 +206,19 @@ int delete_dir_recursive(const std::string& dir) noexcept {
   return delete_dir(dir);
 }
 
+////////////////////////////////////////////////////////////////
+// struct FileVersion members
+
+FileVersion FileVersion::from_stat(const struct stat& st) {
+#if defined(_WIN32)
+  const long mtime_nsec = 0;
+#elif defined(__APPLE__)
+  const long mtime_nsec = st.st_mtimespec.tv_nsec;
+#else
+  const long mtime_nsec = st.st_mtim.tv_nsec;
+#endif
+
+  return FileVersion{st.st_mtime, mtime_nsec, st.st_ino, st.st_size};
+}
+
 } // namespace mysql_harness
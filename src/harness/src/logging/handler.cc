@@ -36,14 +36,18 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <fstream>
+#include <map>
 #include <sstream>
 #include <string>
 #include <thread>
 #ifndef _WIN32
 #  include <sys/types.h>
 #  include <unistd.h>
+#else
+#  define getpid GetCurrentProcessId
 #endif
 
 using mysql_harness::Path;
@@ -80,22 +84,38 @@ std::string Handler::format(const Record& record) const {
   if (!format_messages_)
     return record.message;
 
+  // localtime() and strftime() are expensive and the formatted time only
+  // changes once per second. Cache the last one per formatting thread.
+  struct TimeCache {
+    time_t created;
+    char time_buf[20];
+  };
+  thread_local TimeCache time_cache{static_cast<time_t>(-1), ""};
+
   // Format the time (19 characters)
-  char time_buf[20];
-  strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S",
-           localtime(&record.created));
+  if (record.created != time_cache.created) {
+    strftime(time_cache.time_buf, sizeof(time_cache.time_buf), "%Y-%m-%d %H:%M:%S",
+             localtime(&record.created));
+    time_cache.created = record.created;
+  }
 
   // Get the thread ID in a printable format
-  std::stringstream ss;
-  ss << std::hex << std::this_thread::get_id();
+  thread_local std::thread::id cached_thread_id;
+  thread_local std::string cached_thread_id_str;
+  if (record.thread_id != cached_thread_id || cached_thread_id_str.empty()) {
+    std::stringstream ss;
+    ss << std::hex << record.thread_id;
+    cached_thread_id = record.thread_id;
+    cached_thread_id_str = ss.str();
+  }
 
   // We ignore the return value from snprintf, which means that the
   // output is truncated if the total length exceeds the buffer size.
   char buffer[512];
   snprintf(buffer, sizeof(buffer), "%-19s %s %s [%s] %s",
-           time_buf, record.domain.c_str(),
+           time_cache.time_buf, record.domain.c_str(),
            level_str[static_cast<int>(record.level)],
-           ss.str().c_str(), record.message.c_str());
+           cached_thread_id_str.c_str(), record.message.c_str());
 
   // Note: This copies the buffer into an std::string
   return buffer;
@@ -105,6 +125,15 @@ void Handler::handle(const Record& record) {
   do_log(record);
 }
 
+void Handler::handle_batch(const std::vector<Record>& records) {
+  do_log_batch(records);
+}
+
+void Handler::do_log_batch(const std::vector<Record>& records) {
+  for (const Record& record : records)
+    do_log(record);
+}
+
 // satisfy ODR
 constexpr const char* StreamHandler::kDefaultName;
 
@@ -121,6 +150,18 @@ void StreamHandler::do_log(const Record& record) {
   stream_ << format(record) << std::endl;
 }
 
+void StreamHandler::do_log_batch(const std::vector<Record>& records) {
+  // format outside the lock, write and flush once
+  std::string out;
+  for (const Record& record : records) {
+    out += format(record);
+    out += '\n';
+  }
+
+  std::lock_guard<std::mutex> lock(stream_mutex_);
+  stream_ << out << std::flush;
+}
+
 ////////////////////////////////////////////////////////////////
 // class FileHandler
 
@@ -153,6 +194,166 @@ constexpr const char* FileHandler::kDefaultName;
 
 FileHandler::~FileHandler() {}
 
+////////////////////////////////////////////////////////////////
+// class AsyncHandler
+
+// how often the writer looks for new records
+static const std::chrono::milliseconds kAsyncWriterInterval{20};
+
+/**
+ * Single-producer, single-consumer ring-buffer of records.
+ *
+ * Filled by one logging thread, emptied by the writer thread. The slots are
+ * allocated up front and records are assigned into them, so the strings of
+ * a slot keep their buffers and logging doesn't allocate once the slots
+ * have seen messages of that size.
+ */
+class AsyncHandler::Ring {
+ public:
+  explicit Ring(size_t size)
+      : slots_(size, Record(LogLevel::kNotSet, 0, 0, std::string(), std::string())) {}
+
+  // called by the owning thread only
+  bool push(const Record& record) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == slots_.size())
+      return false;
+
+    slots_[head % slots_.size()] = record;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // called by the writer thread only; copies to leave the slots' buffers
+  void pop_all(std::vector<Record>& records) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    for (size_t pos = tail; pos != head; ++pos)
+      records.push_back(slots_[pos % slots_.size()]);
+    tail_.store(head, std::memory_order_release);
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+ private:
+  std::vector<Record> slots_;
+  std::atomic<size_t> head_{0};  // next slot to fill
+  std::atomic<size_t> tail_{0};  // next slot to empty
+};
+
+static std::atomic<uint64_t> g_next_async_handler_id{0};
+
+// satisfy ODR
+constexpr const char* AsyncHandler::kDefaultName;
+
+AsyncHandler::AsyncHandler(std::shared_ptr<Handler> handler, size_t ring_size)
+    : Handler(false, handler->get_level()),
+      handler_(std::move(handler)),
+      ring_size_(ring_size),
+      id_(g_next_async_handler_id++) {
+  writer_ = std::thread(&AsyncHandler::run_writer, this);
+}
+
+AsyncHandler::~AsyncHandler() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  writer_.join();
+}
+
+void AsyncHandler::flush() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  const uint64_t flush_id = ++flush_requested_;
+  cond_.notify_all();
+  cond_.wait(lock, [this, flush_id]() { return flush_done_ >= flush_id; });
+}
+
+AsyncHandler::Ring& AsyncHandler::get_thread_ring() {
+  // rings of this thread, keyed by the id of their AsyncHandler. The writer
+  // keeps rings alive until they are drained, even if the thread exits.
+  thread_local std::map<uint64_t, std::shared_ptr<Ring>> thread_rings;
+
+  auto it = thread_rings.find(id_);
+  if (it != thread_rings.end())
+    return *it->second;
+
+  auto ring = std::make_shared<Ring>(ring_size_);
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    rings_.push_back(ring);
+  }
+  thread_rings.emplace(id_, ring);
+
+  return *ring;
+}
+
+void AsyncHandler::do_log(const Record& record) {
+  if (!get_thread_ring().push(record))
+    dropped_++;
+}
+
+void AsyncHandler::run_writer() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  for (;;) {
+    cond_.wait_for(lock, kAsyncWriterInterval, [this]() {
+      return stop_ || flush_requested_ != flush_done_;
+    });
+
+    const bool stop = stop_;
+    const uint64_t flush_requested = flush_requested_;
+    std::vector<std::shared_ptr<Ring>> rings(rings_);
+
+    lock.unlock();
+
+    std::vector<Record> records;
+    for (auto& ring : rings)
+      ring->pop_all(records);
+    rings.clear();
+
+    const uint64_t dropped = dropped_.load();
+    if (dropped != dropped_reported_) {
+      records.emplace_back(LogLevel::kWarning, getpid(), time(nullptr),
+                           kMainLogger,
+                           std::to_string(dropped - dropped_reported_) +
+                               " log messages dropped, logging is too slow");
+      dropped_reported_ = dropped;
+    }
+
+    if (!records.empty()) {
+      // records of one thread are in order, across threads only by time
+      std::stable_sort(records.begin(), records.end(),
+                       [](const Record& a, const Record& b) {
+                         return a.created < b.created;
+                       });
+      try {
+        handler_->handle_batch(records);
+      } catch (...) {
+        // there is no one to report it to
+      }
+    }
+
+    lock.lock();
+
+    // forget the rings of threads which exited
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                [](const std::shared_ptr<Ring>& ring) {
+                                  return ring.use_count() == 1 && ring->empty();
+                                }),
+                 rings_.end());
+
+    flush_done_ = flush_requested;
+    cond_.notify_all();
+
+    if (stop)
+      return;
+  }
+}
+
 } // namespace logging
 
 
@@ -51,18 +51,18 @@ void Logger::detach_handler(std::string name, bool handler_must_exist /*= true *
 
 void Logger::handle(const Record& record) {
   if (record.level <= level_) {
+    // handlers as of their last change, looked up without locking the registry
+    const auto snapshot = registry_->get_snapshot();
     for (const std::string& handler_id : handlers_) {
-      std::shared_ptr<Handler> handler;
-      try {
-        handler = registry_->get_handler(handler_id.c_str());
-      } catch (std::logic_error&) {
+      auto it = snapshot->handlers.find(handler_id);
+      if (it == snapshot->handlers.end()) {
         // It may happen that another thread has removed this handler since
         // we got a copy of our Logger object, and we now have a dangling
         // reference. In such case, simply skip it.
         continue;
       }
-      if (record.level <= handler->get_level())
-        handler->handle(record);
+      if (record.level <= it->second->get_level())
+        it->second->handle(record);
     }
   }
 }
@@ -70,6 +70,9 @@ const std::map<std::string, LogLevel> Registry::kLogLevels{
 // set for exaplanation
 std::string g_HACK_default_log_level;
 
+// starts at 1 as log_level_is_handled() treats 0 as "nothing cached"
+std::atomic<uint64_t> g_log_level_generation{1};
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // logger CRUD
@@ -82,6 +85,7 @@ void Registry::create_logger(const std::string& name, LogLevel level) {
   auto result = loggers_.emplace(name, Logger(*this, level));
   if (result.second == false)
     throw std::logic_error("Duplicate logger '" + name + "'");
+  publish_snapshot();
 }
 
 // throws std::logic_error
@@ -89,6 +93,7 @@ void Registry::remove_logger(const std::string& name) {
   std::lock_guard<std::mutex> lock(mtx_);
   if (loggers_.erase(name) == 0)
     throw std::logic_error("Removing non-existant logger '" + name + "'");
+  publish_snapshot();
 }
 
 // throws std::logic_error
@@ -122,6 +127,7 @@ void Registry::update_logger(const std::string& name, const Logger& logger) {
       throw std::logic_error(std::string("Attaching unknown handler '") + s + "'");
 
   it->second = logger;
+  publish_snapshot();
 }
 
 std::set<std::string> Registry::get_logger_names() const {
@@ -147,6 +153,7 @@ void Registry::add_handler(std::string name, std::shared_ptr<Handler> handler) {
   auto result = handlers_.emplace(name, handler);
   if (!result.second)
     throw std::logic_error("Duplicate handler '" + name + "'");
+  publish_snapshot();
 }
 
 // throws std::logic_error
@@ -162,6 +169,7 @@ void Registry::remove_handler(std::string name) {
     pair.second.detach_handler(name, false);
 
   handlers_.erase(it);
+  publish_snapshot();
 }
 
 // throws std::logic_error
@@ -183,6 +191,24 @@ std::set<std::string> Registry::get_handler_names() const {
   return result;
 }
 
+void Registry::publish_snapshot() {
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->handlers = handlers_;
+  for (const auto& pair : loggers_) {
+    Snapshot::ResolvedLogger& resolved = snapshot->loggers[pair.first];
+    resolved.level = pair.second.get_level();
+    for (const std::string& handler_name : pair.second.get_handler_names()) {
+      auto it = handlers_.find(handler_name);
+      if (it != handlers_.end())
+        resolved.handlers.push_back(it->second);
+    }
+  }
+
+  std::atomic_store(&snapshot_,
+                    std::shared_ptr<const Snapshot>(std::move(snapshot)));
+  ++g_log_level_generation;
+}
+
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -226,23 +252,29 @@ std::ostream *get_default_logger_stream() {
 void create_main_logfile_handler(Registry& registry,
                                  const std::string& program,
                                  const std::string& logging_folder,
-                                 bool format_messages) {
+                                 bool format_messages,
+                                 bool async /* = false */) {
   // Register the console as the handler if the logging folder is
   // undefined. Otherwise, register a file handler.
+  std::string handler_name;
+  std::shared_ptr<Handler> handler;
   if (logging_folder.empty()) {
-    registry.add_handler(kMainConsoleHandler,
-                         std::make_shared<StreamHandler>(*get_default_logger_stream(),
-                                                         format_messages));
-    attach_handler_to_all_loggers(registry, kMainConsoleHandler);
+    handler_name = kMainConsoleHandler;
+    handler = std::make_shared<StreamHandler>(*get_default_logger_stream(),
+                                              format_messages);
   } else {
     Path log_file = Path::make_path(logging_folder, program, "log");
 
     // throws std::runtime_error on failure to open file
-    registry.add_handler(kMainLogHandler,
-                         std::make_shared<FileHandler>(log_file, format_messages));
-
-    attach_handler_to_all_loggers(registry, kMainLogHandler);
+    handler_name = kMainLogHandler;
+    handler = std::make_shared<FileHandler>(log_file, format_messages);
   }
+
+  if (async)
+    handler = std::make_shared<AsyncHandler>(handler);
+
+  registry.add_handler(handler_name, handler);
+  attach_handler_to_all_loggers(registry, handler_name);
 }
 
 void init_logger(Registry& registry, const Config& config, const std::string& logger_name) {
@@ -329,6 +361,25 @@ void set_log_level_for_all_loggers(LogLevel level) {
   set_log_level_for_all_loggers(registry, level);
 }
 
+LogLevel get_log_level_for_domain(const char *domain) {
+  // called by the log functions, hence must not throw. When in doubt, let
+  // the message through and leave the decision to log_message()
+  try {
+    Registry& registry = DIM::instance().get_LoggingRegistry();
+    if (!registry.is_ready()) return LogLevel::kNotSet;
+
+    const auto snapshot = registry.get_snapshot();
+    auto it = snapshot->loggers.find(domain);
+    if (it == snapshot->loggers.end()) {
+      // logged as main application domain, see log_message()
+      it = snapshot->loggers.find(g_main_app_log_domain);
+      if (it == snapshot->loggers.end()) return LogLevel::kNotSet;
+    }
+    return it->second.level;
+  } catch (...) {
+    return LogLevel::kNotSet;
+  }
+}
 
 
 }  // namespace logging
@@ -356,6 +407,19 @@ extern "C" void LOGGER_API log_message(LogLevel level, const char* module, const
 #endif
   ;
 
+// passes the record to the handlers of a logger whose levels let it through
+static void handle_record(
+    const mysql_harness::logging::Registry::Snapshot::ResolvedLogger& logger,
+    const Record& record) {
+  if (record.level > logger.level)
+    return;
+
+  for (const auto& handler : logger.handlers) {
+    if (record.level <= handler->get_level())
+      handler->handle(record);
+  }
+}
+
 extern "C" void log_message(LogLevel level, const char* module, const char* fmt, va_list ap) {
   harness_assert(level <= LogLevel::kDebug);
 
@@ -367,24 +431,18 @@ extern "C" void log_message(LogLevel level, const char* module, const char* fmt,
                                                get_LoggingRegistry();
   harness_assert(registry.is_ready());
 
-  // Find the logger for the module
-  // NOTE that we copy the logger. Even if some other thread removes this
-  //      logger from registry, our call will still be valid. As for the
-  //      case of handlers getting removed in the meantime, Logger::handle()
-  //      handles this properly.
-  Logger logger;
-  try {
-    logger = registry.get_logger(module);
-  } catch (std::logic_error&) {
+  // Find the logger for the module in the registry's snapshot. It stays
+  // valid while we hold it, even if some other thread changes the loggers
+  // or removes handlers in the meantime.
+  const auto snapshot = registry.get_snapshot();
+  auto it = snapshot->loggers.find(module);
+  if (it == snapshot->loggers.end()) {
     // Logger is not registered for this module (log domain), so log as main
     // application domain instead (which should always be available)
     using mysql_harness::logging::g_main_app_log_domain;
     harness_assert(!g_main_app_log_domain.empty());
-    try {
-      logger = registry.get_logger(g_main_app_log_domain);
-    } catch (std::logic_error&) {
-      harness_assert(0);
-    }
+    it = snapshot->loggers.find(g_main_app_log_domain);
+    harness_assert(it != snapshot->loggers.end());
 
     // Complain that we're logging this elsewhere
     char msg[mysql_harness::logging::kLogMessageMaxSize];
@@ -392,7 +450,8 @@ extern "C" void log_message(LogLevel level, const char* module, const char* fmt,
              "Module '%s' not registered with logger - "
              "logging the following message as '%s' instead",
              module, g_main_app_log_domain.c_str());
-    logger.handle({LogLevel::kError, getpid(), now, g_main_app_log_domain, msg});
+    handle_record(it->second, {LogLevel::kError, getpid(), now,
+                               g_main_app_log_domain, msg});
 
     // And switch log domain to main application domain for the original
     // log message
@@ -409,6 +468,5 @@ extern "C" void log_message(LogLevel level, const char* module, const char* fmt,
   // Pass the record to the correct logger. The record should be
   // passed to only one logger since otherwise the handler can get
   // multiple calls, resulting in multiple log records.
-  logger.handle(record);
+  handle_record(it->second, record);
 }
-
@@ -156,6 +156,10 @@ int SocketOperations::socket(int domain, int type, int protocol) {
   return ::socket(domain, type, protocol);
 }
 
+int SocketOperations::connect(int fd, const struct sockaddr *addr, socklen_t len) {
+  return ::connect(fd, addr, len);
+}
+
 int SocketOperations::setsockopt(int fd, int level, int optname,
                                  const void *optval, socklen_t optlen) {
 #ifndef _WIN32
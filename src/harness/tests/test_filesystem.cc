@@ -35,6 +35,7 @@
 ////////////////////////////////////////
 // Standard include files
 
+#include <cstdio>
 #include <iostream>
 #include <vector>
 #include <fstream>
@@ -200,6 +201,32 @@ TEST(TestFilesystem, IsNotReadableIfFileCanNotBeRead) {
 #endif
 }
 
+TEST(TestFilesystem, FileVersionChangesWhenFileIsReplaced) {
+  const std::string directory = mysql_harness::get_tmp_dir("tmp");
+  std::shared_ptr<void> exit_guard(nullptr, [&](void*){mysql_harness::delete_dir_recursive(directory);});
+
+  const std::string path = Path(directory).join("tmp_file").str();
+  const std::string other_path = Path(directory).join("other_file").str();
+  std::ofstream(path) << "abc";
+  std::ofstream(other_path) << "abd";
+
+  struct stat st;
+  ASSERT_EQ(0, stat(path.c_str(), &st));
+  const auto version = mysql_harness::FileVersion::from_stat(st);
+  EXPECT_EQ(3, version.size);
+
+  ASSERT_EQ(0, stat(path.c_str(), &st));
+  EXPECT_EQ(version, mysql_harness::FileVersion::from_stat(st));
+
+#ifndef _WIN32
+  // same size and, likely, the same mtime: only the inode tells them apart
+  // (rename() doesn't replace an existing file on Windows)
+  ASSERT_EQ(0, std::rename(other_path.c_str(), path.c_str()));
+  ASSERT_EQ(0, stat(path.c_str(), &st));
+  EXPECT_NE(version, mysql_harness::FileVersion::from_stat(st));
+#endif
+}
+
 int main(int argc, char *argv[]) {
   g_here = Path(argv[0]).dirname();
 
@@ -50,21 +50,28 @@ MYSQL_HARNESS_ENABLE_WARNINGS()
 
 ////////////////////////////////////////
 // Standard include files
+#include <future>
+#include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 #ifndef _WIN32
 #include <unistd.h> // unlink
 #endif
 
 using mysql_harness::Path;
+using mysql_harness::logging::AsyncHandler;
 using mysql_harness::logging::FileHandler;
 using mysql_harness::logging::LogLevel;
 using mysql_harness::logging::Logger;
 using mysql_harness::logging::Record;
 using mysql_harness::logging::StreamHandler;
+using mysql_harness::logging::get_log_level_for_domain;
 using mysql_harness::logging::log_debug;
 using mysql_harness::logging::log_error;
 using mysql_harness::logging::log_info;
+using mysql_harness::logging::log_level_is_handled;
 using mysql_harness::logging::log_warning;
 
 
@@ -634,6 +641,122 @@ const LogLevel all_levels[]{
 INSTANTIATE_TEST_CASE_P(CheckLogLevel, LogLevelTest,
                         Combine(ValuesIn(all_levels), ValuesIn(all_levels)));
 #endif
+
+////////////////////////////////////////////////////////////////
+// Tests of the AsyncHandler.
+////////////////////////////////////////////////////////////////
+
+TEST_F(LoggingTest, AsyncHandlerPassesRecordsInOrder) {
+  std::stringstream buffer;
+  auto handler = std::make_shared<AsyncHandler>(
+      std::make_shared<StreamHandler>(buffer, false));
+
+  handler->handle(Record{LogLevel::kInfo, getpid(), 0, "my_module", "first"});
+  handler->handle(Record{LogLevel::kInfo, getpid(), 0, "my_module", "second"});
+  handler->flush();
+
+  EXPECT_THAT(buffer.str(), StrEq("first\nsecond\n"));
+  EXPECT_THAT(handler->get_dropped(), Eq(0u));
+}
+
+TEST_F(LoggingTest, AsyncHandlerFormatsWithLoggingThread) {
+  std::stringstream buffer;
+  auto handler = std::make_shared<AsyncHandler>(
+      std::make_shared<StreamHandler>(buffer));
+
+  handler->handle(Record{LogLevel::kInfo, getpid(), 0, "my_module", "Message"});
+  handler->flush();
+
+  std::stringstream thread_id;
+  thread_id << std::hex << std::this_thread::get_id();
+
+  EXPECT_THAT(buffer.str(), HasSubstr("[" + thread_id.str() + "] Message\n"));
+}
+
+TEST_F(LoggingTest, AsyncHandlerManyThreads) {
+  std::stringstream buffer;
+  auto handler = std::make_shared<AsyncHandler>(
+      std::make_shared<StreamHandler>(buffer, false), 1024);
+
+  const int kThreads = 4;
+  const int kRecordsPerThread = 100;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&handler, t]() {
+      for (int ndx = 0; ndx < kRecordsPerThread; ++ndx) {
+        handler->handle(Record{LogLevel::kInfo, getpid(), 0, "my_module",
+                               std::to_string(t) + ":" + std::to_string(ndx)});
+      }
+    });
+  }
+  for (auto& thr : threads)
+    thr.join();
+
+  handler->flush();
+
+  // all records arrived, and the ones of each thread in order
+  std::vector<int> next(kThreads, 0);
+  std::string line;
+  int lines = 0;
+  while (std::getline(buffer, line)) {
+    const auto sep = line.find(':');
+    ASSERT_NE(sep, std::string::npos);
+    const int t = std::stoi(line.substr(0, sep));
+    EXPECT_THAT(std::stoi(line.substr(sep + 1)), Eq(next[t]));
+    next[t]++;
+    lines++;
+  }
+  EXPECT_THAT(lines, Eq(kThreads * kRecordsPerThread));
+}
+
+namespace {
+
+/**
+ * handler which blocks until it is released.
+ */
+class BlockingHandler : public mysql_harness::logging::Handler {
+ public:
+  BlockingHandler() : Handler(false, LogLevel::kNotSet) {}
+
+  std::promise<void> entered;
+  std::promise<void> release;
+  std::stringstream buffer;
+
+ private:
+  void do_log(const Record& record) override {
+    if (!is_entered_) {
+      is_entered_ = true;
+      entered.set_value();
+      release.get_future().wait();
+    }
+    buffer << record.message << "\n";
+  }
+
+  bool is_entered_{false};
+};
+
+}
+
+TEST_F(LoggingTest, AsyncHandlerCountsDropped) {
+  auto blocking = std::make_shared<BlockingHandler>();
+  auto entered = blocking->entered.get_future();
+  auto handler = std::make_shared<AsyncHandler>(blocking, 4);
+
+  // block the writer
+  handler->handle(Record{LogLevel::kInfo, getpid(), 0, "my_module", "block"});
+  entered.wait();
+
+  for (int ndx = 0; ndx < 7; ++ndx) {
+    handler->handle(Record{LogLevel::kInfo, getpid(), 0, "my_module", "x"});
+  }
+  EXPECT_THAT(handler->get_dropped(), Eq(3u));
+
+  blocking->release.set_value();
+  handler->flush();
+
+  EXPECT_THAT(blocking->buffer.str(), HasSubstr("3 log messages dropped"));
+}
 ////////////////////////////////////////////////////////////////
 // Tests of the functional interface to the logger.
 ////////////////////////////////////////////////////////////////
@@ -734,6 +857,35 @@ TEST(FunctionalTest, Handlers) {
   expect_no_log(log_debug, buffer);
 }
 
+TEST(FunctionalTest, LogLevelIsHandled) {
+  // the cached level follows the changes of the loggers
+  set_log_level_for_all_loggers(*g_registry, LogLevel::kWarning);
+  EXPECT_TRUE(log_level_is_handled(LogLevel::kError));
+  EXPECT_TRUE(log_level_is_handled(LogLevel::kWarning));
+  EXPECT_FALSE(log_level_is_handled(LogLevel::kInfo));
+  EXPECT_FALSE(log_level_is_handled(LogLevel::kDebug));
+
+  set_log_level_for_all_loggers(*g_registry, LogLevel::kDebug);
+  EXPECT_TRUE(log_level_is_handled(LogLevel::kInfo));
+  EXPECT_TRUE(log_level_is_handled(LogLevel::kDebug));
+
+  set_log_level_for_all_loggers(*g_registry, LogLevel::kError);
+  EXPECT_TRUE(log_level_is_handled(LogLevel::kError));
+  EXPECT_FALSE(log_level_is_handled(LogLevel::kWarning));
+}
+
+TEST(FunctionalTest, LogLevelOfUnregisteredDomain) {
+  // messages of unregistered domains are logged as "main"
+  set_log_level_for_all_loggers(*g_registry, LogLevel::kInfo);
+  EXPECT_EQ(LogLevel::kInfo, get_log_level_for_domain("no_such_domain"));
+
+  Logger logger = g_registry->get_logger(mysql_harness::logging::kMainLogger);
+  logger.set_level(LogLevel::kDebug);
+  g_registry->update_logger(mysql_harness::logging::kMainLogger, logger);
+  EXPECT_EQ(LogLevel::kDebug, get_log_level_for_domain("no_such_domain"));
+  EXPECT_EQ(LogLevel::kInfo, get_log_level_for_domain(MYSQL_ROUTER_LOG_DOMAIN));
+}
+
 
 
 int main(int argc, char *argv[]) {
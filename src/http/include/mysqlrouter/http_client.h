@@ -28,6 +28,12 @@
 #include "mysqlrouter/http_client_export.h"
 #include "mysqlrouter/http_common.h"
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
 class HTTP_CLIENT_EXPORT HttpClient {
 public:
   HttpClient();
@@ -44,4 +50,77 @@ private:
   IOContext &io_ctx_;
 };
 
+/**
+ * asynchronous HTTP client with keep-alive connections per host:port.
+ *
+ * Requests to the same host:port share a pool of connections. Each
+ * connection runs one request at a time, up to max_connections_per_host
+ * requests to a host run concurrently, further ones are queued until a
+ * connection becomes idle.
+ *
+ * All handlers are called from IOContext::dispatch() or wait_all().
+ */
+class HTTP_CLIENT_EXPORT HttpClientPool {
+public:
+  /**
+   * timings and outcome of the finished requests.
+   */
+  struct Stats {
+    uint64_t requests_ok;  // got a response, of any status
+    uint64_t requests_failed;  // no response, like connection failures or timeouts
+    std::chrono::microseconds total_duration;
+    std::chrono::microseconds max_duration;
+  };
+
+  /**
+   * called when a request finished.
+   *
+   * @param req request with the response. evaluates to false if the request failed.
+   *            Only valid until the handler returns.
+   * @param duration time between sending the request and receiving the response,
+   *                 including the time it waited for a connection
+   */
+  using ResponseHandler = std::function<void(HttpRequest &req, std::chrono::microseconds duration)>;
+
+  HttpClientPool(IOContext &io_ctx, size_t max_connections_per_host = 8);
+  ~HttpClientPool();
+
+  /**
+   * set timeout of requests sent over new connections.
+   */
+  void set_timeout(std::chrono::seconds timeout);
+
+  /**
+   * send a request.
+   *
+   * returns immediately, handler is called when the response is received.
+   */
+  void make_request(const std::string &address, uint16_t port,
+      HttpMethod::type method, const std::string &uri,
+      ResponseHandler handler,
+      const std::string &request_body = {},
+      const std::string &content_type = "application/json");
+
+  /**
+   * run the event-loop until all requests are finished.
+   *
+   * Unlike IOContext::dispatch() it doesn't wait for the idle keep-alive
+   * connections to be closed.
+   *
+   * @throws std::runtime_error on internal, unexpected error
+   */
+  void wait_all();
+
+  /**
+   * number of requests sent or waiting for a connection.
+   */
+  size_t pending_requests() const;
+
+  Stats get_stats() const;
+private:
+  class impl;
+
+  std::unique_ptr<impl> pImpl_;
+};
+
 #endif
@@ -256,6 +256,60 @@ private:
   friend class HttpRequest;
 };
 
+/**
+ * output stream which appends to a HttpBuffer.
+ *
+ * satisfies rapidjson's Stream concept and allows to write JSON
+ * directly into the buffer without building it in a StringBuffer first:
+ *
+ *     HttpBufferOutputStream os(buf);
+ *     rapidjson::Writer<HttpBufferOutputStream> writer(os);
+ *
+ * Put() collects small writes locally, Flush() moves them into the buffer.
+ */
+class HttpBufferOutputStream {
+public:
+  using Ch = char;
+
+  explicit HttpBufferOutputStream(HttpBuffer &buf):
+    buf_{&buf}
+  {}
+
+  ~HttpBufferOutputStream() {
+    Flush();
+  }
+
+  HttpBufferOutputStream(const HttpBufferOutputStream &) = delete;
+  HttpBufferOutputStream &operator=(const HttpBufferOutputStream &) = delete;
+
+  void Put(Ch c) {
+    if (pending_size_ == sizeof(pending_)) {
+      Flush();
+    }
+    pending_[pending_size_++] = c;
+  }
+
+  void Flush() {
+    if (pending_size_ > 0) {
+      buf_->add(pending_, pending_size_);
+      pending_size_ = 0;
+    }
+  }
+
+  /**
+   * flush and continue writing into another buffer.
+   */
+  void reset(HttpBuffer &buf) {
+    Flush();
+    buf_ = &buf;
+  }
+private:
+  HttpBuffer *buf_;
+
+  Ch pending_[1024];
+  size_t pending_size_ { 0 };
+};
+
 /**
  * headers of a HTTP response/request.
  */
@@ -347,6 +401,7 @@ private:
 
   std::unique_ptr<impl> pImpl_;
   friend class HttpClient;
+  friend class HttpClientPool;
 };
 
 /**
@@ -381,6 +436,28 @@ public:
   void send_reply(int status_code, std::string status_text);
   void send_reply(int status_code, std::string status_text, HttpBuffer &buffer);
 
+  /**
+   * producer of the body of a chunked response.
+   *
+   * appends the next part of the body to the chunk.
+   *
+   * @returns true if more parts follow, false if the body is complete
+   */
+  using ChunkProducer = std::function<bool(HttpBuffer &chunk)>;
+
+  /**
+   * send a response whose body is produced incrementally.
+   *
+   * The body is sent with chunked transfer-encoding. The next chunk is only
+   * produced after the previous one was written to the connection, which
+   * bounds the memory used per response if the client reads slowly.
+   *
+   * The producer is called from the event-loop of the request and must not
+   * reference the HttpRequest. If the connection is closed early, the
+   * producer is destroyed without being called again.
+   */
+  void send_reply_chunked(int status_code, std::string status_text, ChunkProducer producer);
+
   void send_error(int status_code) {
     send_error(status_code, HttpStatusCode::get_default_status_text(status_code));
   }
@@ -22,11 +22,15 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#include <event2/buffer.h>
 #include <event2/event.h>
 #include <event2/http.h>
 
+#include <deque>
+#include <map>
 #include <string>
 #include <iostream>
+#include <vector>
 
 #include "mysqlrouter/http_client.h"
 #include "http_request_impl.h"
@@ -99,3 +103,260 @@ void HttpClient::make_request_sync(HttpRequest *req, HttpMethod::type method, co
 
 
 HttpClient::~HttpClient() = default;
+
+
+class HttpClientPool::impl {
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  struct Request {
+    HttpMethod::type method;
+    std::string uri;
+    std::string request_body;
+    std::string content_type;
+    ResponseHandler handler;
+    clock_type::time_point queued_at;
+  };
+
+  struct Host;
+  struct Connection;
+
+  // a request which is sent over a connection
+  struct InFlight {
+    impl *pool;
+    Host *host;
+    Connection *conn;
+    Request request;
+    int error_code;
+  };
+
+  struct Connection {
+    std::unique_ptr<InFlight> in_flight;
+    // freed before in_flight
+    std::unique_ptr<evhttp_connection, decltype(&evhttp_connection_free)> conn;
+  };
+
+  struct Host {
+    std::string address;
+    uint16_t port;
+    // value of the Host header of its requests
+    std::string host_header;
+    std::vector<std::unique_ptr<Connection>> connections;
+    std::deque<Request> queued;
+  };
+
+  impl(event_base *ev_base, size_t max_connections_per_host):
+    ev_base_(ev_base),
+    max_connections_per_host_(max_connections_per_host) {}
+
+  void submit(const std::string &address, uint16_t port, Request request) {
+    auto it = hosts_.find(std::make_pair(address, port));
+    if (it == hosts_.end()) {
+      it = hosts_.emplace(std::make_pair(address, port), Host { address, port, make_host_header(address, port), {}, {} }).first;
+    }
+    Host &host = it->second;
+
+    ++pending_;
+    host.queued.push_back(std::move(request));
+
+    send_queued(host);
+  }
+
+  void set_timeout(std::chrono::seconds timeout) {
+    timeout_ = timeout;
+
+    for (auto &host: hosts_) {
+      for (auto &conn: host.second.connections) {
+        evhttp_connection_set_timeout(conn->conn.get(), static_cast<int>(timeout_.count()));
+      }
+    }
+  }
+
+  size_t pending_requests() const { return pending_; }
+
+  void wait_all() {
+    while (pending_ > 0) {
+      if (-1 == event_base_loop(ev_base_, EVLOOP_ONCE)) {
+        throw std::runtime_error("event_base_loop() error");
+      }
+    }
+  }
+
+  Stats get_stats() const { return stats_; }
+private:
+  Connection *get_idle_connection(Host &host) {
+    for (auto &conn: host.connections) {
+      if (!conn->in_flight) {
+        return conn.get();
+      }
+    }
+
+    if (host.connections.size() >= max_connections_per_host_) {
+      return nullptr;
+    }
+
+    auto *ev_conn = evhttp_connection_base_new(ev_base_, nullptr, host.address.c_str(), host.port);
+    if (nullptr == ev_conn) {
+      return nullptr;
+    }
+    if (timeout_.count() > 0) {
+      evhttp_connection_set_timeout(ev_conn, static_cast<int>(timeout_.count()));
+    }
+
+    host.connections.emplace_back(new Connection {
+        nullptr,
+        { ev_conn, &evhttp_connection_free }
+        });
+
+    return host.connections.back().get();
+  }
+
+  void send_queued(Host &host) {
+    while (!host.queued.empty()) {
+      Connection *conn = get_idle_connection(host);
+      if (nullptr == conn) {
+        // wait for a connection to become idle
+        if (!host.connections.empty()) return;
+
+        // no connection at all
+        Request request = std::move(host.queued.front());
+        host.queued.pop_front();
+        finish(std::move(request), nullptr, 0);
+        continue;
+      }
+
+      Request request = std::move(host.queued.front());
+      host.queued.pop_front();
+
+      send(host, *conn, std::move(request));
+    }
+  }
+
+  /**
+   * Host header for address and port.
+   *
+   * the port is omitted if it is the default port, IPv6 addresses are put
+   * in brackets (RFC 7230, section 5.4).
+   */
+  static std::string make_host_header(const std::string &address, uint16_t port) {
+    std::string header = address.find(':') != std::string::npos ? "[" + address + "]" : address;
+    if (port != 80) header += ":" + std::to_string(port);
+
+    return header;
+  }
+
+  void send(Host &host, Connection &conn, Request request) {
+    conn.in_flight.reset(new InFlight { this, &host, &conn, std::move(request), 0 });
+    InFlight *ctx = conn.in_flight.get();
+
+    auto *ev_req = evhttp_request_new(on_response, ctx);
+#if LIBEVENT_VERSION_NUMBER >= 0x02010000
+    evhttp_request_set_error_cb(ev_req, [](evhttp_request_error err_code, void *ev_cb_arg){
+        static_cast<InFlight *>(ev_cb_arg)->error_code = err_code;
+        });
+#endif
+
+    auto *out_hdrs = evhttp_request_get_output_headers(ev_req);
+    evhttp_add_header(out_hdrs, "Host", host.host_header.c_str());
+
+    const Request &req = ctx->request;
+    if (!req.request_body.empty()) {
+      evhttp_add_header(out_hdrs, "Content-Type", req.content_type.c_str());
+      evbuffer_add(evhttp_request_get_output_buffer(ev_req), req.request_body.data(), req.request_body.size());
+    }
+
+    if (0 != evhttp_make_request(conn.conn.get(), ev_req, static_cast<enum evhttp_cmd_type>(req.method), req.uri.c_str())) {
+      // libevent already freed ev_req
+      auto in_flight = std::move(conn.in_flight);
+      finish(std::move(in_flight->request), nullptr, 0);
+    }
+  }
+
+  static void on_response(evhttp_request *ev_req, void *ev_cb_arg) {
+    auto *ctx = static_cast<InFlight *>(ev_cb_arg);
+    impl *pool = ctx->pool;
+    Host &host = *ctx->host;
+
+    // the connection becomes idle before the handler is called
+    // which allows it to send the next request right away
+    auto in_flight = std::move(ctx->conn->in_flight);
+
+    pool->finish(std::move(in_flight->request), ev_req, in_flight->error_code);
+
+    pool->send_queued(host);
+  }
+
+  void finish(Request request, evhttp_request *ev_req, int error_code) {
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - request.queued_at);
+
+    // without a response-code, the request failed to connect, timed out, ...
+    const bool has_response = ev_req != nullptr && evhttp_request_get_response_code(ev_req) != 0;
+    if (has_response) {
+      stats_.requests_ok++;
+    } else {
+      stats_.requests_failed++;
+    }
+    stats_.total_duration += duration;
+    if (duration > stats_.max_duration) {
+      stats_.max_duration = duration;
+    }
+
+    --pending_;
+
+    // the event-loop frees the evhttp_request after the handler
+    HttpRequest req {
+      std::unique_ptr<evhttp_request, std::function<void(evhttp_request *)>>(
+          has_response ? ev_req : nullptr, [](evhttp_request *){})
+    };
+    req.error_code(error_code);
+
+    request.handler(req, duration);
+  }
+
+  event_base *ev_base_;
+  size_t max_connections_per_host_;
+  std::chrono::seconds timeout_ { 0 };  // 0 means libevent's default
+
+  std::map<std::pair<std::string, uint16_t>, Host> hosts_;
+
+  size_t pending_ { 0 };
+  Stats stats_ { 0, 0, std::chrono::microseconds(0), std::chrono::microseconds(0) };
+};
+
+HttpClientPool::HttpClientPool(IOContext &io_ctx, size_t max_connections_per_host):
+  pImpl_{new impl(io_ctx.pImpl_->ev_base.get(), max_connections_per_host)}
+{
+}
+
+HttpClientPool::~HttpClientPool() = default;
+
+void HttpClientPool::set_timeout(std::chrono::seconds timeout) {
+  pImpl_->set_timeout(timeout);
+}
+
+void HttpClientPool::make_request(const std::string &address, uint16_t port,
+    HttpMethod::type method, const std::string &uri,
+    ResponseHandler handler,
+    const std::string &request_body /* = {} */,
+    const std::string &content_type /* = "application/json" */) {
+  // TRACE forbids a request-body
+  if (!request_body.empty() && method == HttpMethod::Trace) {
+    throw std::logic_error("TRACE can't have request-body");
+  }
+
+  pImpl_->submit(address, port, impl::Request {
+      method, uri, request_body, content_type, std::move(handler),
+      impl::clock_type::now() });
+}
+
+void HttpClientPool::wait_all() {
+  pImpl_->wait_all();
+}
+
+size_t HttpClientPool::pending_requests() const {
+  return pImpl_->pending_requests();
+}
+
+HttpClientPool::Stats HttpClientPool::get_stats() const {
+  return pImpl_->get_stats();
+}
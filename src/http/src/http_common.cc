@@ -256,6 +256,109 @@ void HttpRequest::send_reply(int status_code, std::string status_text) {
   evhttp_send_reply(pImpl_->req.get(), status_code, status_text.c_str(), nullptr);
 }
 
+namespace {
+
+/**
+ * state of a chunked reply while its chunks are sent.
+ *
+ * deleted when the reply is complete or the connection got closed.
+ */
+struct ChunkedReply {
+  evhttp_request *req;
+  std::unique_ptr<evbuffer, decltype(&evbuffer_free)> buf;
+  HttpBuffer chunk;
+  // destroyed first, as it may still reference the chunk
+  HttpRequest::ChunkProducer producer;
+};
+
+void finish_chunked_reply(ChunkedReply *reply) {
+  evhttp_connection *conn = evhttp_request_get_connection(reply->req);
+  if (conn != nullptr) {
+    evhttp_connection_set_closecb(conn, nullptr, nullptr);
+  }
+  evhttp_send_reply_end(reply->req);
+
+  delete reply;
+}
+
+bool produce_chunk(ChunkedReply *reply) {
+  // don't let exceptions escape into libevent.
+  try {
+    return reply->producer(reply->chunk);
+  } catch (...) {
+    return false;
+  }
+}
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02010000
+void send_next_chunk(evhttp_connection *, void *arg) {
+  auto *reply = static_cast<ChunkedReply *>(arg);
+
+  bool more = produce_chunk(reply);
+  if (more) {
+    // called again once the chunk is written to the connection
+    evhttp_send_reply_chunk_with_cb(reply->req, reply->buf.get(), send_next_chunk, reply);
+  } else {
+    if (reply->chunk.length() > 0) {
+      evhttp_send_reply_chunk(reply->req, reply->buf.get());
+    }
+    finish_chunked_reply(reply);
+  }
+}
+
+void chunked_reply_connection_closed(evhttp_connection *, void *arg) {
+  auto *reply = static_cast<ChunkedReply *>(arg);
+
+  // the connection failed before the reply was complete and libevent
+  // detached the request from it. Ending the reply frees the request.
+  evhttp_send_reply_end(reply->req);
+
+  delete reply;
+}
+#endif
+
+}
+
+void HttpRequest::send_reply_chunked(int status_code, std::string status_text, ChunkProducer producer) {
+  evhttp_request *req = pImpl_->req.get();
+
+  std::unique_ptr<evbuffer, decltype(&evbuffer_free)> buf(evbuffer_new(), &evbuffer_free);
+  evbuffer *buf_ptr = buf.get();
+
+  auto *reply = new ChunkedReply {
+    req,
+    std::move(buf),
+    // non-owning
+    HttpBuffer {
+      std::unique_ptr<evbuffer, std::function<void(evbuffer *)>>(
+          buf_ptr, [](evbuffer *){})
+    },
+    std::move(producer)
+  };
+
+  evhttp_send_reply_start(req, status_code, status_text.c_str());
+
+  if (get_method() == HttpMethod::Head) {
+    finish_chunked_reply(reply);
+    return;
+  }
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02010000
+  evhttp_connection_set_closecb(evhttp_request_get_connection(req), chunked_reply_connection_closed, reply);
+
+  send_next_chunk(nullptr, reply);
+#else
+  // no notification when a chunk is sent, queue all of them
+  bool more;
+  do {
+    more = produce_chunk(reply);
+    evhttp_send_reply_chunk(req, reply->buf.get());
+  } while (more);
+
+  finish_chunked_reply(reply);
+#endif
+}
+
 HttpRequest::operator bool() {
   return pImpl_->req.operator bool();
 }
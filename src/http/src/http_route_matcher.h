@@ -0,0 +1,214 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef MYSQLROUTER_HTTP_ROUTE_MATCHER_INCLUDED
+#define MYSQLROUTER_HTTP_ROUTE_MATCHER_INCLUDED
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "posix_re.h"
+
+/**
+ * finds the first route whose regex matches an URI.
+ *
+ * Most routes start with a literal path like "^/api/v1/routes/" or are
+ * literal throughout like "^/api/v1/mock_server/globals/$". The literal
+ * prefixes of the routes' regexes are stored in a trie, which yields the
+ * candidate routes for an URI in a single pass over it. The regex is only
+ * run for candidates which aren't fully described by their literal prefix.
+ *
+ * The result is the same as searching each route's regex in the order the
+ * routes were added.
+ */
+class HttpRouteMatcher {
+public:
+  HttpRouteMatcher() = default;
+
+  HttpRouteMatcher(const HttpRouteMatcher &) = delete;
+  HttpRouteMatcher &operator=(const HttpRouteMatcher &) = delete;
+
+  /**
+   * add a route.
+   *
+   * @param url_regex_str extended regex the route was registered with
+   * @param url_regex the compiled url_regex_str, used for the parts of the
+   *        regex which aren't literal
+   */
+  void add(const std::string &url_regex_str, std::shared_ptr<const PosixRE> url_regex) {
+    Route route;
+    bool has_prefix = parse_literal_prefix(url_regex_str, route.prefix, route.kind);
+    if (route.kind == Route::Kind::kRegex) {
+      route.url_regex = std::move(url_regex);
+    }
+
+    TrieNode *node = &root_;
+    if (has_prefix) {
+      for (char c: route.prefix) {
+        auto &child = node->children[c];
+        if (!child) child.reset(new TrieNode);
+        node = child.get();
+      }
+    }
+    node->routes.push_back(routes_.size());
+
+    routes_.push_back(std::move(route));
+  }
+
+  /**
+   * find the first route matching the uri.
+   *
+   * @param uri URI to match
+   * @param route_ndx set to the index of the route in the order they were added
+   * @param path_params if not nullptr, set to the sub-expressions of the
+   *        route's regex, like "42" for "^/api/v1/routes/([0-9]+)$"
+   * @returns false if no route matches
+   */
+  bool match(const std::string &uri, size_t &route_ndx,
+      std::vector<std::string> *path_params = nullptr) const {
+    // routes whose literal prefix is a prefix of the uri
+    std::vector<size_t> candidates;
+
+    const TrieNode *node = &root_;
+    for (size_t depth = 0; ; depth++) {
+      for (size_t ndx: node->routes) {
+        if (routes_[ndx].kind != Route::Kind::kExact || depth == uri.size()) {
+          candidates.push_back(ndx);
+        }
+      }
+
+      if (depth == uri.size()) break;
+
+      auto it = node->children.find(uri[depth]);
+      if (it == node->children.end()) break;
+      node = it->second.get();
+    }
+
+    // routes added first win
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<std::string> groups;
+    for (size_t ndx: candidates) {
+      const Route &route = routes_[ndx];
+      if (route.kind == Route::Kind::kRegex) {
+        if (!route.url_regex->search(uri, groups)) continue;
+      } else {
+        groups.clear();
+      }
+
+      if (path_params) *path_params = std::move(groups);
+      route_ndx = ndx;
+      return true;
+    }
+
+    return false;
+  }
+
+  size_t size() const { return routes_.size(); }
+
+private:
+  struct Route {
+    enum class Kind {
+      kPrefix,  // regex is "^literal"
+      kExact,   // regex is "^literal$"
+      kRegex,   // regex has to be searched, prefix may be empty
+    };
+
+    std::string prefix;
+    Kind kind;
+    std::shared_ptr<const PosixRE> url_regex;
+  };
+
+  struct TrieNode {
+    std::map<char, std::unique_ptr<TrieNode>> children;
+    std::vector<size_t> routes;  // routes whose literal prefix ends here
+  };
+
+  /**
+   * get the literal text a (extended) regex requires at the start of a line.
+   *
+   * @returns false if the regex isn't anchored or has alternations
+   */
+  static bool parse_literal_prefix(const std::string &re, std::string &prefix, Route::Kind &kind) {
+    prefix.clear();
+    kind = Route::Kind::kRegex;
+
+    if (re.empty() || re[0] != '^') return false;
+
+    // alternatives may have different prefixes
+    for (size_t pos = 0; pos < re.size(); pos++) {
+      if (re[pos] == '\\') {
+        pos++;
+      } else if (re[pos] == '|') {
+        return false;
+      }
+    }
+
+    static const std::string kSpecial { ".[]()*+?{}|^$\\" };
+    static const std::string kQuantifier { "*+?{" };
+
+    size_t pos = 1;
+    while (pos < re.size()) {
+      char literal;
+      size_t len;
+      if (re[pos] == '\\') {
+        // only escaped punctuation is literal, \w and friends are classes
+        if (pos + 1 >= re.size() ||
+            std::isalnum(static_cast<unsigned char>(re[pos + 1]))) break;
+        literal = re[pos + 1];
+        len = 2;
+      } else if (kSpecial.find(re[pos]) != std::string::npos) {
+        break;
+      } else {
+        literal = re[pos];
+        len = 1;
+      }
+
+      // the character may be repeated or left out
+      if (pos + len < re.size() &&
+          kQuantifier.find(re[pos + len]) != std::string::npos) break;
+
+      prefix += literal;
+      pos += len;
+    }
+
+    if (pos == re.size()) {
+      kind = Route::Kind::kPrefix;
+    } else if (pos + 1 == re.size() && re[pos] == '$') {
+      kind = Route::Kind::kExact;
+    }
+
+    return true;
+  }
+
+  TrieNode root_;
+  std::vector<Route> routes_;
+};
+
+#endif
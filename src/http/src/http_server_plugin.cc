@@ -25,13 +25,24 @@
 /**
  */
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cinttypes>
+#include <cstring>
+#include <memory>
+#include <system_error>
 #include <thread>
 #include <mutex>
 
 #include <sys/types.h>
 
+#ifndef _WIN32
+# include <netdb.h>
+# include <netinet/in.h>
+# include <sys/socket.h>
+#endif
+
 #include <event2/buffer.h>
 #include <event2/event.h>
 #include <event2/http.h>
@@ -66,55 +77,89 @@ std::atomic<int> g_shutdown_pending { 0 };
  *
  * if no handler is found, reply with 404 not found
  */
-void HttpRequestRouter::append(const std::string &url_regex_str, std::unique_ptr<BaseRequestHandler> cb) {
-  std::lock_guard<std::mutex> lock(route_mtx_);
-  request_handlers_.emplace_back(RouterData { url_regex_str, PosixRE {url_regex_str}, std::move(cb) });
+std::shared_ptr<const HttpRequestRouter::RouteTable> HttpRequestRouter::get_route_table() const {
+  return std::atomic_load(&route_table_);
 }
 
-void HttpRequestRouter::remove(const std::string &url_regex_str) {
+template <class Func>
+void HttpRequestRouter::update_route_table(Func &&modify) {
   std::lock_guard<std::mutex> lock(route_mtx_);
-  for (auto it = request_handlers_.begin(); it != request_handlers_.end(); ) {
-    if (it->url_regex_str == url_regex_str) {
-      it = request_handlers_.erase(it);
-    } else {
-      it++;
-    }
+
+  std::shared_ptr<RouteTable> route_table = std::make_shared<RouteTable>(*route_table_);
+  modify(*route_table);
+
+  std::shared_ptr<HttpRouteMatcher> matcher = std::make_shared<HttpRouteMatcher>();
+  for (const auto &request_handler: route_table->request_handlers) {
+    matcher->add(request_handler->url_regex_str, request_handler->url_regex);
   }
+  route_table->matcher = std::move(matcher);
+
+  std::atomic_store(&route_table_, std::shared_ptr<const RouteTable>(std::move(route_table)));
+}
+
+void HttpRequestRouter::append(const std::string &url_regex_str, std::unique_ptr<BaseRequestHandler> cb) {
+  // compile the regex before taking the lock
+  std::shared_ptr<const RouterData> route = std::make_shared<RouterData>(
+      RouterData { url_regex_str, std::make_shared<PosixRE>(url_regex_str), std::move(cb) });
+
+  update_route_table([&route](RouteTable &route_table) {
+    route_table.request_handlers.push_back(std::move(route));
+  });
+}
+
+void HttpRequestRouter::remove(const std::string &url_regex_str) {
+  update_route_table([&url_regex_str](RouteTable &route_table) {
+    auto &handlers = route_table.request_handlers;
+    handlers.erase(std::remove_if(handlers.begin(), handlers.end(),
+          [&url_regex_str](const std::shared_ptr<const RouterData> &route) {
+            return route->url_regex_str == url_regex_str;
+          }), handlers.end());
+  });
 }
 
 // if no routes are specified, return 404
 void HttpRequestRouter::route_default(HttpRequest &req) {
-  if (default_route_) {
-    default_route_->handle_request(req);
+  handle_request(get_route_table()->default_route, req);
+}
+
+void HttpRequestRouter::handle_request(const std::shared_ptr<BaseRequestHandler> &handler, HttpRequest &req) {
+  if (handler) {
+    handler->handle_request(req);
   } else {
     req.send_error(HttpStatusCode::NotFound, "Not Found");
   }
 }
 
 void HttpRequestRouter::set_default_route(std::unique_ptr<BaseRequestHandler> cb) {
-  std::lock_guard<std::mutex> lock(route_mtx_);
-  default_route_ = std::move(cb);
+  std::shared_ptr<BaseRequestHandler> default_route(std::move(cb));
+
+  update_route_table([&default_route](RouteTable &route_table) {
+    route_table.default_route = std::move(default_route);
+  });
 }
 
 void HttpRequestRouter::clear_default_route() {
-  std::lock_guard<std::mutex> lock(route_mtx_);
-  default_route_ = nullptr;
+  update_route_table([](RouteTable &route_table) {
+    route_table.default_route = nullptr;
+  });
 }
 
 
 void HttpRequestRouter::route(HttpRequest req) {
-  std::lock_guard<std::mutex> lock(route_mtx_);
+  // no lock is held while the handler runs, requests are handled
+  // concurrently by all the threads of the server
+  handle_request(find_handler(req.get_uri()), req);
+}
 
-  auto uri = req.get_uri();
+std::shared_ptr<BaseRequestHandler> HttpRequestRouter::find_handler(const std::string &uri) const {
+  auto route_table = get_route_table();
 
-  for (auto &request_handler: request_handlers_) {
-    if (request_handler.url_regex.search(uri)) {
-      request_handler.handler->handle_request(req);
-      return;
-    }
+  size_t route_ndx;
+  if (route_table->matcher->match(uri, route_ndx)) {
+    return route_table->request_handlers[route_ndx]->handler;
   }
 
-  route_default(req);
+  return route_table->default_route;
 }
 
 
@@ -133,14 +178,28 @@ void HttpRequestThread::accept_socket() {
 }
 
 void HttpRequestThread::set_request_router(HttpRequestRouter &router) {
+  router_ = &router;
+
   evhttp_set_gencb(ev_http.get(), [](evhttp_request * req, void * user_data) {
-      auto *rtr = static_cast<HttpRequestRouter *>(user_data);
-      rtr->route(
+      auto *thr = static_cast<HttpRequestThread *>(user_data);
+
+      thr->requests_handled_.fetch_add(1, std::memory_order_relaxed);
+
+      if (!thr->keepalive_) {
+        // evhttp closes the connection after the reply
+        evhttp_add_header(evhttp_request_get_output_headers(req), "Connection", "close");
+      }
+
+      thr->router_->route(
           HttpRequest {
           std::unique_ptr<evhttp_request, std::function<void(evhttp_request *)>>(
               req, [](evhttp_request *){})
           });
-      }, &router);
+      }, this);
+}
+
+void HttpRequestThread::set_idle_timeout(std::chrono::seconds timeout) {
+  evhttp_set_timeout(ev_http.get(), static_cast<int>(timeout.count()));
 }
 
 void HttpRequestThread::wait_and_dispatch() {
@@ -175,6 +234,87 @@ public:
   }
 };
 
+namespace {
+
+// port a listening socket is bound to
+uint16_t get_bound_port(harness_socket_t sock) {
+  struct sockaddr_storage addr;
+  socklen_t addr_len = sizeof(addr);
+  if (getsockname(sock, reinterpret_cast<struct sockaddr *>(&addr), &addr_len) != 0) {
+    throw std::system_error(errno, std::generic_category(), "getsockname() failed");
+  }
+
+  if (addr.ss_family == AF_INET6) {
+    return ntohs(reinterpret_cast<struct sockaddr_in6 *>(&addr)->sin6_port);
+  }
+  return ntohs(reinterpret_cast<struct sockaddr_in *>(&addr)->sin_port);
+}
+
+}  // namespace
+
+#ifdef SO_REUSEPORT
+namespace {
+
+/**
+ * open a listening socket.
+ *
+ * @param reuse_port set SO_REUSEPORT to let other sockets with it listen on
+ *        the same port
+ */
+harness_socket_t listen_socket(const std::string &address, uint16_t port, bool reuse_port) {
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_PASSIVE;
+
+  struct addrinfo *ai;
+  int err = getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &ai);
+  if (err != 0) {
+    throw std::runtime_error(std::string("resolving ") + address + " failed: " + gai_strerror(err));
+  }
+  std::unique_ptr<struct addrinfo, decltype(&freeaddrinfo)> ai_deleter(ai, &freeaddrinfo);
+
+  harness_socket_t sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+  if (sock < 0) {
+    throw std::system_error(errno, std::generic_category(), "socket() failed");
+  }
+
+  int on = 1;
+  if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+      (reuse_port && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) ||
+      bind(sock, ai->ai_addr, ai->ai_addrlen) != 0 ||
+      listen(sock, 128) != 0 ||
+      evutil_make_socket_nonblocking(sock) != 0) {
+    int last_errno = errno;
+    evutil_closesocket(sock);
+    throw std::system_error(last_errno, std::generic_category(), "binding socket failed");
+  }
+
+  return sock;
+}
+
+/**
+ * fail if something listens on the port already.
+ *
+ * Another process of the same user which set SO_REUSEPORT could listen on
+ * the port too and the kernel would hand it a share of the connections.
+ */
+void ensure_port_is_free(const std::string &address, uint16_t port) {
+  evutil_closesocket(listen_socket(address, port, false));
+}
+
+}  // namespace
+
+class HttpRequestReusePortThread : public HttpRequestThread
+{
+public:
+  HttpRequestReusePortThread(const std::string &address, uint16_t port) {
+    accept_fd_ = listen_socket(address, port, true);
+  }
+};
+#endif
+
 void HttpServer::join_all() {
   while (!sys_threads.empty()) {
     auto &thr = sys_threads.back();
@@ -183,17 +323,35 @@ void HttpServer::join_all() {
   }
 }
 
-void HttpServer::start(size_t max_threads) {
-  thread_contexts.emplace_back(HttpRequestMainThread(address_.c_str(), port_));
+void HttpServer::start(size_t max_threads, std::chrono::seconds idle_timeout, bool keepalive) {
+#ifdef SO_REUSEPORT
+  // threads sharing one socket contend on its listen queue, with several
+  // threads each one listens on its own socket
+  if (max_threads > 1) {
+    if (port_ != 0) ensure_port_is_free(address_, port_);
 
-  harness_socket_t accept_fd = thread_contexts[0].get_socket_fd();
-  for (size_t ndx = 1; ndx < max_threads; ndx++) {
-    thread_contexts.emplace_back(HttpRequestWorkerThread(accept_fd));
+    for (size_t ndx = 0; ndx < max_threads; ndx++) {
+      thread_contexts.emplace_back(HttpRequestReusePortThread(address_, port_));
+      if (port_ == 0) port_ = get_bound_port(thread_contexts.back().get_socket_fd());
+    }
+  }
+#endif
+  if (thread_contexts.empty()) {
+    thread_contexts.emplace_back(HttpRequestMainThread(address_.c_str(), port_));
+    if (port_ == 0) port_ = get_bound_port(thread_contexts[0].get_socket_fd());
+
+    harness_socket_t accept_fd = thread_contexts[0].get_socket_fd();
+    for (size_t ndx = 1; ndx < max_threads; ndx++) {
+      thread_contexts.emplace_back(HttpRequestWorkerThread(accept_fd));
+    }
   }
 
   for (size_t ndx = 0; ndx < max_threads; ndx++) {
     auto &thr = thread_contexts[ndx];
 
+    thr.set_idle_timeout(idle_timeout);
+    thr.set_keepalive(keepalive);
+
     sys_threads.emplace_back(
       [&]() {
         thr.set_request_router(request_router_);
@@ -204,6 +362,16 @@ void HttpServer::start(size_t max_threads) {
   }
 }
 
+std::vector<uint64_t> HttpServer::get_requests_handled() const {
+  std::vector<uint64_t> requests_handled;
+
+  for (const auto &thr: thread_contexts) {
+    requests_handled.push_back(thr.get_requests_handled());
+  }
+
+  return requests_handled;
+}
+
 void HttpServer::add_route(const std::string &url_regex, std::unique_ptr<BaseRequestHandler> cb) {
   log_debug("adding route for regex: %s", url_regex.c_str());
   if (url_regex.empty()) {
@@ -226,20 +394,32 @@ void HttpServer::remove_route(const std::string &url_regex) {
 class PluginConfig : public mysqlrouter::BasePluginConfig {
 public:
   std::string static_basedir;
+  uint32_t static_cache_size;
   std::string srv_address;
   uint16_t srv_port;
+  uint32_t threads;
+  uint32_t idle_timeout;
+  bool keepalive;
 
   explicit PluginConfig(const mysql_harness::ConfigSection *section):
     mysqlrouter::BasePluginConfig(section),
     static_basedir(get_option_string(section, "static_folder")),
+    static_cache_size(get_uint_option<uint32_t>(section, "static_cache_size")),
     srv_address(get_option_string(section, "bind_address")),
-    srv_port(get_uint_option<uint16_t>(section, "port"))
+    srv_port(get_uint_option<uint16_t>(section, "port")),
+    threads(get_uint_option<uint32_t>(section, "threads", 1, 1024)),
+    idle_timeout(get_uint_option<uint32_t>(section, "idle_timeout", 1, 3600)),
+    keepalive(get_uint_option<uint32_t>(section, "keepalive", 0, 1) == 1)
   {}
 
   std::string get_default(const std::string &option) const override {
     const std::map<std::string, std::string> defaults{
         {"bind_address", "0.0.0.0"},
         {"port", "5555"},
+        {"static_cache_size", "8388608"},
+        {"threads", "8"},
+        {"idle_timeout", "50"},
+        {"keepalive", "1"},
     };
 
     auto it = defaults.find(option);
@@ -292,7 +472,7 @@ static void init(PluginFuncEnv* env) {
       if (!config.static_basedir.empty()) {
         srv->add_route("",
             std::unique_ptr<HttpStaticFolderHandler>(
-              new HttpStaticFolderHandler(config.static_basedir)));
+              new HttpStaticFolderHandler(config.static_basedir, config.static_cache_size)));
       }
     }
   } catch (const std::invalid_argument& exc) {
@@ -304,6 +484,34 @@ static void init(PluginFuncEnv* env) {
   }
 }
 
+// how often the requests handled by each thread are logged
+static constexpr std::chrono::minutes kRequestsReportInterval { 10 };
+
+/**
+ * log the requests handled by each thread, shows how evenly the kernel
+ * balances the connections.
+ *
+ * @param reported requests handled at the last report
+ * @returns requests handled now, nothing is logged if it didn't change
+ */
+static uint64_t log_requests_handled(const HttpServer &srv, uint64_t reported) {
+  const auto requests_handled = srv.get_requests_handled();
+
+  uint64_t total = 0;
+  std::string per_thread;
+  for (const auto requests: requests_handled) {
+    total += requests;
+    if (!per_thread.empty()) per_thread += ", ";
+    per_thread += std::to_string(requests);
+  }
+
+  if (total != reported) {
+    log_info("handled %" PRIu64 " requests, per thread: %s", total, per_thread.c_str());
+  }
+
+  return total;
+}
+
 static void start(PluginFuncEnv* env) {
   // - version string
   // - hostname
@@ -325,19 +533,30 @@ static void start(PluginFuncEnv* env) {
   // - important log messages
   // - mismatch between group-membership and metadata
   try {
-    auto srv = http_servers.at(get_config_section(env)->name);
+    const mysql_harness::ConfigSection *section = get_config_section(env);
+    auto srv = http_servers.at(section->name);
+    PluginConfig config {section};
 
     // add routes
 
-    srv->start(8);
+    srv->start(config.threads, std::chrono::seconds(config.idle_timeout), config.keepalive);
 
     // we are supposed to block
+    auto next_report = std::chrono::steady_clock::now() + kRequestsReportInterval;
+    uint64_t reported_requests = 0;
     while (is_running(env)) {
       std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+      if (std::chrono::steady_clock::now() >= next_report) {
+        next_report += kRequestsReportInterval;
+        reported_requests = log_requests_handled(*srv, reported_requests);
+      }
     }
     g_shutdown_pending = 1;
 
     srv->join_all();
+
+    log_requests_handled(*srv, reported_requests);
   } catch (const std::invalid_argument& exc) {
     set_error(env, mysql_harness::kConfigInvalidArgument, "%s", exc.what());
   } catch (const std::exception& exc) {
@@ -25,6 +25,9 @@
 #ifndef MYSQLROUTER_HTTP_SERVER_PLUGIN_INCLUDED
 #define MYSQLROUTER_HTTP_SERVER_PLUGIN_INCLUDED
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 #include <thread>
@@ -37,7 +40,9 @@
 #include <event2/util.h>
 
 #include "mysqlrouter/http_server_component.h"
+#include "http_route_matcher.h"
 #include "posix_re.h"
+#include "static_file_cache.h"
 
 using harness_socket_t = evutil_socket_t;
 
@@ -55,16 +60,48 @@ public:
   void set_default_route(std::unique_ptr<BaseRequestHandler> cb);
   void clear_default_route();
   void route(HttpRequest req);
+
+  /**
+   * handler a request for the URI would be routed to.
+   *
+   * @returns the handler of the first matching route, the default route or
+   *          nullptr if neither exists
+   */
+  std::shared_ptr<BaseRequestHandler> find_handler(const std::string &uri) const;
 private:
   struct RouterData {
     std::string url_regex_str;
-    PosixRE url_regex;
-    std::unique_ptr<BaseRequestHandler> handler;
+    std::shared_ptr<const PosixRE> url_regex;
+    std::shared_ptr<BaseRequestHandler> handler;
+  };
+
+  /**
+   * routes as seen by requests.
+   *
+   * never modified once published. Requests work on a snapshot of it
+   * without locking, which keeps handlers which got removed meanwhile alive
+   * until the request is finished.
+   */
+  struct RouteTable {
+    std::vector<std::shared_ptr<const RouterData>> request_handlers;
+    std::shared_ptr<BaseRequestHandler> default_route;
+
+    // compiled from request_handlers
+    std::shared_ptr<const HttpRouteMatcher> matcher { std::make_shared<HttpRouteMatcher>() };
   };
-  std::vector<RouterData> request_handlers_;
 
-  std::unique_ptr<BaseRequestHandler> default_route_;
+  // runs the handler, or replies 404 if there is none
+  static void handle_request(const std::shared_ptr<BaseRequestHandler> &handler, HttpRequest &req);
+
+  std::shared_ptr<const RouteTable> get_route_table() const;
+
+  // publish a modified copy of the current route table
+  template <class Func>
+  void update_route_table(Func &&modify);
 
+  std::shared_ptr<const RouteTable> route_table_ { std::make_shared<RouteTable>() };
+
+  // serializes writers of route_table_
   std::mutex route_mtx_;
 };
 
@@ -74,10 +111,13 @@ private:
  * - HttpRequestMainThread opens the socket, and accepts and handles connections
  * - HttpRequestWorkerThread accepts and handles connections, using the socket
  *   listened by the main-thread
+ * - HttpRequestReusePortThread opens its own socket with SO_REUSEPORT, and
+ *   accepts and handles connections on it
  *
- * As all threads can accept in parallel this may lead to a thundering herd problem
- * and quite likely it is better to let only one thread accept() and push the socket
- * handling into async-deque and let all workers steal from the queue
+ * If all threads accept on the same socket they contend on one listen queue
+ * which may lead to a thundering herd problem. Where SO_REUSEPORT is available
+ * and more than one thread is configured, each thread listens on its own
+ * socket instead and the kernel balances the new connections between them.
  */
 class HttpRequestThread
 {
@@ -88,8 +128,35 @@ public:
     ev_shutdown_timer(event_new(ev_base.get(), -1, EV_PERSIST, stop_eventloop, ev_base.get()), &event_free)
   {}
 
+  HttpRequestThread(HttpRequestThread &&other):
+    ev_base(std::move(other.ev_base)),
+    ev_http(std::move(other.ev_http)),
+    ev_shutdown_timer(std::move(other.ev_shutdown_timer)),
+    keepalive_(other.keepalive_),
+    accept_fd_(other.accept_fd_),
+    requests_handled_(other.requests_handled_.load()),
+    router_(other.router_)
+  {}
+
   harness_socket_t get_socket_fd() { return accept_fd_; }
 
+  /**
+   * set how long connections may stay idle before they are closed.
+   *
+   * @param timeout timeout in seconds
+   */
+  void set_idle_timeout(std::chrono::seconds timeout);
+
+  /**
+   * set if connections are kept open after a request.
+   */
+  void set_keepalive(bool keepalive) { keepalive_ = keepalive; }
+
+  /**
+   * number of requests this thread handled so far.
+   */
+  uint64_t get_requests_handled() const { return requests_handled_.load(std::memory_order_relaxed); }
+
   void accept_socket();
   void set_request_router(HttpRequestRouter &router);
   void wait_and_dispatch();
@@ -98,7 +165,14 @@ protected:
   std::unique_ptr<evhttp, decltype(&evhttp_free)> ev_http;
   std::unique_ptr<event, decltype(&event_free)> ev_shutdown_timer;
 
+  bool keepalive_ { true };
+
   harness_socket_t accept_fd_ { -1 };
+
+  // only written by the thread itself, but read by others
+  std::atomic<uint64_t> requests_handled_ { 0 };
+
+  HttpRequestRouter *router_ { nullptr };
 };
 
 
@@ -121,9 +195,30 @@ public:
     join_all();
   }
 
-  void start(size_t max_threads);
+  /**
+   * start the threads handling requests.
+   *
+   * @param max_threads number of threads to start
+   * @param idle_timeout seconds connections may stay idle before they are closed
+   * @param keepalive keep connections open after a request
+   */
+  void start(size_t max_threads, std::chrono::seconds idle_timeout, bool keepalive);
+
+  /**
+   * requests handled per thread.
+   */
+  std::vector<uint64_t> get_requests_handled() const;
+
   void add_route(const std::string &url_regex, std::unique_ptr<BaseRequestHandler> cb);
   void remove_route(const std::string &url_regex);
+
+  /**
+   * port the server listens on.
+   *
+   * If the server was created with port 0, the port the system picked once
+   * start() returned.
+   */
+  uint16_t get_port() const { return port_; }
 private:
   std::vector<HttpRequestThread> thread_contexts;
   std::string address_;
@@ -135,12 +230,17 @@ private:
 
 class HttpStaticFolderHandler: public BaseRequestHandler {
 public:
-  explicit HttpStaticFolderHandler(std::string static_basedir):
-    static_basedir_(std::move(static_basedir)) {}
+  // files up to this size are cached, larger ones are sent with sendfile()
+  static constexpr size_t kMaxCachedFileSize = 256 * 1024;
+
+  HttpStaticFolderHandler(std::string static_basedir, size_t cache_size):
+    static_basedir_(std::move(static_basedir)),
+    cache_(cache_size, kMaxCachedFileSize) {}
 
   void handle_request(HttpRequest &req) override;
 private:
   std::string static_basedir_;
+  StaticFileCache cache_;
 };
 
 #endif
@@ -48,6 +48,8 @@
 #endif
 
 #include <memory>
+#include <string>
+#include <vector>
 
 class PosixRE_constants {
 public:
@@ -170,6 +172,44 @@ public:
     return true;
 #else
     return std::regex_search(line, reg_, match_flags);
+#endif
+  }
+
+  /**
+   * search entire line for match and return the sub-expressions.
+   *
+   * @param line line to search
+   * @param groups set to the text of the parenthesized sub-expressions, empty
+   *        strings for those which didn't participate in the match
+   * @param match_flags flags for matching
+   */
+  bool search(const std::string &line, std::vector<std::string> &groups,
+      match_flag_type match_flags = match_default) const {
+    groups.clear();
+#ifdef USE_POSIX_RE_IMPL
+    std::vector<regmatch_t> matches(reg_->re_nsub + 1);
+    if (0 != regexec(reg_.get(), line.c_str(), matches.size(), matches.data(), match_flags)) {
+      return false;
+    }
+
+    for (size_t ndx = 1; ndx < matches.size(); ndx++) {
+      const auto &m = matches[ndx];
+      groups.emplace_back(m.rm_so < 0 ? std::string() :
+          line.substr(static_cast<size_t>(m.rm_so), static_cast<size_t>(m.rm_eo - m.rm_so)));
+    }
+
+    return true;
+#else
+    std::smatch matches;
+    if (!std::regex_search(line, matches, reg_, match_flags)) {
+      return false;
+    }
+
+    for (size_t ndx = 1; ndx < matches.size(); ndx++) {
+      groups.emplace_back(matches[ndx].str());
+    }
+
+    return true;
 #endif
   }
 private:
@@ -0,0 +1,178 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "static_file_cache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <sys/stat.h>
+
+namespace {
+
+bool read_file(const std::string &file_path, size_t size, std::string &content) {
+  std::ifstream ifs(file_path, std::ios::binary);
+  if (!ifs) return false;
+
+  content.resize(size);
+  if (size > 0 && !ifs.read(&content[0], static_cast<std::streamsize>(size))) return false;
+
+  // the file may have grown since it was stat()ed
+  return ifs.peek() == std::ifstream::traits_type::eof();
+}
+
+}  // namespace
+
+StaticFileCache::FileVersion StaticFileCache::gzip_version(const std::string &file_path) {
+  const std::string gzip_path = file_path + ".gz";
+  struct stat gzip_st;
+  if (0 != stat(gzip_path.c_str(), &gzip_st) || (gzip_st.st_mode & S_IFMT) != S_IFREG) {
+    return FileVersion { 0, 0, 0, -1 };
+  }
+
+  return FileVersion::from_stat(gzip_st);
+}
+
+std::string StaticFileCache::make_etag(const struct stat &st, bool gzip) {
+  const FileVersion version = FileVersion::from_stat(st);
+
+  char etag[96];
+  snprintf(etag, sizeof(etag), "\"%llx-%llx-%llx.%lx%s\"",
+      static_cast<unsigned long long>(version.ino),
+      static_cast<unsigned long long>(version.size),
+      static_cast<unsigned long long>(version.mtime),
+      static_cast<unsigned long>(version.mtime_nsec),
+      gzip ? "-gz" : "");
+
+  return etag;
+}
+
+bool StaticFileCache::etag_matches(const std::string &if_none_match, const std::string &etag) {
+  // If-None-Match compares weakly: the W/ prefix is ignored on both sides
+  auto opaque_tag = [](const std::string &tag) {
+    return tag.compare(0, 2, "W/") == 0 ? tag.substr(2) : tag;
+  };
+  const std::string wanted = opaque_tag(etag);
+
+  std::istringstream tags { if_none_match };
+  std::string tag;
+  while (std::getline(tags, tag, ',')) {
+    const auto first = tag.find_first_not_of(" \t");
+    if (first == std::string::npos) continue;
+    const auto last = tag.find_last_not_of(" \t");
+    tag = tag.substr(first, last - first + 1);
+
+    if (tag == "*" || opaque_tag(tag) == wanted) return true;
+  }
+
+  return false;
+}
+
+std::shared_ptr<const StaticFileCache::Entry> StaticFileCache::get(
+    const std::string &file_path, const struct stat &st) {
+  const off_t size = st.st_size;
+  if (size < 0 || static_cast<size_t>(size) > max_file_size_ ||
+      static_cast<size_t>(size) > max_size_) {
+    return nullptr;
+  }
+
+  const FileVersion version = FileVersion::from_stat(st);
+  const FileVersion gz_version = gzip_version(file_path);
+
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = files_.find(file_path);
+    if (it != files_.end()) {
+      const auto &entry = it->second.entry;
+      if (entry->version == version && entry->gzip_version == gz_version) {
+        lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+        return entry;
+      }
+
+      // file or its .gz changed
+      size_ -= entry_size(*entry);
+      lru_.erase(it->second.lru_pos);
+      files_.erase(it);
+    }
+  }
+
+  // read without holding the lock, other threads may read the same file
+  // meanwhile, the last one wins
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  entry->version = version;
+  entry->gzip_version = gz_version;
+  if (!read_file(file_path, static_cast<size_t>(size), entry->content)) {
+    return nullptr;
+  }
+
+  // a .gz older than the file is stale
+  const bool gzip_is_current =
+      gz_version.size >= 0 &&
+      (gz_version.mtime > version.mtime ||
+       (gz_version.mtime == version.mtime && gz_version.mtime_nsec >= version.mtime_nsec));
+  if (gzip_is_current && static_cast<size_t>(gz_version.size) <= max_file_size_) {
+    if (!read_file(file_path + ".gz", static_cast<size_t>(gz_version.size), entry->gzip_content)) {
+      entry->gzip_content.clear();
+    }
+  }
+
+  const size_t needed = entry_size(*entry);
+  if (needed > max_size_) {
+    // with the .gz the file doesn't fit, serve it plain and uncached
+    entry->gzip_content.clear();
+    return entry;
+  }
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto it = files_.find(file_path);
+  if (it != files_.end()) {
+    size_ -= entry_size(*it->second.entry);
+    lru_.erase(it->second.lru_pos);
+    files_.erase(it);
+  }
+
+  evict(needed);
+
+  lru_.push_front(file_path);
+  files_[file_path] = CachedFile { entry, lru_.begin() };
+  size_ += needed;
+
+  return entry;
+}
+
+void StaticFileCache::evict(size_t needed) {
+  while (!lru_.empty() && size_ + needed > max_size_) {
+    auto it = files_.find(lru_.back());
+    size_ -= entry_size(*it->second.entry);
+    files_.erase(it);
+    lru_.pop_back();
+  }
+}
+
+size_t StaticFileCache::size() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return size_;
+}
@@ -0,0 +1,124 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef MYSQLROUTER_STATIC_FILE_CACHE_INCLUDED
+#define MYSQLROUTER_STATIC_FILE_CACHE_INCLUDED
+
+#include <ctime>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "mysql/harness/filesystem.h"
+
+/**
+ * content of small static files, kept in memory.
+ *
+ * Entries are checked against the version of the file and of the
+ * "<file>.gz" next to it on each lookup, changed files are read again. The
+ * total size of the cached content is bounded, the least recently used
+ * files are evicted first.
+ */
+class StaticFileCache {
+public:
+  using FileVersion = mysql_harness::FileVersion;
+
+  struct Entry {
+    std::string content;
+    FileVersion version;
+    // content of a "<file>.gz" next to the file, unless it is older
+    std::string gzip_content;
+    FileVersion gzip_version;
+  };
+
+  /**
+   * @param max_size maximum size of the cached content in bytes, 0 disables caching
+   * @param max_file_size files larger than this aren't cached
+   */
+  StaticFileCache(size_t max_size, size_t max_file_size):
+    max_size_(max_size), max_file_size_(max_file_size) {}
+
+  /**
+   * get the content of a file.
+   *
+   * @param file_path path of the file
+   * @param st current status of the file
+   * @returns the content or nullptr if the file is too large to be cached
+   *          or can't be read
+   */
+  std::shared_ptr<const Entry> get(const std::string &file_path, const struct stat &st);
+
+  /**
+   * total size of the cached content.
+   */
+  size_t size() const;
+
+  /**
+   * build an ETag from the version of a file.
+   *
+   * @param st status of the file
+   * @param gzip true for the ETag of the gzip encoded representation
+   */
+  static std::string make_etag(const struct stat &st, bool gzip);
+
+  /**
+   * check an If-None-Match header against the ETag of a representation.
+   *
+   * Handles lists of ETags, "*" and weak ETags, which are compared weakly
+   * as RFC 7232 asks for.
+   *
+   * @returns true if the client has the representation already
+   */
+  static bool etag_matches(const std::string &if_none_match, const std::string &etag);
+private:
+  static size_t entry_size(const Entry &entry) {
+    return entry.content.size() + entry.gzip_content.size();
+  }
+
+  static FileVersion gzip_version(const std::string &file_path);
+
+  void evict(size_t needed);
+
+  const size_t max_size_;
+  const size_t max_file_size_;
+
+  struct CachedFile {
+    std::shared_ptr<const Entry> entry;
+    std::list<std::string>::iterator lru_pos;
+  };
+
+  mutable std::mutex mtx_;
+  std::map<std::string, CachedFile> files_;
+  // most recently used first
+  std::list<std::string> lru_;
+  size_t size_ { 0 };
+};
+
+#endif
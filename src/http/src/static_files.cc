@@ -22,6 +22,9 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
 #include <string>
 #include <memory>
 #include <map>
@@ -38,40 +41,64 @@
 #include "mysqlrouter/http_server_component.h"
 #include "http_server_plugin.h"
 
+namespace {
+
+const char *get_mimetype(const std::string &file_path) {
+  static const std::map<std::string, std::string> mimetypes {
+    { "css", "text/css" },
+    { "js", "text/javascript" },
+    { "json", "application/json" },
+    { "html", "text/html" },
+    { "png", "image/png" },
+    { "svg", "image/svg+xml" },
+  };
+
+  auto n = file_path.rfind('.');
+  if (n == std::string::npos) {
+    return nullptr;
+  }
+
+  auto it = mimetypes.find(file_path.substr(n + 1));
+
+  return it != mimetypes.end() ? it->second.c_str() : "application/octet-stream";
+}
+
+// does the client accept "gzip" as Content-Encoding
+bool accepts_gzip(const char *accept_encoding) {
+  if (accept_encoding == nullptr) return false;
+
+  std::istringstream codings { accept_encoding };
+  std::string coding;
+  while (std::getline(codings, coding, ',')) {
+    coding.erase(std::remove(coding.begin(), coding.end(), ' '), coding.end());
+
+    std::string qvalue { "1" };
+    auto params = coding.find(';');
+    if (params != std::string::npos) {
+      auto q = coding.find("q=", params);
+      if (q != std::string::npos) qvalue = coding.substr(q + 2);
+      coding.resize(params);
+    }
+
+    if ((coding == "gzip" || coding == "*") && std::strtod(qvalue.c_str(), nullptr) > 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+}  // namespace
+
 void HttpStaticFolderHandler::handle_request(HttpRequest &req) {
   HttpUri parsed_uri { HttpUri::parse( req.get_uri() ) };
 
-  // guess mime-type
-
   std::string file_path { static_basedir_ };
 
   file_path += "/";
   // normalize the path
   file_path += parsed_uri.get_path();
 
-  auto out_hdrs = req.get_output_headers();
-
-  auto n = file_path.rfind('.');
-  if (n != std::string::npos) {
-    const std::map<std::string, std::string> mimetypes {
-      { "css", "text/css" },
-      { "js", "text/javascript" },
-      { "json", "application/json" },
-      { "html", "text/html" },
-      { "png", "image/png" },
-      { "svg", "image/svg+xml" },
-    };
-    std::string extension = file_path.substr(n + 1);
-    auto it = mimetypes.find(extension);
-
-    if (it != mimetypes.end()) {
-      // found
-      out_hdrs.add("Content-Type", it->second.c_str());
-    } else {
-      out_hdrs.add("Content-Type", "application/octet-stream");
-    }
-  }
-
   struct stat st;
   if (-1 == stat(file_path.c_str(), &st)) {
     if (errno == ENOENT) {
@@ -106,46 +133,71 @@ void HttpStaticFolderHandler::handle_request(HttpRequest &req) {
 
   // file exists
 
+  auto out_hdrs = req.get_output_headers();
+
+  // small files are served from memory, Content-Length is set by libevent
+  auto entry = cache_.get(file_path, st);
+  const bool has_gzip = entry && !entry->gzip_content.empty();
+  const bool send_gzip = has_gzip &&
+    accepts_gzip(req.get_input_headers().get("Accept-Encoding"));
+
+  // each representation has its own ETag
+  const std::string etag = StaticFileCache::make_etag(st, send_gzip);
+  out_hdrs.add("ETag", etag.c_str());
+  if (has_gzip) {
+    out_hdrs.add("Vary", "Accept-Encoding");
+  }
+
+  // send_error() would drop the ETag and close the connection
+  const char *if_none_match = req.get_input_headers().get("If-None-Match");
+  if ((if_none_match != nullptr && StaticFileCache::etag_matches(if_none_match, etag)) ||
+      (if_none_match == nullptr && !req.is_modified_since(st.st_mtime))) {
+    req.send_reply(HttpStatusCode::NotModified);
+    return;
+  }
+
+  const char *mimetype = get_mimetype(file_path);
+  if (mimetype != nullptr) {
+    out_hdrs.add("Content-Type", mimetype);
+  }
+
+  req.add_last_modified(st.st_mtime);
+
+  auto chunk = req.get_output_buffer();
+
+  if (entry) {
+    const std::string *content = &entry->content;
+    if (send_gzip) {
+      out_hdrs.add("Content-Encoding", "gzip");
+      content = &entry->gzip_content;
+    }
+
+    chunk.add(content->data(), content->size());
+    req.send_reply(HttpStatusCode::Ok, HttpStatusCode::get_default_status_text(HttpStatusCode::Ok), chunk);
+
+    return;
+  }
+
   int file_fd = open(file_path.c_str(), O_RDONLY);
 
   if (file_fd < 0) {
     if (errno == ENOENT) {
-      // if it was a directory
       req.send_error(HttpStatusCode::NotFound);
-
-      return;
     } else {
       req.send_error(HttpStatusCode::InternalError);
-
-      return;
-    }
-  } else {
-    if (!req.is_modified_since(st.st_mtime)) {
-      req.send_error(HttpStatusCode::NotModified);
-      return;
-    }
-
-    req.add_last_modified(st.st_mtime);
-
-    auto chunk = req.get_output_buffer();
-    // if the file-size is 0, there is nothing to send ... and it triggers a mmap() error
-    if (st.st_size > 0) {
-      // only use sendfile if packet is large enough as it will be sent in sep TCP packet/syscall
-      //
-      // using TCP_CORK would help here
-      // if (st.st_size > 64 * 1024) {
-      //    evbuffer_set_flags(chunk, EVBUFFER_FLAG_DRAINS_TO_FD);
-      // }
-      chunk.add_file(file_fd, 0, st.st_size);
-      // file_fd is owned by evbuffer_add_file(), don't close it
-    } else {
-      close(file_fd);
     }
 
-    req.send_reply(HttpStatusCode::Ok, HttpStatusCode::get_default_status_text(HttpStatusCode::Ok), chunk);
-
     return;
   }
-}
 
+  // if the file-size is 0, there is nothing to send ... and it triggers a mmap() error
+  if (st.st_size > 0) {
+    // large files are sent with sendfile() by libevent
+    chunk.add_file(file_fd, 0, st.st_size);
+    // file_fd is owned by evbuffer_add_file(), don't close it
+  } else {
+    close(file_fd);
+  }
 
+  req.send_reply(HttpStatusCode::Ok, HttpStatusCode::get_default_status_text(HttpStatusCode::Ok), chunk);
+}
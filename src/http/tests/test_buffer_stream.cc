@@ -0,0 +1,103 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <memory>
+#include <string>
+
+#include <event2/buffer.h>
+
+#include <rapidjson/writer.h>
+
+#include "gmock/gmock.h"
+
+#include "mysqlrouter/http_common.h"
+
+class HttpBufferOutputStreamTest : public ::testing::Test {
+protected:
+  std::string contents(HttpBuffer &buf) {
+    auto data = buf.pop_front(buf.length());
+    return std::string(data.begin(), data.end());
+  }
+
+  HttpBuffer make_buffer() {
+    return HttpBuffer {
+      std::unique_ptr<evbuffer, std::function<void(evbuffer *)>>(
+          evbuffer_new(), evbuffer_free)
+    };
+  }
+};
+
+TEST_F(HttpBufferOutputStreamTest, json_writer) {
+  auto buf = make_buffer();
+  {
+    HttpBufferOutputStream os(buf);
+    rapidjson::Writer<HttpBufferOutputStream> writer(os);
+
+    writer.StartObject();
+    writer.Key("a");
+    writer.Int(1);
+    writer.EndObject();
+  }
+
+  EXPECT_THAT(contents(buf), ::testing::StrEq("{\"a\":1}"));
+}
+
+TEST_F(HttpBufferOutputStreamTest, put_is_buffered_until_flush) {
+  auto buf = make_buffer();
+  HttpBufferOutputStream os(buf);
+
+  os.Put('x');
+  EXPECT_THAT(buf.length(), ::testing::Eq(0u));
+
+  os.Flush();
+  EXPECT_THAT(contents(buf), ::testing::StrEq("x"));
+}
+
+TEST_F(HttpBufferOutputStreamTest, large_output) {
+  auto buf = make_buffer();
+  HttpBufferOutputStream os(buf);
+
+  const std::string expected(10000, 'x');
+  for (auto c: expected) {
+    os.Put(c);
+  }
+  os.Flush();
+
+  EXPECT_THAT(contents(buf), ::testing::StrEq(expected));
+}
+
+TEST_F(HttpBufferOutputStreamTest, reset_switches_buffer) {
+  auto buf1 = make_buffer();
+  auto buf2 = make_buffer();
+
+  HttpBufferOutputStream os(buf1);
+  os.Put('a');
+  os.reset(buf2);
+  os.Put('b');
+  os.Flush();
+
+  EXPECT_THAT(contents(buf1), ::testing::StrEq("a"));
+  EXPECT_THAT(contents(buf2), ::testing::StrEq("b"));
+}
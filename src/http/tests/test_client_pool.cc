@@ -0,0 +1,213 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <atomic>
+#include <set>
+#include <string>
+#include <thread>
+
+#include <event2/buffer.h>
+#include <event2/event.h>
+#include <event2/http.h>
+
+#include "gmock/gmock.h"
+
+#include "mysqlrouter/http_client.h"
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#else
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+/**
+ * HTTP server on an ephemeral port which echos the request's URI.
+ */
+class EchoServer {
+public:
+  EchoServer():
+    ev_base_(event_base_new(), &event_base_free),
+    ev_http_(evhttp_new(ev_base_.get()), &evhttp_free) {
+    evhttp_set_gencb(ev_http_.get(), [](evhttp_request *req, void *arg) {
+        auto *self = static_cast<EchoServer *>(arg);
+        self->connections_.insert(evhttp_request_get_connection(req));
+        const char *host = evhttp_find_header(evhttp_request_get_input_headers(req), "Host");
+        self->host_header_ = host != nullptr ? host : "";
+
+        const char *uri = evhttp_request_get_uri(req);
+        evbuffer *body = evbuffer_new();
+        evbuffer_add(body, uri, strlen(uri));
+        evhttp_send_reply(req, 200, "Ok", body);
+        evbuffer_free(body);
+        }, this);
+
+    auto *handle = evhttp_bind_socket_with_handle(ev_http_.get(), "127.0.0.1", 0);
+    if (nullptr == handle) {
+      throw std::runtime_error("binding socket failed");
+    }
+
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    getsockname(evhttp_bound_socket_get_fd(handle), reinterpret_cast<struct sockaddr *>(&addr), &addr_len);
+    port_ = ntohs(addr.sin_port);
+
+    thr_ = std::thread([this]() {
+        struct timeval tv { 0, 10 * 1000 };
+        event *ev_stop = event_new(ev_base_.get(), -1, EV_PERSIST, [](evutil_socket_t, short, void *arg) {
+            auto *self = static_cast<EchoServer *>(arg);
+            if (self->stop_) event_base_loopexit(self->ev_base_.get(), nullptr);
+            }, this);
+        event_add(ev_stop, &tv);
+        event_base_dispatch(ev_base_.get());
+        event_free(ev_stop);
+        });
+  }
+
+  ~EchoServer() {
+    stop();
+  }
+
+  uint16_t port() const { return port_; }
+
+  // only valid after the server is stopped
+  size_t connections_seen() const { return connections_.size(); }
+
+  // Host header of the last request, only valid after the server is stopped
+  std::string host_header() const { return host_header_; }
+
+  void stop() {
+    if (thr_.joinable()) {
+      stop_ = true;
+      thr_.join();
+    }
+  }
+private:
+  std::unique_ptr<event_base, decltype(&event_base_free)> ev_base_;
+  std::unique_ptr<evhttp, decltype(&evhttp_free)> ev_http_;
+  uint16_t port_;
+  std::atomic<bool> stop_ { false };
+  std::set<evhttp_connection *> connections_;
+  std::string host_header_;
+  std::thread thr_;
+};
+
+static std::string body_of(HttpRequest &req) {
+  auto buf = req.get_input_buffer();
+  auto data = buf.pop_front(buf.length());
+  return std::string(data.begin(), data.end());
+}
+
+TEST(HttpClientPoolTest, concurrent_requests) {
+  EchoServer srv;
+  IOContext io_ctx;
+  HttpClientPool pool(io_ctx, 4);
+
+  const size_t kRequests = 20;
+  std::vector<std::string> responses(kRequests);
+
+  for (size_t ndx = 0; ndx < kRequests; ++ndx) {
+    pool.make_request("127.0.0.1", srv.port(), HttpMethod::Get, "/" + std::to_string(ndx),
+        [&responses, ndx](HttpRequest &req, std::chrono::microseconds) {
+          ASSERT_TRUE(req);
+          EXPECT_EQ(200u, req.get_response_code());
+          responses[ndx] = body_of(req);
+        });
+  }
+  EXPECT_EQ(kRequests, pool.pending_requests());
+
+  pool.wait_all();
+
+  for (size_t ndx = 0; ndx < kRequests; ++ndx) {
+    EXPECT_EQ("/" + std::to_string(ndx), responses[ndx]);
+  }
+
+  auto stats = pool.get_stats();
+  EXPECT_EQ(kRequests, stats.requests_ok);
+  EXPECT_EQ(0u, stats.requests_failed);
+  EXPECT_GE(stats.total_duration, stats.max_duration);
+
+  srv.stop();
+  // connections are kept alive and reused
+  EXPECT_LE(srv.connections_seen(), 4u);
+}
+
+TEST(HttpClientPoolTest, request_from_handler) {
+  EchoServer srv;
+  IOContext io_ctx;
+  HttpClientPool pool(io_ctx, 1);
+
+  std::vector<std::string> responses;
+  std::function<void(HttpRequest &, std::chrono::microseconds)> handler =
+    [&](HttpRequest &req, std::chrono::microseconds) {
+      responses.push_back(body_of(req));
+      if (responses.size() < 3) {
+        pool.make_request("127.0.0.1", srv.port(), HttpMethod::Get, "/next", handler);
+      }
+    };
+
+  pool.make_request("127.0.0.1", srv.port(), HttpMethod::Get, "/first", handler);
+
+  pool.wait_all();
+
+  EXPECT_THAT(responses, ::testing::ElementsAre("/first", "/next", "/next"));
+}
+
+TEST(HttpClientPoolTest, host_header_has_port) {
+  EchoServer srv;
+  IOContext io_ctx;
+  HttpClientPool pool(io_ctx);
+
+  pool.make_request("127.0.0.1", srv.port(), HttpMethod::Get, "/",
+      [](HttpRequest &, std::chrono::microseconds) {});
+  pool.wait_all();
+
+  srv.stop();
+  EXPECT_EQ("127.0.0.1:" + std::to_string(srv.port()), srv.host_header());
+}
+
+TEST(HttpClientPoolTest, connection_refused) {
+  uint16_t port;
+  {
+    // get a port nothing listens on
+    EchoServer srv;
+    port = srv.port();
+  }
+
+  IOContext io_ctx;
+  HttpClientPool pool(io_ctx);
+
+  bool handled = false;
+  pool.make_request("127.0.0.1", port, HttpMethod::Get, "/",
+      [&handled](HttpRequest &req, std::chrono::microseconds) {
+        handled = true;
+        EXPECT_FALSE(req);
+      });
+
+  pool.wait_all();
+
+  EXPECT_TRUE(handled);
+  EXPECT_EQ(1u, pool.get_stats().requests_failed);
+}
@@ -0,0 +1,324 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#ifndef _WIN32
+# include <arpa/inet.h>
+# include <netinet/in.h>
+# include <sys/socket.h>
+# include <sys/time.h>
+# include <unistd.h>
+#endif
+
+#include "gmock/gmock.h"
+
+#include "http_server_plugin.h"
+#include "test/helpers.h"
+
+extern std::atomic<int> g_shutdown_pending;
+
+#ifndef _WIN32
+namespace {
+
+int connect_to(uint16_t port) {
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (sock < 0) throw std::system_error(errno, std::generic_category(), "socket() failed");
+
+  // don't hang if the server doesn't answer
+  struct timeval tv { 5, 0 };
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  struct sockaddr_in addr {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(sock, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+    int last_errno = errno;
+    close(sock);
+    throw std::system_error(last_errno, std::generic_category(), "connect() failed");
+  }
+
+  return sock;
+}
+
+// replies without a body
+class EmptyReplyHandler: public BaseRequestHandler {
+public:
+  void handle_request(HttpRequest &req) override {
+    req.send_reply(HttpStatusCode::Ok);
+  }
+};
+
+/**
+ * replies with chunks_ chunks of chunk_size_ bytes each.
+ */
+class ChunkedReplyHandler: public BaseRequestHandler {
+public:
+  struct State {
+    std::atomic<size_t> produced { 0 };
+    std::atomic<bool> producer_destroyed { false };
+  };
+
+  ChunkedReplyHandler(State &state, size_t chunk_size, size_t chunks):
+    state_(state), chunk_size_(chunk_size), chunks_(chunks) {}
+
+  void handle_request(HttpRequest &req) override {
+    // signals when the producer is gone
+    std::shared_ptr<State> guard(&state_, [](State *state) { state->producer_destroyed = true; });
+    const std::string data(chunk_size_, 'x');
+    const size_t chunks = chunks_;
+
+    req.send_reply_chunked(HttpStatusCode::Ok, "Ok", [guard, data, chunks](HttpBuffer &chunk) {
+      chunk.add(data.data(), data.size());
+      return ++guard->produced < chunks;
+    });
+  }
+private:
+  State &state_;
+  size_t chunk_size_;
+  size_t chunks_;
+};
+
+const std::string kChunkedBodyEnd { "\r\n0\r\n\r\n" };
+
+// sends a request and reads the response, which has no body
+std::string request(int sock, const std::string &path = "/") {
+  const std::string req { "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n" };
+  if (send(sock, req.data(), req.size(), 0) != static_cast<ssize_t>(req.size())) return "";
+
+  std::string response;
+  char buf[1024];
+  while (response.find("\r\n\r\n") == std::string::npos) {
+    auto received = recv(sock, buf, sizeof(buf), 0);
+    if (received <= 0) break;
+    response.append(buf, static_cast<size_t>(received));
+  }
+  return response;
+}
+
+// reads up to the end of a chunked body
+std::string read_chunked_body(int sock) {
+  std::string body;
+  char buf[16 * 1024];
+  while (body.size() < kChunkedBodyEnd.size() ||
+         body.compare(body.size() - kChunkedBodyEnd.size(), kChunkedBodyEnd.size(), kChunkedBodyEnd) != 0) {
+    auto received = recv(sock, buf, sizeof(buf), 0);
+    if (received <= 0) break;
+    body.append(buf, static_cast<size_t>(received));
+  }
+  return body;
+}
+
+template<class Pred>
+bool wait_for(Pred pred) {
+  const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!pred()) {
+    if (std::chrono::steady_clock::now() > end) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return true;
+}
+
+// true if the server closed the connection
+bool is_closed(int sock) {
+  char c;
+  return recv(sock, &c, 1, 0) == 0;
+}
+
+}
+
+class HttpServerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    g_shutdown_pending = 0;
+    srv_.add_route("^/$", std::unique_ptr<BaseRequestHandler>(new EmptyReplyHandler()));
+  }
+
+  void TearDown() override {
+    g_shutdown_pending = 1;
+    srv_.join_all();
+  }
+
+  HttpServer srv_ { "127.0.0.1", 0 };
+};
+
+TEST_F(HttpServerTest, threads) {
+  srv_.start(4, std::chrono::seconds(50), true);
+  ASSERT_NE(0, srv_.get_port());
+  EXPECT_EQ(4u, srv_.get_requests_handled().size());
+
+  for (int i = 0; i < 8; ++i) {
+    int sock = connect_to(srv_.get_port());
+    EXPECT_THAT(request(sock), ::testing::StartsWith("HTTP/1.1 200"));
+    close(sock);
+  }
+
+  const auto requests_handled = srv_.get_requests_handled();
+  EXPECT_EQ(8u, std::accumulate(requests_handled.begin(), requests_handled.end(), uint64_t { 0 }));
+}
+
+TEST_F(HttpServerTest, single_thread) {
+  srv_.start(1, std::chrono::seconds(50), true);
+  ASSERT_NE(0, srv_.get_port());
+
+  int sock = connect_to(srv_.get_port());
+  EXPECT_THAT(request(sock), ::testing::StartsWith("HTTP/1.1 200"));
+  close(sock);
+
+  EXPECT_THAT(srv_.get_requests_handled(), ::testing::ElementsAre(1u));
+}
+
+TEST_F(HttpServerTest, keepalive) {
+  srv_.start(1, std::chrono::seconds(50), true);
+
+  int sock = connect_to(srv_.get_port());
+  EXPECT_THAT(request(sock), ::testing::Not(::testing::HasSubstr("Connection: close")));
+  EXPECT_THAT(request(sock), ::testing::StartsWith("HTTP/1.1 200"));
+  close(sock);
+
+  EXPECT_THAT(srv_.get_requests_handled(), ::testing::ElementsAre(2u));
+}
+
+TEST_F(HttpServerTest, no_keepalive) {
+  srv_.start(1, std::chrono::seconds(50), false);
+
+  int sock = connect_to(srv_.get_port());
+  EXPECT_THAT(request(sock), ::testing::HasSubstr("Connection: close"));
+  EXPECT_TRUE(is_closed(sock));
+  close(sock);
+}
+
+TEST_F(HttpServerTest, idle_timeout) {
+  srv_.start(1, std::chrono::seconds(1), true);
+
+  int sock = connect_to(srv_.get_port());
+  EXPECT_THAT(request(sock), ::testing::StartsWith("HTTP/1.1 200"));
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(is_closed(sock));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(4));
+  close(sock);
+}
+
+/**
+ * the next chunk is only produced once the client read the previous ones.
+ */
+TEST_F(HttpServerTest, chunked_reply_backpressure) {
+  const size_t kChunkSize = 64 * 1024;
+  const size_t kChunks = 256;
+  ChunkedReplyHandler::State state;
+  srv_.add_route("^/chunked$", std::unique_ptr<BaseRequestHandler>(
+        new ChunkedReplyHandler(state, kChunkSize, kChunks)));
+  srv_.start(1, std::chrono::seconds(50), true);
+
+  int sock = connect_to(srv_.get_port());
+  EXPECT_THAT(request(sock, "/chunked"), ::testing::StartsWith("HTTP/1.1 200"));
+
+  // the client doesn't read, the producer stalls once the socket buffers are full
+  ASSERT_TRUE(wait_for([&state]() { return state.produced > 0; }));
+  size_t produced;
+  do {
+    produced = state.produced;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  } while (produced != state.produced);
+  EXPECT_LT(produced, kChunks);
+
+  // reading lets the reply complete
+  const std::string body = read_chunked_body(sock);
+  EXPECT_GT(body.size(), (kChunks - produced) * kChunkSize);
+  EXPECT_EQ(kChunks, state.produced);
+  EXPECT_TRUE(wait_for([&state]() -> bool { return state.producer_destroyed; }));
+
+  // the connection is still usable
+  EXPECT_THAT(request(sock), ::testing::StartsWith("HTTP/1.1 200"));
+  close(sock);
+}
+
+/**
+ * a client closing the connection in the middle of a chunked reply stops
+ * the producer.
+ */
+TEST_F(HttpServerTest, chunked_reply_client_closes) {
+  ChunkedReplyHandler::State state;
+  srv_.add_route("^/chunked$", std::unique_ptr<BaseRequestHandler>(
+        new ChunkedReplyHandler(state, 64 * 1024, std::numeric_limits<size_t>::max())));
+  srv_.start(1, std::chrono::seconds(50), true);
+
+  int sock = connect_to(srv_.get_port());
+  EXPECT_THAT(request(sock, "/chunked"), ::testing::StartsWith("HTTP/1.1 200"));
+  ASSERT_TRUE(wait_for([&state]() { return state.produced > 1; }));
+  close(sock);
+
+  EXPECT_TRUE(wait_for([&state]() -> bool { return state.producer_destroyed; }));
+  const size_t produced = state.produced;
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(produced, state.produced);
+
+  // the server keeps serving
+  sock = connect_to(srv_.get_port());
+  EXPECT_THAT(request(sock), ::testing::StartsWith("HTTP/1.1 200"));
+  close(sock);
+}
+
+#ifdef SO_REUSEPORT
+/**
+ * a socket of another process could share the port through SO_REUSEPORT
+ * and get a share of the connections.
+ */
+TEST_F(HttpServerTest, refuses_port_of_foreign_listener) {
+  int foreign = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(foreign, 0);
+  int on = 1;
+  ASSERT_EQ(0, setsockopt(foreign, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)));
+  struct sockaddr_in addr {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(0, bind(foreign, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+  ASSERT_EQ(0, listen(foreign, 1));
+  socklen_t addr_len = sizeof(addr);
+  ASSERT_EQ(0, getsockname(foreign, reinterpret_cast<struct sockaddr *>(&addr), &addr_len));
+
+  HttpServer srv("127.0.0.1", ntohs(addr.sin_port));
+  EXPECT_THROW(srv.start(4, std::chrono::seconds(50), true), std::system_error);
+
+  close(foreign);
+}
+#endif
+#endif
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  init_test_logger({"http_server"});
+  return RUN_ALL_TESTS();
+}
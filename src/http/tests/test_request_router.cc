@@ -0,0 +1,204 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "http_server_plugin.h"
+
+namespace {
+
+const std::chrono::seconds kTimeout { 5 };
+
+/**
+ * handler which counts its instances and, if a gate is set, blocks in
+ * handle_request() until the gate opens.
+ */
+class TestHandler: public BaseRequestHandler {
+public:
+  struct Gate {
+    std::mutex mtx;
+    std::condition_variable cond;
+    bool entered { false };
+    bool open { false };
+  };
+
+  TestHandler(std::atomic<int> &instances, Gate *gate = nullptr):
+    instances_(instances), gate_(gate) {
+    ++instances_;
+  }
+
+  ~TestHandler() override {
+    --instances_;
+  }
+
+  void handle_request(HttpRequest &) override {
+    if (gate_ == nullptr) return;
+
+    std::unique_lock<std::mutex> lock(gate_->mtx);
+    gate_->entered = true;
+    gate_->cond.notify_all();
+    gate_->cond.wait_for(lock, kTimeout, [this]() { return gate_->open; });
+  }
+private:
+  std::atomic<int> &instances_;
+  Gate *gate_;
+};
+
+// a request the test handlers don't look at
+HttpRequest make_request() {
+  return HttpRequest(std::unique_ptr<evhttp_request, std::function<void(evhttp_request *)>>(
+        nullptr, [](evhttp_request *) {}));
+}
+
+}
+
+class HttpRequestRouterTest : public ::testing::Test {
+protected:
+  std::unique_ptr<BaseRequestHandler> make_handler(TestHandler::Gate *gate = nullptr) {
+    return std::unique_ptr<BaseRequestHandler>(new TestHandler(instances_, gate));
+  }
+
+  HttpRequestRouter router_;
+  std::atomic<int> instances_ { 0 };
+};
+
+TEST_F(HttpRequestRouterTest, find_handler) {
+  EXPECT_EQ(nullptr, router_.find_handler("/api/"));
+
+  router_.append("^/api/", make_handler());
+  router_.append("^/static/", make_handler());
+  auto api = router_.find_handler("/api/status");
+  auto files = router_.find_handler("/static/index.html");
+  ASSERT_NE(nullptr, api);
+  ASSERT_NE(nullptr, files);
+  EXPECT_NE(api, files);
+  EXPECT_EQ(nullptr, router_.find_handler("/other"));
+
+  router_.set_default_route(make_handler());
+  auto fallback = router_.find_handler("/other");
+  ASSERT_NE(nullptr, fallback);
+  EXPECT_NE(api, fallback);
+  EXPECT_NE(files, fallback);
+
+  router_.remove("^/api/");
+  EXPECT_EQ(fallback, router_.find_handler("/api/status"));
+  EXPECT_EQ(files, router_.find_handler("/static/index.html"));
+
+  router_.clear_default_route();
+  EXPECT_EQ(nullptr, router_.find_handler("/api/status"));
+}
+
+/**
+ * a route removed while its handler runs is destroyed once the request
+ * finished.
+ */
+TEST_F(HttpRequestRouterTest, removed_handler_outlives_request) {
+  router_.append("^/api/", make_handler());
+  EXPECT_EQ(1, instances_);
+
+  auto handler = router_.find_handler("/api/status");
+  router_.remove("^/api/");
+  EXPECT_EQ(nullptr, router_.find_handler("/api/status"));
+  EXPECT_EQ(1, instances_);
+
+  handler.reset();
+  EXPECT_EQ(0, instances_);
+}
+
+/**
+ * routes are changed and other requests are dispatched while a handler
+ * runs.
+ */
+TEST_F(HttpRequestRouterTest, handler_runs_without_lock) {
+  TestHandler::Gate gate;
+  router_.append("^/slow/", make_handler(&gate));
+
+  auto slow_request = std::async(std::launch::async, [this]() {
+    auto req = make_request();
+    router_.find_handler("/slow/")->handle_request(req);
+  });
+  {
+    std::unique_lock<std::mutex> lock(gate.mtx);
+    ASSERT_TRUE(gate.cond.wait_for(lock, kTimeout, [&gate]() { return gate.entered; }));
+  }
+
+  auto updates = std::async(std::launch::async, [this]() {
+    router_.append("^/api/", make_handler());
+    router_.set_default_route(make_handler());
+    router_.remove("^/slow/");
+
+    auto req = make_request();
+    router_.find_handler("/api/")->handle_request(req);
+  });
+  EXPECT_EQ(std::future_status::ready, updates.wait_for(kTimeout));
+
+  {
+    std::lock_guard<std::mutex> lock(gate.mtx);
+    gate.open = true;
+  }
+  gate.cond.notify_all();
+  slow_request.get();
+  updates.get();
+
+  // the slow handler is gone with its request
+  EXPECT_EQ(2, instances_);
+}
+
+/**
+ * lookups see either the old or the new route table while it changes.
+ */
+TEST_F(HttpRequestRouterTest, concurrent_lookups_and_updates) {
+  router_.append("^/api/", make_handler());
+
+  std::atomic<bool> stop { false };
+  std::atomic<int> misses { 0 };
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([this, &stop, &misses]() {
+      while (!stop) {
+        if (router_.find_handler("/api/status") == nullptr) ++misses;
+        router_.find_handler("/tmp/x");
+      }
+    });
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    router_.append("^/tmp/", make_handler());
+    router_.remove("^/tmp/");
+  }
+  stop = true;
+  for (auto &reader: readers) reader.join();
+
+  EXPECT_EQ(0, misses);
+  EXPECT_EQ(1, instances_);
+}
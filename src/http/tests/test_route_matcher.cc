@@ -0,0 +1,112 @@
+/*
+  Copyright (c) 2015, 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "gmock/gmock.h"
+
+#include "http_route_matcher.h"
+
+class HttpRouteMatcherTest : public ::testing::Test {
+protected:
+  void add(const std::string &url_regex) {
+    matcher_.add(url_regex, std::make_shared<PosixRE>(url_regex));
+  }
+
+  // index of the matching route, -1 if none matches
+  int match(const std::string &uri) {
+    size_t ndx;
+    return matcher_.match(uri, ndx, &path_params_) ? static_cast<int>(ndx) : -1;
+  }
+
+  HttpRouteMatcher matcher_;
+  std::vector<std::string> path_params_;
+};
+
+TEST_F(HttpRouteMatcherTest, exact) {
+  add("^/api/v1/mock_server/globals/$");
+  add("^/api/v1/mock_server/connections/$");
+
+  EXPECT_EQ(0, match("/api/v1/mock_server/globals/"));
+  EXPECT_EQ(1, match("/api/v1/mock_server/connections/"));
+  EXPECT_EQ(-1, match("/api/v1/mock_server/globals"));
+  EXPECT_EQ(-1, match("/api/v1/mock_server/globals/x"));
+  EXPECT_EQ(-1, match("/api/v1/mock_server/"));
+}
+
+TEST_F(HttpRouteMatcherTest, prefix) {
+  add("^/static/");
+
+  EXPECT_EQ(0, match("/static/"));
+  EXPECT_EQ(0, match("/static/index.html"));
+  EXPECT_EQ(-1, match("/stat"));
+}
+
+TEST_F(HttpRouteMatcherTest, regex_after_prefix) {
+  add("^/api/v1/routes/([a-z_]+)/status$");
+  add("^/api/v1/routes/[a-z_]+$");
+
+  EXPECT_EQ(0, match("/api/v1/routes/ro_route/status"));
+  ASSERT_EQ(1u, path_params_.size());
+  EXPECT_EQ("ro_route", path_params_[0]);
+
+  EXPECT_EQ(1, match("/api/v1/routes/ro_route"));
+  EXPECT_TRUE(path_params_.empty());
+
+  EXPECT_EQ(-1, match("/api/v1/routes/42"));
+}
+
+TEST_F(HttpRouteMatcherTest, first_added_wins) {
+  add("^/api/");
+  add("^/api/v1/$");
+  add("v1");
+
+  EXPECT_EQ(0, match("/api/v1/"));
+  EXPECT_EQ(2, match("/v1/"));
+}
+
+TEST_F(HttpRouteMatcherTest, not_literal) {
+  // the last character of the prefix may be missing or repeated
+  add("^/ab?c$");
+  add("^/x\\.y$");
+  add("^/(foo|bar)$");
+  add("^/one$|^/two$");
+  add("/unanchored$");
+
+  EXPECT_EQ(0, match("/ac"));
+  EXPECT_EQ(0, match("/abc"));
+  EXPECT_EQ(1, match("/x.y"));
+  EXPECT_EQ(-1, match("/xzy"));
+  EXPECT_EQ(2, match("/bar"));
+  ASSERT_EQ(1u, path_params_.size());
+  EXPECT_EQ("bar", path_params_[0]);
+  EXPECT_EQ(3, match("/two"));
+  EXPECT_EQ(4, match("/some/unanchored"));
+  EXPECT_EQ(-1, match("/unanchored/"));
+}
+
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,219 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "gmock/gmock.h"
+
+#include "mysql/harness/filesystem.h"
+#include "static_file_cache.h"
+
+class StaticFileCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    dir_ = mysql_harness::get_tmp_dir("static_file_cache");
+  }
+
+  void TearDown() override {
+    mysql_harness::delete_dir_recursive(dir_);
+  }
+
+  std::string path(const std::string &name) const {
+    return dir_ + "/" + name;
+  }
+
+  void write_file(const std::string &name, const std::string &content) {
+    std::ofstream ofs(path(name), std::ios::binary | std::ios::trunc);
+    ofs << content;
+  }
+
+  std::shared_ptr<const StaticFileCache::Entry> get(StaticFileCache &cache, const std::string &name) {
+    struct stat st;
+    EXPECT_EQ(0, stat(path(name).c_str(), &st));
+    return cache.get(path(name), st);
+  }
+
+  std::string dir_;
+};
+
+TEST_F(StaticFileCacheTest, caches_small_files) {
+  StaticFileCache cache(1024, 16);
+  write_file("small", "content");
+  write_file("large", std::string(17, 'x'));
+
+  auto entry = get(cache, "small");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("content", entry->content);
+  EXPECT_EQ(7u, cache.size());
+  EXPECT_EQ(entry, get(cache, "small"));
+
+  EXPECT_EQ(nullptr, get(cache, "large"));
+  EXPECT_EQ(7u, cache.size());
+}
+
+TEST_F(StaticFileCacheTest, evicts_least_recently_used) {
+  StaticFileCache cache(10, 10);
+  write_file("a", "aaaa");
+  write_file("b", "bbbb");
+  write_file("c", "cccc");
+
+  auto a = get(cache, "a");
+  auto b = get(cache, "b");
+  // a is used more recently than b now
+  EXPECT_EQ(a, get(cache, "a"));
+
+  auto c = get(cache, "c");
+  EXPECT_EQ(8u, cache.size());
+  EXPECT_EQ(a, get(cache, "a"));
+  EXPECT_EQ(c, get(cache, "c"));
+
+  // b was evicted and is read again, evicting a
+  auto b_again = get(cache, "b");
+  EXPECT_NE(b, b_again);
+  EXPECT_EQ("bbbb", b_again->content);
+  EXPECT_EQ(8u, cache.size());
+  EXPECT_EQ(c, get(cache, "c"));
+  EXPECT_NE(a, get(cache, "a"));
+}
+
+#ifndef _WIN32
+TEST_F(StaticFileCacheTest, invalidates_on_mtime_nanoseconds) {
+  StaticFileCache cache(1024, 1024);
+  write_file("f", "old");
+  const struct timespec old_times[] { { 1000, 100 }, { 1000, 100 } };
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("f").c_str(), old_times, 0));
+
+  auto entry = get(cache, "f");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("old", entry->content);
+
+  // same size, same second
+  write_file("f", "new");
+  const struct timespec new_times[] { { 1000, 200 }, { 1000, 200 } };
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("f").c_str(), new_times, 0));
+
+  entry = get(cache, "f");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("new", entry->content);
+  EXPECT_EQ(3u, cache.size());
+}
+
+TEST_F(StaticFileCacheTest, invalidates_on_replaced_file) {
+  StaticFileCache cache(1024, 1024);
+  const struct timespec times[] { { 1000, 0 }, { 1000, 0 } };
+  write_file("f", "old");
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("f").c_str(), times, 0));
+
+  auto entry = get(cache, "f");
+  ASSERT_NE(nullptr, entry);
+
+  // same size and times, but another inode
+  write_file("f.tmp", "new");
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("f.tmp").c_str(), times, 0));
+  ASSERT_EQ(0, rename(path("f.tmp").c_str(), path("f").c_str()));
+
+  entry = get(cache, "f");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("new", entry->content);
+}
+
+TEST_F(StaticFileCacheTest, follows_gzip_file) {
+  StaticFileCache cache(1024, 1024);
+  const struct timespec file_times[] { { 1000, 0 }, { 1000, 0 } };
+  const struct timespec newer_times[] { { 2000, 0 }, { 2000, 0 } };
+  const struct timespec older_times[] { { 500, 0 }, { 500, 0 } };
+  write_file("f", "plain");
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("f").c_str(), file_times, 0));
+
+  auto entry = get(cache, "f");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("", entry->gzip_content);
+
+  // a .gz showing up later is picked up without the file changing
+  write_file("f.gz", "gzipped");
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("f.gz").c_str(), newer_times, 0));
+  entry = get(cache, "f");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("gzipped", entry->gzip_content);
+  EXPECT_EQ(12u, cache.size());
+
+  // changed .gz
+  write_file("f.gz", "GZIPPED");
+  const struct timespec changed_times[] { { 2000, 1 }, { 2000, 1 } };
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("f.gz").c_str(), changed_times, 0));
+  entry = get(cache, "f");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("GZIPPED", entry->gzip_content);
+
+  // a stale .gz is ignored
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("f.gz").c_str(), older_times, 0));
+  entry = get(cache, "f");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("", entry->gzip_content);
+
+  // removed .gz
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("f.gz").c_str(), newer_times, 0));
+  EXPECT_EQ("GZIPPED", get(cache, "f")->gzip_content);
+  ASSERT_EQ(0, mysql_harness::delete_file(path("f.gz")));
+  entry = get(cache, "f");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("", entry->gzip_content);
+  EXPECT_EQ(5u, cache.size());
+}
+#endif
+
+TEST_F(StaticFileCacheTest, etag_per_representation) {
+  write_file("f", "content");
+  struct stat st;
+  ASSERT_EQ(0, stat(path("f").c_str(), &st));
+
+  const std::string identity = StaticFileCache::make_etag(st, false);
+  const std::string gzip = StaticFileCache::make_etag(st, true);
+  EXPECT_NE(identity, gzip);
+  EXPECT_EQ('"', identity.front());
+  EXPECT_EQ('"', identity.back());
+  EXPECT_EQ("-gz\"", gzip.substr(gzip.size() - 4));
+}
+
+TEST(StaticFileCacheEtagTest, if_none_match) {
+  const std::string etag { "\"1-2-3.4\"" };
+
+  EXPECT_TRUE(StaticFileCache::etag_matches("\"1-2-3.4\"", etag));
+  EXPECT_TRUE(StaticFileCache::etag_matches("*", etag));
+  EXPECT_TRUE(StaticFileCache::etag_matches("W/\"1-2-3.4\"", etag));
+  EXPECT_TRUE(StaticFileCache::etag_matches("\"a\", \"1-2-3.4\"", etag));
+  EXPECT_TRUE(StaticFileCache::etag_matches("\"a\",W/\"1-2-3.4\" ,\"b\"", etag));
+  EXPECT_TRUE(StaticFileCache::etag_matches("\"1-2-3.4\"", "W/" + etag));
+
+  EXPECT_FALSE(StaticFileCache::etag_matches("", etag));
+  EXPECT_FALSE(StaticFileCache::etag_matches("\"1-2-3.4-gz\"", etag));
+  EXPECT_FALSE(StaticFileCache::etag_matches("\"a\", \"b\"", etag));
+  EXPECT_FALSE(StaticFileCache::etag_matches("1-2-3.4", etag));
+}
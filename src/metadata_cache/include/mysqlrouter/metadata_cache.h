@@ -26,6 +26,7 @@
 #define MYSQLROUTER_METADATA_CACHE_INCLUDED
 
 #include <chrono>
+#include <cstdint>
 #include <stdexcept>
 #include <exception>
 #include <vector>
@@ -111,6 +112,11 @@ public:
   unsigned int port;
   /** The X protocol port number in which the server is running */
   unsigned int xport;
+  /** Transactions the server has received but not applied yet (0 if unknown)
+   *
+   * Changes with every refresh, hence not considered by operator==().
+   */
+  uint64_t transactions_behind;
 };
 
 /** @class ManagedReplicaSet
@@ -123,14 +129,18 @@ public:
 #ifdef not_used_yet
   /** @brief The group_name as known to the GR subsystem */
   std::string group_id;
-  /** @brief The id of the group view from GR. Changes with topology changes */
-  std::string group_view_id;
 #endif
   /** @brief List of the members that belong to the group */
   std::vector<metadata_cache::ManagedInstance> members;
 
   /** @brief Whether replicaset is in single_primary_mode (from PFS) */
   bool single_primary_mode;
+
+  /** @brief The id of the group view from GR. Changes with topology changes
+   *
+   * Empty if the server doesn't report it.
+   */
+  std::string group_view_id;
 };
 
 /** @class connection_error
@@ -222,6 +232,17 @@ public:
   virtual ~ReplicasetStateNotifierInterface();
 };
 
+/** @brief Files the metadata cache keeps the topology in
+ *
+ * An empty path disables the respective file.
+ */
+struct TopologyFiles {
+  /** @brief Last known topology, kept across restarts */
+  std::string snapshot;
+  /** @brief Routing table shared by the routers running on the same host */
+  std::string shared;
+};
+
 METADATA_API class MetadataCacheAPIBase : public ReplicasetStateNotifierInterface {
  public:
 
@@ -252,13 +273,16 @@ METADATA_API class MetadataCacheAPIBase : public ReplicasetStateNotifierInterfac
    * @param read_timeout The time in seconds after which read from metadata
    *                     server should time out.
    * @param thread_stack_size memory in kilobytes allocated for thread's stack
+   * @param topology_files files the topology is kept in across restarts
+   *                       and shared with other routers
    */
   virtual void cache_init(const std::vector<mysql_harness::TCPAddress> &bootstrap_servers,
                           const std::string &user, const std::string &password,
                           std::chrono::milliseconds ttl, const mysqlrouter::SSLOptions &ssl_options,
                           const std::string &cluster_name,
                           int connect_timeout, int read_timeout,
-                          size_t thread_stack_size = mysql_harness::kDefaultStackSizeInKiloBytes) = 0;
+                          size_t thread_stack_size = mysql_harness::kDefaultStackSizeInKiloBytes,
+                          const TopologyFiles &topology_files = TopologyFiles()) = 0;
 
   /**
    * @brief Teardown the metadata cache
@@ -329,7 +353,8 @@ METADATA_API class MetadataCacheAPI: public MetadataCacheAPIBase {
                   const std::string &user, const std::string &password,
                   std::chrono::milliseconds ttl, const mysqlrouter::SSLOptions &ssl_options,
                   const std::string &cluster_name,
-                  int connect_timeout, int read_timeout, size_t thread_stack_size) override;
+                  int connect_timeout, int read_timeout, size_t thread_stack_size,
+                  const TopologyFiles &topology_files) override;
 
   void cache_stop() noexcept override;
 
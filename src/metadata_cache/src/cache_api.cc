@@ -78,6 +78,7 @@ MetadataCacheAPIBase* MetadataCacheAPI::instance() {
  * @param read_timeout The time in seconds after which read from metadata
  *                     server should timeout.
  * @param thread_stack_size memory in kilobytes allocated for thread's stack
+ * @param topology_files files the topology is kept in and shared through
  */
 void MetadataCacheAPI::cache_init(const std::vector<mysql_harness::TCPAddress> &bootstrap_servers,
                   const std::string &user,
@@ -87,12 +88,13 @@ void MetadataCacheAPI::cache_init(const std::vector<mysql_harness::TCPAddress> &
                   const std::string &cluster_name,
                   int connect_timeout,
                   int read_timeout,
-                  size_t thread_stack_size) {
+                  size_t thread_stack_size,
+                  const TopologyFiles &topology_files) {
   std::lock_guard<std::mutex> lock(g_metadata_cache_m);
 
   g_metadata_cache.reset(new MetadataCache(bootstrap_servers,
     get_instance(user, password, connect_timeout, read_timeout, 1, ttl, ssl_options), ttl,
-                 ssl_options, cluster_name, thread_stack_size));
+                 ssl_options, cluster_name, thread_stack_size, topology_files));
   g_metadata_cache->start();
 }
 
@@ -48,6 +48,11 @@ using mysqlrouter::MySQLSession;
 using mysqlrouter::strtoi_checked;
 IMPORT_LOG_FUNCTIONS()
 
+// Metadata is re-fetched at least this often, even if the GR view stays the
+// same: a view change is what all topology changes made through the Shell
+// have in common, but the metadata schema has no version to detect others.
+static const std::chrono::seconds kMetadataMaxAge{60};
+
 /**
  * Return a string representation of the input character string.
  *
@@ -150,6 +155,8 @@ void ClusterMetadata::update_replicaset_status(const std::string &name,
     metadata_cache::ManagedReplicaSet &replicaset) { // throws metadata_cache::metadata_error
   log_debug("Updating replicaset status from GR for '%s'", name.c_str());
 
+  replicaset.group_view_id.clear();
+
   // iterate over all cadidate nodes until we find the node that is part of quorum
   bool found_quorum = false;
   std::shared_ptr<MySQLSession> gr_member_connection;
@@ -213,6 +220,10 @@ void ClusterMetadata::update_replicaset_status(const std::string &name,
 
       if (found_quorum) {
         replicaset.single_primary_mode = single_primary_mode;
+        // the view as seen by the node we got the status from
+        auto self_status = member_status.find(mi.mysql_server_uuid);
+        if (self_status != member_status.end())
+          replicaset.group_view_id = self_status->second.view_id;
         break; // break out of the member iteration loop
       }
 
@@ -298,6 +309,7 @@ metadata_cache::ReplicasetStatus ClusterMetadata::check_replicaset_status(
               quorum_count++;
               break;
           }
+          member.transactions_behind = status->second.transactions_behind;
           break;
         case GR_State::Recovering:
         case GR_State::Unreachable:
@@ -309,10 +321,12 @@ metadata_cache::ReplicasetStatus ClusterMetadata::check_replicaset_status(
           if (GR_State::Recovering ==  status->second.state)
             quorum_count++;
           member.mode = ServerMode::Unavailable;
+          member.transactions_behind = 0;
           break;
       }
     } else {
       member.mode = ServerMode::Unavailable;
+      member.transactions_behind = 0;
       log_warning("Member %s:%d (%s) defined in metadata not found in actual replicaset",
                    member.host.c_str(), member.port, member.mysql_server_uuid.c_str());
     }
@@ -340,6 +354,20 @@ metadata_cache::ReplicasetStatus ClusterMetadata::check_replicaset_status(
       : ReplicasetStatus::AvailableReadOnly;  // primary not elected yet
 }
 
+bool ClusterMetadata::can_reuse_metadata(const std::string &cluster_name) const {
+  if (last_metadata_.empty() || cluster_name != last_metadata_cluster_name_)
+    return false;
+
+  if (std::chrono::steady_clock::now() - last_metadata_time_ > kMetadataMaxAge)
+    return false;
+
+  for (const auto &rs : last_metadata_) {
+    if (rs.second.group_view_id.empty())
+      return false;
+  }
+  return true;
+}
+
 // throws metadata_cache::metadata_error
 ClusterMetadata::ReplicaSetsByName ClusterMetadata::fetch_instances(
     const std::string &cluster_name) {
@@ -347,18 +375,46 @@ ClusterMetadata::ReplicaSetsByName ClusterMetadata::fetch_instances(
 
   assert(metadata_connection_->is_connected());
 
+  // The metadata only changes along with the topology of the replicasets. If
+  // the GR view of all replicasets is still the one we saw when we fetched
+  // the metadata last time, only their status has to be updated.
+  if (can_reuse_metadata(cluster_name)) {
+    ReplicaSetsByName replicasets(last_metadata_);
+    bool views_unchanged = true;
+    for (auto &&rs : replicasets) {
+      const std::string last_view_id = rs.second.group_view_id;
+      update_replicaset_status(rs.first, rs.second);  // throws metadata_cache::metadata_error
+      if (rs.second.group_view_id != last_view_id) {
+        views_unchanged = false;
+        break;
+      }
+    }
+
+    if (views_unchanged)
+      return replicasets;
+
+    log_info("Group replication view of cluster '%s' changed, fetching metadata",
+             cluster_name.c_str());
+  }
+
   // fetch existing replicasets in the cluster from the metadata server (this is the topology that was configured,
   // it will be compared later against current topology reported by (a server in) replicaset)
-  ReplicaSetsByName replicasets(fetch_instances_from_metadata_server(cluster_name)); // throws metadata_cache::metadata_error
-  if (replicasets.empty())
+  ReplicaSetsByName metadata(fetch_instances_from_metadata_server(cluster_name)); // throws metadata_cache::metadata_error
+  if (metadata.empty())
     log_warning("No replicasets defined for cluster '%s'", cluster_name.c_str());
 
   // now connect to each replicaset and query it for the list and status of its members.
   // (more precisely, foreach replicaset: search and connect to a member which is part of quorum to retrieve this data)
+  ReplicaSetsByName replicasets(metadata);
   for (auto &&rs : replicasets) {
     update_replicaset_status(rs.first, rs.second);  // throws metadata_cache::metadata_error
+    metadata[rs.first].group_view_id = rs.second.group_view_id;
   }
 
+  last_metadata_cluster_name_ = cluster_name;
+  last_metadata_ = std::move(metadata);
+  last_metadata_time_ = std::chrono::steady_clock::now();
+
   return replicasets;
 }
 
@@ -418,6 +474,7 @@ ClusterMetadata::ReplicaSetsByName ClusterMetadata::fetch_instances_from_metadat
     }
 
     metadata_cache::ManagedInstance s;
+    s.transactions_behind = 0;  // known only after update_replicaset_status()
     s.replicaset_name = get_string(row[0]);
     s.mysql_server_uuid = get_string(row[1]);
     s.role = get_string(row[2]);
@@ -123,6 +123,10 @@ class METADATA_API ClusterMetadata : public MetaData {
    */
   ReplicaSetsByName fetch_instances_from_metadata_server(const std::string &cluster_name);
 
+  // Returns whether the metadata fetched last time can be used again
+  // for the given cluster, provided the GR view has not changed since.
+  bool can_reuse_metadata(const std::string &cluster_name) const;
+
   /** Query the GR performance_schema tables for live information about a replicaset.
    *
    * update_replicaset_status() calls check_replicaset_status() for some of its processing.
@@ -180,6 +184,14 @@ class METADATA_API ClusterMetadata : public MetaData {
   // connection to metadata server (it may also be shared with GR status queries for optimisation purposes)
   std::shared_ptr<mysqlrouter::MySQLSession> metadata_connection_;
 
+  // Topology from the metadata (without GR status) as fetched by the last
+  // full refresh, with the GR view id of each replicaset at that time.
+  // Reused instead of querying the metadata again as long as the views
+  // don't change.
+  std::string last_metadata_cluster_name_;
+  ReplicaSetsByName last_metadata_;
+  std::chrono::steady_clock::time_point last_metadata_time_;
+
 #if 0 // not used so far
   // How many times we tried to reconnected (for logging purposes)
   size_t reconnect_tries_;
@@ -199,6 +211,7 @@ class METADATA_API ClusterMetadata : public MetaData {
   FRIEND_TEST(MetadataTest, UpdateReplicasetStatus_Status_FailQueryOnNode1);
   FRIEND_TEST(MetadataTest, UpdateReplicasetStatus_Status_FailQueryOnAllNodes);
   FRIEND_TEST(MetadataTest, UpdateReplicasetStatus_SimpleSunnyDayScenario);
+  FRIEND_TEST(MetadataTest, UpdateReplicasetStatus_MemberStats);
   FRIEND_TEST(MetadataTest, CheckReplicasetStatus_Recovering);
   FRIEND_TEST(MetadataTest, CheckReplicasetStatus_ErrorAndOther);
   FRIEND_TEST(MetadataTest, CheckReplicasetStatus_Cornercase2of5Alive);
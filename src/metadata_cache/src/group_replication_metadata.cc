@@ -83,6 +83,54 @@ static std::string find_group_replication_primary_member(MySQLSession& connectio
   return primary_member;
 }
 
+// fills GroupReplicationMember::transactions_behind and view_id, failures are not fatal
+static void fetch_group_replication_member_stats(MySQLSession& connection,
+    std::map<std::string, GroupReplicationMember> &members) {
+
+  auto result_processor = [&members](const MySQLSession::Row& row) -> bool {
+
+    // +--------------------------------------+--------------------------------------------+---------------------+
+    // | member_id                            | COUNT_TRANSACTIONS_REMOTE_IN_APPLIER_QUEUE | view_id             |
+    // +--------------------------------------+--------------------------------------------+---------------------+
+    // | 3acfe4ca-861d-11e6-9e56-08002741aeb6 |                                          0 | 15405212307512370:3 |
+    // | 4c08b4a2-861d-11e6-a256-08002741aeb6 |                                        217 | 15405212307512370:3 |
+    // +--------------------------------------+--------------------------------------------+---------------------+
+
+    if (row.size() != 3) {
+      throw metadata_cache::metadata_error("Unexpected number of fields in resultset from group_replication stats query. "
+                                           "Expected = 3, got = " + std::to_string(row.size()));
+    }
+
+    if (!row[0])
+      return true;  // member without stats (yet), next!
+
+    auto member = members.find(row[0]);
+    if (member != members.end()) {
+      if (row[1])
+        member->second.transactions_behind = std::strtoull(row[1], nullptr, 10);
+      if (row[2])
+        member->second.view_id = row[2];
+    }
+
+    return true;  // false = I don't want more rows
+  };
+
+  // COUNT_TRANSACTIONS_REMOTE_IN_APPLIER_QUEUE exists since 8.0.2, with
+  // older servers we don't know about the lag and treat all members alike
+  // (and always re-fetch the metadata as the view is unknown, too)
+  try {
+    connection.query(
+      "SELECT member_id, COUNT_TRANSACTIONS_REMOTE_IN_APPLIER_QUEUE, view_id"
+      " FROM performance_schema.replication_group_member_stats"
+      " WHERE channel_name = 'group_replication_applier'",
+      result_processor);
+  } catch (const MySQLSession::Error& e) {
+    log_debug("Unable to fetch group_replication member stats: %s", e.what());
+  } catch (const metadata_cache::metadata_error& e) {
+    log_debug("Unable to fetch group_replication member stats: %s", e.what());
+  }
+}
+
 // throws metadata_cache::metadata_error
 std::map<std::string, GroupReplicationMember> fetch_group_replication_members(
     MySQLSession& connection, bool &single_master) {
@@ -157,6 +205,8 @@ std::map<std::string, GroupReplicationMember> fetch_group_replication_members(
     else
       member.role = GroupReplicationMember::Role::Secondary;
 
+    member.transactions_behind = 0;  // filled by fetch_group_replication_member_stats()
+
     // add GroupReplicationMember to map that will be returned
     members[member_id] = member;
 
@@ -184,5 +234,7 @@ std::map<std::string, GroupReplicationMember> fetch_group_replication_members(
     throw;      // in production, rethrow anyway just in case
   }
 
+  fetch_group_replication_member_stats(connection, members);
+
   return members;
 }
@@ -25,6 +25,7 @@
 #ifndef GROUP_REPLICATION_METADATA_INCLUDED
 #define GROUP_REPLICATION_METADATA_INCLUDED
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
@@ -49,11 +50,19 @@ struct GroupReplicationMember {
   uint16_t port;
   State state;
   Role role;
+  // transactions received but not yet applied by the member, 0 if unknown
+  uint64_t transactions_behind;
+  // id of the group view the member is in, empty if unknown
+  std::string view_id;
 };
 
 /** Fetches the list of group replication members known to the instance of the
  * given connection.
  *
+ * Also fetches how far behind each member is applying transactions and the
+ * group view it is in. Servers which don't report it (before 8.0.2) leave
+ * transactions_behind at 0 and view_id empty.
+ *
  * throws metadata_cache::metadata_error
  */
 std::map<std::string, GroupReplicationMember>
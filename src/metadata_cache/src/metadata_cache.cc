@@ -98,6 +98,67 @@
  *
  * `MetadataCache::refresh()` is the "workhorse" of refresh mechanism.
  *
+ * The first refresh is done by the refresh thread as well, so starting MDC
+ * never waits for the metadata servers. Until it finishes, the routing table
+ * is taken from the topology snapshot (see below); lookups made while there
+ * is no routing table at all wait for the first refresh to finish.
+ *
+ *
+ *
+ *
+ *
+ * ## Topology snapshot
+ * Each time the routing table changes, it is written to a snapshot file in
+ * the data folder of the router (next to the keyring). The file is written
+ * under a temporary name and then renamed, hence it always contains a
+ * complete routing table.
+ *
+ * On startup, the snapshot is loaded (if it belongs to the configured
+ * cluster) and used as routing table until the first refresh that reaches
+ * a metadata server replaces it. As the point of the snapshot is to route
+ * while the metadata servers are unreachable, failing to reach any of them
+ * does not clear a routing table that came from the snapshot; it is only
+ * cleared "as a precaution" (see Stage 1) once a metadata server has been
+ * reached since startup.
+ *
+ *
+ *
+ *
+ *
+ * ## Shared topology
+ * If `shared_topology_file` is configured, the routers of a host which set
+ * it to the same file share one routing table through that (memory mapped)
+ * file, so that only one of them queries the metadata servers. Whichever
+ * router gets the lock on the file first becomes the publisher: it runs the
+ * refresh as described below and writes the routing table to the file after
+ * each refresh. The others (subscribers) don't refresh; instead they check
+ * the version of the publication every 100ms and take the routing table from
+ * the file when it changed, notifying their listeners as if they had
+ * refreshed themselves. A subscriber in emergency mode asks the publisher to
+ * refresh right away through a flag in the file.
+ *
+ * If the publisher stops or dies, its lock goes away and the next subscriber
+ * to check the lock becomes the publisher. A subscriber which doesn't find a
+ * routing table of its cluster in the file within 10 seconds (the publisher
+ * is stuck or serves another cluster) refreshes the metadata cache itself
+ * until one gets published, so that lookups don't wait for it forever.
+ *
+ * The file is created with mode 0600: the routers sharing it must run as the
+ * same user. See `SharedTopology` for the layout of the file.
+ *
+ *
+ *
+ *
+ * ## Notifying listeners
+ * When the routing table changes, the listeners registered with
+ * `MetadataCache::add_listener()` (the routing plugin's destinations) are
+ * notified by the `NotificationDispatcher` on a thread of its own. The
+ * refresh thread only hands it a copy of the routing table and carries on,
+ * so a listener that takes long (e.g. closing many client connections)
+ * doesn't delay the next refresh. Changes posted while the listeners are
+ * still busy with a previous one are coalesced: the listeners get the latest
+ * routing table only.
+ *
  *
  *
  *
@@ -109,8 +170,15 @@
  * - emergency mode (replicaset is flagged to have at least one node unreachable).
  *
  * It's implemented by running a sleep loop between refreshes. The loop sleeps 1
- * second at a time, until `<TTL>` iterations have gone or emergency mode is
- * enabled.
+ * second at a time, until the refresh interval has passed. The interval is
+ * decided by `RefreshScheduler`:
+ * - it is `<TTL>` with a random jitter of up to 10%, so that routers started
+ *   together (e.g. by one deployment) don't query the metadata servers in
+ *   lockstep
+ * - after two or more refreshes in a row failed to reach any metadata
+ *   server, it doubles with each failure, up to 10 seconds (or `<TTL>` if
+ *   longer)
+ * - once emergency mode is enabled, it is cut to 1 second (see below).
  *
  *
  *
@@ -119,7 +187,9 @@
  * connect to a node that's declared by MDC as routable (node that is labelled
  * as writable or readonly). In such situation, it will flag the replicaset as
  * missing a node, and MDC will react by increasing refresh rate to 1/s (if it
- * is currently lower).
+ * is currently lower). To not add to the load of a metadata server that is
+ * struggling already, the emergency interval is at least 10 times as long as
+ * the last refresh took, and the backoff after failed refreshes still applies.
  *
  * This emergency mode will stay enabled, until routing table resulting from
  * most recent MD and GR query is different from the one before it _AND_ the
@@ -202,6 +272,13 @@
  * @note
  * ATTOW, if this query fails, whole refresh process fails [03].
  *
+ * @note
+ * The metadata changes together with the GR topology, so this stage is
+ * skipped if the GR view id (reported in Stage 2.2) of every replicaset is
+ * still the one seen when the metadata was fetched last time. The metadata
+ * fetched then is reused, but for no longer than a minute. Servers which
+ * don't report the view id (before 8.0.2) get this query on every refresh.
+ *
  *
  *
  *
@@ -268,6 +345,14 @@
  *
  * If either SQL query fails to execute, Stage 2 iterates to next GR node.
  *
+ * A third query fetches the replication lag and the GR view id of the nodes.
+ * It is optional: older servers fail it, and Stage 2 carries on without.
+ *
+ * @note
+ * Unlike Stage 1.2, this stage runs on every refresh: node states (such as
+ * RECOVERING becoming ONLINE) and the replication lag change without a new
+ * GR view.
+ *
  * @note
  * ATTOW, 1st query is always ran, regardless of whether we're in MM mode or
  * not. As all nodes are PRIMARY in MM setups, we could optimise this query away
@@ -478,12 +563,14 @@
 #include "common.h"
 #include "metadata_cache.h"
 #include "mysql/harness/logging/logging.h"
+#include "topology_snapshot.h"
 
 #include <cassert>
 #include <vector>
 #include <memory>
 #include <cmath>  // fabs()
 
+using mysql_harness::logging::LogLevel;
 IMPORT_LOG_FUNCTIONS()
 
 MetadataCache::MetadataCache(
@@ -492,7 +579,10 @@ MetadataCache::MetadataCache(
   std::chrono::milliseconds ttl,
   const mysqlrouter::SSLOptions &ssl_options,
   const std::string &cluster,
-  size_t thread_stack_size) : refresh_thread_(thread_stack_size) {
+  size_t thread_stack_size,
+  const metadata_cache::TopologyFiles &topology_files)
+    : refresh_thread_(thread_stack_size), notification_dispatcher_(thread_stack_size),
+      refresh_scheduler_(ttl) {
   std::string host;
   for (auto s : bootstrap_servers) {
     metadata_cache::ManagedInstance bootstrap_server_instance;
@@ -506,7 +596,17 @@ MetadataCache::MetadataCache(
   terminate_ = false;
   meta_data_ = cluster_metadata;
   ssl_options_ = ssl_options;
-  refresh();
+  topology_snapshot_file_ = topology_files.snapshot;
+  load_topology_snapshot();
+
+  if (!topology_files.shared.empty()) {
+    try {
+      shared_topology_.reset(new SharedTopology(topology_files.shared));
+    } catch (const std::runtime_error &exc) {
+      // not fatal, this router just queries the metadata servers itself
+      log_warning("Not sharing the routing table with other routers: %s", exc.what());
+    }
+  }
 }
 
 void* MetadataCache::run_thread(void* context) {
@@ -515,31 +615,119 @@ void* MetadataCache::run_thread(void* context) {
   return nullptr;
 }
 
+// how often the refresh counters are logged
+static constexpr std::chrono::minutes kRefreshStatsReportInterval { 10 };
+
+/**
+ * log the refresh counters, shows how much the metadata servers are queried.
+ *
+ * @param reported refreshes at the last report
+ * @returns refreshes now, nothing is logged if it didn't change
+ */
+static uint64_t log_refresh_stats(const MetadataCache &cache, uint64_t reported) {
+  const auto stats = cache.get_refresh_stats();
+
+  if (stats.refreshes != reported) {
+    log_info("Metadata cache: %llu refreshes (%llu failed, %llu emergency refreshes skipped), "
+             "refresh time %lld us last, %lld us max, %lld us total",
+             static_cast<unsigned long long>(stats.refreshes),
+             static_cast<unsigned long long>(stats.failed),
+             static_cast<unsigned long long>(stats.skipped),
+             static_cast<long long>(stats.last_time.count()),
+             static_cast<long long>(stats.max_time.count()),
+             static_cast<long long>(stats.total_time.count()));
+  }
+
+  return stats.refreshes;
+}
+
 void MetadataCache::refresh_thread() {
   mysql_harness::rename_thread("MDC Refresh");
 
   // this will be only useful if the TTL is set to some value that is more than 1 second
   const std::chrono::milliseconds kTerminateOrForcedRefreshCheckInterval = std::chrono::seconds(1);
+  // how often a router not publishing the shared topology checks it for changes
+  const std::chrono::milliseconds kSharedTopologyPollInterval(100);
+
+  auto next_report = std::chrono::steady_clock::now() + kRefreshStatsReportInterval;
+  uint64_t reported_refreshes = 0;
+
+  // when the routing table was last taken from the shared topology file
+  auto last_followed = std::chrono::steady_clock::now();
+  bool refreshing_without_publisher = false;
 
   while (!terminate_) {
+    if (shared_topology_) {
+      const bool was_publisher = shared_topology_->is_publisher();
+      if (!shared_topology_->try_become_publisher()) {
+        if (follow_shared_topology()) {
+          last_followed = std::chrono::steady_clock::now();
+          refreshing_without_publisher = false;
+        }
+        {
+          // let the publisher refresh at the emergency mode rate
+          std::lock_guard<std::mutex> lock(replicasets_with_unreachable_nodes_mtx_);
+          if (!replicasets_with_unreachable_nodes_.empty())
+            shared_topology_->request_refresh();
+        }
+        // the publisher hasn't published a routing table of our cluster in
+        // time: refresh like a router that doesn't share it, lookups must
+        // not wait for the publisher forever
+        if (shared_topology_followed_ ||
+            std::chrono::steady_clock::now() - last_followed < shared_topology_max_wait_) {
+          std::this_thread::sleep_for(kSharedTopologyPollInterval);
+          continue;
+        }
+        if (!refreshing_without_publisher)
+          log_warning("No routing table of cluster '%s' in the shared topology file, "
+                      "refreshing the metadata cache until there is one",
+                      cluster_name_.c_str());
+        refreshing_without_publisher = true;
+      } else if (!was_publisher) {
+        log_info("Refreshing the metadata cache for the routers sharing the routing table");
+      }
+    }
+
+    const auto refresh_start = std::chrono::steady_clock::now();
     refresh();
+    const auto refreshed = std::chrono::steady_clock::now();
+    refresh_scheduler_.record_refresh(refreshed - refresh_start, md_servers_reachable_);
+    publish_shared_topology();
 
-    auto ttl_left = ttl_;
-    // wait for up to TTL until next refresh, unless some replicaset loses an
+    if (refreshed >= next_report) {
+      next_report += kRefreshStatsReportInterval;
+      reported_refreshes = log_refresh_stats(*this, reported_refreshes);
+    }
+
+    // wait for about TTL until next refresh, unless some replicaset loses an
     // online (primary or secondary) server - in that case, "emergency mode" is
-    // enabled and we refresh every 1s until "emergency mode" is called off.
-    while (ttl_left > std::chrono::milliseconds(0)) {
+    // enabled and we refresh about every 1s until "emergency mode" is called
+    // off. See RefreshScheduler for the exact intervals.
+    auto interval = refresh_scheduler_.next_interval(/*emergency=*/false);
+    bool emergency = false;
+    while (true) {
       if (terminate_) return;
 
-      auto sleep_for = std::min(ttl_left, kTerminateOrForcedRefreshCheckInterval);
-      std::this_thread::sleep_for(sleep_for);
-      ttl_left -= sleep_for;
+      const auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - refreshed);
+      if (waited >= interval)
+        break;
+      std::this_thread::sleep_for(std::min(interval - waited, kTerminateOrForcedRefreshCheckInterval));
 
-      {
-        std::lock_guard<std::mutex> lock(replicasets_with_unreachable_nodes_mtx_);
+      if (!emergency) {
+        {
+          std::lock_guard<std::mutex> lock(replicasets_with_unreachable_nodes_mtx_);
+          emergency = !replicasets_with_unreachable_nodes_.empty();
+        }
 
-        if (!replicasets_with_unreachable_nodes_.empty())
-          break; // we're in "emergency mode", don't wait until TTL expires
+        // another router sharing the routing table is in "emergency mode"
+        if (!emergency && shared_topology_ && shared_topology_->is_publisher() &&
+            shared_topology_->take_refresh_request())
+          emergency = true;
+
+        // we're in "emergency mode", don't wait until TTL expires
+        if (emergency)
+          interval = std::min(interval, refresh_scheduler_.next_interval(/*emergency=*/true));
       }
     }
   }
@@ -550,6 +738,11 @@ void MetadataCache::refresh_thread() {
  * cache.
  */
 void MetadataCache::start() {
+  {
+    std::lock_guard<std::mutex> lock(cache_refreshing_mutex_);
+    refresh_thread_started_ = true;
+  }
+  notification_dispatcher_.start();
   refresh_thread_.run(&run_thread, this);
 }
 
@@ -557,8 +750,17 @@ void MetadataCache::start() {
  * Stop the refresh thread.
  */
 void MetadataCache::stop() noexcept {
-  terminate_ = true;
+  {
+    std::lock_guard<std::mutex> lock(cache_refreshing_mutex_);
+    terminate_ = true;
+  }
+  topology_known_cond_.notify_all();
   refresh_thread_.join();
+  notification_dispatcher_.stop();
+
+  log_refresh_stats(*this, 0);
+  // lets another router take over publishing the routing table
+  shared_topology_.reset();
 }
 
 /**
@@ -568,7 +770,13 @@ void MetadataCache::stop() noexcept {
  */
 std::vector<metadata_cache::ManagedInstance> MetadataCache::replicaset_lookup(
   const std::string &replicaset_name) {
-  std::lock_guard<std::mutex> lock(cache_refreshing_mutex_);
+  std::unique_lock<std::mutex> lock(cache_refreshing_mutex_);
+  if (refresh_thread_started_) {
+    topology_known_cond_.wait(lock, [this] {
+      return topology_known_ || terminate_;
+    });
+  }
+
   auto replicaset = replicaset_data_.find(replicaset_name);
 
   if (replicaset == replicaset_data_.end()) {
@@ -624,27 +832,35 @@ static const char *str_mode(metadata_cache::ServerMode mode) {
  */
 void MetadataCache::refresh() {
   // fetch metadata
+  bool fetched = false;
   for (auto &metadata_server: metadata_servers_) {
     if (!meta_data_->connect(metadata_server)) {
       log_error("Failed to connect to metadata server %s", metadata_server.mysql_server_uuid.c_str());
       continue;
      }
-     bool result = fetch_metadata_from_connected_instance();
-     if (result) return; // successfully updated metadata
+     fetched = fetch_metadata_from_connected_instance();
+     if (fetched) break; // successfully updated metadata
   }
 
-  // we failed to fetch metadata from any of the metadata servers
-  log_error("Failed connecting with any of the metadata servers");
-  // clearing metadata
-  {
+  md_servers_reachable_ = fetched;
+  if (!fetched) {
+    // we failed to fetch metadata from any of the metadata servers
+    log_error("Failed connecting with any of the metadata servers");
+    // clearing metadata, unless it is the snapshot we started with
     bool clearing;
+    bool from_snapshot;
     {
       std::lock_guard<std::mutex> lock(cache_refreshing_mutex_);
-      clearing = !replicaset_data_.empty();
+      from_snapshot = topology_from_snapshot_;
+      clearing = !from_snapshot && !replicaset_data_.empty();
       if (clearing)
         replicaset_data_.clear();
+      topology_known_ = true;
     }
-    if (clearing) {
+    topology_known_cond_.notify_all();
+    if (from_snapshot) {
+      log_info("... keeping routing table from topology snapshot until a metadata server is reachable");
+    } else if (clearing) {
       log_info("... cleared current routing table as a precaution");
       on_instances_changed(/*md_servers_reachable=*/false);
     }
@@ -662,52 +878,21 @@ bool MetadataCache::fetch_metadata_from_connected_instance() {
       // Ensure that the refresh does not result in an inconsistency during the
       // lookup.
       std::lock_guard<std::mutex> lock(cache_refreshing_mutex_);
-      if (!compare_instance_lists(replicaset_data_, replicaset_data_temp)) {
-        replicaset_data_ = replicaset_data_temp;
-        changed = true;
-      }
+      changed = !compare_instance_lists(replicaset_data_, replicaset_data_temp);
+      // even if the topology is the same, the replication lag of the members
+      // may have changed
+      replicaset_data_ = std::move(replicaset_data_temp);
+      topology_from_snapshot_ = false;
+      topology_known_ = true;
     }
+    topology_known_cond_.notify_all();
 
     // we want to trigger those actions not only if the metadata has really changed
     // but also when something external (like unsuccessful client connection)
     // triggered the refresh so that we werified if this wasn't false alarm
     // and turn it off if it was
-    if (changed) {
-      log_info("Potential changes detected in cluster '%s' after metadata refresh",
-          cluster_name_.c_str());
-      // dump some informational/debugging information about the replicasets
-      if (replicaset_data_.empty())
-        log_error("Metadata for cluster '%s' is empty!", cluster_name_.c_str());
-      else {
-        log_info("Metadata for cluster '%s' has %i replicasets:",
-          cluster_name_.c_str(), (int)replicaset_data_.size());
-        for (auto &rs : replicaset_data_) {
-          log_info("'%s' (%i members, %s)", rs.first.c_str(),
-                    (int)rs.second.members.size(),
-                    rs.second.single_primary_mode ? "single-master" : "multi-master");
-          for (auto &mi : rs.second.members) {
-            log_info("    %s:%i / %i - role=%s mode=%s", mi.host.c_str(),
-                mi.port, mi.xport, mi.role.c_str(), str_mode(mi.mode));
-
-            if (mi.mode == metadata_cache::ServerMode::ReadWrite) {
-              // If we were running with a primary or secondary node gone
-              // missing before (in so-called "emergency mode"), we trust that
-              // the update fixed the problem. This is wrong behavior that
-              // should be fixed, see notes [05] and [06] in Notes section of
-              // Metadata Cache module in Doxygen.
-              std::lock_guard<std::mutex> lock(replicasets_with_unreachable_nodes_mtx_);
-              auto rs_with_unreachable_node = replicasets_with_unreachable_nodes_.find(rs.first);
-              if (rs_with_unreachable_node != replicasets_with_unreachable_nodes_.end()) {
-                // disable "emergency mode" for this replicaset
-                replicasets_with_unreachable_nodes_.erase(rs_with_unreachable_node);
-              }
-            }
-          }
-        }
-      }
-
-      on_instances_changed(/*md_servers_reachable=*/true);
-    }
+    if (changed)
+      on_topology_changed();
 
     /* Not sure about this, the metadata server could be stored elsewhere
 
@@ -730,17 +915,148 @@ bool MetadataCache::fetch_metadata_from_connected_instance() {
   return true;
 }
 
-void MetadataCache::on_instances_changed(const bool md_servers_reachable) {
-  std::lock_guard<std::mutex> lock(replicaset_instances_change_callbacks_mtx_);
+void MetadataCache::on_topology_changed() {
+  log_info("Potential changes detected in cluster '%s' after metadata refresh",
+      cluster_name_.c_str());
+  // dump some informational/debugging information about the replicasets
+  if (replicaset_data_.empty())
+    log_error("Metadata for cluster '%s' is empty!", cluster_name_.c_str());
+  else {
+    // a line per member, only formatted if info is logged
+    const bool log_members = log_level_is_handled(LogLevel::kInfo);
+    if (log_members)
+      log_info("Metadata for cluster '%s' has %i replicasets:",
+        cluster_name_.c_str(), (int)replicaset_data_.size());
+    for (auto &rs : replicaset_data_) {
+      if (log_members)
+        log_info("'%s' (%i members, %s)", rs.first.c_str(),
+                  (int)rs.second.members.size(),
+                  rs.second.single_primary_mode ? "single-master" : "multi-master");
+      for (auto &mi : rs.second.members) {
+        if (log_members)
+          log_info("    %s:%i / %i - role=%s mode=%s", mi.host.c_str(),
+              mi.port, mi.xport, mi.role.c_str(), str_mode(mi.mode));
 
-  for (auto& replicaset_clb: listeners_) {
-    const std::string replicaset_name = replicaset_clb.first;
-    auto res = replicaset_lookup(replicaset_name);
-
-    for(auto each : listeners_[replicaset_name]) {
-      each->notify(res, md_servers_reachable);
+        if (mi.mode == metadata_cache::ServerMode::ReadWrite) {
+          // If we were running with a primary or secondary node gone
+          // missing before (in so-called "emergency mode"), we trust that
+          // the update fixed the problem. This is wrong behavior that
+          // should be fixed, see notes [05] and [06] in Notes section of
+          // Metadata Cache module in Doxygen.
+          std::lock_guard<std::mutex> lock(replicasets_with_unreachable_nodes_mtx_);
+          auto rs_with_unreachable_node = replicasets_with_unreachable_nodes_.find(rs.first);
+          if (rs_with_unreachable_node != replicasets_with_unreachable_nodes_.end()) {
+            // disable "emergency mode" for this replicaset
+            replicasets_with_unreachable_nodes_.erase(rs_with_unreachable_node);
+          }
+        }
+      }
     }
   }
+
+  on_instances_changed(/*md_servers_reachable=*/true);
+  store_topology_snapshot();
+}
+
+bool MetadataCache::follow_shared_topology() {
+  if (shared_topology_->version() == shared_topology_version_)
+    return shared_topology_followed_;
+
+  SharedTopology::Publication publication;
+  if (!shared_topology_->read(publication))
+    return shared_topology_followed_;
+  shared_topology_version_ = publication.version;
+
+  if (publication.cluster_name != cluster_name_) {
+    log_warning("Ignoring routing table of cluster '%s' in shared topology file, "
+                "expected cluster '%s'",
+                publication.cluster_name.c_str(), cluster_name_.c_str());
+    shared_topology_followed_ = false;
+    return false;
+  }
+  shared_topology_followed_ = true;
+
+  bool changed;
+  {
+    std::lock_guard<std::mutex> lock(cache_refreshing_mutex_);
+    changed = !compare_instance_lists(replicaset_data_, publication.replicasets);
+    replicaset_data_ = std::move(publication.replicasets);
+    topology_from_snapshot_ = false;
+    topology_known_ = true;
+  }
+  topology_known_cond_.notify_all();
+
+  if (!changed)
+    return true;
+
+  if (!publication.md_servers_reachable && replicaset_data_.empty()) {
+    // the publisher cleared its routing table as a precaution
+    on_instances_changed(/*md_servers_reachable=*/false);
+  } else {
+    on_topology_changed();
+  }
+  return true;
+}
+
+void MetadataCache::publish_shared_topology() {
+  if (!shared_topology_ || !shared_topology_->is_publisher())
+    return;
+
+  // only the refresh thread modifies replicaset_data_, no need to lock
+  const bool published = shared_topology_->publish(cluster_name_, replicaset_data_,
+                                                   md_servers_reachable_);
+  if (!published && shared_topology_published_) {
+    log_warning("Routing table of cluster '%s' is too large for the shared topology file, "
+                "the other routers keep the previous one",
+                cluster_name_.c_str());
+  }
+  shared_topology_published_ = published;
+}
+
+void MetadataCache::load_topology_snapshot() {
+  if (topology_snapshot_file_.empty())
+    return;
+
+  MetaData::ReplicaSetsByName replicaset_data;
+  try {
+    replicaset_data = ::load_topology_snapshot(topology_snapshot_file_, cluster_name_);
+  } catch (const std::runtime_error &exc) {
+    // there is no snapshot before the first successful refresh
+    log_info("Not using topology snapshot: %s", exc.what());
+    return;
+  }
+
+  log_info("Loaded topology of cluster '%s' from '%s' (%i replicasets), "
+           "using it until a metadata server is reachable",
+           cluster_name_.c_str(), topology_snapshot_file_.c_str(),
+           (int)replicaset_data.size());
+
+  std::lock_guard<std::mutex> lock(cache_refreshing_mutex_);
+  replicaset_data_ = std::move(replicaset_data);
+  topology_from_snapshot_ = true;
+  topology_known_ = true;
+}
+
+void MetadataCache::store_topology_snapshot() {
+  if (topology_snapshot_file_.empty())
+    return;
+
+  // only the refresh thread modifies replicaset_data_, no need to lock
+  try {
+    save_topology_snapshot(topology_snapshot_file_, cluster_name_, replicaset_data_);
+  } catch (const std::runtime_error &exc) {
+    log_warning("Failed storing topology snapshot: %s", exc.what());
+  }
+}
+
+void MetadataCache::on_instances_changed(const bool md_servers_reachable) {
+  // the listeners get a snapshot, the refresh thread doesn't wait for them
+  NotificationDispatcher::ReplicaSets replicasets;
+  {
+    std::lock_guard<std::mutex> lock(cache_refreshing_mutex_);
+    replicasets = std::make_shared<const MetaData::ReplicaSetsByName>(replicaset_data_);
+  }
+  notification_dispatcher_.post(std::move(replicasets), md_servers_reachable);
 }
 
 void MetadataCache::mark_instance_reachability(const std::string &instance_id,
@@ -811,11 +1127,9 @@ bool MetadataCache::wait_primary_failover(const std::string &replicaset_name,
 }
 
 void MetadataCache::add_listener(const std::string& replicaset_name, metadata_cache::ReplicasetStateListenerInterface* listener) {
-  std::lock_guard<std::mutex> lock(replicaset_instances_change_callbacks_mtx_);
-  listeners_[replicaset_name].insert(listener);
+  notification_dispatcher_.add_listener(replicaset_name, listener);
 }
 
 void MetadataCache::remove_listener(const std::string& replicaset_name, metadata_cache::ReplicasetStateListenerInterface* listener) {
-  std::lock_guard<std::mutex> lock(replicaset_instances_change_callbacks_mtx_);
-  listeners_[replicaset_name].erase(listener);
+  notification_dispatcher_.remove_listener(replicaset_name, listener);
 }
@@ -28,9 +28,13 @@
 #include "mysqlrouter/metadata_cache.h"
 #include "metadata.h"
 #include "mysql_router_thread.h"
+#include "notification_dispatcher.h"
+#include "refresh_scheduler.h"
+#include "shared_topology.h"
 
 #include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <ctime>
 #include <memory>
 #include <mutex>
@@ -62,16 +66,26 @@ public:
    * @param ssl_options SSL related options for connection
    * @param cluster_name The name of the desired cluster in the metadata server
    * @param thread_stack_size The maximum memory allocated for thread's stack
+   * @param topology_files The files the topology is kept in across restarts
+   *        and shared with the other routers of the host, empty paths to not
+   *        use them
+   *
+   * No metadata server is contacted here: the cache starts off with the
+   * topology from the snapshot file (if any), the first refresh is done by
+   * the refresh thread.
    */
   MetadataCache(const std::vector<mysql_harness::TCPAddress> &bootstrap_servers,
                 std::shared_ptr<MetaData> cluster_metadata,
                 std::chrono::milliseconds ttl, const mysqlrouter::SSLOptions &ssl_options,
                 const std::string &cluster_name,
-                size_t thread_stack_size = mysql_harness::kDefaultStackSizeInKiloBytes);
+                size_t thread_stack_size = mysql_harness::kDefaultStackSizeInKiloBytes,
+                const metadata_cache::TopologyFiles &topology_files =
+                    metadata_cache::TopologyFiles());
 
   /** @brief Starts the Metadata Cache
    *
-   * Starts the Metadata Cache and launch thread.
+   * Starts the Metadata Cache and launch thread, which does the first
+   * refresh right away.
    */
   void start();
 
@@ -85,6 +99,9 @@ public:
    *
    * Returns list of managed servers in a replicaset.
    *
+   * If the topology is not known yet (no snapshot was loaded and the first
+   * refresh is still in progress), waits for the first refresh to finish.
+   *
    * @param replicaset_name The ID of the replicaset being looked up
    * @return std::vector containing ManagedInstance objects
    */
@@ -116,6 +133,11 @@ public:
    */
   bool wait_primary_failover(const std::string &replicaset_name, int timeout);
 
+  /** @brief Returns the refresh counters */
+  RefreshScheduler::Stats get_refresh_stats() const {
+    return refresh_scheduler_.get_stats();
+  }
+
   /** @brief refresh replicaset information */
   void refresh_thread();
 
@@ -153,6 +175,31 @@ private:
    */
   bool fetch_metadata_from_connected_instance();
 
+  /** @brief Reports a topology that differs from the previous one
+   *
+   * Logs the new topology, calls off the emergency mode where a primary is
+   * known again and notifies the listeners.
+   */
+  void on_topology_changed();
+
+  /** @brief Takes over the routing table published in the shared topology
+   * file, if it has changed since the last call
+   *
+   * @return true if the routing table is the one of the shared topology
+   *         file, false if no publication for this cluster was read yet
+   */
+  bool follow_shared_topology();
+
+  /** @brief Publishes the routing table to the shared topology file, if
+   * this is the publisher */
+  void publish_shared_topology();
+
+  /** @brief Loads the topology from the snapshot file, if there is one */
+  void load_topology_snapshot();
+
+  /** @brief Writes the current topology to the snapshot file, if there is one */
+  void store_topology_snapshot();
+
   // Called each time the metadata has changed and we need to notify
   // the subscribed observers
   void on_instances_changed(const bool md_servers_reachable);
@@ -186,6 +233,43 @@ private:
   // with the changes in the metadata due to a cache refresh.
   std::mutex cache_refreshing_mutex_;
 
+  // File the last known topology is kept in across restarts, empty if none.
+  std::string topology_snapshot_file_;
+
+  // Whether replicaset_data_ came from the snapshot file and no metadata
+  // server has been reached since. Protected by cache_refreshing_mutex_.
+  bool topology_from_snapshot_ = false;
+
+  // Whether replicaset_data_ is meaningful, i.e. a snapshot was loaded or a
+  // refresh has finished. Protected by cache_refreshing_mutex_.
+  bool topology_known_ = false;
+
+  // Routing table shared with the other routers of the host, null if not
+  // shared. Only used by the refresh thread.
+  std::unique_ptr<SharedTopology> shared_topology_;
+
+  // Version of the shared topology replicaset_data_ was taken from.
+  uint64_t shared_topology_version_ = 0;
+
+  // Whether replicaset_data_ was taken from the shared topology file.
+  bool shared_topology_followed_ = false;
+
+  // How long a subscriber waits for a publication of its cluster before it
+  // refreshes the metadata cache itself.
+  std::chrono::milliseconds shared_topology_max_wait_ = std::chrono::seconds(10);
+
+  // Whether the last publication to the shared topology file succeeded.
+  bool shared_topology_published_ = true;
+
+  // Whether the last refresh reached a metadata server.
+  bool md_servers_reachable_ = false;
+
+  // Whether the refresh thread got started. Protected by cache_refreshing_mutex_.
+  bool refresh_thread_started_ = false;
+
+  // Signalled when topology_known_ gets set or the cache is stopped.
+  std::condition_variable topology_known_cond_;
+
   #if 0 // not used so far
   // This mutex ensures that a refresh of the servers that contain the metadata
   // is consistent with the use of the server list.
@@ -201,17 +285,22 @@ private:
   // Flag used to terminate the refresh thread.
   std::atomic_bool terminate_;
 
-  // map of lists (per each replicaset name) of registered callbacks to be called
-  // on selected replicaset instances change event
-  std::mutex replicaset_instances_change_callbacks_mtx_;
+  // Calls the listeners registered per replicaset name on changes of the
+  // replicaset instances, off the refresh thread once started.
+  NotificationDispatcher notification_dispatcher_;
 
-  std::map<std::string, std::set<metadata_cache::ReplicasetStateListenerInterface*>> listeners_;
+  // Decides when the refresh thread refreshes next, keeps refresh counters.
+  RefreshScheduler refresh_scheduler_;
 
 #ifdef FRIEND_TEST
   FRIEND_TEST(FailoverTest, basics);
   FRIEND_TEST(FailoverTest, primary_failover);
   FRIEND_TEST(MetadataCacheTest2, basic_test);
   FRIEND_TEST(MetadataCacheTest2, metadata_server_connection_failures);
+  FRIEND_TEST(MetadataCacheTest2, topology_snapshot);
+  FRIEND_TEST(MetadataCacheTest2, topology_snapshot_of_other_cluster);
+  FRIEND_TEST(MetadataCacheTest2, shared_topology_subscriber);
+  FRIEND_TEST(MetadataCacheTest2, shared_topology_without_publication);
 #endif
 };
 
@@ -39,6 +39,7 @@
 #include "mysqlrouter/utils.h"
 #include "mysql/harness/logging/logging.h"
 #include "mysql/harness/config_parser.h"
+#include "mysql/harness/filesystem.h"
 #include "tcp_address.h"
 
 using metadata_cache::LookupResult;
@@ -49,6 +50,7 @@ IMPORT_LOG_FUNCTIONS()
 static const mysql_harness::AppInfo *g_app_info;
 static const string kSectionName = "metadata_cache";
 static const char *kKeyringAttributePassword = "password";
+static const char *kTopologySnapshotFileName = "metadata_cache_topology.json";
 
 static void init(mysql_harness::PluginFuncEnv* env) {
   g_app_info = get_app_info(env);
@@ -86,6 +88,25 @@ static mysqlrouter::SSLOptions make_ssl_options(
   return options;
 }
 
+/**
+ * Returns the file the metadata cache keeps the last known topology in.
+ *
+ * It lives in the data folder (next to the keyring). Without a data folder,
+ * the topology is not kept across restarts and empty string is returned.
+ */
+static std::string get_topology_snapshot_file() {
+  if (!g_app_info || !g_app_info->data_folder || !*g_app_info->data_folder)
+    return "";
+
+  mysql_harness::Path data_folder(g_app_info->data_folder);
+  if (!data_folder.is_directory()) {
+    log_debug("Data folder '%s' does not exist, not keeping the topology across restarts",
+              data_folder.c_str());
+    return "";
+  }
+  return data_folder.join(kTopologySnapshotFileName).str();
+}
+
 /**
  * Initialize the metadata cache for fetching the information from the
  * metadata servers.
@@ -117,6 +138,10 @@ static void start(mysql_harness::PluginFuncEnv* env) {
       throw std::runtime_error(msg);
     }
 
+    metadata_cache::TopologyFiles topology_files;
+    topology_files.snapshot = get_topology_snapshot_file();
+    topology_files.shared = config.shared_topology_file;
+
     log_info("Starting Metadata Cache");
     // Initialize the metadata cache.
     metadata_cache::MetadataCacheAPI::instance()->cache_init(config.bootstrap_addresses, config.user,
@@ -125,7 +150,8 @@ static void start(mysql_harness::PluginFuncEnv* env) {
                                metadata_cluster,
                                config.connect_timeout,
                                config.read_timeout,
-                               config.thread_stack_size);
+                               config.thread_stack_size,
+                               topology_files);
   } catch (const std::runtime_error &exc) { // metadata_cache::metadata_error inherits from runtime_error
     log_error("%s", exc.what());  // TODO remove after Loader starts logging
     set_error(env, mysql_harness::kRuntimeError, "%s", exc.what());
@@ -0,0 +1,144 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "notification_dispatcher.h"
+
+#include "common.h"
+#include "mysql/harness/logging/logging.h"
+
+IMPORT_LOG_FUNCTIONS()
+
+NotificationDispatcher::NotificationDispatcher(size_t thread_stack_size)
+    : thread_(thread_stack_size) {}
+
+NotificationDispatcher::~NotificationDispatcher() {
+  stop();
+}
+
+void* NotificationDispatcher::run_thread(void *context) {
+  static_cast<NotificationDispatcher*>(context)->run();
+  return nullptr;
+}
+
+void NotificationDispatcher::start() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mtx_);
+    if (running_)
+      return;
+    running_ = true;
+    terminate_ = false;
+  }
+  thread_.run(&run_thread, this);
+}
+
+void NotificationDispatcher::stop() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(queue_mtx_);
+    if (!running_)
+      return;
+    terminate_ = true;
+  }
+  queue_cond_.notify_all();
+  thread_.join();
+
+  std::lock_guard<std::mutex> lock(queue_mtx_);
+  running_ = false;
+  pending_.reset();
+}
+
+void NotificationDispatcher::run() {
+  mysql_harness::rename_thread("MDC Notify");
+
+  std::unique_lock<std::mutex> lock(queue_mtx_);
+  while (true) {
+    queue_cond_.wait(lock, [this] { return terminate_ || pending_; });
+    if (terminate_)
+      return;
+
+    ReplicaSets replicasets;
+    replicasets.swap(pending_);
+    const bool md_servers_reachable = pending_md_servers_reachable_;
+
+    lock.unlock();
+    dispatch(*replicasets, md_servers_reachable);
+    lock.lock();
+  }
+}
+
+void NotificationDispatcher::post(ReplicaSets replicasets, bool md_servers_reachable) {
+  {
+    std::lock_guard<std::mutex> lock(queue_mtx_);
+    if (running_ && !terminate_) {
+      if (pending_)
+        ++coalesced_count_;
+      pending_ = std::move(replicasets);
+      pending_md_servers_reachable_ = md_servers_reachable;
+      queue_cond_.notify_one();
+      return;
+    }
+  }
+
+  dispatch(*replicasets, md_servers_reachable);
+}
+
+uint64_t NotificationDispatcher::coalesced_count() const {
+  std::lock_guard<std::mutex> lock(queue_mtx_);
+  return coalesced_count_;
+}
+
+void NotificationDispatcher::dispatch(const MetaData::ReplicaSetsByName &replicasets,
+                                      bool md_servers_reachable) {
+  std::lock_guard<std::mutex> lock(listeners_mtx_);
+
+  for (auto &replicaset_listeners: listeners_) {
+    if (replicaset_listeners.second.empty())
+      continue;
+
+    const std::string &replicaset_name = replicaset_listeners.first;
+    auto replicaset = replicasets.find(replicaset_name);
+    if (replicaset == replicasets.end())
+      log_warning("Replicaset '%s' not available", replicaset_name.c_str());
+
+    const metadata_cache::LookupResult res(
+        replicaset == replicasets.end()
+            ? std::vector<metadata_cache::ManagedInstance>()
+            : replicaset->second.members);
+    for (auto each : replicaset_listeners.second) {
+      each->notify(res, md_servers_reachable);
+    }
+  }
+}
+
+void NotificationDispatcher::add_listener(const std::string &replicaset_name,
+                                          Listener *listener) {
+  std::lock_guard<std::mutex> lock(listeners_mtx_);
+  listeners_[replicaset_name].insert(listener);
+}
+
+void NotificationDispatcher::remove_listener(const std::string &replicaset_name,
+                                             Listener *listener) {
+  std::lock_guard<std::mutex> lock(listeners_mtx_);
+  listeners_[replicaset_name].erase(listener);
+}
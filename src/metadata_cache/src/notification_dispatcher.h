@@ -0,0 +1,123 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef METADATA_CACHE_NOTIFICATION_DISPATCHER_INCLUDED
+#define METADATA_CACHE_NOTIFICATION_DISPATCHER_INCLUDED
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "metadata.h"
+#include "mysql_router_thread.h"
+#include "mysqlrouter/metadata_cache.h"
+
+/** @class NotificationDispatcher
+ *
+ * Notifies the listeners registered for a replicaset about changes of the
+ * routing table.
+ *
+ * Once started, the listeners are called from a thread of the dispatcher,
+ * hence the thread posting a change (the refresh thread of the metadata
+ * cache) doesn't wait for them. Each posted routing table is an immutable
+ * snapshot. If more changes are posted while the listeners are still busy
+ * with a previous one, only the last of them is dispatched: the listeners
+ * get the latest state, not every state in between.
+ *
+ * Before start() and after stop(), posted changes are dispatched right away
+ * on the posting thread.
+ */
+class METADATA_API NotificationDispatcher {
+ public:
+  using Listener = metadata_cache::ReplicasetStateListenerInterface;
+  using ReplicaSets = std::shared_ptr<const MetaData::ReplicaSetsByName>;
+
+  /**
+   * @param thread_stack_size memory in kilobytes allocated for the stack of
+   *        the dispatcher thread
+   */
+  explicit NotificationDispatcher(
+      size_t thread_stack_size = mysql_harness::kDefaultStackSizeInKiloBytes);
+
+  ~NotificationDispatcher();
+
+  NotificationDispatcher(const NotificationDispatcher &) = delete;
+  NotificationDispatcher &operator=(const NotificationDispatcher &) = delete;
+
+  /** @brief Starts the dispatcher thread */
+  void start();
+
+  /** @brief Stops the dispatcher thread, dropping a pending change */
+  void stop() noexcept;
+
+  /** @brief Registers a listener for changes of a replicaset */
+  void add_listener(const std::string &replicaset_name, Listener *listener);
+
+  /** @brief Unregisters a listener
+   *
+   * When this returns, the listener is not being called and won't be called
+   * anymore.
+   */
+  void remove_listener(const std::string &replicaset_name, Listener *listener);
+
+  /** @brief Posts a changed routing table
+   *
+   * @param replicasets the new routing table
+   * @param md_servers_reachable false if the routing table was cleared
+   *        because no metadata server was reachable
+   */
+  void post(ReplicaSets replicasets, bool md_servers_reachable);
+
+  /** @brief Number of changes that were replaced by a later one before the
+   * listeners got them */
+  uint64_t coalesced_count() const;
+
+ private:
+  static void* run_thread(void *context);
+  void run();
+
+  void dispatch(const MetaData::ReplicaSetsByName &replicasets,
+                bool md_servers_reachable);
+
+  mysql_harness::MySQLRouterThread thread_;
+
+  // protects the members below up to listeners_mtx_
+  mutable std::mutex queue_mtx_;
+  std::condition_variable queue_cond_;
+  ReplicaSets pending_;  // null if nothing is pending
+  bool pending_md_servers_reachable_ = true;
+  uint64_t coalesced_count_ = 0;
+  bool running_ = false;
+  bool terminate_ = false;
+
+  // held while the listeners are called
+  std::mutex listeners_mtx_;
+  std::map<std::string, std::set<Listener*>> listeners_;
+};
+
+#endif // METADATA_CACHE_NOTIFICATION_DISPATCHER_INCLUDED
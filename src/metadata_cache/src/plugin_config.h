@@ -59,7 +59,8 @@ public:
         metadata_cluster(get_option_string(section, "metadata_cluster")),
         connect_timeout(get_uint_option<uint16_t>(section, "connect_timeout", 1)),
         read_timeout(get_uint_option<uint16_t>(section, "read_timeout", 1)),
-        thread_stack_size(get_uint_option<uint32_t>(section, "thread_stack_size", 1, 65535))
+        thread_stack_size(get_uint_option<uint32_t>(section, "thread_stack_size", 1, 65535)),
+        shared_topology_file(get_option_string(section, "shared_topology_file"))
   { }
 
   /**
@@ -84,6 +85,9 @@ public:
   const unsigned int read_timeout;
   /** @brief memory in kilobytes allocated for thread's stack */
   const unsigned int thread_stack_size;
+  /** @brief File the routing table is shared through with the other routers
+   * of the host (running as the same user), empty to not share it */
+  const std::string shared_topology_file;
 
 private:
   /** @brief Gets a list of metadata servers.
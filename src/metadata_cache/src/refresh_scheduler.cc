@@ -0,0 +1,95 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "refresh_scheduler.h"
+
+#include <algorithm>
+
+using std::chrono::milliseconds;
+using std::chrono::microseconds;
+
+const unsigned RefreshScheduler::kJitterPercent = 10;
+const milliseconds RefreshScheduler::kMaxBackoff = std::chrono::seconds(10);
+const milliseconds RefreshScheduler::kEmergencyInterval = std::chrono::seconds(1);
+const unsigned RefreshScheduler::kEmergencyCostFactor = 10;
+
+RefreshScheduler::RefreshScheduler(milliseconds ttl, unsigned seed)
+    : ttl_(ttl), jitter_rng_(seed) {}
+
+void RefreshScheduler::record_refresh(std::chrono::steady_clock::duration duration, bool ok) {
+  consecutive_failures_ = ok ? 0 : consecutive_failures_ + 1;
+
+  const auto time = std::chrono::duration_cast<microseconds>(duration);
+  std::lock_guard<std::mutex> lock(stats_mtx_);
+  ++stats_.refreshes;
+  if (!ok)
+    ++stats_.failed;
+  stats_.last_time = time;
+  stats_.max_time = std::max(stats_.max_time, time);
+  stats_.total_time += time;
+}
+
+milliseconds RefreshScheduler::base_interval(bool emergency) const {
+  milliseconds interval = ttl_;
+
+  if (emergency) {
+    // but not faster than the metadata server answers
+    milliseconds last_time;
+    {
+      std::lock_guard<std::mutex> lock(stats_mtx_);
+      last_time = std::chrono::duration_cast<milliseconds>(stats_.last_time);
+    }
+    interval = std::min(interval, std::max(kEmergencyInterval, last_time * kEmergencyCostFactor));
+  }
+
+  // the first retry after a failure is not delayed, metadata servers may
+  // just be switching over
+  if (consecutive_failures_ > 1) {
+    const unsigned doublings = std::min(consecutive_failures_ - 1, 16u);
+    const milliseconds backoff = std::min<milliseconds>(ttl_ * (milliseconds::rep(1) << doublings),
+                                                        std::max(ttl_, kMaxBackoff));
+    interval = std::max(interval, backoff);
+  }
+
+  return interval;
+}
+
+milliseconds RefreshScheduler::next_interval(bool emergency) {
+  const milliseconds interval = base_interval(emergency);
+
+  if (emergency && interval > std::min(ttl_, kEmergencyInterval)) {
+    std::lock_guard<std::mutex> lock(stats_mtx_);
+    ++stats_.skipped;
+  }
+
+  std::uniform_int_distribution<milliseconds::rep> jitter(
+      -interval.count() * kJitterPercent / 100, interval.count() * kJitterPercent / 100);
+  return interval + milliseconds(jitter(jitter_rng_));
+}
+
+RefreshScheduler::Stats RefreshScheduler::get_stats() const {
+  std::lock_guard<std::mutex> lock(stats_mtx_);
+  return stats_;
+}
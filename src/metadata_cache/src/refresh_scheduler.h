@@ -0,0 +1,107 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef METADATA_CACHE_REFRESH_SCHEDULER_INCLUDED
+#define METADATA_CACHE_REFRESH_SCHEDULER_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+
+#include "mysqlrouter/metadata_cache.h"
+
+/** @class RefreshScheduler
+ *
+ * Decides when the metadata cache refreshes next and keeps the refresh
+ * counters.
+ *
+ * - The interval between refreshes is the TTL with a random jitter, so that
+ *   routers started at the same time don't keep querying the metadata
+ *   servers in lockstep.
+ * - After consecutive failed refreshes, the interval is doubled with each
+ *   failure (up to kMaxBackoff).
+ * - In emergency mode the interval is kEmergencyInterval, but at least
+ *   kEmergencyCostFactor times as long as the last refresh took: a metadata
+ *   server that answers slowly is not queried more often on top.
+ */
+class METADATA_API RefreshScheduler {
+ public:
+  /** @brief Refresh counters */
+  struct Stats {
+    uint64_t refreshes;
+    // refreshes that reached no metadata server
+    uint64_t failed;
+    // emergency mode refreshes held back by the backoff or the cost limit
+    uint64_t skipped;
+    std::chrono::microseconds last_time;
+    std::chrono::microseconds max_time;
+    std::chrono::microseconds total_time;
+  };
+
+  /** @brief Relative jitter applied to each interval, in percent */
+  static const unsigned kJitterPercent;
+  /** @brief Longest interval the backoff after failures leads to */
+  static const std::chrono::milliseconds kMaxBackoff;
+  /** @brief Interval between refreshes in emergency mode */
+  static const std::chrono::milliseconds kEmergencyInterval;
+  /** @brief Minimum ratio of emergency mode interval to refresh time */
+  static const unsigned kEmergencyCostFactor;
+
+  /**
+   * @param ttl the interval between refreshes
+   * @param seed seed of the jitter
+   */
+  explicit RefreshScheduler(std::chrono::milliseconds ttl,
+                            unsigned seed = std::random_device()());
+
+  /** @brief Accounts a finished refresh
+   *
+   * @param duration time the refresh took
+   * @param ok false if no metadata server was reachable
+   */
+  void record_refresh(std::chrono::steady_clock::duration duration, bool ok);
+
+  /** @brief Time to wait after the last refresh before the next one
+   *
+   * @param emergency whether the cache is in emergency mode
+   */
+  std::chrono::milliseconds next_interval(bool emergency);
+
+  Stats get_stats() const;
+
+ private:
+  // interval without the jitter
+  std::chrono::milliseconds base_interval(bool emergency) const;
+
+  const std::chrono::milliseconds ttl_;
+  std::minstd_rand jitter_rng_;
+  unsigned consecutive_failures_ = 0;
+
+  mutable std::mutex stats_mtx_;
+  Stats stats_{};
+};
+
+#endif // METADATA_CACHE_REFRESH_SCHEDULER_INCLUDED
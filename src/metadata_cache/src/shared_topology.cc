@@ -0,0 +1,363 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "shared_topology.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/file.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#include "common.h"  // get_strerror
+
+using metadata_cache::ManagedInstance;
+using metadata_cache::ManagedReplicaSet;
+using metadata_cache::ServerMode;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "counters in the shared file must be lock-free");
+
+namespace {
+
+const char kMagic[8] = {'M', 'R', 'S', 'H', 'T', 'O', 'P', 'O'};
+
+// attempts of read() to get a consistent copy of the publication; a
+// publisher which died while writing leaves the counter odd until the next
+// publisher takes over
+const int kMaxReadAttempts = 100;
+
+struct ReplicasetRecord {
+  char name[64];
+  char group_view_id[64];
+  uint32_t first_instance;
+  uint32_t instance_count;
+  uint32_t single_primary_mode;
+};
+
+struct InstanceRecord {
+  char mysql_server_uuid[64];
+  char role[32];
+  char location[128];
+  char host[256];
+  uint32_t mode;
+  float weight;
+  uint32_t version_token;
+  uint32_t port;
+  uint32_t xport;
+  uint64_t transactions_behind;
+};
+
+struct Payload {
+  char cluster_name[256];
+  uint32_t md_servers_reachable;
+  uint32_t replicaset_count;
+  uint32_t instance_count;
+  ReplicasetRecord replicasets[SharedTopology::kMaxReplicasets];
+  InstanceRecord instances[SharedTopology::kMaxInstances];
+};
+
+// copies a string into a fixed size field, false if it doesn't fit
+template <size_t N>
+bool set_field(char (&field)[N], const std::string &value) {
+  if (value.size() >= N)
+    return false;
+  std::memcpy(field, value.c_str(), value.size() + 1);
+  return true;
+}
+
+template <size_t N>
+std::string get_field(const char (&field)[N]) {
+  return std::string(field, strnlen(field, N));
+}
+
+uint32_t encode_mode(ServerMode mode) {
+  switch (mode) {
+    case ServerMode::ReadWrite: return 1;
+    case ServerMode::ReadOnly: return 2;
+    case ServerMode::Unavailable: break;
+  }
+  return 0;
+}
+
+ServerMode decode_mode(uint32_t mode) {
+  switch (mode) {
+    case 1: return ServerMode::ReadWrite;
+    case 2: return ServerMode::ReadOnly;
+  }
+  return ServerMode::Unavailable;
+}
+
+bool encode_payload(const std::string &cluster_name,
+                    const MetaData::ReplicaSetsByName &replicasets,
+                    bool md_servers_reachable, Payload &payload) {
+  if (!set_field(payload.cluster_name, cluster_name))
+    return false;
+  payload.md_servers_reachable = md_servers_reachable ? 1 : 0;
+
+  uint32_t rs_ndx = 0;
+  uint32_t inst_ndx = 0;
+  for (const auto &rs : replicasets) {
+    if (rs_ndx == SharedTopology::kMaxReplicasets)
+      return false;
+    ReplicasetRecord &rs_rec = payload.replicasets[rs_ndx++];
+    if (!set_field(rs_rec.name, rs.second.name) ||
+        !set_field(rs_rec.group_view_id, rs.second.group_view_id))
+      return false;
+    rs_rec.single_primary_mode = rs.second.single_primary_mode ? 1 : 0;
+    rs_rec.first_instance = inst_ndx;
+    rs_rec.instance_count = 0;
+
+    for (const auto &mi : rs.second.members) {
+      if (inst_ndx == SharedTopology::kMaxInstances)
+        return false;
+      InstanceRecord &rec = payload.instances[inst_ndx++];
+      if (!set_field(rec.mysql_server_uuid, mi.mysql_server_uuid) ||
+          !set_field(rec.role, mi.role) ||
+          !set_field(rec.location, mi.location) ||
+          !set_field(rec.host, mi.host))
+        return false;
+      rec.mode = encode_mode(mi.mode);
+      rec.weight = mi.weight;
+      rec.version_token = mi.version_token;
+      rec.port = mi.port;
+      rec.xport = mi.xport;
+      rec.transactions_behind = mi.transactions_behind;
+      ++rs_rec.instance_count;
+    }
+  }
+  payload.replicaset_count = rs_ndx;
+  payload.instance_count = inst_ndx;
+
+  return true;
+}
+
+void decode_payload(const Payload &payload, SharedTopology::Publication &publication) {
+  publication.cluster_name = get_field(payload.cluster_name);
+  publication.md_servers_reachable = payload.md_servers_reachable != 0;
+  publication.replicasets.clear();
+
+  // the counts were verified to be in range by the caller
+  for (uint32_t i = 0; i < payload.replicaset_count; ++i) {
+    const ReplicasetRecord &rs_rec = payload.replicasets[i];
+    ManagedReplicaSet replicaset;
+    replicaset.name = get_field(rs_rec.name);
+    replicaset.group_view_id = get_field(rs_rec.group_view_id);
+    replicaset.single_primary_mode = rs_rec.single_primary_mode != 0;
+
+    for (uint32_t j = rs_rec.first_instance;
+         j < rs_rec.first_instance + rs_rec.instance_count; ++j) {
+      const InstanceRecord &rec = payload.instances[j];
+      ManagedInstance mi;
+      mi.replicaset_name = replicaset.name;
+      mi.mysql_server_uuid = get_field(rec.mysql_server_uuid);
+      mi.role = get_field(rec.role);
+      mi.mode = decode_mode(rec.mode);
+      mi.weight = rec.weight;
+      mi.version_token = rec.version_token;
+      mi.location = get_field(rec.location);
+      mi.host = get_field(rec.host);
+      mi.port = rec.port;
+      mi.xport = rec.xport;
+      mi.transactions_behind = rec.transactions_behind;
+      replicaset.members.push_back(std::move(mi));
+    }
+
+    publication.replicasets[replicaset.name] = std::move(replicaset);
+  }
+}
+
+bool payload_in_range(const Payload &payload) {
+  if (payload.replicaset_count > SharedTopology::kMaxReplicasets ||
+      payload.instance_count > SharedTopology::kMaxInstances)
+    return false;
+  for (uint32_t i = 0; i < payload.replicaset_count; ++i) {
+    const ReplicasetRecord &rs_rec = payload.replicasets[i];
+    if (rs_rec.first_instance > payload.instance_count ||
+        rs_rec.instance_count > payload.instance_count - rs_rec.first_instance)
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+struct SharedTopology::Layout {
+  char magic[sizeof(kMagic)];
+  // sizeof(Layout), routers built with another layout don't share the file
+  uint64_t layout_size;
+  // odd while a publication is written
+  std::atomic<uint64_t> seq;
+  std::atomic<uint32_t> refresh_requested;
+  Payload payload;
+};
+
+#ifndef _WIN32
+
+SharedTopology::SharedTopology(const std::string &path) : path_(path) {
+  fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0600);
+  if (fd_ < 0) {
+    const int err = errno;
+    // the file is only accessible to the user which created it
+    throw std::runtime_error("Could not open shared topology file '" + path + "': " +
+                             mysql_harness::get_strerror(err) +
+                             (err == EACCES ? " (all routers sharing it must run as the same user)"
+                                            : ""));
+  }
+
+  struct stat st;
+  if (fstat(fd_, &st) != 0 ||
+      (static_cast<size_t>(st.st_size) < sizeof(Layout) &&
+       ftruncate(fd_, sizeof(Layout)) != 0)) {
+    const std::string err = mysql_harness::get_strerror(errno);
+    close(fd_);
+    throw std::runtime_error("Could not size shared topology file '" + path + "': " + err);
+  }
+
+  void *addr = mmap(nullptr, sizeof(Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (addr == MAP_FAILED) {
+    const std::string err = mysql_harness::get_strerror(errno);
+    close(fd_);
+    throw std::runtime_error("Could not map shared topology file '" + path + "': " + err);
+  }
+  layout_ = static_cast<Layout*>(addr);
+}
+
+SharedTopology::~SharedTopology() {
+  munmap(layout_, sizeof(Layout));
+  close(fd_);  // releases the lock
+}
+
+bool SharedTopology::try_become_publisher() noexcept {
+  if (is_publisher_)
+    return true;
+
+  if (flock(fd_, LOCK_EX | LOCK_NB) != 0)
+    return false;
+
+  is_publisher_ = true;
+
+  // a file created just now or by a router with another layout
+  if (std::memcmp(layout_->magic, kMagic, sizeof(kMagic)) != 0 ||
+      layout_->layout_size != sizeof(Layout)) {
+    layout_->seq.store(0);
+    layout_->refresh_requested.store(0);
+    layout_->layout_size = sizeof(Layout);
+    std::memcpy(layout_->magic, kMagic, sizeof(kMagic));
+  }
+
+  return true;
+}
+
+#else
+
+SharedTopology::SharedTopology(const std::string &path) : path_(path) {
+  throw std::runtime_error("Sharing the topology through '" + path +
+                           "' is not supported on this platform");
+}
+
+SharedTopology::~SharedTopology() {}
+
+bool SharedTopology::try_become_publisher() noexcept {
+  return false;
+}
+
+#endif
+
+bool SharedTopology::publish(const std::string &cluster_name,
+                             const MetaData::ReplicaSetsByName &replicasets,
+                             bool md_servers_reachable) {
+  if (!is_publisher_)
+    throw std::logic_error("only the publisher can publish the topology");
+
+  // encode outside of the write section to not publish partial results
+  std::unique_ptr<Payload> payload(new Payload());
+  if (!encode_payload(cluster_name, replicasets, md_servers_reachable, *payload))
+    return false;
+
+  uint64_t seq = layout_->seq.load(std::memory_order_relaxed);
+  if (seq & 1)
+    ++seq;  // the previous publisher died while writing
+
+  layout_->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(&layout_->payload, payload.get(), sizeof(Payload));
+  layout_->seq.store(seq + 2, std::memory_order_release);
+
+  return true;
+}
+
+uint64_t SharedTopology::version() const noexcept {
+  if (std::memcmp(layout_->magic, kMagic, sizeof(kMagic)) != 0 ||
+      layout_->layout_size != sizeof(Layout))
+    return 0;
+
+  return layout_->seq.load(std::memory_order_acquire) / 2;
+}
+
+bool SharedTopology::read(Publication &publication) const {
+  std::unique_ptr<Payload> payload(new Payload());
+
+  uint64_t seq;
+  int attempts = 0;
+  while (true) {
+    if (version() == 0 || ++attempts > kMaxReadAttempts)
+      return false;
+
+    seq = layout_->seq.load(std::memory_order_acquire);
+    if (seq & 1) {
+      std::this_thread::yield();  // publication in progress
+      continue;
+    }
+    std::memcpy(payload.get(), &layout_->payload, sizeof(Payload));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (layout_->seq.load(std::memory_order_relaxed) == seq)
+      break;
+  }
+
+  if (!payload_in_range(*payload))
+    return false;
+
+  publication.version = seq / 2;
+  decode_payload(*payload, publication);
+
+  return true;
+}
+
+void SharedTopology::request_refresh() noexcept {
+  layout_->refresh_requested.store(1, std::memory_order_relaxed);
+}
+
+bool SharedTopology::take_refresh_request() noexcept {
+  return layout_->refresh_requested.exchange(0, std::memory_order_relaxed) != 0;
+}
@@ -0,0 +1,125 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef METADATA_CACHE_SHARED_TOPOLOGY_INCLUDED
+#define METADATA_CACHE_SHARED_TOPOLOGY_INCLUDED
+
+#include <cstdint>
+#include <string>
+
+#include "metadata.h"
+
+/** @class SharedTopology
+ *
+ * Routing table shared by the routers of one host through a memory mapped
+ * file, so that only one of them has to query the metadata servers.
+ *
+ * The router holding the lock on the file is the publisher: it refreshes
+ * the metadata cache as usual and publishes each result. The others are
+ * subscribers: they take the routing table from the file whenever its
+ * version changes. If the publisher goes away, its lock is released and
+ * one of the subscribers takes over.
+ *
+ * The file has a fixed layout. A publication is guarded by a sequence
+ * counter (seqlock): it is odd while the publisher writes, readers copy the
+ * data and retry if the counter changed meanwhile. The version of a
+ * publication is half its sequence counter.
+ */
+class METADATA_API SharedTopology {
+ public:
+  /** @brief Maximum number of replicasets a publication can hold */
+  static const size_t kMaxReplicasets = 16;
+  /** @brief Maximum number of instances a publication can hold */
+  static const size_t kMaxInstances = 256;
+
+  /** @brief A routing table as published */
+  struct Publication {
+    uint64_t version;
+    std::string cluster_name;
+    MetaData::ReplicaSetsByName replicasets;
+    bool md_servers_reachable;
+  };
+
+  /** @brief Maps the file, creating it if needed
+   *
+   * A new file is created with mode 0600, as the routing table must not be
+   * changed by others: all routers sharing the file have to run as the same
+   * user. Throws std::runtime_error on errors.
+   *
+   * @param path path of the file, the same for all routers sharing it
+   */
+  explicit SharedTopology(const std::string &path);
+
+  ~SharedTopology();
+
+  SharedTopology(const SharedTopology &) = delete;
+  SharedTopology &operator=(const SharedTopology &) = delete;
+
+  /** @brief Takes the lock on the file if nobody else holds it
+   *
+   * @return true if this is the publisher (now or already before)
+   */
+  bool try_become_publisher() noexcept;
+
+  /** @brief Whether this is the publisher */
+  bool is_publisher() const noexcept { return is_publisher_; }
+
+  /** @brief Publishes a routing table, must be the publisher
+   *
+   * @return false if the routing table doesn't fit into the file, the
+   *         previous publication stays in place then
+   */
+  bool publish(const std::string &cluster_name,
+               const MetaData::ReplicaSetsByName &replicasets,
+               bool md_servers_reachable);
+
+  /** @brief Version of the last publication, 0 if there is none */
+  uint64_t version() const noexcept;
+
+  /** @brief Reads the last publication
+   *
+   * Gives up if the publication keeps changing or stays half written (the
+   * publisher died while writing it) over a number of attempts.
+   *
+   * @param publication filled with the publication
+   * @return false if there is no publication or it could not be read
+   */
+  bool read(Publication &publication) const;
+
+  /** @brief Asks the publisher to refresh as soon as possible */
+  void request_refresh() noexcept;
+
+  /** @brief Returns whether a refresh was requested and resets the request */
+  bool take_refresh_request() noexcept;
+
+ private:
+  struct Layout;
+
+  std::string path_;
+  int fd_ = -1;
+  Layout *layout_ = nullptr;
+  bool is_publisher_ = false;
+};
+
+#endif // METADATA_CACHE_SHARED_TOPOLOGY_INCLUDED
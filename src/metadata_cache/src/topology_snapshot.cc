@@ -0,0 +1,257 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "topology_snapshot.h"
+
+#ifdef RAPIDJSON_NO_SIZETYPEDEFINE
+// if we build within the server, it will set RAPIDJSON_NO_SIZETYPEDEFINE globally
+// and require to include my_rapidjson_size_t.h
+#include "my_rapidjson_size_t.h"
+#endif
+
+#include "rapidjson/document.h"
+#include "rapidjson/error/en.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "common.h"  // get_strerror
+#include "mysqlrouter/utils.h"  // rename_file
+
+using metadata_cache::ManagedInstance;
+using metadata_cache::ManagedReplicaSet;
+using metadata_cache::ServerMode;
+
+namespace {
+
+// bump when the layout changes in an incompatible way, older snapshots
+// are then ignored
+const unsigned kSnapshotVersion = 1;
+
+const char *server_mode_name(ServerMode mode) {
+  switch (mode) {
+    case ServerMode::ReadWrite: return "read_write";
+    case ServerMode::ReadOnly: return "read_only";
+    case ServerMode::Unavailable: break;
+  }
+  return "unavailable";
+}
+
+ServerMode server_mode_from_name(const std::string &name) {
+  if (name == "read_write") return ServerMode::ReadWrite;
+  if (name == "read_only") return ServerMode::ReadOnly;
+  if (name == "unavailable") return ServerMode::Unavailable;
+  throw std::runtime_error("unknown server mode '" + name + "'");
+}
+
+const rapidjson::Value &get_member(const rapidjson::Value &obj, const char *name) {
+  auto it = obj.FindMember(name);
+  if (it == obj.MemberEnd())
+    throw std::runtime_error(std::string("'") + name + "' is missing");
+  return it->value;
+}
+
+std::string get_string(const rapidjson::Value &obj, const char *name) {
+  const rapidjson::Value &value = get_member(obj, name);
+  if (!value.IsString())
+    throw std::runtime_error(std::string("'") + name + "' is not a string");
+  return std::string(value.GetString(), value.GetStringLength());
+}
+
+unsigned get_uint(const rapidjson::Value &obj, const char *name) {
+  const rapidjson::Value &value = get_member(obj, name);
+  if (!value.IsUint())
+    throw std::runtime_error(std::string("'") + name + "' is not an unsigned integer");
+  return value.GetUint();
+}
+
+const rapidjson::Value &get_array(const rapidjson::Value &obj, const char *name) {
+  const rapidjson::Value &value = get_member(obj, name);
+  if (!value.IsArray())
+    throw std::runtime_error(std::string("'") + name + "' is not an array");
+  return value;
+}
+
+ManagedInstance read_instance(const rapidjson::Value &json,
+                              const std::string &replicaset_name) {
+  if (!json.IsObject())
+    throw std::runtime_error("member is not an object");
+
+  ManagedInstance instance;
+  instance.replicaset_name = replicaset_name;
+  instance.mysql_server_uuid = get_string(json, "mysql_server_uuid");
+  instance.role = get_string(json, "role");
+  instance.mode = server_mode_from_name(get_string(json, "mode"));
+  const rapidjson::Value &weight = get_member(json, "weight");
+  if (!weight.IsNumber())
+    throw std::runtime_error("'weight' is not a number");
+  instance.weight = static_cast<float>(weight.GetDouble());
+  instance.version_token = get_uint(json, "version_token");
+  instance.location = get_string(json, "location");
+  instance.host = get_string(json, "host");
+  instance.port = get_uint(json, "port");
+  instance.xport = get_uint(json, "xport");
+  // replication lag is outdated by the time the snapshot is read
+  instance.transactions_behind = 0;
+
+  return instance;
+}
+
+MetaData::ReplicaSetsByName read_replicasets(const rapidjson::Value &json) {
+  MetaData::ReplicaSetsByName replicasets;
+
+  for (const auto &rs_json : json.GetArray()) {
+    if (!rs_json.IsObject())
+      throw std::runtime_error("replicaset is not an object");
+
+    ManagedReplicaSet replicaset;
+    replicaset.name = get_string(rs_json, "name");
+    const rapidjson::Value &single_primary_mode = get_member(rs_json, "single_primary_mode");
+    if (!single_primary_mode.IsBool())
+      throw std::runtime_error("'single_primary_mode' is not a boolean");
+    replicaset.single_primary_mode = single_primary_mode.GetBool();
+
+    for (const auto &member_json : get_array(rs_json, "members").GetArray()) {
+      replicaset.members.push_back(read_instance(member_json, replicaset.name));
+    }
+
+    replicasets[replicaset.name] = std::move(replicaset);
+  }
+
+  return replicasets;
+}
+
+} // namespace
+
+void save_topology_snapshot(const std::string &path,
+                            const std::string &cluster_name,
+                            const MetaData::ReplicaSetsByName &replicasets) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+
+  writer.StartObject();
+  writer.Key("version");
+  writer.Uint(kSnapshotVersion);
+  writer.Key("cluster_name");
+  writer.String(cluster_name.c_str(), static_cast<rapidjson::SizeType>(cluster_name.size()));
+  writer.Key("replicasets");
+  writer.StartArray();
+  for (const auto &rs : replicasets) {
+    writer.StartObject();
+    writer.Key("name");
+    writer.String(rs.second.name.c_str(), static_cast<rapidjson::SizeType>(rs.second.name.size()));
+    writer.Key("single_primary_mode");
+    writer.Bool(rs.second.single_primary_mode);
+    writer.Key("members");
+    writer.StartArray();
+    for (const auto &mi : rs.second.members) {
+      writer.StartObject();
+      writer.Key("mysql_server_uuid");
+      writer.String(mi.mysql_server_uuid.c_str(), static_cast<rapidjson::SizeType>(mi.mysql_server_uuid.size()));
+      writer.Key("role");
+      writer.String(mi.role.c_str(), static_cast<rapidjson::SizeType>(mi.role.size()));
+      writer.Key("mode");
+      writer.String(server_mode_name(mi.mode));
+      writer.Key("weight");
+      writer.Double(mi.weight);
+      writer.Key("version_token");
+      writer.Uint(mi.version_token);
+      writer.Key("location");
+      writer.String(mi.location.c_str(), static_cast<rapidjson::SizeType>(mi.location.size()));
+      writer.Key("host");
+      writer.String(mi.host.c_str(), static_cast<rapidjson::SizeType>(mi.host.size()));
+      writer.Key("port");
+      writer.Uint(mi.port);
+      writer.Key("xport");
+      writer.Uint(mi.xport);
+      writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+
+  const std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream f(tmp_path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if (!f) {
+      throw std::runtime_error("Could not create file '" + tmp_path + "': " +
+                               mysql_harness::get_strerror(errno));
+    }
+    f.write(buffer.GetString(), static_cast<std::streamsize>(buffer.GetSize()));
+    f.close();
+    if (f.fail()) {
+      std::remove(tmp_path.c_str());
+      throw std::runtime_error("Could not write file '" + tmp_path + "'");
+    }
+  }
+
+  if (mysqlrouter::rename_file(tmp_path, path) != 0) {
+    const std::string err = mysql_harness::get_strerror(errno);
+    std::remove(tmp_path.c_str());
+    throw std::runtime_error("Could not rename '" + tmp_path + "' to '" + path + "': " + err);
+  }
+}
+
+MetaData::ReplicaSetsByName load_topology_snapshot(const std::string &path,
+                                                   const std::string &cluster_name) {
+  std::ifstream f(path, std::ifstream::in | std::ifstream::binary);
+  if (!f) {
+    throw std::runtime_error("Could not open file '" + path + "': " +
+                             mysql_harness::get_strerror(errno));
+  }
+  std::stringstream ss;
+  ss << f.rdbuf();
+  const std::string content = ss.str();
+
+  rapidjson::Document json;
+  if (json.Parse(content.c_str(), content.size()).HasParseError()) {
+    throw std::runtime_error("Parsing '" + path + "' failed at offset " +
+                             std::to_string(json.GetErrorOffset()) + ": " +
+                             rapidjson::GetParseError_En(json.GetParseError()));
+  }
+
+  try {
+    if (!json.IsObject())
+      throw std::runtime_error("not an object");
+
+    const unsigned version = get_uint(json, "version");
+    if (version != kSnapshotVersion)
+      throw std::runtime_error("unsupported version " + std::to_string(version));
+
+    const std::string snapshot_cluster_name = get_string(json, "cluster_name");
+    if (snapshot_cluster_name != cluster_name)
+      throw std::runtime_error("it belongs to cluster '" + snapshot_cluster_name + "'");
+
+    return read_replicasets(get_array(json, "replicasets"));
+  } catch (const std::runtime_error &e) {
+    throw std::runtime_error("Invalid topology snapshot '" + path + "': " + e.what());
+  }
+}
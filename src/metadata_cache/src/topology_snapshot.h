@@ -0,0 +1,63 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef METADATA_CACHE_TOPOLOGY_SNAPSHOT_INCLUDED
+#define METADATA_CACHE_TOPOLOGY_SNAPSHOT_INCLUDED
+
+#include <string>
+
+#include "metadata.h"
+
+// The topology snapshot is the last routing table fetched from the metadata
+// servers, kept on disk so that a restarted router can route connections
+// before (or without) reaching any of the metadata servers.
+
+/** @brief Writes the topology snapshot of a cluster
+ *
+ * The snapshot is written to a temporary file first, which is then renamed
+ * to `path`, hence readers never see a partially written snapshot.
+ *
+ * Throws std::runtime_error on errors.
+ *
+ * @param path path of the snapshot file
+ * @param cluster_name name of the cluster the topology belongs to
+ * @param replicasets the topology
+ */
+void save_topology_snapshot(const std::string &path,
+                            const std::string &cluster_name,
+                            const MetaData::ReplicaSetsByName &replicasets);
+
+/** @brief Reads the topology snapshot of a cluster
+ *
+ * Throws std::runtime_error if the file can't be read, is malformed or
+ * belongs to another cluster.
+ *
+ * @param path path of the snapshot file
+ * @param cluster_name name of the cluster the topology is expected for
+ * @return the topology
+ */
+MetaData::ReplicaSetsByName load_topology_snapshot(const std::string &path,
+                                                   const std::string &cluster_name);
+
+#endif // METADATA_CACHE_TOPOLOGY_SNAPSHOT_INCLUDED
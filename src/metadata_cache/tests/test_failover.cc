@@ -96,6 +96,8 @@ public:
         {m.string_or_null("uuid-server2"), m.string_or_null("somehost"), m.string_or_null("3001"), m.string_or_null("ONLINE"), m.string_or_null("1")},
         {m.string_or_null("uuid-server3"), m.string_or_null("somehost"), m.string_or_null("3002"), m.string_or_null("ONLINE"), m.string_or_null("1")}
       });
+
+    expect_member_stats();
   }
 
   // make queries on PFS.replication_group_members return primary in the given state
@@ -125,6 +127,16 @@ public:
           {m.string_or_null("uuid-server3"), m.string_or_null("somehost"), m.string_or_null("3002"), m.string_or_null("ONLINE"), m.string_or_null("1")}
         });
     }
+
+    expect_member_stats();
+  }
+
+  // make queries on PFS.replication_group_member_stats fail like on servers before 8.0.2
+  void expect_member_stats() {
+    MySQLSessionReplayer &m = *session;
+
+    m.expect_query("SELECT member_id, COUNT_TRANSACTIONS_REMOTE_IN_APPLIER_QUEUE, view_id FROM performance_schema.replication_group_member_stats WHERE channel_name = 'group_replication_applier'");
+    m.then_error("Unknown column 'COUNT_TRANSACTIONS_REMOTE_IN_APPLIER_QUEUE' in 'field list'", 1054);
   }
 
 };
@@ -147,6 +159,7 @@ TEST_F(FailoverTest, basics) {
   expect_metadata_1();
   expect_group_members_1();
   init_cache();
+  cache->refresh();
 
   // ensure that the instance list returned by a lookup is the expected one
   // in the case everything's online and well
@@ -177,6 +190,7 @@ TEST_F(FailoverTest, primary_failover) {
   expect_metadata_1();
   expect_group_members_1();
   init_cache();
+  cache->refresh();
 
   // ensure that the instance list returned by a lookup is the expected one
   // in the case everything's online and well
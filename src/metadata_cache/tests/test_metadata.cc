@@ -57,6 +57,7 @@
 
 
 using ::testing::_;
+using ::testing::AnyNumber;
 using ::testing::Assign;
 using ::testing::Invoke;
 using ::testing::InvokeWithoutArgs;
@@ -121,6 +122,12 @@ std::string query_status = "SELECT "
     "FROM performance_schema.replication_group_members "
     "WHERE channel_name = 'group_replication_applier'";
 
+// query #4 (optional) - fetches replication lag and GR view of the members as seen by a particular node
+std::string query_member_stats = "SELECT "
+    "member_id, COUNT_TRANSACTIONS_REMOTE_IN_APPLIER_QUEUE, view_id "
+    "FROM performance_schema.replication_group_member_stats "
+    "WHERE channel_name = 'group_replication_applier'";
+
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -131,6 +138,11 @@ std::string query_status = "SELECT "
 
 class MockMySQLSession: public MySQLSession {
  public:
+  MockMySQLSession() {
+    // replication lag is optional, tests not interested in it get no stats
+    EXPECT_CALL(*this, query(StartsWith(query_member_stats), _)).Times(AnyNumber());
+  }
+
   MOCK_METHOD2(query, void(const std::string& query, const RowProcessor& processor));
   MOCK_METHOD2(flag_succeed, void(const std::string&, unsigned int));
   MOCK_METHOD2(flag_fail, void(const std::string&, unsigned int));
@@ -300,7 +312,7 @@ class MetadataTest : public ::testing::Test {
   void connect_to_first_metadata_server() {
 
     std::vector<ManagedInstance> metadata_servers {
-      {"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100},
+      {"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100, 0},
     };
     session_factory.get(0).set_good_conns({"127.0.0.1:3310", "127.0.0.1:3320", "127.0.0.1:3330"});
 
@@ -350,6 +362,32 @@ class MetadataTest : public ::testing::Test {
   }
 
 
+  std::function<void(const std::string&, const MySQLSession::RowProcessor& processor)> query_member_stats_ok(unsigned session) {
+    return [this, session](const std::string&, const MySQLSession::RowProcessor& processor) {
+      session_factory.get(session).query_impl(processor, {
+        {"instance-1", "0", "1540521230:3"},
+        {"instance-2", "250", "1540521230:3"},
+        {"instance-3", nullptr, nullptr},  // no stats (yet)
+      });
+    };
+  }
+
+  std::function<void(const std::string&, const MySQLSession::RowProcessor& processor)> query_member_stats_view(unsigned session,
+                                                                                                               const char *view_id) {
+    return [this, session, view_id](const std::string&, const MySQLSession::RowProcessor& processor) {
+      session_factory.get(session).query_impl(processor, {
+        {"instance-1", "0", view_id},
+        {"instance-2", "0", view_id},
+        {"instance-3", "0", view_id},
+      });
+    };
+  }
+
+  std::function<void(const std::string&, const MySQLSession::RowProcessor& processor)> query_member_stats_fail(unsigned session) {
+    return [this, session](const std::string&, const MySQLSession::RowProcessor& processor) {
+      session_factory.get(session).query_impl(processor, {}, false); // false = induce fail query (e.g. server < 8.0.2)
+    };
+  }
 
  private: // toggling between public and private because we require these vars in this particular order
   std::unique_ptr<MockMySQLSessionFactory> up_session_factory_{new MockMySQLSessionFactory()};
@@ -363,13 +401,14 @@ class MetadataTest : public ::testing::Test {
   const ManagedReplicaSet typical_replicaset {
     "replicaset-1", {
       // will be set ----------------------vvvvvvvvvvvvvvvvvvvvvvv  v--v--vv--- ignored at the time of writing
-      {"replicaset-1", "instance-1", "HA", ServerMode::Unavailable, 0, 0, "", "localhost", 3310, 33100},
-      {"replicaset-1", "instance-2", "HA", ServerMode::Unavailable, 0, 0, "", "localhost", 3320, 33200},
-      {"replicaset-1", "instance-3", "HA", ServerMode::Unavailable, 0, 0, "", "localhost", 3330, 33300},
+      {"replicaset-1", "instance-1", "HA", ServerMode::Unavailable, 0, 0, "", "localhost", 3310, 33100, 0},
+      {"replicaset-1", "instance-2", "HA", ServerMode::Unavailable, 0, 0, "", "localhost", 3320, 33200, 0},
+      {"replicaset-1", "instance-3", "HA", ServerMode::Unavailable, 0, 0, "", "localhost", 3330, 33300, 0},
       // ignored at time of writing -^^^^--------------------------------------------------------^^^^^
       // TODO: ok to ignore xport?
     },
-    false
+    false,
+    ""
   };
 };
 
@@ -383,7 +422,7 @@ class MetadataTest : public ::testing::Test {
 
 TEST_F(MetadataTest, ConnectToMetadataServer_Succeed) {
 
-  ManagedInstance metadata_server{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100};
+  ManagedInstance metadata_server{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100, 0};
   session_factory.get(0).set_good_conns({"127.0.0.1:3310"});
 
   // should connect successfully
@@ -393,7 +432,7 @@ TEST_F(MetadataTest, ConnectToMetadataServer_Succeed) {
 
 TEST_F(MetadataTest, ConnectToMetadataServer_Failed) {
 
-  ManagedInstance metadata_server{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100};
+  ManagedInstance metadata_server{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100, 0};
 
   // connetion attempt should fail
   EXPECT_CALL(session_factory.get(0), flag_fail(_, 3310)).Times(1);
@@ -439,10 +478,10 @@ TEST_F(MetadataTest, FetchInstancesFromMetadataServer) {
 
     EXPECT_EQ(1u, rs.size());
     EXPECT_EQ(4u, rs.at("replicaset-1").members.size()); // not set/checked -------------------vvvvvvvvvvvvvvvvvvvvvvv
-    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-1", "HA",               ServerMode::Unavailable, 0.2f, 0, "location1", "localhost", 3310, 33100}, rs.at("replicaset-1").members.at(0)));
-    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-2", "arbitrary_string", ServerMode::Unavailable, 1.5f, 1, "s.o_loc",   "localhost", 3320, 33200}, rs.at("replicaset-1").members.at(1)));
-    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-3", "",                 ServerMode::Unavailable, 0.0f, 99, "",         "localhost", 3306, 33060}, rs.at("replicaset-1").members.at(2)));
-    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-4", "",                 ServerMode::Unavailable, 0.0f, 0, "",          "", 3306, 33060}, rs.at("replicaset-1").members.at(3)));
+    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-1", "HA",               ServerMode::Unavailable, 0.2f, 0, "location1", "localhost", 3310, 33100, 0}, rs.at("replicaset-1").members.at(0)));
+    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-2", "arbitrary_string", ServerMode::Unavailable, 1.5f, 1, "s.o_loc",   "localhost", 3320, 33200, 0}, rs.at("replicaset-1").members.at(1)));
+    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-3", "",                 ServerMode::Unavailable, 0.0f, 99, "",         "localhost", 3306, 33060, 0}, rs.at("replicaset-1").members.at(2)));
+    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-4", "",                 ServerMode::Unavailable, 0.0f, 0, "",          "", 3306, 33060, 0}, rs.at("replicaset-1").members.at(3)));
     // TODO is this really right behavior? ---------------------------------------------------------------------------------------------------^^
   }
 
@@ -477,14 +516,14 @@ TEST_F(MetadataTest, FetchInstancesFromMetadataServer) {
 
     EXPECT_EQ(3u, rs.size());
     EXPECT_EQ(3u, rs.at("replicaset-1").members.size());
-    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-1", "HA", ServerMode::Unavailable, 0, 0, "", "localhost1", 1111, 11110}, rs.at("replicaset-1").members.at(0)));
-    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-2", "HA", ServerMode::Unavailable, 0, 0, "", "localhost1", 2222, 22220}, rs.at("replicaset-1").members.at(1)));
-    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-3", "HA", ServerMode::Unavailable, 0, 0, "", "localhost1", 3333, 33330}, rs.at("replicaset-1").members.at(2)));
+    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-1", "HA", ServerMode::Unavailable, 0, 0, "", "localhost1", 1111, 11110, 0}, rs.at("replicaset-1").members.at(0)));
+    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-2", "HA", ServerMode::Unavailable, 0, 0, "", "localhost1", 2222, 22220, 0}, rs.at("replicaset-1").members.at(1)));
+    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-1", "instance-3", "HA", ServerMode::Unavailable, 0, 0, "", "localhost1", 3333, 33330, 0}, rs.at("replicaset-1").members.at(2)));
     EXPECT_EQ(1u, rs.at("replicaset-2").members.size());
-    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-2", "instance-4", "HA", ServerMode::Unavailable, 0, 0, "", "localhost2", 3333, 33330}, rs.at("replicaset-2").members.at(0)));
+    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-2", "instance-4", "HA", ServerMode::Unavailable, 0, 0, "", "localhost2", 3333, 33330, 0}, rs.at("replicaset-2").members.at(0)));
     EXPECT_EQ(2u, rs.at("replicaset-3").members.size());
-    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-3", "instance-5", "HA", ServerMode::Unavailable, 0, 0, "", "localhost3", 3333, 33330}, rs.at("replicaset-3").members.at(0)));
-    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-3", "instance-6", "HA", ServerMode::Unavailable, 0, 0, "", "localhost3", 3333, 33330}, rs.at("replicaset-3").members.at(1)));
+    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-3", "instance-5", "HA", ServerMode::Unavailable, 0, 0, "", "localhost3", 3333, 33330, 0}, rs.at("replicaset-3").members.at(0)));
+    EXPECT_TRUE(cmp_mi_FIFMS(ManagedInstance{"replicaset-3", "instance-6", "HA", ServerMode::Unavailable, 0, 0, "", "localhost3", 3333, 33330, 0}, rs.at("replicaset-3").members.at(1)));
   }
 
   // query fails
@@ -530,17 +569,17 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
 
   std::vector<ManagedInstance> servers_in_metadata {
     // ServerMode doesn't matter ------vvvvvvvvvvv
-    {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "instance-3", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
+    {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "instance-3", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
   };
 
   // typical
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online, Role::Primary  } },
-      { "instance-2", {"", "", 0, State::Online, Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Online, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Online, Role::Primary,   0, ""} },
+      { "instance-2", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -551,9 +590,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
   // less typical
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online, Role::Secondary} },
-      { "instance-2", {"", "", 0, State::Online, Role::Primary  } },
-      { "instance-3", {"", "", 0, State::Online, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "instance-2", {"", "", 0, State::Online, Role::Primary,   0, ""} },
+      { "instance-3", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadOnly,    servers_in_metadata.at(0).mode);
@@ -569,9 +608,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
   // less typical
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online, Role::Secondary} },
-      { "instance-2", {"", "", 0, State::Online, Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Online, Role::Primary  } },
+      { "instance-1", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "instance-2", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Online, Role::Primary,   0, ""} },
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadOnly,    servers_in_metadata.at(0).mode);
@@ -587,9 +626,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
   // no primary
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online, Role::Secondary} },
-      { "instance-2", {"", "", 0, State::Online, Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Online, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "instance-2", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableReadOnly, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadOnly,    servers_in_metadata.at(0).mode);
@@ -606,9 +645,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
   // TODO: this behaviour should change, probably turn all Primary -> Unavailable but leave Secondary alone
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online, Role::Primary} },
-      { "instance-2", {"", "", 0, State::Online, Role::Primary} },
-      { "instance-3", {"", "", 0, State::Online, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Online, Role::Primary, 0, ""} },
+      { "instance-2", {"", "", 0, State::Online, Role::Primary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     #ifdef NDEBUG // guardian assert() should fail in Debug
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
@@ -626,8 +665,8 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
   // 1 node missing
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online, Role::Primary  } },
-      { "instance-3", {"", "", 0, State::Online, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Online, Role::Primary,   0, ""} },
+      { "instance-3", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -640,8 +679,8 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
   // 1 node missing, no primary
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-2", {"", "", 0, State::Online, Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Online, Role::Secondary} },
+      { "instance-2", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableReadOnly, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::Unavailable, servers_in_metadata.at(0).mode);
@@ -653,7 +692,7 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
   // 2 nodes missing
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online, Role::Primary  } },
+      { "instance-1", {"", "", 0, State::Online, Role::Primary,   0, ""} },
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -666,7 +705,7 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
   // 2 nodes missing, no primary
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-3", {"", "", 0, State::Online, Role::Secondary} },
+      { "instance-3", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableReadOnly, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::Unavailable, servers_in_metadata.at(0).mode);
@@ -691,9 +730,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
   // 1 unknown id
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-4", {"instance-4", "host4", 4444, State::Online, Role::Secondary} },
-      { "instance-2", {"", "", 0, State::Online, Role::Primary  } },
-      { "instance-3", {"", "", 0, State::Online, Role::Secondary} },
+      { "instance-4", {"instance-4", "host4", 4444, State::Online, Role::Secondary, 0, ""} },
+      { "instance-2", {"", "", 0, State::Online, Role::Primary,   0, ""} },
+      { "instance-3", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::Unavailable, servers_in_metadata.at(0).mode);
@@ -706,9 +745,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
   // 2 unknown ids
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-4", {"", "", 0, State::Online, Role::Secondary} },
-      { "instance-2", {"", "", 0, State::Online, Role::Primary  } },
-      { "instance-5", {"", "", 0, State::Online, Role::Secondary} },
+      { "instance-4", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "instance-2", {"", "", 0, State::Online, Role::Primary,   0, ""} },
+      { "instance-5", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::Unavailable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::Unavailable, servers_in_metadata.at(0).mode);
@@ -723,11 +762,11 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
   // more nodes than expected
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online, Role::Primary  } },
-      { "instance-2", {"", "", 0, State::Online, Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Online, Role::Secondary} },
-      { "instance-4", {"", "", 0, State::Online, Role::Primary  } },
-      { "instance-5", {"", "", 0, State::Online, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Online, Role::Primary,   0, ""} },
+      { "instance-2", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "instance-4", {"", "", 0, State::Online, Role::Primary,   0, ""} },
+      { "instance-5", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -750,9 +789,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_3NodeSetup) {
 TEST_F(MetadataTest, CheckReplicasetStatus_VariableNodeSetup) {
 
   std::map<std::string, GroupReplicationMember> server_status {
-    { "instance-1", {"", "", 0, State::Online, Role::Primary  } },
-    { "instance-2", {"", "", 0, State::Online, Role::Secondary} },
-    { "instance-3", {"", "", 0, State::Online, Role::Secondary} },
+    { "instance-1", {"", "", 0, State::Online, Role::Primary,   0, ""} },
+    { "instance-2", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+    { "instance-3", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
   };
 
   // Next 2 scenarios test situation in which the status report (view) contains
@@ -764,13 +803,13 @@ TEST_F(MetadataTest, CheckReplicasetStatus_VariableNodeSetup) {
   {
     std::vector<ManagedInstance> servers_in_metadata {
       // ServerMode doesn't matter ------vvvvvvvvvvv
-      {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-      {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-      {"", "instance-3", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-      {"", "instance-4", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-      {"", "instance-5", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-      {"", "instance-6", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-      {"", "instance-7", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
+      {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+      {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+      {"", "instance-3", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+      {"", "instance-4", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+      {"", "instance-5", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+      {"", "instance-6", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+      {"", "instance-7", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -783,10 +822,10 @@ TEST_F(MetadataTest, CheckReplicasetStatus_VariableNodeSetup) {
   // 4-node setup according to metadata
   {
     std::vector<ManagedInstance> servers_in_metadata {
-      {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-      {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-      {"", "instance-3", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-      {"", "instance-4", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
+      {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+      {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+      {"", "instance-3", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+      {"", "instance-4", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -808,8 +847,8 @@ TEST_F(MetadataTest, CheckReplicasetStatus_VariableNodeSetup) {
   // 2-node setup according to metadata -> quorum requires 3 nodes, 2 nodes count
   {
     std::vector<ManagedInstance> servers_in_metadata {
-      {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-      {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
+      {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+      {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -820,7 +859,7 @@ TEST_F(MetadataTest, CheckReplicasetStatus_VariableNodeSetup) {
   // 1-node setup according to metadata -> quorum requires 3 nodes, 1 node counts
   {
     std::vector<ManagedInstance> servers_in_metadata {
-      {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
+      {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
     };
     EXPECT_EQ(RS::Unavailable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -852,9 +891,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_VariousStatuses) {
 
   std::vector<ManagedInstance> servers_in_metadata {
     // ServerMode doesn't matter ------vvvvvvvvvvv
-    {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "instance-3", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
+    {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "instance-3", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
   };
 
   for (State state : {State::Offline, State::Error, State::Unreachable, State::Other}) {
@@ -862,9 +901,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_VariousStatuses) {
     // should keep quorum
     {
       std::map<std::string, GroupReplicationMember> server_status {
-        { "instance-1", {"", "", 0, State::Online,  Role::Primary  } },
-        { "instance-2", {"", "", 0, State::Online,  Role::Secondary} },
-        { "instance-3", {"", "", 0, state,          Role::Secondary} },
+        { "instance-1", {"", "", 0, State::Online,  Role::Primary,   0, ""} },
+        { "instance-2", {"", "", 0, State::Online,  Role::Secondary, 0, ""} },
+        { "instance-3", {"", "", 0, state,          Role::Secondary, 0, ""} },
       };
       EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
       EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -875,9 +914,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_VariousStatuses) {
     // should keep quorum
     {
       std::map<std::string, GroupReplicationMember> server_status {
-        { "instance-1", {"", "", 0, State::Online,  Role::Secondary} },
-        { "instance-2", {"", "", 0, State::Online,  Role::Secondary} },
-        { "instance-3", {"", "", 0, state,          Role::Secondary} },
+        { "instance-1", {"", "", 0, State::Online,  Role::Secondary, 0, ""} },
+        { "instance-2", {"", "", 0, State::Online,  Role::Secondary, 0, ""} },
+        { "instance-3", {"", "", 0, state,          Role::Secondary, 0, ""} },
       };
       EXPECT_EQ(RS::AvailableReadOnly, metadata.check_replicaset_status(servers_in_metadata, server_status));
       EXPECT_EQ(ServerMode::ReadOnly,    servers_in_metadata.at(0).mode);
@@ -888,9 +927,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_VariousStatuses) {
     // should lose quorum
     {
       std::map<std::string, GroupReplicationMember> server_status {
-        { "instance-1", {"", "", 0, State::Online,  Role::Primary  } },
-        { "instance-2", {"", "", 0, state,          Role::Secondary} },
-        { "instance-3", {"", "", 0, state,          Role::Secondary} },
+        { "instance-1", {"", "", 0, State::Online,  Role::Primary,   0, ""} },
+        { "instance-2", {"", "", 0, state,          Role::Secondary, 0, ""} },
+        { "instance-3", {"", "", 0, state,          Role::Secondary, 0, ""} },
       };
       EXPECT_EQ(RS::Unavailable, metadata.check_replicaset_status(servers_in_metadata, server_status));
       EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -915,9 +954,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
 
   std::vector<ManagedInstance> servers_in_metadata {
     // ServerMode doesn't matter ------vvvvvvvvvvv
-    {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "instance-3", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
+    {"", "instance-1", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "instance-2", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "instance-3", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
   };
 
 
@@ -925,9 +964,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
   // 1 node recovering, 1 RW, 1 RO
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online,     Role::Primary  } },
-      { "instance-2", {"", "", 0, State::Online,     Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Online,     Role::Primary,   0, ""} },
+      { "instance-2", {"", "", 0, State::Online,     Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -938,9 +977,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
   // 1 node recovering, 1 offline, 1 RW
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online,     Role::Primary  } },
-      { "instance-2", {"", "", 0, State::Error,      Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Online,     Role::Primary,   0, ""} },
+      { "instance-2", {"", "", 0, State::Error,      Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -951,9 +990,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
   // 1 node recovering, 1 offline, 1 RO
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online,     Role::Secondary} },
-      { "instance-2", {"", "", 0, State::Error,      Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Online,     Role::Secondary, 0, ""} },
+      { "instance-2", {"", "", 0, State::Error,      Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableReadOnly, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadOnly,    servers_in_metadata.at(0).mode);
@@ -964,9 +1003,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
   // 1 node recovering, 2 offline
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Error,      Role::Secondary} },
-      { "instance-2", {"", "", 0, State::Error,      Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Error,      Role::Secondary, 0, ""} },
+      { "instance-2", {"", "", 0, State::Error,      Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::Unavailable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::Unavailable, servers_in_metadata.at(0).mode);
@@ -977,8 +1016,8 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
   // 1 node recovering, 1 offline, 1 left replicaset
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-2", {"", "", 0, State::Error,      Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary} },
+      { "instance-2", {"", "", 0, State::Error,      Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::Unavailable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::Unavailable, servers_in_metadata.at(0).mode);
@@ -988,7 +1027,7 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
   // 1 node recovering, 2 left replicaset
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary} },
+      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::UnavailableRecovering, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::Unavailable, servers_in_metadata.at(0).mode);
@@ -999,9 +1038,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
   // 2 nodes recovering, 1 RW
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online,     Role::Primary  } },
-      { "instance-2", {"", "", 0, State::Recovering, Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Online,     Role::Primary,   0, ""} },
+      { "instance-2", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableWritable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadWrite,   servers_in_metadata.at(0).mode);
@@ -1012,9 +1051,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
   // 2 nodes recovering, 1 RO
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Online,     Role::Secondary} },
-      { "instance-2", {"", "", 0, State::Recovering, Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Online,     Role::Secondary, 0, ""} },
+      { "instance-2", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::AvailableReadOnly, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::ReadOnly,    servers_in_metadata.at(0).mode);
@@ -1025,9 +1064,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
   // 2 nodes recovering, 1 offline
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Error,      Role::Secondary} },
-      { "instance-2", {"", "", 0, State::Recovering, Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Error,      Role::Secondary, 0, ""} },
+      { "instance-2", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::UnavailableRecovering, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::Unavailable, servers_in_metadata.at(0).mode);
@@ -1038,8 +1077,8 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
   // 2 nodes recovering, 1 left replicaset
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-2", {"", "", 0, State::Recovering, Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary} },
+      { "instance-2", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::UnavailableRecovering, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::Unavailable, servers_in_metadata.at(0).mode);
@@ -1051,9 +1090,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Recovering) {
   // 3 nodes recovering
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "instance-1", {"", "", 0, State::Recovering, Role::Secondary} },
-      { "instance-2", {"", "", 0, State::Recovering, Role::Secondary} },
-      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary} },
+      { "instance-1", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
+      { "instance-2", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
+      { "instance-3", {"", "", 0, State::Recovering, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::UnavailableRecovering, metadata.check_replicaset_status(servers_in_metadata, server_status));
     EXPECT_EQ(ServerMode::Unavailable, servers_in_metadata.at(0).mode);
@@ -1082,9 +1121,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Cornercase2of5Alive) {
 
   // MD defines 3 nodes
   std::vector<ManagedInstance> servers_in_metadata {
-    {"", "node-A", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "node-B", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "node-C", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
+    {"", "node-A", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "node-B", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "node-C", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
   };
 
   // GR reports 5 nodes, of which only 2 are alive (no qourum), BUT from
@@ -1092,11 +1131,11 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Cornercase2of5Alive) {
   // We choose to be pessimistic (no quorum)
   for (State dead_state : {State::Offline, State::Error, State::Unreachable, State::Other}) {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "node-A", {"", "", 0, State::Online, Role::Primary  } },
-      { "node-B", {"", "", 0, State::Online, Role::Secondary} },
-      { "node-C", {"", "", 0, dead_state, Role::Secondary} },
-      { "node-D", {"", "", 0, dead_state, Role::Secondary} },
-      { "node-E", {"", "", 0, dead_state, Role::Secondary} },
+      { "node-A", {"", "", 0, State::Online, Role::Primary,   0, ""} },
+      { "node-B", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "node-C", {"", "", 0, dead_state, Role::Secondary, 0, ""} },
+      { "node-D", {"", "", 0, dead_state, Role::Secondary, 0, ""} },
+      { "node-E", {"", "", 0, dead_state, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::Unavailable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     // should log error "Member <host>:<port> (node-D) found in replicaset, yet is not defined in metadata!"
@@ -1150,9 +1189,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Cornercase3of5Alive) {
 
   // MD defines 3 nodes
   std::vector<ManagedInstance> servers_in_metadata {
-    {"", "node-A", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "node-B", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "node-C", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
+    {"", "node-A", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "node-B", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "node-C", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
   };
 
   // GR reports 5 nodes, of which 3 are alive (have qourum), BUT from
@@ -1160,11 +1199,11 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Cornercase3of5Alive) {
   // We choose to be pessimistic (no quorum)
   for (State dead_state : {State::Offline, State::Error, State::Unreachable, State::Other}) {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "node-A", {"", "", 0, dead_state, Role::Primary  } },
-      { "node-B", {"", "", 0, dead_state, Role::Secondary} },
-      { "node-C", {"", "", 0, State::Online, Role::Secondary} },
-      { "node-D", {"", "", 0, State::Online, Role::Secondary} },
-      { "node-E", {"", "", 0, State::Online, Role::Secondary} },
+      { "node-A", {"", "", 0, dead_state, Role::Primary,   0, ""} },
+      { "node-B", {"", "", 0, dead_state, Role::Secondary, 0, ""} },
+      { "node-C", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "node-D", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "node-E", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::Unavailable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     // should log error "Member <host>:<port> (node-D) found in replicaset, yet is not defined in metadata!"
@@ -1217,9 +1256,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Cornercase1Common) {
 
   // MD defines 3 nodes
   std::vector<ManagedInstance> servers_in_metadata {
-    {"", "node-A", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "node-B", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
-    {"", "node-C", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0},
+    {"", "node-A", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "node-B", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
+    {"", "node-C", "", ServerMode::Unavailable, 0, 0, "", "", 0, 0, 0},
   };
 
   // GR reports 3 nodes, of which 3 are alive (have qourum), BUT from
@@ -1227,9 +1266,9 @@ TEST_F(MetadataTest, CheckReplicasetStatus_Cornercase1Common) {
   // We choose to be pessimistic (no quorum)
   {
     std::map<std::string, GroupReplicationMember> server_status {
-      { "node-C", {"", "", 0, State::Online, Role::Primary  } },
-      { "node-D", {"", "", 0, State::Online, Role::Secondary} },
-      { "node-E", {"", "", 0, State::Online, Role::Secondary} },
+      { "node-C", {"", "", 0, State::Online, Role::Primary,   0, ""} },
+      { "node-D", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
+      { "node-E", {"", "", 0, State::Online, Role::Secondary, 0, ""} },
     };
     EXPECT_EQ(RS::Unavailable, metadata.check_replicaset_status(servers_in_metadata, server_status));
     // should log warning "Member <host>:<port> (node-A) defined in metadata not found in actual replicaset"
@@ -1306,9 +1345,9 @@ TEST_F(MetadataTest, UpdateReplicasetStatus_PrimaryMember_FailConnectOnNode2) {
   metadata.update_replicaset_status("replicaset-1", replicaset);
 
   EXPECT_EQ(3u, replicaset.members.size());
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100}, replicaset.members.at(0)));
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-2", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3320, 33200}, replicaset.members.at(1)));
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-3", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3330, 33300}, replicaset.members.at(2)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100, 0}, replicaset.members.at(0)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-2", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3320, 33200, 0}, replicaset.members.at(1)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-3", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3330, 33300, 0}, replicaset.members.at(2)));
 
   EXPECT_EQ(3, session_factory.create_cnt());          // +2 from new connections to localhost:3320 and :3330
 }
@@ -1402,9 +1441,9 @@ TEST_F(MetadataTest, UpdateReplicasetStatus_PrimaryMember_FailQueryOnNode1) {
 
   // query_status reported back from instance-2
   EXPECT_EQ(3u, replicaset.members.size());
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100}, replicaset.members.at(0)));
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-2", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3320, 33200}, replicaset.members.at(1)));
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-3", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3330, 33300}, replicaset.members.at(2)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100, 0}, replicaset.members.at(0)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-2", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3320, 33200, 0}, replicaset.members.at(1)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-3", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3330, 33300, 0}, replicaset.members.at(2)));
 }
 
 /**
@@ -1510,9 +1549,9 @@ TEST_F(MetadataTest, UpdateReplicasetStatus_Status_FailQueryOnNode1) {
 
   // query_status reported back from instance-1
   EXPECT_EQ(3u, replicaset.members.size());
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100}, replicaset.members.at(0)));
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-2", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3320, 33200}, replicaset.members.at(1)));
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-3", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3330, 33300}, replicaset.members.at(2)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100, 0}, replicaset.members.at(0)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-2", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3320, 33200, 0}, replicaset.members.at(1)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-3", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3330, 33300, 0}, replicaset.members.at(2)));
 }
 
 /**
@@ -1615,13 +1654,50 @@ TEST_F(MetadataTest, UpdateReplicasetStatus_SimpleSunnyDayScenario) {
 
   // query_status reported back from instance-1
   EXPECT_EQ(3u, replicaset.members.size());
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100}, replicaset.members.at(0)));
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-2", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3320, 33200}, replicaset.members.at(1)));
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-3", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3330, 33300}, replicaset.members.at(2)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100, 0}, replicaset.members.at(0)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-2", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3320, 33200, 0}, replicaset.members.at(1)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-3", "", ServerMode::ReadOnly,  0, 0, "", "localhost", 3330, 33300, 0}, replicaset.members.at(2)));
 }
 
 
 
+/**
+ * @test
+ * Verify `ClusterMetadata::update_replicaset_status()` stores the replication
+ * lag of the members and does not fail if the server can't report it.
+ */
+TEST_F(MetadataTest, UpdateReplicasetStatus_MemberStats) {
+  connect_to_first_metadata_server();
+
+  unsigned session = 0;
+
+  EXPECT_CALL(session_factory.get(session), query(StartsWith(query_primary_member), _)).Times(2)
+    .WillRepeatedly(Invoke(query_primary_member_ok(session)));
+  EXPECT_CALL(session_factory.get(session), query(StartsWith(query_status), _)).Times(2)
+    .WillRepeatedly(Invoke(query_status_ok(session)));
+  EXPECT_CALL(session_factory.get(session), query(StartsWith(query_member_stats), _)).Times(2)
+    .WillOnce(Invoke(query_member_stats_ok(session)))
+    .WillOnce(Invoke(query_member_stats_fail(session)));
+
+  ManagedReplicaSet replicaset = typical_replicaset;
+  metadata.update_replicaset_status("replicaset-1", replicaset);
+
+  ASSERT_EQ(3u, replicaset.members.size());
+  EXPECT_EQ(0u, replicaset.members.at(0).transactions_behind);
+  EXPECT_EQ(250u, replicaset.members.at(1).transactions_behind);
+  EXPECT_EQ(0u, replicaset.members.at(2).transactions_behind);
+  EXPECT_EQ("1540521230:3", replicaset.group_view_id);
+
+  // stats not available, the members are still usable
+  replicaset = typical_replicaset;
+  metadata.update_replicaset_status("replicaset-1", replicaset);
+
+  ASSERT_EQ(3u, replicaset.members.size());
+  EXPECT_EQ(ServerMode::ReadOnly, replicaset.members.at(1).mode);
+  EXPECT_EQ(0u, replicaset.members.at(1).transactions_behind);
+  EXPECT_EQ("", replicaset.group_view_id);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // test ClusterMetadata::fetch_instances()
@@ -1662,9 +1738,9 @@ TEST_F(MetadataTest, FetchInstances_1Replicaset_ok) {
 
   EXPECT_EQ(1u, rs.size());
   EXPECT_EQ(3u, rs.at("replicaset-1").members.size());
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100}, rs.at("replicaset-1").members.at(0)));
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-2", "", ServerMode::ReadOnly, 0, 0, "", "localhost", 3320, 33200}, rs.at("replicaset-1").members.at(1)));
-  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-3", "", ServerMode::ReadOnly, 0, 0, "", "localhost", 3330, 33300}, rs.at("replicaset-1").members.at(2)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100, 0}, rs.at("replicaset-1").members.at(0)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-2", "", ServerMode::ReadOnly, 0, 0, "", "localhost", 3320, 33200, 0}, rs.at("replicaset-1").members.at(1)));
+  EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-3", "", ServerMode::ReadOnly, 0, 0, "", "localhost", 3330, 33300, 0}, rs.at("replicaset-1").members.at(2)));
 }
 
 /**
@@ -1702,6 +1778,48 @@ TEST_F(MetadataTest, FetchInstances_1Replicaset_fail) {
   EXPECT_EQ(0u, rs.at("replicaset-1").members.size());
 }
 
+/**
+ * @test
+ * Verify `ClusterMetadata::fetch_instances()` only queries the metadata again
+ * when the GR view has changed.
+ */
+TEST_F(MetadataTest, FetchInstances_ReuseMetadataWhileViewUnchanged) {
+
+  connect_to_first_metadata_server();
+
+  // all requests go to existing connection to instance-1 (shared with metadata server)
+  unsigned session = 0;
+
+  auto resultset_metadata = [this](const std::string&, const MySQLSession::RowProcessor& processor) {
+    session_factory.get(0).query_impl(processor, {
+      {"replicaset-1", "instance-1", "HA", NULL, NULL, "blabla", "localhost:3310", NULL},
+      {"replicaset-1", "instance-2", "HA", NULL, NULL, "blabla", "localhost:3320", NULL},
+      {"replicaset-1", "instance-3", "HA", NULL, NULL, "blabla", "localhost:3330", NULL},
+    });
+  };
+  // 1st fetch: metadata, 2nd: view unchanged, 3rd: view changed -> metadata again
+  EXPECT_CALL(session_factory.get(session), query(StartsWith(query_metadata), _)).Times(2)
+    .WillRepeatedly(Invoke(resultset_metadata));
+  EXPECT_CALL(session_factory.get(session), query(StartsWith(query_primary_member), _)).Times(4)
+    .WillRepeatedly(Invoke(query_primary_member_ok(session)));
+  EXPECT_CALL(session_factory.get(session), query(StartsWith(query_status), _)).Times(4)
+    .WillRepeatedly(Invoke(query_status_ok(session)));
+  EXPECT_CALL(session_factory.get(session), query(StartsWith(query_member_stats), _)).Times(4)
+    .WillOnce(Invoke(query_member_stats_view(session, "1540521230:3")))
+    .WillOnce(Invoke(query_member_stats_view(session, "1540521230:3")))
+    .WillRepeatedly(Invoke(query_member_stats_view(session, "1540521230:4")));
+
+  for (int i = 0; i < 3; ++i) {
+    ClusterMetadata::ReplicaSetsByName rs = metadata.fetch_instances("replicaset-1");
+
+    ASSERT_EQ(1u, rs.size());
+    ASSERT_EQ(3u, rs.at("replicaset-1").members.size());
+    EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-1", "", ServerMode::ReadWrite, 0, 0, "", "localhost", 3310, 33100, 0}, rs.at("replicaset-1").members.at(0)));
+    EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-2", "", ServerMode::ReadOnly, 0, 0, "", "localhost", 3320, 33200, 0}, rs.at("replicaset-1").members.at(1)));
+    EXPECT_TRUE(cmp_mi_FI(ManagedInstance{"replicaset-1", "instance-3", "", ServerMode::ReadOnly, 0, 0, "", "localhost", 3330, 33300, 0}, rs.at("replicaset-1").members.at(2)));
+  }
+}
+
 int main(int argc, char *argv[]) {
   init_test_logger();
   ::testing::InitGoogleTest(&argc, argv);
@@ -34,6 +34,7 @@
 #include "metadata_cache.h"
 #include "metadata_factory.h"
 #include "mock_metadata.h"
+#include "mysql/harness/filesystem.h"
 #include "mysql_session_replayer.h"
 #include "tcp_address.h"
 #include "test/helpers.h"
@@ -50,7 +51,14 @@ public:
                       cache({TCPAddress("localhost", 32275)},
                               get_instance("admin", "admin", 1, 1, 1, std::chrono::seconds(10),
                                            mysqlrouter::SSLOptions()),
-                              std::chrono::seconds(10), mysqlrouter::SSLOptions(), "replicaset-1") {}
+                              std::chrono::seconds(10), mysqlrouter::SSLOptions(), "replicaset-1") {
+    // lookups wait for the first refresh of the refresh thread
+    cache.start();
+  }
+
+  ~MetadataCacheTest() override {
+    cache.stop();
+  }
 };
 
 /**
@@ -95,6 +103,13 @@ class MetadataCacheTest2 : public ::testing::Test {
       [](mysqlrouter::MySQLSession*){}   // and don't try deleting it!
     );
     cmeta.reset(new ClusterMetadata("admin", "admin", 1, 1, 1, std::chrono::seconds(10), mysqlrouter::SSLOptions()));
+    tmp_dir = mysql_harness::get_tmp_dir("mdc");
+    snapshot_file = mysql_harness::Path(tmp_dir).join("topology.json").str();
+    topology_files.snapshot = snapshot_file;
+  }
+
+  virtual void TearDown() override {
+    mysql_harness::delete_dir_recursive(tmp_dir);
   }
 
   // make queries on metadata schema return a 3 members replicaset
@@ -127,11 +142,23 @@ class MetadataCacheTest2 : public ::testing::Test {
       {m.string_or_null("uuid-server2"), m.string_or_null("somehost"), m.string_or_null("3001"), m.string_or_null("ONLINE"), m.string_or_null("1")},
       {m.string_or_null("uuid-server3"), m.string_or_null("somehost"), m.string_or_null("3002"), m.string_or_null("ONLINE"), m.string_or_null("1")}
     });
+
+    // no view id: metadata is fetched again on every refresh
+    m.expect_query("SELECT member_id, COUNT_TRANSACTIONS_REMOTE_IN_APPLIER_QUEUE, view_id FROM performance_schema.replication_group_member_stats WHERE channel_name = 'group_replication_applier'");
+    m.then_return(3, {
+      // member_id, COUNT_TRANSACTIONS_REMOTE_IN_APPLIER_QUEUE, view_id
+      {m.string_or_null("uuid-server1"), m.string_or_null("0"), m.string_or_null()},
+      {m.string_or_null("uuid-server2"), m.string_or_null("42"), m.string_or_null()},
+      {m.string_or_null("uuid-server3"), m.string_or_null("0"), m.string_or_null()}
+    });
   }
 
   std::shared_ptr<MySQLSessionReplayer> session;
   std::shared_ptr<ClusterMetadata> cmeta;
   std::shared_ptr<MetadataCache> cache;
+  std::string tmp_dir;
+  std::string snapshot_file;
+  metadata_cache::TopologyFiles topology_files;
 
   std::vector<TCPAddress> metadata_servers {
     {"localhost", 3000},
@@ -147,6 +174,7 @@ void expect_cluster_routable(MetadataCache& mc) {
   EXPECT_EQ(metadata_cache::ServerMode::ReadWrite, instances[0].mode);
   EXPECT_EQ("uuid-server2", instances[1].mysql_server_uuid);
   EXPECT_EQ(metadata_cache::ServerMode::ReadOnly, instances[1].mode);
+  EXPECT_EQ(42u, instances[1].transactions_behind);
   EXPECT_EQ("uuid-server3", instances[2].mysql_server_uuid);
   EXPECT_EQ(metadata_cache::ServerMode::ReadOnly, instances[2].mode);
 }
@@ -162,6 +190,7 @@ TEST_F(MetadataCacheTest2, basic_test) {
   expect_sql_metadata();
   expect_sql_members();
   MetadataCache mc(metadata_servers, cmeta, std::chrono::seconds(10), mysqlrouter::SSLOptions(), "cluster-1");
+  mc.refresh();
 
   // verify that cluster can be seen
   expect_cluster_routable(mc);
@@ -190,6 +219,7 @@ TEST_F(MetadataCacheTest2, metadata_server_connection_failures) {
   expect_sql_metadata();
   expect_sql_members();
   MetadataCache mc(metadata_servers, cmeta, std::chrono::seconds(10), mysqlrouter::SSLOptions(), "cluster-1");
+  mc.refresh();
   expect_cluster_routable(mc);
 
   // refresh: fail connecting to first metadata server
@@ -215,6 +245,136 @@ TEST_F(MetadataCacheTest2, metadata_server_connection_failures) {
   expect_cluster_routable(mc); // lookup should see the cluster again
 }
 
+TEST_F(MetadataCacheTest2, topology_snapshot) {
+  MySQLSessionReplayer& m = *session;
+
+  // no snapshot yet: nothing to route to until the first refresh
+  {
+    MetadataCache mc(metadata_servers, cmeta, std::chrono::seconds(10), mysqlrouter::SSLOptions(),
+                     "cluster-1", mysql_harness::kDefaultStackSizeInKiloBytes, topology_files);
+    expect_cluster_not_routable(mc);
+
+    expect_sql_metadata();
+    expect_sql_members();
+    mc.refresh();
+    expect_cluster_routable(mc);
+  }
+  ASSERT_TRUE(mysql_harness::Path(snapshot_file).is_regular());
+  ASSERT_FALSE(mysql_harness::Path(snapshot_file + ".tmp").exists());
+
+  // restart: the topology is known before reaching any metadata server
+  MetadataCache mc(metadata_servers, cmeta, std::chrono::seconds(10), mysqlrouter::SSLOptions(),
+                   "cluster-1", mysql_harness::kDefaultStackSizeInKiloBytes, topology_files);
+  std::vector<ManagedInstance> instances = mc.replicaset_lookup("cluster-1");
+  ASSERT_EQ(3U, instances.size());
+  EXPECT_EQ("uuid-server1", instances[0].mysql_server_uuid);
+  EXPECT_EQ(metadata_cache::ServerMode::ReadWrite, instances[0].mode);
+  EXPECT_EQ("localhost", instances[0].host);
+  EXPECT_EQ(3000u, instances[0].port);
+  EXPECT_EQ(30000u, instances[0].xport);
+  EXPECT_EQ(metadata_cache::ServerMode::ReadOnly, instances[1].mode);
+  EXPECT_EQ(0u, instances[1].transactions_behind);  // not kept in the snapshot
+  EXPECT_EQ(metadata_cache::ServerMode::ReadOnly, instances[2].mode);
+
+  // all metadata servers down: the snapshot is kept
+  m.expect_connect("127.0.0.1", 3000, "admin", "admin", "").then_error("some fake bad connection message", 66);
+  m.expect_connect("127.0.0.1", 3001, "admin", "admin", "").then_error("some fake bad connection message", 66);
+  m.expect_connect("127.0.0.1", 3002, "admin", "admin", "").then_error("some fake bad connection message", 66);
+  mc.refresh();
+  EXPECT_EQ(3U, mc.replicaset_lookup("cluster-1").size());
+
+  // the live topology replaces the snapshot
+  expect_sql_metadata();
+  expect_sql_members();
+  mc.refresh();
+  expect_cluster_routable(mc);
+
+  // metadata servers down again: cleared as a precaution as usual
+  m.expect_connect("127.0.0.1", 3000, "admin", "admin", "").then_error("some fake bad connection message", 66);
+  m.expect_connect("127.0.0.1", 3001, "admin", "admin", "").then_error("some fake bad connection message", 66);
+  m.expect_connect("127.0.0.1", 3002, "admin", "admin", "").then_error("some fake bad connection message", 66);
+  mc.refresh();
+  expect_cluster_not_routable(mc);
+}
+
+TEST_F(MetadataCacheTest2, topology_snapshot_of_other_cluster) {
+  {
+    MetadataCache mc(metadata_servers, cmeta, std::chrono::seconds(10), mysqlrouter::SSLOptions(),
+                     "cluster-1", mysql_harness::kDefaultStackSizeInKiloBytes, topology_files);
+    expect_sql_metadata();
+    expect_sql_members();
+    mc.refresh();
+    expect_cluster_routable(mc);
+  }
+
+  // the snapshot is ignored if the configured cluster has changed
+  MetadataCache mc(metadata_servers, cmeta, std::chrono::seconds(10), mysqlrouter::SSLOptions(),
+                   "cluster-2", mysql_harness::kDefaultStackSizeInKiloBytes, topology_files);
+  expect_cluster_not_routable(mc);
+}
+
+#ifndef _WIN32
+TEST_F(MetadataCacheTest2, shared_topology_subscriber) {
+  metadata_cache::TopologyFiles files;
+  files.shared = mysql_harness::Path(tmp_dir).join("shared_topology").str();
+
+  // another router on the host refreshes and publishes the routing table
+  MetadataCache publisher(metadata_servers, cmeta, std::chrono::seconds(10), mysqlrouter::SSLOptions(),
+                          "cluster-1", mysql_harness::kDefaultStackSizeInKiloBytes, files);
+  ASSERT_TRUE(publisher.shared_topology_ != nullptr);
+  ASSERT_TRUE(publisher.shared_topology_->try_become_publisher());
+  expect_sql_metadata();
+  expect_sql_members();
+  publisher.refresh();
+  publisher.publish_shared_topology();
+
+  // this one takes it over without querying the metadata servers
+  MetadataCache mc(metadata_servers, cmeta, std::chrono::seconds(10), mysqlrouter::SSLOptions(),
+                   "cluster-1", mysql_harness::kDefaultStackSizeInKiloBytes, files);
+  ASSERT_TRUE(mc.shared_topology_ != nullptr);
+  EXPECT_FALSE(mc.shared_topology_->try_become_publisher());
+  mc.follow_shared_topology();
+  expect_cluster_routable(mc);
+  EXPECT_EQ(1u, mc.shared_topology_version_);
+
+  // metadata servers down: the publisher clears the routing table
+  MySQLSessionReplayer& m = *session;
+  m.expect_connect("127.0.0.1", 3000, "admin", "admin", "").then_error("some fake bad connection message", 66);
+  m.expect_connect("127.0.0.1", 3001, "admin", "admin", "").then_error("some fake bad connection message", 66);
+  m.expect_connect("127.0.0.1", 3002, "admin", "admin", "").then_error("some fake bad connection message", 66);
+  publisher.refresh();
+  publisher.publish_shared_topology();
+  mc.follow_shared_topology();
+  expect_cluster_not_routable(mc);
+  EXPECT_EQ(2u, mc.shared_topology_version_);
+
+  // the publisher stops: the subscriber takes over
+  publisher.stop();
+  EXPECT_TRUE(mc.shared_topology_->try_become_publisher());
+}
+
+TEST_F(MetadataCacheTest2, shared_topology_without_publication) {
+  metadata_cache::TopologyFiles files;
+  files.shared = mysql_harness::Path(tmp_dir).join("shared_topology").str();
+
+  // another router holds the lock, but doesn't publish anything
+  SharedTopology stuck_publisher(files.shared);
+  ASSERT_TRUE(stuck_publisher.try_become_publisher());
+
+  // lookups wait for the publisher only that long, then the subscriber
+  // refreshes itself
+  MetadataCache mc(metadata_servers, cmeta, std::chrono::seconds(10), mysqlrouter::SSLOptions(),
+                   "cluster-1", mysql_harness::kDefaultStackSizeInKiloBytes, files);
+  mc.shared_topology_max_wait_ = std::chrono::milliseconds(200);
+  expect_sql_metadata();
+  expect_sql_members();
+  mc.start();
+  expect_cluster_routable(mc);
+  EXPECT_FALSE(mc.shared_topology_->is_publisher());
+  mc.stop();
+}
+#endif
+
 int main(int argc, char *argv[]) {
   init_test_logger();
   ::testing::InitGoogleTest(&argc, argv);
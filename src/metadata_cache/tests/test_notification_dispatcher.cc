@@ -0,0 +1,175 @@
+/*
+  Copyright (c) 2016, 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+/**
+ * Test the dispatching of routing table changes to the listeners.
+ */
+
+#include "gmock/gmock.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "notification_dispatcher.h"
+#include "test/helpers.h"
+
+using metadata_cache::LookupResult;
+using metadata_cache::ManagedInstance;
+using metadata_cache::ManagedReplicaSet;
+
+// records the notifications, can hold up the dispatcher in notify()
+class RecordingListener : public metadata_cache::ReplicasetStateListenerInterface {
+ public:
+  void notify(const LookupResult &instances, const bool md_servers_reachable) noexcept override {
+    std::unique_lock<std::mutex> lock(mtx_);
+    ++notified_;
+    last_size_ = instances.instance_vector.size();
+    last_md_servers_reachable_ = md_servers_reachable;
+    cond_.notify_all();
+    cond_.wait(lock, [this] { return !blocked_; });
+  }
+
+  void block() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    blocked_ = true;
+  }
+
+  void unblock() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    blocked_ = false;
+    cond_.notify_all();
+  }
+
+  bool wait_notified(unsigned count) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    return cond_.wait_for(lock, std::chrono::seconds(10),
+                          [this, count] { return notified_ >= count; });
+  }
+
+  unsigned notified() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return notified_;
+  }
+
+  size_t last_size() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return last_size_;
+  }
+
+  bool last_md_servers_reachable() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return last_md_servers_reachable_;
+  }
+
+ private:
+  std::mutex mtx_;
+  std::condition_variable cond_;
+  unsigned notified_ = 0;
+  size_t last_size_ = 0;
+  bool last_md_servers_reachable_ = false;
+  bool blocked_ = false;
+};
+
+static NotificationDispatcher::ReplicaSets make_replicasets(size_t members) {
+  ManagedReplicaSet rs;
+  rs.name = "replicaset-1";
+  for (size_t i = 0; i < members; ++i) {
+    ManagedInstance mi;
+    mi.replicaset_name = rs.name;
+    mi.mysql_server_uuid = "uuid-" + std::to_string(i);
+    rs.members.push_back(mi);
+  }
+  return std::make_shared<const MetaData::ReplicaSetsByName>(
+      MetaData::ReplicaSetsByName{{rs.name, rs}});
+}
+
+TEST(NotificationDispatcherTest, InlineUntilStarted) {
+  NotificationDispatcher dispatcher;
+  RecordingListener listener;
+  RecordingListener other_listener;
+  dispatcher.add_listener("replicaset-1", &listener);
+  dispatcher.add_listener("replicaset-2", &other_listener);
+
+  dispatcher.post(make_replicasets(3), true);
+  EXPECT_EQ(1u, listener.notified());
+  EXPECT_EQ(3u, listener.last_size());
+  EXPECT_TRUE(listener.last_md_servers_reachable());
+
+  // a replicaset missing from the routing table has no instances
+  EXPECT_EQ(1u, other_listener.notified());
+  EXPECT_EQ(0u, other_listener.last_size());
+}
+
+TEST(NotificationDispatcherTest, CoalesceWhileListenerBusy) {
+  NotificationDispatcher dispatcher;
+  RecordingListener listener;
+  dispatcher.add_listener("replicaset-1", &listener);
+  dispatcher.start();
+
+  // the poster doesn't wait for the listener
+  listener.block();
+  dispatcher.post(make_replicasets(1), true);
+  ASSERT_TRUE(listener.wait_notified(1));
+
+  dispatcher.post(make_replicasets(2), true);
+  dispatcher.post(make_replicasets(3), false);
+  dispatcher.post(make_replicasets(0), false);
+  EXPECT_EQ(1u, listener.notified());
+
+  // only the last of the changes made while busy is dispatched
+  listener.unblock();
+  ASSERT_TRUE(listener.wait_notified(2));
+  dispatcher.stop();
+  EXPECT_EQ(2u, listener.notified());
+  EXPECT_EQ(0u, listener.last_size());
+  EXPECT_FALSE(listener.last_md_servers_reachable());
+  EXPECT_EQ(2u, dispatcher.coalesced_count());
+}
+
+TEST(NotificationDispatcherTest, RemovedListener) {
+  NotificationDispatcher dispatcher;
+  RecordingListener listener;
+  RecordingListener other_listener;
+  dispatcher.add_listener("replicaset-1", &listener);
+  dispatcher.add_listener("replicaset-1", &other_listener);
+  dispatcher.start();
+
+  dispatcher.post(make_replicasets(3), true);
+  ASSERT_TRUE(listener.wait_notified(1));
+  ASSERT_TRUE(other_listener.wait_notified(1));
+
+  dispatcher.remove_listener("replicaset-1", &listener);
+  dispatcher.post(make_replicasets(2), true);
+  ASSERT_TRUE(other_listener.wait_notified(2));
+  dispatcher.stop();
+  EXPECT_EQ(1u, listener.notified());
+}
+
+int main(int argc, char *argv[]) {
+  init_test_logger();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,141 @@
+/*
+  Copyright (c) 2016, 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+/**
+ * Test the scheduling of metadata cache refreshes.
+ */
+
+#include "gmock/gmock.h"
+
+#include <set>
+
+#include "refresh_scheduler.h"
+#include "test/helpers.h"
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+static const milliseconds kMs(1);
+
+TEST(RefreshSchedulerTest, JitterAroundTTL) {
+  RefreshScheduler scheduler(seconds(10), 1);
+  scheduler.record_refresh(milliseconds(5), true);
+
+  std::set<milliseconds::rep> intervals;
+  for (int i = 0; i < 100; ++i) {
+    const milliseconds interval = scheduler.next_interval(false);
+    EXPECT_GE(interval, milliseconds(9000));
+    EXPECT_LE(interval, milliseconds(11000));
+    intervals.insert(interval.count());
+  }
+  // routers don't refresh in lockstep
+  EXPECT_GT(intervals.size(), 50u);
+}
+
+TEST(RefreshSchedulerTest, DifferentSeeds) {
+  RefreshScheduler first(seconds(10), 1);
+  RefreshScheduler second(seconds(10), 2);
+
+  bool differ = false;
+  for (int i = 0; i < 10; ++i) {
+    differ |= first.next_interval(false) != second.next_interval(false);
+  }
+  EXPECT_TRUE(differ);
+}
+
+TEST(RefreshSchedulerTest, BackoffOnFailures) {
+  RefreshScheduler scheduler(seconds(1), 1);
+
+  // the first retry is not delayed
+  scheduler.record_refresh(kMs, false);
+  EXPECT_LE(scheduler.next_interval(false), milliseconds(1100));
+
+  scheduler.record_refresh(kMs, false);
+  EXPECT_GE(scheduler.next_interval(false), milliseconds(1800));
+  EXPECT_LE(scheduler.next_interval(false), milliseconds(2200));
+
+  scheduler.record_refresh(kMs, false);
+  EXPECT_GE(scheduler.next_interval(false), milliseconds(3600));
+  EXPECT_LE(scheduler.next_interval(false), milliseconds(4400));
+
+  // up to the maximum, even in emergency mode
+  for (int i = 0; i < 20; ++i) {
+    scheduler.record_refresh(kMs, false);
+  }
+  EXPECT_GE(scheduler.next_interval(false), milliseconds(9000));
+  EXPECT_LE(scheduler.next_interval(false), milliseconds(11000));
+  EXPECT_GE(scheduler.next_interval(true), milliseconds(9000));
+
+  // back to TTL after a success
+  scheduler.record_refresh(kMs, true);
+  EXPECT_LE(scheduler.next_interval(false), milliseconds(1100));
+
+  const auto stats = scheduler.get_stats();
+  EXPECT_EQ(24u, stats.refreshes);
+  EXPECT_EQ(23u, stats.failed);
+  EXPECT_EQ(1u, stats.skipped);
+}
+
+TEST(RefreshSchedulerTest, EmergencyMode) {
+  RefreshScheduler scheduler(seconds(300), 1);
+
+  scheduler.record_refresh(milliseconds(20), true);
+  EXPECT_GE(scheduler.next_interval(true), milliseconds(900));
+  EXPECT_LE(scheduler.next_interval(true), milliseconds(1100));
+  EXPECT_EQ(0u, scheduler.get_stats().skipped);
+
+  // a slow metadata server is not queried faster on top
+  scheduler.record_refresh(milliseconds(500), true);
+  EXPECT_GE(scheduler.next_interval(true), milliseconds(4500));
+  EXPECT_LE(scheduler.next_interval(true), milliseconds(5500));
+  EXPECT_EQ(2u, scheduler.get_stats().skipped);
+
+  // but not slower than without emergency mode
+  RefreshScheduler short_ttl(milliseconds(500), 1);
+  short_ttl.record_refresh(milliseconds(500), true);
+  EXPECT_LE(short_ttl.next_interval(true), milliseconds(550));
+  EXPECT_EQ(0u, short_ttl.get_stats().skipped);
+}
+
+TEST(RefreshSchedulerTest, RefreshTime) {
+  RefreshScheduler scheduler(seconds(1), 1);
+
+  scheduler.record_refresh(milliseconds(3), true);
+  scheduler.record_refresh(milliseconds(7), false);
+  scheduler.record_refresh(milliseconds(2), true);
+
+  const auto stats = scheduler.get_stats();
+  EXPECT_EQ(3u, stats.refreshes);
+  EXPECT_EQ(1u, stats.failed);
+  EXPECT_EQ(std::chrono::microseconds(2000), stats.last_time);
+  EXPECT_EQ(std::chrono::microseconds(7000), stats.max_time);
+  EXPECT_EQ(std::chrono::microseconds(12000), stats.total_time);
+}
+
+int main(int argc, char *argv[]) {
+  init_test_logger();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,219 @@
+/*
+  Copyright (c) 2016, 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+/**
+ * Test the routing table shared between routers through a file.
+ */
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+#include "gmock/gmock.h"
+
+#include "mysql/harness/filesystem.h"
+#include "shared_topology.h"
+#include "test/helpers.h"
+
+using metadata_cache::ManagedInstance;
+using metadata_cache::ManagedReplicaSet;
+using metadata_cache::ServerMode;
+
+#ifndef _WIN32
+
+class SharedTopologyTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tmp_dir = mysql_harness::get_tmp_dir("shared_topology");
+    path = mysql_harness::Path(tmp_dir).join("topology").str();
+  }
+
+  void TearDown() override {
+    mysql_harness::delete_dir_recursive(tmp_dir);
+  }
+
+  static MetaData::ReplicaSetsByName make_replicasets(size_t members) {
+    ManagedReplicaSet rs;
+    rs.name = "default";
+    rs.single_primary_mode = true;
+    rs.group_view_id = "15300:7";
+    for (size_t i = 0; i < members; ++i) {
+      ManagedInstance mi;
+      mi.replicaset_name = rs.name;
+      mi.mysql_server_uuid = "uuid-" + std::to_string(i);
+      mi.role = "HA";
+      mi.mode = i == 0 ? ServerMode::ReadWrite : ServerMode::ReadOnly;
+      mi.weight = 1;
+      mi.version_token = 0;
+      mi.location = "";
+      mi.host = "10.0.0." + std::to_string(i);
+      mi.port = 3306;
+      mi.xport = 33060;
+      mi.transactions_behind = i * 10;
+      rs.members.push_back(mi);
+    }
+    return {{rs.name, rs}};
+  }
+
+  std::string tmp_dir;
+  std::string path;
+};
+
+TEST_F(SharedTopologyTest, OnePublisher) {
+  SharedTopology first(path);
+  SharedTopology second(path);
+
+  EXPECT_TRUE(first.try_become_publisher());
+  EXPECT_TRUE(first.try_become_publisher());
+  EXPECT_FALSE(second.try_become_publisher());
+  EXPECT_TRUE(first.is_publisher());
+  EXPECT_FALSE(second.is_publisher());
+}
+
+TEST_F(SharedTopologyTest, NothingPublishedYet) {
+  SharedTopology publisher(path);
+  SharedTopology subscriber(path);
+  ASSERT_TRUE(publisher.try_become_publisher());
+
+  SharedTopology::Publication publication;
+  EXPECT_EQ(0u, subscriber.version());
+  EXPECT_FALSE(subscriber.read(publication));
+}
+
+TEST_F(SharedTopologyTest, PublishAndRead) {
+  SharedTopology publisher(path);
+  SharedTopology subscriber(path);
+  ASSERT_TRUE(publisher.try_become_publisher());
+
+  ASSERT_TRUE(publisher.publish("cluster-1", make_replicasets(3), true));
+  EXPECT_EQ(1u, subscriber.version());
+
+  SharedTopology::Publication publication;
+  ASSERT_TRUE(subscriber.read(publication));
+  EXPECT_EQ(1u, publication.version);
+  EXPECT_EQ("cluster-1", publication.cluster_name);
+  EXPECT_TRUE(publication.md_servers_reachable);
+  ASSERT_EQ(1u, publication.replicasets.size());
+
+  const ManagedReplicaSet &rs = publication.replicasets["default"];
+  EXPECT_EQ("default", rs.name);
+  EXPECT_TRUE(rs.single_primary_mode);
+  EXPECT_EQ("15300:7", rs.group_view_id);
+  ASSERT_EQ(3u, rs.members.size());
+  EXPECT_EQ(make_replicasets(3)["default"].members, rs.members);
+  EXPECT_EQ(ServerMode::ReadWrite, rs.members[0].mode);
+  EXPECT_EQ("10.0.0.2", rs.members[2].host);
+  EXPECT_EQ(20u, rs.members[2].transactions_behind);
+
+  ASSERT_TRUE(publisher.publish("cluster-1", {}, false));
+  EXPECT_EQ(2u, subscriber.version());
+  ASSERT_TRUE(subscriber.read(publication));
+  EXPECT_EQ(2u, publication.version);
+  EXPECT_FALSE(publication.md_servers_reachable);
+  EXPECT_TRUE(publication.replicasets.empty());
+}
+
+TEST_F(SharedTopologyTest, TooLarge) {
+  SharedTopology publisher(path);
+  SharedTopology subscriber(path);
+  ASSERT_TRUE(publisher.try_become_publisher());
+
+  ASSERT_TRUE(publisher.publish("cluster-1", make_replicasets(3), true));
+  EXPECT_FALSE(publisher.publish("cluster-1",
+                                 make_replicasets(SharedTopology::kMaxInstances + 1), true));
+
+  auto replicasets = make_replicasets(3);
+  replicasets["default"].members[0].host = std::string(300, 'h');
+  EXPECT_FALSE(publisher.publish("cluster-1", replicasets, true));
+
+  // the previous publication stays in place
+  SharedTopology::Publication publication;
+  ASSERT_TRUE(subscriber.read(publication));
+  EXPECT_EQ(1u, publication.version);
+  EXPECT_EQ(3u, publication.replicasets["default"].members.size());
+}
+
+TEST_F(SharedTopologyTest, Takeover) {
+  SharedTopology subscriber(path);
+  {
+    SharedTopology publisher(path);
+    ASSERT_TRUE(publisher.try_become_publisher());
+    ASSERT_TRUE(publisher.publish("cluster-1", make_replicasets(2), true));
+    EXPECT_FALSE(subscriber.try_become_publisher());
+  }
+
+  // the lock went away with the publisher, its publication stays
+  ASSERT_TRUE(subscriber.try_become_publisher());
+  EXPECT_EQ(1u, subscriber.version());
+  ASSERT_TRUE(subscriber.publish("cluster-1", make_replicasets(3), true));
+  EXPECT_EQ(2u, subscriber.version());
+}
+
+TEST_F(SharedTopologyTest, PublisherDiedWhileWriting) {
+  SharedTopology subscriber(path);
+  {
+    SharedTopology publisher(path);
+    ASSERT_TRUE(publisher.try_become_publisher());
+    ASSERT_TRUE(publisher.publish("cluster-1", make_replicasets(2), true));
+  }
+
+  // the sequence counter follows the magic and the layout size
+  const uint64_t odd_seq = 3;
+  int fd = open(path.c_str(), O_RDWR);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(odd_seq)), pwrite(fd, &odd_seq, sizeof(odd_seq), 16));
+  close(fd);
+
+  // read() gives up instead of waiting for the publication to complete
+  SharedTopology::Publication publication;
+  EXPECT_FALSE(subscriber.read(publication));
+
+  // the next publisher completes it
+  ASSERT_TRUE(subscriber.try_become_publisher());
+  ASSERT_TRUE(subscriber.publish("cluster-1", make_replicasets(3), true));
+  ASSERT_TRUE(subscriber.read(publication));
+  EXPECT_EQ(3u, publication.replicasets["default"].members.size());
+}
+
+TEST_F(SharedTopologyTest, RefreshRequest) {
+  SharedTopology publisher(path);
+  SharedTopology subscriber(path);
+  ASSERT_TRUE(publisher.try_become_publisher());
+
+  EXPECT_FALSE(publisher.take_refresh_request());
+  subscriber.request_refresh();
+  subscriber.request_refresh();
+  EXPECT_TRUE(publisher.take_refresh_request());
+  EXPECT_FALSE(publisher.take_refresh_request());
+}
+
+#endif
+
+int main(int argc, char *argv[]) {
+  init_test_logger();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
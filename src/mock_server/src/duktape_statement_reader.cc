@@ -27,9 +27,15 @@
 #define NOMINMAX
 #endif
 
-#include <string>
-#include <map>
+#include <cstring>
 #include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
 
 #include "duktape.h"
 #include "duk_logging.h"
@@ -37,6 +43,7 @@
 #include "duktape_statement_reader.h"
 #include "duk_node_fs.h"
 #include "mysql/harness/logging/logging.h"
+#include "mysql/harness/filesystem.h"
 
 IMPORT_LOG_FUNCTIONS()
 
@@ -174,7 +181,8 @@ struct DuktapeStatementReader::Pimpl {
       if (duk_get_number(ctx, -1) > std::numeric_limits<INT_TYPE>::max()) {
         throw std::runtime_error("value out-of-range for field \"" + field  + "\"");
       }
-      value = duk_to_uint(ctx, -1);
+      // duk_to_uint() would truncate to 32bit
+      value = static_cast<INT_TYPE>(duk_get_number(ctx, -1));
     } else {
       throw std::runtime_error("wrong type for field \"" + field  + "\", expected unsigned number");
     }
@@ -208,11 +216,9 @@ struct DuktapeStatementReader::Pimpl {
           ));
   }
 
-  std::unique_ptr<Response> get_result(duk_idx_t idx) {
-    std::unique_ptr<ResultsetResponse> response(new ResultsetResponse);
-    if (!duk_is_object(ctx, idx)) {
-      throw std::runtime_error("expect a object");
-    }
+  std::vector<column_info_type> get_columns(duk_idx_t idx) {
+    std::vector<column_info_type> columns;
+
     duk_get_prop_string(ctx, idx, "columns");
 
     if (!duk_is_array(ctx, idx)) {
@@ -245,7 +251,7 @@ struct DuktapeStatementReader::Pimpl {
       }
       duk_pop(ctx);
 
-      response->columns.push_back(column_info);
+      columns.push_back(column_info);
 
       duk_pop(ctx); // row
       duk_pop(ctx); // row-ndx
@@ -253,6 +259,17 @@ struct DuktapeStatementReader::Pimpl {
     duk_pop(ctx); // rows-enum
 
     duk_pop(ctx);
+
+    return columns;
+  }
+
+  std::unique_ptr<Response> get_result(duk_idx_t idx) {
+    std::unique_ptr<ResultsetResponse> response(new ResultsetResponse);
+    if (!duk_is_object(ctx, idx)) {
+      throw std::runtime_error("expect a object");
+    }
+    response->columns = get_columns(idx);
+
     duk_get_prop_string(ctx, idx, "rows");
 
     // object|undefined
@@ -291,21 +308,183 @@ struct DuktapeStatementReader::Pimpl {
     // gcc-4.8 needs a std::move, other's don't
     return std::move(response);
   }
+
+  std::unique_ptr<Response> get_generated_result(duk_idx_t idx) {
+    std::unique_ptr<GeneratedResultsetResponse> response(new GeneratedResultsetResponse);
+    if (!duk_is_object(ctx, idx)) {
+      throw std::runtime_error("expect a object");
+    }
+    response->columns = get_columns(idx);
+
+    response->row_count = get_object_integer_value<uint64_t>(-1, "row_count", 0, true);
+    response->value_length = get_object_integer_value<uint32_t>(-1, "value_length", 0);
+    response->rate_limit = get_object_integer_value<uint64_t>(-1, "rate_limit", 0);
+
+    // gcc-4.8 needs a std::move, other's don't
+    return std::move(response);
+  }
+
+  // heap borrowed from the pool
+  duk_context *heap {nullptr};
+  // thread with the session's global environment, lives on the heap's stack
   duk_context *ctx {nullptr};
 };
 
-duk_int_t duk_peval_file(duk_context *ctx, const char *path) {
-  duk_push_c_function(ctx, duk_node_fs_read_file_sync, 1);
-  duk_push_string(ctx, path);
-  if (duk_int_t rc = duk_pcall(ctx, 1)) {
-    return rc;
+/**
+ * pool of duktape heaps.
+ *
+ * Creating a heap with all its builtins is expensive compared to running
+ * the few statements of a typical session. Readers borrow a heap and run in
+ * a duktape thread with its own, fresh global environment on it, which
+ * leaves nothing of the previous session behind.
+ */
+class DukHeapPool {
+public:
+  static DukHeapPool &instance() {
+    static DukHeapPool pool;
+
+    return pool;
+  }
+
+  ~DukHeapPool() {
+    for (auto *heap: heaps_) {
+      duk_destroy_heap(heap);
+    }
+  }
+
+  duk_context *get() {
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      if (!heaps_.empty()) {
+        auto *heap = heaps_.back();
+        heaps_.pop_back();
+
+        return heap;
+      }
+    }
+
+    auto *heap = duk_create_heap_default();
+    if (nullptr == heap) {
+      throw std::runtime_error("creating duktape heap failed");
+    }
+
+    return heap;
   }
 
-  duk_buffer_to_string(ctx, -1);
-  duk_push_string(ctx, path);
-  if (duk_int_t rc = duk_pcompile(ctx, DUK_COMPILE_EVAL)) {
+  void release(duk_context *heap) {
+    // drops the session's thread and with it everything it referenced
+    duk_set_top(heap, 0);
+
+    {
+      std::lock_guard<std::mutex> lk(mtx_);
+      if (heaps_.size() < kMaxIdleHeaps) {
+        heaps_.push_back(heap);
+        return;
+      }
+    }
+
+    duk_destroy_heap(heap);
+  }
+
+private:
+  static constexpr size_t kMaxIdleHeaps = 16;
+
+  std::mutex mtx_;
+  std::vector<duk_context *> heaps_;
+};
+
+/**
+ * bytecode of compiled tracefiles.
+ *
+ * The bytecode is shared between the heaps and recompiled when the file
+ * changes.
+ */
+class DukBytecodeCache {
+public:
+  static DukBytecodeCache &instance() {
+    static DukBytecodeCache cache;
+
+    return cache;
+  }
+
+  /**
+   * push the compiled function of the file onto the stack.
+   *
+   * @returns DUK_EXEC_SUCCESS or DUK_EXEC_ERROR with the error on the stack
+   */
+  duk_int_t push_function(duk_context *ctx, const char *path) {
+    struct stat st;
+    const bool have_stat = (0 == stat(path, &st));
+    const auto version = have_stat ? mysql_harness::FileVersion::from_stat(st)
+                                   : mysql_harness::FileVersion{0, 0, 0, -1};
+
+    if (have_stat) {
+      std::lock_guard<std::mutex> lk(mtx_);
+
+      auto it = entries_.find(path);
+      if (it != entries_.end() && it->second.version == version) {
+        const auto &bytecode = it->second.bytecode;
+
+        void *buf = duk_push_fixed_buffer(ctx, bytecode.size());
+        std::memcpy(buf, bytecode.data(), bytecode.size());
+
+        return duk_safe_call(ctx, load_function, nullptr, 1, 1);
+      }
+    }
+
+    duk_push_c_function(ctx, duk_node_fs_read_file_sync, 1);
+    duk_push_string(ctx, path);
+    if (duk_int_t rc = duk_pcall(ctx, 1)) {
+      return rc;
+    }
+
+    duk_buffer_to_string(ctx, -1);
+    duk_push_string(ctx, path);
+    if (duk_int_t rc = duk_pcompile(ctx, DUK_COMPILE_EVAL)) {
+      return rc;
+    }
+
+    if (have_stat) {
+      duk_dup(ctx, -1);
+      duk_dump_function(ctx);
+
+      duk_size_t bytecode_size;
+      const char *bytecode = static_cast<const char *>(duk_get_buffer(ctx, -1, &bytecode_size));
+
+      {
+        std::lock_guard<std::mutex> lk(mtx_);
+        entries_[path] = Entry {
+          version,
+          std::string(bytecode, bytecode_size)
+        };
+      }
+      duk_pop(ctx); // bytecode
+    }
+
+    return DUK_EXEC_SUCCESS;
+  }
+
+private:
+  static duk_ret_t load_function(duk_context *ctx, void *) {
+    duk_load_function(ctx);
+
+    return 1;
+  }
+
+  struct Entry {
+    mysql_harness::FileVersion version;
+    std::string bytecode;
+  };
+
+  std::mutex mtx_;
+  std::map<std::string, Entry> entries_;
+};
+
+duk_int_t duk_peval_file(duk_context *ctx, const char *path) {
+  if (duk_int_t rc = DukBytecodeCache::instance().push_function(ctx, path)) {
     return rc;
   }
+
   duk_push_global_object(ctx);
   return duk_pcall_method(ctx, 0);
 }
@@ -391,14 +570,17 @@ DuktapeStatementReader::DuktapeStatementReader(
   pimpl_{new Pimpl()},
   shared_{shared_globals}
 {
-  auto *ctx = duk_create_heap_default();
+  auto *heap = DukHeapPool::instance().get();
 
-  // free the duk_context if an exception gets thrown as DuktapeStatementReaders's destructor
+  // return the heap if an exception gets thrown as DuktapeStatementReaders's destructor
   // will not be called in that case.
-  ScopeGuard duk_guard{[&ctx](){
-    duk_destroy_heap(ctx);
+  ScopeGuard duk_guard{[&heap](){
+    DukHeapPool::instance().release(heap);
   }};
 
+  duk_push_thread_new_globalenv(heap);
+  auto *ctx = duk_get_context(heap, -1);
+
   // init module-loader
   duk_module_shim_init(ctx, module_prefix.c_str());
 
@@ -478,14 +660,13 @@ DuktapeStatementReader::DuktapeStatementReader(
   }
 
   // we are still alive, dismiss the guard
+  pimpl_->heap = heap;
   pimpl_->ctx = ctx;
   duk_guard.dismiss();
 }
 
 DuktapeStatementReader::~DuktapeStatementReader() {
-  // duk_pop(pimpl_->ctx);
-
-  if (pimpl_->ctx) duk_destroy_heap(pimpl_->ctx);
+  if (pimpl_->heap) DukHeapPool::instance().release(pimpl_->heap);
 }
 
 StatementAndResponse DuktapeStatementReader::handle_statement(const std::string &statement) {
@@ -564,7 +745,14 @@ StatementAndResponse DuktapeStatementReader::handle_statement(const std::string
         response.response_type = StatementAndResponse::StatementResponseType::STMT_RES_OK;
         response.response = pimpl_->get_ok(-1);
       } else {
-        throw std::runtime_error("expected 'error', 'ok' or 'result'");
+        duk_pop(ctx); // ok
+        duk_get_prop_string(ctx, -1, "generated_result");
+        if (!duk_is_undefined(ctx, -1)) {
+          response.response_type = StatementAndResponse::StatementResponseType::STMT_RES_GENERATED_RESULT;
+          response.response = pimpl_->get_generated_result(-1);
+        } else {
+          throw std::runtime_error("expected 'error', 'ok', 'result' or 'generated_result'");
+        }
       }
     }
   }
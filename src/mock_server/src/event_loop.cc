@@ -0,0 +1,304 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "event_loop.h"
+
+#include <algorithm>
+#include <system_error>
+#include <vector>
+
+#ifdef __linux__
+#  include <sys/epoll.h>
+#endif
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <unistd.h>
+#else
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#  include <winsock2.h>
+#endif
+
+#include "mysql_protocol_utils.h"
+
+namespace server_mock {
+
+// sockets reported ready per epoll_wait()
+constexpr int kMaxEventsPerWait = 256;
+
+#ifdef __linux__
+static uint32_t to_epoll_events(unsigned events) {
+  return ((events & EventLoop::kRead) ? static_cast<uint32_t>(EPOLLIN) : 0u) |
+         ((events & EventLoop::kWrite) ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+}
+
+// the descriptor in the lower, the id of its watch in the upper half
+static uint64_t to_epoll_data(socket_t fd, uint32_t watch_id) {
+  return (static_cast<uint64_t>(watch_id) << 32) | static_cast<uint32_t>(fd);
+}
+#endif
+
+EventLoop::EventLoop() {
+#ifndef _WIN32
+  if (pipe(wakeup_fds_) != 0) {
+    throw std::system_error(errno, std::generic_category(), "pipe() failed");
+  }
+  for (int fd: wakeup_fds_) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+#endif
+
+#ifdef __linux__
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    auto ec = errno;
+    close(wakeup_fds_[0]);
+    close(wakeup_fds_[1]);
+    throw std::system_error(ec, std::generic_category(), "epoll_create1() failed");
+  }
+
+  struct epoll_event ev {};
+  ev.events = EPOLLIN;
+  ev.data.u64 = to_epoll_data(wakeup_fds_[0], 0);
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fds_[0], &ev);
+#endif
+}
+
+EventLoop::~EventLoop() {
+#ifdef __linux__
+  close(epoll_fd_);
+#endif
+#ifndef _WIN32
+  close(wakeup_fds_[0]);
+  close(wakeup_fds_[1]);
+#endif
+}
+
+void EventLoop::add(socket_t fd, unsigned events, IoHandler handler) {
+  const uint32_t watch_id = next_watch_id_++;
+  // 0 is the wakeup pipe's
+  if (next_watch_id_ == 0) next_watch_id_ = 1;
+
+#ifdef __linux__
+  struct epoll_event ev {};
+  ev.events = to_epoll_events(events);
+  ev.data.u64 = to_epoll_data(fd, watch_id);
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+    throw std::system_error(errno, std::generic_category(), "epoll_ctl(ADD) failed");
+  }
+#endif
+  watches_[fd] = Watch { watch_id, events, std::move(handler) };
+}
+
+void EventLoop::modify(socket_t fd, unsigned events) {
+  auto it = watches_.find(fd);
+  if (it == watches_.end() || it->second.events == events) return;
+
+#ifdef __linux__
+  struct epoll_event ev {};
+  ev.events = to_epoll_events(events);
+  ev.data.u64 = to_epoll_data(fd, it->second.id);
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) != 0) {
+    throw std::system_error(errno, std::generic_category(), "epoll_ctl(MOD) failed");
+  }
+#endif
+  it->second.events = events;
+}
+
+void EventLoop::remove(socket_t fd) noexcept {
+  if (watches_.erase(fd) == 0) return;
+
+#ifdef __linux__
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+#endif
+}
+
+EventLoop::TimerId EventLoop::add_timer(std::chrono::microseconds timeout, TimerHandler handler) {
+  const TimerId id = next_timer_id_++;
+  const auto expiry = clock_type::now() + timeout;
+
+  timers_.emplace(std::make_pair(expiry, id), std::move(handler));
+  timer_expiries_.emplace(id, expiry);
+
+  return id;
+}
+
+void EventLoop::cancel_timer(TimerId id) noexcept {
+  auto it = timer_expiries_.find(id);
+  if (it == timer_expiries_.end()) return;
+
+  timers_.erase(std::make_pair(it->second, id));
+  timer_expiries_.erase(it);
+}
+
+void EventLoop::post(Task task) {
+  {
+    std::lock_guard<std::mutex> lk(posted_tasks_mutex_);
+    posted_tasks_.push_back(std::move(task));
+  }
+  wakeup();
+}
+
+void EventLoop::wakeup() noexcept {
+#ifndef _WIN32
+  const char c = 0;
+  // if the pipe is full, the loop is woken up already
+  ssize_t res = write(wakeup_fds_[1], &c, 1);
+  (void)res;
+#endif
+}
+
+void EventLoop::run_once(std::chrono::milliseconds max_wait) {
+  auto timeout = max_wait;
+  if (!timers_.empty()) {
+    auto until_expiry = std::chrono::duration_cast<std::chrono::milliseconds>(
+        timers_.begin()->first.first - clock_type::now());
+    // round up to not wake up before the timer expires
+    if (until_expiry.count() >= 0) until_expiry += std::chrono::milliseconds(1);
+    timeout = std::max(std::chrono::milliseconds(0), std::min(timeout, until_expiry));
+  }
+
+  wait_and_dispatch(static_cast<int>(timeout.count()));
+  run_timers();
+  run_posted_tasks();
+}
+
+void EventLoop::dispatch(socket_t fd, uint32_t watch_id, unsigned events) {
+  auto it = watches_.find(fd);
+  // removed by a handler called earlier in this round, maybe even replaced
+  // by a new socket which got the same descriptor
+  if (it == watches_.end() || it->second.id != watch_id) return;
+
+  // the handler may remove itself
+  IoHandler handler = it->second.handler;
+  handler(events);
+}
+
+#ifdef __linux__
+void EventLoop::wait_and_dispatch(int timeout_ms) {
+  struct epoll_event events[kMaxEventsPerWait];
+
+  int num_events = epoll_wait(epoll_fd_, events, kMaxEventsPerWait, timeout_ms);
+  if (num_events < 0) {
+    if (errno == EINTR) return;
+    throw std::system_error(errno, std::generic_category(), "epoll_wait() failed");
+  }
+
+  for (int ndx = 0; ndx < num_events; ndx++) {
+    const auto &ev = events[ndx];
+    const auto fd = static_cast<socket_t>(static_cast<uint32_t>(ev.data.u64));
+    const auto watch_id = static_cast<uint32_t>(ev.data.u64 >> 32);
+
+    if (watch_id == 0) {
+      char buf[64];
+      while (read(wakeup_fds_[0], buf, sizeof(buf)) > 0);
+      continue;
+    }
+
+    unsigned ready = 0;
+    if (ev.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) ready |= kRead;
+    if (ev.events & EPOLLOUT) ready |= kWrite;
+
+    dispatch(fd, watch_id, ready);
+  }
+}
+#else
+void EventLoop::wait_and_dispatch(int timeout_ms) {
+#ifdef _WIN32
+  std::vector<WSAPOLLFD> fds;
+#else
+  std::vector<struct pollfd> fds;
+  fds.push_back({wakeup_fds_[0], POLLIN, 0});
+#endif
+  // id of the watch of each entry of fds
+  std::vector<uint32_t> watch_ids(fds.size(), 0);
+  for (const auto &watch: watches_) {
+    short events = 0;
+    if (watch.second.events & kRead) events |= POLLIN;
+    if (watch.second.events & kWrite) events |= POLLOUT;
+    fds.push_back({watch.first, events, 0});
+    watch_ids.push_back(watch.second.id);
+  }
+
+#ifdef _WIN32
+  // without a wakeup descriptor the callers bound the wait instead
+  int num_events = fds.empty() ? (Sleep(static_cast<DWORD>(timeout_ms)), 0)
+                               : WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeout_ms);
+#else
+  int num_events = poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout_ms);
+#endif
+  if (num_events < 0) {
+    if (get_socket_errno() == EINTR) return;
+    throw std::system_error(get_socket_errno(), std::system_category(), "poll() failed");
+  }
+
+  for (size_t ndx = 0; ndx < fds.size(); ++ndx) {
+    const auto &pfd = fds[ndx];
+    if (pfd.revents == 0) continue;
+
+#ifndef _WIN32
+    if (watch_ids[ndx] == 0) {
+      char buf[64];
+      while (read(wakeup_fds_[0], buf, sizeof(buf)) > 0);
+      continue;
+    }
+#endif
+
+    unsigned ready = 0;
+    if (pfd.revents & (POLLIN | POLLERR | POLLHUP | POLLNVAL)) ready |= kRead;
+    if (pfd.revents & POLLOUT) ready |= kWrite;
+
+    dispatch(pfd.fd, watch_ids[ndx], ready);
+  }
+}
+#endif
+
+void EventLoop::run_timers() {
+  const auto now = clock_type::now();
+
+  while (!timers_.empty() && timers_.begin()->first.first <= now) {
+    auto it = timers_.begin();
+    TimerHandler handler = std::move(it->second);
+
+    timer_expiries_.erase(it->first.second);
+    timers_.erase(it);
+
+    handler();
+  }
+}
+
+void EventLoop::run_posted_tasks() {
+  std::vector<Task> tasks;
+  {
+    std::lock_guard<std::mutex> lk(posted_tasks_mutex_);
+    if (posted_tasks_.empty()) return;
+    tasks.swap(posted_tasks_);
+  }
+
+  for (auto &task: tasks) task();
+}
+
+} // namespace server_mock
@@ -0,0 +1,157 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef MYSQLD_MOCK_EVENT_LOOP_INCLUDED
+#define MYSQLD_MOCK_EVENT_LOOP_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mysql_protocol_decoder.h"  // socket_t
+
+namespace server_mock {
+
+/** @class EventLoop
+ *
+ * @brief Waits for sockets to become readable/writable and for timers to expire
+ *
+ * Uses epoll on Linux and poll() elsewhere. Handlers are called from
+ * run_once() in the thread that runs the loop; besides post() and wakeup()
+ * none of the methods is thread-safe.
+ *
+ * Errors and hangups of a socket are reported as kRead, the handler finds
+ * out about them when reading.
+ **/
+class EventLoop {
+ public:
+  enum Events : unsigned {
+    kRead = 1 << 0,
+    kWrite = 1 << 1,
+  };
+
+  using IoHandler = std::function<void(unsigned events)>;
+  using TimerHandler = std::function<void()>;
+  using Task = std::function<void()>;
+  using TimerId = uint64_t;
+  using clock_type = std::chrono::steady_clock;
+
+  /** @throws std::system_error if the loop's descriptors can't be created */
+  EventLoop();
+  ~EventLoop();
+
+  EventLoop(const EventLoop &) = delete;
+  EventLoop &operator=(const EventLoop &) = delete;
+
+  /** @brief Starts watching a socket
+   *
+   * @param fd socket to watch
+   * @param events kRead and/or kWrite
+   * @param handler called with the events that occured
+   *
+   * @throws std::system_error on failure
+   */
+  void add(socket_t fd, unsigned events, IoHandler handler);
+
+  /** @brief Changes the events a socket is watched for
+   *
+   * @throws std::system_error on failure
+   */
+  void modify(socket_t fd, unsigned events);
+
+  /** @brief Stops watching a socket
+   *
+   * Must be called before the socket is closed.
+   */
+  void remove(socket_t fd) noexcept;
+
+  /** @brief Calls handler once after the given time
+   *
+   * @returns id of the timer which can be passed to cancel_timer()
+   */
+  TimerId add_timer(std::chrono::microseconds timeout, TimerHandler handler);
+
+  /** @brief Cancels a timer which hasn't expired yet */
+  void cancel_timer(TimerId id) noexcept;
+
+  /** @brief Waits for events and calls their handlers
+   *
+   * @param max_wait maximum time to wait for events
+   */
+  void run_once(std::chrono::milliseconds max_wait);
+
+  /** @brief Calls task from run_once() in the thread that runs the loop
+   *
+   * May be called from any thread. Tasks which didn't run yet when the
+   * loop is destroyed are dropped.
+   */
+  void post(Task task);
+
+  /** @brief Interrupts run_once() if it is waiting
+   *
+   * May be called from any thread.
+   */
+  void wakeup() noexcept;
+
+ private:
+  void wait_and_dispatch(int timeout_ms);
+  void dispatch(socket_t fd, uint32_t watch_id, unsigned events);
+  void run_timers();
+  void run_posted_tasks();
+
+  struct Watch {
+    uint32_t id;
+    unsigned events;
+    IoHandler handler;
+  };
+
+  std::unordered_map<socket_t, Watch> watches_;
+
+  // ordered by expiry, ties in the order they were added
+  std::map<std::pair<clock_type::time_point, TimerId>, TimerHandler> timers_;
+  std::unordered_map<TimerId, clock_type::time_point> timer_expiries_;
+  TimerId next_timer_id_ { 1 };
+
+  // tells a socket from an earlier one with the same descriptor number
+  // which got closed while the events of a wait were dispatched
+  uint32_t next_watch_id_ { 1 };
+
+  std::mutex posted_tasks_mutex_;
+  std::vector<Task> posted_tasks_;
+
+#ifdef __linux__
+  int epoll_fd_ { -1 };
+#endif
+  // the loop waits for the read-side of the wakeup pipe too
+  int wakeup_fds_[2] { -1, -1 };
+};
+
+} // namespace server_mock
+
+#endif // MYSQLD_MOCK_EVENT_LOOP_INCLUDED
@@ -38,8 +38,14 @@
 #include <cassert>
 #include <cerrno>
 #include <chrono>
+#include <map>
 #include <memory>
+#include <mutex>
 
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "mysql/harness/filesystem.h"
 #include "mysql_server_mock_schema.h"
 
 #ifdef _WIN32
@@ -129,24 +135,140 @@ INT_TYPE get_json_integer_field(const JsonValue& parent,
 
 namespace server_mock {
 
+namespace {
+
+/** @brief Precompiled "stmt.regex" of a statement
+ **/
+class StatementRegex {
+ public:
+  // throws std::runtime_error if the pattern is invalid
+  explicit StatementRegex(const std::string &pattern)
+#ifdef _WIN32
+    try : regex_(pattern) {
+  } catch (const std::regex_error &) {
+    throw std::runtime_error("Error compiling regex pattern: " + pattern);
+  }
+#else
+  {
+    if (regcomp(&regex_, pattern.c_str(), REG_EXTENDED | REG_NOSUB)) {
+      throw std::runtime_error("Error compiling regex pattern: " + pattern);
+    }
+  }
+
+  ~StatementRegex() {
+    regfree(&regex_);
+  }
+#endif
+
+  StatementRegex(const StatementRegex &) = delete;
+  StatementRegex &operator=(const StatementRegex &) = delete;
+
+  // may be called concurrently
+  bool matches(const std::string &s) const {
+#ifndef _WIN32
+    return regexec(&regex_, s.c_str(), 0, NULL, 0) == 0;
+#else
+    return std::regex_match(s, regex_);
+#endif
+  }
+
+ private:
+#ifndef _WIN32
+  regex_t regex_;
+#else
+  std::regex regex_;
+#endif
+};
+
+/** @brief Single statement of the JSON file, prepared for matching
+ **/
+struct CompiledStatement {
+  std::string statement;
+  std::unique_ptr<StatementRegex> regex;  // set for "stmt.regex"
+
+  std::chrono::microseconds exec_time{0};
+  StatementAndResponse::StatementResponseType response_type{
+    StatementAndResponse::StatementResponseType::STMT_RES_UNKNOWN};
+  // handed to the sessions as is
+  std::shared_ptr<const Response> response;
+
+  // reported when the statement is handled, like before it was prepared
+  std::string statement_error;
+  std::string response_error;
+};
+
+/** @brief Parsed and validated JSON file, shared by all sessions
+ **/
+struct StatementTable {
+  std::vector<CompiledStatement> stmts;
+  std::chrono::microseconds default_exec_time{0};
+};
+
+} // unnamed namespace
+
 struct QueriesJsonReader::Pimpl {
 
-  JsonDocument json_document_;
+  std::shared_ptr<const StatementTable> table_;
   size_t current_stmt_{0u};
 
   // load queries JSON; throws std::runtime_error on invalid JSON file
-  Pimpl(const std::string& json_filename): json_document_(load_json_from_file(json_filename)) {}
+  Pimpl(const std::string& json_filename): table_(get_statement_table(json_filename)) {}
 
+  static std::shared_ptr<const StatementTable> get_statement_table(const std::string& filename);
+  static std::shared_ptr<const StatementTable> load_statement_table(const std::string& filename);
   static JsonDocument load_json_from_file(const std::string& filename);
   static void validate_json_against_schema(const JsonSchemaDocument& schema, const JsonDocument& json);
-
-  std::unique_ptr<Response> read_result_info(const JsonValue& stmt);
-  std::unique_ptr<Response> read_ok_info(const JsonValue& stmt);
-  std::unique_ptr<Response> read_error_info(const JsonValue& stmt);
+  static std::chrono::microseconds read_exec_time(const JsonValue& parent);
+
+  static void compile_statement(const JsonValue& stmt, CompiledStatement& compiled);
+  static void compile_response(const JsonValue& stmt, CompiledStatement& compiled);
+  static std::vector<column_info_type> read_columns(const JsonValue& result);
+  static std::unique_ptr<Response> read_result_info(const JsonValue& stmt);
+  static std::unique_ptr<Response> read_generated_result_info(const JsonValue& stmt);
+  static std::unique_ptr<Response> read_ok_info(const JsonValue& stmt);
+  static std::unique_ptr<Response> read_error_info(const JsonValue& stmt);
 };
 
 QueriesJsonReader::QueriesJsonReader(const std::string &json_filename):
               pimpl_(new Pimpl(json_filename)) {
+}
+
+// parses and validates the file only if it changed since it was loaded last
+/*static*/
+std::shared_ptr<const StatementTable> QueriesJsonReader::Pimpl::get_statement_table(
+    const std::string& filename) {
+  struct CacheEntry {
+    mysql_harness::FileVersion version;
+    std::shared_ptr<const StatementTable> table;
+  };
+
+  static std::mutex cache_mtx;
+  static std::map<std::string, CacheEntry> cache;
+
+  struct stat st;
+  if (-1 == stat(filename.c_str(), &st)) {
+    throw std::runtime_error("Could not open JSON file '" + filename
+                             + "' for reading: " + strerror(errno));
+  }
+  const auto version = mysql_harness::FileVersion::from_stat(st);
+
+  std::lock_guard<std::mutex> lk(cache_mtx);
+
+  auto it = cache.find(filename);
+  if (it != cache.end() && it->second.version == version) {
+    return it->second.table;
+  }
+
+  auto table = load_statement_table(filename);
+  cache[filename] = CacheEntry { version, table };
+
+  return table;
+}
+
+/*static*/
+std::shared_ptr<const StatementTable> QueriesJsonReader::Pimpl::load_statement_table(
+    const std::string& filename) {
+  JsonDocument json_document = load_json_from_file(filename);
 
   // construct schema JSON; throws std::runtime_error on invalid JSON, but note
   // that invalid schema will slip by without throwing (but it will cause
@@ -160,19 +282,93 @@ QueriesJsonReader::QueriesJsonReader(const std::string &json_filename):
 
   // validate JSON against schema; throws std::runtime if validation fails
   try {
-    pimpl_->validate_json_against_schema(schema, pimpl_->json_document_);
+    validate_json_against_schema(schema, json_document);
   } catch (const std::runtime_error& e) {
     // TODO: we could also get here if schema itself is not valid. To diagnose that,
     //       another validate_json_against_schema() could be ran here to validate our
     //       schema against schema spec (http://json-schema.org/draft-04/schema#)
 
-    throw std::runtime_error("JSON file '" + json_filename +
+    throw std::runtime_error("JSON file '" + filename +
                              "' failed validation against JSON schema:\n" + e.what());
   }
 
   // schema should have caught these
-  harness_assert(pimpl_->json_document_.HasMember("stmts"));
-  harness_assert(pimpl_->json_document_["stmts"].IsArray());
+  harness_assert(json_document.HasMember("stmts"));
+  harness_assert(json_document["stmts"].IsArray());
+
+  std::shared_ptr<StatementTable> table(new StatementTable);
+
+  if (json_document.HasMember("defaults")) {
+    table->default_exec_time = read_exec_time(json_document["defaults"]);
+  }
+
+  const JsonValue& stmts = json_document["stmts"];
+  table->stmts.resize(stmts.Size());
+  for (size_t i = 0; i < stmts.Size(); ++i) {
+    auto& compiled = table->stmts[i];
+
+    compiled.exec_time = stmts[i].HasMember("exec_time")
+        ? read_exec_time(stmts[i])
+        : table->default_exec_time;
+
+    try {
+      compile_statement(stmts[i], compiled);
+    } catch (const std::exception& e) {
+      compiled.statement_error = e.what();
+    }
+
+    try {
+      compile_response(stmts[i], compiled);
+    } catch (const std::exception& e) {
+      compiled.response_error = e.what();
+    }
+  }
+
+  return table;
+}
+
+/*static*/
+std::chrono::microseconds QueriesJsonReader::Pimpl::read_exec_time(const JsonValue& parent) {
+  if (!parent.HasMember("exec_time")) return std::chrono::microseconds(0);
+
+  double exec_time = get_json_double_field(parent, "exec_time", 0.0);
+  return std::chrono::microseconds(static_cast<long>(exec_time * 1000));
+}
+
+/*static*/
+void QueriesJsonReader::Pimpl::compile_statement(const JsonValue& stmt,
+                                                 CompiledStatement& compiled) {
+  harness_assert(stmt.HasMember("stmt") || stmt.HasMember("stmt.regex"));  // schema should have caught this
+
+  const bool statement_is_regex = stmt.HasMember("stmt.regex");
+  const char *name = statement_is_regex ? "stmt.regex" : "stmt";
+
+  harness_assert(stmt[name].IsString());  // schema should have caught this
+
+  compiled.statement = stmt[name].GetString();
+  if (statement_is_regex) {
+    compiled.regex.reset(new StatementRegex(compiled.statement));
+  }
+}
+
+/*static*/
+void QueriesJsonReader::Pimpl::compile_response(const JsonValue& stmt,
+                                                CompiledStatement& compiled) {
+  if (stmt.HasMember("ok")) {
+    compiled.response_type = StatementAndResponse::StatementResponseType::STMT_RES_OK;
+    compiled.response = read_ok_info(stmt);
+  } else if (stmt.HasMember("error")) {
+    compiled.response_type = StatementAndResponse::StatementResponseType::STMT_RES_ERROR;
+    compiled.response = read_error_info(stmt);
+  } else if (stmt.HasMember("result")) {
+    compiled.response_type = StatementAndResponse::StatementResponseType::STMT_RES_RESULT;
+    compiled.response = read_result_info(stmt);
+  } else if (stmt.HasMember("generated_result")) {
+    compiled.response_type = StatementAndResponse::StatementResponseType::STMT_RES_GENERATED_RESULT;
+    compiled.response = read_generated_result_info(stmt);
+  } else {
+    harness_assert_this_should_not_execute(); // schema should have caught this
+  }
 }
 
 // this is needed for pimpl, otherwise compiler complains
@@ -236,106 +432,47 @@ void QueriesJsonReader::Pimpl::validate_json_against_schema(const JsonSchemaDocu
   }
 }
 
-namespace {
-
-bool pattern_matching(const std::string &s,
-                      const std::string &pattern) {
-#ifndef _WIN32
-  regex_t regex;
-  auto r = regcomp(&regex, pattern.c_str(), REG_EXTENDED);
-  if (r) {
-    throw std::runtime_error("Error compiling regex pattern: " + pattern);
-  }
-  r = regexec(&regex, s.c_str(), 0, NULL, 0);
-  regfree(&regex);
-  return (r == 0);
-#else
-  std::regex regex(pattern);
-  return std::regex_match(s, regex);
-#endif
-}
-
-} // unnamed namespace
-
-
 StatementAndResponse QueriesJsonReader::handle_statement(const std::string &statement_received) {
   StatementAndResponse response;
 
-  const JsonValue& stmts = pimpl_->json_document_["stmts"];
-  if (pimpl_->current_stmt_ >= stmts.Size()) return response;
-
-  auto& stmt = stmts[pimpl_->current_stmt_++];
-  harness_assert(stmt.HasMember("stmt") || stmt.HasMember("stmt.regex"));  // schema should have caught this
-
-  if (stmt.HasMember("exec_time")) {
-    double exec_time = get_json_double_field(stmt, "exec_time", 0.0);
-    response.exec_time = std::chrono::microseconds(static_cast<long>(exec_time * 1000));
-  }
-  else {
-    response.exec_time = get_default_exec_time();
-  }
+  const auto& stmts = pimpl_->table_->stmts;
+  if (pimpl_->current_stmt_ >= stmts.size()) return response;
 
-  bool statement_is_regex = false;
-  std::string name{"stmt"};
-  if (stmt.HasMember("stmt.regex")) {
-    name = "stmt.regex";
-    statement_is_regex = true;
-  }
+  const auto& stmt = stmts[pimpl_->current_stmt_++];
 
-  harness_assert(stmt[name.c_str()].IsString());  // schema should have caught this
+  response.exec_time = stmt.exec_time;
 
-  std::string statement = stmt[name.c_str()].GetString();
+  if (!stmt.statement_error.empty()) throw std::runtime_error(stmt.statement_error);
 
   bool statement_matching{false};
-  if (!statement_is_regex) { // not regex
-    statement_matching = (statement_received == statement);
+  if (!stmt.regex) { // not regex
+    statement_matching = (statement_received == stmt.statement);
   } else { // regex
-    statement_matching = pattern_matching(statement_received,
-                                          statement);
+    statement_matching = stmt.regex->matches(statement_received);
   }
 
   if (!statement_matching) {
     response.response_type = StatementAndResponse::StatementResponseType::STMT_RES_ERROR;
     response.response.reset(new ErrorResponse(MYSQL_PARSE_ERROR,
         std::string("Unexpected stmt, got: \"") + statement_received +
-        "\"; expected: \"" + statement + "\""));
-  } else if (stmt.HasMember("ok")) {
-    response.response_type = StatementAndResponse::StatementResponseType::STMT_RES_OK;
-    response.response = pimpl_->read_ok_info(stmt);
-  } else if (stmt.HasMember("error")) {
-    response.response_type = StatementAndResponse::StatementResponseType::STMT_RES_ERROR;
-    response.response = pimpl_->read_error_info(stmt);
-  } else if (stmt.HasMember("result")) {
-    response.response_type = StatementAndResponse::StatementResponseType::STMT_RES_RESULT;
-    response.response = pimpl_->read_result_info(stmt);
+        "\"; expected: \"" + stmt.statement + "\""));
   } else {
-    harness_assert_this_should_not_execute(); // schema should have caught this
+    if (!stmt.response_error.empty()) throw std::runtime_error(stmt.response_error);
+
+    response.response_type = stmt.response_type;
+    response.response = stmt.response;
   }
 
   return response;
 }
 
 std::chrono::microseconds QueriesJsonReader::get_default_exec_time() {
-
-  if (pimpl_->json_document_.HasMember("defaults")) {
-    auto& defaults = pimpl_->json_document_["defaults"];
-    if (defaults.HasMember("exec_time")) {
-      double exec_time = get_json_double_field(defaults, "exec_time", 0.0);
-      return std::chrono::microseconds(static_cast<long>(exec_time * 1000));
-    }
-  }
-  return std::chrono::microseconds(0);
+  return pimpl_->table_->default_exec_time;
 }
 
-std::unique_ptr<Response> QueriesJsonReader::Pimpl::read_result_info(const JsonValue &stmt) {
-  // only asserting as this should have been checked before if we got here
-  assert(stmt.HasMember("result"));
-
-  const auto& result = stmt["result"];
-
-  std::unique_ptr<ResultsetResponse> response(new ResultsetResponse);
+std::vector<column_info_type> QueriesJsonReader::Pimpl::read_columns(const JsonValue &result) {
+  std::vector<column_info_type> columns_info;
 
-  // read columns
   if (result.HasMember("columns")) {
     const auto& columns = result["columns"];
     harness_assert(columns.IsArray());  // schema should have caught this
@@ -357,10 +494,23 @@ std::unique_ptr<Response> QueriesJsonReader::Pimpl::read_result_info(const JsonV
           get_json_integer_field<unsigned>(column, "repeat", 1)
       };
 
-      response->columns.push_back(column_info);
+      columns_info.push_back(column_info);
     }
   }
 
+  return columns_info;
+}
+
+std::unique_ptr<Response> QueriesJsonReader::Pimpl::read_result_info(const JsonValue &stmt) {
+  // only asserting as this should have been checked before if we got here
+  assert(stmt.HasMember("result"));
+
+  const auto& result = stmt["result"];
+
+  std::unique_ptr<ResultsetResponse> response(new ResultsetResponse);
+
+  response->columns = read_columns(result);
+
   // read rows
   if (result.HasMember("rows")) {
     const auto& rows = result["rows"];
@@ -397,6 +547,28 @@ std::unique_ptr<Response> QueriesJsonReader::Pimpl::read_result_info(const JsonV
   return std::move(response);
 }
 
+std::unique_ptr<Response> QueriesJsonReader::Pimpl::read_generated_result_info(const JsonValue &stmt) {
+  // only asserting as this should have been checked before if we got here
+  assert(stmt.HasMember("generated_result"));
+
+  const auto& result = stmt["generated_result"];
+
+  std::unique_ptr<GeneratedResultsetResponse> response(new GeneratedResultsetResponse);
+
+  response->columns = read_columns(result);
+
+  // row_count and rate_limit may exceed int
+  harness_assert(result["row_count"].IsUint64());  // schema should have caught this
+  response->row_count = result["row_count"].GetUint64();
+  response->value_length = get_json_integer_field<uint32_t>(result, "value_length", 0);
+  if (result.HasMember("rate_limit")) {
+    harness_assert(result["rate_limit"].IsUint64());  // schema should have caught this
+    response->rate_limit = result["rate_limit"].GetUint64();
+  }
+
+  return std::move(response);
+}
+
 std::unique_ptr<Response> QueriesJsonReader::Pimpl::read_ok_info(const JsonValue &stmt) {
   // only asserting as this should have been checked before if we got here
   assert(stmt.HasMember("ok"));
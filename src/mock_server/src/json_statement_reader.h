@@ -45,6 +45,9 @@ class QueriesJsonReader: public StatementReaderBase {
  public:
 
   /** @brief Constructor.
+   *
+   * The file is parsed and validated only once and shared by all readers
+   * of the same file until it gets modified.
    *
    * @param filename Path to the json file with definitins
    *         of the expected SQL statements and responses
@@ -40,26 +40,21 @@
 #  include <ws2tcpip.h>
 #endif
 
+#include <algorithm>
 #include <iostream>
 
 namespace server_mock {
 
 //TODO use of this class should probably be replaced by mysql_protocol::Packet* classes
 
-MySQLProtocolDecoder::MySQLProtocolDecoder(const ReadCallback& read_clb):
-  read_callback_(read_clb)
-{}
+size_t MySQLProtocolDecoder::decode_message(const uint8_t *data, size_t size) {
+  constexpr size_t header_len = 4;
+  if (size < header_len) return 0;
 
-void MySQLProtocolDecoder::read_message(socket_t client_socket, int flags) {
-  ProtocolPacketType result;
-  uint8_t header_buf[4];
   uint32_t header{0};
-
-  read_callback_(client_socket, &header_buf[0], sizeof(header_buf), flags);
-
-  for (size_t i = 1; i <= 4; ++i) {
+  for (size_t i = 1; i <= header_len; ++i) {
     header <<= 8;
-    header |= header_buf[4-i];
+    header |= data[header_len-i];
   }
 
   uint32_t pkt_len = header & 0x00ffffff;
@@ -69,12 +64,12 @@ void MySQLProtocolDecoder::read_message(socket_t client_socket, int flags) {
     throw std::runtime_error("Protocol messages split into several packets not supported!");
   }
 
+  if (size < header_len + pkt_len) return 0;
+
   packet_.packet_seq = static_cast<uint8_t>(header >> 24);
+  packet_.packet_buffer.assign(data + header_len, data + header_len + pkt_len);
 
-  if (pkt_len > 0) {
-    packet_.packet_buffer.resize(pkt_len);
-    read_callback_(client_socket, &packet_.packet_buffer[0], pkt_len, flags);
-  }
+  return header_len + pkt_len;
 }
 
 mysql_protocol::Command MySQLProtocolDecoder::get_command_type() const {
@@ -82,16 +77,14 @@ mysql_protocol::Command MySQLProtocolDecoder::get_command_type() const {
 }
 
 std::string MySQLProtocolDecoder::get_statement() const {
-  size_t buf_len = packet_.packet_buffer.size() - 1;
-  if (buf_len == 0) return "";
+  if (packet_.packet_buffer.size() <= 1) return "";
 
-  std::vector<char> statement(buf_len+1);
-  const char* buf = reinterpret_cast<const char*>(&packet_.packet_buffer[1]);
-  std::copy(buf, buf+buf_len, &statement[0]);
-  statement[buf_len] = '\0';
+  // the statement follows the command byte and ends at the first NUL, if any
+  mysql_protocol::PacketView payload(packet_.packet_buffer);
+  auto statement = payload.read_bytes_eof_from(1);
+  const auto statement_end = std::find(statement.begin(), statement.end(), 0);
 
-  return std::string(statement.data());
+  return std::string(statement.begin(), statement_end);
 }
 
-
 } // namespace
@@ -25,7 +25,6 @@
 #ifndef MYSQLD_MOCK_MYSQL_PROTOCOL_DECODER_INCLUDED
 #define MYSQLD_MOCK_MYSQL_PROTOCOL_DECODER_INCLUDED
 
-#include <functional>
 #include <string>
 #include <vector>
 #include <stdint.h>
@@ -54,19 +53,16 @@ using byte = uint8_t;
 class MySQLProtocolDecoder {
  public:
 
-  /** @brief Callback used to read more data from the socket
-   **/
-  using ReadCallback = std::function<void(int, uint8_t *data, size_t size, int)>;
-
-  /** @brief Constructor
+  /** @brief Decodes single packet from the start of a buffer.
    *
-   * @param read_clb Callback to use to read more data from the socket
-   **/
-  MySQLProtocolDecoder(const ReadCallback& read_clb);
-
-  /** @brief Reads single packet from the network socket.
+   * @param data bytes received from the client
+   * @param size number of bytes in data
+   *
+   * @returns size of the decoded packet including its header or 0 if data
+   *          doesn't contain a complete packet yet
+   * @throws std::runtime_error if the packet is split into several packets
    **/
-  void read_message(socket_t client_socket, int flags=0);
+  size_t decode_message(const uint8_t *data, size_t size);
 
   /** @brief Retrieves sequence number of the packet
    *
@@ -98,7 +94,6 @@ class MySQLProtocolDecoder {
     std::vector<byte> packet_buffer;
   };
 
-  const ReadCallback read_callback_;
   ProtocolPacketType packet_;
   mysql_protocol::Capabilities::Flags capabilities_;
 };
@@ -34,7 +34,6 @@ void send_packet(socket_t client_socket, const uint8_t *data, size_t size, int f
 void send_packet(socket_t client_socket,
                  const server_mock::MySQLProtocolEncoder::MsgBuffer &buffer,
                  int flags = 0);
-void read_packet(socket_t client_socket, uint8_t *data, size_t size, int flags = 0);
 int close_socket(socket_t sock);
 
 #endif // MYSQLD_MOCK_MYSQL_PROTOCOL_UTILS_INCLUDED
@@ -22,6 +22,11 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#ifdef _WIN32
+// disable the min() macro in favor of std::min() and std::numeric_limits<>::min()
+#define NOMINMAX
+#endif
+
 #include "mysql_server_mock.h"
 #include "mysql_protocol_utils.h"
 #include "json_statement_reader.h"
@@ -30,24 +35,20 @@
 #include "mysql/harness/logging/logging.h"
 IMPORT_LOG_FUNCTIONS()
 
+#include <algorithm>
 #include <cstring>
 #include <functional>
 #include <iostream>
-#include <thread>
-#include <atomic>
-#include <condition_variable>
+#include <limits>
+#include <map>
+#include <memory>
 #include <system_error>
-#include <deque>
-#include <queue>
-#include <set>
+#include <thread>
 
 #ifndef _WIN32
 #  include <netdb.h>
 #  include <netinet/in.h>
 #  include <fcntl.h>
-#  include <signal.h>
-#  include <sys/un.h>
-#  include <sys/select.h>
 #  include <sys/socket.h>
 #  include <sys/types.h>
 #  include <netinet/tcp.h>
@@ -65,14 +66,75 @@ constexpr socket_t kInvalidSocket = INVALID_SOCKET;
 constexpr socket_t kInvalidSocket = -1;
 #endif
 
-
-using namespace std::placeholders;
+#ifndef MSG_NOSIGNAL
+// a client closing the connection shouldn't kill us with SIGPIPE
+#  define MSG_NOSIGNAL 0
+#endif
 
 namespace server_mock {
 
 constexpr char kAuthCachingSha2Password[] = "caching_sha2_password";
 constexpr char kAuthNativePassword[] = "mysql_native_password";
-constexpr size_t kReadBufSize = 16 * 1024;  // size big enough to contain any packet we're likely to read
+constexpr size_t kReadBufSize = 16 * 1024;  // bytes read from a client socket at once
+
+// how long the I/O threads wait for events before checking if they should stop
+constexpr std::chrono::milliseconds kIoThreadWaitTime { 100 };
+
+// connections accepted per wakeup of an I/O thread to spread them over the threads
+constexpr size_t kMaxAcceptsPerWakeup = 16;
+
+// bytes of generated rows handed to send() at once
+constexpr size_t kRowStreamBatchSize = 256 * 1024;
+
+// with a rate limit, the rows of ~20ms are sent at once
+constexpr uint64_t kRowStreamBatchesPerSecond = 50;
+
+static bool is_would_block(int err) {
+#ifdef _WIN32
+  return err == WSAEWOULDBLOCK;
+#else
+  return err == EAGAIN || err == EWOULDBLOCK;
+#endif
+}
+
+static bool is_interrupted(int err) {
+#ifdef _WIN32
+  return err == WSAEINTR;
+#else
+  return err == EINTR;
+#endif
+}
+
+/** @brief Generated rows which are still to be sent
+ *
+ * All rows are the same, only their sequence ids differ. They are sent
+ * from a batch of pre-encoded row packets of which only the sequence ids
+ * get patched.
+ */
+struct MySQLServerMockSession::RowStream {
+  std::vector<uint8_t> batch;
+  size_t row_packet_size;
+  size_t rows_per_batch;
+
+  uint64_t rows_left;
+  uint8_t seq_no;
+
+  uint64_t rate_limit;  // bytes per second, 0 for no limit
+  EventLoop::clock_type::time_point started;
+  uint64_t bytes_sent { 0 };
+};
+
+/** @brief Sessions and event loop of one I/O thread */
+struct MySQLServerMock::IoThread {
+  EventLoop event_loop;
+  // shared with the reader threads which create their statement readers
+  std::map<socket_t, std::shared_ptr<MySQLServerMockSession>> sessions;
+
+  // last close_generation_ handled, protected by io_threads_mutex_
+  uint64_t closed_generation { 0 };
+
+  std::thread thread;
+};
 
 MySQLServerMock::MySQLServerMock(
     const std::string &expected_queries_file,
@@ -96,11 +158,20 @@ MySQLServerMock::~MySQLServerMock() {
 
 // close all active connections
 void MySQLServerMock::close_all_connections() {
-  std::lock_guard<std::mutex> active_fd_lock(active_fds_mutex_);
-  for (auto it = active_fds_.begin(); it != active_fds_.end(); ) {
-    close_socket(*it);
-    it = active_fds_.erase(it);
+  std::unique_lock<std::mutex> lk(io_threads_mutex_);
+
+  const uint64_t generation = ++close_generation_;
+  for (auto &io_thread: io_threads_) {
+    io_thread->event_loop.wakeup();
   }
+
+  // wait until every I/O thread closed its sessions
+  io_threads_cond_.wait(lk, [&]() {
+    return std::all_of(io_threads_.begin(), io_threads_.end(),
+                       [generation](const std::unique_ptr<IoThread> &io_thread) {
+                         return io_thread->closed_generation >= generation;
+                       });
+  });
 }
 
 void MySQLServerMock::run(mysql_harness::PluginFuncEnv* env) {
@@ -146,444 +217,516 @@ void MySQLServerMock::setup_service() {
   }
 }
 
-void MySQLServerMockSession::send_handshake(
-    socket_t client_socket,
-    mysql_protocol::Capabilities::Flags our_capabilities) {
-
-  constexpr const char* plugin_name = kAuthNativePassword;
-  constexpr const char* plugin_data = "123456789|ABCDEFGHI|"; // 20 bytes
-
-  std::vector<uint8_t> buf = protocol_encoder_.encode_greetings_message(
-      0, "8.0.5", 1, plugin_data, our_capabilities, plugin_name);
-  send_packet(client_socket, buf);
+void non_blocking(socket_t handle_, bool mode) {
+#ifdef _WIN32
+  u_long arg = mode ? 1 : 0;
+  ioctlsocket(handle_, FIONBIO, &arg);
+#else
+  int flags = fcntl(handle_, F_GETFL, 0);
+  fcntl(handle_, F_SETFL, (flags & ~O_NONBLOCK) | (mode ? O_NONBLOCK : 0));
+#endif
 }
 
-mysql_protocol::HandshakeResponsePacket MySQLServerMockSession::handle_handshake_response(
-    socket_t client_socket,
-    mysql_protocol::Capabilities::Flags our_capabilities) {
+class StatementReaderFactory {
+public:
+  static StatementReaderBase *create(const std::string &filename,
+      std::string &module_prefix,
+      std::map<std::string, std::string> session_data,
+      std::shared_ptr<MockServerGlobalScope> shared_globals) {
+    if (filename.substr(filename.size() - 3) == ".js") {
+      return new DuktapeStatementReader(filename, module_prefix, session_data, shared_globals);
+    } else if (filename.substr(filename.size() - 5) == ".json") {
+      return new QueriesJsonReader(filename);
+    } else {
+      throw std::runtime_error("can't create reader for " + filename);
+    }
+  }
+};
 
-  typedef std::vector<uint8_t> MsgBuffer;
-  using namespace mysql_protocol;
+void MySQLServerMock::handle_connections(mysql_harness::PluginFuncEnv* env) {
+  log_info("Starting to handle connections on port: %d", bind_port_);
 
-  uint8_t buf[kReadBufSize];
-  size_t payload_size;
-  constexpr size_t header_len = HandshakeResponsePacket::get_header_length();
+  non_blocking(listener_, true);
 
-  // receive handshake response packet
-  {
-    // reads all bytes or throws
-    read_packet(client_socket, buf, header_len);
+  const unsigned num_io_threads = std::max(1u, std::thread::hardware_concurrency());
 
-    if (HandshakeResponsePacket::read_sequence_id(buf) != 1)
-      throw std::runtime_error("Handshake response packet with incorrect sequence number: " +
-                               std::to_string(HandshakeResponsePacket::read_sequence_id(buf)));
+  {
+    std::lock_guard<std::mutex> lk(io_threads_mutex_);
+    for (unsigned ndx = 0; ndx < num_io_threads; ndx++) {
+      io_threads_.emplace_back(new IoThread);
+    }
+    for (auto &io_thread: io_threads_) {
+      io_thread->thread = std::thread(&MySQLServerMock::run_io_thread, this, std::ref(*io_thread));
+    }
+  }
+  for (unsigned ndx = 0; ndx < num_io_threads; ndx++) {
+    reader_threads_.emplace_back(&MySQLServerMock::run_reader_thread, this);
+  }
 
-    payload_size = HandshakeResponsePacket::read_payload_size(buf);
-    assert(header_len + payload_size <= sizeof(buf));
+  wait_for_stop(env, 0);
 
-    // reads all bytes or throws
-    read_packet(client_socket, buf + header_len, payload_size);
+  stopped_ = true;
+  // only this thread modifies io_threads_, no need to lock for reading it
+  for (auto &io_thread: io_threads_) {
+    io_thread->event_loop.wakeup();
+  }
+  for (auto &io_thread: io_threads_) {
+    io_thread->thread.join();
   }
 
-  // parse handshake response packet
+  // the readers still to be created are for sessions which are gone
   {
-    HandshakeResponsePacket pkt(MsgBuffer(buf, buf + header_len + payload_size));
-    try {
-      pkt.parse_payload(our_capabilities);
-
-      #if 0 // enable if you need to debug
-      pkt.debug_dump();
-      #endif
-      return pkt;
-    } catch (const std::runtime_error& e) {
-      // Dump packet contents to stdout, so we can try to debug what went wrong.
-      // Since parsing failed, this is also likely to throw. If it doesn't,
-      // great, but we'll be happy to take whatever info the dump can give us
-      // before throwing.
-      try {
-        pkt.debug_dump();
-      } catch (...) {}
+    std::lock_guard<std::mutex> lk(reader_jobs_mutex_);
+    reader_threads_stopped_ = true;
+  }
+  reader_jobs_cond_.notify_all();
+  for (auto &reader_thread: reader_threads_) {
+    reader_thread.join();
+  }
+  reader_threads_.clear();
+  reader_jobs_.clear();
 
-      throw;
-    }
+  {
+    std::lock_guard<std::mutex> lk(io_threads_mutex_);
+    io_threads_.clear();
   }
+  io_threads_cond_.notify_all();
 }
 
-void MySQLServerMockSession::handle_auth_switch(socket_t client_socket) {
+void MySQLServerMock::run_io_thread(IoThread &io_thread) {
+  auto &event_loop = io_thread.event_loop;
+  auto &sessions = io_thread.sessions;
 
-  constexpr uint8_t seq_nr = 2;
+  try {
+    // all I/O threads watch the listener, whoever wakes up first accepts
+    event_loop.add(listener_, EventLoop::kRead, [this, &io_thread](unsigned) {
+      accept_connections(io_thread);
+    });
+
+    while (!stopped_) {
+      event_loop.run_once(kIoThreadWaitTime);
+
+      // sessions can't be destroyed from their own handlers
+      for (auto it = sessions.begin(); it != sessions.end();) {
+        if (it->second->is_finished()) {
+          it = sessions.erase(it);
+        } else {
+          ++it;
+        }
+      }
 
-  // send switch-auth request packet
-  {
-    constexpr const char* plugin_data = "123456789|ABCDEFGHI|";
+      const uint64_t generation = close_generation_;
+      if (generation != io_thread.closed_generation) {
+        sessions.clear();
 
-    auto buf = protocol_encoder_.encode_auth_switch_message(
-                   seq_nr, kAuthCachingSha2Password, plugin_data);
-    send_packet(client_socket, buf);
+        {
+          std::lock_guard<std::mutex> lk(io_threads_mutex_);
+          io_thread.closed_generation = generation;
+        }
+        io_threads_cond_.notify_all();
+      }
+    }
+  } catch (const std::exception &e) {
+    log_error("I/O thread failed: %s", e.what());
   }
 
-  // receive auth-data packet
-  {
-    using namespace mysql_protocol;
-    constexpr size_t header_len = HandshakeResponsePacket::get_header_length();
+  sessions.clear();
+  event_loop.remove(listener_);
 
-    uint8_t buf[kReadBufSize];
+  // don't let close_all_connections() wait for us anymore
+  {
+    std::lock_guard<std::mutex> lk(io_threads_mutex_);
+    io_thread.closed_generation = std::numeric_limits<uint64_t>::max();
+  }
+  io_threads_cond_.notify_all();
+}
 
-    // reads all bytes or throws
-    read_packet(client_socket, buf, header_len);
+void MySQLServerMock::accept_connections(IoThread &io_thread) {
+  for (size_t accepted = 0; accepted < kMaxAcceptsPerWakeup; ) {
+    struct sockaddr_storage client_addr;
+    socklen_t addr_size = sizeof(client_addr);
 
-    if (HandshakeResponsePacket::read_sequence_id(buf) != seq_nr + 1)
-      throw std::runtime_error("Auth-change response packet with incorrect sequence number: " +
-                               std::to_string(HandshakeResponsePacket::read_sequence_id(buf)));
+    socket_t client_socket = accept(listener_, (struct sockaddr*)&client_addr, &addr_size);
+    if (client_socket == kInvalidSocket) {
+      auto accept_errno = get_socket_errno();
 
-    size_t payload_size = HandshakeResponsePacket::read_payload_size(buf);
-    assert(header_len + payload_size <= sizeof(buf));
+      // another I/O thread was faster
+      if (is_would_block(accept_errno)) return;
+      if (is_interrupted(accept_errno)) continue;
 
-    // reads all bytes or throws
-    read_packet(client_socket, buf + header_len, payload_size);
+      std::cerr << "accept() failed: errno=" << accept_errno << std::endl;
+      return;
+    }
+    accepted++;
 
-    // for now, we ignore the contents we just read, because we always positively
-    // authenticate the client
+    try {
+      sockaddr_in addr;
+      socklen_t addr_len = sizeof(addr);
+      if (-1 == getsockname(client_socket, reinterpret_cast<sockaddr *>(&addr), &addr_len)) {
+        throw std::system_error(get_socket_errno(), std::system_category(), "getsockname() failed");
+      }
+      std::shared_ptr<MySQLServerMockSession> session(new MySQLServerMockSession(
+          client_socket,
+          debug_mode_,
+          io_thread.event_loop));
+      // from here on the session owns the socket
+      client_socket = kInvalidSocket;
+
+      session->start();
+
+      if (!session->is_finished()) {
+        auto fd = session->socket();
+        io_thread.sessions[fd] = session;
+
+        create_statement_reader(session, io_thread.event_loop,
+            // expose session data json-encoded string
+            {
+              { "port", std::to_string(ntohs(addr.sin_port)) },
+            });
+      }
+    } catch (const std::exception &e) {
+      if (client_socket != kInvalidSocket) {
+        // close the connection before Session took over.
+        try {
+          send_packet(client_socket,
+              MySQLProtocolEncoder().encode_error_message(
+                0, 1064, "", "reader error: " + std::string(e.what())),
+              MSG_NOSIGNAL);
+        } catch (...) {}
+        close_socket(client_socket);
+      }
+      log_error("%s", e.what());
+    }
   }
-
 }
 
-void MySQLServerMockSession::send_fast_auth(socket_t client_socket) {
-  // a mysql-8 client will send us a cache-256-password-scramble
-  // and expects a \x03 back (fast-auth) + a OK packet
-  // Here we send the 1st of the two.
+void MySQLServerMock::create_statement_reader(
+    std::weak_ptr<MySQLServerMockSession> session,
+    EventLoop &event_loop,
+    std::map<std::string, std::string> session_data) {
+  {
+    std::lock_guard<std::mutex> lk(reader_jobs_mutex_);
+    reader_jobs_.emplace_back([this, session, &event_loop, session_data]() {
+      struct Result {
+        std::unique_ptr<StatementReaderBase> reader;
+        std::string error;
+      };
+      auto result = std::make_shared<Result>();
 
-  // pretend we do cached_sha256 fast-auth
-  constexpr uint8_t seq_nr = 4;
-  constexpr uint8_t fast_auth_cmd = 3;
-  constexpr uint8_t payload_size_bytes[] = {1, 0, 0};
-  constexpr uint8_t switch_auth[] = {payload_size_bytes[0], payload_size_bytes[1], payload_size_bytes[2],
-                                     seq_nr, fast_auth_cmd};
+      try {
+        result->reader.reset(StatementReaderFactory::create(
+            expected_queries_file_, module_prefix_, session_data, shared_globals_));
+      } catch (const std::exception &e) {
+        result->error = e.what();
+        log_error("%s", e.what());
+      }
 
-  send_packet(client_socket, switch_auth, sizeof(switch_auth));
+      // the session may only be touched by its I/O thread
+      event_loop.post([session, result]() {
+        if (auto locked_session = session.lock()) {
+          locked_session->set_statement_reader(std::move(result->reader), result->error);
+        }
+      });
+    });
+  }
+  reader_jobs_cond_.notify_one();
 }
 
-void non_blocking(socket_t handle_, bool mode) {
-#ifdef _WIN32
-  u_long arg = mode ? 1 : 0;
-  ioctlsocket(handle_, FIONBIO, &arg);
-#else
-  int flags = fcntl(handle_, F_GETFL, 0);
-  fcntl(handle_, F_SETFL, (flags & ~O_NONBLOCK) | (mode ? O_NONBLOCK : 0));
-#endif
-}
+void MySQLServerMock::run_reader_thread() {
+  std::unique_lock<std::mutex> lk(reader_jobs_mutex_);
 
-class StatementReaderFactory {
-public:
-  static StatementReaderBase *create(const std::string &filename,
-      std::string &module_prefix,
-      std::map<std::string, std::string> session_data,
-      std::shared_ptr<MockServerGlobalScope> shared_globals) {
-    if (filename.substr(filename.size() - 3) == ".js") {
-      return new DuktapeStatementReader(filename, module_prefix, session_data, shared_globals);
-    } else if (filename.substr(filename.size() - 5) == ".json") {
-      return new QueriesJsonReader(filename);
-    } else {
-      throw std::runtime_error("can't create reader for " + filename);
-    }
+  while (true) {
+    reader_jobs_cond_.wait(lk, [this]() {
+      return reader_threads_stopped_ || !reader_jobs_.empty();
+    });
+    if (reader_threads_stopped_) return;
+
+    auto job = std::move(reader_jobs_.front());
+    reader_jobs_.pop_front();
+
+    lk.unlock();
+    job();
+    lk.lock();
   }
-};
+}
 
 MySQLServerMockSession::MySQLServerMockSession(
     socket_t client_sock,
-    std::unique_ptr<StatementReaderBase> statement_processor,
-    bool debug_mode):
+    bool debug_mode,
+    EventLoop &event_loop):
   client_socket_{client_sock},
-  protocol_decoder_{&read_packet},
-  json_reader_{std::move(statement_processor)},
-  debug_mode_{debug_mode}
+  debug_mode_{debug_mode},
+  event_loop_(event_loop)
 {
   // if it doesn't work, no problem.
   int one = 1;
   setsockopt(client_socket_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&one), sizeof(one));
 
-  non_blocking(client_socket_, false);
-
+  non_blocking(client_socket_, true);
 }
 
 MySQLServerMockSession::~MySQLServerMockSession() {
+  if (exec_timer_) event_loop_.cancel_timer(exec_timer_);
+  if (watched_events_) event_loop_.remove(client_socket_);
+
+  close_socket(client_socket_);
 }
 
-void MySQLServerMockSession::run() {
-  try {
-    ////////////////////////////////////////////////////////////////////////////////
-    //
-    // This is the handshake packet that my server v8.0.5 emits:
-    //
-    //        <header >   v10  <--- server version
-    //  0000: 6c00 0000   0a   38 2e30 2e35 2d65 6e74 6572 7072 6973 652d 636f 6d6d 6572 6369 616c            l....8.0.5-enterprise-commercial
-    //
-    //                         server version -> <conn id> <-- auth data 1 -->  zero cap.low char status
-    //  0020: 2d61 6476 616e 6365 642d 6c6f 6700 0800 0000 5b09 4e78 3d48 0a11   00   ff ff   ff   0200       -advanced-log.....[.Nx=H........
-    //
-    //      cap.hi  auth-len  <- reserved 10 0-bytes ->   <SECURE_CONN && auth-data 2    >   <PLUGIN_AUTH && auth-plugin name
-    //  0040: ffc3     15     00 0000 0000 0000 0000 00   64 1242 070c 5263 2d01 710c 4100   6361 6368 696e   .............d.B..Rc-.q.A.cachin
-    //
-    //        auth-plugin name --------------------->
-    //  0060: 675f 7368 6132 5f70 6173 7377 6f72 6400                                                         g_sha2_password.
-    //
-    //
-    //  client v8.0.5 reponds with capability flags: 05ae ff01
-    //
-    ////////////////////////////////////////////////////////////////////////////////
-
-    using namespace mysql_protocol;
-
-    constexpr Capabilities::Flags our_capabilities = Capabilities::PROTOCOL_41
-                                                   | Capabilities::PLUGIN_AUTH
-                                                   | Capabilities::SECURE_CONNECTION;
-
-    send_handshake(client_socket_, our_capabilities);
-    HandshakeResponsePacket handshake_response = handle_handshake_response(
-                                                     client_socket_, our_capabilities);
-
-    uint8_t packet_seq = 2u;
-    if (handshake_response.get_auth_plugin() == kAuthCachingSha2Password) {
-      // typically, client >= 8.0.4 will trigger this branch
-
-      handle_auth_switch(client_socket_);
-      send_fast_auth(client_socket_);
-      packet_seq += 3;  // 2 from auth-switch + 1 from fast-auth
-
-    } else if (handshake_response.get_auth_plugin() == kAuthNativePassword) {
-      // typically, client <= 5.7 will trigger this branch; do nothing, we're good
-    } else {
-      // unexpected auth-plugin name
-      assert(0);
-    }
+void MySQLServerMockSession::start() {
+  ////////////////////////////////////////////////////////////////////////////////
+  //
+  // This is the handshake packet that my server v8.0.5 emits:
+  //
+  //        <header >   v10  <--- server version
+  //  0000: 6c00 0000   0a   38 2e30 2e35 2d65 6e74 6572 7072 6973 652d 636f 6d6d 6572 6369 616c            l....8.0.5-enterprise-commercial
+  //
+  //                         server version -> <conn id> <-- auth data 1 -->  zero cap.low char status
+  //  0020: 2d61 6476 616e 6365 642d 6c6f 6700 0800 0000 5b09 4e78 3d48 0a11   00   ff ff   ff   0200       -advanced-log.....[.Nx=H........
+  //
+  //      cap.hi  auth-len  <- reserved 10 0-bytes ->   <SECURE_CONN && auth-data 2    >   <PLUGIN_AUTH && auth-plugin name
+  //  0040: ffc3     15     00 0000 0000 0000 0000 00   64 1242 070c 5263 2d01 710c 4100   6361 6368 696e   .............d.B..Rc-.q.A.cachin
+  //
+  //        auth-plugin name --------------------->
+  //  0060: 675f 7368 6132 5f70 6173 7377 6f72 6400                                                         g_sha2_password.
+  //
+  //
+  //  client v8.0.5 reponds with capability flags: 05ae ff01
+  //
+  ////////////////////////////////////////////////////////////////////////////////
 
-    send_ok(client_socket_, packet_seq);
+  using namespace mysql_protocol;
 
-    bool res = process_statements(client_socket_);
-    if (!res) {
-      std::cout << "Error processing statements with client: " << client_socket_ << std::endl;
-    }
-  }
-  catch (const std::exception &e) {
+  constexpr Capabilities::Flags our_capabilities = Capabilities::PROTOCOL_41
+                                                 | Capabilities::PLUGIN_AUTH
+                                                 | Capabilities::SECURE_CONNECTION;
+
+  constexpr const char* plugin_name = kAuthNativePassword;
+  constexpr const char* plugin_data = "123456789|ABCDEFGHI|"; // 20 bytes
+
+  watched_events_ = EventLoop::kRead;
+  event_loop_.add(client_socket_, watched_events_, [this](unsigned events) {
+    on_io(events);
+  });
+
+  send(protocol_encoder_.encode_greetings_message(
+      0, "8.0.5", 1, plugin_data, our_capabilities, plugin_name));
+}
+
+void MySQLServerMockSession::set_statement_reader(
+    std::unique_ptr<StatementReaderBase> statement_processor,
+    const std::string &error) {
+  json_reader_ = std::move(statement_processor);
+  reader_error_ = error;
+
+  // commands which arrived in the meantime
+  if (state_ != State::kCommand) return;
+
+  try {
+    process_input();
+  } catch (const std::exception &e) {
     log_warning("Exception caught in connection loop: %s", e.what());
+    finish();
   }
 }
 
-struct Work {
-  socket_t client_socket;
-  std::string expected_queries_file;
-  std::string module_prefix;
-  bool debug_mode;
-};
+void MySQLServerMockSession::on_io(unsigned events) {
+  // finished earlier in this round of events
+  if (state_ == State::kFinished) return;
 
-template<typename Data>
-class concurrent_queue {
-public:
-  Data pop() {
-    std::unique_lock<std::mutex> mlock(mutex_);
+  try {
+    if (events & EventLoop::kWrite) flush();
+    if (state_ == State::kFinished) return;
 
-    while(queue_.empty()) {
-      cond_.wait(mlock);
+    if (events & EventLoop::kRead) {
+      on_readable();
+    } else {
+      // a row stream may have ended
+      process_input();
     }
-
-    auto item = queue_.front();
-    queue_.pop();
-    return item;
+  } catch (const std::exception &e) {
+    log_warning("Exception caught in connection loop: %s", e.what());
+    finish();
   }
+}
 
-  void push(Data&& item) {
-    std::unique_lock<std::mutex> mlock(mutex_);
+void MySQLServerMockSession::on_readable() {
+  uint8_t buf[kReadBufSize];
 
-    queue_.push(std::move(item));
+  while (state_ != State::kFinished) {
+    auto received = recv(client_socket_, reinterpret_cast<char*>(buf), sizeof(buf), 0);
+    if (received < 0) {
+      auto err = get_socket_errno();
+      if (is_would_block(err)) break;
+      if (is_interrupted(err)) continue;
+
+      throw std::system_error(err, std::system_category(), "recv() failed");
+    } else if (received == 0) {
+      // connection closed by client
+      finish();
+      return;
+    }
 
-    mlock.unlock();
-    cond_.notify_one();
+    in_buf_.insert(in_buf_.end(), buf, buf + received);
   }
 
-private:
-  std::queue<Data> queue_;
-  std::mutex mutex_;
-  std::condition_variable cond_;
-};
-
-void MySQLServerMock::handle_connections(mysql_harness::PluginFuncEnv* env) {
-  struct sockaddr_storage client_addr;
-  socklen_t addr_size = sizeof(client_addr);
-
-  log_info("Starting to handle connections on port: %d", bind_port_);
+  process_input();
+}
 
-  concurrent_queue<Work> work_queue;
-  concurrent_queue<socket_t> socket_queue;
+void MySQLServerMockSession::process_input() {
+  size_t consumed = 0;
 
-  auto connection_handler = [&]() -> void {
-    while (true) {
-      auto work = work_queue.pop();
+  // statements are executed one after another, the next one is looked at
+  // once the response to the previous one is queued
+  while (state_ == State::kHandshakeResponse ||
+         state_ == State::kAuthSwitchResponse ||
+         state_ == State::kCommand) {
+    // the statement reader is still being created
+    if (state_ == State::kCommand && !json_reader_ && reader_error_.empty()) break;
 
-      // exit
-      if (work.client_socket == kInvalidSocket) break;
+    const size_t packet_size = protocol_decoder_.decode_message(
+        in_buf_.data() + consumed, in_buf_.size() - consumed);
+    if (packet_size == 0) break;  // wait for more data
 
-      try {
-        sockaddr_in addr;
-        socklen_t addr_len = sizeof(addr);
-        if (-1 == getsockname(work.client_socket, reinterpret_cast<sockaddr *>(&addr), &addr_len)) {
-          throw std::system_error(get_socket_errno(), std::system_category(), "getsockname() failed");
-        }
-        std::unique_ptr<StatementReaderBase> statement_reader {
-          StatementReaderFactory::create(
-              work.expected_queries_file,
-              work.module_prefix,
-              // expose session data json-encoded string
-              {
-                { "port", std::to_string(ntohs(addr.sin_port)) },
-              },
-              shared_globals_)};
-
-        MySQLServerMockSession session(
-            work.client_socket,
-            std::move(statement_reader),
-            work.debug_mode);
-        try {
-          session.run();
-        } catch (const std::exception &e) {
-          log_error("%s", e.what());
-        }
-      } catch (const std::exception &e) {
-        // close the connection before Session took over.
-        send_packet(work.client_socket,
-            MySQLProtocolEncoder().encode_error_message(
-              0, 1064, "", "reader error: " + std::string(e.what())),
-            0);
-        log_error("%s", e.what());
-      }
+    const uint8_t *packet = in_buf_.data() + consumed;
+    consumed += packet_size;
 
-      // first remove the book-keeping, then close the socket
-      // to avoid a race between the acceptor and the worker thread
-      {
-        // socket is done, unregister it
-        std::lock_guard<std::mutex> active_fd_lock(active_fds_mutex_);
-        auto it = active_fds_.find(work.client_socket);
-        if (it != active_fds_.end()) {
-          // it should always be there
-          active_fds_.erase(it);
-        }
-      }
-      close_socket(work.client_socket);
+    switch (state_) {
+    case State::kHandshakeResponse:
+      handle_handshake_response(packet, packet_size);
+      break;
+    case State::kAuthSwitchResponse:
+      handle_auth_switch_response();
+      break;
+    default:
+      handle_command();
     }
-  };
-
-  non_blocking(listener_, true);
-
-  std::deque<std::thread> worker_threads;
-  for (size_t ndx = 0; ndx < 4; ndx++) {
-    worker_threads.emplace_back(connection_handler);
   }
 
-  while (is_running(env)) {
-    fd_set fds;
-    FD_ZERO (&fds);
-    FD_SET (listener_, &fds);
+  in_buf_.erase(in_buf_.begin(), in_buf_.begin() + static_cast<std::ptrdiff_t>(consumed));
+}
+
+void MySQLServerMockSession::handle_handshake_response(const uint8_t *packet, size_t size) {
+  typedef std::vector<uint8_t> MsgBuffer;
+  using namespace mysql_protocol;
 
-    // timeval is initialized in loop because value of timeval may be overriden by calling select.
-    timeval tv;
-    tv.tv_sec = 0;
-    tv.tv_usec = 10000;
+  constexpr Capabilities::Flags our_capabilities = Capabilities::PROTOCOL_41
+                                                 | Capabilities::PLUGIN_AUTH
+                                                 | Capabilities::SECURE_CONNECTION;
 
-    int err = select (listener_ + 1, &fds, NULL, NULL, &tv);
+  if (protocol_decoder_.packet_seq() != 1)
+    throw std::runtime_error("Handshake response packet with incorrect sequence number: " +
+                             std::to_string(protocol_decoder_.packet_seq()));
 
-    if (err < 0) {
-      std::cerr << "select() failed: " << strerror(errno) << "\n";
-      break;
-    } else if (err == 0) {
-      // timeout
-      continue;
-    }
+  HandshakeResponsePacket pkt(MsgBuffer(packet, packet + size));
+  try {
+    pkt.parse_payload(our_capabilities);
+
+    #if 0 // enable if you need to debug
+    pkt.debug_dump();
+    #endif
+  } catch (const std::runtime_error& e) {
+    // Dump packet contents to stdout, so we can try to debug what went wrong.
+    // Since parsing failed, this is also likely to throw. If it doesn't,
+    // great, but we'll be happy to take whatever info the dump can give us
+    // before throwing.
+    try {
+      pkt.debug_dump();
+    } catch (...) {}
 
-    if (FD_ISSET(listener_, &fds)) {
-      while (true) {
-        socket_t client_socket = accept(listener_, (struct sockaddr*)&client_addr, &addr_size);
-        if (client_socket == kInvalidSocket) {
-          auto accept_errno = get_socket_errno();
+    throw;
+  }
 
-          // if we got interrupted at shutdown, just leave
-          if (!is_running(env)) break;
+  if (pkt.get_auth_plugin() == kAuthCachingSha2Password) {
+    // typically, client >= 8.0.4 will trigger this branch
+    constexpr uint8_t seq_nr = 2;
+    constexpr const char* plugin_data = "123456789|ABCDEFGHI|";
 
-          if (accept_errno == EAGAIN) break;
-          if (accept_errno == EWOULDBLOCK) break;
-#ifdef _WIN32
-          if (accept_errno == WSAEWOULDBLOCK) break;
-          if (accept_errno == WSAEINTR) continue;
-#endif
-          if (accept_errno == EINTR) continue;
+    send(protocol_encoder_.encode_auth_switch_message(
+             seq_nr, kAuthCachingSha2Password, plugin_data));
+    state_ = State::kAuthSwitchResponse;
+  } else if (pkt.get_auth_plugin() == kAuthNativePassword) {
+    // typically, client <= 5.7 will trigger this branch; do nothing, we're good
+    send_ok(2);
+    state_ = State::kCommand;
+  } else {
+    // unexpected auth-plugin name
+    assert(0);
+  }
+}
 
-          std::cerr << "accept() failed: errno=" << accept_errno << std::endl;
-          return;
-        }
+void MySQLServerMockSession::handle_auth_switch_response() {
+  constexpr uint8_t seq_nr = 2;
 
-        {
-          // socket is new, register it
-          std::lock_guard<std::mutex> active_fd_lock(active_fds_mutex_);
-          active_fds_.emplace(client_socket);
-        }
+  if (protocol_decoder_.packet_seq() != seq_nr + 1)
+    throw std::runtime_error("Auth-change response packet with incorrect sequence number: " +
+                             std::to_string(protocol_decoder_.packet_seq()));
 
-        // std::cout << "Accepted client " << client_socket << std::endl;
-        work_queue.push(Work {client_socket, expected_queries_file_, module_prefix_, debug_mode_});
-      }
-    }
-  }
+  // for now, we ignore the contents we just read, because we always positively
+  // authenticate the client
 
-  // beware, this closes all sockets that are either in the work-queue or
-  // currently handled by worker-threads. As long as we don't reuse the file-handles
-  // for anything else before we leave this function, this approach is safe.
-  close_all_connections();
+  // a mysql-8 client will send us a cache-256-password-scramble
+  // and expects a \x03 back (fast-auth) + a OK packet
+  //
+  // pretend we do cached_sha256 fast-auth
+  constexpr uint8_t fast_auth_seq_nr = seq_nr + 2;
+  constexpr uint8_t fast_auth_cmd = 3;
+  send({1, 0, 0, fast_auth_seq_nr, fast_auth_cmd});
 
-  // std::cerr << "sending death-signal to threads" << std::endl;
-  for (size_t ndx = 0; ndx < worker_threads.size(); ndx++) {
-    work_queue.push(Work { kInvalidSocket, "", "", 0});
-  }
-  // std::cerr << "joining threads" << std::endl;
-  for (size_t ndx = 0; ndx < worker_threads.size(); ndx++) {
-    worker_threads[ndx].join();
-  }
-  // std::cerr << "done" << std::endl;
+  send_ok(fast_auth_seq_nr + 1);
+  state_ = State::kCommand;
 }
 
-bool MySQLServerMockSession::process_statements(socket_t client_socket) {
+void MySQLServerMockSession::handle_command() {
   using mysql_protocol::Command;
 
-  while (!killed_) {
-    protocol_decoder_.read_message(client_socket);
-    auto cmd = protocol_decoder_.get_command_type();
-    switch (cmd) {
-    case Command::QUERY: {
-      std::string statement_received = protocol_decoder_.get_statement();
+  if (!json_reader_) {
+    uint8_t packet_seq = protocol_decoder_.packet_seq() + 1;   // rollover to 0 is ok
+    respond(std::chrono::microseconds(0),
+            protocol_encoder_.encode_error_message(
+                packet_seq, 1064, "", "reader error: " + reader_error_),
+            true);
+    return;
+  }
 
-      try {
-        handle_statement(client_socket, protocol_decoder_.packet_seq(),
-            json_reader_->handle_statement(statement_received));
-      } catch (const std::exception &e) {
-        // handling statement failed. Return the error to the client
-        uint8_t packet_seq = protocol_decoder_.packet_seq() + 1;   // rollover to 0 is ok
-        std::this_thread::sleep_for(json_reader_->get_default_exec_time());
-        send_error(client_socket, packet_seq, 1064, std::string("executing statement failed: ") + e.what());
+  auto cmd = protocol_decoder_.get_command_type();
+  switch (cmd) {
+  case Command::QUERY: {
+    std::string statement_received = protocol_decoder_.get_statement();
 
-        // assume the connection is broken
-        return true;
-      }
-    }
-    break;
-    case Command::QUIT:
-      // std::cout << "received QUIT command from the client" << std::endl;
-      return true;
-    default:
-      std::cerr << "received unsupported command from the client: "
-                << static_cast<int>(cmd) << "\n";
+    try {
+      handle_statement(protocol_decoder_.packet_seq(),
+          json_reader_->handle_statement(statement_received));
+    } catch (const std::exception &e) {
+      // handling statement failed. Return the error to the client
       uint8_t packet_seq = protocol_decoder_.packet_seq() + 1;   // rollover to 0 is ok
-      std::this_thread::sleep_for(json_reader_->get_default_exec_time());
-      send_error(client_socket, packet_seq, 1064, "Unsupported command: " + std::to_string(cmd));
+
+      // assume the connection is broken
+      respond(json_reader_->get_default_exec_time(),
+              protocol_encoder_.encode_error_message(
+                  packet_seq, 1064, "HY000",
+                  std::string("executing statement failed: ") + e.what()),
+              true);
     }
   }
+  break;
+  case Command::QUIT:
+    // std::cout << "received QUIT command from the client" << std::endl;
+    finish();
+    break;
+  default:
+    std::cerr << "received unsupported command from the client: "
+              << static_cast<int>(cmd) << "\n";
+    uint8_t packet_seq = protocol_decoder_.packet_seq() + 1;   // rollover to 0 is ok
+    respond(json_reader_->get_default_exec_time(),
+            protocol_encoder_.encode_error_message(
+                packet_seq, 1064, "HY000", "Unsupported command: " + std::to_string(cmd)));
+  }
+}
 
-  return true;
+static void debug_trace_generated_result(const GeneratedResultsetResponse *resultset) {
+  std::cout << "QUERY RESULT: " << resultset->row_count << " generated rows of "
+            << resultset->columns.size() << " fields with " << resultset->value_length
+            << " bytes each\n\n\n" << std::flush;
 }
 
 static void debug_trace_result(const ResultsetResponse *resultset) {
@@ -596,46 +739,67 @@ static void debug_trace_result(const ResultsetResponse *resultset) {
   std::cout << "\n\n\n" << std::flush;
 }
 
-void MySQLServerMockSession::handle_statement(socket_t client_socket, uint8_t seq_no,
+void MySQLServerMockSession::handle_statement(uint8_t seq_no,
                     const StatementAndResponse& statement) {
   using StatementResponseType = StatementAndResponse::StatementResponseType;
 
   switch (statement.response_type) {
   case StatementResponseType::STMT_RES_OK: {
     if (debug_mode_) std::cout << std::endl;  // visual separator
-    OkResponse *response = dynamic_cast<OkResponse *>(statement.response.get());
-    std::this_thread::sleep_for(statement.exec_time);
-    send_ok(client_socket, static_cast<uint8_t>(seq_no+1), 0, response->last_insert_id, 0, response->warning_count);
+    const OkResponse *response = dynamic_cast<const OkResponse *>(statement.response.get());
+    respond(statement.exec_time,
+            protocol_encoder_.encode_ok_message(static_cast<uint8_t>(seq_no+1), 0,
+                response->last_insert_id, 0, response->warning_count));
   }
   break;
   case StatementResponseType::STMT_RES_RESULT: {
-    ResultsetResponse *response = dynamic_cast<ResultsetResponse *>(statement.response.get());
+    const ResultsetResponse *response = dynamic_cast<const ResultsetResponse *>(statement.response.get());
     if (debug_mode_) {
       debug_trace_result(response);
     }
     seq_no = static_cast<uint8_t>(seq_no + 1);
     auto buf = protocol_encoder_.encode_columns_number_message(seq_no++, response->columns.size());
-    std::this_thread::sleep_for(statement.exec_time);
-    send_packet(client_socket, buf);
     for (const auto& column: response->columns) {
       auto col_buf = protocol_encoder_.encode_column_meta_message(seq_no++, column);
-      send_packet(client_socket, col_buf);
+      buf.insert(buf.end(), col_buf.begin(), col_buf.end());
     }
-    buf = protocol_encoder_.encode_eof_message(seq_no++);
-    send_packet(client_socket, buf);
+    auto eof_buf = protocol_encoder_.encode_eof_message(seq_no++);
+    buf.insert(buf.end(), eof_buf.begin(), eof_buf.end());
 
     for (size_t i = 0; i < response->rows.size(); ++i) {
       auto res_buf = protocol_encoder_.encode_row_message(seq_no++, response->columns, response->rows[i]);
-      send_packet(client_socket, res_buf);
+      buf.insert(buf.end(), res_buf.begin(), res_buf.end());
     }
-    buf = protocol_encoder_.encode_eof_message(seq_no++);
-    send_packet(client_socket, buf);
+    eof_buf = protocol_encoder_.encode_eof_message(seq_no++);
+    buf.insert(buf.end(), eof_buf.begin(), eof_buf.end());
+
+    respond(statement.exec_time, std::move(buf));
+  }
+  break;
+  case StatementResponseType::STMT_RES_GENERATED_RESULT: {
+    const GeneratedResultsetResponse *response = dynamic_cast<const GeneratedResultsetResponse *>(statement.response.get());
+    if (debug_mode_) {
+      debug_trace_generated_result(response);
+    }
+    seq_no = static_cast<uint8_t>(seq_no + 1);
+    auto buf = protocol_encoder_.encode_columns_number_message(seq_no++, response->columns.size());
+    for (const auto& column: response->columns) {
+      auto col_buf = protocol_encoder_.encode_column_meta_message(seq_no++, column);
+      buf.insert(buf.end(), col_buf.begin(), col_buf.end());
+    }
+    auto eof_buf = protocol_encoder_.encode_eof_message(seq_no++);
+    buf.insert(buf.end(), eof_buf.begin(), eof_buf.end());
+
+    // the rows and the final EOF follow the metadata
+    start_row_stream(*response, seq_no);
+
+    respond(statement.exec_time, std::move(buf));
   }
   break;
   case StatementResponseType::STMT_RES_ERROR: {
     if (debug_mode_) std::cout << std::endl;  // visual separator
-    ErrorResponse *response = dynamic_cast<ErrorResponse *>(statement.response.get());
-    send_error(client_socket, static_cast<uint8_t>(seq_no+1), response->code, response->msg);
+    const ErrorResponse *response = dynamic_cast<const ErrorResponse *>(statement.response.get());
+    send_error(static_cast<uint8_t>(seq_no+1), response->code, response->msg);
   }
   break;
   default:;
@@ -644,22 +808,209 @@ void MySQLServerMockSession::handle_statement(socket_t client_socket, uint8_t se
   }
 }
 
-void MySQLServerMockSession::send_error(socket_t client_socket, uint8_t seq_no,
+void MySQLServerMockSession::respond(std::chrono::microseconds exec_time,
+                                     std::vector<uint8_t> response,
+                                     bool close_after) {
+  const State next_state = close_after ? State::kClosing
+                         : row_stream_ ? State::kStreaming
+                         : State::kCommand;
+
+  // the state has to be set before sending as flush() acts on it
+  if (exec_time.count() <= 0) {
+    state_ = next_state;
+    send(response);
+    return;
+  }
+
+  // don't look at further commands while "executing" this one
+  state_ = State::kExecuting;
+
+  auto pending_response = std::make_shared<std::vector<uint8_t>>(std::move(response));
+  exec_timer_ = event_loop_.add_timer(exec_time,
+      [this, pending_response, next_state]() {
+        exec_timer_ = 0;
+        try {
+          state_ = next_state;
+          send(*pending_response);
+          process_input();
+        } catch (const std::exception &e) {
+          log_warning("Exception caught in connection loop: %s", e.what());
+          finish();
+        }
+      });
+}
+
+void MySQLServerMockSession::send_error(uint8_t seq_no,
                                  uint16_t error_code,
                                  const std::string &error_msg,
                                  const std::string &sql_state) {
-  auto buf = protocol_encoder_.encode_error_message(seq_no, error_code,
-                                                    sql_state, error_msg);
-  send_packet(client_socket, buf);
+  send(protocol_encoder_.encode_error_message(seq_no, error_code,
+                                              sql_state, error_msg));
 }
 
-void MySQLServerMockSession::send_ok(socket_t client_socket, uint8_t seq_no,
+void MySQLServerMockSession::send_ok(uint8_t seq_no,
     uint64_t affected_rows,
     uint64_t last_insert_id,
     uint16_t server_status,
     uint16_t warning_count) {
-  auto buf = protocol_encoder_.encode_ok_message(seq_no, affected_rows, last_insert_id, server_status, warning_count);
-  send_packet(client_socket, buf);
+  send(protocol_encoder_.encode_ok_message(seq_no, affected_rows, last_insert_id, server_status, warning_count));
+}
+
+void MySQLServerMockSession::send(const std::vector<uint8_t> &buf) {
+  if (state_ == State::kFinished) return;
+
+  out_buf_.insert(out_buf_.end(), buf.begin(), buf.end());
+  flush();
+}
+
+void MySQLServerMockSession::flush() {
+  while (send_buffered() && row_stream_ && buffer_next_rows());
+
+  if (out_buf_.empty() && state_ == State::kClosing) {
+    finish();
+    return;
+  }
+
+  update_watched_events();
+}
+
+bool MySQLServerMockSession::send_buffered() {
+  while (out_buf_offset_ < out_buf_.size()) {
+    auto sent = ::send(client_socket_,
+                       reinterpret_cast<const char*>(out_buf_.data()) + out_buf_offset_,
+                       out_buf_.size() - out_buf_offset_, MSG_NOSIGNAL);
+    if (sent < 0) {
+      auto err = get_socket_errno();
+      if (is_would_block(err)) return false;
+      if (is_interrupted(err)) continue;
+
+      throw std::system_error(err, std::system_category(), "send() failed");
+    }
+    out_buf_offset_ += static_cast<size_t>(sent);
+  }
+
+  // keeps the capacity for the next packets
+  out_buf_.clear();
+  out_buf_offset_ = 0;
+
+  return true;
+}
+
+void MySQLServerMockSession::start_row_stream(const GeneratedResultsetResponse &response,
+                                              uint8_t seq_no) {
+  // digits are a valid value for numeric and string columns alike
+  std::string value(response.value_length, '0');
+  for (size_t i = 0; i < value.size(); ++i) {
+    value[i] = static_cast<char>('0' + (i + 1) % 10);
+  }
+
+  const RowValueType row(response.columns.size(), std::make_pair(true, value));
+  const auto row_packet = protocol_encoder_.encode_row_message(0, response.columns, row);
+
+  if (row_packet.size() - 4 >= 0xffffff) {
+    throw std::runtime_error("generated rows don't fit into a single packet");
+  }
+
+  std::unique_ptr<RowStream> stream(new RowStream);
+  stream->row_packet_size = row_packet.size();
+
+  size_t batch_size = kRowStreamBatchSize;
+  if (response.rate_limit > 0) {
+    batch_size = std::min(batch_size,
+        static_cast<size_t>(response.rate_limit / kRowStreamBatchesPerSecond));
+  }
+  stream->rows_per_batch = std::max(size_t{1}, batch_size / row_packet.size());
+  if (stream->rows_per_batch > response.row_count) {
+    stream->rows_per_batch = std::max(uint64_t{1}, response.row_count);
+  }
+
+  stream->batch.reserve(stream->rows_per_batch * row_packet.size());
+  for (size_t i = 0; i < stream->rows_per_batch; ++i) {
+    stream->batch.insert(stream->batch.end(), row_packet.begin(), row_packet.end());
+  }
+
+  stream->rows_left = response.row_count;
+  stream->seq_no = seq_no;
+  stream->rate_limit = response.rate_limit;
+  stream->started = EventLoop::clock_type::now();
+
+  row_stream_ = std::move(stream);
+}
+
+bool MySQLServerMockSession::buffer_next_rows() {
+  auto &stream = *row_stream_;
+
+  if (stream.rows_left == 0) {
+    auto eof_buf = protocol_encoder_.encode_eof_message(stream.seq_no);
+    out_buf_.insert(out_buf_.end(), eof_buf.begin(), eof_buf.end());
+
+    row_stream_.reset();
+    if (state_ == State::kStreaming) state_ = State::kCommand;
+
+    return true;
+  }
+
+  if (stream.rate_limit > 0) {
+    // when the bytes sent so far are allowed to have been sent
+    const auto due = stream.started + std::chrono::duration_cast<EventLoop::clock_type::duration>(
+        std::chrono::duration<double>(static_cast<double>(stream.bytes_sent) / stream.rate_limit));
+    const auto now = EventLoop::clock_type::now();
+
+    if (now < due) {
+      exec_timer_ = event_loop_.add_timer(
+          std::chrono::duration_cast<std::chrono::microseconds>(due - now),
+          [this]() {
+            exec_timer_ = 0;
+            try {
+              flush();
+              process_input();
+            } catch (const std::exception &e) {
+              log_warning("Exception caught in connection loop: %s", e.what());
+              finish();
+            }
+          });
+
+      return false;
+    }
+  }
+
+  const size_t rows = static_cast<size_t>(std::min<uint64_t>(stream.rows_left, stream.rows_per_batch));
+  const size_t size = rows * stream.row_packet_size;
+
+  for (size_t ndx = 0; ndx < rows; ++ndx) {
+    stream.batch[ndx * stream.row_packet_size + 3] = stream.seq_no++;
+  }
+  out_buf_.insert(out_buf_.end(), stream.batch.begin(), stream.batch.begin() + static_cast<std::ptrdiff_t>(size));
+
+  stream.rows_left -= rows;
+  stream.bytes_sent += size;
+
+  return true;
+}
+
+void MySQLServerMockSession::update_watched_events() {
+  if (state_ == State::kFinished) return;
+
+  unsigned events = 0;
+  // stop reading once we only wait for the output to drain
+  if (state_ != State::kClosing) events |= EventLoop::kRead;
+  if (!out_buf_.empty()) events |= EventLoop::kWrite;
+
+  if (events == watched_events_) return;
+
+  event_loop_.modify(client_socket_, events);
+  watched_events_ = events;
+}
+
+void MySQLServerMockSession::finish() {
+  if (state_ == State::kFinished) return;
+  state_ = State::kFinished;
+
+  if (exec_timer_) {
+    event_loop_.cancel_timer(exec_timer_);
+    exec_timer_ = 0;
+  }
+  // the socket gets closed when the session is destroyed
 }
 
 } // namespace server_mock
@@ -25,10 +25,17 @@
 #ifndef MYSQLD_MOCK_MYSQL_SERVER_MOCK_INCLUDED
 #define MYSQLD_MOCK_MYSQL_SERVER_MOCK_INCLUDED
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
-#include <set>
+#include <thread>
+#include <vector>
 
+#include "event_loop.h"
 #include "statement_reader.h"
 #include "mysql_protocol_decoder.h"
 #include "mysql_protocol_encoder.h"
@@ -37,53 +44,132 @@
 
 namespace server_mock {
 
+/** @class MySQLServerMockSession
+ *
+ * @brief Handles a client connection as a state machine driven by an EventLoop
+ *
+ * The session never blocks: input is buffered until a complete packet
+ * arrived, output is buffered until the socket is writable and the
+ * execution time of a statement is waited for with a timer of the loop.
+ *
+ * Commands are only handled once the statement reader is set.
+ **/
 class MySQLServerMockSession {
 public:
   MySQLServerMockSession(socket_t client_sock,
-      std::unique_ptr<StatementReaderBase> statement_processor,
-      bool debug_mode);
+      bool debug_mode,
+      EventLoop &event_loop);
 
+  /** @brief Stops watching the client socket and closes it */
   ~MySQLServerMockSession();
 
-  void send_handshake(socket_t client_socket,
-                      mysql_protocol::Capabilities::Flags our_capabilities);
+  MySQLServerMockSession(const MySQLServerMockSession &) = delete;
+  MySQLServerMockSession &operator=(const MySQLServerMockSession &) = delete;
+
+  /** @brief Sends the server greeting and starts handling the client */
+  void start();
+
+  /** @brief Sets the reader of the statements and handles waiting commands
+   *
+   * @param statement_processor reader of the statements, empty if it
+   *        couldn't be created
+   * @param error why the reader couldn't be created, sent to the client
+   *        as the response to its commands
+   */
+  void set_statement_reader(std::unique_ptr<StatementReaderBase> statement_processor,
+                            const std::string &error = "");
+
+  socket_t socket() const { return client_socket_; }
 
-  mysql_protocol::HandshakeResponsePacket handle_handshake_response(
-      socket_t client_socket,
-      mysql_protocol::Capabilities::Flags our_capabilities);
+  /** @brief Whether the session is over and may be destroyed */
+  bool is_finished() const { return state_ == State::kFinished; }
 
-  void handle_auth_switch(socket_t client_socket);
+private:
+  enum class State {
+    kHandshakeResponse,   // greeting sent, waiting for the client's response
+    kAuthSwitchResponse,  // auth-switch sent, waiting for the auth-data
+    kCommand,             // waiting for the next command
+    kExecuting,           // waiting for the execution time of a statement
+    kStreaming,           // sending the rows of a generated resultset
+    kClosing,             // sending the last packets before closing
+    kFinished,
+  };
+
+  void on_io(unsigned events);
+
+  void on_readable();
+
+  void process_input();
+
+  void handle_handshake_response(const uint8_t *packet, size_t size);
 
-  void send_fast_auth(socket_t client_socket);
+  void handle_auth_switch_response();
 
-  bool process_statements(socket_t client_socket);
+  void handle_command();
 
-  void handle_statement(socket_t client_socket, uint8_t seq_no,
-                        const StatementAndResponse& statement);
+  void handle_statement(uint8_t seq_no, const StatementAndResponse& statement);
 
-  void send_error(socket_t client_socket, uint8_t seq_no,
+  /** @brief Sends the response once the execution time passed
+   *
+   * If a row stream is set, its rows are sent after the response.
+   *
+   * @param exec_time time the statement takes to execute
+   * @param response encoded packets
+   * @param close_after whether to close the connection after the response
+   */
+  void respond(std::chrono::microseconds exec_time,
+               std::vector<uint8_t> response,
+               bool close_after = false);
+
+  void send_error(uint8_t seq_no,
                   uint16_t error_code,
                   const std::string &error_msg,
                   const std::string &sql_state = "HY000");
 
-  void send_ok(socket_t client_socket, uint8_t seq_no,
+  void send_ok(uint8_t seq_no,
       uint64_t affected_rows=0,
       uint64_t last_insert_id=0,
       uint16_t server_status=0,
       uint16_t warning_count=0);
 
-  void run();
+  /** @brief Queues packets for sending and tries to send them right away */
+  void send(const std::vector<uint8_t> &buf);
+
+  void flush();
+
+  /** @returns true if all buffered output was sent */
+  bool send_buffered();
+
+  struct RowStream;
+
+  void start_row_stream(const GeneratedResultsetResponse &response, uint8_t seq_no);
+
+  /** @brief Buffers the next batch of rows of the row stream
+   *
+   * @returns false if nothing was buffered as the rate limit was hit
+   */
+  bool buffer_next_rows();
+
+  void update_watched_events();
+
+  void finish();
 
-  void kill() {
-    killed_ = true;
-  }
-private:
-  bool killed_ { false };
   socket_t client_socket_;
   MySQLProtocolEncoder protocol_encoder_;
   MySQLProtocolDecoder protocol_decoder_;
   std::unique_ptr<StatementReaderBase> json_reader_;
+  std::string reader_error_;
   bool debug_mode_;
+  EventLoop &event_loop_;
+
+  State state_ { State::kHandshakeResponse };
+  unsigned watched_events_ { 0 };
+  EventLoop::TimerId exec_timer_ { 0 };
+  std::unique_ptr<RowStream> row_stream_;
+
+  std::vector<uint8_t> in_buf_;
+  std::vector<uint8_t> out_buf_;
+  size_t out_buf_offset_ { 0 };
 };
 
 /** @class MySQLServerMock
@@ -128,7 +214,25 @@ class MySQLServerMock {
 
   void handle_connections(mysql_harness::PluginFuncEnv* env);
 
-  static constexpr int kListenQueueSize = 128;
+  struct IoThread;
+
+  void run_io_thread(IoThread &io_thread);
+
+  void accept_connections(IoThread &io_thread);
+
+  void run_reader_thread();
+
+  /** @brief Creates the statement reader of a session in a reader thread
+   *
+   * Evaluating the statement file takes far longer than the rest of
+   * accepting a connection; it would stall the other sessions of the I/O
+   * thread. The reader is handed to the session in its I/O thread.
+   */
+  void create_statement_reader(std::weak_ptr<MySQLServerMockSession> session,
+                               EventLoop &event_loop,
+                               std::map<std::string, std::string> session_data);
+
+  static constexpr int kListenQueueSize = 1024;
   unsigned bind_port_;
   bool debug_mode_;
   socket_t listener_{socket_t(-1)};
@@ -137,8 +241,21 @@ class MySQLServerMock {
 
   std::shared_ptr<MockServerGlobalScope> shared_globals_ {new MockServerGlobalScope};
 
-  std::mutex active_fds_mutex_;
-  std::set<socket_t> active_fds_;
+  std::atomic<bool> stopped_ { false };
+
+  // bumped by close_all_connections(), each I/O thread closes its sessions
+  // and acknowledges it by setting its closed_generation.
+  std::atomic<uint64_t> close_generation_ { 0 };
+  std::mutex io_threads_mutex_;
+  std::condition_variable io_threads_cond_;
+  std::vector<std::unique_ptr<IoThread>> io_threads_;
+
+  std::mutex reader_jobs_mutex_;
+  std::condition_variable reader_jobs_cond_;
+  std::deque<std::function<void()>> reader_jobs_;
+  // protected by reader_jobs_mutex_
+  bool reader_threads_stopped_ { false };
+  std::vector<std::thread> reader_threads_;
 };
 
 } // namespace
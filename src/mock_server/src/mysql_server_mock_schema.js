@@ -194,6 +194,41 @@
       "required": ["columns"]
     },
 
+    "GeneratedResult": {
+      "description": "resultset of identical rows that are generated while being sent; for big resultsets",
+      "type": "object",
+      "additionalProperties": false,
+
+      "properties": {
+        "columns": {
+          "description": "column descriptions",
+          "type": "array",
+          "minItems": 1,
+          "items": {
+            "$ref": "#/definitions/ResultsetColumn"
+          }
+        },
+        "row_count": {
+          "description": "number of rows to send",
+          "type": "integer",
+          "minimum": 0
+        },
+        "value_length": {
+          "description": "size of each field of a row in bytes",
+          "type": "integer",
+          "minimum": 0,
+          "default": 0
+        },
+        "rate_limit": {
+          "description": "max bytes per second to send the rows with; 0 for no limit",
+          "type": "integer",
+          "minimum": 0,
+          "default": 0
+        }
+      },
+      "required": ["columns", "row_count"]
+    },
+
     "RPC": {
       "description": "statement and its response",
       "type": "object",
@@ -214,6 +249,9 @@
         "result": {
           "$ref": "#/definitions/Result"
         },
+        "generated_result": {
+          "$ref": "#/definitions/GeneratedResult"
+        },
         "ok": {
           "$ref": "#/definitions/Ok"
         },
@@ -240,6 +278,9 @@
             {
               "required": ["result"]
             },
+            {
+              "required": ["generated_result"]
+            },
             {
               "required": ["error"]
             }
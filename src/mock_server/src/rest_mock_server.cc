@@ -27,8 +27,11 @@
 
 #include <atomic>
 #include <chrono>
+#include <memory>
 
 #include <rapidjson/document.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/error/en.h>
 
@@ -159,48 +162,78 @@ private:
   }
 
   void handle_global_get_all(HttpRequest &req) {
-    auto chunk = req.get_output_buffer();
+    auto shared_globals = MockServerComponent::getInstance().getGlobalScope();
+    auto all_globals = shared_globals->get_all();
 
-    {
-      rapidjson::StringBuffer json_buf;
-      {
-        rapidjson::Writer<rapidjson::StringBuffer> json_writer(json_buf);
-        JsonDocument json_doc;
+    // the status is sent before the body, check the values upfront
+    for (auto &element: all_globals) {
+      rapidjson::Reader reader;
+      rapidjson::BaseReaderHandler<> handler;
+      rapidjson::StringStream value_stream(element.second.c_str()); // value is a json-value as string
 
-        json_doc.SetObject();
+      if (reader.Parse(value_stream, handler).IsError()) {
+        req.send_reply(HttpStatusCode::InternalError);
+        return;
+      }
+    }
 
-        auto shared_globals = MockServerComponent::getInstance().getGlobalScope();
-        auto all_globals = shared_globals->get_all();
+    auto out_hdrs = req.get_output_headers();
+    out_hdrs.add("Content-Type", "application/json");
 
-        for (auto &element: all_globals) {
-          JsonDocument value_doc;
-          value_doc.Parse(element.second.c_str()); // value is a json-value as string
+    req.send_reply_chunked(HttpStatusCode::Ok, "Ok", GlobalsJsonProducer(std::move(all_globals)));
+  }
 
-          if (value_doc.HasParseError()) {
-            req.send_reply(HttpStatusCode::InternalError);
-            return;
-          }
+  /**
+   * writes the globals as JSON object, a chunk at a time.
+   */
+  class GlobalsJsonProducer {
+  public:
+    explicit GlobalsJsonProducer(MockServerGlobalScope::type globals):
+      globals_(std::make_shared<MockServerGlobalScope::type>(std::move(globals))) {}
+
+    bool operator()(HttpBuffer &chunk) {
+      if (!state_) {
+        state_ = std::make_shared<State>(*globals_, chunk);
+      } else {
+        state_->json_stream.reset(chunk);
+      }
+      auto &json_writer = state_->json_writer;
 
-          json_doc.AddMember(
-              JsonValue(element.first.c_str(), element.first.size(), json_doc.GetAllocator()),
-              value_doc,
-              json_doc.GetAllocator());
-        }
+      for (; state_->it != globals_->end() && chunk.length() < kChunkSize; ++state_->it) {
+        const auto &element = *state_->it;
 
-        json_doc.Accept(json_writer);
-      } // free json_doc and json_writer early
+        json_writer.Key(element.first.c_str(), static_cast<rapidjson::SizeType>(element.first.size()));
+        // the type only matters for the root value
+        json_writer.RawValue(element.second.c_str(), element.second.size(), rapidjson::kObjectType);
+      }
 
-      // perhaps we could use evbuffer_add_reference() and a unique-ptr on json_buf here.
-      // needs to be benchmarked
-      chunk.add(json_buf.GetString(), json_buf.GetSize());
-    } // free json_buf early
+      const bool has_more = state_->it != globals_->end();
+      if (!has_more) {
+        json_writer.EndObject();
+      }
+      state_->json_stream.Flush();
 
-    auto out_hdrs = req.get_output_headers();
-    out_hdrs.add("Content-Type", "application/json");
+      return has_more;
+    }
+  private:
+    static constexpr size_t kChunkSize = 16 * 1024;
+
+    struct State {
+      State(const MockServerGlobalScope::type &globals, HttpBuffer &chunk):
+        it(globals.begin()),
+        json_stream(chunk),
+        json_writer(json_stream) {
+        json_writer.StartObject();
+      }
 
-    req.send_reply(HttpStatusCode::Ok, "Ok", chunk);
-  }
+      MockServerGlobalScope::type::const_iterator it;
+      HttpBufferOutputStream json_stream;
+      rapidjson::Writer<HttpBufferOutputStream> json_writer;
+    };
 
+    std::shared_ptr<const MockServerGlobalScope::type> globals_;
+    std::shared_ptr<State> state_;
+  };
 };
 
 class RestApiV1MockServerConnections: public BaseRequestHandler {
@@ -46,6 +46,21 @@ struct ResultsetResponse : public Response {
   std::vector<RowValueType> rows;
 };
 
+/** @brief Resultset of identical rows which are generated while they are
+ *         sent.
+ *
+ * Used to emit big resultsets without keeping them in memory.
+ **/
+struct GeneratedResultsetResponse : public Response {
+  std::vector<column_info_type> columns;
+  // number of rows to send
+  uint64_t row_count{0};
+  // size of each field of a row in bytes
+  uint32_t value_length{0};
+  // max bytes per second to send, 0 for no limit
+  uint64_t rate_limit{0};
+};
+
 struct OkResponse : public Response {
   OkResponse(unsigned int last_insert_id_=0, unsigned int warning_count_=0) : last_insert_id(last_insert_id_), warning_count(warning_count_) {}
 
@@ -71,13 +86,16 @@ struct StatementAndResponse {
    * Response expected for given SQL statement.
    **/
   enum class StatementResponseType {
-     STMT_RES_UNKNOWN, STMT_RES_OK, STMT_RES_ERROR, STMT_RES_RESULT
+     STMT_RES_UNKNOWN, STMT_RES_OK, STMT_RES_ERROR, STMT_RES_RESULT,
+     STMT_RES_GENERATED_RESULT
   };
 
   // exected response type for the statement
   StatementResponseType response_type;
 
-  std::unique_ptr<Response> response;
+  // may be shared with other sessions, like the parsed responses of a
+  // JSON file
+  std::shared_ptr<const Response> response;
 
   // execution time in microseconds
   std::chrono::microseconds exec_time{0};
@@ -0,0 +1,241 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+# include <direct.h>
+#endif
+
+#include "gmock/gmock.h"
+
+#include "duktape_statement_reader.h"
+#include "mysql/harness/filesystem.h"
+
+using server_mock::DuktapeStatementReader;
+using server_mock::StatementAndResponse;
+
+namespace {
+
+// the parts of a response the tests look at, as text
+std::string describe(const StatementAndResponse &statement) {
+  using StatementResponseType = StatementAndResponse::StatementResponseType;
+
+  std::string result;
+  switch (statement.response_type) {
+  case StatementResponseType::STMT_RES_OK: {
+    auto *ok = dynamic_cast<const server_mock::OkResponse *>(statement.response.get());
+    result = "ok " + std::to_string(ok->warning_count);
+  }
+  break;
+  case StatementResponseType::STMT_RES_ERROR: {
+    auto *error = dynamic_cast<const server_mock::ErrorResponse *>(statement.response.get());
+    result = "error " + std::to_string(error->code) + " " + error->msg;
+  }
+  break;
+  case StatementResponseType::STMT_RES_RESULT: {
+    auto *resultset = dynamic_cast<const server_mock::ResultsetResponse *>(statement.response.get());
+    result = "result";
+    for (const auto &column: resultset->columns) result += " " + column.name;
+    for (const auto &row: resultset->rows) {
+      for (const auto &field: row) result += " " + field.second;
+    }
+  }
+  break;
+  default:
+    result = "other";
+  }
+
+  return result;
+}
+
+}
+
+class DuktapeStatementReaderTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    dir_ = mysql_harness::get_tmp_dir("duktape_statement_reader");
+    // where require() looks for modules
+#ifdef _WIN32
+    _mkdir(path("local_modules").c_str());
+#else
+    mkdir(path("local_modules").c_str(), 0700);
+#endif
+  }
+
+  void TearDown() override {
+    mysql_harness::delete_dir_recursive(dir_);
+  }
+
+  std::string path(const std::string &name) const {
+    return dir_ + "/" + name;
+  }
+
+  void write_file(const std::string &name, const std::string &content) {
+    std::ofstream ofs(path(name), std::ios::binary | std::ios::trunc);
+    ofs << content;
+  }
+
+  // the response of a new session to stmt
+  std::string run_session(const std::string &trace, const std::string &stmt) {
+    DuktapeStatementReader reader(path(trace), dir_, { { "port", "3306" } }, shared_globals_);
+    return describe(reader.handle_statement(stmt));
+  }
+
+  std::string dir_;
+  std::shared_ptr<MockServerGlobalScope> shared_globals_ { new MockServerGlobalScope };
+};
+
+/**
+ * the heap of a session is reused by the next one, which must not see the
+ * previous session's globals or loaded modules. mysqld.global is what is
+ * shared between sessions.
+ */
+TEST_F(DuktapeStatementReaderTest, sessions_on_reused_heap_start_fresh) {
+  write_file("local_modules/counter.js", "module.exports = { count: 0 };\n");
+  write_file("trace.js",
+      "var leaked_before = (typeof leaked !== 'undefined');\n"
+      "leaked = true;\n"
+      "var counter = require('counter');\n"
+      "counter.count++;\n"
+      "mysqld.global.sessions = (mysqld.global.sessions || 0) + 1;\n"
+      "({\n"
+      "  stmts: function (stmt) {\n"
+      "    return { error: { code: 1, message: 'leaked=' + leaked_before +\n"
+      "      ' count=' + counter.count + ' sessions=' + mysqld.global.sessions } };\n"
+      "  }\n"
+      "})\n");
+
+  EXPECT_EQ("error 1 leaked=false count=1 sessions=1", run_session("trace.js", "SELECT 1"));
+  EXPECT_EQ("error 1 leaked=false count=1 sessions=2", run_session("trace.js", "SELECT 1"));
+}
+
+/**
+ * the second session runs the bytecode the first one cached, it has to
+ * behave like the freshly compiled file.
+ */
+TEST_F(DuktapeStatementReaderTest, bytecode_behaves_like_compiled_file) {
+  write_file("trace.js",
+      "var counter = 0;\n"
+      "function make_row(n) { return ['row' + n, '' + (n * 2)]; }\n"
+      "var re = /^SELECT (\\d+)$/;\n"
+      "({\n"
+      "  stmts: function (stmt) {\n"
+      "    counter++;\n"
+      "    var m = re.exec(stmt);\n"
+      "    if (m) {\n"
+      "      return { result: {\n"
+      "        columns: [ { name: 'a', type: 'STRING' }, { name: 'b', type: 'STRING' } ],\n"
+      "        rows: [ make_row(parseInt(m[1], 10)), make_row(counter) ] } };\n"
+      "    } else if (stmt === 'ok') {\n"
+      "      return { ok: { warning_count: counter } };\n"
+      "    }\n"
+      "    return { error: { code: 1234,\n"
+      "      message: mysqld.session.port + ' ' + JSON.stringify({ s: stmt, c: counter }) } };\n"
+      "  }\n"
+      "})\n");
+  const std::vector<std::string> statements { "SELECT 21", "ok", "other", "SELECT 4" };
+
+  std::vector<std::vector<std::string>> sessions;
+  for (int i = 0; i < 2; ++i) {
+    DuktapeStatementReader reader(path("trace.js"), dir_, { { "port", "3306" } }, shared_globals_);
+    std::vector<std::string> responses;
+    for (const auto &stmt: statements) responses.push_back(describe(reader.handle_statement(stmt)));
+    sessions.push_back(responses);
+  }
+
+  EXPECT_THAT(sessions[0], ::testing::ElementsAre(
+      "result a b row21 42 row1 2",
+      "ok 2",
+      "error 1234 3306 {\"s\":\"other\",\"c\":3}",
+      "result a b row4 8 row4 8"));
+  EXPECT_EQ(sessions[0], sessions[1]);
+}
+
+TEST_F(DuktapeStatementReaderTest, generated_result) {
+  write_file("trace.js",
+      "({ stmts: [ { stmt: 'SELECT 1', generated_result: {\n"
+      "  columns: [ { name: 'a', type: 'STRING' }, { name: 'b', type: 'LONG' } ],\n"
+      "  row_count: 10000000000, value_length: 10, rate_limit: 5000000000 } },\n"
+      "  { stmt: 'SELECT 2', generated_result: {\n"
+      "  columns: [ { name: 'a', type: 'STRING' } ], row_count: 0 } },\n"
+      "  { stmt: 'SELECT 3', generated_result: {\n"
+      "  columns: [ { name: 'a', type: 'STRING' } ] } } ] })\n");
+
+  DuktapeStatementReader reader(path("trace.js"), dir_, { { "port", "3306" } }, shared_globals_);
+
+  auto statement = reader.handle_statement("SELECT 1");
+  ASSERT_EQ(StatementAndResponse::StatementResponseType::STMT_RES_GENERATED_RESULT,
+            statement.response_type);
+  auto *response = dynamic_cast<const server_mock::GeneratedResultsetResponse *>(
+      statement.response.get());
+  ASSERT_NE(nullptr, response);
+  ASSERT_EQ(2u, response->columns.size());
+  EXPECT_EQ("a", response->columns[0].name);
+  EXPECT_EQ(server_mock::MySQLColumnType::LONG, response->columns[1].type);
+  // beyond 32bit
+  EXPECT_EQ(10000000000u, response->row_count);
+  EXPECT_EQ(10u, response->value_length);
+  EXPECT_EQ(5000000000u, response->rate_limit);
+
+  statement = reader.handle_statement("SELECT 2");
+  response = dynamic_cast<const server_mock::GeneratedResultsetResponse *>(
+      statement.response.get());
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ(0u, response->row_count);
+  EXPECT_EQ(0u, response->value_length);
+  EXPECT_EQ(0u, response->rate_limit);
+
+  // row_count is required
+  EXPECT_THROW(reader.handle_statement("SELECT 3"), std::runtime_error);
+}
+
+#ifndef _WIN32
+/**
+ * a trace rewritten within the same second and with the same size is
+ * compiled again.
+ */
+TEST_F(DuktapeStatementReaderTest, recompiles_changed_file) {
+  const std::string trace {
+    "({ stmts: function () { return { error: { code: 1, message: 'AAA' } }; } })\n" };
+  std::string changed { trace };
+  changed.replace(changed.find("AAA"), 3, "BBB");
+
+  write_file("trace.js", trace);
+  const struct timespec old_times[] { { 1000, 100 }, { 1000, 100 } };
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("trace.js").c_str(), old_times, 0));
+  EXPECT_EQ("error 1 AAA", run_session("trace.js", "SELECT 1"));
+
+  write_file("trace.js", changed);
+  const struct timespec new_times[] { { 1000, 200 }, { 1000, 200 } };
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("trace.js").c_str(), new_times, 0));
+  EXPECT_EQ("error 1 BBB", run_session("trace.js", "SELECT 1"));
+}
+#endif
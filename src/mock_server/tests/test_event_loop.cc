@@ -0,0 +1,238 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <chrono>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+#include "gmock/gmock.h"
+
+#include "event_loop.h"
+
+using server_mock::EventLoop;
+
+namespace {
+
+const std::chrono::seconds kTimeout { 5 };
+
+// runs the loop until pred() is true or the timeout hits
+template<class Pred>
+bool run_until(EventLoop &loop, Pred pred) {
+  const auto end = std::chrono::steady_clock::now() + kTimeout;
+  while (!pred()) {
+    if (std::chrono::steady_clock::now() > end) return false;
+    loop.run_once(std::chrono::milliseconds(10));
+  }
+  return true;
+}
+
+}
+
+TEST(EventLoopTest, timers_expire_in_order) {
+  EventLoop loop;
+  std::vector<int> expired;
+
+  loop.add_timer(std::chrono::milliseconds(30), [&expired]() { expired.push_back(30); });
+  loop.add_timer(std::chrono::milliseconds(10), [&expired]() { expired.push_back(10); });
+  loop.add_timer(std::chrono::milliseconds(20), [&expired]() { expired.push_back(20); });
+  // same expiry, in the order they were added
+  loop.add_timer(std::chrono::milliseconds(0), [&expired]() { expired.push_back(1); });
+  loop.add_timer(std::chrono::milliseconds(0), [&expired]() { expired.push_back(2); });
+
+  ASSERT_TRUE(run_until(loop, [&expired]() { return expired.size() == 5; }));
+  EXPECT_THAT(expired, ::testing::ElementsAre(1, 2, 10, 20, 30));
+}
+
+TEST(EventLoopTest, cancelled_timer_does_not_expire) {
+  EventLoop loop;
+  bool cancelled_expired = false;
+  bool other_expired = false;
+
+  auto id = loop.add_timer(std::chrono::milliseconds(10),
+                           [&cancelled_expired]() { cancelled_expired = true; });
+  loop.add_timer(std::chrono::milliseconds(20), [&other_expired]() { other_expired = true; });
+  loop.cancel_timer(id);
+  // cancelling twice is fine
+  loop.cancel_timer(id);
+
+  ASSERT_TRUE(run_until(loop, [&other_expired]() { return other_expired; }));
+  EXPECT_FALSE(cancelled_expired);
+}
+
+TEST(EventLoopTest, timer_shortens_wait) {
+  EventLoop loop;
+  bool expired = false;
+  loop.add_timer(std::chrono::milliseconds(20), [&expired]() { expired = true; });
+
+  const auto start = std::chrono::steady_clock::now();
+  while (!expired && std::chrono::steady_clock::now() - start < kTimeout) {
+    loop.run_once(std::chrono::seconds(10));
+  }
+  EXPECT_TRUE(expired);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST(EventLoopTest, post_from_other_thread) {
+  EventLoop loop;
+  std::thread::id ran_in;
+
+  std::thread poster([&loop, &ran_in]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    loop.post([&ran_in]() { ran_in = std::this_thread::get_id(); });
+  });
+
+  // the post wakes up the loop
+  const auto start = std::chrono::steady_clock::now();
+  while (ran_in == std::thread::id() && std::chrono::steady_clock::now() - start < kTimeout) {
+    loop.run_once(std::chrono::seconds(10));
+  }
+  poster.join();
+
+  EXPECT_EQ(std::this_thread::get_id(), ran_in);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+#ifndef _WIN32
+class EventLoopSocketTest : public ::testing::Test {
+protected:
+  void TearDown() override {
+    for (int fd: fds_) {
+      if (fd >= 0) close(fd);
+    }
+  }
+
+  // returns both ends of a connected socket pair
+  std::pair<int, int> socket_pair() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+      throw std::system_error(errno, std::generic_category(), "socketpair() failed");
+    }
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+    fds_.push_back(fds[0]);
+    fds_.push_back(fds[1]);
+    return std::make_pair(fds[0], fds[1]);
+  }
+
+  void close_fd(int fd) {
+    for (int &open_fd: fds_) {
+      if (open_fd == fd) open_fd = -1;
+    }
+    close(fd);
+  }
+
+  std::vector<int> fds_;
+};
+
+/**
+ * a socket which is closed while the events of a wait are dispatched
+ * doesn't get its events delivered to a new socket with the same
+ * descriptor.
+ */
+TEST_F(EventLoopSocketTest, reused_descriptor_in_same_wait) {
+  EventLoop loop;
+  auto a = socket_pair();
+  auto b = socket_pair();
+
+  int closed_fd = -1;
+  int new_fd = -1;
+  unsigned new_socket_events = 0;
+
+  // whichever handler is called first replaces the other socket
+  auto replace = [&](int other_fd) {
+    if (closed_fd != -1) return;
+    loop.remove(other_fd);
+    close_fd(other_fd);
+    closed_fd = other_fd;
+
+    new_fd = socket_pair().first;
+    loop.add(new_fd, EventLoop::kRead | EventLoop::kWrite,
+             [&new_socket_events](unsigned events) { new_socket_events |= events; });
+  };
+  loop.add(a.first, EventLoop::kRead, [&](unsigned) { replace(b.first); });
+  loop.add(b.first, EventLoop::kRead, [&](unsigned) { replace(a.first); });
+
+  // both sockets are readable in the same wait
+  ASSERT_EQ(1, write(a.second, "a", 1));
+  ASSERT_EQ(1, write(b.second, "b", 1));
+  loop.run_once(std::chrono::milliseconds(1000));
+
+  ASSERT_NE(-1, closed_fd);
+  ASSERT_EQ(closed_fd, new_fd) << "descriptor wasn't reused";
+  // the readable event of the closed socket isn't passed on, the new
+  // socket's own events come with the next wait
+  EXPECT_EQ(0u, new_socket_events);
+
+  loop.run_once(std::chrono::milliseconds(1000));
+  EXPECT_EQ(static_cast<unsigned>(EventLoop::kWrite), new_socket_events);
+}
+
+/**
+ * many sessions on one loop, more than one wait reports at once.
+ */
+TEST_F(EventLoopSocketTest, many_concurrent_sessions) {
+  const size_t kSessions = 1000;
+  EventLoop loop;
+  std::vector<std::pair<int, int>> sessions;
+  size_t echoed = 0;
+
+  for (size_t ndx = 0; ndx < kSessions; ++ndx) {
+    auto session = socket_pair();
+    sessions.push_back(session);
+
+    // echos one message and stops watching
+    const int fd = session.first;
+    loop.add(fd, EventLoop::kRead, [&loop, &echoed, fd](unsigned) {
+      char buf[64];
+      auto received = read(fd, buf, sizeof(buf));
+      if (received <= 0) return;
+      if (write(fd, buf, static_cast<size_t>(received)) == received) ++echoed;
+      loop.remove(fd);
+    });
+  }
+
+  for (size_t ndx = 0; ndx < kSessions; ++ndx) {
+    const std::string msg { std::to_string(ndx) };
+    ASSERT_EQ(static_cast<ssize_t>(msg.size()), write(sessions[ndx].second, msg.data(), msg.size()));
+  }
+
+  ASSERT_TRUE(run_until(loop, [&echoed]() { return echoed == kSessions; }));
+
+  for (size_t ndx = 0; ndx < kSessions; ++ndx) {
+    char buf[64];
+    auto received = read(sessions[ndx].second, buf, sizeof(buf));
+    ASSERT_GT(received, 0);
+    EXPECT_EQ(std::to_string(ndx), std::string(buf, static_cast<size_t>(received)));
+  }
+}
+#endif
@@ -0,0 +1,176 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#ifndef _WIN32
+# include <fcntl.h>
+# include <sys/stat.h>
+#endif
+
+#include "gmock/gmock.h"
+
+#include "json_statement_reader.h"
+#include "mysql/harness/filesystem.h"
+
+using server_mock::QueriesJsonReader;
+using server_mock::StatementAndResponse;
+
+namespace {
+
+const std::string kOkTrace { R"({ "stmts": [ { "stmt": "SELECT 1", "ok": {} } ] })" };
+const std::string kErrorTrace {
+  R"({ "stmts": [ { "stmt": "SELECT 1", "error": { "code": 1, "message": "x" } } ] })" };
+
+// the traces padded to the same size
+std::string padded(const std::string &trace) {
+  std::string result { trace };
+  result.resize(128, ' ');
+  return result;
+}
+
+}
+
+class QueriesJsonReaderTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    dir_ = mysql_harness::get_tmp_dir("json_statement_reader");
+  }
+
+  void TearDown() override {
+    mysql_harness::delete_dir_recursive(dir_);
+  }
+
+  std::string path(const std::string &name) const {
+    return dir_ + "/" + name;
+  }
+
+  void write_file(const std::string &name, const std::string &content) {
+    std::ofstream ofs(path(name), std::ios::binary | std::ios::trunc);
+    ofs << content;
+  }
+
+  std::string dir_;
+};
+
+/**
+ * readers of the same file share its parsed statements and responses.
+ */
+TEST_F(QueriesJsonReaderTest, readers_share_parsed_file) {
+  write_file("trace.json", kOkTrace);
+
+  QueriesJsonReader first(path("trace.json"));
+  QueriesJsonReader second(path("trace.json"));
+  auto first_response = first.handle_statement("SELECT 1");
+  auto second_response = second.handle_statement("SELECT 1");
+
+  EXPECT_EQ(StatementAndResponse::StatementResponseType::STMT_RES_OK, first_response.response_type);
+  ASSERT_NE(nullptr, first_response.response);
+  EXPECT_EQ(first_response.response, second_response.response);
+}
+
+#ifndef _WIN32
+/**
+ * a file changed within the same second and with the same size is parsed
+ * again, readers created before keep the old statements.
+ */
+TEST_F(QueriesJsonReaderTest, reloads_changed_file) {
+  write_file("trace.json", padded(kOkTrace));
+  const struct timespec old_times[] { { 1000, 100 }, { 1000, 100 } };
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("trace.json").c_str(), old_times, 0));
+  QueriesJsonReader old_reader(path("trace.json"));
+
+  write_file("trace.json", padded(kErrorTrace));
+  const struct timespec new_times[] { { 1000, 200 }, { 1000, 200 } };
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("trace.json").c_str(), new_times, 0));
+  QueriesJsonReader new_reader(path("trace.json"));
+
+  EXPECT_EQ(StatementAndResponse::StatementResponseType::STMT_RES_ERROR,
+            new_reader.handle_statement("SELECT 1").response_type);
+  EXPECT_EQ(StatementAndResponse::StatementResponseType::STMT_RES_OK,
+            old_reader.handle_statement("SELECT 1").response_type);
+}
+
+TEST_F(QueriesJsonReaderTest, reloads_replaced_file) {
+  const struct timespec times[] { { 1000, 0 }, { 1000, 0 } };
+  write_file("trace.json", padded(kOkTrace));
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("trace.json").c_str(), times, 0));
+  QueriesJsonReader old_reader(path("trace.json"));
+
+  // same size and times, but another inode
+  write_file("trace.json.tmp", padded(kErrorTrace));
+  ASSERT_EQ(0, utimensat(AT_FDCWD, path("trace.json.tmp").c_str(), times, 0));
+  ASSERT_EQ(0, rename(path("trace.json.tmp").c_str(), path("trace.json").c_str()));
+
+  QueriesJsonReader new_reader(path("trace.json"));
+  EXPECT_EQ(StatementAndResponse::StatementResponseType::STMT_RES_ERROR,
+            new_reader.handle_statement("SELECT 1").response_type);
+}
+#endif
+
+TEST_F(QueriesJsonReaderTest, generated_result) {
+  write_file("trace.json", R"({ "stmts": [ { "stmt": "SELECT 1", "generated_result": {
+      "columns": [ { "name": "a", "type": "STRING" }, { "name": "b", "type": "LONG" } ],
+      "row_count": 10000000000, "value_length": 10, "rate_limit": 5000000000 } } ] })");
+
+  QueriesJsonReader reader(path("trace.json"));
+  auto statement = reader.handle_statement("SELECT 1");
+  ASSERT_EQ(StatementAndResponse::StatementResponseType::STMT_RES_GENERATED_RESULT,
+            statement.response_type);
+  auto *response = dynamic_cast<const server_mock::GeneratedResultsetResponse *>(
+      statement.response.get());
+  ASSERT_NE(nullptr, response);
+
+  ASSERT_EQ(2u, response->columns.size());
+  EXPECT_EQ("a", response->columns[0].name);
+  EXPECT_EQ(server_mock::MySQLColumnType::LONG, response->columns[1].type);
+  // beyond 32bit
+  EXPECT_EQ(10000000000u, response->row_count);
+  EXPECT_EQ(10u, response->value_length);
+  EXPECT_EQ(5000000000u, response->rate_limit);
+}
+
+TEST_F(QueriesJsonReaderTest, generated_result_defaults) {
+  write_file("trace.json", R"({ "stmts": [ { "stmt": "SELECT 1", "generated_result": {
+      "columns": [ { "name": "a", "type": "STRING" } ], "row_count": 0 } } ] })");
+
+  QueriesJsonReader reader(path("trace.json"));
+  auto statement = reader.handle_statement("SELECT 1");
+  auto *response = dynamic_cast<const server_mock::GeneratedResultsetResponse *>(
+      statement.response.get());
+  ASSERT_NE(nullptr, response);
+  EXPECT_EQ(0u, response->row_count);
+  EXPECT_EQ(0u, response->value_length);
+  EXPECT_EQ(0u, response->rate_limit);
+}
+
+TEST_F(QueriesJsonReaderTest, generated_result_needs_row_count) {
+  write_file("trace.json", R"({ "stmts": [ { "stmt": "SELECT 1", "generated_result": {
+      "columns": [ { "name": "a", "type": "STRING" } ] } } ] })");
+
+  EXPECT_THROW(QueriesJsonReader reader(path("trace.json")), std::runtime_error);
+}
@@ -0,0 +1,348 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+# include <sys/time.h>
+# include <unistd.h>
+#endif
+
+#include "gmock/gmock.h"
+
+#include "mysql_server_mock.h"
+#include "test/helpers.h"
+
+using server_mock::EventLoop;
+using server_mock::GeneratedResultsetResponse;
+using server_mock::MySQLServerMockSession;
+using server_mock::StatementAndResponse;
+using server_mock::StatementReaderBase;
+
+#ifndef _WIN32
+namespace {
+
+// answers every statement with the same response
+class FixedStatementReader: public StatementReaderBase {
+public:
+  explicit FixedStatementReader(const StatementAndResponse &response):
+    response_(response) {}
+
+  StatementAndResponse handle_statement(const std::string &) override {
+    return response_;
+  }
+
+  std::chrono::microseconds get_default_exec_time() override {
+    return std::chrono::microseconds(0);
+  }
+private:
+  StatementAndResponse response_;
+};
+
+StatementAndResponse ok_response() {
+  StatementAndResponse result;
+  result.response_type = StatementAndResponse::StatementResponseType::STMT_RES_OK;
+  result.response.reset(new server_mock::OkResponse());
+  return result;
+}
+
+StatementAndResponse generated_result(uint64_t row_count, uint32_t value_length,
+                                      uint64_t rate_limit = 0) {
+  std::shared_ptr<GeneratedResultsetResponse> response(new GeneratedResultsetResponse);
+  server_mock::column_info_type column {};
+  column.name = "a";
+  column.type = server_mock::MySQLColumnType::STRING;
+  response->columns.push_back(column);
+  response->row_count = row_count;
+  response->value_length = value_length;
+  response->rate_limit = rate_limit;
+
+  StatementAndResponse result;
+  result.response_type = StatementAndResponse::StatementResponseType::STMT_RES_GENERATED_RESULT;
+  result.response = response;
+  return result;
+}
+
+// reads a packet, returns its payload; empty if none arrived
+std::vector<uint8_t> read_packet(int sock, uint8_t &seq_no) {
+  uint8_t header[4];
+  size_t have = 0;
+  while (have < sizeof(header)) {
+    auto received = recv(sock, header + have, sizeof(header) - have, 0);
+    if (received <= 0) return {};
+    have += static_cast<size_t>(received);
+  }
+  seq_no = header[3];
+
+  std::vector<uint8_t> payload(header[0] | (header[1] << 8u) | (header[2] << 16u));
+  have = 0;
+  while (have < payload.size()) {
+    auto received = recv(sock, payload.data() + have, payload.size() - have, 0);
+    if (received <= 0) return {};
+    have += static_cast<size_t>(received);
+  }
+  return payload;
+}
+
+// reads a resultset of one column, returns the number of its rows; -1 if
+// something else arrived
+int64_t read_resultset(int sock) {
+  uint8_t seq_no;
+  uint8_t expected_seq_no = 1;
+  auto next_packet = [&]() {
+    auto payload = read_packet(sock, seq_no);
+    if (seq_no != expected_seq_no++) payload.clear();
+    return payload;
+  };
+
+  const auto column_count = next_packet();
+  if (column_count.size() != 1 || column_count[0] != 1) return -1;
+  if (next_packet().empty()) return -1;  // column definition
+  const auto eof = next_packet();
+  if (eof.empty() || eof[0] != 0xfe) return -1;
+
+  int64_t rows = 0;
+  while (true) {
+    const auto payload = next_packet();
+    if (payload.empty()) return -1;
+    if (payload[0] == 0xfe && payload.size() < 9) return rows;
+    ++rows;
+  }
+}
+
+void send_packet(int sock, uint8_t seq_no, const std::vector<uint8_t> &payload) {
+  std::vector<uint8_t> packet {
+    static_cast<uint8_t>(payload.size()), static_cast<uint8_t>(payload.size() >> 8),
+    static_cast<uint8_t>(payload.size() >> 16), seq_no };
+  packet.insert(packet.end(), payload.begin(), payload.end());
+  ASSERT_EQ(static_cast<ssize_t>(packet.size()), send(sock, packet.data(), packet.size(), 0));
+}
+
+void send_query(int sock, const std::string &sql) {
+  std::vector<uint8_t> payload { 3 /* COM_QUERY */ };
+  payload.insert(payload.end(), sql.begin(), sql.end());
+  send_packet(sock, 0, payload);
+}
+
+// handshake response of user root without password
+void send_handshake_response(int sock) {
+  std::vector<uint8_t> payload {
+    0x00, 0x82, 0x08, 0x00,  // PROTOCOL_41 | SECURE_CONNECTION | PLUGIN_AUTH
+    0x00, 0x00, 0x00, 0x01,  // max packet size
+    0x08,                    // character set
+  };
+  payload.resize(payload.size() + 23);  // reserved
+  const std::string user { "root" };
+  payload.insert(payload.end(), user.begin(), user.end() + 1);
+  payload.push_back(0);  // auth response length
+  const std::string plugin { "mysql_native_password" };
+  payload.insert(payload.end(), plugin.begin(), plugin.end() + 1);
+  send_packet(sock, 1, payload);
+}
+
+void set_receive_timeout(int sock, std::chrono::milliseconds timeout) {
+  struct timeval tv;
+  tv.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+  tv.tv_usec = static_cast<suseconds_t>((timeout.count() % 1000) * 1000);
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+}
+
+/**
+ * runs a session in the thread of an event loop, the test is its client.
+ */
+class MySQLServerMockSessionTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    client_ = fds[1];
+    set_receive_timeout(client_, std::chrono::seconds(5));
+
+    session_.reset(new MySQLServerMockSession(fds[0], false, loop_));
+    session_->start();
+
+    loop_thread_ = std::thread([this]() {
+      while (!stopped_) {
+        loop_.run_once(std::chrono::milliseconds(10));
+        // closes the connection
+        if (session_ && session_->is_finished()) session_.reset();
+      }
+    });
+  }
+
+  void TearDown() override {
+    stopped_ = true;
+    loop_thread_.join();
+    session_.reset();
+    close(client_);
+  }
+
+  // hands the session a reader which answers with response
+  void set_statement_reader(const StatementAndResponse &response) {
+    loop_.post([this, response]() {
+      std::unique_ptr<StatementReaderBase> reader(new FixedStatementReader(response));
+      if (session_) session_->set_statement_reader(std::move(reader));
+    });
+  }
+
+  // lets the session fail to get a reader
+  void fail_statement_reader(const std::string &error) {
+    loop_.post([this, error]() {
+      if (session_) session_->set_statement_reader(nullptr, error);
+    });
+  }
+
+  // reads the greeting and authenticates
+  void handshake() {
+    uint8_t seq_no;
+    ASSERT_FALSE(read_packet(client_, seq_no).empty());
+
+    send_handshake_response(client_);
+
+    const auto ok = read_packet(client_, seq_no);
+    ASSERT_FALSE(ok.empty());
+    EXPECT_EQ(0, ok[0]);
+    EXPECT_EQ(2, seq_no);
+  }
+
+  EventLoop loop_;
+  std::unique_ptr<MySQLServerMockSession> session_;
+  int client_ { -1 };
+  std::atomic<bool> stopped_ { false };
+  std::thread loop_thread_;
+};
+
+/**
+ * the handshake doesn't need the statement reader, commands wait for it.
+ */
+TEST_F(MySQLServerMockSessionTest, commands_wait_for_statement_reader) {
+  handshake();
+  send_query(client_, "SELECT 1");
+
+  set_receive_timeout(client_, std::chrono::milliseconds(200));
+  uint8_t seq_no;
+  EXPECT_TRUE(read_packet(client_, seq_no).empty());
+
+  set_statement_reader(ok_response());
+  set_receive_timeout(client_, std::chrono::seconds(5));
+  const auto ok = read_packet(client_, seq_no);
+  ASSERT_FALSE(ok.empty());
+  EXPECT_EQ(0, ok[0]);
+  EXPECT_EQ(1, seq_no);
+
+  // later commands are answered right away
+  send_query(client_, "SELECT 2");
+  EXPECT_FALSE(read_packet(client_, seq_no).empty());
+}
+
+TEST_F(MySQLServerMockSessionTest, statement_reader_failed) {
+  fail_statement_reader("no statements");
+  handshake();
+  send_query(client_, "SELECT 1");
+
+  uint8_t seq_no;
+  const auto error = read_packet(client_, seq_no);
+  ASSERT_FALSE(error.empty());
+  EXPECT_EQ(0xff, error[0]);
+  EXPECT_THAT(std::string(error.begin(), error.end()),
+              ::testing::HasSubstr("reader error: no statements"));
+
+  // the connection gets closed
+  char c;
+  EXPECT_EQ(0, recv(client_, &c, 1, 0));
+}
+
+TEST_F(MySQLServerMockSessionTest, generated_result) {
+  set_statement_reader(generated_result(10000, 100));
+  handshake();
+
+  send_query(client_, "SELECT 1");
+  EXPECT_EQ(10000, read_resultset(client_));
+
+  // the connection is still usable
+  send_query(client_, "SELECT 1");
+  EXPECT_EQ(10000, read_resultset(client_));
+}
+
+TEST_F(MySQLServerMockSessionTest, generated_result_without_rows) {
+  set_statement_reader(generated_result(0, 100));
+  handshake();
+
+  send_query(client_, "SELECT 1");
+  EXPECT_EQ(0, read_resultset(client_));
+}
+
+/**
+ * rows are sent as single packets, their payload has to be smaller than
+ * 16MB.
+ */
+TEST_F(MySQLServerMockSessionTest, generated_result_row_too_large) {
+  // a payload of exactly 0xffffff bytes: the value and its 9 bytes length
+  set_statement_reader(generated_result(1, 0xffffff - 9));
+  handshake();
+  send_query(client_, "SELECT 1");
+
+  uint8_t seq_no;
+  const auto error = read_packet(client_, seq_no);
+  ASSERT_FALSE(error.empty());
+  EXPECT_EQ(0xff, error[0]);
+  EXPECT_EQ(1, seq_no);
+  EXPECT_THAT(std::string(error.begin(), error.end()),
+              ::testing::HasSubstr("generated rows don't fit into a single packet"));
+
+  char c;
+  EXPECT_EQ(0, recv(client_, &c, 1, 0));
+}
+
+TEST_F(MySQLServerMockSessionTest, generated_result_rate_limit) {
+  // 300 rows of ~1000 bytes at 1MB/s take ~300ms
+  set_statement_reader(generated_result(300, 1000, 1000000));
+  handshake();
+
+  const auto start = std::chrono::steady_clock::now();
+  send_query(client_, "SELECT 1");
+  EXPECT_EQ(300, read_resultset(client_));
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_GE(elapsed, std::chrono::milliseconds(200));
+  EXPECT_LT(elapsed, std::chrono::seconds(3));
+}
+#endif
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+
+  init_test_logger({"mock_server"});
+  return RUN_ALL_TESTS();
+}
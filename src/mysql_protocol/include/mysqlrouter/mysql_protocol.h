@@ -43,7 +43,9 @@
 #endif
 
 #include "mysql_protocol/constants.h" // comes first
+#include "mysql_protocol/packet_view.h"
 #include "mysql_protocol/base_packet.h"
+#include "mysql_protocol/change_user_packet.h"
 #include "mysql_protocol/error_packet.h"
 #include "mysql_protocol/handshake_packet.h"
 
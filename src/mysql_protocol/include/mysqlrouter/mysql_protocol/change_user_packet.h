@@ -0,0 +1,98 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef MYSQLROUTER_MYSQL_PROTOCOL_CHANGE_USER_PACKET_INCLUDED
+#define MYSQLROUTER_MYSQL_PROTOCOL_CHANGE_USER_PACKET_INCLUDED
+
+#include "base_packet.h"
+
+namespace mysql_protocol {
+
+/** @class ChangeUserPacket
+ * @brief Creates a MySQL COM_CHANGE_USER packet
+ *
+ * COM_CHANGE_USER authenticates an established connection as the given user
+ * and resets the session. The fields are those of a handshake response,
+ * which lets an authenticated server connection be handed to another
+ * client.
+ *
+ */
+class MYSQL_PROTOCOL_API ChangeUserPacket final : public Packet {
+ public:
+  /** @brief Constructor
+   *
+   * @param sequence_id MySQL Packet number
+   * @param username MySQL username
+   * @param auth_response authentication data computed by the client
+   * @param database MySQL database to use (can be empty)
+   * @param char_set MySQL character set code
+   * @param auth_plugin authentication plugin the client used
+   * @param connection_attrs connection attributes as lenenc-str key-values
+   * @param capabilities capability flags of the connection
+   *
+   * @throws packet_error if the auth_response is too long for SECURE_CONNECTION
+   */
+  ChangeUserPacket(uint8_t sequence_id, const std::string &username,
+                   const std::vector<uint8_t> &auth_response,
+                   const std::string &database, uint8_t char_set,
+                   const std::string &auth_plugin,
+                   const std::vector<uint8_t> &connection_attrs,
+                   Capabilities::Flags capabilities);
+
+  /** @brief returns username */
+  const std::string& get_username() const { return username_; }
+
+  /** @brief returns database name */
+  const std::string& get_database() const { return database_; }
+
+ private:
+  /** @brief Prepares the packet
+   *
+   * Prepares the actual COM_CHANGE_USER packet and stores it. Optional
+   * fields are written depending on the capability flags.
+   */
+  void prepare_packet();
+
+  /** @brief MySQL username */
+  std::string username_;
+
+  /** @brief MySQL auth-response */
+  std::vector<uint8_t> auth_response_;
+
+  /** @brief MySQL database */
+  std::string database_;
+
+  /** @brief MySQL character set */
+  uint8_t char_set_;
+
+  /** @brief MySQL authentication plugin name */
+  std::string auth_plugin_;
+
+  /** @brief MySQL connection attributes */
+  std::vector<uint8_t> connection_attrs_;
+};
+
+} // namespace mysql_protocol
+
+#endif // MYSQLROUTER_MYSQL_PROTOCOL_CHANGE_USER_PACKET_INCLUDED
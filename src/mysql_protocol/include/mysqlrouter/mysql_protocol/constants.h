@@ -164,6 +164,19 @@ enum Command {
   RESET_CONNECTION    = 0x1f,
 };
 
+/** @namespace ServerStatus
+ *
+ * Status flags sent by the server in OK and EOF packets.
+ *
+ **/
+namespace ServerStatus {
+
+  static constexpr uint16_t IN_TRANS             = 0x0001;
+  static constexpr uint16_t AUTOCOMMIT           = 0x0002;
+  static constexpr uint16_t MORE_RESULTS_EXISTS  = 0x0008;
+
+} // namespace ServerStatus
+
 } // namespace mysql_protocol
 
 #endif // MYSQLROUTER_MYSQL_PROTOCOL_CONSTANTS_INCLUDED
@@ -163,6 +163,9 @@ class MYSQL_PROTOCOL_API HandshakeResponsePacket final : public Packet {
   /** @brief returns max packet size specified in the packet */
   uint32_t get_max_packet_size() const { return max_packet_size_; }
 
+  /** @brief returns connection attributes (key-values without the total length) */
+  const std::vector<uint8_t>& get_connection_attrs() const { return connection_attrs_; }
+
   /** @brief (debug tool) parse packet contents and print this info on stdout */
   void debug_dump() {
     init_parser_if_not_initialized();
@@ -214,6 +217,9 @@ class MYSQL_PROTOCOL_API HandshakeResponsePacket final : public Packet {
   /** @brief Max size that of a command packet that the client wants to send to the server */
   uint32_t max_packet_size_;
 
+  /** @brief MySQL connection attributes, as lenenc-str key-value pairs */
+  std::vector<uint8_t> connection_attrs_;
+
   /** @brief Parser used to parse this packet */
   std::unique_ptr<Parser> parser_;
 
@@ -0,0 +1,254 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef MYSQLROUTER_MYSQL_PROTOCOL_PACKET_VIEW_INCLUDED
+#define MYSQLROUTER_MYSQL_PROTOCOL_PACKET_VIEW_INCLUDED
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "harness_assert.h"
+
+namespace mysql_protocol {
+
+/** @class PacketView
+ * @brief Read-only view of a MySQL packet
+ *
+ * Offers the read API of Packet on a buffer owned by someone else, for
+ * example a receive buffer. Unlike Packet, the buffer is not copied and
+ * bytes and strings are returned as views into it, hence the buffer has to
+ * outlive the view and everything read from it.
+ *
+ * Like Packet, the view covers the whole packet including the 4-byte
+ * header, so positions are the same as for Packet.
+ */
+class MYSQL_PROTOCOL_API PacketView {
+ public:
+
+  /** @class Bytes
+   * @brief Range of bytes of the viewed buffer
+   */
+  class Bytes {
+   public:
+    using const_iterator = const uint8_t*;
+
+    Bytes() = default;
+    Bytes(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+    const uint8_t *data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+
+    uint8_t operator[](size_t ndx) const noexcept { return data_[ndx]; }
+
+    /** @brief Copies the bytes into a string */
+    std::string str() const {
+      return std::string(reinterpret_cast<const char*>(data_), size_);
+    }
+
+    /** @brief Copies the bytes into a vector */
+    std::vector<uint8_t> vec() const {
+      return std::vector<uint8_t>(begin(), end());
+    }
+
+    /** @brief Compares the bytes with a string without copying them */
+    bool equals(const std::string &other) const noexcept {
+      return other.size() == size_ && other.compare(0, size_, reinterpret_cast<const char*>(data_), size_) == 0;
+    }
+
+   private:
+    const uint8_t *data_{nullptr};
+    size_t size_{0};
+  };
+
+  /** @brief Constructor
+   *
+   * @param data Buffer to view
+   * @param size Size of the buffer
+   */
+  PacketView(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+  /** @overload */
+  explicit PacketView(const std::vector<uint8_t> &buffer)
+      : PacketView(buffer.data(), buffer.size()) {}
+
+  /** @brief Returns the viewed buffer */
+  const uint8_t *data() const noexcept { return data_; }
+
+  /** @brief Returns the size of the viewed buffer */
+  size_t size() const noexcept { return size_; }
+
+  /** @brief Sets current read position used by read_*() calls */
+  void seek(size_t position) const {
+    if (position > size_)
+      throw std::range_error("seek past EOF");
+    position_ = position;
+  }
+
+  /** @brief Returns current read position used by read_*() calls */
+  size_t tell() const noexcept {
+    return position_;
+  }
+
+  /** @brief Gets the sequence ID from the packet header
+   *
+   * @throws std::range_error if the buffer is smaller than the header
+   */
+  uint8_t get_sequence_id() const {
+    return read_int_from<uint8_t>(3);
+  }
+
+  /** @brief Gets the payload size from the packet header
+   *
+   * @throws std::range_error if the buffer is smaller than the header
+   */
+  uint32_t get_payload_size() const {
+    return read_int_from<uint32_t>(0, 3);
+  }
+
+  /** @brief Gets an integral at the current position and advances it
+   *
+   * @see Packet::read_int()
+   */
+  template<typename Type, typename = std::enable_if<std::is_integral<Type>::value>>
+  Type read_int(size_t length = sizeof(Type)) const {
+    Type res = read_int_from<Type>(position_, length); // throws range_error
+    position_ += length;
+    return res;
+  }
+
+  /** @brief Gets a length encoded integer at the current position and advances it
+   *
+   * @see Packet::read_lenenc_uint()
+   */
+  uint64_t read_lenenc_uint() const;
+
+  /** @brief Gets raw bytes at the current position and advances it
+   *
+   * @see Packet::read_bytes()
+   */
+  Bytes read_bytes(size_t length) const;
+
+  /** @brief Gets raw bytes with length encoded size at the current position
+   *         and advances it
+   *
+   * @see Packet::read_lenenc_bytes()
+   */
+  Bytes read_lenenc_bytes() const;
+
+  /** @brief Gets zero-terminated string at the current position and
+   *         advances it behind the zero-terminator
+   *
+   * The returned bytes don't include the zero-terminator.
+   *
+   * @see Packet::read_string_nul()
+   */
+  Bytes read_string_nul() const;
+
+  /** @brief Gets raw bytes from the current position until EOF
+   *
+   * @see Packet::read_bytes_eof()
+   */
+  Bytes read_bytes_eof() const;
+
+  /** @brief Gets an integral from the given position
+   *
+   * @see Packet::read_int_from()
+   */
+  template<typename Type, typename = std::enable_if<std::is_integral<Type>::value>>
+  Type read_int_from(size_t position, size_t length = sizeof(Type)) const {
+
+    harness_assert((length >= 1 && length <= 4) || length == 8);
+    if (position + length > size_)
+      throw std::range_error("start or end beyond EOF");
+
+    if (length == 1) {
+      return static_cast<Type>(data_[position]);
+    }
+
+    uint64_t result = 0;
+    const uint8_t *it = data_ + position + length;
+    while (length-- > 0) {
+      result <<= 8;
+      result |= *--it;
+    }
+
+    return static_cast<Type>(result);
+  }
+
+  /** @brief Gets a length encoded integer from the given position
+   *
+   * @return value and length of the encoded integer
+   *
+   * @see Packet::read_lenenc_uint_from()
+   */
+  std::pair<uint64_t, size_t> read_lenenc_uint_from(size_t position) const;
+
+  /** @brief Gets a zero-terminated string from the given position
+   *
+   * @see Packet::read_string_nul_from()
+   */
+  Bytes read_string_nul_from(size_t position) const;
+
+  /** @brief Gets raw bytes from the given position
+   *
+   * @see Packet::read_bytes_from()
+   */
+  Bytes read_bytes_from(size_t position, size_t length) const;
+
+  /** @brief Gets raw bytes with length encoded size from the given position
+   *
+   * @return bytes and length of the whole token
+   *
+   * @see Packet::read_lenenc_bytes_from()
+   */
+  std::pair<Bytes, size_t> read_lenenc_bytes_from(size_t position) const;
+
+  /** @brief Gets raw bytes from the given position until EOF
+   *
+   * @see Packet::read_bytes_eof_from()
+   */
+  Bytes read_bytes_eof_from(size_t position) const;
+
+ private:
+  const uint8_t *data_;
+  size_t size_;
+
+  /** @brief read position for stream operations */
+  mutable size_t position_{0};
+};
+
+} // namespace mysql_protocol
+
+#endif // MYSQLROUTER_MYSQL_PROTOCOL_PACKET_VIEW_INCLUDED
@@ -103,34 +103,7 @@ std::vector<uint8_t> Packet::read_bytes_eof() const {
 }
 
 std::pair<uint64_t, size_t> Packet::read_lenenc_uint_from(size_t position) const {
-
-  if (position >= size())
-    throw std::range_error("start beyond EOF");
-  if ((*this)[position] == 0xff ||  // 0xff is undefined in length encoded integers
-      (*this)[position] == 0xfb)    // 0xfb represents NULL and not used in length encoded integers
-    throw std::runtime_error("illegal value at first byte");
-
-  // single-byte uint
-  if ((*this)[position] < 0xfb) {
-    return std::make_pair((*this)[position], 1);
-  }
-
-  // multi-byte uint
-  size_t length = 2;
-  switch ((*this)[position]) {
-    case 0xfc:
-      length = 2;
-      break;
-    case 0xfd:
-      length = 3;
-      break;
-    case 0xfe:  // NOTE: up to MySQL 3.22 0xfe was follwed by 4 bytes, not 8
-      length = 8;
-  }
-  if (position + length >= size())
-    throw std::range_error("end beyond EOF");
-
-  return std::make_pair(read_int_from<uint64_t>(position + 1, length), length + 1);
+  return PacketView(*this).read_lenenc_uint_from(position);
 }
 
 std::string Packet::read_string_from(unsigned long position, unsigned long length) const {
@@ -146,44 +119,21 @@ std::string Packet::read_string_from(unsigned long position, unsigned long lengt
 }
 
 std::string Packet::read_string_nul_from(size_t position) const {
-  if (position >= size())
-    throw std::range_error("start beyond EOF");
-
-  auto it = std::find(begin() + position, end(), 0);
-  if (it == end())
-    throw std::runtime_error("zero-terminator not found");
-
-  return std::string(begin() + position, it);
+  return PacketView(*this).read_string_nul_from(position).str();
 }
 
 std::vector<uint8_t> Packet::read_bytes_from(size_t position, size_t length) const {
-
-  if (position + length > size())
-    throw std::range_error("start or end beyond EOF");
-
-  return std::vector<uint8_t>(begin() + position, begin() + position + length);
+  return PacketView(*this).read_bytes_from(position, length).vec();
 }
 
 std::pair<std::vector<uint8_t>, size_t> Packet::read_lenenc_bytes_from(size_t position) const {
-  auto pr = read_lenenc_uint_from(position); // throws runtime_error, range_error
+  auto pr = PacketView(*this).read_lenenc_bytes_from(position); // throws runtime_error, range_error
 
-  size_t lenenc_uint_value = pr.first;
-  size_t lenenc_uint_token_len = pr.second;
-
-  size_t start = position + lenenc_uint_token_len;
-  size_t endd = start + lenenc_uint_value;  // 'end' already exists
-  if (endd > size())
-    throw std::range_error("start or end beyond EOF");
-
-  return make_pair(std::vector<uint8_t>(begin() + start, begin() + endd),
-                   lenenc_uint_token_len + lenenc_uint_value);
+  return std::make_pair(pr.first.vec(), pr.second);
 }
 
 std::vector<uint8_t> Packet::read_bytes_eof_from(size_t position) const {
-  if (position >= size())
-    throw std::range_error("start beyond EOF");
-
-  return std::vector<uint8_t>(begin() + position, end());
+  return PacketView(*this).read_bytes_eof_from(position).vec();
 }
 
 void Packet::write_bytes_impl(const uint8_t* bytes, size_t length) {
@@ -0,0 +1,89 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "mysqlrouter/mysql_protocol.h"
+
+#include <string>
+#include <vector>
+
+namespace mysql_protocol {
+
+ChangeUserPacket::ChangeUserPacket(uint8_t sequence_id, const std::string &username,
+                                   const std::vector<uint8_t> &auth_response,
+                                   const std::string &database, uint8_t char_set,
+                                   const std::string &auth_plugin,
+                                   const std::vector<uint8_t> &connection_attrs,
+                                   Capabilities::Flags capabilities)
+    : Packet(sequence_id, capabilities), username_(username),
+      auth_response_(auth_response), database_(database), char_set_(char_set),
+      auth_plugin_(auth_plugin), connection_attrs_(connection_attrs) {
+  prepare_packet();
+}
+
+void ChangeUserPacket::prepare_packet() {
+  reset();
+  position_ = size();
+
+  // command
+  write_int<uint8_t>(Command::CHANGE_USER);
+
+  // username
+  write_string(username_);
+  write_int<uint8_t>(0);
+
+  // auth-response
+  if (capability_flags_.test(Capabilities::SECURE_CONNECTION)) {
+    if (auth_response_.size() > 0xff) {
+      throw packet_error("COM_CHANGE_USER: auth-response longer than 255 bytes");
+    }
+    write_int<uint8_t>(static_cast<uint8_t>(auth_response_.size()));
+    write_bytes(auth_response_);
+  } else {
+    write_bytes(auth_response_);
+    write_int<uint8_t>(0);
+  }
+
+  // database
+  write_string(database_);
+  write_int<uint8_t>(0);
+
+  // character set; the server reads the optional fields only with PROTOCOL_41
+  if (capability_flags_.test(Capabilities::PROTOCOL_41)) {
+    write_int<uint16_t>(char_set_);
+
+    if (capability_flags_.test(Capabilities::PLUGIN_AUTH)) {
+      write_string(auth_plugin_);
+      write_int<uint8_t>(0);
+    }
+
+    if (capability_flags_.test(Capabilities::CONNECT_ATTRS)) {
+      write_lenenc_uint(connection_attrs_.size());
+      write_bytes(connection_attrs_);
+    }
+  }
+
+  update_packet_size();
+}
+
+} // namespace mysql_protocol
@@ -189,7 +189,8 @@ void HandshakeResponsePacket::prepare_packet() {
      */
 
     constexpr size_t kReservedBytes = 23;
-    vector<uint8_t> reserved = packet_.read_bytes(kReservedBytes);
+    PacketView::Bytes reserved = PacketView(packet_).read_bytes_from(packet_.tell(), kReservedBytes);
+    packet_.seek(packet_.tell() + kReservedBytes);
 
     // proper packet should have all of those set to 0
     if (! std::all_of(reserved.begin(), reserved.end(), [](uint8_t c) { return c == 0; }))
@@ -286,7 +287,7 @@ void HandshakeResponsePacket::prepare_packet() {
      */
 
     if (effective_capability_flags_.test(Capabilities::CONNECT_ATTRS))
-      throw std::runtime_error("Handshake response packet: capability CONNECT_ATTRS is not implemented atm");
+      packet_.connection_attrs_ = packet_.read_lenenc_bytes();
   }
 
 
@@ -0,0 +1,136 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "mysqlrouter/mysql_protocol.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace mysql_protocol {
+
+uint64_t PacketView::read_lenenc_uint() const {
+  auto pr = read_lenenc_uint_from(position_);  // throws range_error/runtime_error
+  position_ += pr.second;
+  return pr.first;
+}
+
+PacketView::Bytes PacketView::read_bytes(size_t length) const {
+  Bytes res = read_bytes_from(position_, length); // throws range_error
+  position_ += length;
+  return res;
+}
+
+PacketView::Bytes PacketView::read_lenenc_bytes() const {
+  auto pr = read_lenenc_bytes_from(position_);  // throws range_error/runtime_error
+  position_ += pr.second;
+  return pr.first;
+}
+
+PacketView::Bytes PacketView::read_string_nul() const {
+  Bytes res = read_string_nul_from(position_);  // throws range_error/runtime_error
+  position_ += res.size() + 1; // +1 for zero-terminator
+  return res;
+}
+
+PacketView::Bytes PacketView::read_bytes_eof() const {
+  Bytes res = read_bytes_eof_from(position_);  // throws range_error
+  position_ += res.size();
+  return res;
+}
+
+std::pair<uint64_t, size_t> PacketView::read_lenenc_uint_from(size_t position) const {
+
+  if (position >= size_)
+    throw std::range_error("start beyond EOF");
+  if (data_[position] == 0xff ||  // 0xff is undefined in length encoded integers
+      data_[position] == 0xfb)    // 0xfb represents NULL and not used in length encoded integers
+    throw std::runtime_error("illegal value at first byte");
+
+  // single-byte uint
+  if (data_[position] < 0xfb) {
+    return std::make_pair(data_[position], 1);
+  }
+
+  // multi-byte uint
+  size_t length = 2;
+  switch (data_[position]) {
+    case 0xfc:
+      length = 2;
+      break;
+    case 0xfd:
+      length = 3;
+      break;
+    case 0xfe:  // NOTE: up to MySQL 3.22 0xfe was follwed by 4 bytes, not 8
+      length = 8;
+  }
+  if (position + length >= size_)
+    throw std::range_error("end beyond EOF");
+
+  return std::make_pair(read_int_from<uint64_t>(position + 1, length), length + 1);
+}
+
+PacketView::Bytes PacketView::read_string_nul_from(size_t position) const {
+  if (position >= size_)
+    throw std::range_error("start beyond EOF");
+
+  const uint8_t *start = data_ + position;
+  const uint8_t *it = std::find(start, data_ + size_, 0);
+  if (it == data_ + size_)
+    throw std::runtime_error("zero-terminator not found");
+
+  return Bytes(start, static_cast<size_t>(it - start));
+}
+
+PacketView::Bytes PacketView::read_bytes_from(size_t position, size_t length) const {
+
+  if (position + length > size_)
+    throw std::range_error("start or end beyond EOF");
+
+  return Bytes(data_ + position, length);
+}
+
+std::pair<PacketView::Bytes, size_t> PacketView::read_lenenc_bytes_from(size_t position) const {
+  auto pr = read_lenenc_uint_from(position); // throws runtime_error, range_error
+
+  size_t lenenc_uint_value = pr.first;
+  size_t lenenc_uint_token_len = pr.second;
+
+  size_t start = position + lenenc_uint_token_len;
+  if (lenenc_uint_value > size_ - start)
+    throw std::range_error("start or end beyond EOF");
+
+  return std::make_pair(Bytes(data_ + start, lenenc_uint_value),
+                        lenenc_uint_token_len + lenenc_uint_value);
+}
+
+PacketView::Bytes PacketView::read_bytes_eof_from(size_t position) const {
+  if (position >= size_)
+    throw std::range_error("start beyond EOF");
+
+  return Bytes(data_ + position, size_ - position);
+}
+
+} // namespace mysql_protocol
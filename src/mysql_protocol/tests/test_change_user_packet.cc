@@ -0,0 +1,83 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <gmock/gmock.h>
+
+#include "mysqlrouter/mysql_protocol.h"
+
+using ::testing::ElementsAreArray;
+using ::testing::HasSubstr;
+
+using namespace mysql_protocol;
+
+class ChangeUserPacketTest : public ::testing::Test {};
+
+TEST_F(ChangeUserPacketTest, Protocol41) {
+  ChangeUserPacket pkt(0, "root", {0x01, 0x02}, "db", 0x21,
+                       "mysql_native_password", {0x01, 'k', 0x01, 'v'},
+                       Capabilities::PROTOCOL_41 | Capabilities::SECURE_CONNECTION |
+                       Capabilities::PLUGIN_AUTH | Capabilities::CONNECT_ATTRS);
+
+  const std::vector<uint8_t> expected{
+      0x29, 0x00, 0x00, 0x00,        // header
+      0x11,                          // COM_CHANGE_USER
+      'r', 'o', 'o', 't', 0x00,      // username
+      0x02, 0x01, 0x02,              // auth-response
+      'd', 'b', 0x00,                // database
+      0x21, 0x00,                    // character set
+      'm', 'y', 's', 'q', 'l', '_', 'n', 'a', 't', 'i', 'v', 'e', '_',
+      'p', 'a', 's', 's', 'w', 'o', 'r', 'd', 0x00,  // auth plugin
+      0x04, 0x01, 'k', 0x01, 'v',    // connection attributes
+  };
+  EXPECT_THAT(pkt, ElementsAreArray(expected));
+  EXPECT_EQ("root", pkt.get_username());
+  EXPECT_EQ("db", pkt.get_database());
+}
+
+TEST_F(ChangeUserPacketTest, NoOptionalFields) {
+  ChangeUserPacket pkt(0, "u", {0x07}, "", 0x21, "mysql_native_password", {},
+                       Capabilities::SECURE_CONNECTION);
+
+  const std::vector<uint8_t> expected{
+      0x06, 0x00, 0x00, 0x00,
+      0x11,
+      'u', 0x00,
+      0x01, 0x07,
+      0x00,
+  };
+  EXPECT_THAT(pkt, ElementsAreArray(expected));
+}
+
+TEST_F(ChangeUserPacketTest, AuthResponseTooLong) {
+  const std::vector<uint8_t> auth_response(256, 0x01);
+
+  try {
+    ChangeUserPacket pkt(0, "u", auth_response, "", 0x21, "", {},
+                         Capabilities::PROTOCOL_41 | Capabilities::SECURE_CONNECTION);
+    FAIL() << "expected packet_error";
+  } catch (const packet_error &exc) {
+    EXPECT_THAT(exc.what(), HasSubstr("auth-response longer than 255 bytes"));
+  }
+}
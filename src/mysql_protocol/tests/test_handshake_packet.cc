@@ -736,9 +736,40 @@ TEST_F(HandshakeResponseParseTest, connection_attrs) {
   const size_t kOffset = bytes_before_connection_attrs.size();
   constexpr Capabilities::Flags flags = Capabilities::CONNECT_ATTRS;
 
-  // CONNECT_ATTRS is not implemented atm
+  // capability flag not set
+  {
+    std::vector<uint8_t> bytes = bytes_before_connection_attrs;
+
+    HandshakeResponsePacket pkt(bytes, kNoPayloadParse);
+
+    HandshakeResponsePacket::Parser41 prs(pkt);
+    pkt.position_ = kOffset;
+    prs.part8_connection_attrs();
+    EXPECT_EQ(kOffset, pkt.position_);
+    EXPECT_TRUE(pkt.connection_attrs_.empty());
+  }
+
+  // key-values are kept as they are
+  {
+    const std::vector<uint8_t> attrs = str2bytes("03 6b 65 79  05 76 61 6c 75 65"); // "key" "value"
+    std::vector<uint8_t> bytes = bytes_before_connection_attrs;
+    bytes.push_back(static_cast<uint8_t>(attrs.size()));
+    bytes.insert(bytes.end(), attrs.begin(), attrs.end());
+
+    HandshakeResponsePacket pkt(bytes, kNoPayloadParse);
+
+    HandshakeResponsePacket::Parser41 prs(pkt);
+    prs.effective_capability_flags_ = flags;
+    pkt.position_ = kOffset;
+    prs.part8_connection_attrs();
+    EXPECT_EQ(bytes.size(), pkt.position_);
+    EXPECT_EQ(attrs, pkt.connection_attrs_);
+  }
+
+  // EOF
   {
     std::vector<uint8_t> bytes = bytes_before_connection_attrs;
+    bytes.push_back(10);  // length, but no key-values follow
 
     HandshakeResponsePacket pkt(bytes, kNoPayloadParse);
 
@@ -747,7 +778,7 @@ TEST_F(HandshakeResponseParseTest, connection_attrs) {
     EXPECT_THROW_LIKE(
       pkt.position_ = kOffset;
       prs.part8_connection_attrs(),
-      std::runtime_error, "Handshake response packet: capability CONNECT_ATTRS is not implemented atm"
+      std::range_error, "start or end beyond EOF"
     );
   }
 }
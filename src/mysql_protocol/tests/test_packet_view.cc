@@ -0,0 +1,121 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mysqlrouter/mysql_protocol.h"
+
+using ::testing::ElementsAre;
+
+using namespace mysql_protocol;
+
+class PacketViewTest : public ::testing::Test {
+ public:
+  // header, int<2>, lenenc-int, string<NUL>, lenenc-string, string<EOF>
+  std::vector<uint8_t> buffer = {
+      0x0e, 0x00, 0x00, 0x02,
+      0x34, 0x12,
+      0xfc, 0x01, 0x01,
+      'a', 'b', 0x00,
+      0x02, 'c', 'd',
+      'e', 'f', 'g',
+  };
+};
+
+TEST_F(PacketViewTest, Header) {
+  PacketView view(buffer);
+
+  EXPECT_EQ(14u, view.get_payload_size());
+  EXPECT_EQ(2u, view.get_sequence_id());
+  EXPECT_EQ(buffer.data(), view.data());
+  EXPECT_EQ(buffer.size(), view.size());
+
+  PacketView too_short(buffer.data(), 3);
+  EXPECT_THROW(too_short.get_sequence_id(), std::range_error);
+}
+
+TEST_F(PacketViewTest, ReadStream) {
+  PacketView view(buffer);
+  view.seek(Packet::get_header_length());
+
+  EXPECT_EQ(0x1234u, view.read_int<uint16_t>());
+  EXPECT_EQ(0x0101u, view.read_lenenc_uint());
+
+  PacketView::Bytes str = view.read_string_nul();
+  EXPECT_EQ("ab", str.str());
+  EXPECT_TRUE(str.equals("ab"));
+  EXPECT_FALSE(str.equals("abc"));
+
+  PacketView::Bytes lenenc = view.read_lenenc_bytes();
+  EXPECT_THAT(lenenc.vec(), ElementsAre('c', 'd'));
+
+  PacketView::Bytes eof = view.read_bytes_eof();
+  EXPECT_EQ("efg", eof.str());
+  EXPECT_EQ(buffer.size(), view.tell());
+}
+
+TEST_F(PacketViewTest, ViewsDontCopy) {
+  PacketView view(buffer);
+
+  PacketView::Bytes bytes = view.read_bytes_from(9, 2);
+  EXPECT_EQ(buffer.data() + 9, bytes.data());
+
+  // changes of the buffer are seen through the view
+  buffer[9] = 'x';
+  EXPECT_EQ("xb", bytes.str());
+}
+
+TEST_F(PacketViewTest, ReadPastEof) {
+  PacketView view(buffer);
+
+  EXPECT_THROW(view.seek(buffer.size() + 1), std::range_error);
+  EXPECT_THROW(view.read_bytes_from(buffer.size() - 1, 2), std::range_error);
+  EXPECT_THROW(view.read_bytes_eof_from(buffer.size()), std::range_error);
+  EXPECT_THROW(view.read_string_nul_from(12), std::runtime_error);
+
+  // lenenc-string longer than the buffer
+  std::vector<uint8_t> truncated{0x05, 'a', 'b'};
+  EXPECT_THROW(PacketView(truncated).read_lenenc_bytes_from(0), std::range_error);
+
+  // position is unchanged after a failed read
+  view.seek(15);
+  EXPECT_THROW(view.read_bytes(4), std::range_error);
+  EXPECT_EQ(15u, view.tell());
+}
+
+TEST_F(PacketViewTest, SameResultsAsPacket) {
+  Packet packet(buffer);
+  PacketView view(buffer);
+
+  EXPECT_EQ(packet.read_lenenc_uint_from(6), view.read_lenenc_uint_from(6));
+  EXPECT_EQ(packet.read_string_nul_from(9), view.read_string_nul_from(9).str());
+  EXPECT_EQ(packet.read_lenenc_bytes_from(12).first, view.read_lenenc_bytes_from(12).first.vec());
+  EXPECT_EQ(packet.read_lenenc_bytes_from(12).second, view.read_lenenc_bytes_from(12).second);
+  EXPECT_EQ(packet.read_bytes_eof_from(15), view.read_bytes_eof_from(15).vec());
+}
@@ -39,6 +39,7 @@
 IMPORT_LOG_FUNCTIONS()
 
 using namespace mysqlrouter;
+using mysql_harness::logging::LogLevel;
 
 /*
    Mock recorder for MySQLSession
@@ -596,10 +597,14 @@ void MySQLSession::disconnect() {
 }
 
 void MySQLSession::execute(const std::string &q) {
-  log_debug("Executing query: %s", log_filter_.filter(q).c_str());
-  std::shared_ptr<void> exit_guard(nullptr, [](void*) {
-    log_debug("Done executing query");
-  });
+  // filtering the query is a regex replace, skip it if it isn't logged
+  std::shared_ptr<void> exit_guard;
+  if (log_level_is_handled(LogLevel::kDebug)) {
+    log_debug("Executing query: %s", log_filter_.filter(q).c_str());
+    exit_guard = std::shared_ptr<void>(nullptr, [](void*) {
+      log_debug("Done executing query");
+    });
+  }
 
   if (connected_) {
     MOCK_REC_EXECUTE(q);
@@ -627,10 +632,14 @@ void MySQLSession::execute(const std::string &q) {
  */
 void MySQLSession::query(const std::string &q,
                          const RowProcessor &processor) {
-  log_debug("Executing query: %s", log_filter_.filter(q).c_str());
-  std::shared_ptr<void> exit_guard(nullptr, [](void*) {
-    log_debug("Done executing query");
-  });
+  // filtering the query is a regex replace, skip it if it isn't logged
+  std::shared_ptr<void> exit_guard;
+  if (log_level_is_handled(LogLevel::kDebug)) {
+    log_debug("Executing query: %s", log_filter_.filter(q).c_str());
+    exit_guard = std::shared_ptr<void>(nullptr, [](void*) {
+      log_debug("Done executing query");
+    });
+  }
   if (connected_) {
     MOCK_REC_QUERY(q);
     if (mysql_real_query(connection_, q.data(), q.length()) != 0) {
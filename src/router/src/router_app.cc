@@ -373,6 +373,25 @@ std::map<std::string, std::string> MySQLRouter::get_default_paths() const {
   return params;
 }
 
+// [logger].async, read before set_default_log_level() erases the [logger] section
+static bool is_async_logging(const mysql_harness::LoaderConfig& config) {
+  constexpr const char kNone[] = "";
+  constexpr const char* kLogAsync = mysql_harness::logging::kConfigOptionLogAsync;
+  constexpr const char* kLogger = mysql_harness::logging::kConfigSectionLogger;
+
+  if (!config.has(kLogger) || !config.get(kLogger, kNone).has(kLogAsync))
+    return false;
+
+  const std::string value = config.get(kLogger, kNone).get(kLogAsync);
+  if (value == "1")
+    return true;
+  if (value == "0")
+    return false;
+
+  throw std::invalid_argument(std::string("Option '") + kLogAsync + "' in [" + kLogger +
+                              "] needs to be 0 or 1, got '" + value + "'");
+}
+
 // throws mysql_harness::bad_section (std::runtime_error) on [logger:some_key] section
 static void set_default_log_level(mysql_harness::LoaderConfig& config, bool raw_mode /*= false*/) {
 
@@ -458,6 +477,8 @@ std::exception_ptr detect_and_fix_nonfatal_problems(mysql_harness::LoaderConfig&
 /*static*/
 void MySQLRouter::init_main_logger(mysql_harness::LoaderConfig& config, bool raw_mode /*= false*/) {
 
+  const bool async_logging = is_async_logging(config);
+
   // set defaults if they're not defined
   set_default_log_level(config, raw_mode);  // throws std::runtime_error on [logger:some_key] section
   if (!config.has_default("logging_folder"))
@@ -489,7 +510,8 @@ void MySQLRouter::init_main_logger(mysql_harness::LoaderConfig& config, bool raw
 
     // attach all loggers to main handler (throws std::runtime_error)
     mysql_harness::logging::create_main_logfile_handler(*registry, kProgramName,
-                                                        logging_folder, !raw_mode);
+                                                        logging_folder, !raw_mode,
+                                                        async_logging);
 
     // nothing threw - we're good. Now let's replace the new registry with the old one
     DIM::instance().set_LoggingRegistry([&registry](){ return registry.release(); },
@@ -106,18 +106,34 @@ extern const unsigned int kDefaultNetBufferLength;
  */
 extern const std::chrono::seconds kDefaultClientConnectTimeout;
 
+/** @brief Default number of TLS sessions cached for resumption
+ *
+ * Used when the router terminates TLS of client connections.
+ */
+extern const unsigned int kDefaultClientSslSessionCacheSize;
+
+/** @brief Time idle server connections are kept in the pool (in seconds)
+ *
+ * Should be less than wait_timeout of the MySQL Server.
+ */
+extern const std::chrono::seconds kDefaultConnectionPoolIdleTimeout;
+
 #ifdef _WIN32
   const SOCKET kInvalidSocket = INVALID_SOCKET;// windows defines INVALID_SOCKET already
 #else
   const int kInvalidSocket = -1;
 #endif
 
+/** @brief Unix socket paths of local MySQL servers keyed by their TCP port */
+using LocalSockets = std::map<uint16_t, std::string>;
+
 
 /** @brief Modes supported by Routing plugin */
 enum class AccessMode {
   kUndefined = 0,
   kReadWrite = 1,
   kReadOnly = 2,
+  kReadWriteSplit = 3,  // reads to secondaries, writes to the primary
 };
 
 /** @brief Routing strategies supported by Routing plugin */
@@ -129,6 +145,15 @@ enum class RoutingStrategy {
   kRoundRobinWithFallback = 4,
 };
 
+/** @brief How client connections asking for SSL are handled */
+enum class ClientSslMode {
+  kUndefined = 0,
+  kPassthrough = 1,  // relay the encrypted stream to the server
+  kPreferred = 2,    // terminate TLS in the router if client asks for it
+  kRequired = 3,     // terminate TLS in the router, refuse plain clients
+  kDisabled = 4,     // don't offer SSL to clients
+};
+
 /** @brief Get comma separated list of all access mode names
  *
  */
@@ -184,6 +209,21 @@ RoutingStrategy get_routing_strategy(const std::string& value);
  */
 std::string get_routing_strategy_name(RoutingStrategy routing_strategy) noexcept;
 
+/** @brief Get comma separated list of all client SSL mode names
+ *
+ */
+std::string get_client_ssl_mode_names();
+
+/** @brief Returns ClientSslMode for its literal representation
+ *
+ * If no ClientSslMode is found for given string,
+ * ClientSslMode::kUndefined is returned.
+ *
+ * @param value literal representation of the client SSL mode
+ * @return ClientSslMode for the given string or ClientSslMode::kUndefined
+ */
+ClientSslMode get_client_ssl_mode(const std::string& value);
+
 /**
  * Sets blocking flag for given socket
  *
@@ -201,6 +241,7 @@ class RoutingSockOpsInterface {
  public:
   virtual ~RoutingSockOpsInterface() = default;
   virtual int get_mysql_socket(mysql_harness::TCPAddress addr, std::chrono::milliseconds connect_timeout_ms, bool log = true) noexcept = 0;
+  virtual int get_mysql_unix_socket(const std::string &socket_path, std::chrono::milliseconds connect_timeout_ms, bool log = true) noexcept = 0;
   virtual mysql_harness::SocketOperationsBase* so() const = 0;
 };
 
@@ -232,6 +273,24 @@ class RoutingSockOps : public RoutingSockOpsInterface {
    */
   int get_mysql_socket(mysql_harness::TCPAddress addr, std::chrono::milliseconds connect_timeout, bool log = true) noexcept override;
 
+  /** @brief Returns socket descriptor of MySQL server connected over Unix socket
+   *
+   * Used for destinations which run on the same host as the Router. Connects
+   * non-blocking like get_mysql_socket(), so that a hung MySQL Server or a
+   * full backlog makes the caller fall back to TCP instead of blocking it.
+   *
+   * Returns a socket descriptor for the connection to the MySQL Server or
+   * negative value when error occurred (always on Windows):
+   *  -2 - if connection timeout has expired
+   *  -1 - in case of any other error
+   *
+   * @param socket_path path to the Unix socket of the MySQL Server
+   * @param connect_timeout timeout waiting for connection
+   * @param log whether to log errors or not
+   * @return a socket descriptor
+   */
+  int get_mysql_unix_socket(const std::string &socket_path, std::chrono::milliseconds connect_timeout, bool log = true) noexcept override;
+
   /** @brief Returns SocketOperations implementation used by this class */
   mysql_harness::SocketOperationsBase* so() const override { return so_; }
 
@@ -0,0 +1,369 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "client_tls.h"
+
+#include "mysql/harness/logging/logging.h"
+#include "mysqlrouter/routing.h"
+
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include <openssl/err.h>
+
+#ifndef _WIN32
+# include <poll.h>
+#endif
+
+IMPORT_LOG_FUNCTIONS()
+
+#ifdef HAVE_YASSL
+using namespace yaSSL;
+
+// yaSSL's default PEM pass phrase callback uses this function of the MySQL
+// client library. Keys with pass phrase are not supported: never prompt.
+char *yassl_mysql_get_tty_password_ext(const char *, char *(*)(const char *, int)) {
+  return nullptr;
+}
+#endif
+
+// kernel TLS offload needs OpenSSL 3.0 built with ktls support
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS) && !defined(HAVE_YASSL)
+# define ROUTING_HAVE_KTLS 1
+#endif
+
+#ifdef HAVE_YASSL
+// yaSSL only learns that the socket is non-blocking when a recv() fails
+// with EAGAIN. Until then it loops on partial records, which spins on a
+// non-blocking socket. The first receive after the handshake reports
+// EAGAIN to switch it to non-blocking mode.
+struct YasslTransport {
+  int fd;
+  bool nonblocking_reported;
+};
+
+namespace {
+
+extern "C" long yassl_transport_recv(void *ptr, void *buf, size_t count) {
+  YasslTransport *transport = static_cast<YasslTransport*>(ptr);
+  if (!transport->nonblocking_reported) {
+    transport->nonblocking_reported = true;
+    errno = EAGAIN;
+    return -1;
+  }
+  return static_cast<long>(::recv(transport->fd, static_cast<char*>(buf), count, 0));
+}
+
+}
+#endif
+
+namespace {
+
+std::string get_ssl_error_string() {
+  char buf[256];
+  unsigned long err = ERR_get_error();
+  if (err == 0) {
+    return "unknown error";
+  }
+  ERR_error_string_n(err, buf, sizeof(buf));
+
+  // drain the rest of the error queue
+  while (ERR_get_error() != 0) {}
+
+  return buf;
+}
+
+const unsigned char kSessionIdContext[] = "mysqlrouter";
+
+// sets receive and send timeout of the socket; zero disables them
+void set_socket_timeouts(mysql_harness::SocketOperationsBase *so, int fd,
+                         std::chrono::milliseconds timeout) {
+#ifdef _WIN32
+  DWORD tv = static_cast<DWORD>(timeout.count());
+#else
+  struct timeval tv;
+  tv.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+  tv.tv_usec = static_cast<suseconds_t>((timeout.count() % 1000) * 1000);
+#endif
+  so->setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, static_cast<socklen_t>(sizeof(tv)));
+  so->setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, static_cast<socklen_t>(sizeof(tv)));
+}
+
+
+}
+
+ClientTlsContext::ClientTlsContext(const std::string &cert_file,
+                                   const std::string &key_file,
+                                   size_t session_cache_size, bool ktls)
+    : ctx_(nullptr), ktls_(false) {
+  static std::once_flag ssl_init_flag;
+  std::call_once(ssl_init_flag, []() {
+    SSL_library_init();
+    SSL_load_error_strings();
+  });
+
+  ctx_ = SSL_CTX_new(SSLv23_server_method());
+  if (ctx_ == nullptr) {
+    throw std::runtime_error("Could not create TLS context: " + get_ssl_error_string());
+  }
+
+  try {
+#ifndef HAVE_YASSL
+    SSL_CTX_set_options(ctx_, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 | SSL_OP_NO_COMPRESSION);
+#endif
+
+#ifdef HAVE_YASSL
+    // yaSSL doesn't implement loading chains, only the server certificate
+    if (SSL_CTX_use_certificate_file(ctx_, cert_file.c_str(), SSL_FILETYPE_PEM) != 1) {
+#else
+    if (SSL_CTX_use_certificate_chain_file(ctx_, cert_file.c_str()) != 1) {
+#endif
+      throw std::runtime_error("Could not load certificate '" + cert_file + "': " +
+                               get_ssl_error_string());
+    }
+
+    if (SSL_CTX_use_PrivateKey_file(ctx_, key_file.c_str(), SSL_FILETYPE_PEM) != 1) {
+      throw std::runtime_error("Could not load private key '" + key_file + "': " +
+                               get_ssl_error_string());
+    }
+
+#ifndef HAVE_YASSL
+    // not implemented by yaSSL, a mismatch fails the handshake instead
+    if (SSL_CTX_check_private_key(ctx_) != 1) {
+      throw std::runtime_error("Private key '" + key_file + "' does not match certificate '" +
+                               cert_file + "'");
+    }
+#endif
+
+    SSL_CTX_set_verify(ctx_, SSL_VERIFY_NONE, nullptr);
+
+    if (session_cache_size > 0) {
+      // session IDs and, with OpenSSL, session tickets. The ticket keys are
+      // generated per context, so tickets stay valid as long as the route
+      // is running.
+      SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER);
+      SSL_CTX_sess_set_cache_size(ctx_, static_cast<long>(std::min<size_t>(session_cache_size, LONG_MAX)));
+      SSL_CTX_set_session_id_context(ctx_, kSessionIdContext,
+                                     static_cast<unsigned int>(sizeof(kSessionIdContext) - 1));
+    } else {
+      SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_OFF);
+#ifdef SSL_OP_NO_TICKET
+      SSL_CTX_set_options(ctx_, SSL_OP_NO_TICKET);
+#endif
+    }
+
+    if (ktls) {
+#ifdef ROUTING_HAVE_KTLS
+      SSL_CTX_set_options(ctx_, SSL_OP_ENABLE_KTLS);
+      ktls_ = true;
+#else
+      log_warning("kernel TLS is not supported by the SSL library, using userspace TLS");
+#endif
+    }
+  } catch (...) {
+    SSL_CTX_free(ctx_);
+    throw;
+  }
+}
+
+ClientTlsContext::~ClientTlsContext() {
+  SSL_CTX_free(ctx_);
+}
+
+ClientTlsConnection::ClientTlsConnection(const ClientTlsContext &ctx,
+                                         mysql_harness::SocketOperationsBase *so,
+                                         int fd)
+    : ssl_(SSL_new(ctx.get())), so_(so), fd_(fd), timeout_(0) {
+  if (ssl_ == nullptr) {
+    throw std::runtime_error("Could not create TLS connection: " + get_ssl_error_string());
+  }
+  SSL_set_fd(ssl_, fd_);
+}
+
+ClientTlsConnection::~ClientTlsConnection() {
+  SSL_free(ssl_);
+}
+
+bool ClientTlsConnection::accept(std::chrono::milliseconds timeout) {
+  timeout_ = timeout;
+
+  {
+    // the handshake runs on the blocking socket and is bounded by socket
+    // timeouts: yaSSL can't resume a handshake that ran out of data
+    set_socket_timeouts(so_, fd_, timeout);
+    std::shared_ptr<void> timeout_guard(nullptr, [this](void*) {
+      set_socket_timeouts(so_, fd_, std::chrono::milliseconds::zero());
+    });
+
+    const int res = SSL_accept(ssl_);
+    if (res != 1) {
+      log_debug("fd=%d TLS handshake failed: %s", fd_, get_ssl_error_string().c_str());
+      return false;
+    }
+  }
+
+  // afterwards the socket is non-blocking: a partial record must not block
+  // the connection thread. Callers poll() before reading.
+  routing::set_socket_blocking(fd_, false);
+#ifdef HAVE_YASSL
+  transport_.reset(new YasslTransport{fd_, false});
+  yaSSL_transport_set_ptr(ssl_, transport_.get());
+  yaSSL_transport_set_recv_function(ssl_, yassl_transport_recv);
+#endif
+
+  return true;
+}
+
+ssize_t ClientTlsConnection::ssl_read(uint8_t *buffer, size_t size) {
+  const int res = SSL_read(ssl_, buffer, static_cast<int>(std::min<size_t>(size, INT_MAX)));
+  if (res > 0) {
+    return res;
+  }
+
+  switch (SSL_get_error(ssl_, res)) {
+    case SSL_ERROR_ZERO_RETURN:
+      // the caller assumes that errno == 0 on plain connection closes.
+      so_->set_errno(0);
+      return 0;
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+      so_->set_errno(EAGAIN);
+      return -1;
+    default:
+      log_debug("fd=%d TLS read failed: %s", fd_, get_ssl_error_string().c_str());
+      return -1;
+  }
+}
+
+ssize_t ClientTlsConnection::read(uint8_t *buffer, size_t size) {
+#ifdef HAVE_YASSL
+  // yaSSL's SSL_pending() peeks, which drops records on non-blocking
+  // sockets. Everything yaSSL decrypted is taken into read_ahead_ instead:
+  // if SSL_read() returns less than asked for, yaSSL has nothing buffered.
+  if (read_ahead_pos_ == read_ahead_.size()) {
+    read_ahead_.resize(kReadAheadSize);
+    read_ahead_pos_ = 0;
+    size_t filled = 0;
+    while (true) {
+      const ssize_t res = ssl_read(&read_ahead_[filled], read_ahead_.size() - filled);
+      if (res <= 0) {
+        if (filled > 0) break;
+        read_ahead_.clear();
+        return res;
+      }
+      filled += static_cast<size_t>(res);
+      if (filled < read_ahead_.size()) break;
+      read_ahead_.resize(read_ahead_.size() * 2);
+    }
+    read_ahead_.resize(filled);
+  }
+
+  const size_t bytes = std::min(size, read_ahead_.size() - read_ahead_pos_);
+  std::copy(read_ahead_.begin() + static_cast<std::ptrdiff_t>(read_ahead_pos_),
+            read_ahead_.begin() + static_cast<std::ptrdiff_t>(read_ahead_pos_ + bytes),
+            buffer);
+  read_ahead_pos_ += bytes;
+
+  return static_cast<ssize_t>(bytes);
+#else
+  return ssl_read(buffer, size);
+#endif
+}
+
+ssize_t ClientTlsConnection::write_all(const uint8_t *buffer, size_t size) {
+  size_t written = 0;
+  while (written < size) {
+    // after WANT_READ/WANT_WRITE the write has to be repeated with the same
+    // arguments
+    const int res = SSL_write(ssl_, buffer + written,
+        static_cast<int>(std::min<size_t>(size - written, INT_MAX)));
+    if (res <= 0) {
+      const int err = SSL_get_error(ssl_, res);
+      if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+        if (!wait_for_socket(err == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT)) {
+          return -1;
+        }
+        continue;
+      }
+      log_debug("fd=%d TLS write failed: %s", fd_, get_ssl_error_string().c_str());
+      return -1;
+    }
+    written += static_cast<size_t>(res);
+  }
+
+  return static_cast<ssize_t>(written);
+}
+
+bool ClientTlsConnection::wait_for_socket(short events) {
+  while (true) {
+    struct pollfd fds[] = {
+      { fd_, events, 0 },
+    };
+    const int res = so_->poll(fds, 1, timeout_);
+    if (res > 0) return true;
+    if (res == 0) {
+      log_debug("fd=%d TLS write timed out", fd_);
+      so_->set_errno(ETIMEDOUT);
+      return false;
+    }
+    if (so_->get_errno() != EINTR) return false;
+  }
+}
+
+size_t ClientTlsConnection::pending() const {
+#ifdef HAVE_YASSL
+  return read_ahead_.size() - read_ahead_pos_;
+#else
+  const int res = SSL_pending(ssl_);
+
+  return res > 0 ? static_cast<size_t>(res) : 0;
+#endif
+}
+
+bool ClientTlsConnection::is_ktls() const {
+#ifdef ROUTING_HAVE_KTLS
+  return BIO_get_ktls_send(SSL_get_wbio(ssl_)) &&
+         BIO_get_ktls_recv(SSL_get_rbio(ssl_)) &&
+         SSL_pending(ssl_) == 0;
+#else
+  return false;
+#endif
+}
+
+bool ClientTlsConnection::session_reused() const {
+  return SSL_session_reused(ssl_) == 1;
+}
+
+std::string ClientTlsConnection::version() const {
+  const char *v = SSL_get_version(ssl_);
+
+  return v ? v : "";
+}
+
+void ClientTlsConnection::shutdown() {
+  SSL_shutdown(ssl_);
+}
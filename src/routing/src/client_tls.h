@@ -0,0 +1,170 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef ROUTING_CLIENT_TLS_INCLUDED
+#define ROUTING_CLIENT_TLS_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <openssl/ssl.h>
+#ifdef HAVE_YASSL
+using yaSSL::SSL;
+using yaSSL::SSL_CTX;
+#endif
+
+#include "socket_operations.h"  // ssize_t
+
+#ifdef HAVE_YASSL
+struct YasslTransport;
+#endif
+
+/** @class ClientTlsContext
+ * @brief TLS server side settings shared by all client connections of a route
+ *
+ * Holds certificate, key and the session cache. Sessions (and session
+ * tickets if supported by the SSL library) are kept per route which lets
+ * reconnecting clients resume their session instead of doing a full
+ * handshake.
+ */
+class ClientTlsContext {
+ public:
+  /** @brief Constructor
+   *
+   * @param cert_file path to the certificate (chain) in PEM format
+   * @param key_file path to the private key in PEM format
+   * @param session_cache_size max number of cached sessions; 0 disables
+   *        session resumption
+   * @param ktls try to hand symmetric crypto to the kernel (kTLS)
+   *
+   * @throws std::runtime_error if the context can't be set up
+   */
+  ClientTlsContext(const std::string &cert_file, const std::string &key_file,
+                   size_t session_cache_size, bool ktls);
+
+  ~ClientTlsContext();
+
+  ClientTlsContext(const ClientTlsContext&) = delete;
+  ClientTlsContext& operator=(const ClientTlsContext&) = delete;
+
+  SSL_CTX *get() const noexcept { return ctx_; }
+
+  /** @brief Whether kTLS was requested and is supported by this build */
+  bool ktls() const noexcept { return ktls_; }
+
+ private:
+  SSL_CTX *ctx_;
+  bool ktls_;
+};
+
+/** @class ClientTlsConnection
+ * @brief TLS session between a client and the router
+ */
+class ClientTlsConnection {
+ public:
+  /** @brief Constructor
+   *
+   * @param ctx context of the route the client connected to
+   * @param so object handling the operations on network sockets
+   * @param fd socket of the client
+   *
+   * @throws std::runtime_error if the SSL object can't be created
+   */
+  ClientTlsConnection(const ClientTlsContext &ctx,
+                      mysql_harness::SocketOperationsBase *so, int fd);
+
+  ~ClientTlsConnection();
+
+  ClientTlsConnection(const ClientTlsConnection&) = delete;
+  ClientTlsConnection& operator=(const ClientTlsConnection&) = delete;
+
+  /** @brief Runs the server side of the TLS handshake
+   *
+   * Afterwards the client socket is non-blocking.
+   *
+   * @param timeout max time to wait for data from the client; also bounds
+   *        the time write_all() waits for the client to take data
+   * @return true on success; false on error
+   */
+  bool accept(std::chrono::milliseconds timeout);
+
+  /** @brief Reads decrypted data
+   *
+   * @return bytes read; 0 on close; -1 on error with errno set (EAGAIN if
+   *         no application data is available yet)
+   */
+  ssize_t read(uint8_t *buffer, size_t size);
+
+  /** @brief Encrypts and writes all data
+   *
+   * Waits with poll() while the socket buffer is full.
+   *
+   * @return bytes written; -1 on error or timeout
+   */
+  ssize_t write_all(const uint8_t *buffer, size_t size);
+
+  /** @brief Number of decrypted bytes buffered by the SSL library */
+  size_t pending() const;
+
+  /** @brief Whether the kernel does encryption and decryption
+   *
+   * If true, plain reads and writes on the client socket carry
+   * application data and the SSL object doesn't need to be used anymore.
+   */
+  bool is_ktls() const;
+
+  /** @brief Whether the session was resumed */
+  bool session_reused() const;
+
+  /** @brief Returns the negotiated protocol version, e.g. "TLSv1.2" */
+  std::string version() const;
+
+  /** @brief Sends close_notify to the client */
+  void shutdown();
+
+ private:
+  // waits until the socket gets readable (POLLIN) or writable (POLLOUT)
+  bool wait_for_socket(short events);
+
+  ssize_t ssl_read(uint8_t *buffer, size_t size);
+
+  SSL *ssl_;
+  mysql_harness::SocketOperationsBase *so_;
+  int fd_;
+  std::chrono::milliseconds timeout_;
+#ifdef HAVE_YASSL
+  static constexpr size_t kReadAheadSize = 16 * 1024;
+
+  std::unique_ptr<YasslTransport> transport_;
+  // decrypted data not read yet
+  std::vector<uint8_t> read_ahead_;
+  size_t read_ahead_pos_{0};
+#endif
+};
+
+#endif // ROUTING_CLIENT_TLS_INCLUDED
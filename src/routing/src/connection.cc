@@ -22,9 +22,11 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#include <algorithm>
 #include <cstring>
 #include <string>
 
+#include "client_tls.h"
 #include "common.h"
 #include "connection.h"
 #include "mysql_router_thread.h"
@@ -32,9 +34,102 @@
 #include "mysql/harness/loader.h"
 #include "mysql/harness/logging/logging.h"
 #include "mysqlrouter/routing.h"
+#include "protocol/classic_protocol.h"
+#include "protocol/statement_classifier.h"
 #include "utils.h"
 IMPORT_LOG_FUNCTIONS()
 
+using mysql_harness::logging::LogLevel;
+
+namespace {
+
+using mysql_protocol::Capabilities::Flags;
+
+// client capabilities which don't change the protocol of an established session
+const Flags kSessionIndependentCapabilities =
+    mysql_protocol::Capabilities::SSL |
+    mysql_protocol::Capabilities::CONNECT_WITH_DB |
+    mysql_protocol::Capabilities::CONNECT_ATTRS |
+    mysql_protocol::Capabilities::PLUGIN_AUTH_LENENC_CLIENT_DATA |
+    mysql_protocol::Capabilities::SSL_VERIFY_SERVER_CERT |
+    mysql_protocol::Capabilities::REMEMBER_OPTIONS;
+
+const uint8_t kComQuit[] = {1, 0, 0, 0, mysql_protocol::Command::QUIT};
+
+// statements may run for any time
+const std::chrono::milliseconds kNoTimeout{-1};
+
+const size_t kHeaderSize = mysql_protocol::Packet::kHeaderSize;
+
+// how long reads of a split session stay with the primary if no secondary
+// could be used
+const std::chrono::milliseconds kReadOnlyRetryInterval{std::chrono::seconds(5)};
+
+bool fits_session(Flags client_capabilities, Flags session_capabilities) {
+  return client_capabilities.clear(kSessionIndependentCapabilities) ==
+         session_capabilities.clear(kSessionIndependentCapabilities);
+}
+
+/*
+ * Relays data if the router ran the handshake. At most one of sender_tls
+ * and receiver_tls is set, the side whose TLS the router terminates.
+ *
+ * If session is set, it is updated with the relayed data, which comes from
+ * the client if from_client is set. If quit is set,
+ * a COM_QUIT the client sends on an idle session is not relayed but
+ * reported in it.
+ */
+int copy_tls(mysql_harness::SocketOperationsBase *so,
+             int sender, ClientTlsConnection *sender_tls,
+             int receiver, ClientTlsConnection *receiver_tls,
+             bool sender_is_readable, RoutingProtocolBuffer &buffer,
+             size_t *report_bytes_read,
+             ClassicSessionTracker *session = nullptr, bool from_client = false,
+             bool *quit = nullptr) {
+  *report_bytes_read = 0;
+  if (!sender_is_readable) return 0;
+
+  const ssize_t res = sender_tls ? sender_tls->read(&buffer[0], buffer.size())
+                                 : so->read(sender, &buffer[0], buffer.size());
+  if (res < 0 && sender_tls && so->get_errno() == EAGAIN) {
+    // TLS record without application data
+    return 0;
+  }
+  if (res <= 0) {
+    if (res == 0) {
+      // the caller assumes that errno == 0 on plain connection closes.
+      so->set_errno(0);
+    }
+    return -1;
+  }
+
+  const size_t bytes_read = static_cast<size_t>(res);
+  if (quit && session && session->is_idle() && bytes_read == sizeof(kComQuit) &&
+      memcmp(&buffer[0], kComQuit, sizeof(kComQuit)) == 0) {
+    *quit = true;
+    *report_bytes_read = bytes_read;
+    return 0;
+  }
+
+  const ssize_t written = receiver_tls ? receiver_tls->write_all(&buffer[0], bytes_read)
+                                       : so->write_all(receiver, &buffer[0], bytes_read);
+  if (written < 0) {
+    return -1;
+  }
+  if (session) {
+    if (from_client) {
+      session->update_client(&buffer[0], bytes_read);
+    } else {
+      session->update_server(&buffer[0], bytes_read);
+    }
+  }
+
+  *report_bytes_read = bytes_read;
+  return 0;
+}
+
+}
+
 MySQLRoutingConnection ::MySQLRoutingConnection(MySQLRoutingContext& context, int client_socket,
     const sockaddr_storage& client_addr, int server_socket,
     const mysql_harness::TCPAddress& server_address,
@@ -45,7 +140,18 @@ MySQLRoutingConnection ::MySQLRoutingConnection(MySQLRoutingContext& context, in
   client_addr_(client_addr),
   server_socket_(server_socket),
   server_address_(server_address),
-  client_address_(make_client_address(client_socket, context)){
+  client_address_(make_client_address(client_addr, context)){
+}
+
+void MySQLRoutingConnection::set_pooled_server(PooledServerConnection pooled,
+    std::function<int(const mysql_harness::TCPAddress&)> connect_server) {
+  pooled_server_.reset(new PooledServerConnection(std::move(pooled)));
+  connect_server_ = std::move(connect_server);
+}
+
+void MySQLRoutingConnection::set_read_only_server(
+    std::function<int(mysql_harness::TCPAddress*)> connect_read_only) {
+  connect_read_only_ = std::move(connect_read_only);
 }
 
 void MySQLRoutingConnection::start(bool detached) {
@@ -126,33 +232,115 @@ void MySQLRoutingConnection::run() {
     return;
   }
 
-  std::pair<std::string, int> c_ip = get_peer_name(client_socket_);
-  std::pair<std::string, int> s_ip = get_peer_name(server_socket_);
+  int pktnr = 0;
+  bool connection_is_ok = true;
 
-  if (c_ip.second == 0) {
-    // Unix socket/Windows Named pipe
-    log_debug("[%s] fd=%d connected %s -> %s:%d as fd=%d",
-        context_.get_name().c_str(),
-        client_socket_,
-        context_.get_bind_named_socket().c_str(),
-        s_ip.first.c_str(), s_ip.second,
-        server_socket_);
-  } else {
-    log_debug("[%s] fd=%d connected %s:%d -> %s:%d as fd=%d",
-        context_.get_name().c_str(),
-        client_socket_,
-        c_ip.first.c_str(), c_ip.second,
-        s_ip.first.c_str(), s_ip.second,
-        server_socket_);
+  if (log_level_is_handled(LogLevel::kDebug)) {
+    std::pair<std::string, int> c_ip = get_peer_name(client_addr_);
+    std::pair<std::string, int> s_ip = get_peer_name(server_socket_);
+
+    if (c_ip.second == 0) {
+      // Unix socket/Windows Named pipe
+      log_debug("[%s] fd=%d connected %s -> %s:%d as fd=%d",
+          context_.get_name().c_str(),
+          client_socket_,
+          context_.get_bind_named_socket().c_str(),
+          s_ip.first.c_str(), s_ip.second,
+          server_socket_);
+    } else {
+      log_debug("[%s] fd=%d connected %s:%d -> %s:%d as fd=%d",
+          context_.get_name().c_str(),
+          client_socket_,
+          c_ip.first.c_str(), c_ip.second,
+          s_ip.first.c_str(), s_ip.second,
+          server_socket_);
+    }
   }
 
   context_.increase_info_active_routes();
   context_.increase_info_handled_routes();
 
-  int pktnr = 0;
+  // TLS connection to the client if the router terminates it
+  std::unique_ptr<ClientTlsConnection> client_tls;
+  // set if data from/to the client has to go through the SSL library
+  ClientTlsConnection *tls_relay = nullptr;
+  // set if the router ran the whole handshake and relays the data itself
+  bool relay_in_router = false;
+  // set if the server connection may be pooled when the client quits
+  bool poolable = false;
 
-  bool connection_is_ok = true;
-  while (connection_is_ok && !disconnect_) {
+  // set if reads and writes of the session are split
+  bool split = false;
+
+  if (connect_read_only_) {
+    if (handshake_split(client_tls, &split, extra_msg) == -1) {
+      connection_is_ok = false;
+    } else {
+      handshake_done = true;
+      relay_in_router = true;
+    }
+  } else if (context_.get_connection_pool() != nullptr ||
+      context_.get_client_ssl_mode() == routing::ClientSslMode::kDisabled) {
+    bool authenticated = false;
+    if (handshake_in_router(client_tls, &authenticated, extra_msg) == -1) {
+      connection_is_ok = false;
+    } else {
+      handshake_done = true;
+      relay_in_router = true;
+      // reusing the session needs an auth-switch, which needs plugin auth;
+      // the session tracker can't follow the other capabilities
+      poolable = context_.get_connection_pool() != nullptr && authenticated &&
+                 session_capabilities_.test(mysql_protocol::Capabilities::PLUGIN_AUTH) &&
+                 !session_capabilities_.test(mysql_protocol::Capabilities::COMPRESS) &&
+                 !session_capabilities_.test(
+                     mysql_protocol::Capabilities::OPTIONAL_RESULTSET_METADATA);
+    }
+  } else if (context_.get_client_tls_context() != nullptr) {
+    // the configuration allows TLS termination for the classic protocol only
+    auto &protocol = static_cast<ClassicProtocol&>(context_.get_protocol());
+    if (protocol.handshake_client_tls(client_socket_, server_socket_,
+                                      *context_.get_client_tls_context(),
+                                      context_.get_client_ssl_mode(),
+                                      context_.get_client_connect_timeout(),
+                                      client_tls, &pktnr, context_.get_name()) == -1) {
+      connection_is_ok = false;
+      extra_msg = std::string("client TLS handshake failed");
+    } else if (pktnr == 2) {
+      handshake_done = true;
+    }
+  }
+
+  if (connection_is_ok && client_tls) {
+    // with kTLS the kernel encrypts and decrypts, the socket can be used as is
+    if (!client_tls->is_ktls()) {
+      tls_relay = client_tls.get();
+    } else {
+      // the TLS connection left the socket non-blocking
+      routing::set_socket_blocking(client_socket_, true);
+    }
+    log_debug("[%s] fd=%d TLS terminated (%s%s%s)",
+        context_.get_name().c_str(),
+        client_socket_,
+        client_tls->version().c_str(),
+        client_tls->session_reused() ? ", session resumed" : "",
+        tls_relay ? "" : ", kTLS");
+  }
+
+  // protocol state of a poolable session
+  std::unique_ptr<ClassicSessionTracker> session;
+  if (poolable) {
+    session.reset(new ClassicSessionTracker(
+        session_capabilities_.test(mysql_protocol::Capabilities::DEPRECATE_EOF)));
+  }
+  bool client_quit = false;
+
+  // a pinned session continues with the primary below
+  if (connection_is_ok && split &&
+      run_split_session(tls_relay, &client_quit, bytes_up, bytes_down, extra_msg) == -1) {
+    connection_is_ok = false;
+  }
+
+  while (connection_is_ok && !disconnect_ && !client_quit) {
     const size_t kClientEventIndex = 0;
     const size_t kServerEventIndex = 1;
 
@@ -164,9 +352,13 @@ void MySQLRoutingConnection::run() {
     fds[kClientEventIndex].fd = client_socket_;
     fds[kServerEventIndex].fd = server_socket_;
 
+    // decrypted data may already wait in the SSL library
+    const bool tls_pending = tls_relay && tls_relay->pending() > 0;
+
     const std::chrono::milliseconds poll_timeout_ms =
-        handshake_done ? std::chrono::milliseconds(1000)
-                       : context_.get_client_connect_timeout();
+        tls_pending ? std::chrono::milliseconds::zero()
+        : handshake_done ? std::chrono::milliseconds(1000)
+                         : context_.get_client_connect_timeout();
     int res = context_.get_socket_operations()->poll(fds, sizeof(fds) / sizeof(fds[0]), poll_timeout_ms);
 
     if (res < 0) {
@@ -184,7 +376,7 @@ void MySQLRoutingConnection::run() {
       }
 
       continue;
-    } else if (res == 0) {
+    } else if (res == 0 && !tls_pending) {
       // timeout
       if (!handshake_done) {
         connection_is_ok = false;
@@ -203,9 +395,40 @@ void MySQLRoutingConnection::run() {
     // * Linux: POLLIN + read() == 0
     // * Windows: POLLHUP
 
-    const bool client_is_readable = (fds[kClientEventIndex].revents & (POLLIN|POLLHUP)) != 0;
+    const bool client_is_readable = tls_pending || (fds[kClientEventIndex].revents & (POLLIN|POLLHUP)) != 0;
     const bool server_is_readable = (fds[kServerEventIndex].revents & (POLLIN|POLLHUP)) != 0;
 
+    if (tls_relay || relay_in_router) {
+      // handshake is done, relay the data (through the SSL library for TLS clients)
+      if (copy_tls(context_.get_socket_operations(), server_socket_, nullptr,
+                   client_socket_, tls_relay, server_is_readable, buffer, &bytes_read,
+                   session.get(), false) == -1) {
+        const int last_errno = context_.get_socket_operations()->get_errno();
+        if (last_errno > 0) {
+          extra_msg = std::string("Copy server->client failed: " + mysqlrouter::to_string(get_message_error(last_errno)));
+        }
+        connection_is_ok = false;
+      } else {
+        bytes_up += bytes_read;
+      }
+
+      if (!connection_is_ok) continue;
+
+      if (copy_tls(context_.get_socket_operations(), client_socket_, tls_relay,
+                   server_socket_, nullptr, client_is_readable, buffer, &bytes_read,
+                   session.get(), true, session ? &client_quit : nullptr) == -1) {
+        const int last_errno = context_.get_socket_operations()->get_errno();
+        if (last_errno > 0) {
+          extra_msg = std::string("Copy client->server failed: " + mysqlrouter::to_string(get_message_error(last_errno)));
+        }
+        connection_is_ok = false;
+      } else {
+        bytes_down += bytes_read;
+      }
+
+      continue;
+    }
+
     // Handle traffic from Server to Client
     // Note: In classic protocol Server _always_ talks first
     if (context_.get_protocol().copy_packets(server_socket_, client_socket_, server_is_readable,
@@ -239,19 +462,30 @@ void MySQLRoutingConnection::run() {
   } // while (connection_is_ok && !disconnect_.load())
 
   if (!handshake_done) {
+    const std::string client_ip = get_peer_name(client_addr_).first;
     log_info("[%s] fd=%d Pre-auth socket failure %s: %s",
         context_.get_name().c_str(),
         client_socket_,
-        c_ip.first.c_str(), extra_msg.c_str());
+        client_ip.c_str(), extra_msg.c_str());
      auto ip_array = in_addr_to_array(client_addr_);
-     context_.block_client_host(ip_array, c_ip.first.c_str(), server_socket_);
+     context_.block_client_host(ip_array, client_ip, server_socket_);
+  }
+
+  // a session that is idle when the client quits can serve the next client
+  if (client_quit && session && session->is_idle() && !disconnect_) {
+    return_to_pool();
   }
 
   // Either client or server terminated
+  if (client_tls) {
+    client_tls->shutdown();
+  }
   context_.get_socket_operations()->shutdown(client_socket_);
-  context_.get_socket_operations()->shutdown(server_socket_);
   context_.get_socket_operations()->close(client_socket_);
-  context_.get_socket_operations()->close(server_socket_);
+  if (server_socket_ != routing::kInvalidSocket) {
+    context_.get_socket_operations()->shutdown(server_socket_);
+    context_.get_socket_operations()->close(server_socket_);
+  }
 
   context_.decrease_info_active_routes();
 #ifndef _WIN32
@@ -265,6 +499,354 @@ void MySQLRoutingConnection::run() {
 #endif
 }
 
+int MySQLRoutingConnection::handshake_in_router(std::unique_ptr<ClientTlsConnection> &client_tls,
+                                                bool *authenticated, std::string &extra_msg) {
+  // the configuration allows this for the classic protocol only
+  auto &protocol = static_cast<ClassicProtocol&>(context_.get_protocol());
+  const std::chrono::milliseconds timeout = context_.get_client_connect_timeout();
+  const std::string &name = context_.get_name();
+  *authenticated = false;
+
+  RoutingProtocolBuffer greeting;
+  if (pooled_server_) {
+    // the client may only use what the pooled session was set up with
+    server_greeting_ = pooled_server_->greeting;
+    greeting = server_greeting_;
+    ClassicProtocol::set_greeting_capabilities(greeting, pooled_server_->capabilities);
+    // never hand out the scramble of an earlier client: the server's
+    // scramble is only used after the forced auth-switch below
+    ClassicProtocol::renew_greeting_scramble(greeting);
+  } else {
+    if (!protocol.read_greeting(server_socket_, timeout, server_greeting_, name)) {
+      extra_msg = "reading server greeting failed";
+      return -1;
+    }
+    if (server_greeting_[mysql_protocol::Packet::kHeaderSize] == 0xff) {
+      // error from the server, e.g. too many connections: pass it on
+      context_.get_socket_operations()->write_all(client_socket_, server_greeting_.data(),
+                                                  server_greeting_.size());
+      return 0;
+    }
+    greeting = server_greeting_;
+  }
+
+  RoutingProtocolBuffer response;
+  if (protocol.accept_client(client_socket_, greeting, context_.get_client_tls_context(),
+                             context_.get_client_ssl_mode(), timeout, client_tls,
+                             response, name) == -1) {
+    extra_msg = "client handshake failed";
+    return -1;
+  }
+  const Flags client_capabilities = ClassicProtocol::get_response_capabilities(response);
+
+  bool change_user = false;
+  bool force_auth_switch = false;
+  if (pooled_server_) {
+    if (fits_session(client_capabilities, pooled_server_->capabilities)) {
+      log_debug("[%s] fd=%d reusing pooled server connection fd=%d",
+          name.c_str(), client_socket_, server_socket_);
+      // the client answered the router's scramble, the server has to ask
+      // again with a fresh one
+      change_user = true;
+      force_auth_switch = true;
+      session_capabilities_ = pooled_server_->capabilities;
+    } else {
+      log_debug("[%s] fd=%d pooled server connection fd=%d doesn't fit the client",
+          name.c_str(), client_socket_, server_socket_);
+      context_.get_connection_pool()->add(std::move(*pooled_server_));
+
+      // the client answered the router's scramble, the new connection has
+      // to ask again
+      force_auth_switch = true;
+      server_socket_ = connect_server_(server_address_);
+      if (server_socket_ < 0) {
+        server_socket_ = routing::kInvalidSocket;
+        protocol.send_error(client_socket_, 2003, "Can't connect to remote MySQL server",
+                            "HY000", name);
+        extra_msg = "connecting server failed";
+        return -1;
+      }
+      if (!protocol.read_greeting(server_socket_, timeout, server_greeting_, name) ||
+          server_greeting_[mysql_protocol::Packet::kHeaderSize] == 0xff) {
+        extra_msg = "reading server greeting failed";
+        return -1;
+      }
+    }
+    pooled_server_.reset();
+  }
+  if (!change_user) {
+    session_capabilities_ = client_capabilities &
+                            ClassicProtocol::get_greeting_capabilities(server_greeting_);
+  }
+
+  if (protocol.authenticate(client_socket_, client_tls.get(), server_socket_, server_greeting_,
+                            response, change_user, force_auth_switch,
+                            change_user ? session_capabilities_
+                                        : ClassicProtocol::get_greeting_capabilities(server_greeting_),
+                            timeout, authenticated, name) == -1) {
+    extra_msg = "authentication failed";
+    return -1;
+  }
+
+  return 0;
+}
+
+void MySQLRoutingConnection::return_to_pool() {
+  auto &protocol = static_cast<ClassicProtocol&>(context_.get_protocol());
+  ConnectionPool *pool = context_.get_connection_pool();
+
+  const auto start = std::chrono::steady_clock::now();
+  const bool reset = protocol.reset_session(server_socket_, context_.get_client_connect_timeout(),
+                                            context_.get_name());
+  pool->record_reset(std::chrono::steady_clock::now() - start, reset);
+  if (!reset || disconnect_) return;
+
+  log_debug("[%s] fd=%d adding server connection fd=%d to the pool",
+      context_.get_name().c_str(), client_socket_, server_socket_);
+  pool->add(PooledServerConnection{server_socket_, server_address_, server_greeting_,
+                                   session_capabilities_, std::chrono::steady_clock::now()});
+  server_socket_ = routing::kInvalidSocket;
+}
+
+int MySQLRoutingConnection::handshake_split(std::unique_ptr<ClientTlsConnection> &client_tls,
+                                            bool *split, std::string &extra_msg) {
+  // the configuration allows this for the classic protocol only
+  auto &protocol = static_cast<ClassicProtocol&>(context_.get_protocol());
+  const std::chrono::milliseconds timeout = context_.get_client_connect_timeout();
+  const std::string &name = context_.get_name();
+  *split = false;
+
+  if (!protocol.read_greeting(server_socket_, timeout, server_greeting_, name)) {
+    extra_msg = "reading server greeting failed";
+    return -1;
+  }
+  if (server_greeting_[kHeaderSize] == 0xff) {
+    // error from the server, e.g. too many connections: pass it on
+    context_.get_socket_operations()->write_all(client_socket_, server_greeting_.data(),
+                                                server_greeting_.size());
+    return 0;
+  }
+
+  RoutingProtocolBuffer response;
+  if (protocol.accept_client(client_socket_, server_greeting_, context_.get_client_tls_context(),
+                             context_.get_client_ssl_mode(), timeout, client_tls,
+                             response, name) == -1) {
+    extra_msg = "client handshake failed";
+    return -1;
+  }
+  const Flags server_capabilities = ClassicProtocol::get_greeting_capabilities(server_greeting_);
+  session_capabilities_ = ClassicProtocol::get_response_capabilities(response) & server_capabilities;
+
+  bool authenticated = false;
+  uint16_t status_flags = mysql_protocol::ServerStatus::AUTOCOMMIT;
+  if (protocol.authenticate(client_socket_, client_tls.get(), server_socket_, server_greeting_,
+                            response, false, false, server_capabilities, timeout, &authenticated,
+                            name, &status_flags) == -1) {
+    extra_msg = "authentication failed";
+    return -1;
+  }
+
+  // compressed sessions can't be followed: such clients stay with the primary
+  if (!authenticated || session_capabilities_.test(mysql_protocol::Capabilities::COMPRESS)) {
+    return 0;
+  }
+
+  try {
+    mysql_protocol::HandshakeResponsePacket parsed(response, true, server_capabilities);
+    split_user_ = parsed.get_username();
+  } catch (const std::runtime_error &) {
+    return 0;
+  }
+  // the router can only log accounts whose password it has into secondaries
+  if (context_.get_read_write_split_password(split_user_) == nullptr) {
+    log_debug("[%s] fd=%d reads of user '%s' are not split",
+        name.c_str(), client_socket_, split_user_.c_str());
+    return 0;
+  }
+
+  client_response_ = std::move(response);
+  split_session_.reset(new SplitSession(status_flags, kReadOnlyRetryInterval));
+  *split = true;
+
+  return 0;
+}
+
+int MySQLRoutingConnection::run_split_session(ClientTlsConnection *client_tls, bool *client_quit,
+                                              std::size_t &bytes_up, std::size_t &bytes_down,
+                                              std::string &extra_msg) {
+  auto &protocol = static_cast<ClassicProtocol&>(context_.get_protocol());
+  mysql_harness::SocketOperationsBase *so = context_.get_socket_operations();
+  const std::string &name = context_.get_name();
+  std::shared_ptr<void> exit_guard(nullptr, [this](void*) { end_split(); });
+
+  RoutingProtocolBuffer command;
+  while (!disconnect_) {
+    if (read_only_not_allowed_.exchange(false)) close_read_only();
+
+    if (client_tls == nullptr || client_tls->pending() == 0) {
+      struct pollfd fds[] = {
+        { client_socket_, POLLIN, 0 },
+        { server_socket_, POLLIN, 0 },
+      };
+      const int res = so->poll(fds, 2, std::chrono::milliseconds(1000));
+      if (res < 0) {
+        const int last_errno = so->get_errno();
+        if (last_errno == EINTR || last_errno == EAGAIN) continue;
+        extra_msg = std::string("poll() failed: " + mysqlrouter::to_string(get_message_error(last_errno)));
+        return -1;
+      }
+      if (fds[1].revents & (POLLIN|POLLHUP)) {
+        // the idle primary talks only if it closes the session, relay that
+        return 0;
+      }
+      if (!(fds[0].revents & (POLLIN|POLLHUP))) continue;
+    }
+
+    if (!protocol.read_command(client_socket_, client_tls, context_.get_client_connect_timeout(),
+                               command)) {
+      const int last_errno = so->get_errno();
+      if (last_errno > 0) {
+        extra_msg = std::string("Copy client->server failed: " + mysqlrouter::to_string(get_message_error(last_errno)));
+      }
+      return -1;
+    }
+    bytes_down += command.size();
+
+    const size_t payload_size = command.size() - kHeaderSize;
+    const uint8_t cmd = payload_size > 0 ? command[kHeaderSize] : 0;
+    if (payload_size == 1 && cmd == mysql_protocol::Command::QUIT) {
+      so->write_all(server_socket_, command.data(), command.size());
+      if (read_only_socket_ != routing::kInvalidSocket) {
+        so->write_all(read_only_socket_, command.data(), command.size());
+      }
+      *client_quit = true;
+      return 0;
+    }
+
+    // commands continued in further packets and all but queries and pings
+    // are left to the primary for the rest of the session
+    routing::StatementKind kind = routing::StatementKind::kSessionState;
+    if (payload_size == 0 || payload_size == 0xffffff) {
+      kind = routing::StatementKind::kSessionState;
+    } else if (cmd == mysql_protocol::Command::QUERY) {
+      kind = routing::classify_statement(std::string(command.begin() + kHeaderSize + 1, command.end()));
+    } else if (cmd == mysql_protocol::Command::PING) {
+      kind = routing::StatementKind::kReadWrite;
+    }
+
+    if (kind == routing::StatementKind::kSessionState) {
+      log_debug("[%s] fd=%d session pinned to the primary", name.c_str(), client_socket_);
+      if (so->write_all(server_socket_, command.data(), command.size()) < 0) {
+        extra_msg = std::string("Copy client->server failed: " + mysqlrouter::to_string(get_message_error(so->get_errno())));
+        return -1;
+      }
+      return 0;
+    }
+
+    const int server = split_session_->is_for_read_only(kind) && connect_read_only()
+                           ? read_only_socket_ : server_socket_;
+
+    uint16_t status_flags = split_session_->status_flags();
+    size_t bytes_relayed = 0;
+    if (protocol.relay_command(client_socket_, client_tls, server, command, session_capabilities_,
+                               kNoTimeout, &status_flags, &bytes_relayed, name) == -1) {
+      extra_msg = server == server_socket_ ? "relaying command to primary failed"
+                                           : "relaying command to secondary failed";
+      return -1;
+    }
+    bytes_up += bytes_relayed;
+    if (server == server_socket_) split_session_->executed_on_primary(kind, status_flags);
+  }
+
+  return 0;
+}
+
+bool MySQLRoutingConnection::connect_read_only() {
+  auto &protocol = static_cast<ClassicProtocol&>(context_.get_protocol());
+  mysql_harness::SocketOperationsBase *so = context_.get_socket_operations();
+  const std::string &name = context_.get_name();
+
+  if (read_only_socket_ != routing::kInvalidSocket) {
+    // the idle secondary talks only if it closes the session
+    struct pollfd fds[] = {
+      { read_only_socket_, POLLIN, 0 },
+    };
+    if (so->poll(fds, 1, std::chrono::milliseconds::zero()) == 0) return true;
+
+    close_read_only();
+  }
+  const auto now = SplitSession::clock::now();
+  if (!split_session_->may_connect_read_only(now)) return false;
+
+  mysql_harness::TCPAddress address;
+  const int fd = connect_read_only_(&address);
+  if (fd < 0) {
+    log_debug("[%s] fd=%d no secondary available, reads go to the primary",
+        name.c_str(), client_socket_);
+    split_session_->read_only_failed(now);
+    return false;
+  }
+
+  // the secondary has to use the protocol the client set up with the primary
+  const std::chrono::milliseconds timeout = context_.get_client_connect_timeout();
+  RoutingProtocolBuffer greeting;
+  RoutingProtocolBuffer reply;
+  const std::string *password = context_.get_read_write_split_password(split_user_);
+  const bool logged_in =
+      password != nullptr &&
+      protocol.read_greeting(fd, timeout, greeting, name) && greeting[kHeaderSize] != 0xff &&
+      fits_session(ClassicProtocol::get_response_capabilities(client_response_) &
+                       ClassicProtocol::get_greeting_capabilities(greeting),
+                   session_capabilities_) &&
+      protocol.login(fd, greeting, client_response_, *password, timeout, reply, name) == 0 &&
+      reply[kHeaderSize] == 0x00;
+  if (!logged_in) {
+    log_warning("[%s] fd=%d logging into secondary %s failed, reads go to the primary",
+        name.c_str(), client_socket_, address.str().c_str());
+    so->shutdown(fd);
+    so->close(fd);
+    split_session_->read_only_failed(now);
+    return false;
+  }
+
+  log_debug("[%s] fd=%d reads go to %s as fd=%d",
+      name.c_str(), client_socket_, address.str().c_str(), fd);
+  {
+    std::lock_guard<std::mutex> lock(read_only_mutex_);
+    read_only_address_ = address;
+  }
+  read_only_socket_ = fd;
+
+  return true;
+}
+
+void MySQLRoutingConnection::close_read_only() {
+  if (read_only_socket_ == routing::kInvalidSocket) return;
+
+  context_.get_socket_operations()->shutdown(read_only_socket_);
+  context_.get_socket_operations()->close(read_only_socket_);
+  read_only_socket_ = routing::kInvalidSocket;
+
+  std::lock_guard<std::mutex> lock(read_only_mutex_);
+  read_only_address_ = mysql_harness::TCPAddress();
+}
+
+void MySQLRoutingConnection::end_split() {
+  close_read_only();
+  client_response_.clear();
+  split_session_.reset();
+}
+
+void MySQLRoutingConnection::drop_read_only_if_not_allowed(const AllowedNodes& nodes) {
+  std::lock_guard<std::mutex> lock(read_only_mutex_);
+  if (read_only_address_.port == 0) return;
+  if (std::find(nodes.begin(), nodes.end(), read_only_address_) == nodes.end()) {
+    log_info("Closing session of client %s with secondary %s",
+        client_address_.c_str(), read_only_address_.str().c_str());
+    read_only_not_allowed_ = true;
+  }
+}
+
 void MySQLRoutingConnection::disconnect() noexcept {
   disconnect_ = true;
 }
@@ -277,15 +859,14 @@ const std::string& MySQLRoutingConnection::get_client_address() const {
   return client_address_;
 }
 
-std::string MySQLRoutingConnection::make_client_address(int client_socket, const MySQLRoutingContext& context) {
-  std::pair<std::string, int> c_ip = get_peer_name(client_socket);
+std::string MySQLRoutingConnection::make_client_address(const sockaddr_storage& client_addr, const MySQLRoutingContext& context) {
+  // the address returned by accept() saves asking the socket again
+  std::pair<std::string, int> c_ip = get_peer_name(client_addr);
 
   if (c_ip.second == 0) {
     // Unix socket/Windows Named pipe
     return context.get_bind_named_socket().c_str();
   } else {
-    std::ostringstream oss;
-    oss << c_ip.first.c_str() << ":" << c_ip.second;
-    return oss.str();
+    return c_ip.first + ":" + std::to_string(c_ip.second);
   }
 }
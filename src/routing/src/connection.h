@@ -28,14 +28,19 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <functional>
+#include <memory>
 #include <mutex>
 
+#include "connection_pool.h"
 #include "context.h"
 #include "mysql_router_thread.h"
 #include "protocol/base_protocol.h"
+#include "split_session.h"
 #include "tcp_address.h"
 
 
+class ClientTlsConnection;
 class MySQLRouting;
 class MySQLRoutingContext;
 
@@ -75,6 +80,32 @@ public:
       const mysql_harness::TCPAddress& server_address,
       std::function<void(MySQLRoutingConnection*)> remove_callback);
 
+  /**
+   * @brief Serves the client by a server connection taken from the pool.
+   *
+   * Must be called before start(); server_socket passed to the constructor
+   * is the socket of the pooled connection.
+   *
+   * @param pooled the pooled connection
+   * @param connect_server connects the same server if the client can't use
+   *        the pooled session; returns the socket or a negative value
+   */
+  void set_pooled_server(PooledServerConnection pooled,
+      std::function<int(const mysql_harness::TCPAddress&)> connect_server);
+
+  /**
+   * @brief Splits reads and writes of the client's session.
+   *
+   * Must be called before start(); server_socket passed to the constructor
+   * is the primary, which gets all statements but plain reads outside of
+   * transactions. Only sessions of the accounts set with
+   * MySQLRoutingContext::set_read_write_split_credentials() are split.
+   *
+   * @param connect_read_only connects a secondary and stores its address;
+   *        returns the socket or a negative value
+   */
+  void set_read_only_server(std::function<int(mysql_harness::TCPAddress*)> connect_read_only);
+
   /**
    * @brief Verify if client socket and server socket are valid.
    *
@@ -112,6 +143,16 @@ public:
    */
   const mysql_harness::TCPAddress& get_server_address() const noexcept;
 
+  /**
+   * @brief Closes the session with the secondary if it is no longer allowed.
+   *
+   * The session continues with the primary; the connection thread closes
+   * the secondary before it routes the next statement.
+   *
+   * @param nodes allowed servers
+   */
+  void drop_read_only_if_not_allowed(const AllowedNodes& nodes);
+
   /**
    * @brief Returns address of client which connected to router
    *
@@ -121,6 +162,74 @@ public:
 
 private:
 
+  /** @brief Runs the handshake in the router
+   *
+   * Used if server connections are pooled or SSL is disabled for clients.
+   * The client is authenticated on the pooled connection if there is one
+   * and the client's capabilities match its session.
+   *
+   * @param client_tls [out] TLS connection to the client, if any
+   * @param authenticated [out] true if the server accepted the client
+   * @param extra_msg [out] reason of a failure
+   *
+   * @return 0 on success; -1 on error
+   */
+  int handshake_in_router(std::unique_ptr<ClientTlsConnection> &client_tls,
+                          bool *authenticated, std::string &extra_msg);
+
+  /** @brief Resets the session and adds the server connection to the pool */
+  void return_to_pool();
+
+  /** @brief Runs the handshake of a session with reads and writes split
+   *
+   * The client is authenticated on the primary. Its reads are split if it
+   * logged in with one of the configured accounts and doesn't use
+   * compression.
+   *
+   * @param client_tls [out] TLS connection to the client, if any
+   * @param split [out] true if the client is logged in and reads can be
+   *              sent to secondaries
+   * @param extra_msg [out] reason of a failure
+   *
+   * @return 0 on success; -1 on error
+   */
+  int handshake_split(std::unique_ptr<ClientTlsConnection> &client_tls,
+                      bool *split, std::string &extra_msg);
+
+  /** @brief Routes the commands of the client one by one
+   *
+   * Plain reads outside of transactions go to a secondary, everything else
+   * to the primary. Returns when the client quits or the session depends on
+   * state only the primary has; the caller then relays the rest of the
+   * session with the primary.
+   *
+   * @param client_tls TLS connection to the client or nullptr
+   * @param client_quit [out] true if the client sent COM_QUIT
+   * @param bytes_up [in,out] bytes sent to the client
+   * @param bytes_down [in,out] bytes received from the client
+   * @param extra_msg [out] reason of a failure
+   *
+   * @return 0 on success; -1 on error
+   */
+  int run_split_session(ClientTlsConnection *client_tls, bool *client_quit,
+                        std::size_t &bytes_up, std::size_t &bytes_down,
+                        std::string &extra_msg);
+
+  /** @brief Connects and logs into a secondary unless there is a session with one
+   *
+   * Logs in with the configured password of the account. If that fails,
+   * reads go to the primary until the retry interval passed.
+   *
+   * @return false if reads have to go to the primary
+   */
+  bool connect_read_only();
+
+  /** @brief Closes the connection to the secondary */
+  void close_read_only();
+
+  /** @brief Closes the connection to the secondary and forgets the session */
+  void end_split();
+
   /** @brief wrapper for common data used by all routing threads */
   MySQLRoutingContext& context_;
   /** @brief callback that is called when thread of execution completes */
@@ -132,6 +241,29 @@ private:
   /** @brief socket used to communicate with server */
   int server_socket_;
   mysql_harness::TCPAddress server_address_;
+  /** @brief pooled server connection the client starts with, if any */
+  std::unique_ptr<PooledServerConnection> pooled_server_;
+  /** @brief connects server_address_ again if pooled_server_ doesn't fit */
+  std::function<int(const mysql_harness::TCPAddress&)> connect_server_;
+  /** @brief greeting of the server connection, kept for pooling */
+  RoutingProtocolBuffer server_greeting_;
+  /** @brief capabilities of the session with the server */
+  mysql_protocol::Capabilities::Flags session_capabilities_;
+  /** @brief connects a secondary if reads and writes are split */
+  std::function<int(mysql_harness::TCPAddress*)> connect_read_only_;
+  /** @brief socket of the session with a secondary, if any */
+  int read_only_socket_{routing::kInvalidSocket};
+  /** @brief address of the secondary, guarded by read_only_mutex_ */
+  mysql_harness::TCPAddress read_only_address_;
+  std::mutex read_only_mutex_;
+  /** @brief set if the secondary left the allowed nodes */
+  std::atomic<bool> read_only_not_allowed_{false};
+  /** @brief handshake response of the client, to log into a secondary */
+  RoutingProtocolBuffer client_response_;
+  /** @brief account of the client, whose configured password logs into secondaries */
+  std::string split_user_;
+  /** @brief where statements of the split session go */
+  std::unique_ptr<SplitSession> split_session_;
   /** @brief true if connection should be disconnected */
   std::atomic<bool> disconnect_{false};
   /** @brief address of the client */
@@ -139,7 +271,7 @@ private:
   /** @brief run client thread which will service this new connection */
   static void* run_thread(void* context);
   /** @brief make address of client */
-  static std::string make_client_address(int client_socket, const MySQLRoutingContext& context);
+  static std::string make_client_address(const sockaddr_storage& client_addr, const MySQLRoutingContext& context);
 };
 
 #endif /* ROUTING_CONNECTION_INCLUDED */
@@ -44,6 +44,8 @@ void ConnectionContainer::disconnect(const AllowedNodes& nodes) {
       log_info("Disconnecting client %s from server %s", client_address.c_str(), server_address.str().c_str());
       connection.first->disconnect();
       ++number_of_disconnected_connections;
+    } else {
+      connection.first->drop_read_only_if_not_allowed(nodes);
     }
   };
 
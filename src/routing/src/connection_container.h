@@ -172,7 +172,7 @@ public:
    * @brief Disconnects all connections to servers that are not allowed any longer.
    *
    * @param nodes Allowed servers. Connections to servers that are not in nodes
-   *        are closed.
+   *        are closed, as are sessions with secondaries of split connections.
    */
   void disconnect(const AllowedNodes& nodes);
 
@@ -0,0 +1,147 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "connection_pool.h"
+#include "mysql/harness/logging/logging.h"
+#include "mysqlrouter/routing.h"
+#include "socket_operations.h"
+
+#include <algorithm>
+
+IMPORT_LOG_FUNCTIONS()
+
+ConnectionPool::ConnectionPool(mysql_harness::SocketOperationsBase *socket_operations,
+                               size_t max_idle, std::chrono::milliseconds idle_timeout)
+    : socket_operations_(socket_operations),
+      max_idle_(max_idle),
+      idle_timeout_(idle_timeout) {}
+
+ConnectionPool::~ConnectionPool() {
+  for (const auto &connection : idle_) {
+    close(connection);
+  }
+  for (const auto &connection : reserved_) {
+    close(connection.second);
+  }
+}
+
+int ConnectionPool::reserve(const mysql_harness::TCPAddress &address) {
+  const auto now = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = idle_.size(); i-- > 0;) {
+    if (!(idle_[i].address == address)) continue;
+
+    PooledServerConnection connection = std::move(idle_[i]);
+    idle_.erase(idle_.begin() + static_cast<std::ptrdiff_t>(i));
+
+    if (is_usable(connection, now)) {
+      ++stats_.reused;
+      const int fd = connection.fd;
+      reserved_[fd] = std::move(connection);
+      return fd;
+    }
+    ++stats_.expired;
+    close(connection);
+  }
+
+  return -1;
+}
+
+bool ConnectionPool::take_reserved(int fd, PooledServerConnection &connection) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = reserved_.find(fd);
+  if (it == reserved_.end()) return false;
+
+  connection = std::move(it->second);
+  reserved_.erase(it);
+  return true;
+}
+
+void ConnectionPool::add(PooledServerConnection connection) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (max_idle_ == 0) {
+    close(connection);
+    return;
+  }
+  while (idle_.size() >= max_idle_) {
+    close(idle_.front());
+    idle_.pop_front();
+  }
+  idle_.push_back(std::move(connection));
+  ++stats_.added;
+}
+
+void ConnectionPool::remove_not_allowed(const AllowedNodes &nodes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto not_allowed = [&nodes](const PooledServerConnection &connection) {
+    return std::find(nodes.begin(), nodes.end(), connection.address) == nodes.end();
+  };
+  const auto it = std::stable_partition(idle_.begin(), idle_.end(),
+      [&not_allowed](const PooledServerConnection &connection) {
+        return !not_allowed(connection);
+      });
+  for (auto removed = it; removed != idle_.end(); ++removed) {
+    log_debug("Closing idle connection to server %s", removed->address.str().c_str());
+    close(*removed);
+  }
+  idle_.erase(it, idle_.end());
+}
+
+void ConnectionPool::record_reset(std::chrono::steady_clock::duration duration, bool ok) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.resets;
+  if (!ok) ++stats_.reset_failures;
+  stats_.reset_time += std::chrono::duration_cast<std::chrono::microseconds>(duration);
+}
+
+void ConnectionPool::record_miss() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.misses;
+}
+
+ConnectionPool::Stats ConnectionPool::get_stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.idle = idle_.size();
+  stats.max_idle = max_idle_;
+  return stats;
+}
+
+bool ConnectionPool::is_usable(const PooledServerConnection &connection,
+                               std::chrono::steady_clock::time_point now) {
+  if (now - connection.idle_since >= idle_timeout_) return false;
+
+  // an idle server connection only becomes readable if the server closed it
+  // (wait_timeout, shutdown) or sent an error before doing so
+  struct pollfd fds[] = {
+    { connection.fd, POLLIN, 0 },
+  };
+  return socket_operations_->poll(fds, 1, std::chrono::milliseconds::zero()) == 0;
+}
+
+void ConnectionPool::close(const PooledServerConnection &connection) {
+  socket_operations_->shutdown(connection.fd);
+  socket_operations_->close(connection.fd);
+}
@@ -0,0 +1,169 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef ROUTING_CONNECTION_POOL_INCLUDED
+#define ROUTING_CONNECTION_POOL_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+
+#include "destination.h"
+#include "mysqlrouter/mysql_protocol.h"
+#include "protocol/base_protocol.h"
+#include "tcp_address.h"
+
+namespace mysql_harness { class SocketOperationsBase; }
+
+/**
+ * @brief Authenticated server connection waiting for its next client
+ */
+struct PooledServerConnection {
+  /** @brief socket connected to the server */
+  int fd;
+  /** @brief address of the server */
+  mysql_harness::TCPAddress address;
+  /** @brief greeting the server sent when the connection was opened */
+  RoutingProtocolBuffer greeting;
+  /** @brief capabilities the session was established with */
+  mysql_protocol::Capabilities::Flags capabilities;
+  /** @brief time the connection was returned to the pool */
+  std::chrono::steady_clock::time_point idle_since;
+};
+
+/**
+ * @brief Pool of idle server connections of a route
+ *
+ * When a client quits, the router resets the session of its server connection
+ * and keeps the connection here instead of closing it. The next client is then
+ * authenticated on it with COM_CHANGE_USER, which saves the TCP connect and
+ * the server side setup of a new connection.
+ *
+ * The destination of a route picks the server of a new client as usual, with
+ * its routing strategy and quarantine, and takes an idle connection to that
+ * server if there is one (reserve()). Connections are handed out last in,
+ * first out. Connections idling longer than the idle timeout are closed when
+ * they are found in the pool.
+ */
+class ConnectionPool {
+ public:
+  /** @brief Pool usage counters */
+  struct Stats {
+    size_t idle;
+    size_t max_idle;
+    uint64_t reused;
+    uint64_t misses;
+    uint64_t added;
+    uint64_t expired;
+    uint64_t resets;
+    uint64_t reset_failures;
+    std::chrono::microseconds reset_time;
+  };
+
+  /**
+   * @param socket_operations used to check and close the connections
+   * @param max_idle maximum number of idle connections kept
+   * @param idle_timeout time after which idle connections are closed
+   */
+  ConnectionPool(mysql_harness::SocketOperationsBase *socket_operations,
+                 size_t max_idle, std::chrono::milliseconds idle_timeout);
+
+  /** @brief Closes all idle connections */
+  ~ConnectionPool();
+
+  ConnectionPool(const ConnectionPool&) = delete;
+  ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+  /** @brief Reserves an idle connection to a server
+   *
+   * The connection is taken out of the idle connections; the caller gets
+   * it with take_reserved(). Expired connections and connections closed by
+   * the server are closed on the way.
+   *
+   * @param address the server
+   * @return socket of the connection; -1 if there is no idle connection to
+   *         the server
+   */
+  int reserve(const mysql_harness::TCPAddress &address);
+
+  /** @brief Takes a connection reserved by reserve()
+   *
+   * @param fd socket returned by reserve()
+   * @param connection [out] the connection
+   * @return true if fd is a reserved connection; false if it isn't pooled
+   */
+  bool take_reserved(int fd, PooledServerConnection &connection);
+
+  /** @brief Puts an idle connection into the pool
+   *
+   * If the pool is full, the connection idling the longest is closed.
+   *
+   * @param connection the connection; its session must be reset
+   */
+  void add(PooledServerConnection connection);
+
+  /** @brief Closes idle connections to servers which are not in nodes */
+  void remove_not_allowed(const AllowedNodes &nodes);
+
+  /** @brief Accounts a session reset done before adding a connection
+   *
+   * @param duration time the reset took
+   * @param ok true if the session was reset
+   */
+  void record_reset(std::chrono::steady_clock::duration duration, bool ok);
+
+  /** @brief Accounts a client that needed a new server connection */
+  void record_miss();
+
+  Stats get_stats() const;
+
+  size_t get_max_idle() const {
+    return max_idle_;
+  }
+
+  std::chrono::milliseconds get_idle_timeout() const {
+    return idle_timeout_;
+  }
+
+ private:
+  bool is_usable(const PooledServerConnection &connection,
+                 std::chrono::steady_clock::time_point now);
+  void close(const PooledServerConnection &connection);
+
+  mysql_harness::SocketOperationsBase *socket_operations_;
+  const size_t max_idle_;
+  const std::chrono::milliseconds idle_timeout_;
+
+  mutable std::mutex mutex_;
+  /** @brief idle connections, most recently added at the back */
+  std::deque<PooledServerConnection> idle_;
+  /** @brief connections handed out by reserve(), keyed by socket */
+  std::map<int, PooledServerConnection> reserved_;
+  Stats stats_{};
+};
+
+#endif /* ROUTING_CONNECTION_POOL_INCLUDED */
@@ -43,6 +43,8 @@
 #include "utils.h"
 
 class BaseProtocol;
+class ClientTlsContext;
+class ConnectionPool;
 namespace routing { class RoutingSockOpsInterface; }
 namespace mysql_harness { class SocketOperationsBase; }
 
@@ -130,6 +132,64 @@ public:
     return thread_stack_size_;
   }
 
+  /** @brief Lets the router terminate TLS of client connections
+   *
+   * @param tls_context certificate, key and session cache for the clients;
+   *                    nullptr for ClientSslMode::kDisabled
+   * @param ssl_mode ClientSslMode::kPreferred, ClientSslMode::kRequired or
+   *                 ClientSslMode::kDisabled
+   */
+  void set_client_tls(std::shared_ptr<ClientTlsContext> tls_context,
+                      routing::ClientSslMode ssl_mode) {
+    client_tls_context_ = std::move(tls_context);
+    client_ssl_mode_ = ssl_mode;
+  }
+
+  /** @brief Returns TLS context for clients or nullptr if TLS is passed
+   *         through or disabled */
+  ClientTlsContext* get_client_tls_context() const {
+    return client_tls_context_.get();
+  }
+
+  routing::ClientSslMode get_client_ssl_mode() const {
+    return client_ssl_mode_;
+  }
+
+  /** @brief true if the router runs the handshake instead of relaying it */
+  bool is_handshake_in_router() const {
+    return client_ssl_mode_ != routing::ClientSslMode::kPassthrough;
+  }
+
+  /** @brief Keeps server connections of quitting clients for reuse
+   *
+   * Requires that the router runs the handshake.
+   */
+  void set_connection_pool(std::shared_ptr<ConnectionPool> pool) {
+    connection_pool_ = std::move(pool);
+  }
+
+  /** @brief Returns pool of idle server connections or nullptr if disabled */
+  ConnectionPool* get_connection_pool() const {
+    return connection_pool_.get();
+  }
+
+  /** @brief Sets the accounts whose reads may go to secondaries
+   *
+   * @param credentials passwords by user name, used to log into secondaries
+   */
+  void set_read_write_split_credentials(std::map<std::string, std::string> credentials) {
+    read_write_split_credentials_ = std::move(credentials);
+  }
+
+  /** @brief Returns the password of an account whose reads may go to secondaries
+   *
+   * @return nullptr if reads of the user are not split
+   */
+  const std::string* get_read_write_split_password(const std::string &user) const {
+    auto it = read_write_split_credentials_.find(user);
+    return it == read_write_split_credentials_.end() ? nullptr : &it->second;
+  }
+
 private:
   /** @brief object to handle protocol specific stuff */
   std::unique_ptr<BaseProtocol> protocol_;
@@ -164,6 +224,18 @@ private:
     /** @brief memory in kilobytes allocated for thread's stack */
   size_t thread_stack_size_ = mysql_harness::kDefaultStackSizeInKiloBytes;
 
+  /** @brief TLS settings if the router terminates client TLS */
+  std::shared_ptr<ClientTlsContext> client_tls_context_;
+
+  /** @brief How client connections asking for SSL are handled */
+  routing::ClientSslMode client_ssl_mode_ = routing::ClientSslMode::kPassthrough;
+
+  /** @brief idle server connections if connection pooling is enabled */
+  std::shared_ptr<ConnectionPool> connection_pool_;
+
+  /** @brief passwords of the accounts whose reads may go to secondaries */
+  std::map<std::string, std::string> read_write_split_credentials_;
+
   mutable std::mutex mutex_conn_errors_;
 
 public:
@@ -45,7 +45,7 @@ int DestFirstAvailable::get_server_socket(std::chrono::milliseconds connect_time
     auto addr = destinations_.at(current_pos_);
     log_debug("Trying server %s (index %lu)", addr.str().c_str(),
               static_cast<long unsigned>(i)); // 32bit Linux requires cast
-    auto sock = get_mysql_socket(addr, connect_timeout);
+    auto sock = get_pooled_or_new_socket(addr, connect_timeout);
     if (sock >= 0) {
       if (address) *address = addr;
       return sock;
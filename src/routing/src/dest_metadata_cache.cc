@@ -27,7 +27,10 @@
 #include "mysqlrouter/routing.h"
 
 #include <algorithm>
+#include <cctype>
+#include <cerrno>
 #include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <set>
 #ifndef _WIN32
@@ -56,7 +59,8 @@ static const int kPrimaryFailoverTimeout = 10;
 
 static const std::set<std::string> supported_params{"role", "allow_primary_reads",
                                                     "disconnect_on_promoted_to_primary",
-                                                    "disconnect_on_metadata_unavailable"};
+                                                    "disconnect_on_metadata_unavailable",
+                                                    "max_transactions_behind"};
 
 namespace {
 
@@ -114,8 +118,11 @@ bool mode_is_valid(const routing::AccessMode mode, const DestMetadataCacheGroup:
    case DestMetadataCacheGroup::ServerRole::Primary:
     return mode == routing::AccessMode::kReadWrite;
    case DestMetadataCacheGroup::ServerRole::Secondary:
-   case DestMetadataCacheGroup::ServerRole::PrimaryAndSecondary:
     return mode == routing::AccessMode::kReadOnly;
+   case DestMetadataCacheGroup::ServerRole::PrimaryAndSecondary:
+    // splitting needs both, primaries for writes and secondaries for reads
+    return mode == routing::AccessMode::kReadOnly ||
+           mode == routing::AccessMode::kReadWriteSplit;
    default:; //
     /* fall-through, no acces mode is valid for that role */
   }
@@ -168,6 +175,30 @@ bool get_disconnect_on_metadata_unavailable(const mysqlrouter::URIQuery &uri) {
   return get_yes_no_option(uri, kOptionName, /*default=*/ false, check_option_allowed);
 }
 
+// throws runtime_error if the parameter has wrong value or is not allowed for given configuration
+uint64_t get_max_transactions_behind(const mysqlrouter::URIQuery &uri,
+                                     const DestMetadataCacheGroup::ServerRole& role) {
+  const std::string kOptionName = "max_transactions_behind";
+  auto option = uri.find(kOptionName);
+  if (option == uri.end())
+    return 0;  // no limit
+
+  if (role == DestMetadataCacheGroup::ServerRole::Primary) {
+    throw std::runtime_error("Option '" + kOptionName + "' is not valid for role=PRIMARY");
+  }
+
+  const std::string &value = option->second;
+  char *rest = nullptr;
+  errno = 0;
+  const unsigned long long result = std::strtoull(value.c_str(), &rest, 10);
+  if (value.empty() || !isdigit(value[0]) || *rest != '\0' || errno != 0 || result == 0) {
+    throw std::runtime_error("Invalid value for option '" + kOptionName + "': '" + value +
+                             "'. Allowed are positive integers");
+  }
+
+  return result;
+}
+
 } // namespace {
 
 
@@ -192,13 +223,15 @@ DestMetadataCacheGroup::DestMetadataCacheGroup(const std::string &metadata_cache
     server_role_(get_server_role_from_uri(query)),
     cache_api_(cache_api),
     disconnect_on_promoted_to_primary_(get_disconnect_on_promoted_to_primary(query, server_role_)),
-    disconnect_on_metadata_unavailable_(get_disconnect_on_metadata_unavailable(query)) {
+    disconnect_on_metadata_unavailable_(get_disconnect_on_metadata_unavailable(query)),
+    max_transactions_behind_(get_max_transactions_behind(query, server_role_)) {
 
   init();
 }
 #endif
 
 DestMetadataCacheGroup::AvailableDestinations DestMetadataCacheGroup::get_available(const metadata_cache::LookupResult& managed_servers,
+                                                                                    ServerRole role,
                                                                                     bool for_new_connections) {
   // TODO: this is a workaround. We should do it in the init() but currently
   // there is no way to check if metadata_cache is initialized so we postpone it to
@@ -207,14 +240,22 @@ DestMetadataCacheGroup::AvailableDestinations DestMetadataCacheGroup::get_availa
 
   DestMetadataCacheGroup::AvailableDestinations result;
 
+  // secondaries too far behind the primary are only used for new connections
+  // if there is nothing else, existing connections to them are kept
+  auto is_lagging = [this, for_new_connections](const metadata_cache::ManagedInstance& i) {
+    return for_new_connections && max_transactions_behind_ > 0 &&
+           i.mode == metadata_cache::ServerMode::ReadOnly &&
+           i.transactions_behind > max_transactions_behind_;
+  };
+
   bool primary_fallback{false};
   const auto& managed_servers_vec = managed_servers.instance_vector;
   if (routing_strategy_ == routing::RoutingStrategy::kRoundRobinWithFallback) {
     // if there are no secondaries available we fall-back to primaries
     auto secondary = std::find_if(managed_servers_vec.begin(), managed_servers_vec.end(),
-            [](const metadata_cache::ManagedInstance& i)
+            [&is_lagging](const metadata_cache::ManagedInstance& i)
             {
-              return i.mode == metadata_cache::ServerMode::ReadOnly;
+              return i.mode == metadata_cache::ServerMode::ReadOnly && !is_lagging(i);
             });
 
     primary_fallback = secondary == managed_servers_vec.end();
@@ -223,18 +264,26 @@ DestMetadataCacheGroup::AvailableDestinations DestMetadataCacheGroup::get_availa
   // if we are gathering the nodes for the decision about keeping existing connections
   // we look also at the disconnect_on_promoted_to_primary_ setting
   // if set to 'no' we need to allow primaries for role=SECONDARY
-  if (!for_new_connections && server_role_ == ServerRole::Secondary && !disconnect_on_promoted_to_primary_) {
+  if (!for_new_connections && role == ServerRole::Secondary && !disconnect_on_promoted_to_primary_) {
     primary_fallback = true;
   }
 
+  DestMetadataCacheGroup::AvailableDestinations lagging;
+
   for (const auto &it: managed_servers_vec) {
     if (!(it.role == "HA")) {
       continue;
     }
     auto port = (protocol_ == Protocol::Type::kXProtocol) ? static_cast<uint16_t>(it.xport) : static_cast<uint16_t>(it.port);
 
+    if (role != ServerRole::Primary && is_lagging(it)) {
+      lagging.address.push_back(mysql_harness::TCPAddress(it.host, port));
+      lagging.id.push_back(it.mysql_server_uuid);
+      continue;
+    }
+
     // role=PRIMARY_AND_SECONDARY
-    if ((server_role_ == ServerRole::PrimaryAndSecondary) &&
+    if ((role == ServerRole::PrimaryAndSecondary) &&
         (it.mode == metadata_cache::ServerMode::ReadWrite || it.mode == metadata_cache::ServerMode::ReadOnly)) {
       result.address.push_back(mysql_harness::TCPAddress(it.host, port));
       result.id.push_back(it.mysql_server_uuid);
@@ -242,14 +291,14 @@ DestMetadataCacheGroup::AvailableDestinations DestMetadataCacheGroup::get_availa
     }
 
     // role=SECONDARY
-    if (server_role_ == ServerRole::Secondary && it.mode == metadata_cache::ServerMode::ReadOnly) {
+    if (role == ServerRole::Secondary && it.mode == metadata_cache::ServerMode::ReadOnly) {
       result.address.push_back(mysql_harness::TCPAddress(it.host, port));
       result.id.push_back(it.mysql_server_uuid);
       continue;
     }
 
     // role=PRIMARY
-    if ((server_role_ == ServerRole::Primary || primary_fallback)
+    if ((role == ServerRole::Primary || primary_fallback)
          && it.mode == metadata_cache::ServerMode::ReadWrite) {
       result.address.push_back(mysql_harness::TCPAddress(it.host, port));
       result.id.push_back(it.mysql_server_uuid);
@@ -257,6 +306,13 @@ DestMetadataCacheGroup::AvailableDestinations DestMetadataCacheGroup::get_availa
     }
   }
 
+  // a stale read is still better than none
+  if (result.address.empty() && !lagging.address.empty()) {
+    log_debug("All secondaries are more than %llu transactions behind, using them anyway",
+              static_cast<unsigned long long>(max_transactions_behind_));
+    return lagging;
+  }
+
   return result;
 }
 
@@ -282,8 +338,8 @@ void DestMetadataCacheGroup::init() {
   }
 
   // check that mode (if present) is correct for the role
-  // we don't actually use it but support it for backward compatibility
-  // and parity with STANDALONE routing destinations
+  // apart from read-write-split we don't actually use it but support it for
+  // backward compatibility and parity with STANDALONE routing destinations
   if (!mode_is_valid(access_mode_, server_role_)) {
     throw std::runtime_error("mode '" + routing::get_access_mode_name(access_mode_) +
                              "' is not valid for 'role=" + get_server_role_name(server_role_) + "'");
@@ -345,24 +401,25 @@ DestMetadataCacheGroup::~DestMetadataCacheGroup() {
 }
 
 size_t DestMetadataCacheGroup::get_next_server(
-    const DestMetadataCacheGroup::AvailableDestinations& available) {
+    const DestMetadataCacheGroup::AvailableDestinations& available,
+    size_t &current_pos) {
   std::lock_guard<std::mutex> lock(mutex_update_);
   size_t result = 0;
 
   switch (routing_strategy_) {
   case routing::RoutingStrategy::kFirstAvailable:
-    result = current_pos_;
+    result = current_pos;
     break;
   case routing::RoutingStrategy::kRoundRobin:
   case routing::RoutingStrategy::kRoundRobinWithFallback:
-    result = current_pos_;
+    result = current_pos;
     if (result >= available.address.size()) {
       result = 0;
-      current_pos_ = 0;
+      current_pos = 0;
     }
-    ++current_pos_;
-    if (current_pos_ >= available.address.size()) {
-      current_pos_ = 0;
+    ++current_pos;
+    if (current_pos >= available.address.size()) {
+      current_pos = 0;
     }
     break;
   default:
@@ -376,24 +433,49 @@ size_t DestMetadataCacheGroup::get_next_server(
 
 int DestMetadataCacheGroup::get_server_socket(std::chrono::milliseconds connect_timeout, int *error,
                                               mysql_harness::TCPAddress *address) noexcept {
+  // when splitting, the session is opened on the primary and reads are
+  // sent to connections made by get_read_only_server_socket()
+  const ServerRole role = access_mode_ == routing::AccessMode::kReadWriteSplit ?
+      ServerRole::Primary : server_role_;
+
+  return connect_next_server(role, connect_timeout, error, address);
+}
+
+int DestMetadataCacheGroup::get_read_only_server_socket(std::chrono::milliseconds connect_timeout, int *error,
+                                                        mysql_harness::TCPAddress *address) noexcept {
+  if (access_mode_ != routing::AccessMode::kReadWriteSplit) {
+    *error = 0;
+    return -1;
+  }
+
+  return connect_next_server(ServerRole::Secondary, connect_timeout, error, address);
+}
+
+int DestMetadataCacheGroup::connect_next_server(ServerRole role,
+                                                std::chrono::milliseconds connect_timeout, int *error,
+                                                mysql_harness::TCPAddress *address) noexcept {
+  size_t &current_pos = (access_mode_ == routing::AccessMode::kReadWriteSplit &&
+                         role == ServerRole::Secondary) ? current_read_only_pos_ : current_pos_;
+
   while (true) {
     try {
-      auto available = get_available(cache_api_->lookup_replicaset(ha_replicaset_).instance_vector);
+      auto available = get_available(cache_api_->lookup_replicaset(ha_replicaset_).instance_vector,
+                                     role, /*for_new_connections=*/ true);
       if (available.address.empty()) {
         log_warning("No available servers found for '%s' %s routing",
             ha_replicaset_.c_str(),
-            server_role_ == ServerRole::Primary ? "primary" : "secondary");
+            role == ServerRole::Primary ? "primary" : "secondary");
         return -1;
       }
 
-      size_t next_up = get_next_server(available);
-      int fd = get_mysql_socket(available.address.at(next_up), connect_timeout);
+      size_t next_up = get_next_server(available, current_pos);
+      int fd = get_pooled_or_new_socket(available.address.at(next_up), connect_timeout);
       if (fd < 0) {
         // Signal that we can't connect to the instance
         cache_api_->mark_instance_reachability(available.id.at(next_up),
             metadata_cache::InstanceStatus::Unreachable);
         // if we're looking for a primary member, wait for there to be at least one
-        if (server_role_ == ServerRole::Primary &&
+        if (role == ServerRole::Primary &&
             cache_api_->wait_primary_failover(ha_replicaset_,
                 kPrimaryFailoverTimeout)) {
           log_info("Retrying connection for '%s' after possible failover",
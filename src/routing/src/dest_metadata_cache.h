@@ -69,6 +69,14 @@ public:
   int get_server_socket(std::chrono::milliseconds connect_timeout, int *error,
                         mysql_harness::TCPAddress *address = nullptr) noexcept override;
 
+  /** @brief Gets next connection to a secondary
+   *
+   * Only used for routes with mode=read-write-split, get_server_socket()
+   * returns primaries for them.
+   */
+  int get_read_only_server_socket(std::chrono::milliseconds connect_timeout, int *error,
+                                  mysql_harness::TCPAddress *address = nullptr) noexcept override;
+
   ~DestMetadataCacheGroup();
 
   void add(const std::string &, uint16_t) override { }
@@ -143,12 +151,26 @@ private:
    *
    */
   AvailableDestinations get_available(const metadata_cache::LookupResult& managed_servers,
-                                      bool for_new_connections = true);
+                                      bool for_new_connections = true) {
+    return get_available(managed_servers, server_role_, for_new_connections);
+  }
 
-  size_t get_next_server(const DestMetadataCacheGroup::AvailableDestinations& available);
+  /** @brief Gets available destinations of the given role from Metadata Cache */
+  AvailableDestinations get_available(const metadata_cache::LookupResult& managed_servers,
+                                      ServerRole role, bool for_new_connections);
+
+  size_t get_next_server(const DestMetadataCacheGroup::AvailableDestinations& available,
+                         size_t &current_pos);
+
+  /** @brief Connects the next available server of the given role */
+  int connect_next_server(ServerRole role, std::chrono::milliseconds connect_timeout, int *error,
+                          mysql_harness::TCPAddress *address) noexcept;
 
   size_t current_pos_;
 
+  // position of the next secondary with mode=read-write-split
+  size_t current_read_only_pos_{0};
+
   routing::RoutingStrategy routing_strategy_;
 
   routing::AccessMode access_mode_;
@@ -164,6 +186,9 @@ private:
   bool disconnect_on_promoted_to_primary_{false};
   bool disconnect_on_metadata_unavailable_{false};
 
+  // secondaries with more transactions not applied yet are avoided, 0 = no limit
+  uint64_t max_transactions_behind_{0};
+
   void on_instances_change(const metadata_cache::LookupResult &instances, const bool md_servers_reachable);
   void subscribe_for_metadata_cache_changes();
 
@@ -52,7 +52,7 @@ int DestNextAvailable::get_server_socket(std::chrono::milliseconds connect_timeo
     auto addr = destinations_.at(i);
     log_debug("Trying server %s (index %lu)", addr.str().c_str(),
               static_cast<long unsigned>(i)); // 32bit Linux requires cast
-    auto sock = get_mysql_socket(addr, connect_timeout);
+    auto sock = get_pooled_or_new_socket(addr, connect_timeout);
     if (sock >= 0) {
       current_pos_ = i;
       if (address) *address = addr;
@@ -87,7 +87,7 @@ int DestRoundRobin::get_server_socket(std::chrono::milliseconds connect_timeout,
     TCPAddress server_addr = destinations_[server_pos];
     log_debug("Trying server %s (index %lu)", server_addr.str().c_str(),
               static_cast<long unsigned>(server_pos));
-    auto sock = get_mysql_socket(server_addr, connect_timeout);
+    auto sock = get_pooled_or_new_socket(server_addr, connect_timeout);
     if (sock >= 0) {
       // Server is available
       if (address) *address = server_addr;
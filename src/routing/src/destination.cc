@@ -23,6 +23,7 @@
 */
 
 #include "common.h"
+#include "connection_pool.h"
 #include "destination.h"
 #include "mysql/harness/logging/logging.h"
 #include "mysqlrouter/routing.h"
@@ -129,6 +130,57 @@ size_t RouteDestination::get_next_server() {
   return result;
 }
 
+void RouteDestination::set_local_sockets(const routing::LocalSockets &local_sockets) {
+  local_sockets_ = local_sockets;
+  local_host_names_.clear();
+
+  if (!local_sockets_.empty()) {
+    std::string hostname;
+    try {
+      hostname = routing_sock_ops_->so()->get_local_hostname();
+    } catch (const mysql_harness::SocketOperationsBase::LocalHostnameResolutionError &e) {
+      log_warning("Could not get the name of the local host: %s", e.what());
+    }
+    local_host_names_ = get_local_host_names(hostname);
+  }
+}
+
+std::string RouteDestination::get_local_socket(const TCPAddress &addr) const {
+  if (local_sockets_.empty()) return {};
+
+  auto it = local_sockets_.find(addr.port);
+  if (it == local_sockets_.end() || local_host_names_.count(addr.addr) == 0) {
+    return {};
+  }
+
+  return it->second;
+}
+
 int RouteDestination::get_mysql_socket(const TCPAddress &addr, std::chrono::milliseconds connect_timeout, const bool log_errors) {
+  const std::string local_socket = get_local_socket(addr);
+  if (!local_socket.empty()) {
+    int sock = routing_sock_ops_->get_mysql_unix_socket(local_socket, connect_timeout, log_errors);
+    if (sock >= 0) {
+      return sock;
+    }
+
+    if (log_errors) {
+      log_debug("Connecting to %s using socket %s failed, falling back to TCP",
+          addr.str().c_str(), local_socket.c_str());
+    }
+  }
+
   return routing_sock_ops_->get_mysql_socket(addr, connect_timeout, log_errors);
 }
+
+int RouteDestination::get_pooled_or_new_socket(const TCPAddress &addr,
+                                               std::chrono::milliseconds connect_timeout) {
+  if (connection_pool_) {
+    const int sock = connection_pool_->reserve(addr);
+    if (sock >= 0) {
+      return sock;
+    }
+  }
+
+  return get_mysql_socket(addr, connect_timeout);
+}
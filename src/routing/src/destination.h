@@ -32,6 +32,7 @@
 #include <condition_variable>
 #include <cstdint>
 #include <mutex>
+#include <set>
 #include <string>
 #include <thread>
 #include <vector>
@@ -41,6 +42,8 @@
 #include "mysql/harness/logging/logging.h"
 #include "protocol/protocol.h"
 #include "tcp_address.h"
+
+class ConnectionPool;
 IMPORT_LOG_FUNCTIONS()
 
 using AllowedNodes = std::vector<mysql_harness::TCPAddress>;
@@ -179,6 +182,27 @@ class RouteDestination: public DestinationNodesStateNotifier {
   virtual int get_server_socket(std::chrono::milliseconds connect_timeout, int *error,
                                 mysql_harness::TCPAddress *address = nullptr) noexcept = 0;
 
+  /** @brief Gets next connection to a destination serving reads
+   *
+   * Used when reads and writes of a session are split; get_server_socket()
+   * then returns the destination for writes. Unlike get_server_socket(),
+   * this may be called from connection threads.
+   *
+   * The default implementation has no such destinations and returns -1.
+   *
+   * @param connect_timeout timeout
+   * @param error Pointer to int for storing errno
+   * @param address Pointer to memory for storing destination address
+   * @return a socket descriptor or -1 on error
+   */
+  virtual int get_read_only_server_socket(std::chrono::milliseconds connect_timeout, int *error,
+                                          mysql_harness::TCPAddress *address = nullptr) noexcept {
+    (void)connect_timeout;
+    (void)address;
+    *error = 0;
+    return -1;
+  }
+
   /** @brief Gets the number of destinations
    *
    * Gets the number of destinations currently in the list.
@@ -200,6 +224,17 @@ class RouteDestination: public DestinationNodesStateNotifier {
    */
   virtual void start() {}
 
+  /** @brief Sets Unix sockets to use for destinations on the local host
+   *
+   * When a destination runs on the same host as the Router and its TCP port
+   * is found in the given map, the connection is made over the Unix socket
+   * instead of TCP, which saves the overhead of the loopback TCP stack. If
+   * connecting to the Unix socket fails, TCP is used as a fallback.
+   *
+   * @param local_sockets Unix socket paths keyed by TCP port
+   */
+  void set_local_sockets(const routing::LocalSockets &local_sockets);
+
   AddrVector::iterator begin() {
     return destinations_.begin();
   }
@@ -216,6 +251,31 @@ class RouteDestination: public DestinationNodesStateNotifier {
     return destinations_.end();
   }
 
+  /** @brief Connects a given destination server
+   *
+   * Unlike get_server_socket(), no destination is picked and the state of
+   * the destinations is not changed, hence this may be called from
+   * connection threads.
+   *
+   * @param addr information of the server we connect with
+   * @param connect_timeout timeout waiting for connection
+   * @return a socket descriptor or -1 on error
+   */
+  int connect_server(const mysql_harness::TCPAddress &addr, std::chrono::milliseconds connect_timeout) {
+    return get_mysql_socket(addr, connect_timeout);
+  }
+
+  /** @brief Sets the pool of idle server connections of the route
+   *
+   * get_server_socket() then reuses an idle connection to the picked
+   * destination if there is one, see ConnectionPool::reserve().
+   *
+   * @param connection_pool the pool; nullptr if connections are not pooled
+   */
+  void set_connection_pool(ConnectionPool *connection_pool) {
+    connection_pool_ = connection_pool;
+  }
+
  protected:
   /** @brief Returns socket descriptor of connected MySQL server
    *
@@ -233,6 +293,24 @@ class RouteDestination: public DestinationNodesStateNotifier {
    */
   virtual int get_mysql_socket(const mysql_harness::TCPAddress &addr, std::chrono::milliseconds connect_timeout, bool log_errors = true);
 
+  /** @brief Returns a pooled idle connection to the server or connects it
+   *
+   * Used by get_server_socket() once a destination is picked.
+   *
+   * @param addr information of the server we connect with
+   * @param connect_timeout timeout waiting for connection
+   * @return a socket descriptor or -1 on error
+   */
+  int get_pooled_or_new_socket(const mysql_harness::TCPAddress &addr,
+                               std::chrono::milliseconds connect_timeout);
+
+  /** @brief Returns the Unix socket to use for the destination, if any
+   *
+   * @param addr information of the server we connect with
+   * @return path of the Unix socket or empty string if TCP should be used
+   */
+  std::string get_local_socket(const mysql_harness::TCPAddress &addr) const;
+
   /** @brief Gets the id of the next server to connect to.
    *
    * @throws std::logic_error if destinations list is empty
@@ -253,6 +331,15 @@ class RouteDestination: public DestinationNodesStateNotifier {
 
   /** @brief Protocol for the destination */
   Protocol::Type protocol_;
+
+  /** @brief Unix sockets of the servers running on the local host */
+  routing::LocalSockets local_sockets_;
+
+  /** @brief Names and addresses of the local host */
+  std::set<std::string> local_host_names_;
+
+  /** @brief Idle server connections of the route, nullptr if not pooled */
+  ConnectionPool *connection_pool_{nullptr};
 };
 
 #endif // ROUTING_DESTINATION_INCLUDED
@@ -88,6 +88,7 @@ using mysqlrouter::URIError;
 using mysqlrouter::URIQuery;
 using mysql_harness::TCPAddress;
 using mysqlrouter::is_valid_socket_name;
+using mysql_harness::logging::LogLevel;
 IMPORT_LOG_FUNCTIONS()
 
 static int kListenQueueSize = 1024;
@@ -95,6 +96,38 @@ static int kListenQueueSize = 1024;
 static const char *kDefaultReplicaSetName = "default";
 static const std::chrono::milliseconds kAcceptorStopPollInterval_ms { 100 };
 
+// how often the connection pool counters are logged
+static constexpr std::chrono::minutes kPoolStatsReportInterval { 10 };
+
+/**
+ * log the connection pool counters, shows whether the pool size fits the
+ * clients of the route.
+ *
+ * @param reported connections reused and missed at the last report
+ * @returns connections reused and missed now, nothing is logged if it didn't change
+ */
+static uint64_t log_pool_stats(const std::string &name, const ConnectionPool &pool,
+                               uint64_t reported) {
+  const auto stats = pool.get_stats();
+
+  if (stats.reused + stats.misses != reported) {
+    log_info("[%s] connection pool: %llu of %llu idle, %llu reused, %llu misses, %llu added, "
+             "%llu expired, %llu resets (%llu failed, %lld us total)",
+             name.c_str(),
+             static_cast<unsigned long long>(stats.idle),
+             static_cast<unsigned long long>(stats.max_idle),
+             static_cast<unsigned long long>(stats.reused),
+             static_cast<unsigned long long>(stats.misses),
+             static_cast<unsigned long long>(stats.added),
+             static_cast<unsigned long long>(stats.expired),
+             static_cast<unsigned long long>(stats.resets),
+             static_cast<unsigned long long>(stats.reset_failures),
+             static_cast<long long>(stats.reset_time.count()));
+  }
+
+  return stats.reused + stats.misses;
+}
+
 MySQLRouting::MySQLRouting(routing::RoutingStrategy routing_strategy, uint16_t port,
                            const Protocol::Type protocol,
                            const routing::AccessMode access_mode,
@@ -246,6 +279,9 @@ void MySQLRouting::start_acceptor(mysql_harness::PluginFuncEnv* env) {
 
     // handle allowed nodes changed
     connection_container_.disconnect(nodes);
+    if (context_.get_connection_pool()) {
+      context_.get_connection_pool()->remove_not_allowed(nodes);
+    }
   };
 
   allowed_nodes_list_iterator_ =
@@ -273,7 +309,16 @@ void MySQLRouting::start_acceptor(mysql_harness::PluginFuncEnv* env) {
   fds[kAcceptTcpNdx].fd = service_tcp_;
   fds[kAcceptUnixSocketNdx].fd = service_named_socket_;
 
+  auto next_report = std::chrono::steady_clock::now() + kPoolStatsReportInterval;
+  uint64_t reported_clients = 0;
+
   while (is_running(env)) {
+    if (context_.get_connection_pool() && std::chrono::steady_clock::now() >= next_report) {
+      next_report += kPoolStatsReportInterval;
+      reported_clients = log_pool_stats(context_.get_name(), *context_.get_connection_pool(),
+                                        reported_clients);
+    }
+
     // wait for the accept() sockets to become readable (POLLIN)
     int ready_fdnum = context_.get_socket_operations()->poll(fds, sizeof(fds) / sizeof(fds[0]), kAcceptorStopPollInterval_ms);
     // < 0 - failure
@@ -313,27 +358,31 @@ void MySQLRouting::start_acceptor(mysql_harness::PluginFuncEnv* env) {
 
       bool is_tcp = (ndx == kAcceptTcpNdx);
 
-      if (is_tcp) {
-        log_debug("[%s] fd=%d connection accepted at %s", context_.get_name().c_str(), sock_client, context_.get_bind_address().str().c_str());
-      } else {
+      // skip building the addresses and asking for the peer credentials
+      // if the messages are not logged anyway
+      if (log_level_is_handled(LogLevel::kDebug)) {
+        if (is_tcp) {
+          log_debug("[%s] fd=%d connection accepted at %s", context_.get_name().c_str(), sock_client, context_.get_bind_address().str().c_str());
+        } else {
 #if !defined(_WIN32)
-        pid_t peer_pid;
-        uid_t peer_uid;
-
-        // try to be helpful of who tried to connect to use and failed.
-        // who == PID + UID
-        //
-        // if we can't get the PID, we'll just show a simpler errormsg
-
-        if (0 == unix_getpeercred(sock_client, peer_pid, peer_uid)) {
-          log_debug("[%s] fd=%d connection accepted at %s from (pid=%d, uid=%d)",
-              context_.get_name().c_str(), sock_client, context_.get_bind_named_socket().str().c_str(),
-              peer_pid, peer_uid);
-        } else
-          // fall through
+          pid_t peer_pid;
+          uid_t peer_uid;
+
+          // try to be helpful of who tried to connect to use and failed.
+          // who == PID + UID
+          //
+          // if we can't get the PID, we'll just show a simpler errormsg
+
+          if (0 == unix_getpeercred(sock_client, peer_pid, peer_uid)) {
+            log_debug("[%s] fd=%d connection accepted at %s from (pid=%d, uid=%d)",
+                context_.get_name().c_str(), sock_client, context_.get_bind_named_socket().str().c_str(),
+                peer_pid, peer_uid);
+          } else
+            // fall through
 #endif
-        log_debug("[%s] fd=%d connection accepted at %s",
-            context_.get_name().c_str(), sock_client, context_.get_bind_named_socket().str().c_str());
+          log_debug("[%s] fd=%d connection accepted at %s",
+              context_.get_name().c_str(), sock_client, context_.get_bind_named_socket().str().c_str());
+        }
       }
 
       if (context_.conn_error_counters_[in_addr_to_array(client_addr)] >= context_.max_connect_errors_) {
@@ -378,6 +427,10 @@ void MySQLRouting::start_acceptor(mysql_harness::PluginFuncEnv* env) {
     context_.active_client_threads_cond_.wait(lk, [&]{ return context_.active_client_threads_ == 0;});
   }
 
+  if (context_.get_connection_pool()) {
+    log_pool_stats(context_.get_name(), *context_.get_connection_pool(), 0);
+  }
+
   log_info("[%s] stopped", context_.get_name().c_str());
 }
 
@@ -386,6 +439,7 @@ void MySQLRouting::create_connection(int client_socket, const sockaddr_storage&
     connection_container_.remove_connection(connection);
   };
 
+  // the destination picks the server, a pooled connection to it is reused
   int error = 0;
   mysql_harness::TCPAddress server_address;
   int server_socket = destination_->get_server_socket(
@@ -393,7 +447,29 @@ void MySQLRouting::create_connection(int client_socket, const sockaddr_storage&
 
   std::unique_ptr<MySQLRoutingConnection> new_connection(
       new MySQLRoutingConnection(context_, client_socket, client_addr,
-          server_socket, server_address, remove_callback));
+                                 server_socket, server_address, remove_callback));
+
+  ConnectionPool *pool = context_.get_connection_pool();
+  PooledServerConnection pooled;
+  if (pool && server_socket >= 0 && pool->take_reserved(server_socket, pooled)) {
+    // called from the connection thread if the client can't use the pooled session
+    auto connect_server = [this](const mysql_harness::TCPAddress &address) {
+      return destination_->connect_server(address, context_.get_destination_connect_timeout());
+    };
+    new_connection->set_pooled_server(std::move(pooled), connect_server);
+  } else {
+    if (pool) pool->record_miss();
+
+    if (access_mode_ == routing::AccessMode::kReadWriteSplit) {
+      // called from the connection thread when the first read is routed
+      auto connect_read_only = [this](mysql_harness::TCPAddress *address) {
+        int read_only_error = 0;
+        return destination_->get_read_only_server_socket(
+            context_.get_destination_connect_timeout(), &read_only_error, address);
+      };
+      new_connection->set_read_only_server(connect_read_only);
+    }
+  }
 
   new_connection->start();
   connection_container_.add_connection(std::move(new_connection));
@@ -562,6 +638,8 @@ void MySQLRouting::set_destinations_from_uri(const URI &uri) {
                                                   routing_strategy_,
                                                   uri.query, context_.get_protocol().get_type(),
                                                   access_mode_));
+    destination_->set_local_sockets(local_sockets_);
+    destination_->set_connection_pool(context_.get_connection_pool());
   } else {
     throw runtime_error(string_format("Invalid URI scheme; expecting: 'metadata-cache' is: '%s'",
                                       uri.scheme.c_str()));
@@ -604,6 +682,17 @@ RouteDestination* create_standalone_destination(const routing::RoutingStrategy s
 }
 }
 
+void MySQLRouting::set_connection_pool(size_t max_idle, std::chrono::milliseconds idle_timeout) {
+  if (!context_.is_handshake_in_router()) {
+    throw std::invalid_argument("Connection pooling requires the router to run the handshake");
+  }
+  context_.set_connection_pool(std::make_shared<ConnectionPool>(
+      context_.get_socket_operations(), max_idle, idle_timeout));
+  if (destination_) {
+    destination_->set_connection_pool(context_.get_connection_pool());
+  }
+}
+
 void MySQLRouting::set_destinations_from_csv(const string &csv) {
   std::stringstream ss(csv);
   std::string part;
@@ -618,6 +707,8 @@ void MySQLRouting::set_destinations_from_csv(const string &csv) {
   destination_.reset(create_standalone_destination(routing_strategy_,
                                                    context_.get_protocol().get_type(),
                                                    routing_sock_ops_, context_.get_thread_stack_size()));
+  destination_->set_local_sockets(local_sockets_);
+  destination_->set_connection_pool(context_.get_connection_pool());
 
   // Fall back to comma separated list of MySQL servers
   while (std::getline(ss, part, ',')) {
@@ -46,6 +46,7 @@
 #include "connection.h"
 #include "context.h"
 #include "connection_container.h"
+#include "connection_pool.h"
 namespace mysql_harness { class PluginFuncEnv; }
 
 #include <array>
@@ -181,6 +182,53 @@ public:
 
   void set_destinations_from_uri(const mysqlrouter::URI &uri);
 
+  /** @brief Sets Unix sockets of destinations running on the local host
+   *
+   * Must be called before the destinations are set. Connections to a
+   * local destination whose TCP port is found in the map are made over
+   * the Unix socket instead of TCP.
+   *
+   * @param local_sockets Unix socket paths keyed by TCP port
+   */
+  void set_local_sockets(const routing::LocalSockets &local_sockets) {
+    local_sockets_ = local_sockets;
+  }
+
+  /** @brief Lets the router terminate TLS of client connections
+   *
+   * Only supported for the classic protocol.
+   *
+   * @param tls_context certificate, key and session cache for the clients;
+   *                    nullptr for ClientSslMode::kDisabled
+   * @param ssl_mode ClientSslMode::kPreferred, ClientSslMode::kRequired or
+   *                 ClientSslMode::kDisabled
+   */
+  void set_client_tls(std::shared_ptr<ClientTlsContext> tls_context,
+                      routing::ClientSslMode ssl_mode) {
+    context_.set_client_tls(std::move(tls_context), ssl_mode);
+  }
+
+  /** @brief Keeps server connections of quitting clients for reuse
+   *
+   * Requires set_client_tls() to be called before, as the router can only
+   * pool connections whose handshake it runs.
+   *
+   * @param max_idle maximum number of idle server connections
+   * @param idle_timeout time after which idle server connections are closed
+   */
+  void set_connection_pool(size_t max_idle, std::chrono::milliseconds idle_timeout);
+
+  /** @brief Sets the accounts whose reads are sent to secondaries
+   *
+   * Used with mode read-write-split; sessions of other users stay with the
+   * primary.
+   *
+   * @param credentials passwords by user name
+   */
+  void set_read_write_split_credentials(std::map<std::string, std::string> credentials) {
+    context_.set_read_write_split_credentials(std::move(credentials));
+  }
+
   /** @brief Returns timeout when connecting to destination
    *
    * @return Timeout in seconds as int
@@ -273,6 +321,9 @@ private:
   /** @brief Destination object to use when getting next connection */
   std::unique_ptr<RouteDestination> destination_;
 
+  /** @brief Unix sockets to use for destinations on the local host */
+  routing::LocalSockets local_sockets_;
+
   /** @brief Routing strategy to use when getting next destination */
   routing::RoutingStrategy routing_strategy_;
 
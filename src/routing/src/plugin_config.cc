@@ -60,12 +60,75 @@ RoutingPluginConfig::RoutingPluginConfig(const mysql_harness::ConfigSection *sec
       max_connect_errors(get_uint_option<uint32_t>(section, "max_connect_errors", 1, UINT32_MAX)),
       client_connect_timeout(get_uint_option<uint32_t>(section, "client_connect_timeout", 2, 31536000)),
       net_buffer_length(get_uint_option<uint32_t>(section, "net_buffer_length", 1024, 1048576)),
-      thread_stack_size(get_uint_option<uint32_t>(section, "thread_stack_size", 1, 65535)){
+      thread_stack_size(get_uint_option<uint32_t>(section, "thread_stack_size", 1, 65535)),
+      local_sockets(get_option_local_sockets(section, "local_sockets", protocol)),
+      client_ssl_mode(get_option_client_ssl_mode(section, "client_ssl_mode")),
+      client_ssl_cert(get_option_string(section, "client_ssl_cert")),
+      client_ssl_key(get_option_string(section, "client_ssl_key")),
+      client_ssl_session_cache_size(get_uint_option<uint32_t>(section, "client_ssl_session_cache_size")),
+      client_ssl_ktls(get_uint_option<uint16_t>(section, "client_ssl_ktls", 0, 1) == 1),
+      connection_pool_size(get_uint_option<uint32_t>(section, "connection_pool_size", 0, 65535)),
+      connection_pool_idle_timeout(get_uint_option<uint32_t>(section, "connection_pool_idle_timeout", 1, 31536000)),
+      read_write_split_users(get_option_user_list(section, "read_write_split_users")) {
 
   // either bind_address or socket needs to be set, or both
   if (!bind_address.port && !named_socket.is_set()) {
     throw invalid_argument("either bind_address or socket option needs to be supplied, or both");
   }
+
+  if (client_ssl_mode != routing::ClientSslMode::kPassthrough) {
+    if (protocol != Protocol::Type::kClassicProtocol) {
+      throw invalid_argument(get_log_prefix("client_ssl_mode") +
+                             " is only supported for the classic protocol");
+    }
+  }
+
+  if (client_ssl_mode == routing::ClientSslMode::kPreferred ||
+      client_ssl_mode == routing::ClientSslMode::kRequired) {
+    if (client_ssl_cert.empty()) {
+      throw invalid_argument(get_log_prefix("client_ssl_cert") +
+                             " is required if client_ssl_mode is preferred or required");
+    }
+    if (client_ssl_key.empty()) {
+      throw invalid_argument(get_log_prefix("client_ssl_key") +
+                             " is required if client_ssl_mode is preferred or required");
+    }
+  }
+
+  // the router has to see the authentication to hand a server connection
+  // to another client; with client_ssl_mode disabled it runs the handshake
+  // without TLS
+  if (connection_pool_size > 0 && client_ssl_mode == routing::ClientSslMode::kPassthrough) {
+    throw invalid_argument(get_log_prefix("connection_pool_size") +
+                           " requires client_ssl_mode other than passthrough");
+  }
+
+  // splitting needs the decrypted commands of the client, hence TLS has to
+  // be terminated in the router. Secondaries are logged into with the
+  // passwords of the configured accounts, taken from the keyring.
+  if (mode == routing::AccessMode::kReadWriteSplit) {
+    if (!metadata_cache_) {
+      throw invalid_argument(get_log_prefix("mode") +
+                             " read-write-split requires metadata-cache destinations");
+    }
+    if (protocol != Protocol::Type::kClassicProtocol) {
+      throw invalid_argument(get_log_prefix("mode") +
+                             " read-write-split is only supported for the classic protocol");
+    }
+    if (client_ssl_mode != routing::ClientSslMode::kPreferred &&
+        client_ssl_mode != routing::ClientSslMode::kRequired) {
+      throw invalid_argument(get_log_prefix("mode") +
+                             " read-write-split requires client_ssl_mode preferred or required");
+    }
+    if (read_write_split_users.empty()) {
+      throw invalid_argument(get_log_prefix("read_write_split_users") +
+                             " is required if mode is read-write-split");
+    }
+    if (connection_pool_size > 0) {
+      throw invalid_argument(get_log_prefix("mode") +
+                             " read-write-split can not be used with connection_pool_size");
+    }
+  }
 }
 
 
@@ -79,6 +142,11 @@ string RoutingPluginConfig::get_default(const string &option) const {
       {"client_connect_timeout", to_string(std::chrono::duration_cast<std::chrono::seconds>(routing::kDefaultClientConnectTimeout).count())},
       {"net_buffer_length", to_string(routing::kDefaultNetBufferLength)},
       {"thread_stack_size", to_string(mysql_harness::kDefaultStackSizeInKiloBytes)},
+      {"client_ssl_mode", "passthrough"},
+      {"client_ssl_session_cache_size", to_string(routing::kDefaultClientSslSessionCacheSize)},
+      {"client_ssl_ktls", "0"},
+      {"connection_pool_size", "0"},
+      {"connection_pool_idle_timeout", to_string(routing::kDefaultConnectionPoolIdleTimeout.count())},
   };
 
   auto it = defaults.find(option);
@@ -122,6 +190,21 @@ routing::AccessMode RoutingPluginConfig::get_option_mode(
   return result;
 }
 
+routing::ClientSslMode RoutingPluginConfig::get_option_client_ssl_mode(
+    const mysql_harness::ConfigSection *section, const string &option) const {
+  string value = get_option_string(section, option);
+
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+
+  routing::ClientSslMode result = routing::get_client_ssl_mode(value);
+  if (result == routing::ClientSslMode::kUndefined) {
+    const string valid = routing::get_client_ssl_mode_names();
+    throw invalid_argument(get_log_prefix(option) + " is invalid; valid are " +
+                           valid + " (was '" + value + "')");
+  }
+  return result;
+}
+
 routing::RoutingStrategy RoutingPluginConfig::get_option_routing_strategy(
     const mysql_harness::ConfigSection *section, const string &option) const {
   string value;
@@ -245,3 +328,93 @@ string RoutingPluginConfig::get_option_destinations(const mysql_harness::ConfigS
 
   return value;
 }
+
+std::vector<string> RoutingPluginConfig::get_option_user_list(const mysql_harness::ConfigSection *section,
+                                                            const string &option) const {
+  std::vector<string> result;
+  string value;
+  try {
+    value = get_option_string(section, option);
+  } catch (const mysqlrouter::option_not_present&) {
+    return result;
+  }
+
+  // format: <user>[,<user>...]
+  std::stringstream ss(value);
+  string part;
+  while (std::getline(ss, part, ',')) {
+    mysqlrouter::trim(part);
+    if (part.empty()) {
+      throw invalid_argument(get_log_prefix(option) +
+                             ": empty entry found in user list (was '" + value + "')");
+    }
+    result.push_back(part);
+  }
+
+  return result;
+}
+
+routing::LocalSockets RoutingPluginConfig::get_option_local_sockets(const mysql_harness::ConfigSection *section,
+                                                           const string &option,
+                                                           const Protocol::Type &protocol_type) const {
+  routing::LocalSockets result;
+  string value;
+  try {
+    value = get_option_string(section, option);
+  } catch (const mysqlrouter::option_not_present&) {
+    return result;
+  }
+
+  mysqlrouter::trim(value);
+  if (value.empty()) {
+    return result;
+  }
+
+#ifdef _WIN32
+  (void)protocol_type;
+  throw invalid_argument(get_log_prefix(option) + " is not supported on Windows");
+#else
+  // format: [<port>:]<path>[,[<port>:]<path>...]
+  std::stringstream ss(value);
+  string part;
+  while (std::getline(ss, part, ',')) {
+    mysqlrouter::trim(part);
+    if (part.empty()) {
+      throw invalid_argument(get_log_prefix(option) +
+                             ": empty entry found in socket list (was '" + value + "')");
+    }
+
+    uint16_t port = Protocol::get_default_port(protocol_type);
+    string path = part;
+    if (part.front() != '/') {
+      auto pos = part.find(':');
+      if (pos == string::npos) {
+        throw invalid_argument(get_log_prefix(option) +
+                               ": socket path in '" + part + "' needs to be absolute");
+      }
+      const string port_str = part.substr(0, pos);
+      const unsigned port_num = mysqlrouter::strtoui_checked(port_str.c_str(), 0);
+      if (port_num == 0 || port_num > UINT16_MAX) {
+        throw invalid_argument(get_log_prefix(option) +
+                               ": invalid TCP port '" + port_str + "' in '" + part + "'");
+      }
+      port = static_cast<uint16_t>(port_num);
+      path = part.substr(pos + 1);
+    }
+
+    string err_msg;
+    if (path.empty() || path.front() != '/' || !mysqlrouter::is_valid_socket_name(path, err_msg)) {
+      throw invalid_argument(get_log_prefix(option) +
+                             ": invalid socket path '" + path + "'" +
+                             (err_msg.empty() ? "" : ": " + err_msg));
+    }
+
+    if (!result.emplace(port, path).second) {
+      throw invalid_argument(get_log_prefix(option) +
+                             ": duplicate TCP port " + to_string(port) + " (was '" + value + "')");
+    }
+  }
+
+  return result;
+#endif
+}
@@ -39,6 +39,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 using std::map;
 using std::string;
@@ -94,6 +95,24 @@ public:
   const unsigned int net_buffer_length;
   /** @brief memory in kilobytes allocated for thread's stack */
   const unsigned int thread_stack_size;
+  /** @brief `local_sockets` option read from configuration section */
+  const routing::LocalSockets local_sockets;
+  /** @brief `client_ssl_mode` option read from configuration section */
+  const routing::ClientSslMode client_ssl_mode;
+  /** @brief `client_ssl_cert` option read from configuration section */
+  const std::string client_ssl_cert;
+  /** @brief `client_ssl_key` option read from configuration section */
+  const std::string client_ssl_key;
+  /** @brief `client_ssl_session_cache_size` option read from configuration section */
+  const unsigned int client_ssl_session_cache_size;
+  /** @brief `client_ssl_ktls` option read from configuration section */
+  const bool client_ssl_ktls;
+  /** @brief `connection_pool_size` option read from configuration section */
+  const unsigned int connection_pool_size;
+  /** @brief `connection_pool_idle_timeout` option read from configuration section */
+  const unsigned int connection_pool_idle_timeout;
+  /** @brief `read_write_split_users` option read from configuration section */
+  const std::vector<std::string> read_write_split_users;
 protected:
 
 private:
@@ -103,6 +122,11 @@ private:
   std::string get_option_destinations(const mysql_harness::ConfigSection *section, const std::string &option,
                                       const Protocol::Type &protocol_type) const;
   Protocol::Type get_protocol(const mysql_harness::ConfigSection *section, const std::string &option) const;
+  routing::ClientSslMode get_option_client_ssl_mode(const mysql_harness::ConfigSection *section, const std::string &option) const;
+  std::vector<std::string> get_option_user_list(const mysql_harness::ConfigSection *section,
+                                                const std::string &option) const;
+  routing::LocalSockets get_option_local_sockets(const mysql_harness::ConfigSection *section, const std::string &option,
+                                        const Protocol::Type &protocol_type) const;
 };
 
 #endif // PLUGIN_CONFIG_ROUTING_INCLUDED
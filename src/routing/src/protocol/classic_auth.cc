@@ -0,0 +1,212 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "classic_auth.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef HAVE_YASSL
+# include <memory>
+# include <openssl/evp.h>
+# include <openssl/pem.h>
+# include <openssl/rsa.h>
+#else
+# include "sha.hpp"
+#endif
+
+namespace classic_auth {
+
+namespace {
+
+#ifndef HAVE_YASSL
+
+// EVP_MD_CTX_destroy() is a macro in newer OpenSSL versions
+struct MdCtxDeleter {
+  void operator()(EVP_MD_CTX *ctx) const { EVP_MD_CTX_destroy(ctx); }
+};
+
+std::vector<uint8_t> digest(const EVP_MD *md, const uint8_t *data1, size_t size1,
+                            const uint8_t *data2 = nullptr, size_t size2 = 0) {
+  std::unique_ptr<EVP_MD_CTX, MdCtxDeleter> ctx(EVP_MD_CTX_create());
+  std::vector<uint8_t> result(static_cast<size_t>(EVP_MD_size(md)));
+  unsigned int size = 0;
+
+  if (!ctx || EVP_DigestInit_ex(ctx.get(), md, nullptr) != 1 ||
+      EVP_DigestUpdate(ctx.get(), data1, size1) != 1 ||
+      (size2 > 0 && EVP_DigestUpdate(ctx.get(), data2, size2) != 1) ||
+      EVP_DigestFinal_ex(ctx.get(), result.data(), &size) != 1) {
+    throw std::runtime_error("Computing the password hash failed");
+  }
+
+  return result;
+}
+
+std::vector<uint8_t> sha1(const uint8_t *data1, size_t size1,
+                          const uint8_t *data2 = nullptr, size_t size2 = 0) {
+  return digest(EVP_sha1(), data1, size1, data2, size2);
+}
+
+std::vector<uint8_t> sha256(const uint8_t *data1, size_t size1,
+                            const uint8_t *data2 = nullptr, size_t size2 = 0) {
+  return digest(EVP_sha256(), data1, size1, data2, size2);
+}
+
+#else
+
+template <class Hash>
+std::vector<uint8_t> digest(const uint8_t *data1, size_t size1,
+                            const uint8_t *data2, size_t size2) {
+  Hash hash;
+  std::vector<uint8_t> result(hash.getDigestSize());
+  hash.Update(data1, static_cast<TaoCrypt::word32>(size1));
+  if (size2 > 0) hash.Update(data2, static_cast<TaoCrypt::word32>(size2));
+  hash.Final(result.data());
+
+  return result;
+}
+
+std::vector<uint8_t> sha1(const uint8_t *data1, size_t size1,
+                          const uint8_t *data2 = nullptr, size_t size2 = 0) {
+  return digest<TaoCrypt::SHA>(data1, size1, data2, size2);
+}
+
+std::vector<uint8_t> sha256(const uint8_t *data1, size_t size1,
+                            const uint8_t *data2 = nullptr, size_t size2 = 0) {
+  return digest<TaoCrypt::SHA256>(data1, size1, data2, size2);
+}
+
+#endif // HAVE_YASSL
+
+const uint8_t *bytes(const std::string &str) {
+  return reinterpret_cast<const uint8_t*>(str.data());
+}
+
+}
+
+std::vector<uint8_t> scramble_native_password(const std::string &password,
+                                              const std::vector<uint8_t> &nonce) {
+  if (password.empty()) return {};
+
+  // SHA1(password) XOR SHA1(nonce, SHA1(SHA1(password)))
+  std::vector<uint8_t> stage1 = sha1(bytes(password), password.size());
+  const std::vector<uint8_t> stage2 = sha1(stage1.data(), stage1.size());
+  const std::vector<uint8_t> mask = sha1(nonce.data(), nonce.size(),
+                                         stage2.data(), stage2.size());
+  for (size_t i = 0; i < stage1.size(); ++i) {
+    stage1[i] = static_cast<uint8_t>(stage1[i] ^ mask[i]);
+  }
+
+  return stage1;
+}
+
+std::vector<uint8_t> scramble_caching_sha2_password(const std::string &password,
+                                                    const std::vector<uint8_t> &nonce) {
+  if (password.empty()) return {};
+
+  // SHA256(password) XOR SHA256(SHA256(SHA256(password)), nonce)
+  std::vector<uint8_t> stage1 = sha256(bytes(password), password.size());
+  const std::vector<uint8_t> stage2 = sha256(stage1.data(), stage1.size());
+  const std::vector<uint8_t> mask = sha256(stage2.data(), stage2.size(),
+                                           nonce.data(), nonce.size());
+  for (size_t i = 0; i < stage1.size(); ++i) {
+    stage1[i] = static_cast<uint8_t>(stage1[i] ^ mask[i]);
+  }
+
+  return stage1;
+}
+
+#ifndef HAVE_YASSL
+
+namespace {
+
+struct BioDeleter {
+  void operator()(BIO *bio) const { BIO_free(bio); }
+};
+
+struct PkeyDeleter {
+  void operator()(EVP_PKEY *pkey) const { EVP_PKEY_free(pkey); }
+};
+
+struct PkeyCtxDeleter {
+  void operator()(EVP_PKEY_CTX *ctx) const { EVP_PKEY_CTX_free(ctx); }
+};
+
+}
+
+bool has_rsa_password_encryption() {
+  return true;
+}
+
+std::vector<uint8_t> encrypt_password_rsa(const std::string &password,
+                                          const std::vector<uint8_t> &nonce,
+                                          const std::string &public_key) {
+  if (nonce.empty()) throw std::runtime_error("No scramble to encrypt the password with");
+
+  // older OpenSSL versions take the buffer as non-const
+  std::unique_ptr<BIO, BioDeleter> bio(
+      BIO_new_mem_buf(const_cast<char*>(public_key.data()), static_cast<int>(public_key.size())));
+  std::unique_ptr<EVP_PKEY, PkeyDeleter> pkey(
+      bio ? PEM_read_bio_PUBKEY(bio.get(), nullptr, nullptr, nullptr) : nullptr);
+  if (!pkey) throw std::runtime_error("Invalid RSA public key of the server");
+
+  // password and its terminator, XORed with the nonce
+  std::vector<uint8_t> plain(password.begin(), password.end());
+  plain.push_back(0);
+  for (size_t i = 0; i < plain.size(); ++i) {
+    plain[i] = static_cast<uint8_t>(plain[i] ^ nonce[i % nonce.size()]);
+  }
+
+  std::unique_ptr<EVP_PKEY_CTX, PkeyCtxDeleter> ctx(EVP_PKEY_CTX_new(pkey.get(), nullptr));
+  size_t size = 0;
+  std::vector<uint8_t> result;
+  if (ctx && EVP_PKEY_encrypt_init(ctx.get()) == 1 &&
+      EVP_PKEY_CTX_set_rsa_padding(ctx.get(), RSA_PKCS1_OAEP_PADDING) == 1 &&
+      EVP_PKEY_encrypt(ctx.get(), nullptr, &size, plain.data(), plain.size()) == 1) {
+    result.resize(size);
+    if (EVP_PKEY_encrypt(ctx.get(), result.data(), &size, plain.data(), plain.size()) != 1) {
+      size = 0;
+    }
+  }
+  std::fill(plain.begin(), plain.end(), 0);
+  if (size == 0) throw std::runtime_error("Encrypting the password failed");
+  result.resize(size);
+
+  return result;
+}
+
+#else
+
+bool has_rsa_password_encryption() {
+  return false;
+}
+
+std::vector<uint8_t> encrypt_password_rsa(const std::string &, const std::vector<uint8_t> &,
+                                          const std::string &) {
+  throw std::runtime_error("Encrypting passwords with RSA needs MySQL Router built with OpenSSL");
+}
+
+#endif // HAVE_YASSL
+
+} // namespace classic_auth
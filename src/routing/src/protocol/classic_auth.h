@@ -0,0 +1,87 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef ROUTING_CLASSIC_AUTH_INCLUDED
+#define ROUTING_CLASSIC_AUTH_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** @file
+ * @brief Client side of the MySQL authentication methods
+ *
+ * Used by the router to log into secondaries with the configured password
+ * of an account when it splits reads and writes. Works with OpenSSL and
+ * the bundled yaSSL, except for the RSA encryption of passwords, which
+ * needs OpenSSL.
+ */
+
+namespace classic_auth {
+
+/** @brief Auth-response of mysql_native_password
+ *
+ * @param password password in clear text
+ * @param nonce 20 bytes scramble sent by the server
+ * @return auth-response; empty for an empty password
+ */
+std::vector<uint8_t> scramble_native_password(const std::string &password,
+                                              const std::vector<uint8_t> &nonce);
+
+/** @brief Fast auth-response of caching_sha2_password
+ *
+ * @param password password in clear text
+ * @param nonce 20 bytes scramble sent by the server
+ * @return auth-response; empty for an empty password
+ */
+std::vector<uint8_t> scramble_caching_sha2_password(const std::string &password,
+                                                    const std::vector<uint8_t> &nonce);
+
+/** @brief Whether encrypt_password_rsa() is available
+ *
+ * yaSSL has no RSA OAEP padding, which the servers expect.
+ */
+bool has_rsa_password_encryption();
+
+/** @brief Password of caching_sha2_password full authentication, encrypted
+ *         for an unencrypted connection
+ *
+ * The password with its terminating NUL, XORed with the nonce, is encrypted
+ * with the server's RSA public key using OAEP padding. The key is taken as
+ * the server sends it and is not verified.
+ *
+ * @param password password in clear text
+ * @param nonce 20 bytes scramble sent by the server
+ * @param public_key PEM encoded RSA public key of the server
+ * @return encrypted password
+ * @throws std::runtime_error if the key is invalid or encryption fails
+ */
+std::vector<uint8_t> encrypt_password_rsa(const std::string &password,
+                                          const std::vector<uint8_t> &nonce,
+                                          const std::string &public_key);
+
+} // namespace classic_auth
+
+#endif // ROUTING_CLASSIC_AUTH_INCLUDED
@@ -24,13 +24,18 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "classic_protocol.h"
 
+#include "../client_tls.h"
+#include "classic_auth.h"
 #include "common.h"
 #include "mysql/harness/logging/logging.h"
 #include "mysqlrouter/mysql_protocol.h"
 #include "mysqlrouter/routing.h"
+#include "random_generator.h"
 #include "../utils.h"
 
+#include <algorithm>
 #include <cstring>
+#include <stdexcept>
 
 using mysql_harness::get_strerror;
 IMPORT_LOG_FUNCTIONS()
@@ -47,6 +52,41 @@ bool ClassicProtocol::on_block_client_host(int server, const std::string &log_pr
   return true;
 }
 
+namespace {
+
+/**
+ * reads from fd until the buffer holds at least `needed` bytes.
+ *
+ * handshake packets may arrive in pieces, the ones which are inspected
+ * need their header and first fields complete.
+ *
+ * @returns false if the read failed or the connection got closed
+ */
+bool read_at_least(mysql_harness::SocketOperationsBase *so, int fd,
+                   RoutingProtocolBuffer &buffer, size_t &bytes_read, size_t needed) {
+  while (bytes_read < needed) {
+    const ssize_t res = so->read(fd, &buffer[bytes_read], buffer.size() - bytes_read);
+    if (res <= 0) {
+      if (res == -1) {
+        const int last_errno = so->get_errno();
+
+        log_debug("fd=%d read failed: (%d %s)",
+            fd,
+            last_errno, get_message_error(last_errno).c_str());
+      } else {
+        // the caller assumes that errno == 0 on plain connection closes.
+        so->set_errno(0);
+      }
+      return false;
+    }
+    bytes_read += static_cast<size_t>(res);
+  }
+
+  return true;
+}
+
+}
+
 int ClassicProtocol::copy_packets(int sender, int receiver, bool sender_is_readable,
                                   RoutingProtocolBuffer &buffer, int *curr_pktnr,
                                   bool &handshake_done, size_t *report_bytes_read,
@@ -85,17 +125,26 @@ int ClassicProtocol::copy_packets(int sender, int receiver, bool sender_is_reada
       // handshaking is satisfied. For secure connections, we stop when client asks to
       // switch to SSL.
       // The caller should set handshake_done to true when packet number is 2.
-      if (bytes_read < mysql_protocol::Packet::kHeaderSize) {
-        // We need packet which is at least 4 bytes
+      if (!read_at_least(so, sender, buffer, bytes_read, mysql_protocol::Packet::kHeaderSize)) {
         return -1;
       }
+      const size_t payload_size = static_cast<size_t>(buffer[0]) |
+                                  static_cast<size_t>(buffer[1]) << 8 |
+                                  static_cast<size_t>(buffer[2]) << 16;
       pktnr = buffer[3];
       if (*curr_pktnr > 0 && pktnr != *curr_pktnr + 1) {
         log_debug("Received incorrect packet number; aborting (was %d)", pktnr);
         return -1;
       }
 
-      if (buffer[4] == 0xff) {
+      // the error marker and the capabilities of a handshake response
+      // are in the first 4 bytes of the payload
+      if (!read_at_least(so, sender, buffer, bytes_read,
+                         mysql_protocol::Packet::kHeaderSize + std::min<size_t>(payload_size, 4))) {
+        return -1;
+      }
+
+      if (payload_size > 0 && buffer[4] == 0xff) {
         // We got error from MySQL Server while handshaking
         // We do not consider this a failed handshake
 
@@ -119,9 +168,10 @@ int ClassicProtocol::copy_packets(int sender, int receiver, bool sender_is_reada
         // if client is switching to SSL, we are not continuing any checks
         mysql_protocol::Capabilities::Flags capabilities;
         try {
-          auto pkt = mysql_protocol::Packet(buffer);
+          // only the capabilities are needed, don't copy the buffer
+          mysql_protocol::PacketView pkt(buffer.data(), bytes_read);
           capabilities = mysql_protocol::Capabilities::Flags(pkt.read_int_from<uint32_t>(4));
-        } catch (const mysql_protocol::packet_error &exc) {
+        } catch (const std::range_error &exc) {
           log_debug("%s", exc.what());
           return -1;
         }
@@ -164,3 +214,1109 @@ bool ClassicProtocol::send_error(int destination,
   }
   return true;
 }
+
+namespace {
+
+using mysql_protocol::Capabilities::Flags;
+
+const Flags kSslFlag = mysql_protocol::Capabilities::SSL;
+const size_t kHeaderSize = mysql_protocol::Packet::kHeaderSize;
+
+// the SSL request is a handshake response that ends after the filler
+const size_t kSslRequestPayloadSize = 32;
+
+// client auth plugin name that no server implements. The server answers it
+// with an auth-switch request to the plugin of the account.
+const char kForceAuthSwitchPlugin[] = "mysqlrouter_auth_switch";
+
+// waits until fd has data, unless TLS has buffered data already
+bool wait_readable(mysql_harness::SocketOperationsBase *so, int fd,
+                   ClientTlsConnection *tls, std::chrono::milliseconds timeout) {
+  if (tls && tls->pending() > 0) return true;
+
+  while (true) {
+    struct pollfd fds[] = {
+      { fd, POLLIN, 0 },
+    };
+    const int res = so->poll(fds, 1, timeout);
+    if (res > 0) return true;
+    if (res == 0) {
+      so->set_errno(ETIMEDOUT);
+      return false;
+    }
+    if (so->get_errno() != EINTR) return false;
+  }
+}
+
+bool read_exact(mysql_harness::SocketOperationsBase *so, int fd,
+                ClientTlsConnection *tls, std::chrono::milliseconds timeout,
+                uint8_t *buffer, size_t size) {
+  while (size > 0) {
+    if (!wait_readable(so, fd, tls, timeout)) return false;
+
+    const ssize_t res = tls ? tls->read(buffer, size) : so->read(fd, buffer, size);
+    if (res < 0 && tls && so->get_errno() == EAGAIN) continue;
+    if (res <= 0) {
+      if (res == 0) so->set_errno(0);
+      return false;
+    }
+    buffer += res;
+    size -= static_cast<size_t>(res);
+  }
+
+  return true;
+}
+
+// reads one complete packet, either plain from fd or through TLS
+bool read_packet(mysql_harness::SocketOperationsBase *so, int fd,
+                 ClientTlsConnection *tls, std::chrono::milliseconds timeout,
+                 RoutingProtocolBuffer &packet) {
+  packet.resize(kHeaderSize);
+  if (!read_exact(so, fd, tls, timeout, &packet[0], kHeaderSize)) return false;
+
+  const size_t payload_size = static_cast<size_t>(packet[0]) |
+                              static_cast<size_t>(packet[1]) << 8 |
+                              static_cast<size_t>(packet[2]) << 16;
+  packet.resize(kHeaderSize + payload_size);
+
+  return payload_size == 0 ||
+         read_exact(so, fd, tls, timeout, &packet[kHeaderSize], payload_size);
+}
+
+bool write_packet(mysql_harness::SocketOperationsBase *so, int fd,
+                  ClientTlsConnection *tls, RoutingProtocolBuffer &packet) {
+  const ssize_t res = tls ? tls->write_all(packet.data(), packet.size())
+                          : so->write_all(fd, packet.data(), packet.size());
+  return res >= 0;
+}
+
+// position of the lower capability flags in a protocol 10 greeting; 0 if invalid
+size_t greeting_capabilities_pos(const RoutingProtocolBuffer &greeting) {
+  if (greeting.size() <= kHeaderSize || greeting[kHeaderSize] != 10) return 0;
+
+  // protocol version, server version, connection id, auth-plugin-data-part-1, filler
+  auto version_end = std::find(greeting.begin() + kHeaderSize + 1, greeting.end(), 0);
+  const size_t pos = static_cast<size_t>(version_end - greeting.begin()) + 1 + 4 + 8 + 1;
+
+  // lower flags, character set, status flags, upper flags
+  return pos + 2 + 1 + 2 + 2 <= greeting.size() ? pos : 0;
+}
+
+void update_payload_size(RoutingProtocolBuffer &packet) {
+  const size_t payload_size = packet.size() - kHeaderSize;
+  packet[0] = static_cast<uint8_t>(payload_size);
+  packet[1] = static_cast<uint8_t>(payload_size >> 8);
+  packet[2] = static_cast<uint8_t>(payload_size >> 16);
+}
+
+size_t lenenc_size(uint64_t value) {
+  if (value < 251) return 1;
+  if (value < (1 << 16)) return 3;
+  if (value < (1 << 24)) return 4;
+  return 9;
+}
+
+// replaces the auth plugin name of a parsed handshake response
+bool replace_auth_plugin(RoutingProtocolBuffer &packet,
+                         const mysql_protocol::HandshakeResponsePacket &parsed,
+                         Flags capabilities, const std::string &plugin) {
+  if (!capabilities.test(mysql_protocol::Capabilities::PLUGIN_AUTH)) return false;
+
+  // the plugin name is followed by its terminator and the connection attributes
+  size_t tail = 1;
+  if (capabilities.test(mysql_protocol::Capabilities::CONNECT_ATTRS)) {
+    const size_t attrs_size = parsed.get_connection_attrs().size();
+    tail += lenenc_size(attrs_size) + attrs_size;
+  }
+  const std::string &old_plugin = parsed.get_auth_plugin();
+  if (packet.size() < kHeaderSize + tail + old_plugin.size()) return false;
+
+  const auto plugin_end = packet.end() - static_cast<std::ptrdiff_t>(tail);
+  const auto plugin_begin = plugin_end - static_cast<std::ptrdiff_t>(old_plugin.size());
+  if (!std::equal(old_plugin.begin(), old_plugin.end(), plugin_begin)) return false;
+
+  packet.insert(packet.erase(plugin_begin, plugin_end), plugin.begin(), plugin.end());
+  update_payload_size(packet);
+
+  return true;
+}
+
+bool is_ok_or_error(const RoutingProtocolBuffer &packet) {
+  return packet.size() > kHeaderSize &&
+         (packet[kHeaderSize] == 0x00 || packet[kHeaderSize] == 0xff);
+}
+
+const char kNativePasswordPlugin[] = "mysql_native_password";
+const char kCachingSha2PasswordPlugin[] = "caching_sha2_password";
+
+// caching_sha2_password exchange after the auth-response
+const uint8_t kAuthMoreData = 0x01;
+const uint8_t kRequestPublicKey = 0x02;
+const uint8_t kFastAuthSuccess = 0x03;
+const uint8_t kPerformFullAuth = 0x04;
+
+// plugins which send the password in clear text if the client's connection
+// is encrypted
+const char kSha256PasswordPlugin[] = "sha256_password";
+const char kClearPasswordPlugin[] = "mysql_clear_password";
+
+bool is_cleartext_plugin(const std::string &plugin) {
+  return plugin == kSha256PasswordPlugin || plugin == kClearPasswordPlugin;
+}
+
+bool is_full_auth_request(const RoutingProtocolBuffer &packet) {
+  return packet.size() == kHeaderSize + 2 && packet[kHeaderSize] == kAuthMoreData &&
+         packet[kHeaderSize + 1] == kPerformFullAuth;
+}
+
+// whether the server's packet makes a TLS client send its password in clear
+// text: caching_sha2_password's full authentication or an auth-switch to a
+// plugin that sends it right away
+bool requests_cleartext_password(const RoutingProtocolBuffer &packet) {
+  if (is_full_auth_request(packet)) return true;
+  if (packet.size() > kHeaderSize + 1 && packet[kHeaderSize] == 0xfe) {
+    const auto begin = packet.begin() + kHeaderSize + 1;
+    return is_cleartext_plugin(std::string(begin, std::find(begin, packet.end(), 0)));
+  }
+
+  return false;
+}
+
+// result sets are sent to the client in batches of about this size
+const size_t kRelayBatchSize = 16 * 1024;
+
+// payload size of packets which are continued by the next one
+const size_t kMaxPayloadSize = 0xffffff;
+
+// reads a length encoded integer at pos, moving pos behind it
+bool read_lenenc(const RoutingProtocolBuffer &packet, size_t &pos, uint64_t *value) {
+  if (pos >= packet.size()) return false;
+
+  const uint8_t first = packet[pos++];
+  size_t size = 0;
+  switch (first) {
+    case 0xfc: size = 2; break;
+    case 0xfd: size = 3; break;
+    case 0xfe: size = 8; break;
+    case 0xfb:
+    case 0xff: return false;
+    default:
+      *value = first;
+      return true;
+  }
+  if (pos + size > packet.size()) return false;
+
+  *value = 0;
+  for (size_t i = 0; i < size; ++i) {
+    *value |= static_cast<uint64_t>(packet[pos + i]) << (8 * i);
+  }
+  pos += size;
+
+  return true;
+}
+
+// nonce and auth plugin of a protocol 10 greeting
+bool get_greeting_auth(const RoutingProtocolBuffer &greeting, std::vector<uint8_t> &nonce,
+                       std::string &plugin) {
+  const size_t caps_pos = greeting_capabilities_pos(greeting);
+  if (caps_pos == 0 || caps_pos + 8 > greeting.size()) return false;
+
+  // auth-plugin-data-part-1 is in front of the filler and the lower flags
+  nonce.assign(greeting.begin() + static_cast<std::ptrdiff_t>(caps_pos - 9),
+               greeting.begin() + static_cast<std::ptrdiff_t>(caps_pos - 1));
+
+  // lower flags, character set, status flags, upper flags, auth data length,
+  // reserved, auth-plugin-data-part-2 (ends with a NUL)
+  const size_t auth_data_size = greeting[caps_pos + 7];
+  size_t pos = caps_pos + 2 + 1 + 2 + 2 + 1 + 10;
+  const size_t part2_size = std::max<size_t>(13, auth_data_size > 8 ? auth_data_size - 8 : 0);
+  if (pos + part2_size > greeting.size()) return false;
+  nonce.insert(nonce.end(), greeting.begin() + static_cast<std::ptrdiff_t>(pos),
+               greeting.begin() + static_cast<std::ptrdiff_t>(pos + part2_size - 1));
+  pos += part2_size;
+
+  auto plugin_end = std::find(greeting.begin() + static_cast<std::ptrdiff_t>(pos), greeting.end(), 0);
+  plugin.assign(greeting.begin() + static_cast<std::ptrdiff_t>(pos), plugin_end);
+
+  return true;
+}
+
+// auth-response of the given plugin, throws for unsupported plugins
+std::vector<uint8_t> scramble_password(const std::string &plugin, const std::string &password,
+                                       const std::vector<uint8_t> &nonce) {
+  if (plugin == kNativePasswordPlugin) {
+    return classic_auth::scramble_native_password(password, nonce);
+  } else if (plugin == kCachingSha2PasswordPlugin) {
+    return classic_auth::scramble_caching_sha2_password(password, nonce);
+  }
+
+  throw std::runtime_error("Unsupported authentication plugin '" + plugin + "'");
+}
+
+void append_string(RoutingProtocolBuffer &packet, const std::string &value) {
+  packet.insert(packet.end(), value.begin(), value.end());
+  packet.push_back(0);
+}
+
+void append_lenenc(RoutingProtocolBuffer &packet, uint64_t value) {
+  const size_t size = lenenc_size(value);
+  switch (size) {
+    case 1: packet.push_back(static_cast<uint8_t>(value)); return;
+    case 3: packet.push_back(0xfc); break;
+    case 4: packet.push_back(0xfd); break;
+    default: packet.push_back(0xfe); break;
+  }
+  for (size_t i = 0; i < size - 1; ++i) {
+    packet.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+// packet with the given sequence id and payload
+RoutingProtocolBuffer make_packet(uint8_t seq, const std::vector<uint8_t> &payload) {
+  RoutingProtocolBuffer packet{0, 0, 0, seq};
+  packet.insert(packet.end(), payload.begin(), payload.end());
+  update_payload_size(packet);
+  return packet;
+}
+
+void wipe(RoutingProtocolBuffer &packet) {
+  std::fill(packet.begin(), packet.end(), 0);
+}
+
+// plugin name and nonce of an auth-switch request
+bool get_auth_switch(const RoutingProtocolBuffer &packet, std::string &plugin,
+                     std::vector<uint8_t> &nonce) {
+  if (packet.size() <= kHeaderSize || packet[kHeaderSize] != 0xfe) return false;
+
+  auto plugin_end = std::find(packet.begin() + kHeaderSize + 1, packet.end(), 0);
+  if (plugin_end == packet.end()) return false;
+  plugin.assign(packet.begin() + kHeaderSize + 1, plugin_end);
+  nonce.assign(plugin_end + 1, packet.end());
+  if (!nonce.empty() && nonce.back() == 0) nonce.pop_back();
+
+  return true;
+}
+
+// servers reached over a Unix socket accept passwords in clear text
+bool is_unix_socket(int fd) {
+  struct sockaddr_storage addr;
+  socklen_t addr_len = static_cast<socklen_t>(sizeof(addr));
+  return getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &addr_len) == 0 &&
+         addr.ss_family == AF_UNIX;
+}
+
+// caching_sha2_password full authentication over a TCP connection: asks the
+// server for its RSA public key, starting with sequence id seq, and sends
+// the password encrypted with it. If the server sends no key, reply is the
+// packet it sent instead.
+bool send_password_rsa(mysql_harness::SocketOperationsBase *so, int server, uint8_t seq,
+                       const std::string &password, const std::vector<uint8_t> &nonce,
+                       std::chrono::milliseconds timeout, RoutingProtocolBuffer &reply,
+                       const std::string &log_prefix) {
+  RoutingProtocolBuffer packet{1, 0, 0, seq, kRequestPublicKey};
+  if (!write_packet(so, server, nullptr, packet) ||
+      !read_packet(so, server, nullptr, timeout, reply)) {
+    return false;
+  }
+  if (reply.size() <= kHeaderSize + 1 || reply[kHeaderSize] != kAuthMoreData) {
+    log_warning("[%s] fd=%d server sent no RSA public key for caching_sha2_password",
+                log_prefix.c_str(), server);
+    return false;
+  }
+
+  try {
+    const std::string public_key(reply.begin() + kHeaderSize + 1, reply.end());
+    packet = make_packet(static_cast<uint8_t>(reply[3] + 1),
+                         classic_auth::encrypt_password_rsa(password, nonce, public_key));
+  } catch (const std::runtime_error &exc) {
+    log_warning("[%s] fd=%d %s", log_prefix.c_str(), server, exc.what());
+    return false;
+  }
+
+  return write_packet(so, server, nullptr, packet);
+}
+
+}
+
+Flags ClassicProtocol::get_greeting_capabilities(const RoutingProtocolBuffer &greeting) {
+  const size_t pos = greeting_capabilities_pos(greeting);
+  if (pos == 0) return Flags();
+
+  return Flags(static_cast<uint32_t>(greeting[pos]) |
+               static_cast<uint32_t>(greeting[pos + 1]) << 8 |
+               static_cast<uint32_t>(greeting[pos + 5]) << 16 |
+               static_cast<uint32_t>(greeting[pos + 6]) << 24);
+}
+
+bool ClassicProtocol::set_greeting_capabilities(RoutingProtocolBuffer &greeting,
+                                                Flags capabilities) {
+  const size_t pos = greeting_capabilities_pos(greeting);
+  if (pos == 0) return false;
+
+  const uint32_t bits = capabilities.bits();
+  greeting[pos] = static_cast<uint8_t>(bits);
+  greeting[pos + 1] = static_cast<uint8_t>(bits >> 8);
+  greeting[pos + 5] = static_cast<uint8_t>(bits >> 16);
+  greeting[pos + 6] = static_cast<uint8_t>(bits >> 24);
+
+  return true;
+}
+
+bool ClassicProtocol::renew_greeting_scramble(RoutingProtocolBuffer &greeting) {
+  std::vector<uint8_t> nonce;
+  std::string plugin;
+  if (!get_greeting_auth(greeting, nonce, plugin) || nonce.size() < 8) {
+    return false;
+  }
+
+  mysql_harness::RandomGenerator generator;
+  const std::string scramble = generator.generate_identifier(
+      static_cast<unsigned>(nonce.size()),
+      mysql_harness::RandomGenerator::AlphabetDigits |
+      mysql_harness::RandomGenerator::AlphabetLowercase |
+      mysql_harness::RandomGenerator::AlphabetUppercase);
+
+  // auth-plugin-data-part-1 in front of the filler, part-2 behind the
+  // reserved bytes
+  const size_t caps_pos = greeting_capabilities_pos(greeting);
+  std::copy(scramble.begin(), scramble.begin() + 8,
+            greeting.begin() + static_cast<std::ptrdiff_t>(caps_pos - 9));
+  std::copy(scramble.begin() + 8, scramble.end(),
+            greeting.begin() + static_cast<std::ptrdiff_t>(caps_pos + 18));
+
+  return true;
+}
+
+Flags ClassicProtocol::get_response_capabilities(const RoutingProtocolBuffer &response) {
+  if (response.size() < kHeaderSize + 4) return Flags();
+
+  return Flags(static_cast<uint32_t>(response[4]) | static_cast<uint32_t>(response[5]) << 8 |
+               static_cast<uint32_t>(response[6]) << 16 | static_cast<uint32_t>(response[7]) << 24);
+}
+
+bool ClassicProtocol::read_greeting(int server, std::chrono::milliseconds timeout,
+                                    RoutingProtocolBuffer &greeting,
+                                    const std::string &log_prefix) {
+  if (!read_packet(routing_sock_ops_->so(), server, nullptr, timeout, greeting)) {
+    log_debug("[%s] fd=%d reading server greeting failed", log_prefix.c_str(), server);
+    return false;
+  }
+  if (greeting.size() <= kHeaderSize) return false;
+
+  return true;
+}
+
+int ClassicProtocol::accept_client(int client, RoutingProtocolBuffer greeting,
+                                   const ClientTlsContext *tls_context,
+                                   routing::ClientSslMode ssl_mode,
+                                   std::chrono::milliseconds timeout,
+                                   std::unique_ptr<ClientTlsConnection> &client_tls,
+                                   RoutingProtocolBuffer &response,
+                                   const std::string &log_prefix) {
+  mysql_harness::SocketOperationsBase* const so = routing_sock_ops_->so();
+
+  Flags capabilities = get_greeting_capabilities(greeting);
+  if (tls_context) {
+    capabilities.set(kSslFlag);
+  } else {
+    capabilities.clear(kSslFlag);
+  }
+  if (!set_greeting_capabilities(greeting, capabilities)) {
+    log_debug("[%s] fd=%d unexpected server greeting", log_prefix.c_str(), client);
+    return -1;
+  }
+  if (!write_packet(so, client, nullptr, greeting)) return -1;
+
+  // client's SSL request or handshake response
+  if (!read_packet(so, client, nullptr, timeout, response)) return -1;
+  if (response[3] != 1) {
+    log_debug("Received incorrect packet number; aborting (was %d)", response[3]);
+    return -1;
+  }
+
+  if (!get_response_capabilities(response).test(kSslFlag)) {
+    if (ssl_mode == routing::ClientSslMode::kRequired) {
+      send_error(client, 3159, "Connections using insecure transport are prohibited",
+                 "HY000", log_prefix);
+      return -1;
+    }
+    return 0;
+  }
+
+  if (!tls_context || response.size() != kHeaderSize + kSslRequestPayloadSize) {
+    log_debug("[%s] fd=%d unexpected SSL request", log_prefix.c_str(), client);
+    return -1;
+  }
+
+  try {
+    client_tls.reset(new ClientTlsConnection(*tls_context, so, client));
+  } catch (const std::runtime_error &exc) {
+    log_warning("[%s] %s", log_prefix.c_str(), exc.what());
+    return -1;
+  }
+  if (!client_tls->accept(timeout)) return -1;
+
+  // handshake response over TLS; the server doesn't see the SSL request
+  if (!read_packet(so, client, client_tls.get(), timeout, response)) return -1;
+  if (response[3] != 2 || response.size() < kHeaderSize + 4) return -1;
+  response[3] = 1;
+  response[kHeaderSize + 1] = static_cast<uint8_t>(response[kHeaderSize + 1] & ~(kSslFlag.low_16_bits() >> 8));
+
+  return 0;
+}
+
+int ClassicProtocol::authenticate(int client, ClientTlsConnection *client_tls, int server,
+                                  const RoutingProtocolBuffer &greeting,
+                                  const RoutingProtocolBuffer &response, bool change_user,
+                                  bool force_auth_switch, Flags server_capabilities,
+                                  std::chrono::milliseconds timeout, bool *authenticated,
+                                  const std::string &log_prefix, uint16_t *status_flags) {
+  assert(authenticated);
+  mysql_harness::SocketOperationsBase* const so = routing_sock_ops_->so();
+  *authenticated = false;
+
+  RoutingProtocolBuffer packet;
+  if (change_user || force_auth_switch) {
+    try {
+      mysql_protocol::HandshakeResponsePacket parsed(response, true, server_capabilities);
+      if (change_user) {
+        // a forced switch makes the server send a fresh scramble, an auth
+        // response to the router's scramble is of no use to it
+        packet = mysql_protocol::ChangeUserPacket(
+            0, parsed.get_username(),
+            force_auth_switch ? std::vector<uint8_t>() : parsed.get_auth_response(),
+            parsed.get_database(),
+            parsed.get_character_set(),
+            force_auth_switch ? kForceAuthSwitchPlugin : parsed.get_auth_plugin(),
+            parsed.get_connection_attrs(), server_capabilities);
+      } else {
+        packet = response;
+        if (!replace_auth_plugin(packet, parsed,
+                                 get_response_capabilities(response) & server_capabilities,
+                                 kForceAuthSwitchPlugin)) {
+          log_debug("[%s] fd=%d client does not support auth plugins", log_prefix.c_str(), client);
+          return -1;
+        }
+      }
+    } catch (const std::runtime_error &exc) {
+      log_debug("[%s] fd=%d invalid handshake response: %s", log_prefix.c_str(), client, exc.what());
+      return -1;
+    }
+  } else {
+    packet = response;
+  }
+
+  // difference of the sequence ids the client and the server see
+  const int client_seq = client_tls ? 2 : 1;
+  const int server_seq = change_user ? 0 : 1;
+  int seq_offset = client_seq - server_seq;
+
+  // the scramble of caching_sha2_password's RSA encryption; COM_CHANGE_USER
+  // keeps the one of the greeting unless the server switches plugins
+  std::vector<uint8_t> nonce;
+  std::string plugin;
+  get_greeting_auth(greeting, nonce, plugin);
+
+  // The client trusts the TLS connection to the router, but a TCP server
+  // connection is plain: a password in clear text must not be passed on.
+  // caching_sha2_password's full authentication gets it RSA encrypted.
+  const bool cleartext_allowed = client_tls == nullptr || is_unix_socket(server);
+  auto refuse_cleartext_password = [&](uint8_t seq) {
+    log_info("[%s] fd=%d refused authentication sending the password in clear text "
+             "over the unencrypted server connection", log_prefix.c_str(), client);
+    RoutingProtocolBuffer error = mysql_protocol::ErrorPacket(
+        seq, 1251, "Authentication sending the password in clear text is not supported "
+        "for TLS connections terminated by MySQL Router", "08004");
+    write_packet(so, client, client_tls, error);
+    return -1;
+  };
+
+  if (!cleartext_allowed) {
+    try {
+      mysql_protocol::HandshakeResponsePacket parsed(response, true, server_capabilities);
+      if (is_cleartext_plugin(parsed.get_auth_plugin()) &&
+          parsed.get_auth_response().size() > 1) {
+        return refuse_cleartext_password(static_cast<uint8_t>(client_seq + 1));
+      }
+    } catch (const std::runtime_error &) {
+      // old clients without auth plugins, the server decides
+    }
+  }
+
+  if (!write_packet(so, server, nullptr, packet)) return -1;
+
+  // authentication exchange until the server sends OK or Error
+  while (true) {
+    struct pollfd fds[] = {
+      { server, POLLIN, 0 },
+      { client, POLLIN, 0 },
+    };
+    if (client_tls == nullptr || client_tls->pending() == 0) {
+      const int res = so->poll(fds, 2, timeout);
+      if (res == 0) {
+        so->set_errno(ETIMEDOUT);
+        return -1;
+      } else if (res < 0) {
+        if (so->get_errno() == EINTR) continue;
+        return -1;
+      }
+    } else {
+      fds[1].revents = POLLIN;
+    }
+
+    if (fds[0].revents & (POLLIN|POLLHUP)) {
+      if (!read_packet(so, server, nullptr, timeout, packet)) return -1;
+      get_auth_switch(packet, plugin, nonce);
+      packet[3] = static_cast<uint8_t>(packet[3] + seq_offset);
+      if (!cleartext_allowed && requests_cleartext_password(packet)) {
+        if (!is_full_auth_request(packet) || !classic_auth::has_rsa_password_encryption()) {
+          return refuse_cleartext_password(packet[3]);
+        }
+
+        // the client sends its password over TLS, the server gets it encrypted
+        if (!write_packet(so, client, client_tls, packet) ||
+            !read_packet(so, client, client_tls, timeout, packet)) {
+          return -1;
+        }
+        const uint8_t seq = static_cast<uint8_t>(packet[3] - seq_offset);
+        std::string password(packet.begin() + kHeaderSize,
+                             std::find(packet.begin() + kHeaderSize, packet.end(), 0));
+        wipe(packet);
+        const bool sent = send_password_rsa(so, server, seq, password, nonce, timeout,
+                                            packet, log_prefix);
+        std::fill(password.begin(), password.end(), 0);
+        if (sent) {
+          // the client doesn't see the public key request and its reply
+          seq_offset -= 2;
+          continue;
+        }
+        if (!is_ok_or_error(packet)) return -1;
+        packet[3] = static_cast<uint8_t>(packet[3] + seq_offset);
+      }
+      if (!write_packet(so, client, client_tls, packet)) return -1;
+
+      if (is_ok_or_error(packet)) {
+        *authenticated = packet[kHeaderSize] == 0x00;
+        if (*authenticated && status_flags) get_ok_status_flags(packet, status_flags);
+        return 0;
+      }
+    }
+
+    if (fds[1].revents & (POLLIN|POLLHUP)) {
+      if (!read_packet(so, client, client_tls, timeout, packet)) return -1;
+      packet[3] = static_cast<uint8_t>(packet[3] - seq_offset);
+      if (!write_packet(so, server, nullptr, packet)) return -1;
+    }
+  }
+}
+
+bool ClassicProtocol::reset_session(int server, std::chrono::milliseconds timeout,
+                                    const std::string &log_prefix) {
+  mysql_harness::SocketOperationsBase* const so = routing_sock_ops_->so();
+
+  RoutingProtocolBuffer reset{1, 0, 0, 0, mysql_protocol::Command::RESET_CONNECTION};
+  RoutingProtocolBuffer packet;
+  if (!write_packet(so, server, nullptr, reset) ||
+      !read_packet(so, server, nullptr, timeout, packet)) {
+    log_debug("[%s] fd=%d resetting session failed: %s", log_prefix.c_str(), server,
+              get_message_error(so->get_errno()).c_str());
+    return false;
+  }
+
+  // anything but a lone OK means the connection was not idle
+  struct pollfd fds[] = {
+    { server, POLLIN, 0 },
+  };
+  uint16_t status_flags = 0;
+  if (!get_ok_status_flags(packet, &status_flags) || packet[kHeaderSize] != 0x00 ||
+      (status_flags & mysql_protocol::ServerStatus::MORE_RESULTS_EXISTS) ||
+      so->poll(fds, 1, std::chrono::milliseconds::zero()) != 0) {
+    log_debug("[%s] fd=%d unexpected reply resetting session", log_prefix.c_str(), server);
+    return false;
+  }
+
+  return true;
+}
+
+int ClassicProtocol::login(int server, const RoutingProtocolBuffer &greeting,
+                           const RoutingProtocolBuffer &response, const std::string &password,
+                           std::chrono::milliseconds timeout, RoutingProtocolBuffer &reply,
+                           const std::string &log_prefix) {
+  mysql_harness::SocketOperationsBase* const so = routing_sock_ops_->so();
+  const Flags server_capabilities = get_greeting_capabilities(greeting);
+
+  std::vector<uint8_t> nonce;
+  std::string plugin;
+  if (!get_greeting_auth(greeting, nonce, plugin)) {
+    log_debug("[%s] fd=%d unexpected server greeting", log_prefix.c_str(), server);
+    return -1;
+  }
+  if (plugin != kNativePasswordPlugin) {
+    // the server switches to the plugin of the account if it is another one
+    plugin = kCachingSha2PasswordPlugin;
+  }
+
+  RoutingProtocolBuffer packet{0, 0, 0, 1};
+  try {
+    mysql_protocol::HandshakeResponsePacket parsed(response, true, server_capabilities);
+
+    // the auth-response is never longer than 250 bytes
+    Flags capabilities = get_response_capabilities(response) & server_capabilities;
+    capabilities.clear(kSslFlag);
+    capabilities.clear(mysql_protocol::Capabilities::PLUGIN_AUTH_LENENC_CLIENT_DATA);
+    capabilities.set(mysql_protocol::Capabilities::SECURE_CONNECTION);
+
+    const uint32_t bits = capabilities.bits();
+    const uint32_t max_packet_size = parsed.get_max_packet_size();
+    for (size_t i = 0; i < 4; ++i) packet.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+    for (size_t i = 0; i < 4; ++i) packet.push_back(static_cast<uint8_t>(max_packet_size >> (8 * i)));
+    packet.push_back(parsed.get_character_set());
+    packet.resize(packet.size() + 23, 0);
+    append_string(packet, parsed.get_username());
+
+    const std::vector<uint8_t> auth_response = scramble_password(plugin, password, nonce);
+    packet.push_back(static_cast<uint8_t>(auth_response.size()));
+    packet.insert(packet.end(), auth_response.begin(), auth_response.end());
+
+    if (capabilities.test(mysql_protocol::Capabilities::CONNECT_WITH_DB)) {
+      append_string(packet, parsed.get_database());
+    }
+    if (capabilities.test(mysql_protocol::Capabilities::PLUGIN_AUTH)) {
+      append_string(packet, plugin);
+    }
+    if (capabilities.test(mysql_protocol::Capabilities::CONNECT_ATTRS)) {
+      const auto &attrs = parsed.get_connection_attrs();
+      append_lenenc(packet, attrs.size());
+      packet.insert(packet.end(), attrs.begin(), attrs.end());
+    }
+  } catch (const std::runtime_error &exc) {
+    log_warning("[%s] fd=%d logging into server failed: %s", log_prefix.c_str(), server, exc.what());
+    return -1;
+  }
+  update_payload_size(packet);
+  if (!write_packet(so, server, nullptr, packet)) return -1;
+
+  // over Unix sockets the server accepts the password in clear text
+  const bool secure_transport = is_unix_socket(server);
+
+  while (true) {
+    if (!read_packet(so, server, nullptr, timeout, reply) || reply.size() <= kHeaderSize) {
+      log_debug("[%s] fd=%d reading login reply failed", log_prefix.c_str(), server);
+      return -1;
+    }
+    const uint8_t seq = static_cast<uint8_t>(reply[3] + 1);
+
+    if (is_ok_or_error(reply)) return 0;
+
+    if (reply[kHeaderSize] == 0xfe) {
+      // auth-switch request: plugin name and a new nonce
+      if (!get_auth_switch(reply, plugin, nonce)) return -1;
+
+      try {
+        packet = make_packet(seq, scramble_password(plugin, password, nonce));
+      } catch (const std::runtime_error &exc) {
+        log_warning("[%s] fd=%d logging into server failed: %s", log_prefix.c_str(), server, exc.what());
+        return -1;
+      }
+    } else if (reply[kHeaderSize] == kAuthMoreData && reply.size() == kHeaderSize + 2 &&
+               reply[kHeaderSize + 1] == kFastAuthSuccess) {
+      // OK follows
+      continue;
+    } else if (reply[kHeaderSize] == kAuthMoreData && reply.size() == kHeaderSize + 2 &&
+               reply[kHeaderSize + 1] == kPerformFullAuth) {
+      if (!secure_transport) {
+        if (!classic_auth::has_rsa_password_encryption()) {
+          log_warning("[%s] fd=%d skipping server: caching_sha2_password asks for full "
+                      "authentication, which needs a Unix socket (local_sockets) or "
+                      "MySQL Router built with OpenSSL", log_prefix.c_str(), server);
+          return -1;
+        }
+        if (send_password_rsa(so, server, seq, password, nonce, timeout, reply, log_prefix)) {
+          continue;
+        }
+        if (is_ok_or_error(reply)) return 0;
+        log_warning("[%s] fd=%d skipping server: caching_sha2_password full authentication "
+                    "with the server's RSA public key failed", log_prefix.c_str(), server);
+        return -1;
+      }
+      packet = make_packet(seq, std::vector<uint8_t>(password.begin(), password.end()));
+      packet.push_back(0);
+      update_payload_size(packet);
+    } else {
+      log_debug("[%s] fd=%d unexpected login reply", log_prefix.c_str(), server);
+      return -1;
+    }
+
+    const bool written = write_packet(so, server, nullptr, packet);
+    wipe(packet);
+    if (!written) return -1;
+  }
+}
+
+bool ClassicProtocol::read_command(int client, ClientTlsConnection *client_tls,
+                                   std::chrono::milliseconds timeout,
+                                   RoutingProtocolBuffer &packet) {
+  return read_packet(routing_sock_ops_->so(), client, client_tls, timeout, packet);
+}
+
+int ClassicProtocol::relay_command(int client, ClientTlsConnection *client_tls, int server,
+                                   RoutingProtocolBuffer &command, Flags capabilities,
+                                   std::chrono::milliseconds timeout, uint16_t *status_flags,
+                                   size_t *bytes_relayed, const std::string &log_prefix) {
+  assert(status_flags);
+  assert(bytes_relayed);
+  mysql_harness::SocketOperationsBase* const so = routing_sock_ops_->so();
+  *bytes_relayed = 0;
+
+  if (!write_packet(so, server, nullptr, command)) return -1;
+
+  enum class State { kFirst, kColumns, kColumnsEof, kRows };
+  State state = State::kFirst;
+  uint64_t columns = 0;
+  bool continued = false;
+  const bool deprecate_eof = capabilities.test(mysql_protocol::Capabilities::DEPRECATE_EOF);
+
+  RoutingProtocolBuffer batch;
+  RoutingProtocolBuffer packet;
+  auto flush = [&]() {
+    if (batch.empty()) return true;
+    if (!write_packet(so, client, client_tls, batch)) return false;
+    *bytes_relayed += batch.size();
+    batch.clear();
+    return true;
+  };
+
+  while (true) {
+    if (!read_packet(so, server, nullptr, timeout, packet)) {
+      log_debug("[%s] fd=%d reading response failed", log_prefix.c_str(), server);
+      return -1;
+    }
+    batch.insert(batch.end(), packet.begin(), packet.end());
+
+    const size_t payload_size = packet.size() - kHeaderSize;
+    const bool is_continuation = continued;
+    continued = payload_size == kMaxPayloadSize;
+    if (is_continuation || payload_size == 0) {
+      if (batch.size() >= kRelayBatchSize && !flush()) return -1;
+      continue;
+    }
+
+    const uint8_t first = packet[kHeaderSize];
+    bool end_of_result = false;
+    switch (state) {
+      case State::kFirst:
+        if (first == 0x00 || first == 0xff) {
+          end_of_result = true;
+        } else if (first == 0xfb) {
+          log_warning("[%s] fd=%d LOCAL INFILE is not supported with read-write splitting",
+                      log_prefix.c_str(), server);
+          return -1;
+        } else {
+          size_t pos = kHeaderSize;
+          if (!read_lenenc(packet, pos, &columns) || columns == 0) return -1;
+          state = State::kColumns;
+        }
+        break;
+      case State::kColumns:
+        if (--columns == 0) state = deprecate_eof ? State::kRows : State::kColumnsEof;
+        break;
+      case State::kColumnsEof:
+        state = State::kRows;
+        break;
+      case State::kRows:
+        // rows starting with 0xfe are at least as long as kMaxPayloadSize
+        end_of_result = first == 0xff ||
+                        (first == 0xfe && payload_size < (deprecate_eof ? kMaxPayloadSize : 9));
+        break;
+    }
+
+    if (!end_of_result) {
+      if (batch.size() >= kRelayBatchSize && !flush()) return -1;
+      continue;
+    }
+
+    uint16_t flags = 0;
+    bool has_flags = false;
+    if (first == 0xfe && !deprecate_eof) {
+      // EOF: warning count, status flags
+      has_flags = payload_size >= 5;
+      if (has_flags) {
+        flags = static_cast<uint16_t>(packet[kHeaderSize + 3] | packet[kHeaderSize + 4] << 8);
+      }
+    } else if (first != 0xff) {
+      has_flags = get_ok_status_flags(packet, &flags);
+    }
+    if (has_flags) *status_flags = flags;
+
+    if (has_flags && (flags & mysql_protocol::ServerStatus::MORE_RESULTS_EXISTS)) {
+      state = State::kFirst;
+      continue;
+    }
+
+    return flush() ? 0 : -1;
+  }
+}
+
+bool ClassicProtocol::get_ok_status_flags(const RoutingProtocolBuffer &packet,
+                                          uint16_t *status_flags) {
+  if (packet.size() < kHeaderSize + 7 ||
+      (packet[kHeaderSize] != 0x00 && packet[kHeaderSize] != 0xfe)) {
+    return false;
+  }
+
+  // affected rows and last insert id precede the status flags
+  size_t pos = kHeaderSize + 1;
+  uint64_t value;
+  if (!read_lenenc(packet, pos, &value) || !read_lenenc(packet, pos, &value) ||
+      pos + 2 > packet.size()) {
+    return false;
+  }
+  *status_flags = static_cast<uint16_t>(packet[pos] | packet[pos + 1] << 8);
+
+  return true;
+}
+
+int ClassicProtocol::handshake_client_tls(int client, int server,
+                                          const ClientTlsContext &tls_context,
+                                          routing::ClientSslMode ssl_mode,
+                                          std::chrono::milliseconds timeout,
+                                          std::unique_ptr<ClientTlsConnection> &client_tls,
+                                          int *curr_pktnr, const std::string &log_prefix) {
+  assert(curr_pktnr);
+  mysql_harness::SocketOperationsBase* const so = routing_sock_ops_->so();
+
+  RoutingProtocolBuffer greeting;
+  if (!read_greeting(server, timeout, greeting, log_prefix)) return -1;
+  if (greeting[kHeaderSize] == 0xff) {
+    // error from the server, e.g. too many connections: pass it on
+    write_packet(so, client, nullptr, greeting);
+    *curr_pktnr = 2;
+    return 0;
+  }
+
+  RoutingProtocolBuffer response;
+  if (accept_client(client, greeting, &tls_context, ssl_mode, timeout, client_tls,
+                    response, log_prefix) == -1) {
+    return -1;
+  }
+
+  if (!client_tls) {
+    // plain client: leave the rest of the handshake to copy_packets()
+    if (!write_packet(so, server, nullptr, response)) return -1;
+    *curr_pktnr = 1;
+    return 0;
+  }
+
+  bool authenticated;
+  if (authenticate(client, client_tls.get(), server, greeting, response, false, false,
+                   get_greeting_capabilities(greeting), timeout, &authenticated,
+                   log_prefix) == -1) {
+    return -1;
+  }
+
+  *curr_pktnr = 2;
+  return 0;
+}
+
+size_t ClassicSessionTracker::PacketSplitter::consume(const uint8_t *data, size_t size,
+                                                      bool *complete) {
+  *complete = false;
+  size_t pos = 0;
+  while (pos < size) {
+    if (header_pos_ < sizeof(header_)) {
+      header_[header_pos_++] = data[pos++];
+      if (header_pos_ < sizeof(header_)) continue;
+
+      remaining_ = static_cast<size_t>(header_[0]) |
+                   static_cast<size_t>(header_[1]) << 8 |
+                   static_cast<size_t>(header_[2]) << 16;
+      if (!continued_) {
+        packet_.assign(header_, header_ + sizeof(header_));
+        payload_size_ = remaining_;
+      }
+    } else {
+      const size_t n = std::min(remaining_, size - pos);
+      if (!continued_ && packet_.size() < kHeaderSize + kPrefixSize) {
+        const size_t keep = std::min(n, kHeaderSize + kPrefixSize - packet_.size());
+        packet_.insert(packet_.end(), data + pos, data + pos + keep);
+      }
+      remaining_ -= n;
+      pos += n;
+    }
+
+    if (remaining_ == 0) {
+      // end of a packet, packets of the max size are continued by the next
+      header_pos_ = 0;
+      continued_ = (static_cast<size_t>(header_[0]) |
+                    static_cast<size_t>(header_[1]) << 8 |
+                    static_cast<size_t>(header_[2]) << 16) == kMaxPayloadSize;
+      if (!continued_) {
+        *complete = true;
+        return pos;
+      }
+    }
+  }
+
+  return pos;
+}
+
+void ClassicSessionTracker::update_client(const uint8_t *data, size_t size) {
+  while (size > 0) {
+    bool complete;
+    const size_t n = client_.consume(data, size, &complete);
+    if (complete) on_client_packet(client_.packet(), client_.payload_size());
+    data += n;
+    size -= n;
+  }
+}
+
+void ClassicSessionTracker::update_server(const uint8_t *data, size_t size) {
+  while (size > 0) {
+    bool complete;
+    const size_t n = server_.consume(data, size, &complete);
+    if (complete) on_server_packet(server_.packet(), server_.payload_size());
+    data += n;
+    size -= n;
+  }
+}
+
+void ClassicSessionTracker::on_client_packet(const RoutingProtocolBuffer &packet,
+                                             size_t payload_size) {
+  if (state_ == State::kLocalInfile) {
+    // an empty packet ends the file, the server answers with OK or Error
+    if (payload_size == 0) state_ = State::kCommand;
+    return;
+  }
+
+  // a command before the response to the last one is pipelined
+  if (state_ != State::kIdle || payload_size == 0) {
+    state_ = State::kUnknown;
+    return;
+  }
+
+  switch (packet[kHeaderSize]) {
+    case mysql_protocol::Command::STMT_SEND_LOG_DATA:
+    case mysql_protocol::Command::STMT_CLOSE:
+      // no response
+      break;
+    case mysql_protocol::Command::STMT_PREPARE:
+      state_ = State::kPrepare;
+      break;
+    case mysql_protocol::Command::STMT_EXECUTE:
+      // statement id, flags: a cursor type leaves the rows for COM_STMT_FETCH
+      state_ = packet.size() > kHeaderSize + 5 && (packet[kHeaderSize + 5] & 0x07) == 0
+                   ? State::kCommand : State::kUnknown;
+      break;
+    case mysql_protocol::Command::STMT_FETCH:
+      state_ = State::kRows;
+      break;
+    case mysql_protocol::Command::FIELD_LIST:
+      state_ = State::kFieldList;
+      break;
+    case mysql_protocol::Command::STATISTICS:
+      state_ = State::kStatistics;
+      break;
+    case mysql_protocol::Command::QUIT:
+    case mysql_protocol::Command::CONNECT:
+    case mysql_protocol::Command::TIME:
+    case mysql_protocol::Command::DELAYED_INSERT:
+    case mysql_protocol::Command::CHANGE_USER:
+    case mysql_protocol::Command::BINLOG_DUMP:
+    case mysql_protocol::Command::TABLE_DUMP:
+    case mysql_protocol::Command::CONNECT_OUT:
+    case mysql_protocol::Command::DAEMON:
+    case mysql_protocol::Command::BINLOG_DUMP_GTID:
+      state_ = State::kUnknown;
+      break;
+    default:
+      state_ = State::kCommand;
+      break;
+  }
+}
+
+void ClassicSessionTracker::on_server_packet(const RoutingProtocolBuffer &packet,
+                                             size_t payload_size) {
+  if (payload_size == 0) {
+    state_ = State::kUnknown;
+    return;
+  }
+  const uint8_t first = packet[kHeaderSize];
+
+  switch (state_) {
+    case State::kIdle:
+    case State::kLocalInfile:
+    case State::kUnknown:
+      state_ = State::kUnknown;
+      break;
+    case State::kStatistics:
+      state_ = State::kIdle;
+      break;
+    case State::kCommand:
+      if (first == 0xff) {
+        state_ = State::kIdle;
+      } else if (first == 0x00 || first == 0xfe) {
+        state_ = after_status(packet, payload_size);
+      } else if (first == 0xfb) {
+        state_ = State::kLocalInfile;
+      } else {
+        size_t pos = kHeaderSize;
+        if (!read_lenenc(packet, pos, &packets_left_) || packets_left_ == 0) {
+          state_ = State::kUnknown;
+        } else {
+          state_ = State::kColumns;
+        }
+      }
+      break;
+    case State::kPrepare:
+      if (first == 0xff) {
+        state_ = State::kIdle;
+      } else if (first == 0x00 && packet.size() >= kHeaderSize + 9) {
+        // statement id, number of columns, number of parameters
+        const uint64_t columns = packet[kHeaderSize + 5] | packet[kHeaderSize + 6] << 8;
+        const uint64_t params = packet[kHeaderSize + 7] | packet[kHeaderSize + 8] << 8;
+        packets_left_ = columns + params;
+        if (!deprecate_eof_) {
+          packets_left_ += (columns > 0 ? 1 : 0) + (params > 0 ? 1 : 0);
+        }
+        state_ = packets_left_ == 0 ? State::kIdle : State::kDefinitions;
+      } else {
+        state_ = State::kUnknown;
+      }
+      break;
+    case State::kDefinitions:
+      if (--packets_left_ == 0) state_ = State::kIdle;
+      break;
+    case State::kFieldList:
+      if (first == 0xff || (first == 0xfe && payload_size < 9)) state_ = State::kIdle;
+      break;
+    case State::kColumns:
+      if (--packets_left_ == 0) state_ = deprecate_eof_ ? State::kRows : State::kColumnsEof;
+      break;
+    case State::kColumnsEof:
+      state_ = first == 0xfe && payload_size < 9 ? State::kRows : State::kUnknown;
+      break;
+    case State::kRows:
+      // rows starting with 0xfe are at least as long as kMaxPayloadSize
+      if (first == 0xff) {
+        state_ = State::kIdle;
+      } else if (first == 0xfe && payload_size < kMaxPayloadSize) {
+        state_ = after_status(packet, payload_size);
+      }
+      break;
+  }
+}
+
+ClassicSessionTracker::State ClassicSessionTracker::after_status(
+    const RoutingProtocolBuffer &packet, size_t payload_size) const {
+  uint16_t flags = 0;
+  if (packet[kHeaderSize] == 0xfe && !deprecate_eof_) {
+    // EOF: warning count, status flags
+    if (payload_size < 5 || packet.size() < kHeaderSize + 5) return State::kUnknown;
+    flags = static_cast<uint16_t>(packet[kHeaderSize + 3] | packet[kHeaderSize + 4] << 8);
+  } else if (!ClassicProtocol::get_ok_status_flags(packet, &flags)) {
+    return State::kUnknown;
+  }
+
+  return (flags & mysql_protocol::ServerStatus::MORE_RESULTS_EXISTS) ? State::kCommand
+                                                                     : State::kIdle;
+}
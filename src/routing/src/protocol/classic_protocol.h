@@ -26,9 +26,15 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define ROUTING_CLASSICPROTOCOL_INCLUDED
 
 #include "base_protocol.h"
+#include "mysqlrouter/routing.h"
 
+#include <chrono>
+#include <memory>
 #include <string>
 
+class ClientTlsConnection;
+class ClientTlsContext;
+
 class ClassicProtocol: public BaseProtocol {
 public:
   ClassicProtocol(routing::RoutingSockOpsInterface *routing_sock_ops)
@@ -94,10 +100,336 @@ public:
                           const std::string &sql_state,
                           const std::string &log_prefix) override;
 
+  /** @brief Runs the handshake with client TLS terminated by the router
+   *
+   * The router announces SSL support to the client. If the client asks to
+   * switch to SSL, the TLS handshake is done with the router and the
+   * decrypted handshake response is sent to the server over the plain
+   * connection; the SSL capability is removed from it and the sequence ids
+   * are adjusted for the SSL request packet that the server never saw.
+   * The authentication exchange that follows is relayed the same way until
+   * the server sends OK or Error.
+   *
+   * If the client doesn't ask for SSL, its handshake response is relayed
+   * unchanged (ClientSslMode::kPreferred) or refused
+   * (ClientSslMode::kRequired); the rest of the handshake is then left to
+   * copy_packets().
+   *
+   * @param client Descriptor of the client
+   * @param server Descriptor of the server
+   * @param tls_context TLS settings of the route
+   * @param ssl_mode ClientSslMode::kPreferred or ClientSslMode::kRequired
+   * @param timeout max time to wait for a packet
+   * @param client_tls [out] TLS connection to the client; empty if the
+   *                   client didn't switch to SSL
+   * @param curr_pktnr [out] 2 if the handshake is done, otherwise sequence
+   *                   id of the last relayed packet
+   * @param log_prefix prefix to be used by the function as a tag for logging
+   *
+   * @return 0 on success; -1 on error
+   */
+  int handshake_client_tls(int client, int server,
+                           const ClientTlsContext &tls_context,
+                           routing::ClientSslMode ssl_mode,
+                           std::chrono::milliseconds timeout,
+                           std::unique_ptr<ClientTlsConnection> &client_tls,
+                           int *curr_pktnr, const std::string &log_prefix);
+
+  /** @brief Reads the greeting of a server
+   *
+   * @param server Descriptor of the server
+   * @param timeout max time to wait for the greeting
+   * @param greeting [out] the greeting packet, or the Error packet the
+   *                 server sent instead
+   * @param log_prefix prefix to be used by the function as a tag for logging
+   *
+   * @return true on success; false on error
+   */
+  bool read_greeting(int server, std::chrono::milliseconds timeout,
+                     RoutingProtocolBuffer &greeting, const std::string &log_prefix);
+
+  /** @brief Sends a server greeting to the client and reads its handshake response
+   *
+   * The SSL capability of the greeting is set if tls_context is given and
+   * cleared otherwise; the other capabilities are sent as they are. If the
+   * client switches to SSL, the TLS handshake is done and the handshake
+   * response is read over TLS. The response is returned with the SSL
+   * capability cleared and sequence id 1, as if there was no SSL request.
+   *
+   * @param client Descriptor of the client
+   * @param greeting server greeting to send
+   * @param tls_context TLS settings of the route, nullptr if the router
+   *                    doesn't offer TLS
+   * @param ssl_mode ClientSslMode::kRequired refuses plain clients
+   * @param timeout max time to wait for a packet
+   * @param client_tls [out] TLS connection to the client; empty if the
+   *                   client didn't switch to SSL
+   * @param response [out] handshake response of the client
+   * @param log_prefix prefix to be used by the function as a tag for logging
+   *
+   * @return 0 on success; -1 on error
+   */
+  int accept_client(int client, RoutingProtocolBuffer greeting,
+                    const ClientTlsContext *tls_context,
+                    routing::ClientSslMode ssl_mode,
+                    std::chrono::milliseconds timeout,
+                    std::unique_ptr<ClientTlsConnection> &client_tls,
+                    RoutingProtocolBuffer &response, const std::string &log_prefix);
+
+  /** @brief Authenticates the client at the server
+   *
+   * Sends the client's handshake response to the server, either as it is
+   * (server connection in handshake phase) or as COM_CHANGE_USER (server
+   * connection authenticated before, capabilities given by
+   * server_capabilities). The authentication exchange is then relayed
+   * until the server sends OK or Error, adjusting the sequence ids on the
+   * way.
+   *
+   * With force_auth_switch the client's auth plugin name is replaced, which
+   * makes the server restart the authentication with an auth-switch request
+   * carrying its own scramble. This is needed if the client computed its
+   * auth-response for another server connection.
+   *
+   * @param client Descriptor of the client
+   * @param client_tls TLS connection to the client or nullptr
+   * @param server Descriptor of the server
+   * @param greeting greeting of the server connection
+   * @param response handshake response as returned by accept_client()
+   * @param change_user true to send COM_CHANGE_USER
+   * @param force_auth_switch true to make the server restart authentication
+   * @param server_capabilities capabilities the server connection uses
+   * @param timeout max time to wait for a packet
+   * @param authenticated [out] true if the server accepted the client
+   * @param log_prefix prefix to be used by the function as a tag for logging
+   * @param status_flags [out] if set, the server status of the OK packet
+   *
+   * If the client talks TLS with the router and the server is connected
+   * over TCP, its password must not be passed on in clear text. For
+   * caching_sha2_password full authentication the router takes the password
+   * from the client and sends it encrypted with the server's RSA public key
+   * (OpenSSL builds only). Other such authentication (sha256_password,
+   * mysql_clear_password) is refused with an error to the client.
+   *
+   * @return 0 on success (also if the server refused the client); -1 on error
+   */
+  int authenticate(int client, ClientTlsConnection *client_tls, int server,
+                   const RoutingProtocolBuffer &greeting,
+                   const RoutingProtocolBuffer &response, bool change_user,
+                   bool force_auth_switch,
+                   mysql_protocol::Capabilities::Flags server_capabilities,
+                   std::chrono::milliseconds timeout, bool *authenticated,
+                   const std::string &log_prefix, uint16_t *status_flags = nullptr);
+
+  /** @brief Resets the session of an idle server connection
+   *
+   * Sends COM_RESET_CONNECTION and expects nothing but its OK packet.
+   *
+   * @param server Descriptor of the server
+   * @param timeout max time to wait for the reply
+   * @param log_prefix prefix to be used by the function as a tag for logging
+   *
+   * @return true if the session was reset; false otherwise
+   */
+  bool reset_session(int server, std::chrono::milliseconds timeout,
+                     const std::string &log_prefix);
+
+  /** @brief Logs into a server with the password of an account
+   *
+   * Sends a handshake response built from the client's one, with the
+   * auth-response computed by the router. mysql_native_password and
+   * caching_sha2_password are supported. Full authentication of the latter
+   * sends the password in clear text over Unix sockets and encrypted with
+   * the server's RSA public key over TCP. Without RSA support (yaSSL
+   * builds) the login fails over TCP unless the server has the account in
+   * its cache, and the server is skipped with a warning.
+   *
+   * @param server Descriptor of the server, in handshake phase
+   * @param greeting greeting of the server
+   * @param response handshake response of the client as returned by
+   *                 accept_client()
+   * @param password password of the account
+   * @param timeout max time to wait for a packet
+   * @param reply [out] OK or Error packet of the server
+   * @param log_prefix prefix to be used by the function as a tag for logging
+   *
+   * @return 0 on success (also if the server refused the login); -1 on error
+   */
+  int login(int server, const RoutingProtocolBuffer &greeting,
+            const RoutingProtocolBuffer &response, const std::string &password,
+            std::chrono::milliseconds timeout, RoutingProtocolBuffer &reply,
+            const std::string &log_prefix);
+
+  /** @brief Reads a command packet of the client
+   *
+   * @param client Descriptor of the client
+   * @param client_tls TLS connection to the client or nullptr
+   * @param timeout max time to wait for the packet
+   * @param packet [out] the packet
+   *
+   * @return true on success; false on error or if the client closed the connection
+   */
+  bool read_command(int client, ClientTlsConnection *client_tls,
+                    std::chrono::milliseconds timeout, RoutingProtocolBuffer &packet);
+
+  /** @brief Sends a command to the server and relays its response to the client
+   *
+   * Follows the response to find its end: OK, Error, result sets (also
+   * multiple ones) and packets split for their size. The packets are
+   * relayed unchanged, in batches. LOCAL INFILE requests are not supported.
+   *
+   * @param client Descriptor of the client
+   * @param client_tls TLS connection to the client or nullptr
+   * @param server Descriptor of the server
+   * @param command command packet to send, not continued in further packets
+   * @param capabilities capabilities of the session
+   * @param timeout max time to wait for a packet of the server
+   * @param status_flags [out] server status of the last OK or EOF packet,
+   *                     unchanged if there was none
+   * @param bytes_relayed [out] bytes sent to the client
+   * @param log_prefix prefix to be used by the function as a tag for logging
+   *
+   * @return 0 on success; -1 on error
+   */
+  int relay_command(int client, ClientTlsConnection *client_tls, int server,
+                    RoutingProtocolBuffer &command,
+                    mysql_protocol::Capabilities::Flags capabilities,
+                    std::chrono::milliseconds timeout, uint16_t *status_flags,
+                    size_t *bytes_relayed, const std::string &log_prefix);
+
+  /** @brief Gets the server status of an OK packet
+   *
+   * @return false if packet is no OK packet
+   */
+  static bool get_ok_status_flags(const RoutingProtocolBuffer &packet, uint16_t *status_flags);
+
+  /** @brief Returns capabilities announced in a server greeting */
+  static mysql_protocol::Capabilities::Flags get_greeting_capabilities(
+      const RoutingProtocolBuffer &greeting);
+
+  /** @brief Returns capabilities of a handshake response */
+  static mysql_protocol::Capabilities::Flags get_response_capabilities(
+      const RoutingProtocolBuffer &response);
+
+  /** @brief Sets capabilities announced in a server greeting
+   *
+   * @return false if greeting is not a valid protocol 10 greeting
+   */
+  static bool set_greeting_capabilities(RoutingProtocolBuffer &greeting,
+                                        mysql_protocol::Capabilities::Flags capabilities);
+
+  /** @brief Replaces the scramble (auth-plugin-data) of a server greeting
+   *
+   * The new scramble is random and as long as the old one.
+   *
+   * @param greeting protocol 10 greeting
+   * @return false if greeting is not a valid protocol 10 greeting
+   */
+  static bool renew_greeting_scramble(RoutingProtocolBuffer &greeting);
+
   /** @brief Gets protocol type. */
   virtual Type get_type() override {
     return Type::kClassicProtocol;
   }
 };
 
+/** @class ClassicSessionTracker
+ * @brief Follows the protocol state of a session after the handshake
+ *
+ * Data relayed after the handshake is fed to update_client() and
+ * update_server() in the order and chunks it was relayed. The tracker
+ * splits it into packets and follows the command phase: commands, result
+ * sets, prepared statement metadata, LOCAL INFILE requests and multiple
+ * results. Anything it can't follow (pipelined commands, COM_CHANGE_USER,
+ * binlog dumps, cursors, unexpected packets) puts it into a sticky unknown
+ * state in which the session is never idle.
+ *
+ * Compressed sessions and sessions with optional result set metadata can't
+ * be tracked.
+ */
+class ClassicSessionTracker {
+ public:
+  /** @brief Constructor
+   *
+   * @param deprecate_eof true if the session uses CLIENT_DEPRECATE_EOF
+   */
+  explicit ClassicSessionTracker(bool deprecate_eof) : deprecate_eof_(deprecate_eof) {}
+
+  /** @brief Accounts data relayed from the client to the server */
+  void update_client(const uint8_t *data, size_t size);
+
+  /** @brief Accounts data relayed from the server to the client */
+  void update_server(const uint8_t *data, size_t size);
+
+  /** @brief true if the server answered all commands and no packet is in
+   *         transfer in either direction
+   */
+  bool is_idle() const {
+    return state_ == State::kIdle && client_.at_boundary() && server_.at_boundary();
+  }
+
+ private:
+  /** @brief Splits one direction into packets
+   *
+   * Keeps the header and the start of the payload of the packet in
+   * transfer; packets of 0xffffff bytes and their continuations count as
+   * one.
+   */
+  class PacketSplitter {
+   public:
+    static constexpr size_t kPrefixSize = 32;
+
+    /** @brief Consumes data up to the end of the next packet
+     *
+     * @return number of bytes consumed; if a packet ended, complete is set
+     */
+    size_t consume(const uint8_t *data, size_t size, bool *complete);
+
+    bool at_boundary() const {
+      return header_pos_ == 0 && remaining_ == 0 && !continued_;
+    }
+
+    /** @brief header and start of the payload of the last complete packet */
+    const RoutingProtocolBuffer &packet() const { return packet_; }
+
+    /** @brief payload size of the first part of the last complete packet */
+    size_t payload_size() const { return payload_size_; }
+
+   private:
+    uint8_t header_[mysql_protocol::Packet::kHeaderSize];
+    size_t header_pos_{0};
+    size_t remaining_{0};
+    bool continued_{false};
+
+    RoutingProtocolBuffer packet_;
+    size_t payload_size_{0};
+  };
+
+  enum class State {
+    kIdle,
+    kCommand,          // awaiting the (next) response to a command
+    kPrepare,          // awaiting the response to COM_STMT_PREPARE
+    kColumns,          // column definitions of a result set
+    kColumnsEof,       // EOF after the column definitions
+    kRows,             // rows until EOF, OK or Error
+    kDefinitions,      // parameter and column definitions of a prepare
+    kFieldList,        // column definitions until EOF or Error
+    kStatistics,       // single string packet
+    kLocalInfile,      // client sends a file until an empty packet
+    kUnknown,
+  };
+
+  void on_client_packet(const RoutingProtocolBuffer &packet, size_t payload_size);
+  void on_server_packet(const RoutingProtocolBuffer &packet, size_t payload_size);
+
+  /** @brief state after an OK or EOF packet which ends a result */
+  State after_status(const RoutingProtocolBuffer &packet, size_t payload_size) const;
+
+  const bool deprecate_eof_;
+  State state_{State::kIdle};
+  uint64_t packets_left_{0};
+
+  PacketSplitter client_;
+  PacketSplitter server_;
+};
+
 #endif // ROUTING_CLASSICPROTOCOL_INCLUDED
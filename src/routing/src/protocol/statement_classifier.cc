@@ -0,0 +1,208 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "statement_classifier.h"
+
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <vector>
+
+namespace routing {
+
+namespace {
+
+const std::set<std::string> kSessionStateStatements{
+  "SET", "USE", "LOCK", "UNLOCK", "PREPARE", "EXECUTE", "DEALLOCATE", "HANDLER",
+  "CALL", "LOAD", "XA", "FLUSH",
+};
+
+// functions which need a session on a particular server
+const std::set<std::string> kSessionStateFunctions{
+  "GET_LOCK", "RELEASE_LOCK", "RELEASE_ALL_LOCKS", "IS_USED_LOCK", "IS_FREE_LOCK",
+  "SQL_CALC_FOUND_ROWS",
+};
+
+// words which make a SELECT depend on the primary
+const std::set<std::string> kReadWriteWords{
+  "FOUND_ROWS", "LAST_INSERT_ID", "ROW_COUNT", "CONNECTION_ID", "FOR", "LOCK", "INTO",
+};
+
+// statements other than SELECT which don't change data; writes of a
+// transaction are accounted when they are executed
+const std::set<std::string> kReadStatements{
+  "SHOW", "DESCRIBE", "DESC", "EXPLAIN", "HELP", "BEGIN", "START", "COMMIT", "ROLLBACK",
+};
+
+// keywords which may be followed by a parenthesis
+const std::set<std::string> kParenthesisKeywords{
+  "SELECT", "FROM", "WHERE", "AND", "OR", "NOT", "XOR", "IN", "EXISTS", "ON", "USING",
+  "JOIN", "AS", "BY", "HAVING", "WHEN", "THEN", "ELSE", "CASE", "UNION", "ALL", "ANY",
+  "SOME", "ROW", "LIKE", "BETWEEN", "IS", "DISTINCT", "INTERVAL", "DIV", "MOD", "LIMIT",
+  "OVER", "PARTITION", "WITH", "RECURSIVE", "LATERAL", "INDEX", "KEY", "AGAINST",
+  "CHAR", "BINARY", "DECIMAL", "DATETIME", "TIME", "TIMESTAMP",
+};
+
+// built-in functions which only read; any other function may be a stored
+// function, which may write
+const std::set<std::string> kReadOnlyFunctions{
+  // aggregates and window functions
+  "COUNT", "SUM", "AVG", "MIN", "MAX", "GROUP_CONCAT", "STD", "STDDEV", "VARIANCE",
+  "BIT_AND", "BIT_OR", "BIT_XOR", "JSON_ARRAYAGG", "JSON_OBJECTAGG", "ROW_NUMBER",
+  "RANK", "DENSE_RANK", "LAG", "LEAD", "FIRST_VALUE", "LAST_VALUE", "NTILE",
+  // flow control and comparison
+  "IF", "IFNULL", "NULLIF", "COALESCE", "GREATEST", "LEAST", "ISNULL", "CAST", "CONVERT",
+  // strings
+  "CONCAT", "CONCAT_WS", "LENGTH", "CHAR_LENGTH", "CHARACTER_LENGTH", "LOWER", "LCASE",
+  "UPPER", "UCASE", "SUBSTRING", "SUBSTR", "SUBSTRING_INDEX", "LEFT", "RIGHT", "TRIM",
+  "LTRIM", "RTRIM", "REPLACE", "LOCATE", "INSTR", "POSITION", "LPAD", "RPAD", "REPEAT",
+  "REVERSE", "FORMAT", "HEX", "UNHEX", "MD5", "SHA1", "SHA2", "FIND_IN_SET", "FIELD",
+  "ELT", "ASCII", "ORD", "SPACE", "STRCMP", "MATCH", "REGEXP_LIKE", "REGEXP_REPLACE",
+  "REGEXP_SUBSTR", "TO_BASE64", "FROM_BASE64", "INET_ATON", "INET_NTOA", "UUID_TO_BIN",
+  "BIN_TO_UUID",
+  // numbers
+  "ABS", "CEIL", "CEILING", "FLOOR", "ROUND", "TRUNCATE", "MOD", "POW", "POWER", "SQRT",
+  "EXP", "LN", "LOG", "LOG10", "LOG2", "SIGN", "PI", "CRC32", "CONV",
+  // dates and times
+  "NOW", "CURDATE", "CURTIME", "CURRENT_DATE", "CURRENT_TIME", "CURRENT_TIMESTAMP",
+  "UTC_DATE", "UTC_TIME", "UTC_TIMESTAMP", "DATE", "TIME", "TIMESTAMP", "YEAR", "MONTH",
+  "DAY", "DAYOFMONTH", "DAYOFWEEK", "DAYOFYEAR", "WEEK", "WEEKDAY", "HOUR", "MINUTE",
+  "SECOND", "QUARTER", "DATE_FORMAT", "TIME_FORMAT", "DATE_ADD", "DATE_SUB", "ADDDATE",
+  "SUBDATE", "DATEDIFF", "TIMEDIFF", "TIMESTAMPDIFF", "TIMESTAMPADD", "STR_TO_DATE",
+  "UNIX_TIMESTAMP", "FROM_UNIXTIME", "LAST_DAY", "MAKEDATE", "EXTRACT", "CONVERT_TZ",
+  // JSON
+  "JSON_EXTRACT", "JSON_UNQUOTE", "JSON_OBJECT", "JSON_ARRAY", "JSON_CONTAINS",
+  "JSON_CONTAINS_PATH", "JSON_LENGTH", "JSON_KEYS", "JSON_SEARCH", "JSON_TYPE",
+  "JSON_VALID",
+};
+
+/** @brief Splits a statement into upper case words
+ *
+ * Skips comments and string literals; quoted identifiers become "`",
+ * parentheses right behind a word "(" and dots behind a word ".". Returns false if the statement may
+ * not be classified by its words: executable comments, user variables and
+ * multiple statements.
+ */
+bool tokenize(const std::string &sql, std::vector<std::string> &words) {
+  const size_t size = sql.size();
+  size_t pos = 0;
+  // set if the last token is a word or a quoted identifier
+  bool after_word = false;
+
+  while (pos < size) {
+    const char c = sql[pos];
+    const char next = pos + 1 < size ? sql[pos + 1] : '\0';
+
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      ++pos;
+    } else if (c == '#' || (c == '-' && next == '-')) {
+      pos = sql.find('\n', pos);
+      if (pos == std::string::npos) pos = size;
+    } else if (c == '/' && next == '*') {
+      if (pos + 2 < size && (sql[pos + 2] == '!' || sql[pos + 2] == '+')) return false;
+      pos = sql.find("*/", pos + 2);
+      if (pos == std::string::npos) return false;
+      pos += 2;
+    } else if (c == '\'' || c == '"' || c == '`') {
+      for (++pos; pos < size && sql[pos] != c; ++pos) {
+        if (sql[pos] == '\\' && c != '`') ++pos;
+      }
+      if (pos >= size) return false;
+      ++pos;
+      after_word = c == '`';
+      if (after_word) words.push_back("`");
+    } else if (c == '(' || c == '.') {
+      if (after_word) words.push_back(std::string(1, c));
+      after_word = false;
+      ++pos;
+    } else if (c == '@' || c == '?') {
+      return false;
+    } else if (c == ';') {
+      // a trailing semicolon is fine, a second statement is not
+      for (++pos; pos < size; ++pos) {
+        if (!std::isspace(static_cast<unsigned char>(sql[pos]))) return false;
+      }
+    } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+      size_t end = pos;
+      while (end < size && (std::isalnum(static_cast<unsigned char>(sql[end])) ||
+                            sql[end] == '_' || sql[end] == '$')) {
+        ++end;
+      }
+      std::string word = sql.substr(pos, end - pos);
+      std::transform(word.begin(), word.end(), word.begin(), ::toupper);
+      words.push_back(word);
+      pos = end;
+      after_word = true;
+    } else {
+      after_word = false;
+      ++pos;
+    }
+  }
+
+  return true;
+}
+
+}
+
+StatementKind classify_statement(const std::string &sql) {
+  std::vector<std::string> words;
+  if (!tokenize(sql, words) || words.empty()) {
+    return StatementKind::kSessionState;
+  }
+
+  const std::string &first = words[0];
+  if (kSessionStateStatements.count(first) > 0 ||
+      (first == "CREATE" && words.size() > 1 && words[1] == "TEMPORARY")) {
+    return StatementKind::kSessionState;
+  }
+
+  if (first != "SELECT") {
+    return kReadStatements.count(first) > 0 ? StatementKind::kReadWrite
+                                            : StatementKind::kWrite;
+  }
+
+  StatementKind result = StatementKind::kReadOnly;
+  for (size_t i = 0; i < words.size(); ++i) {
+    const std::string &word = words[i];
+    if (kSessionStateFunctions.count(word) > 0) {
+      return StatementKind::kSessionState;
+    }
+    if (kReadWriteWords.count(word) > 0) {
+      result = StatementKind::kReadWrite;
+    }
+    // a call of a function which isn't known to only read, built-in ones
+    // are never qualified by a schema
+    const bool is_call = i + 1 < words.size() && words[i + 1] == "(";
+    const bool is_qualified = i > 0 && words[i - 1] == ".";
+    if (is_call && (is_qualified || (kParenthesisKeywords.count(word) == 0 &&
+                                     kReadOnlyFunctions.count(word) == 0 &&
+                                     kReadWriteWords.count(word) == 0))) {
+      return StatementKind::kWrite;
+    }
+  }
+
+  return result;
+}
+
+} // namespace routing
@@ -0,0 +1,58 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef ROUTING_STATEMENT_CLASSIFIER_INCLUDED
+#define ROUTING_STATEMENT_CLASSIFIER_INCLUDED
+
+#include <string>
+
+namespace routing {
+
+/** @brief Where a statement can be executed when splitting reads and writes */
+enum class StatementKind {
+  kReadOnly = 1,      // plain SELECT, can run on a secondary
+  kReadWrite = 2,     // must run on the primary
+  kSessionState = 3,  // changes session state, pins the session to the primary
+  kWrite = 4,         // may change data, must run on the primary
+};
+
+/** @brief Classifies a COM_QUERY statement for read/write splitting
+ *
+ * Only looks at the tokens of the statement, it does not parse SQL. Anything
+ * that is not clearly a plain SELECT is classified as read-write, or as
+ * write unless it is known not to change data: SELECTs calling functions
+ * other than known built-in ones may call a stored function which writes.
+ * Statements which may create state in the session (user variables,
+ * temporary tables, locks, prepared statements, ...) are classified as
+ * session state.
+ *
+ * @param sql statement as sent by the client
+ * @return kind of the statement
+ */
+StatementKind classify_statement(const std::string &sql);
+
+} // namespace routing
+
+#endif // ROUTING_STATEMENT_CLASSIFIER_INCLUDED
@@ -37,6 +37,7 @@
 # include <netdb.h>
 # include <netinet/tcp.h>
 # include <sys/socket.h>
+# include <sys/un.h>
 # include <poll.h>
 #else
 # define WIN32_LEAN_AND_MEAN
@@ -59,6 +60,8 @@ const std::string kDefaultBindAddress = "127.0.0.1";
 const unsigned int kDefaultNetBufferLength = 16384;  // Default defined in latest MySQL Server
 const unsigned long long kDefaultMaxConnectErrors = 100;  // Similar to MySQL Server
 const std::chrono::seconds kDefaultClientConnectTimeout { 9 }; // Default connect_timeout MySQL Server minus 1
+const unsigned int kDefaultClientSslSessionCacheSize = 1024;
+const std::chrono::seconds kDefaultConnectionPoolIdleTimeout { 60 };
 
 // unused constant
 // const int kMaxConnectTimeout = INT_MAX / 1000;
@@ -66,7 +69,7 @@ const std::chrono::seconds kDefaultClientConnectTimeout { 9 }; // Default connec
 
 // keep in-sync with enum AccessMode
 const std::vector<const char*> kAccessModeNames {
-  nullptr, "read-write", "read-only"
+  nullptr, "read-write", "read-only", "read-write-split"
 };
 
 AccessMode get_access_mode(const std::string& value) {
@@ -117,6 +120,23 @@ std::string get_routing_strategy_name(RoutingStrategy routing_strategy) noexcept
   return kRoutingStrategyNames[static_cast<int>(routing_strategy)];
 }
 
+// keep in-sync with enum ClientSslMode
+const std::vector<const char*> kClientSslModeNames {
+  nullptr, "passthrough", "preferred", "required", "disabled"
+};
+
+ClientSslMode get_client_ssl_mode(const std::string& value) {
+  for (unsigned int i = 1 ; i < kClientSslModeNames.size() ; ++i)
+    if (strcmp(kClientSslModeNames[i], value.c_str()) == 0)
+      return static_cast<ClientSslMode>(i);
+  return ClientSslMode::kUndefined;
+}
+
+std::string get_client_ssl_mode_names() {
+  // +1 to skip undefined
+  return mysql_harness::serial_comma(kClientSslModeNames.begin()+1, kClientSslModeNames.end());
+}
+
 void set_socket_blocking(int sock, bool blocking) {
 
   assert(!(sock < 0));
@@ -238,4 +258,65 @@ int RoutingSockOps::get_mysql_socket(mysql_harness::TCPAddress addr, std::chrono
   return sock;
 }
 
+int RoutingSockOps::get_mysql_unix_socket(const std::string &socket_path, std::chrono::milliseconds connect_timeout_ms, bool log) noexcept {
+#ifndef _WIN32
+  struct sockaddr_un sock_unix;
+
+  if (socket_path.size() >= sizeof(sock_unix.sun_path)) {
+    if (log) {
+      log_debug("Socket file path '%s' is too long", socket_path.c_str());
+    }
+    return -1;
+  }
+
+  int sock;
+  if ((sock = so_->socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+    log_error("Failed opening socket: %s", get_message_error(so_->get_errno()).c_str());
+    return -1;
+  }
+
+  memset(&sock_unix, 0, sizeof sock_unix);
+  sock_unix.sun_family = AF_UNIX;
+  std::strncpy(sock_unix.sun_path, socket_path.c_str(), sizeof(sock_unix.sun_path) - 1);
+
+  set_socket_blocking(sock, false);
+
+  // a full backlog fails with EAGAIN right away, the caller falls back to TCP then
+  if (so_->connect(sock, reinterpret_cast<struct sockaddr *>(&sock_unix), static_cast<socklen_t>(sizeof(sock_unix))) < 0) {
+    int result = -1;
+    if (so_->get_errno() != EINPROGRESS) {
+      if (log) {
+        log_debug("Failed connect() to %s: %s", socket_path.c_str(), get_message_error(so_->get_errno()).c_str());
+      }
+    } else if (0 != so_->connect_non_blocking_wait(sock, connect_timeout_ms)) {
+      if (log) {
+        log_warning("Timeout reached trying to connect to MySQL Server %s: %s", socket_path.c_str(), get_message_error(so_->get_errno()).c_str());
+      }
+      if (so_->get_errno() == ETIMEDOUT) result = -2;
+    } else {
+      int so_error = 0;
+      if (0 == so_->connect_non_blocking_status(sock, so_error)) {
+        result = sock;
+      }
+    }
+
+    if (result < 0) {
+      so_->close(sock);
+      return result;
+    }
+  }
+
+  // the MySQL protocol is blocking, see get_mysql_socket()
+  set_socket_blocking(sock, true);
+
+  return sock;
+#else
+  (void)socket_path;
+  (void)connect_timeout_ms;
+  (void)log;
+
+  return -1;
+#endif
+}
+
 } // routing
@@ -22,11 +22,13 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#include "client_tls.h"
 #include "plugin_config.h"
 #include "mysql_routing.h"
 #include "utils.h"
 
 #include "dim.h"
+#include "keyring/keyring_manager.h"
 #include "mysql/harness/loader_config.h"
 
 #include "mysql/harness/logging/logging.h"
@@ -34,6 +36,7 @@
 
 #include <atomic>
 #include <iostream>
+#include <map>
 #include <mutex>
 #include <vector>
 
@@ -47,6 +50,7 @@ IMPORT_LOG_FUNCTIONS()
 
 const mysql_harness::AppInfo *g_app_info;
 static const string kSectionName = "routing";
+static const char *kKeyringAttributePassword = "password";
 
 static void validate_socket_info(const std::string& err_prefix,
                                  const mysql_harness::ConfigSection* section,
@@ -214,6 +218,37 @@ static void start(mysql_harness::PluginFuncEnv* env) {
                    routing::RoutingSockOps::instance(mysql_harness::SocketOperations::instance()),
                    config.thread_stack_size);
 
+    r.set_local_sockets(config.local_sockets);
+
+    if (config.client_ssl_mode == routing::ClientSslMode::kDisabled) {
+      r.set_client_tls(nullptr, config.client_ssl_mode);
+    } else if (config.client_ssl_mode != routing::ClientSslMode::kPassthrough) {
+      r.set_client_tls(std::make_shared<ClientTlsContext>(config.client_ssl_cert,
+                                                          config.client_ssl_key,
+                                                          config.client_ssl_session_cache_size,
+                                                          config.client_ssl_ktls),
+                       config.client_ssl_mode);
+    }
+
+    if (config.connection_pool_size > 0) {
+      r.set_connection_pool(config.connection_pool_size,
+                            std::chrono::seconds(config.connection_pool_idle_timeout));
+    }
+
+    if (config.mode == routing::AccessMode::kReadWriteSplit) {
+      std::map<std::string, std::string> credentials;
+      for (const auto &user : config.read_write_split_users) {
+        try {
+          credentials[user] = mysql_harness::get_keyring() ?
+            mysql_harness::get_keyring()->fetch(user, kKeyringAttributePassword) : "";
+        } catch (const std::out_of_range&) {
+          throw std::runtime_error("Could not find the password for user '" + user +
+                                   "' in the keyring. read-write-split not initialized properly.");
+        }
+      }
+      r.set_read_write_split_credentials(std::move(credentials));
+    }
+
     try {
       // don't allow rootless URIs as we did already in the get_option_destinations()
       r.set_destinations_from_uri(URI(config.destinations, false));
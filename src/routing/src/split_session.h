@@ -0,0 +1,85 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef ROUTING_SPLIT_SESSION_INCLUDED
+#define ROUTING_SPLIT_SESSION_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+
+#include "protocol/statement_classifier.h"
+
+/**
+ * @brief Routing decisions of a session with reads and writes split
+ *
+ * Plain reads go to a secondary while the session is in autocommit mode
+ * outside of transactions and didn't write yet. Once it may have written,
+ * its reads stay with the primary, so it reads its own writes. If no
+ * secondary could be used, the next attempt is made after a retry interval.
+ */
+class SplitSession {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /** @brief Constructor
+   *
+   * @param status_flags server status after the login to the primary
+   * @param retry_interval time to wait before using a secondary after a
+   *        failed attempt
+   */
+  SplitSession(uint16_t status_flags, std::chrono::milliseconds retry_interval)
+      : status_flags_(status_flags), retry_interval_(retry_interval) {}
+
+  /** @brief true if a statement of the given kind can go to a secondary */
+  bool is_for_read_only(routing::StatementKind kind) const;
+
+  /** @brief Accounts a statement the primary executed
+   *
+   * @param kind kind of the statement
+   * @param status_flags server status of its response
+   */
+  void executed_on_primary(routing::StatementKind kind, uint16_t status_flags);
+
+  /** @brief true if a secondary may be connected at the given time */
+  bool may_connect_read_only(clock::time_point now) const {
+    return now >= retry_at_;
+  }
+
+  /** @brief Accounts a failed attempt to use a secondary */
+  void read_only_failed(clock::time_point now) {
+    retry_at_ = now + retry_interval_;
+  }
+
+  /** @brief server status of the session with the primary */
+  uint16_t status_flags() const { return status_flags_; }
+
+ private:
+  uint16_t status_flags_;
+  const std::chrono::milliseconds retry_interval_;
+  bool wrote_{false};
+  clock::time_point retry_at_{};
+};
+
+#endif // ROUTING_SPLIT_SESSION_INCLUDED
@@ -33,6 +33,7 @@
 #ifndef _MSC_VER
 # include <arpa/inet.h>
 # include <fcntl.h>
+# include <ifaddrs.h>
 # include <sys/socket.h>
 # include <sys/un.h>
 #else
@@ -54,20 +55,25 @@ void *get_in_addr(struct sockaddr *addr) {
 std::pair<std::string, int > get_peer_name(int sock) {
   socklen_t sock_len;
   struct sockaddr_storage addr;
-  char result_addr[105];  // For IPv4, IPv6 and Unix socket
-  int port;
 
   sock_len = static_cast<socklen_t>(sizeof addr);
   getpeername(sock, (struct sockaddr*)&addr, &sock_len);
 
+  return get_peer_name(addr);
+}
+
+std::pair<std::string, int > get_peer_name(const struct sockaddr_storage &addr) {
+  char result_addr[105] = "";  // For IPv4, IPv6 and Unix socket
+  int port = 0;
+
   if (addr.ss_family == AF_INET6) {
     // IPv6
-    auto *sin6 = (struct sockaddr_in6 *)&addr;
+    auto *sin6 = (const struct sockaddr_in6 *)&addr;
     port = ntohs(sin6->sin6_port);
     inet_ntop(AF_INET6, &sin6->sin6_addr, result_addr, static_cast<socklen_t>(sizeof result_addr));
   } else if (addr.ss_family == AF_INET) {
     // IPv4
-    auto *sin4 = (struct sockaddr_in *)&addr;
+    auto *sin4 = (const struct sockaddr_in *)&addr;
     port = ntohs(sin4->sin_port);
     inet_ntop(AF_INET, &sin4->sin_addr, result_addr, static_cast<socklen_t>(sizeof result_addr));
   } else if (addr.ss_family == AF_UNIX) {
@@ -156,3 +162,35 @@ std::string get_message_error(int errcode)
   }
 #endif
 }
+
+std::set<std::string> get_local_host_names(const std::string &hostname) {
+  std::set<std::string> result{"localhost", "127.0.0.1", "::1"};
+
+  if (!hostname.empty()) {
+    result.insert(hostname);
+  }
+
+#ifndef _WIN32
+  struct ifaddrs *ifaddr;
+  if (getifaddrs(&ifaddr) == -1) {
+    return result;
+  }
+
+  for (struct ifaddrs *ifa = ifaddr; ifa != nullptr; ifa = ifa->ifa_next) {
+    if (ifa->ifa_addr == nullptr) continue;
+
+    char addr_str[INET6_ADDRSTRLEN];
+    const int family = ifa->ifa_addr->sa_family;
+    if (family != AF_INET && family != AF_INET6) continue;
+
+    if (inet_ntop(family, get_in_addr(ifa->ifa_addr), addr_str,
+                  static_cast<socklen_t>(sizeof addr_str)) != nullptr) {
+      result.insert(addr_str);
+    }
+  }
+
+  freeifaddrs(ifaddr);
+#endif
+
+  return result;
+}
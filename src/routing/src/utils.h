@@ -27,6 +27,7 @@
 
 #include <array>
 #include <iostream>
+#include <set>
 #include <sstream>
 #include <vector>
 #ifndef _WIN32
@@ -63,6 +64,16 @@ void * get_in_addr(struct sockaddr *addr);
  */
 std::pair<std::string, int > get_peer_name(int sock);
 
+/**
+ * Get address of peer from the address returned by accept()
+ *
+ * Same as get_peer_name(int), without asking the socket.
+ *
+ * @param addr address of the peer
+ * @return std::pair with std::string and uint16_t
+ */
+std::pair<std::string, int > get_peer_name(const struct sockaddr_storage &addr);
+
 /**
  * Splits a string using a delimiter
  *
@@ -88,4 +99,16 @@ ClientIpArray in_addr_to_array(const sockaddr_storage& addr);
 
 std::string get_message_error(int errcode);
 
+/** @brief Returns names and addresses under which this host is reachable
+ *
+ * The set contains `localhost`, the loopback addresses, the given hostname
+ * and (on systems supporting getifaddrs()) the IP addresses of all local
+ * network interfaces. It is used to decide whether a destination runs on
+ * the same host as the Router.
+ *
+ * @param hostname name of the local host (can be empty)
+ * @return set of names and textual IP addresses
+ */
+std::set<std::string> get_local_host_names(const std::string &hostname);
+
 #endif // UTILS_ROUTING_INCLUDED
@@ -253,6 +253,55 @@ TEST_F(RoutingPluginTests, ListeningTcpSocket) {
 
 }
 
+TEST_F(RoutingPluginTests, ReadWriteSplitUsers) {
+  mysql_harness::Config         cfg;
+  mysql_harness::ConfigSection& section = cfg.add("routing", "test_route");
+  section.add("destinations", "metadata-cache://cluster/default?role=PRIMARY_AND_SECONDARY");
+  section.add("mode", "read-write-split");
+  section.add("bind_address", "127.0.0.1:15508");
+  section.add("client_ssl_mode", "required");
+  section.add("client_ssl_cert", "cert.pem");
+  section.add("client_ssl_key", "key.pem");
+
+  try {
+    RoutingPluginConfig config(&section);
+    FAIL() << "Expected std::invalid_argument to be thrown";
+  } catch (const std::invalid_argument& e) {
+    EXPECT_STREQ("option read_write_split_users in [routing:test_route] is required "
+                 "if mode is read-write-split", e.what());
+  }
+
+  section.add("read_write_split_users", "app, report");
+  RoutingPluginConfig config(&section);
+  EXPECT_EQ(std::vector<std::string>({"app", "report"}), config.read_write_split_users);
+
+  section.set("read_write_split_users", "app,,report");
+  EXPECT_THROW(RoutingPluginConfig{&section}, std::invalid_argument);
+}
+
+TEST_F(RoutingPluginTests, ConnectionPoolClientSslMode) {
+  mysql_harness::Config         cfg;
+  mysql_harness::ConfigSection& section = cfg.add("routing", "test_route");
+  section.add("destinations", "localhost:1234");
+  section.add("mode", "read-write");
+  section.add("bind_address", "127.0.0.1:15508");
+  section.add("connection_pool_size", "8");
+
+  try {
+    RoutingPluginConfig config(&section);
+    FAIL() << "Expected std::invalid_argument to be thrown";
+  } catch (const std::invalid_argument& e) {
+    EXPECT_STREQ("option connection_pool_size in [routing:test_route] requires "
+                 "client_ssl_mode other than passthrough", e.what());
+  }
+
+  // the router runs the handshake without TLS, no certificate needed
+  section.add("client_ssl_mode", "disabled");
+  RoutingPluginConfig config(&section);
+  EXPECT_EQ(routing::ClientSslMode::kDisabled, config.client_ssl_mode);
+  EXPECT_EQ(8u, config.connection_pool_size);
+}
+
 #ifndef _WIN32
 TEST_F(RoutingPluginTests, ListeningUnixSocket) {
   mysql_harness::Config         cfg;
@@ -58,6 +58,7 @@ class MockSocketOperations : public mysql_harness::SocketOperationsBase {
   MOCK_METHOD4(getaddrinfo, int(const char*, const char*, const addrinfo*, addrinfo**));
   MOCK_METHOD3(bind, int(int, const struct sockaddr*, socklen_t));
   MOCK_METHOD3(socket, int(int, int, int));
+  MOCK_METHOD3(connect, int(int, const struct sockaddr*, socklen_t));
   MOCK_METHOD5(setsockopt, int(int, int, int, const void*, socklen_t));
   MOCK_METHOD2(listen, int(int fd, int n));
   MOCK_METHOD3(poll, int(struct pollfd *, nfds_t, std::chrono::milliseconds));
@@ -106,6 +107,30 @@ class MockRoutingSockOps : public routing::RoutingSockOpsInterface {
     }
   }
 
+  int get_mysql_unix_socket(const std::string &, std::chrono::milliseconds, bool = true) noexcept override {
+    get_mysql_unix_socket_call_cnt_++;
+    if (get_mysql_unix_socket_fails_todo_) {
+      so()->set_errno(ECONNREFUSED);
+      get_mysql_unix_socket_fails_todo_--;
+      return -1;
+    }
+    so()->set_errno(0);
+    return unix_socket_fd();
+  }
+
+  int get_mysql_unix_socket_call_cnt() {
+    int cc = get_mysql_unix_socket_call_cnt_;
+    get_mysql_unix_socket_call_cnt_ = 0;
+    return cc;
+  }
+
+  void get_mysql_unix_socket_fail(int fail_cnt) {
+    get_mysql_unix_socket_fails_todo_ = fail_cnt;
+  }
+
+  // "socket" returned by get_mysql_unix_socket() on success
+  static int unix_socket_fd() { return 1000; }
+
   int get_mysql_socket_call_cnt() {
     int cc = get_mysql_socket_call_cnt_;
     get_mysql_socket_call_cnt_ = 0;
@@ -119,6 +144,8 @@ class MockRoutingSockOps : public routing::RoutingSockOpsInterface {
  private:
   std::atomic_int get_mysql_socket_fails_todo_ { 0 };
   std::atomic_int get_mysql_socket_call_cnt_   { 0 };
+  std::atomic_int get_mysql_unix_socket_fails_todo_ { 0 };
+  std::atomic_int get_mysql_unix_socket_call_cnt_   { 0 };
 
   std::unique_ptr<MockSocketOperations> so_;
 };
@@ -173,8 +173,11 @@ TEST_F(ClassicProtocolTest, CopyPacketsHandshakePacketTooSmall)
 {
   size_t report_bytes_read = 3;
 
+  // the rest of the header never arrives
   EXPECT_CALL(*mock_socket_operations_, read(sender_socket_, &network_buffer_[0], network_buffer_.size())).
                                                                   WillOnce(Return((ssize_t)report_bytes_read));
+  EXPECT_CALL(*mock_socket_operations_, read(sender_socket_, &network_buffer_[3], network_buffer_.size() - 3)).
+                                                                  WillOnce(Return(0));
 
   int result = sut_protocol_->copy_packets(sender_socket_, receiver_socket_, true, network_buffer_, &curr_pktnr_,
                                        handshake_done_, &report_bytes_read, true);
@@ -226,6 +229,65 @@ TEST_F(ClassicProtocolTest, CopyPacketsHandshakeServerSendsError)
   ASSERT_EQ(0, result);
 }
 
+/**
+ * a handshake response whose header and capabilities arrive in pieces is
+ * read until they are complete.
+ */
+TEST_F(ClassicProtocolTest, CopyPacketsHandshakeResponseInPieces)
+{
+  size_t report_bytes_read = 0xff;
+
+  auto response = mysql_protocol::HandshakeResponsePacket(1, {}, "ROUTER", "", "fake_router_login");
+  serialize_classic_packet_to_buffer(network_buffer_, network_buffer_offset_, response);
+  // client asks to switch to SSL
+  network_buffer_[5] |= 0x08;
+
+  {
+    ::testing::InSequence s;
+    EXPECT_CALL(*mock_socket_operations_, read(sender_socket_, &network_buffer_[0], network_buffer_.size())).
+                                                                    WillOnce(Return(2));
+    EXPECT_CALL(*mock_socket_operations_, read(sender_socket_, &network_buffer_[2], network_buffer_.size() - 2)).
+                                                                    WillOnce(Return(4));
+    EXPECT_CALL(*mock_socket_operations_, read(sender_socket_, &network_buffer_[6], network_buffer_.size() - 6)).
+                                                                    WillOnce(Return((ssize_t)network_buffer_offset_ - 6));
+    EXPECT_CALL(*mock_socket_operations_, write(receiver_socket_, &network_buffer_[0], network_buffer_offset_)).
+                                                                    WillOnce(Return((ssize_t)network_buffer_offset_));
+  }
+
+  int result = sut_protocol_->copy_packets(sender_socket_, receiver_socket_, true, network_buffer_, &curr_pktnr_,
+                                       handshake_done_, &report_bytes_read, false);
+
+  ASSERT_EQ(0, result);
+  EXPECT_EQ(network_buffer_offset_, report_bytes_read);
+  // switching to SSL ends the handshake
+  EXPECT_EQ(2, curr_pktnr_);
+}
+
+/**
+ * a packet shorter than the fields which are inspected is passed on as is.
+ */
+TEST_F(ClassicProtocolTest, CopyPacketsHandshakeShortPacket)
+{
+  size_t report_bytes_read = 0xff;
+  curr_pktnr_ = 1;
+
+  // header and 2 bytes payload
+  const uint8_t packet[] { 0x02, 0x00, 0x00, 0x02, 0x00, 0x00 };
+  std::copy(std::begin(packet), std::end(packet), network_buffer_.begin());
+
+  EXPECT_CALL(*mock_socket_operations_, read(sender_socket_, &network_buffer_[0], network_buffer_.size())).
+                                                                  WillOnce(Return((ssize_t)sizeof(packet)));
+  EXPECT_CALL(*mock_socket_operations_, write(receiver_socket_, &network_buffer_[0], sizeof(packet))).
+                                                                  WillOnce(Return((ssize_t)sizeof(packet)));
+
+  int result = sut_protocol_->copy_packets(sender_socket_, receiver_socket_, true, network_buffer_, &curr_pktnr_,
+                                       handshake_done_, &report_bytes_read, true);
+
+  ASSERT_EQ(0, result);
+  EXPECT_EQ(sizeof(packet), report_bytes_read);
+  EXPECT_EQ(2, curr_pktnr_);
+}
+
 TEST_F(ClassicProtocolTest, SendErrorOKMultipleWrites)
 {
   EXPECT_CALL(*mock_socket_operations_, write(1, _, _)).Times(2).
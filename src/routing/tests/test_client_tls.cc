@@ -0,0 +1,572 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "test/helpers.h"
+
+#include "gtest/gtest.h"
+
+#ifndef _WIN32
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <future>
+#include <memory>
+#include <thread>
+
+#include "client_tls.h"
+#include "mysqlrouter/routing.h"
+#include "protocol/classic_protocol.h"
+
+#ifdef HAVE_YASSL
+using namespace yaSSL;
+#else
+# include <openssl/pem.h>
+# include <openssl/rsa.h>
+#endif
+
+using mysql_protocol::Capabilities::Flags;
+using Buffer = std::vector<uint8_t>;
+
+namespace {
+
+const std::string kCertFile = std::string(ROUTING_TEST_DATA_DIR) + "/tls_server_cert.pem";
+const std::string kKeyFile = std::string(ROUTING_TEST_DATA_DIR) + "/tls_server_key.pem";
+
+const std::chrono::milliseconds kTimeout{5000};
+
+Buffer make_packet(uint8_t seq, const Buffer &payload) {
+  Buffer packet{static_cast<uint8_t>(payload.size()),
+                static_cast<uint8_t>(payload.size() >> 8),
+                static_cast<uint8_t>(payload.size() >> 16),
+                seq};
+  packet.insert(packet.end(), payload.begin(), payload.end());
+  return packet;
+}
+
+Buffer caps_bytes(Flags caps) {
+  const uint32_t bits = caps.bits();
+  return {static_cast<uint8_t>(bits), static_cast<uint8_t>(bits >> 8),
+          static_cast<uint8_t>(bits >> 16), static_cast<uint8_t>(bits >> 24)};
+}
+
+// protocol 10 greeting without SSL support
+Buffer make_greeting() {
+  Buffer payload{10, '8', '.', '0', 0,
+                 1, 0, 0, 0,                    // connection id
+                 1, 2, 3, 4, 5, 6, 7, 8, 0};   // auth-plugin-data-part-1, filler
+  const auto caps = caps_bytes(mysql_protocol::Capabilities::PROTOCOL_41);
+  payload.insert(payload.end(), caps.begin(), caps.begin() + 2);
+  payload.insert(payload.end(), {8, 2, 0, 0, 0});
+  return make_packet(0, payload);
+}
+
+Buffer make_response(uint8_t seq, Flags caps, bool ssl_request) {
+  Buffer payload = caps_bytes(caps);
+  payload.insert(payload.end(), {0, 0, 0, 1, 8});  // max-packet-size, charset
+  payload.resize(32, 0);                            // filler
+  if (!ssl_request) {
+    payload.insert(payload.end(), {'r', 'o', 'o', 't', 0, 0});
+  }
+  return make_packet(seq, payload);
+}
+
+Buffer read_packet(int fd) {
+  Buffer header(4);
+  EXPECT_EQ(4, ::recv(fd, header.data(), header.size(), MSG_WAITALL));
+  Buffer packet(header);
+  packet.resize(4 + (header[0] | header[1] << 8 | header[2] << 16));
+  if (packet.size() > 4) {
+    EXPECT_EQ(static_cast<ssize_t>(packet.size() - 4),
+              ::recv(fd, &packet[4], packet.size() - 4, MSG_WAITALL));
+  }
+  return packet;
+}
+
+Buffer read_packet(SSL *ssl) {
+  Buffer packet(4);
+  EXPECT_EQ(4, SSL_read(ssl, packet.data(), 4));
+  packet.resize(4 + (packet[0] | packet[1] << 8 | packet[2] << 16));
+  size_t pos = 4;
+  while (pos < packet.size()) {
+    int res = SSL_read(ssl, &packet[pos], static_cast<int>(packet.size() - pos));
+    if (res <= 0) {
+      ADD_FAILURE() << "SSL_read failed";
+      break;
+    }
+    pos += static_cast<size_t>(res);
+  }
+  return packet;
+}
+
+// reads what is available from the router's TLS connection
+ssize_t read_some(ClientTlsConnection &tls, int fd, uint8_t *buffer, size_t size) {
+  while (true) {
+    struct pollfd fds[] = {
+      { fd, POLLIN, 0 },
+    };
+    if (tls.pending() == 0 && ::poll(fds, 1, static_cast<int>(kTimeout.count())) != 1) {
+      return -1;
+    }
+    const ssize_t res = tls.read(buffer, size);
+    if (res >= 0 || errno != EAGAIN) return res;
+  }
+}
+
+Flags get_caps(const Buffer &packet) {
+  return Flags(static_cast<uint32_t>(packet[4] | packet[5] << 8 | packet[6] << 16 | packet[7] << 24));
+}
+
+// connected sockets over TCP, which the server doesn't trust with passwords
+void tcp_socket_pair(int fds[2]) {
+  const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(listener, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addr_len = sizeof(addr);
+  ASSERT_EQ(0, ::bind(listener, reinterpret_cast<sockaddr*>(&addr), addr_len));
+  ASSERT_EQ(0, ::listen(listener, 1));
+  ASSERT_EQ(0, ::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addr_len));
+  fds[0] = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(0, ::connect(fds[0], reinterpret_cast<sockaddr*>(&addr), addr_len));
+  fds[1] = ::accept(listener, nullptr, nullptr);
+  ASSERT_GE(fds[1], 0);
+  ::close(listener);
+}
+
+#ifndef HAVE_YASSL
+
+// auth-switch to caching_sha2_password with the given nonce
+Buffer make_sha2_auth_switch(uint8_t seq, const Buffer &nonce) {
+  Buffer payload{0xfe};
+  const std::string plugin("caching_sha2_password");
+  payload.insert(payload.end(), plugin.begin(), plugin.end());
+  payload.push_back(0);
+  payload.insert(payload.end(), nonce.begin(), nonce.end());
+  payload.push_back(0);
+  return make_packet(seq, payload);
+}
+
+// public key of the test certificate as the server sends it
+std::string get_public_key() {
+  BIO *cert_bio = BIO_new_file(kCertFile.c_str(), "r");
+  X509 *cert = PEM_read_bio_X509(cert_bio, nullptr, nullptr, nullptr);
+  EVP_PKEY *pkey = X509_get_pubkey(cert);
+  BIO *out = BIO_new(BIO_s_mem());
+  PEM_write_bio_PUBKEY(out, pkey);
+  char *data = nullptr;
+  const long size = BIO_get_mem_data(out, &data);
+  std::string result(data, static_cast<size_t>(size));
+  BIO_free(out);
+  EVP_PKEY_free(pkey);
+  X509_free(cert);
+  BIO_free(cert_bio);
+  return result;
+}
+
+// password the router encrypted, still XORed with the nonce
+Buffer decrypt_password(const Buffer &encrypted) {
+  BIO *key_bio = BIO_new_file(kKeyFile.c_str(), "r");
+  EVP_PKEY *pkey = PEM_read_bio_PrivateKey(key_bio, nullptr, nullptr, nullptr);
+  EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(pkey, nullptr);
+  size_t size = 0;
+  EXPECT_EQ(1, EVP_PKEY_decrypt_init(ctx));
+  EXPECT_EQ(1, EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_OAEP_PADDING));
+  EXPECT_EQ(1, EVP_PKEY_decrypt(ctx, nullptr, &size, encrypted.data(), encrypted.size()));
+  Buffer result(size);
+  EXPECT_EQ(1, EVP_PKEY_decrypt(ctx, result.data(), &size, encrypted.data(), encrypted.size()));
+  result.resize(size);
+  EVP_PKEY_CTX_free(ctx);
+  EVP_PKEY_free(pkey);
+  BIO_free(key_bio);
+  return result;
+}
+
+#endif // !HAVE_YASSL
+
+}
+
+class ClientTlsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    client_ = fds[0];
+    router_client_ = fds[1];
+    tcp_socket_pair(fds);
+    router_server_ = fds[0];
+    server_ = fds[1];
+
+    tls_context_.reset(new ClientTlsContext(kCertFile, kKeyFile, 16, false));
+  }
+
+  void TearDown() override {
+    for (int fd : {client_, router_client_, router_server_, server_}) {
+      ::close(fd);
+    }
+  }
+
+  std::future<int> run_router_handshake(routing::ClientSslMode ssl_mode) {
+    return std::async(std::launch::async, [this, ssl_mode]() {
+      ClassicProtocol protocol(routing::RoutingSockOps::instance(
+          mysql_harness::SocketOperations::instance()));
+      return protocol.handshake_client_tls(router_client_, router_server_,
+                                           *tls_context_, ssl_mode, kTimeout,
+                                           client_tls_, &pktnr_, "test");
+    });
+  }
+
+  // runs the handshake up to the handshake response the server receives
+  SSL *start_tls_session(SSL_CTX *client_ctx) {
+    const Buffer greeting = make_greeting();
+    EXPECT_EQ(static_cast<ssize_t>(greeting.size()), ::send(server_, greeting.data(), greeting.size(), 0));
+    read_packet(client_);
+
+    const Flags caps = mysql_protocol::Capabilities::PROTOCOL_41 | mysql_protocol::Capabilities::SSL;
+    const Buffer ssl_request = make_response(1, caps, true);
+    EXPECT_EQ(static_cast<ssize_t>(ssl_request.size()), ::send(client_, ssl_request.data(), ssl_request.size(), 0));
+
+    SSL *ssl = SSL_new(client_ctx);
+    SSL_set_fd(ssl, client_);
+    EXPECT_EQ(1, SSL_connect(ssl));
+
+    const Buffer response = make_response(2, caps, false);
+    EXPECT_EQ(static_cast<int>(response.size()), SSL_write(ssl, response.data(), static_cast<int>(response.size())));
+    read_packet(server_);
+
+    return ssl;
+  }
+
+  int client_, router_client_, router_server_, server_;
+  std::unique_ptr<ClientTlsContext> tls_context_;
+  std::unique_ptr<ClientTlsConnection> client_tls_;
+  int pktnr_ = 0;
+};
+
+/**
+ * @test Client switching to SSL talks TLS with the router, the server gets
+ *       the handshake response as plain packet with adjusted sequence ids.
+ */
+TEST_F(ClientTlsTest, TerminateTls) {
+  auto router = run_router_handshake(routing::ClientSslMode::kPreferred);
+
+  const Buffer greeting = make_greeting();
+  ASSERT_EQ(static_cast<ssize_t>(greeting.size()), ::send(server_, greeting.data(), greeting.size(), 0));
+
+  // router announces SSL
+  Buffer packet = read_packet(client_);
+  ASSERT_EQ(greeting.size(), packet.size());
+  EXPECT_TRUE(Flags(static_cast<uint32_t>(packet[22] | packet[23] << 8)).test(mysql_protocol::Capabilities::SSL));
+
+  const Flags caps = mysql_protocol::Capabilities::PROTOCOL_41 | mysql_protocol::Capabilities::SSL;
+  const Buffer ssl_request = make_response(1, caps, true);
+  ASSERT_EQ(static_cast<ssize_t>(ssl_request.size()), ::send(client_, ssl_request.data(), ssl_request.size(), 0));
+
+  SSL_CTX *client_ctx = SSL_CTX_new(SSLv23_client_method());
+  ASSERT_NE(nullptr, client_ctx);
+  SSL_CTX_set_verify(client_ctx, SSL_VERIFY_NONE, nullptr);
+  SSL *ssl = SSL_new(client_ctx);
+  SSL_set_fd(ssl, client_);
+  ASSERT_EQ(1, SSL_connect(ssl));
+
+  const Buffer response = make_response(2, caps, false);
+  ASSERT_EQ(static_cast<int>(response.size()), SSL_write(ssl, response.data(), static_cast<int>(response.size())));
+
+  // server sees the response as 2nd packet, without SSL
+  packet = read_packet(server_);
+  ASSERT_EQ(response.size(), packet.size());
+  EXPECT_EQ(1, packet[3]);
+  EXPECT_FALSE(get_caps(packet).test(mysql_protocol::Capabilities::SSL));
+  EXPECT_TRUE(get_caps(packet).test(mysql_protocol::Capabilities::PROTOCOL_41));
+
+  // auth-switch, its response and OK
+  const Buffer auth_switch = make_packet(2, {0xfe, 'x', 0});
+  ASSERT_EQ(static_cast<ssize_t>(auth_switch.size()), ::send(server_, auth_switch.data(), auth_switch.size(), 0));
+  packet = read_packet(ssl);
+  EXPECT_EQ(3, packet[3]);
+  EXPECT_EQ(0xfe, packet[4]);
+
+  const Buffer auth_data = make_packet(4, {1, 2, 3});
+  ASSERT_EQ(static_cast<int>(auth_data.size()), SSL_write(ssl, auth_data.data(), static_cast<int>(auth_data.size())));
+  packet = read_packet(server_);
+  EXPECT_EQ(3, packet[3]);
+
+  const Buffer ok = make_packet(4, {0, 0, 0, 2, 0, 0, 0});
+  ASSERT_EQ(static_cast<ssize_t>(ok.size()), ::send(server_, ok.data(), ok.size(), 0));
+  packet = read_packet(ssl);
+  EXPECT_EQ(5, packet[3]);
+  EXPECT_EQ(0, packet[4]);
+
+  EXPECT_EQ(0, router.get());
+  EXPECT_EQ(2, pktnr_);
+  ASSERT_NE(nullptr, client_tls_);
+
+  // application data is relayed through the TLS connection
+  const uint8_t query[] = {1, 0, 0, 0, 0x0e};  // COM_PING
+  ASSERT_EQ(static_cast<int>(sizeof(query)), SSL_write(ssl, query, sizeof(query)));
+  uint8_t buf[sizeof(query)];
+  EXPECT_EQ(static_cast<ssize_t>(sizeof(query)), read_some(*client_tls_, router_client_, buf, sizeof(buf)));
+  EXPECT_EQ(0, memcmp(query, buf, sizeof(query)));
+
+  SSL_free(ssl);
+  SSL_CTX_free(client_ctx);
+}
+
+/**
+ * @test Reading from the TLS connection doesn't block if the client sent
+ *       nothing, and large writes wait for the client to take the data.
+ */
+TEST_F(ClientTlsTest, NonBlockingIo) {
+  auto router = run_router_handshake(routing::ClientSslMode::kPreferred);
+
+  SSL_CTX *client_ctx = SSL_CTX_new(SSLv23_client_method());
+  ASSERT_NE(nullptr, client_ctx);
+  SSL_CTX_set_verify(client_ctx, SSL_VERIFY_NONE, nullptr);
+  SSL *ssl = start_tls_session(client_ctx);
+
+  const Buffer ok = make_packet(2, {0, 0, 0, 2, 0, 0, 0});
+  ASSERT_EQ(static_cast<ssize_t>(ok.size()), ::send(server_, ok.data(), ok.size(), 0));
+  read_packet(ssl);
+  ASSERT_EQ(0, router.get());
+  ASSERT_NE(nullptr, client_tls_);
+
+  uint8_t buf[16];
+  errno = 0;
+  EXPECT_EQ(-1, client_tls_->read(buf, sizeof(buf)));
+  EXPECT_EQ(EAGAIN, errno);
+
+  // more than the socket buffers hold
+  const Buffer data(4 * 1024 * 1024, 'x');
+  auto writer = std::async(std::launch::async, [this, &data]() {
+    return client_tls_->write_all(data.data(), data.size());
+  });
+  Buffer received(data.size());
+  size_t pos = 0;
+  while (pos < received.size()) {
+    const int res = SSL_read(ssl, &received[pos], static_cast<int>(received.size() - pos));
+    ASSERT_GT(res, 0);
+    pos += static_cast<size_t>(res);
+  }
+  EXPECT_EQ(static_cast<ssize_t>(data.size()), writer.get());
+  EXPECT_EQ(data, received);
+
+  SSL_free(ssl);
+  SSL_CTX_free(client_ctx);
+}
+
+#ifdef HAVE_YASSL
+
+/**
+ * @test The client gets an error instead of sending its password in clear
+ *       text if the server asks for caching_sha2_password full
+ *       authentication: the TCP server connection is not encrypted and
+ *       yaSSL can't encrypt the password with the server's RSA key.
+ */
+TEST_F(ClientTlsTest, FullAuthRefused) {
+  auto router = run_router_handshake(routing::ClientSslMode::kPreferred);
+
+  SSL_CTX *client_ctx = SSL_CTX_new(SSLv23_client_method());
+  ASSERT_NE(nullptr, client_ctx);
+  SSL_CTX_set_verify(client_ctx, SSL_VERIFY_NONE, nullptr);
+  SSL *ssl = start_tls_session(client_ctx);
+
+  const Buffer full_auth = make_packet(2, {0x01, 0x04});
+  ASSERT_EQ(static_cast<ssize_t>(full_auth.size()), ::send(server_, full_auth.data(), full_auth.size(), 0));
+
+  const Buffer error = read_packet(ssl);
+  EXPECT_EQ(3, error[3]);
+  EXPECT_EQ(0xff, error[4]);
+  EXPECT_EQ(-1, router.get());
+
+  SSL_free(ssl);
+  SSL_CTX_free(client_ctx);
+}
+
+#else
+
+/**
+ * @test caching_sha2_password full authentication over TCP: the router
+ *       takes the password from the TLS client and sends it encrypted with
+ *       the server's RSA public key. The client doesn't see the key
+ *       exchange.
+ */
+TEST_F(ClientTlsTest, FullAuthRsa) {
+  auto router = run_router_handshake(routing::ClientSslMode::kPreferred);
+
+  SSL_CTX *client_ctx = SSL_CTX_new(SSLv23_client_method());
+  ASSERT_NE(nullptr, client_ctx);
+  SSL_CTX_set_verify(client_ctx, SSL_VERIFY_NONE, nullptr);
+  SSL *ssl = start_tls_session(client_ctx);
+
+  const Buffer nonce(20, 's');
+  const Buffer auth_switch = make_sha2_auth_switch(2, nonce);
+  ASSERT_EQ(static_cast<ssize_t>(auth_switch.size()), ::send(server_, auth_switch.data(), auth_switch.size(), 0));
+  EXPECT_EQ(3, read_packet(ssl)[3]);
+  const Buffer auth_data = make_packet(4, Buffer(32, 1));
+  ASSERT_EQ(static_cast<int>(auth_data.size()), SSL_write(ssl, auth_data.data(), static_cast<int>(auth_data.size())));
+  EXPECT_EQ(3, read_packet(server_)[3]);
+
+  const Buffer full_auth = make_packet(4, {0x01, 0x04});
+  ASSERT_EQ(static_cast<ssize_t>(full_auth.size()), ::send(server_, full_auth.data(), full_auth.size(), 0));
+  EXPECT_EQ(make_packet(5, {0x01, 0x04}), read_packet(ssl));
+  const Buffer password = make_packet(6, {'s', 'e', 'c', 'r', 'e', 't', 0});
+  ASSERT_EQ(static_cast<int>(password.size()), SSL_write(ssl, password.data(), static_cast<int>(password.size())));
+
+  // the server is asked for its public key and gets the password encrypted
+  EXPECT_EQ(make_packet(5, {0x02}), read_packet(server_));
+  Buffer key{0x01};
+  const std::string public_key = get_public_key();
+  key.insert(key.end(), public_key.begin(), public_key.end());
+  const Buffer key_packet = make_packet(6, key);
+  ASSERT_EQ(static_cast<ssize_t>(key_packet.size()), ::send(server_, key_packet.data(), key_packet.size(), 0));
+
+  const Buffer encrypted = read_packet(server_);
+  EXPECT_EQ(7, encrypted[3]);
+  Buffer plain = decrypt_password(Buffer(encrypted.begin() + 4, encrypted.end()));
+  for (size_t i = 0; i < plain.size(); ++i) plain[i] = static_cast<uint8_t>(plain[i] ^ nonce[i % nonce.size()]);
+  EXPECT_EQ(Buffer({'s', 'e', 'c', 'r', 'e', 't', 0}), plain);
+
+  const Buffer ok = make_packet(8, {0, 0, 0, 2, 0, 0, 0});
+  ASSERT_EQ(static_cast<ssize_t>(ok.size()), ::send(server_, ok.data(), ok.size(), 0));
+  const Buffer packet = read_packet(ssl);
+  EXPECT_EQ(7, packet[3]);
+  EXPECT_EQ(0, packet[4]);
+  EXPECT_EQ(0, router.get());
+
+  SSL_free(ssl);
+  SSL_CTX_free(client_ctx);
+}
+
+#endif // HAVE_YASSL
+
+/**
+ * @test Servers reached over a Unix socket get the password of full
+ *       authentication in clear text, as if the client was connected.
+ */
+TEST_F(ClientTlsTest, FullAuthOverUnixSocket) {
+  ::close(router_server_);
+  ::close(server_);
+  int fds[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+  router_server_ = fds[0];
+  server_ = fds[1];
+
+  auto router = run_router_handshake(routing::ClientSslMode::kPreferred);
+
+  SSL_CTX *client_ctx = SSL_CTX_new(SSLv23_client_method());
+  ASSERT_NE(nullptr, client_ctx);
+  SSL_CTX_set_verify(client_ctx, SSL_VERIFY_NONE, nullptr);
+  SSL *ssl = start_tls_session(client_ctx);
+
+  const Buffer full_auth = make_packet(2, {0x01, 0x04});
+  ASSERT_EQ(static_cast<ssize_t>(full_auth.size()), ::send(server_, full_auth.data(), full_auth.size(), 0));
+  EXPECT_EQ(make_packet(3, {0x01, 0x04}), read_packet(ssl));
+
+  const Buffer password = make_packet(4, {'s', 'e', 'c', 'r', 'e', 't', 0});
+  ASSERT_EQ(static_cast<int>(password.size()), SSL_write(ssl, password.data(), static_cast<int>(password.size())));
+  EXPECT_EQ(make_packet(3, {'s', 'e', 'c', 'r', 'e', 't', 0}), read_packet(server_));
+
+  const Buffer ok = make_packet(4, {0, 0, 0, 2, 0, 0, 0});
+  ASSERT_EQ(static_cast<ssize_t>(ok.size()), ::send(server_, ok.data(), ok.size(), 0));
+  EXPECT_EQ(5, read_packet(ssl)[3]);
+  EXPECT_EQ(0, router.get());
+
+  SSL_free(ssl);
+  SSL_CTX_free(client_ctx);
+}
+
+/**
+ * @test An auth-switch to mysql_clear_password is refused as well.
+ */
+TEST_F(ClientTlsTest, ClearPasswordSwitchRefused) {
+  auto router = run_router_handshake(routing::ClientSslMode::kPreferred);
+
+  SSL_CTX *client_ctx = SSL_CTX_new(SSLv23_client_method());
+  ASSERT_NE(nullptr, client_ctx);
+  SSL_CTX_set_verify(client_ctx, SSL_VERIFY_NONE, nullptr);
+  SSL *ssl = start_tls_session(client_ctx);
+
+  Buffer payload{0xfe};
+  const std::string plugin("mysql_clear_password");
+  payload.insert(payload.end(), plugin.begin(), plugin.end());
+  payload.push_back(0);
+  const Buffer auth_switch = make_packet(2, payload);
+  ASSERT_EQ(static_cast<ssize_t>(auth_switch.size()), ::send(server_, auth_switch.data(), auth_switch.size(), 0));
+
+  const Buffer error = read_packet(ssl);
+  EXPECT_EQ(3, error[3]);
+  EXPECT_EQ(0xff, error[4]);
+  EXPECT_EQ(-1, router.get());
+
+  SSL_free(ssl);
+  SSL_CTX_free(client_ctx);
+}
+
+/**
+ * @test Plain clients are passed on if TLS is preferred.
+ */
+TEST_F(ClientTlsTest, PlainClientPreferred) {
+  auto router = run_router_handshake(routing::ClientSslMode::kPreferred);
+
+  const Buffer greeting = make_greeting();
+  ASSERT_EQ(static_cast<ssize_t>(greeting.size()), ::send(server_, greeting.data(), greeting.size(), 0));
+  read_packet(client_);
+
+  const Buffer response = make_response(1, mysql_protocol::Capabilities::PROTOCOL_41, false);
+  ASSERT_EQ(static_cast<ssize_t>(response.size()), ::send(client_, response.data(), response.size(), 0));
+
+  EXPECT_EQ(response, read_packet(server_));
+  EXPECT_EQ(0, router.get());
+  EXPECT_EQ(1, pktnr_);
+  EXPECT_EQ(nullptr, client_tls_);
+}
+
+/**
+ * @test Plain clients get an error if TLS is required.
+ */
+TEST_F(ClientTlsTest, PlainClientRequired) {
+  auto router = run_router_handshake(routing::ClientSslMode::kRequired);
+
+  const Buffer greeting = make_greeting();
+  ASSERT_EQ(static_cast<ssize_t>(greeting.size()), ::send(server_, greeting.data(), greeting.size(), 0));
+  read_packet(client_);
+
+  const Buffer response = make_response(1, mysql_protocol::Capabilities::PROTOCOL_41, false);
+  ASSERT_EQ(static_cast<ssize_t>(response.size()), ::send(client_, response.data(), response.size(), 0));
+
+  const Buffer error = read_packet(client_);
+  EXPECT_EQ(0xff, error[4]);
+  EXPECT_EQ(-1, router.get());
+}
+
+#endif // !_WIN32
+
+int main(int argc, char *argv[]) {
+  init_test_logger();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -142,7 +142,7 @@ TEST_F(TestConfig, InvalidMode) {
 
   MySQLRouter r(g_origin, {"-c", config_path->str()});
   ASSERT_THROW_LIKE(r.start(), std::invalid_argument,
-      "option mode in [routing] is invalid; valid are read-write and read-only (was 'invalid')");
+      "option mode in [routing] is invalid; valid are read-write, read-only, and read-write-split (was 'invalid')");
 }
 
 TEST_F(TestConfig, InvalidStrategyOption) {
@@ -0,0 +1,564 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "test/helpers.h"
+
+#include "gtest/gtest.h"
+
+#ifndef _WIN32
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "connection_pool.h"
+#include "mysqlrouter/routing.h"
+#include "protocol/classic_protocol.h"
+#include "socket_operations.h"
+
+using mysql_harness::TCPAddress;
+using mysql_protocol::Capabilities::Flags;
+using Buffer = std::vector<uint8_t>;
+
+namespace {
+
+const std::chrono::milliseconds kTimeout{5000};
+
+Buffer make_packet(uint8_t seq, const Buffer &payload) {
+  Buffer packet{static_cast<uint8_t>(payload.size()),
+                static_cast<uint8_t>(payload.size() >> 8),
+                static_cast<uint8_t>(payload.size() >> 16),
+                seq};
+  packet.insert(packet.end(), payload.begin(), payload.end());
+  return packet;
+}
+
+Buffer read_packet(int fd) {
+  Buffer header(4);
+  EXPECT_EQ(4, ::recv(fd, header.data(), header.size(), MSG_WAITALL));
+  Buffer packet(header);
+  packet.resize(4 + (header[0] | header[1] << 8 | header[2] << 16));
+  if (packet.size() > 4) {
+    EXPECT_EQ(static_cast<ssize_t>(packet.size() - 4),
+              ::recv(fd, &packet[4], packet.size() - 4, MSG_WAITALL));
+  }
+  return packet;
+}
+
+void send_packet(int fd, const Buffer &packet) {
+  ASSERT_EQ(static_cast<ssize_t>(packet.size()), ::send(fd, packet.data(), packet.size(), 0));
+}
+
+// true if the peer of fd closed its end
+bool is_closed(int fd) {
+  uint8_t byte;
+  return ::recv(fd, &byte, 1, MSG_DONTWAIT) == 0;
+}
+
+}
+
+class ConnectionPoolTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    for (int fd : server_ends_) {
+      ::close(fd);
+    }
+  }
+
+  PooledServerConnection make_connection(const TCPAddress &address = TCPAddress("127.0.0.1", 3306),
+                                         std::chrono::steady_clock::time_point idle_since =
+                                             std::chrono::steady_clock::now()) {
+    int fds[2];
+    EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    server_ends_.push_back(fds[1]);
+    return PooledServerConnection{fds[0], address, Buffer(), Flags(), idle_since};
+  }
+
+  mysql_harness::SocketOperationsBase *so_ = mysql_harness::SocketOperations::instance();
+  std::vector<int> server_ends_;
+};
+
+/**
+ * @test The connection added last is reserved first and taken once.
+ */
+TEST_F(ConnectionPoolTest, ReserveReturnsLastAdded) {
+  const TCPAddress server("127.0.0.1", 3306);
+  ConnectionPool pool(so_, 4, std::chrono::seconds(60));
+  EXPECT_EQ(-1, pool.reserve(server));
+
+  const auto first = make_connection();
+  const auto second = make_connection();
+  pool.add(first);
+  pool.add(second);
+
+  EXPECT_EQ(second.fd, pool.reserve(server));
+  EXPECT_EQ(first.fd, pool.reserve(server));
+  EXPECT_EQ(-1, pool.reserve(server));
+
+  PooledServerConnection connection;
+  ASSERT_TRUE(pool.take_reserved(first.fd, connection));
+  EXPECT_EQ(first.fd, connection.fd);
+  EXPECT_FALSE(pool.take_reserved(first.fd, connection));
+  ASSERT_TRUE(pool.take_reserved(second.fd, connection));
+
+  const auto stats = pool.get_stats();
+  EXPECT_EQ(2u, stats.added);
+  EXPECT_EQ(2u, stats.reused);
+  EXPECT_EQ(0u, stats.idle);
+  EXPECT_EQ(4u, stats.max_idle);
+
+  so_->close(first.fd);
+  so_->close(second.fd);
+}
+
+/**
+ * @test Only connections to the server the destination picked are reserved.
+ */
+TEST_F(ConnectionPoolTest, ReserveByAddress) {
+  ConnectionPool pool(so_, 4, std::chrono::seconds(60));
+  const auto first = make_connection(TCPAddress("127.0.0.1", 3306));
+  const auto second = make_connection(TCPAddress("127.0.0.1", 3307));
+  pool.add(first);
+  pool.add(second);
+
+  EXPECT_EQ(-1, pool.reserve(TCPAddress("127.0.0.1", 3308)));
+  EXPECT_EQ(first.fd, pool.reserve(TCPAddress("127.0.0.1", 3306)));
+  EXPECT_EQ(1u, pool.get_stats().idle);
+  EXPECT_FALSE(is_closed(server_ends_[1]));
+
+  // a socket the pool didn't hand out is not taken
+  PooledServerConnection connection;
+  EXPECT_FALSE(pool.take_reserved(second.fd, connection));
+}
+
+/**
+ * @test A full pool closes the connection idling the longest.
+ */
+TEST_F(ConnectionPoolTest, FullPoolClosesOldest) {
+  ConnectionPool pool(so_, 2, std::chrono::seconds(60));
+  for (int i = 0; i < 3; ++i) {
+    pool.add(make_connection());
+  }
+
+  EXPECT_TRUE(is_closed(server_ends_[0]));
+  EXPECT_FALSE(is_closed(server_ends_[1]));
+  EXPECT_EQ(2u, pool.get_stats().idle);
+}
+
+/**
+ * @test Connections idling longer than the timeout or closed by the server
+ *       are not handed out.
+ */
+TEST_F(ConnectionPoolTest, UnusableConnectionsAreClosed) {
+  ConnectionPool pool(so_, 4, std::chrono::seconds(60));
+  pool.add(make_connection(TCPAddress("127.0.0.1", 3306),
+                           std::chrono::steady_clock::now() - std::chrono::seconds(61)));
+  pool.add(make_connection());
+  ::shutdown(server_ends_[1], SHUT_WR);
+
+  EXPECT_EQ(-1, pool.reserve(TCPAddress("127.0.0.1", 3306)));
+  EXPECT_TRUE(is_closed(server_ends_[0]));
+  EXPECT_EQ(2u, pool.get_stats().expired);
+}
+
+/**
+ * @test Connections to servers which are no longer allowed are closed.
+ */
+TEST_F(ConnectionPoolTest, RemoveNotAllowed) {
+  ConnectionPool pool(so_, 4, std::chrono::seconds(60));
+  const auto kept = make_connection(TCPAddress("127.0.0.1", 3306));
+  pool.add(kept);
+  pool.add(make_connection(TCPAddress("127.0.0.1", 3307)));
+
+  pool.remove_not_allowed({TCPAddress("127.0.0.1", 3306)});
+  EXPECT_TRUE(is_closed(server_ends_[1]));
+
+  EXPECT_EQ(-1, pool.reserve(TCPAddress("127.0.0.1", 3307)));
+  EXPECT_EQ(kept.fd, pool.reserve(TCPAddress("127.0.0.1", 3306)));
+}
+
+namespace {
+
+Buffer column_def() {
+  return make_packet(2, {3, 'd', 'e', 'f', 0, 0, 0, 1, 'a', 0, 0x0c, 0x3f, 0, 0, 0, 0, 0,
+                         8, 0, 0, 0, 0});
+}
+
+const Buffer kOk = make_packet(1, {0, 0, 0, 2, 0, 0, 0});
+const Buffer kEof = make_packet(3, {0xfe, 0, 0, 2, 0});
+
+// feeds packets and returns whether the session is idle after each
+std::vector<bool> feed(ClassicSessionTracker &tracker,
+                       const std::vector<std::pair<bool, Buffer>> &packets) {
+  std::vector<bool> idle;
+  for (const auto &packet : packets) {
+    if (packet.first) {
+      tracker.update_client(packet.second.data(), packet.second.size());
+    } else {
+      tracker.update_server(packet.second.data(), packet.second.size());
+    }
+    idle.push_back(tracker.is_idle());
+  }
+  return idle;
+}
+
+const bool kClient = true;
+const bool kServer = false;
+
+}
+
+/**
+ * @test Packet boundaries are found in data split at any position.
+ */
+TEST(ClassicSessionTrackerTest, SplitPackets) {
+  const Buffer query = make_packet(0, {3, 'S', 'E', 'L'});
+
+  for (size_t split = 1; split < query.size(); ++split) {
+    ClassicSessionTracker tracker(false);
+    tracker.update_client(query.data(), split);
+    EXPECT_FALSE(tracker.is_idle());
+    tracker.update_client(query.data() + split, query.size() - split);
+    EXPECT_FALSE(tracker.is_idle());
+
+    tracker.update_server(kOk.data(), split);
+    EXPECT_FALSE(tracker.is_idle());
+    tracker.update_server(kOk.data() + split, kOk.size() - split);
+    EXPECT_TRUE(tracker.is_idle());
+  }
+}
+
+/**
+ * @test Rows which look like OK or EOF packets don't end a result set.
+ */
+TEST(ClassicSessionTrackerTest, ResultSet) {
+  ClassicSessionTracker tracker(false);
+  EXPECT_EQ(std::vector<bool>({false, false, false, false, false, false, false, true}),
+            feed(tracker, {
+                {kClient, make_packet(0, {3, 'S', 'E', 'L'})},
+                {kServer, make_packet(1, {1})},                          // column count
+                {kServer, column_def()},
+                {kServer, kEof},
+                {kServer, make_packet(4, {0, 0, 0, 2, 0, 0, 0, 0})},     // row of empty strings
+                {kServer, make_packet(5, {0xfb, 0xfb})},                 // row of NULLs
+                {kServer, make_packet(6, {1, 'a'})},
+                {kServer, make_packet(7, {0xfe, 0, 0, 2, 0})},
+            }));
+}
+
+/**
+ * @test With CLIENT_DEPRECATE_EOF only an OK packet with 0xfe header ends rows.
+ */
+TEST(ClassicSessionTrackerTest, DeprecateEof) {
+  ClassicSessionTracker tracker(true);
+  EXPECT_EQ(std::vector<bool>({false, false, false, false, true}),
+            feed(tracker, {
+                {kClient, make_packet(0, {3, 'S', 'E', 'L'})},
+                {kServer, make_packet(1, {1})},
+                {kServer, column_def()},
+                {kServer, make_packet(3, {0, 0, 0, 2, 0, 0, 0})},  // looks like OK
+                {kServer, make_packet(4, {0xfe, 0, 0, 2, 0, 0, 0})},
+            }));
+}
+
+/**
+ * @test Multiple results continue until a status without
+ *       SERVER_MORE_RESULTS_EXISTS; an error ends them.
+ */
+TEST(ClassicSessionTrackerTest, MultipleResults) {
+  ClassicSessionTracker tracker(false);
+  EXPECT_EQ(std::vector<bool>({false, false, false, false, false, true, false, false, true}),
+            feed(tracker, {
+                {kClient, make_packet(0, {3, 'S', 'E', 'L'})},
+                {kServer, make_packet(1, {0, 0, 0, 0x0a, 0, 0, 0})},  // OK, more results
+                {kServer, make_packet(2, {1})},
+                {kServer, column_def()},
+                {kServer, kEof},
+                {kServer, make_packet(5, {0xfe, 0, 0, 2, 0})},
+                {kClient, make_packet(0, {3, 'S', 'E', 'L'})},
+                {kServer, make_packet(1, {0, 0, 0, 0x0a, 0, 0, 0})},
+                {kServer, make_packet(2, {0xff, 0x15, 0x04, '#'})},
+            }));
+}
+
+/**
+ * @test The parameter and column definitions of a prepare are counted,
+ *       COM_STMT_CLOSE has no response.
+ */
+TEST(ClassicSessionTrackerTest, Prepare) {
+  ClassicSessionTracker tracker(false);
+  EXPECT_EQ(std::vector<bool>({false, false, false, false, false, true, true}),
+            feed(tracker, {
+                {kClient, make_packet(0, {mysql_protocol::Command::STMT_PREPARE, 'S'})},
+                // statement 1 with 1 column and 1 parameter
+                {kServer, make_packet(1, {0, 1, 0, 0, 0, 1, 0, 1, 0, 0, 0, 0})},
+                {kServer, column_def()},
+                {kServer, kEof},
+                {kServer, column_def()},
+                {kServer, kEof},
+                {kClient, make_packet(0, {mysql_protocol::Command::STMT_CLOSE, 1, 0, 0, 0})},
+            }));
+}
+
+/**
+ * @test The file of a LOCAL INFILE request ends with an empty packet.
+ */
+TEST(ClassicSessionTrackerTest, LocalInfile) {
+  ClassicSessionTracker tracker(false);
+  EXPECT_EQ(std::vector<bool>({false, false, false, false, true}),
+            feed(tracker, {
+                {kClient, make_packet(0, {3, 'L'})},
+                {kServer, make_packet(1, {0xfb, 'f'})},
+                {kClient, make_packet(2, {0, 0, 0, 2, 0, 0, 0})},
+                {kClient, make_packet(3, {})},
+                {kServer, make_packet(4, {0, 1, 0, 2, 0, 0, 0})},
+            }));
+}
+
+/**
+ * @test Sessions the tracker can't follow are never idle again.
+ */
+TEST(ClassicSessionTrackerTest, UnknownIsSticky) {
+  const Buffer query = make_packet(0, {3, 'S', 'E', 'L'});
+  struct {
+    std::vector<std::pair<bool, Buffer>> packets;
+  } cases[] = {
+    // pipelined commands
+    {{{kClient, query}, {kClient, query}, {kServer, kOk}, {kServer, kOk}}},
+    // COM_CHANGE_USER
+    {{{kClient, make_packet(0, {mysql_protocol::Command::CHANGE_USER, 'u', 0})},
+      {kServer, kOk}}},
+    // COM_STMT_EXECUTE opening a cursor
+    {{{kClient, make_packet(0, {mysql_protocol::Command::STMT_EXECUTE, 1, 0, 0, 0, 1,
+                                1, 0, 0, 0})},
+      {kServer, make_packet(1, {1})}, {kServer, column_def()}, {kServer, kEof}}},
+    // data from the server on an idle session
+    {{{kServer, make_packet(0, {0xff, 0x15, 0x04, '#'})}}},
+  };
+
+  for (const auto &c : cases) {
+    ClassicSessionTracker tracker(false);
+    feed(tracker, c.packets);
+    EXPECT_FALSE(tracker.is_idle());
+    feed(tracker, {{kClient, query}, {kServer, kOk}});
+    EXPECT_FALSE(tracker.is_idle());
+  }
+}
+
+class ClassicPoolingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    client_ = fds[0];
+    router_client_ = fds[1];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    router_server_ = fds[0];
+    server_ = fds[1];
+  }
+
+  void TearDown() override {
+    for (int fd : {client_, router_client_, router_server_, server_}) {
+      ::close(fd);
+    }
+  }
+
+  ClassicProtocol protocol_{routing::RoutingSockOps::instance(
+      mysql_harness::SocketOperations::instance())};
+  int client_, router_client_, router_server_, server_;
+};
+
+/**
+ * @test A client authenticated on a pooled connection is sent as
+ *       COM_CHANGE_USER, the replies get the client's sequence ids.
+ */
+TEST_F(ClassicPoolingTest, ChangeUser) {
+  const Flags caps = mysql_protocol::Capabilities::PROTOCOL_41 |
+                     mysql_protocol::Capabilities::SECURE_CONNECTION |
+                     mysql_protocol::Capabilities::CONNECT_WITH_DB;
+  const uint32_t bits = caps.bits();
+  Buffer payload{static_cast<uint8_t>(bits), static_cast<uint8_t>(bits >> 8),
+                 static_cast<uint8_t>(bits >> 16), static_cast<uint8_t>(bits >> 24),
+                 0, 0, 0, 1, 8};
+  payload.resize(32, 0);
+  payload.insert(payload.end(), {'r', 'o', 'o', 't', 0, 2, 0xaa, 0xbb, 't', 'e', 's', 't', 0});
+  const Buffer response = make_packet(1, payload);
+
+  bool authenticated = false;
+  auto router = std::async(std::launch::async, [&]() {
+    return protocol_.authenticate(router_client_, nullptr, router_server_, {}, response,
+                                  true, false, caps, kTimeout, &authenticated, "test");
+  });
+
+  const Buffer expected = mysql_protocol::ChangeUserPacket(
+      0, "root", {0xaa, 0xbb}, "test", 8, "", {}, caps);
+  EXPECT_EQ(expected, read_packet(server_));
+
+  send_packet(server_, make_packet(1, {0, 0, 0, 2, 0, 0, 0}));
+  const Buffer ok = read_packet(client_);
+  EXPECT_EQ(2, ok[3]);
+  EXPECT_EQ(0, ok[4]);
+
+  EXPECT_EQ(0, router.get());
+  EXPECT_TRUE(authenticated);
+}
+
+/**
+ * @test A client on a pooled connection answered the router's scramble:
+ *       COM_CHANGE_USER asks the server for an auth-switch with its own.
+ */
+TEST_F(ClassicPoolingTest, ChangeUserForcesAuthSwitch) {
+  const Flags caps = mysql_protocol::Capabilities::PROTOCOL_41 |
+                     mysql_protocol::Capabilities::SECURE_CONNECTION |
+                     mysql_protocol::Capabilities::PLUGIN_AUTH;
+  const uint32_t bits = caps.bits();
+  Buffer payload{static_cast<uint8_t>(bits), static_cast<uint8_t>(bits >> 8),
+                 static_cast<uint8_t>(bits >> 16), static_cast<uint8_t>(bits >> 24),
+                 0, 0, 0, 1, 8};
+  payload.resize(32, 0);
+  payload.insert(payload.end(), {'r', 'o', 'o', 't', 0, 2, 0xaa, 0xbb});
+  for (const char c : std::string("mysql_native_password")) {
+    payload.push_back(static_cast<uint8_t>(c));
+  }
+  payload.push_back(0);
+  const Buffer response = make_packet(1, payload);
+
+  bool authenticated = false;
+  auto router = std::async(std::launch::async, [&]() {
+    return protocol_.authenticate(router_client_, nullptr, router_server_, {}, response,
+                                  true, true, caps, kTimeout, &authenticated, "test");
+  });
+
+  const Buffer expected = mysql_protocol::ChangeUserPacket(
+      0, "root", {}, "", 8, "mysqlrouter_auth_switch", {}, caps);
+  EXPECT_EQ(expected, read_packet(server_));
+
+  // auth-switch with the server's scramble, passed on to the client
+  Buffer auth_switch{0xfe};
+  for (const char c : std::string("mysql_native_password")) {
+    auth_switch.push_back(static_cast<uint8_t>(c));
+  }
+  auth_switch.push_back(0);
+  auth_switch.insert(auth_switch.end(), 20, 's');
+  auth_switch.push_back(0);
+  send_packet(server_, make_packet(1, auth_switch));
+  EXPECT_EQ(make_packet(2, auth_switch), read_packet(client_));
+
+  send_packet(client_, make_packet(3, Buffer(20, 'r')));
+  EXPECT_EQ(make_packet(2, Buffer(20, 'r')), read_packet(server_));
+  send_packet(server_, make_packet(3, {0, 0, 0, 2, 0, 0, 0}));
+  EXPECT_EQ(4, read_packet(client_)[3]);
+
+  EXPECT_EQ(0, router.get());
+  EXPECT_TRUE(authenticated);
+}
+
+/**
+ * @test A session is reset only if the server answers with a lone OK.
+ */
+TEST_F(ClassicPoolingTest, ResetSession) {
+  auto router = std::async(std::launch::async, [&]() {
+    return protocol_.reset_session(router_server_, kTimeout, "test");
+  });
+  EXPECT_EQ(make_packet(0, {mysql_protocol::Command::RESET_CONNECTION}), read_packet(server_));
+  send_packet(server_, make_packet(1, {0, 0, 0, 2, 0, 0, 0}));
+  EXPECT_TRUE(router.get());
+
+  router = std::async(std::launch::async, [&]() {
+    return protocol_.reset_session(router_server_, kTimeout, "test");
+  });
+  read_packet(server_);
+  send_packet(server_, make_packet(1, {0xff, 0x15, 0x04, '#'}));
+  EXPECT_FALSE(router.get());
+
+  // an OK announcing more results
+  router = std::async(std::launch::async, [&]() {
+    return protocol_.reset_session(router_server_, kTimeout, "test");
+  });
+  read_packet(server_);
+  send_packet(server_, make_packet(1, {0, 0, 0, 0x0a, 0, 0, 0}));
+  EXPECT_FALSE(router.get());
+}
+
+/**
+ * @test Capabilities are read from and written to the server greeting.
+ */
+TEST(ClassicGreetingTest, Capabilities) {
+  Buffer greeting = make_packet(0, {10, '8', 0, 1, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 0,
+                                    0x00, 0x82, 8, 2, 0, 0x0f, 0x00});
+  EXPECT_EQ(Flags(0x000f8200), ClassicProtocol::get_greeting_capabilities(greeting));
+
+  ASSERT_TRUE(ClassicProtocol::set_greeting_capabilities(greeting, Flags(0x00010200)));
+  EXPECT_EQ(Flags(0x00010200), ClassicProtocol::get_greeting_capabilities(greeting));
+
+  Buffer error = make_packet(0, {0xff, 0x10, 0x04});
+  EXPECT_FALSE(ClassicProtocol::set_greeting_capabilities(error, Flags()));
+}
+
+/**
+ * @test Renewing the scramble of a greeting changes nothing else.
+ */
+TEST(ClassicGreetingTest, RenewScramble) {
+  Buffer payload{10, '8', 0, 1, 0, 0, 0};
+  payload.insert(payload.end(), 8, 'a');                    // scramble part 1
+  payload.insert(payload.end(), {0, 0x00, 0x82, 8, 2, 0, 0x0f, 0x00, 21});
+  payload.insert(payload.end(), 10, 0);                     // reserved
+  payload.insert(payload.end(), 12, 'b');                   // scramble part 2
+  payload.push_back(0);
+  for (const char c : std::string("mysql_native_password")) {
+    payload.push_back(static_cast<uint8_t>(c));
+  }
+  payload.push_back(0);
+  const Buffer original = make_packet(0, payload);
+
+  Buffer greeting = original;
+  ASSERT_TRUE(ClassicProtocol::renew_greeting_scramble(greeting));
+  ASSERT_EQ(original.size(), greeting.size());
+
+  const size_t part1 = 4 + 7;
+  const size_t part2 = part1 + 8 + 9 + 10;
+  EXPECT_FALSE(std::equal(original.begin() + part1, original.begin() + part1 + 8,
+                          greeting.begin() + part1));
+  EXPECT_FALSE(std::equal(original.begin() + part2, original.begin() + part2 + 12,
+                          greeting.begin() + part2));
+  for (size_t i = 0; i < greeting.size(); ++i) {
+    if ((i >= part1 && i < part1 + 8) || (i >= part2 && i < part2 + 12)) continue;
+    EXPECT_EQ(original[i], greeting[i]) << i;
+  }
+
+  Buffer error = make_packet(0, {0xff, 0x10, 0x04});
+  EXPECT_FALSE(ClassicProtocol::renew_greeting_scramble(error));
+}
+
+#endif // !_WIN32
+
+int main(int argc, char *argv[]) {
+  init_test_logger();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
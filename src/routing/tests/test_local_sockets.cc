@@ -0,0 +1,187 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/socket.h>
+#  include <sys/un.h>
+#  include <unistd.h>
+#endif
+
+#include "dest_first_available.h"
+#include "mysql/harness/filesystem.h"
+#include "routing_mocks.h"
+#include "test/helpers.h"
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::InvokeWithoutArgs;
+using ::testing::Return;
+
+class LocalSocketsTest : public ::testing::Test {
+ public:
+  LocalSocketsTest() : routing_sock_ops_(new MockRoutingSockOps()),
+                       dest_(Protocol::Type::kClassicProtocol, routing_sock_ops_.get()) {
+    EXPECT_CALL(*routing_sock_ops_->so(), get_local_hostname())
+        .WillRepeatedly(Return("router-host"));
+  }
+
+ protected:
+  std::unique_ptr<MockRoutingSockOps> routing_sock_ops_;
+  DestFirstAvailable dest_;
+};
+
+/**
+ * @test Destinations on the local host whose port has a socket configured
+ *       are connected to over the Unix socket.
+ */
+TEST_F(LocalSocketsTest, LocalDestinationUsesUnixSocket) {
+  int dummy;
+
+  dest_.add("127.0.0.1", 3306);
+  dest_.set_local_sockets({{3306, "/tmp/mysql.sock"}});
+
+  ASSERT_EQ(dest_.get_server_socket(std::chrono::seconds::zero(), &dummy),
+            MockRoutingSockOps::unix_socket_fd());
+  EXPECT_EQ(routing_sock_ops_->get_mysql_unix_socket_call_cnt(), 1);
+  EXPECT_EQ(routing_sock_ops_->get_mysql_socket_call_cnt(), 0);
+}
+
+/**
+ * @test Destinations given by the local hostname are considered local too.
+ */
+TEST_F(LocalSocketsTest, LocalHostnameUsesUnixSocket) {
+  int dummy;
+
+  dest_.add("router-host", 3306);
+  dest_.set_local_sockets({{3306, "/tmp/mysql.sock"}});
+
+  ASSERT_EQ(dest_.get_server_socket(std::chrono::seconds::zero(), &dummy),
+            MockRoutingSockOps::unix_socket_fd());
+  EXPECT_EQ(routing_sock_ops_->get_mysql_unix_socket_call_cnt(), 1);
+  EXPECT_EQ(routing_sock_ops_->get_mysql_socket_call_cnt(), 0);
+}
+
+/**
+ * @test Remote destinations and local destinations on a port without socket
+ *       keep using TCP.
+ */
+TEST_F(LocalSocketsTest, OtherDestinationsUseTcp) {
+  int dummy;
+
+  dest_.add("42", 3306);
+  dest_.add("127.0.0.1", 3307);
+  dest_.set_local_sockets({{3306, "/tmp/mysql.sock"}});
+
+  ASSERT_EQ(dest_.get_server_socket(std::chrono::seconds::zero(), &dummy), 42);
+  EXPECT_EQ(routing_sock_ops_->get_mysql_unix_socket_call_cnt(), 0);
+  EXPECT_EQ(routing_sock_ops_->get_mysql_socket_call_cnt(), 1);
+
+  // first destination fails, second one is local but has no socket
+  routing_sock_ops_->get_mysql_socket_fail(1);
+  ASSERT_EQ(dest_.get_server_socket(std::chrono::seconds::zero(), &dummy), 127);
+  EXPECT_EQ(routing_sock_ops_->get_mysql_unix_socket_call_cnt(), 0);
+  EXPECT_EQ(routing_sock_ops_->get_mysql_socket_call_cnt(), 2);
+}
+
+/**
+ * @test If the Unix socket can't be connected to, TCP is used instead.
+ */
+TEST_F(LocalSocketsTest, FallbackToTcp) {
+  int dummy;
+
+  dest_.add("127.0.0.1", 3306);
+  dest_.set_local_sockets({{3306, "/tmp/mysql.sock"}});
+
+  routing_sock_ops_->get_mysql_unix_socket_fail(1);
+  ASSERT_EQ(dest_.get_server_socket(std::chrono::seconds::zero(), &dummy), 127);
+  EXPECT_EQ(routing_sock_ops_->get_mysql_unix_socket_call_cnt(), 1);
+  EXPECT_EQ(routing_sock_ops_->get_mysql_socket_call_cnt(), 1);
+}
+
+#ifndef _WIN32
+/**
+ * @test A Unix socket which doesn't accept the connection in time is given
+ *       up on like a TCP connection.
+ */
+TEST(UnixSocketConnectTest, Timeout) {
+  MockSocketOperations so;
+  routing::RoutingSockOps sock_ops(&so);
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_GE(fd, 0);
+
+  EXPECT_CALL(so, socket(AF_UNIX, SOCK_STREAM, 0)).WillOnce(Return(fd));
+  EXPECT_CALL(so, connect(fd, _, _)).WillOnce(DoAll(
+      InvokeWithoutArgs([&so]() { so.set_errno(EINPROGRESS); }), Return(-1)));
+  EXPECT_CALL(so, connect_non_blocking_wait(fd, std::chrono::milliseconds(100))).WillOnce(DoAll(
+      InvokeWithoutArgs([&so]() { so.set_errno(ETIMEDOUT); }), Return(-1)));
+  EXPECT_CALL(so, close(fd));
+
+  EXPECT_EQ(-2, sock_ops.get_mysql_unix_socket("/tmp/mysql.sock", std::chrono::milliseconds(100)));
+  ::close(fd);
+}
+
+/**
+ * @test Connecting to a MySQL Server which doesn't accept connections
+ *       anymore fails without blocking, connected sockets are blocking.
+ */
+TEST(UnixSocketConnectTest, FullBacklog) {
+  const std::string tmp_dir = mysql_harness::get_tmp_dir("unix_socket");
+  const std::string path = tmp_dir + "/mysql.sock";
+  const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_GE(listener, 0);
+  struct sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  ASSERT_EQ(0, ::bind(listener, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)));
+  ASSERT_EQ(0, ::listen(listener, 0));
+
+  routing::RoutingSockOps sock_ops(mysql_harness::SocketOperations::instance());
+  std::vector<int> socks;
+  int sock;
+  const auto start = std::chrono::steady_clock::now();
+  while ((sock = sock_ops.get_mysql_unix_socket(path, std::chrono::seconds(10))) >= 0 &&
+         socks.size() < 16) {
+    EXPECT_EQ(0, fcntl(sock, F_GETFL, nullptr) & O_NONBLOCK);
+    socks.push_back(sock);
+  }
+  EXPECT_LT(sock, 0);
+  EXPECT_FALSE(socks.empty());
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+  for (int s: socks) ::close(s);
+  ::close(listener);
+  mysql_harness::delete_dir_recursive(tmp_dir);
+}
+#endif
+
+int main(int argc, char *argv[]) {
+  init_test_logger();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
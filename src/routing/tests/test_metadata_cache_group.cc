@@ -66,9 +66,9 @@ class MetadataCacheAPIStub: public metadata_cache::MetadataCacheAPIBase {
 
   MOCK_METHOD2(mark_instance_reachability, void(const std::string&, InstanceStatus));
   MOCK_METHOD2(wait_primary_failover, bool(const std::string&, int));
-  MOCK_METHOD9(cache_init, void(const std::vector<mysql_harness::TCPAddress>&, const std::string&,
-                                const std::string&, std::chrono::milliseconds, const mysqlrouter::SSLOptions&,
-                                const std::string&, int, int, size_t));
+  MOCK_METHOD10(cache_init, void(const std::vector<mysql_harness::TCPAddress>&, const std::string&,
+                                 const std::string&, std::chrono::milliseconds, const mysqlrouter::SSLOptions&,
+                                 const std::string&, int, int, size_t, const metadata_cache::TopologyFiles&));
 
   void cache_stop() noexcept override {} // no easy way to mock noexcept method
 
@@ -118,9 +118,9 @@ TEST_F(DestMetadataCacheTest, StrategyFirstAvailableOnPrimaries) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3306);
@@ -137,9 +137,9 @@ TEST_F(DestMetadataCacheTest, StrategyFirstAvailableOnSinglePrimary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3306);
@@ -156,9 +156,9 @@ TEST_F(DestMetadataCacheTest, StrategyFirstAvailableOnNoPrimary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), -1);
@@ -175,9 +175,9 @@ TEST_F(DestMetadataCacheTest, StrategyFirstAvailableOnSecondaries) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
@@ -194,9 +194,9 @@ TEST_F(DestMetadataCacheTest, StrategyFirstAvailableOnSingleSecondary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3308);
@@ -213,9 +213,9 @@ TEST_F(DestMetadataCacheTest, StrategyFirstAvailableOnNoSecondary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), -1);
@@ -232,9 +232,9 @@ TEST_F(DestMetadataCacheTest, StrategyFirstAvailablePrimaryAndSecondary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3306);
@@ -251,9 +251,9 @@ TEST_F(DestMetadataCacheTest, StrategyRoundRobinWithFallbackUnavailableServer) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::Unavailable, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::Unavailable, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
@@ -275,10 +275,10 @@ TEST_F(DestMetadataCacheTest, StrategyRoundRobinOnPrimaries) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3308", 3308, 33062},
-    {kReplicasetName, "uuid4", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3309", 3309, 33063},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3308", 3308, 33062, 0},
+    {kReplicasetName, "uuid4", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3309", 3309, 33063, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3306);
@@ -297,9 +297,9 @@ TEST_F(DestMetadataCacheTest, StrategyRoundRobinOnSinglePrimary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3306);
@@ -316,8 +316,8 @@ TEST_F(DestMetadataCacheTest, StrategyRoundRobinPrimaryMissing) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), -1);
@@ -334,10 +334,10 @@ TEST_F(DestMetadataCacheTest, StrategyRoundRobinOnSecondaries) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
-    {kReplicasetName, "uuid4", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3309", 3309, 33063},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
+    {kReplicasetName, "uuid4", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3309", 3309, 33063, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
@@ -356,9 +356,9 @@ TEST_F(DestMetadataCacheTest, StrategyRoundRobinOnSingleSecondary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3308);
@@ -375,8 +375,8 @@ TEST_F(DestMetadataCacheTest, StrategyRoundRobinSecondaryMissing) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), -1);
@@ -393,9 +393,9 @@ TEST_F(DestMetadataCacheTest, StrategyRoundRobinPrimaryAndSecondary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
-    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3309", 3309, 33063},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
+    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3309", 3309, 33063, 0},
   });
 
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
@@ -417,9 +417,9 @@ TEST_F(DestMetadataCacheTest, StrategyRoundRobinWithFallbackBasicScenario) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   // we have 2 SECONDARIES up so we expect round robin on them
@@ -438,9 +438,9 @@ TEST_F(DestMetadataCacheTest, StrategyRoundRobinWithFallbackSingleSecondary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   // we do not fallback to PRIMARIES as long as there is at least single SECONDARY available
@@ -458,8 +458,8 @@ TEST_F(DestMetadataCacheTest, StrategyRoundRobinWithFallbackNoSecondary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
   });
 
   // no SECONDARY available so we expect round-robin on PRIAMRIES
@@ -494,9 +494,9 @@ TEST_F(DestMetadataCacheTest, AllowPrimaryReadsBasic) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061},
-    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   // we expect round-robin on all the servers (PRIMARY and SECONDARY)
@@ -516,7 +516,7 @@ TEST_F(DestMetadataCacheTest, AllowPrimaryReadsNoSecondary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
   });
 
   // we expect the PRIMARY being used
@@ -538,8 +538,8 @@ TEST_F(DestMetadataCacheTest, PrimaryDefault) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
   });
 
   // default for PRIMARY should be round-robin on ReadWrite servers
@@ -558,9 +558,9 @@ TEST_F(DestMetadataCacheTest, SecondaryDefault) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061},
-     {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061, 0},
+     {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   // default for SECONDARY should be round-robin on ReadOnly servers
@@ -579,9 +579,9 @@ TEST_F(DestMetadataCacheTest, PrimaryAndSecondaryDefault) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061},
-     {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33061, 0},
+     {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
   });
 
   // default for PRIMARY_AND_SECONDARY should be round-robin on ReadOnly and ReadWrite servers
@@ -610,16 +610,16 @@ TEST_F(DestMetadataCacheTest, AllowedNodesNoPrimary) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070, 0},
   });
   // need at least one connection to force dest to register for md changes
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3306);
 
   // new metadata - no primary
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070, 0},
   });
 
   bool callback_called{false};
@@ -650,16 +650,16 @@ TEST_F(DestMetadataCacheTest, AllowedNodes2Primaries) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070, 0},
   });
   // need at least one connection to force dest to register for md changes
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3306);
 
   // new metadata - no primary
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33070},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33070, 0},
   });
 
   bool callback_called{false};
@@ -693,15 +693,15 @@ TEST_F(DestMetadataCacheTest, AllowedNodesNoSecondaries) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070, 0},
   });
   // need at least one connection to force dest to register for md changes
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
 
   // new metadata - no primary
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
   });
 
   bool callback_called{false};
@@ -734,8 +734,8 @@ TEST_F(DestMetadataCacheTest, AllowedNodesSecondaryDisconnectToPromoted) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070, 0},
   });
   // need at least one connection to force dest to register for md changes
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
@@ -779,8 +779,8 @@ TEST_F(DestMetadataCacheTest, AllowedNodesSecondaryDisconnectToPromotedTwice) {
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070, 0},
   });
   // need at least one connection to force dest to register for md changes
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
@@ -816,8 +816,8 @@ TEST_F(DestMetadataCacheTest, AllowedNodesEmptyKeepConnectionsIfMetadataUnavaila
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070, 0},
   });
   // need at least one connection to force dest to register for md changes
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
@@ -856,8 +856,8 @@ TEST_F(DestMetadataCacheTest, AllowedNodesEmptyDisconnectConnectionsIfMetadataUn
                          &metadata_cache_api_, &routing_sock_ops_);
 
   fill_instance_vector({
-     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060},
-     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070},
+     {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+     {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070, 0},
   });
   // need at least one connection to force dest to register for md changes
   ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
@@ -1011,6 +1011,235 @@ TEST_F(DestMetadataCacheTest, RolePrimaryAndSecondaryWrongMode) {
    );
 }
 
+TEST_F(DestMetadataCacheTest, RolePrimaryReadWriteSplit) {
+
+  ASSERT_THROW_LIKE(
+    DestMetadataCacheGroup dest_mc_group("cache-name", kReplicasetName,
+                         routing::RoutingStrategy::kUndefined,
+                         mysqlrouter::URI("metadata-cache://cache-name/default?role=PRIMARY").query,
+                         BaseProtocol::Type::kClassicProtocol,
+                         routing::AccessMode::kReadWriteSplit,
+                         &metadata_cache_api_, &routing_sock_ops_),
+    std::runtime_error,
+    "mode 'read-write-split' is not valid for 'role=primary'"
+   );
+}
+
+/*****************************************/
+/*READ WRITE SPLIT                       */
+/*****************************************/
+TEST_F(DestMetadataCacheTest, ReadWriteSplit) {
+
+  DestMetadataCacheGroup dest_mc_group("cache-name", kReplicasetName,
+                         routing::RoutingStrategy::kUndefined,
+                         mysqlrouter::URI("metadata-cache://cache-name/default?role=PRIMARY_AND_SECONDARY").query,
+                         BaseProtocol::Type::kClassicProtocol,
+                         routing::AccessMode::kReadWriteSplit,
+                         &metadata_cache_api_, &routing_sock_ops_);
+
+  fill_instance_vector({
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
+    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3309", 3309, 33063, 0},
+  });
+
+  // sessions start on the primary, reads go round-robin to the secondaries
+  ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
+  ASSERT_EQ(dest_mc_group.get_read_only_server_socket(std::chrono::milliseconds(0), &err_), 3308);
+  ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
+  ASSERT_EQ(dest_mc_group.get_read_only_server_socket(std::chrono::milliseconds(0), &err_), 3309);
+  ASSERT_EQ(dest_mc_group.get_read_only_server_socket(std::chrono::milliseconds(0), &err_), 3308);
+}
+
+TEST_F(DestMetadataCacheTest, ReadWriteSplitNoSecondary) {
+
+  DestMetadataCacheGroup dest_mc_group("cache-name", kReplicasetName,
+                         routing::RoutingStrategy::kUndefined,
+                         mysqlrouter::URI("metadata-cache://cache-name/default?role=PRIMARY_AND_SECONDARY").query,
+                         BaseProtocol::Type::kClassicProtocol,
+                         routing::AccessMode::kReadWriteSplit,
+                         &metadata_cache_api_, &routing_sock_ops_);
+
+  fill_instance_vector({
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+  });
+
+  ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
+  ASSERT_EQ(dest_mc_group.get_read_only_server_socket(std::chrono::milliseconds(0), &err_), -1);
+}
+
+TEST_F(DestMetadataCacheTest, ReadOnlyServerSocketWithoutSplit) {
+
+  DestMetadataCacheGroup dest_mc_group("cache-name", kReplicasetName,
+                         routing::RoutingStrategy::kRoundRobin,
+                         mysqlrouter::URI("metadata-cache://cache-name/default?role=PRIMARY_AND_SECONDARY").query,
+                         BaseProtocol::Type::kClassicProtocol,
+                         routing::AccessMode::kUndefined,
+                         &metadata_cache_api_, &routing_sock_ops_);
+
+  fill_instance_vector({
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
+  });
+
+  ASSERT_EQ(dest_mc_group.get_read_only_server_socket(std::chrono::milliseconds(0), &err_), -1);
+}
+
+/*****************************************/
+/*REPLICATION LAG                        */
+/*****************************************/
+TEST_F(DestMetadataCacheTest, MaxTransactionsBehindSkipsLaggingSecondary) {
+
+  DestMetadataCacheGroup dest_mc_group("cache-name", kReplicasetName,
+                         routing::RoutingStrategy::kRoundRobin,
+                         mysqlrouter::URI("metadata-cache://cache-name/default?role=SECONDARY&max_transactions_behind=100").query,
+                         BaseProtocol::Type::kClassicProtocol,
+                         routing::AccessMode::kUndefined,
+                         &metadata_cache_api_, &routing_sock_ops_);
+
+  fill_instance_vector({
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 101},
+    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3309", 3309, 33063, 100},
+  });
+
+  ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3309);
+  ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3309);
+
+  // the secondary caught up
+  fill_instance_vector({
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 0},
+    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3309", 3309, 33063, 100},
+  });
+
+  ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3308);
+  ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3309);
+}
+
+TEST_F(DestMetadataCacheTest, MaxTransactionsBehindAllSecondariesLagging) {
+
+  DestMetadataCacheGroup dest_mc_group("cache-name", kReplicasetName,
+                         routing::RoutingStrategy::kRoundRobin,
+                         mysqlrouter::URI("metadata-cache://cache-name/default?role=SECONDARY&max_transactions_behind=100").query,
+                         BaseProtocol::Type::kClassicProtocol,
+                         routing::AccessMode::kUndefined,
+                         &metadata_cache_api_, &routing_sock_ops_);
+
+  fill_instance_vector({
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 500},
+    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3309", 3309, 33063, 200},
+  });
+
+  // stale secondaries are still better than no secondaries
+  ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3308);
+  ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3309);
+}
+
+TEST_F(DestMetadataCacheTest, MaxTransactionsBehindWithFallback) {
+
+  DestMetadataCacheGroup dest_mc_group("cache-name", kReplicasetName,
+                         routing::RoutingStrategy::kRoundRobinWithFallback,
+                         mysqlrouter::URI("metadata-cache://cache-name/default?role=SECONDARY&max_transactions_behind=100").query,
+                         BaseProtocol::Type::kClassicProtocol,
+                         routing::AccessMode::kUndefined,
+                         &metadata_cache_api_, &routing_sock_ops_);
+
+  fill_instance_vector({
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 500},
+  });
+
+  // with all secondaries lagging, the primary is the fallback
+  ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
+}
+
+TEST_F(DestMetadataCacheTest, MaxTransactionsBehindReadWriteSplit) {
+
+  DestMetadataCacheGroup dest_mc_group("cache-name", kReplicasetName,
+                         routing::RoutingStrategy::kUndefined,
+                         mysqlrouter::URI("metadata-cache://cache-name/default?role=PRIMARY_AND_SECONDARY&max_transactions_behind=10").query,
+                         BaseProtocol::Type::kClassicProtocol,
+                         routing::AccessMode::kReadWriteSplit,
+                         &metadata_cache_api_, &routing_sock_ops_);
+
+  fill_instance_vector({
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3307", 3307, 33061, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3308", 3308, 33062, 11},
+    {kReplicasetName, "uuid3", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3309", 3309, 33063, 0},
+  });
+
+  ASSERT_EQ(dest_mc_group.get_read_only_server_socket(std::chrono::milliseconds(0), &err_), 3309);
+  ASSERT_EQ(dest_mc_group.get_read_only_server_socket(std::chrono::milliseconds(0), &err_), 3309);
+}
+
+/**
+ * @test verifies that existing connections to a lagging secondary are kept
+ */
+TEST_F(DestMetadataCacheTest, AllowedNodesLaggingSecondary) {
+
+  DestMetadataCacheGroup dest_mc_group("cache-name", kReplicasetName,
+                         routing::RoutingStrategy::kUndefined,
+                         mysqlrouter::URI("metadata-cache://cache-name/default?role=SECONDARY&max_transactions_behind=100").query,
+                         BaseProtocol::Type::kClassicProtocol,
+                         routing::AccessMode::kReadOnly,
+                         &metadata_cache_api_, &routing_sock_ops_);
+
+  fill_instance_vector({
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070, 0},
+  });
+  // need at least one connection to force dest to register for md changes
+  ASSERT_EQ(dest_mc_group.get_server_socket(std::chrono::milliseconds(0), &err_), 3307);
+
+  fill_instance_vector({
+    {kReplicasetName, "uuid1", "HA", metadata_cache::ServerMode::ReadWrite, 1.0, 1, "location", "3306", 3306, 33060, 0},
+    {kReplicasetName, "uuid2", "HA", metadata_cache::ServerMode::ReadOnly, 1.0, 1, "location", "3307", 3307, 33070, 1000},
+  });
+
+  bool callback_called{false};
+  auto check_nodes = [&](const AllowedNodes& nodes, const std::string&) -> void {
+    ASSERT_EQ(2u, nodes.size());
+    ASSERT_EQ(3307u, nodes[1].port);
+    callback_called = true;
+  };
+  dest_mc_group.register_allowed_nodes_change_callback(check_nodes);
+  metadata_cache_api_.trigger_instances_change_callback();
+
+  ASSERT_TRUE(callback_called);
+}
+
+TEST_F(DestMetadataCacheTest, MaxTransactionsBehindWithPrimaryRouting) {
+
+  ASSERT_THROW_LIKE(
+    DestMetadataCacheGroup dest_mc_group("cache-name", kReplicasetName,
+                         routing::RoutingStrategy::kUndefined,
+                         mysqlrouter::URI("metadata-cache://cache-name/default?role=PRIMARY&max_transactions_behind=10").query,
+                         BaseProtocol::Type::kClassicProtocol,
+                         routing::AccessMode::kReadWrite,
+                         &metadata_cache_api_, &routing_sock_ops_),
+    std::runtime_error,
+    "Option 'max_transactions_behind' is not valid for role=PRIMARY"
+   );
+}
+
+TEST_F(DestMetadataCacheTest, MaxTransactionsBehindInvalidValue) {
+
+  for (const std::string value: {"0", "-1", "abc", "10x", "99999999999999999999999"}) {
+    ASSERT_THROW_LIKE(
+      DestMetadataCacheGroup dest_mc_group("cache-name", kReplicasetName,
+                           routing::RoutingStrategy::kUndefined,
+                           mysqlrouter::URI("metadata-cache://cache-name/default?role=SECONDARY&max_transactions_behind=" + value).query,
+                           BaseProtocol::Type::kClassicProtocol,
+                           routing::AccessMode::kReadOnly,
+                           &metadata_cache_api_, &routing_sock_ops_),
+      std::runtime_error,
+      "Invalid value for option 'max_transactions_behind': '" + value + "'. Allowed are positive integers"
+     );
+  }
+}
+
 /*****************************************/
 /*URI parsing tests                      */
 /*****************************************/
@@ -0,0 +1,560 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "test/helpers.h"
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "protocol/classic_auth.h"
+#include "protocol/classic_protocol.h"
+#include "protocol/statement_classifier.h"
+#include "mysqlrouter/routing.h"
+#include "split_session.h"
+
+#ifndef _WIN32
+# include <netinet/in.h>
+# include <sys/socket.h>
+# include <unistd.h>
+# include <future>
+#endif
+
+#ifndef HAVE_YASSL
+# include <openssl/pem.h>
+# include <openssl/rsa.h>
+#endif
+
+using routing::StatementKind;
+using routing::classify_statement;
+using mysql_protocol::ServerStatus::AUTOCOMMIT;
+using mysql_protocol::ServerStatus::IN_TRANS;
+using mysql_protocol::Capabilities::Flags;
+using Buffer = std::vector<uint8_t>;
+
+/**
+ * @test Plain SELECTs can go to secondaries.
+ */
+TEST(StatementClassifierTest, ReadOnly) {
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("SELECT 1"));
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("  select * from t where a = 1;"));
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("/* hint */ SELECT a FROM t"));
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("-- comment\nSELECT 'for update' FROM t"));
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("SELECT `lock` FROM t"));
+}
+
+/**
+ * @test SELECTs may call built-in functions and use parentheses.
+ */
+TEST(StatementClassifierTest, ReadOnlyFunctions) {
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("SELECT COUNT(*), MAX(a) FROM t"));
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("SELECT concat(a, 'x') FROM t"));
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("SELECT NOW ()"));
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("SELECT a, (b) FROM t"));
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("SELECT a FROM t WHERE b IN (1, 2)"));
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("SELECT a FROM (SELECT a FROM t) AS s"));
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("SELECT 'f(1)' FROM t"));
+  EXPECT_EQ(StatementKind::kReadOnly, classify_statement("SELECT t.a, 1.5 FROM db.t"));
+}
+
+/**
+ * @test Statements which may change data are writes.
+ */
+TEST(StatementClassifierTest, Write) {
+  EXPECT_EQ(StatementKind::kWrite, classify_statement("INSERT INTO t VALUES (1)"));
+  EXPECT_EQ(StatementKind::kWrite, classify_statement("update t set a = 2"));
+  EXPECT_EQ(StatementKind::kWrite, classify_statement("DELETE FROM t"));
+  EXPECT_EQ(StatementKind::kWrite, classify_statement("CREATE TABLE t (a INT)"));
+  // stored functions may write
+  EXPECT_EQ(StatementKind::kWrite, classify_statement("SELECT stored_func()"));
+  EXPECT_EQ(StatementKind::kWrite, classify_statement("SELECT a FROM t WHERE b = f(a)"));
+  EXPECT_EQ(StatementKind::kWrite, classify_statement("SELECT db.count(a) FROM t"));
+  EXPECT_EQ(StatementKind::kWrite, classify_statement("SELECT `f`(1)"));
+}
+
+/**
+ * @test Reads which depend on the primary's session go to the primary.
+ */
+TEST(StatementClassifierTest, ReadWrite) {
+  EXPECT_EQ(StatementKind::kReadWrite, classify_statement("BEGIN"));
+  EXPECT_EQ(StatementKind::kReadWrite, classify_statement("COMMIT"));
+  EXPECT_EQ(StatementKind::kReadWrite, classify_statement("START TRANSACTION READ ONLY"));
+  EXPECT_EQ(StatementKind::kReadWrite, classify_statement("SELECT * FROM t FOR UPDATE"));
+  EXPECT_EQ(StatementKind::kReadWrite, classify_statement("SELECT * FROM t LOCK IN SHARE MODE"));
+  EXPECT_EQ(StatementKind::kReadWrite, classify_statement("SELECT LAST_INSERT_ID()"));
+  EXPECT_EQ(StatementKind::kReadWrite, classify_statement("SELECT a INTO OUTFILE '/tmp/a' FROM t"));
+  EXPECT_EQ(StatementKind::kReadWrite, classify_statement("SHOW TABLES"));
+}
+
+/**
+ * @test Statements which create state in the session pin it to the primary.
+ */
+TEST(StatementClassifierTest, SessionState) {
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("SET @a = 1"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("SELECT @a"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("SET autocommit = 0"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("USE test"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("CREATE TEMPORARY TABLE t (a INT)"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("LOCK TABLES t READ"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("SELECT GET_LOCK('a', 1)"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("SELECT SQL_CALC_FOUND_ROWS * FROM t"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("PREPARE s FROM 'SELECT 1'"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("SELECT 1; SELECT 2"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("/*!40101 SET NAMES utf8 */"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement("SELECT 'unterminated"));
+  EXPECT_EQ(StatementKind::kSessionState, classify_statement(""));
+}
+
+/**
+ * @test Status flags are found behind the length encoded integers of OK.
+ */
+TEST(ClassicSplitTest, OkStatusFlags) {
+  uint16_t flags = 0;
+  EXPECT_TRUE(ClassicProtocol::get_ok_status_flags({7, 0, 0, 1, 0, 0, 0, 0x03, 0, 0, 0}, &flags));
+  EXPECT_EQ(0x0003, flags);
+  EXPECT_TRUE(ClassicProtocol::get_ok_status_flags({9, 0, 0, 1, 0, 0xfc, 0, 1, 5, 0x01, 0, 0, 0}, &flags));
+  EXPECT_EQ(0x0001, flags);
+  EXPECT_FALSE(ClassicProtocol::get_ok_status_flags({3, 0, 0, 1, 0xff, 0x15, 0x04}, &flags));
+}
+
+/**
+ * @test Plain reads go to secondaries in autocommit mode outside of transactions.
+ */
+TEST(SplitSessionTest, Transactions) {
+  SplitSession session(AUTOCOMMIT, std::chrono::seconds(1));
+  EXPECT_TRUE(session.is_for_read_only(StatementKind::kReadOnly));
+  EXPECT_FALSE(session.is_for_read_only(StatementKind::kReadWrite));
+  EXPECT_FALSE(session.is_for_read_only(StatementKind::kWrite));
+
+  session.executed_on_primary(StatementKind::kReadWrite, AUTOCOMMIT | IN_TRANS);
+  EXPECT_FALSE(session.is_for_read_only(StatementKind::kReadOnly));
+  session.executed_on_primary(StatementKind::kReadWrite, AUTOCOMMIT);
+  EXPECT_TRUE(session.is_for_read_only(StatementKind::kReadOnly));
+
+  SplitSession no_autocommit(0, std::chrono::seconds(1));
+  EXPECT_FALSE(no_autocommit.is_for_read_only(StatementKind::kReadOnly));
+}
+
+/**
+ * @test After a write, also one in autocommit mode, reads stay with the primary.
+ */
+TEST(SplitSessionTest, ReadYourWrites) {
+  SplitSession session(AUTOCOMMIT, std::chrono::seconds(1));
+  session.executed_on_primary(StatementKind::kWrite, AUTOCOMMIT);
+  EXPECT_EQ(AUTOCOMMIT, session.status_flags());
+  EXPECT_FALSE(session.is_for_read_only(StatementKind::kReadOnly));
+
+  SplitSession in_transaction(AUTOCOMMIT, std::chrono::seconds(1));
+  in_transaction.executed_on_primary(StatementKind::kReadWrite, AUTOCOMMIT | IN_TRANS);
+  in_transaction.executed_on_primary(StatementKind::kWrite, AUTOCOMMIT | IN_TRANS);
+  in_transaction.executed_on_primary(StatementKind::kReadWrite, AUTOCOMMIT);
+  EXPECT_FALSE(in_transaction.is_for_read_only(StatementKind::kReadOnly));
+}
+
+/**
+ * @test A secondary is tried again once the retry interval passed.
+ */
+TEST(SplitSessionTest, RetryInterval) {
+  SplitSession session(AUTOCOMMIT, std::chrono::seconds(10));
+  const auto now = SplitSession::clock::now();
+  EXPECT_TRUE(session.may_connect_read_only(now));
+
+  session.read_only_failed(now);
+  EXPECT_FALSE(session.may_connect_read_only(now));
+  EXPECT_FALSE(session.may_connect_read_only(now + std::chrono::seconds(9)));
+  EXPECT_TRUE(session.may_connect_read_only(now + std::chrono::seconds(10)));
+}
+
+#ifndef _WIN32
+
+namespace {
+
+const std::chrono::milliseconds kTimeout{5000};
+
+Buffer make_packet(uint8_t seq, const Buffer &payload) {
+  Buffer packet{static_cast<uint8_t>(payload.size()),
+                static_cast<uint8_t>(payload.size() >> 8),
+                static_cast<uint8_t>(payload.size() >> 16),
+                seq};
+  packet.insert(packet.end(), payload.begin(), payload.end());
+  return packet;
+}
+
+Buffer read_packet(int fd) {
+  Buffer header(4);
+  EXPECT_EQ(4, ::recv(fd, header.data(), header.size(), MSG_WAITALL));
+  Buffer packet(header);
+  packet.resize(4 + (header[0] | header[1] << 8 | header[2] << 16));
+  if (packet.size() > 4) {
+    EXPECT_EQ(static_cast<ssize_t>(packet.size() - 4),
+              ::recv(fd, &packet[4], packet.size() - 4, MSG_WAITALL));
+  }
+  return packet;
+}
+
+// protocol 10 greeting announcing the auth plugin
+Buffer make_greeting(const Buffer &nonce, const std::string &plugin) {
+  const uint32_t bits = (mysql_protocol::Capabilities::PROTOCOL_41 |
+                         mysql_protocol::Capabilities::SECURE_CONNECTION |
+                         mysql_protocol::Capabilities::PLUGIN_AUTH).bits();
+  Buffer greeting{10, '8', '.', '0', 0, 1, 0, 0, 0};
+  greeting.insert(greeting.end(), nonce.begin(), nonce.begin() + 8);
+  greeting.insert(greeting.end(), {0, static_cast<uint8_t>(bits), static_cast<uint8_t>(bits >> 8),
+                                   8, 2, 0, static_cast<uint8_t>(bits >> 16),
+                                   static_cast<uint8_t>(bits >> 24), 21});
+  greeting.resize(greeting.size() + 10, 0);
+  greeting.insert(greeting.end(), nonce.begin() + 8, nonce.end());
+  greeting.push_back(0);
+  greeting.insert(greeting.end(), plugin.begin(), plugin.end());
+  greeting.push_back(0);
+  return make_packet(0, greeting);
+}
+
+// handshake response of user "u", the auth-response doesn't matter
+Buffer make_response(const std::string &plugin) {
+  const uint32_t bits = (mysql_protocol::Capabilities::PROTOCOL_41 |
+                         mysql_protocol::Capabilities::SECURE_CONNECTION |
+                         mysql_protocol::Capabilities::PLUGIN_AUTH).bits();
+  Buffer response{static_cast<uint8_t>(bits), static_cast<uint8_t>(bits >> 8),
+                  static_cast<uint8_t>(bits >> 16), static_cast<uint8_t>(bits >> 24),
+                  0, 0, 0, 1, 8};
+  response.resize(response.size() + 23, 0);
+  response.insert(response.end(), {'u', 0, 1, 0xaa});
+  response.insert(response.end(), plugin.begin(), plugin.end());
+  response.push_back(0);
+  return make_packet(1, response);
+}
+
+void send_packets(int fd, const std::vector<Buffer> &packets) {
+  for (auto &packet : packets) {
+    ASSERT_EQ(static_cast<ssize_t>(packet.size()), ::send(fd, packet.data(), packet.size(), 0));
+  }
+}
+
+}
+
+class ClassicSplitRelayTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    client_ = fds[0];
+    router_client_ = fds[1];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    router_server_ = fds[0];
+    server_ = fds[1];
+  }
+
+  void TearDown() override {
+    for (int fd : {client_, router_client_, router_server_, server_}) {
+      ::close(fd);
+    }
+  }
+
+  int relay(const Buffer &command, Flags capabilities) {
+    ClassicProtocol protocol(routing::RoutingSockOps::instance(
+        mysql_harness::SocketOperations::instance()));
+    RoutingProtocolBuffer packet(command);
+    return protocol.relay_command(router_client_, nullptr, router_server_, packet, capabilities,
+                                  kTimeout, &status_flags_, &bytes_relayed_, "test");
+  }
+
+  int client_, router_client_, router_server_, server_;
+  uint16_t status_flags_ = 0;
+  size_t bytes_relayed_ = 0;
+};
+
+/**
+ * @test Result sets are relayed until the last one ends, whose status is reported.
+ */
+TEST_F(ClassicSplitRelayTest, MultipleResultSets) {
+  const Buffer query = make_packet(0, {0x03, 'C', 'A', 'L', 'L', ' ', 'p'});
+  const std::vector<Buffer> response{
+    make_packet(1, {1}),                               // column count
+    make_packet(2, {3, 'd', 'e', 'f', 0, 0, 0, 1, 'a', 0}),  // column definition
+    make_packet(3, {0xfe, 0, 0, 0x0a, 0}),             // EOF, more results
+    make_packet(4, {1, '1'}),                          // row
+    make_packet(5, {0xfe, 0, 0, 0x0a, 0}),             // EOF, more results
+    make_packet(6, {0x00, 0, 0, 0x03, 0, 0, 0}),       // OK, in transaction
+  };
+  send_packets(server_, response);
+
+  EXPECT_EQ(0, relay(query, mysql_protocol::Capabilities::PROTOCOL_41));
+  EXPECT_EQ(query, read_packet(server_));
+  for (auto &packet : response) {
+    EXPECT_EQ(packet, read_packet(client_));
+  }
+  EXPECT_EQ(0x0003, status_flags_);
+
+  size_t size = 0;
+  for (auto &packet : response) size += packet.size();
+  EXPECT_EQ(size, bytes_relayed_);
+}
+
+/**
+ * @test With CLIENT_DEPRECATE_EOF rows end with an OK packet starting with 0xfe.
+ */
+TEST_F(ClassicSplitRelayTest, DeprecateEof) {
+  const Buffer query = make_packet(0, {0x03, 'S', 'E', 'L', 'E', 'C', 'T', ' ', '1'});
+  const std::vector<Buffer> response{
+    make_packet(1, {1}),
+    make_packet(2, {3, 'd', 'e', 'f', 0, 0, 0, 1, '1', 0}),
+    make_packet(3, {1, '1'}),
+    make_packet(4, {0xfe, 0, 0, 0x02, 0, 0, 0}),
+  };
+  send_packets(server_, response);
+
+  EXPECT_EQ(0, relay(query, mysql_protocol::Capabilities::PROTOCOL_41 |
+                            mysql_protocol::Capabilities::DEPRECATE_EOF));
+  read_packet(server_);
+  for (auto &packet : response) {
+    EXPECT_EQ(packet, read_packet(client_));
+  }
+  EXPECT_EQ(0x0002, status_flags_);
+}
+
+/**
+ * @test Errors end the response and keep the status.
+ */
+TEST_F(ClassicSplitRelayTest, Error) {
+  const Buffer error = make_packet(1, {0xff, 0x7a, 0x04, '#', '4', '2', 'S', '0', '2', 'x'});
+  send_packets(server_, {error});
+
+  status_flags_ = 0x0002;
+  EXPECT_EQ(0, relay(make_packet(0, {0x03, 'S', 'E', 'L', 'E', 'C', 'T'}),
+                     mysql_protocol::Capabilities::PROTOCOL_41));
+  EXPECT_EQ(error, read_packet(client_));
+  EXPECT_EQ(0x0002, status_flags_);
+}
+
+#endif // !_WIN32
+
+/**
+ * @test Auth-responses match the ones computed by the MySQL client.
+ */
+TEST(ClassicAuthTest, Scramble) {
+  Buffer nonce;
+  for (uint8_t i = 1; i <= 20; ++i) nonce.push_back(i);
+
+  EXPECT_EQ(Buffer({0xb3, 0x2b, 0xb3, 0xa5, 0x83, 0xe1, 0x34, 0x0c, 0x0a, 0x11,
+                    0x08, 0xd5, 0x8b, 0x1b, 0xe4, 0x97, 0x81, 0xad, 0x8c, 0x2f}),
+            classic_auth::scramble_native_password("secret", nonce));
+  EXPECT_EQ(Buffer({0x74, 0x6e, 0xbe, 0x20, 0x5d, 0x56, 0xa0, 0x70, 0x7a, 0xcb, 0x3e,
+                    0x79, 0x6e, 0x83, 0x4e, 0x0d, 0xd7, 0xb1, 0xd6, 0x17, 0x43, 0xb2,
+                    0x6b, 0xd5, 0x20, 0x2c, 0x7a, 0x62, 0x32, 0x30, 0xc7, 0xc9}),
+            classic_auth::scramble_caching_sha2_password("secret", nonce));
+  EXPECT_TRUE(classic_auth::scramble_native_password("", nonce).empty());
+  EXPECT_TRUE(classic_auth::scramble_caching_sha2_password("", nonce).empty());
+}
+
+#ifndef _WIN32
+
+/**
+ * @test The router logs in with the password of the account and follows
+ *       auth-switch and full authentication of caching_sha2_password.
+ */
+TEST_F(ClassicSplitRelayTest, Login) {
+  Buffer nonce;
+  for (uint8_t i = 1; i <= 20; ++i) nonce.push_back(i);
+  const std::string plugin = "mysql_native_password";
+
+  auto router = std::async(std::launch::async, [&]() {
+    ClassicProtocol protocol(routing::RoutingSockOps::instance(
+        mysql_harness::SocketOperations::instance()));
+    RoutingProtocolBuffer reply;
+    const int res = protocol.login(router_server_, make_greeting(nonce, plugin),
+                                   make_response(plugin), "secret", kTimeout, reply, "test");
+    return res == 0 ? reply : RoutingProtocolBuffer();
+  });
+
+  Buffer packet = read_packet(server_);
+  EXPECT_EQ(1, packet[3]);
+  const Buffer native = classic_auth::scramble_native_password("secret", nonce);
+  // user "u", 1 byte length of the auth-response
+  EXPECT_EQ(20, packet[4 + 32 + 2]);
+  EXPECT_TRUE(std::equal(native.begin(), native.end(), packet.begin() + 4 + 32 + 3));
+
+  // switch to caching_sha2_password with a new nonce
+  Buffer switch_nonce(20, 7);
+  Buffer auth_switch{0xfe};
+  const std::string sha2 = "caching_sha2_password";
+  auth_switch.insert(auth_switch.end(), sha2.begin(), sha2.end());
+  auth_switch.push_back(0);
+  auth_switch.insert(auth_switch.end(), switch_nonce.begin(), switch_nonce.end());
+  auth_switch.push_back(0);
+  send_packets(server_, {make_packet(2, auth_switch)});
+
+  packet = read_packet(server_);
+  EXPECT_EQ(3, packet[3]);
+  EXPECT_EQ(make_packet(3, classic_auth::scramble_caching_sha2_password("secret", switch_nonce)),
+            packet);
+
+  // full authentication: Unix sockets get the password in clear text
+  send_packets(server_, {make_packet(4, {0x01, 0x04})});
+  EXPECT_EQ(make_packet(5, {'s', 'e', 'c', 'r', 'e', 't', 0}), read_packet(server_));
+
+  const Buffer ok = make_packet(6, {0, 0, 0, 2, 0, 0, 0});
+  send_packets(server_, {ok});
+  EXPECT_EQ(ok, router.get());
+}
+
+namespace {
+
+// connected sockets over TCP, which the server doesn't trust with passwords
+void tcp_socket_pair(int fds[2]) {
+  const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(listener, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addr_len = sizeof(addr);
+  ASSERT_EQ(0, ::bind(listener, reinterpret_cast<sockaddr*>(&addr), addr_len));
+  ASSERT_EQ(0, ::listen(listener, 1));
+  ASSERT_EQ(0, ::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addr_len));
+  fds[0] = ::socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_EQ(0, ::connect(fds[0], reinterpret_cast<sockaddr*>(&addr), addr_len));
+  fds[1] = ::accept(listener, nullptr, nullptr);
+  ASSERT_GE(fds[1], 0);
+  ::close(listener);
+}
+
+}
+
+#ifdef HAVE_YASSL
+
+/**
+ * @test Over TCP the password is never sent in clear text and yaSSL can't
+ *       encrypt it with the server's RSA key: full authentication of
+ *       caching_sha2_password fails the login.
+ */
+TEST(ClassicAuthTest, LoginRefusesFullAuthOverTcp) {
+  int fds[2];
+  tcp_socket_pair(fds);
+  const int router_server = fds[0];
+  const int server = fds[1];
+
+  const Buffer nonce(20, 3);
+  const std::string plugin = "caching_sha2_password";
+  auto router = std::async(std::launch::async, [&]() {
+    ClassicProtocol protocol(routing::RoutingSockOps::instance(
+        mysql_harness::SocketOperations::instance()));
+    RoutingProtocolBuffer reply;
+    return protocol.login(router_server, make_greeting(nonce, plugin),
+                          make_response(plugin), "secret", kTimeout, reply, "test");
+  });
+
+  Buffer packet = read_packet(server);
+  EXPECT_EQ(32, packet[4 + 32 + 2]);
+  send_packets(server, {make_packet(2, {0x01, 0x04})});
+  EXPECT_EQ(-1, router.get());
+
+  // nothing but the handshake response reached the server
+  ::shutdown(router_server, SHUT_WR);
+  uint8_t byte;
+  EXPECT_EQ(0, ::recv(server, &byte, 1, 0));
+
+  for (int fd : {router_server, server}) ::close(fd);
+}
+
+#else
+
+/**
+ * @test Over TCP full authentication of caching_sha2_password asks the
+ *       server for its RSA public key and sends the password encrypted.
+ */
+TEST(ClassicAuthTest, LoginFullAuthRsaOverTcp) {
+  int fds[2];
+  tcp_socket_pair(fds);
+  const int router_server = fds[0];
+  const int server = fds[1];
+
+  const Buffer nonce(20, 3);
+  const std::string plugin = "caching_sha2_password";
+  auto router = std::async(std::launch::async, [&]() {
+    ClassicProtocol protocol(routing::RoutingSockOps::instance(
+        mysql_harness::SocketOperations::instance()));
+    RoutingProtocolBuffer reply;
+    const int res = protocol.login(router_server, make_greeting(nonce, plugin),
+                                   make_response(plugin), "secret", kTimeout, reply, "test");
+    return res == 0 ? reply : RoutingProtocolBuffer();
+  });
+
+  read_packet(server);
+  send_packets(server, {make_packet(2, {0x01, 0x04})});
+  EXPECT_EQ(make_packet(3, {0x02}), read_packet(server));
+
+  // the public key of the test certificate
+  const std::string data_dir(ROUTING_TEST_DATA_DIR);
+  BIO *cert_bio = BIO_new_file((data_dir + "/tls_server_cert.pem").c_str(), "r");
+  X509 *cert = PEM_read_bio_X509(cert_bio, nullptr, nullptr, nullptr);
+  EVP_PKEY *public_key = X509_get_pubkey(cert);
+  BIO *key_bio = BIO_new(BIO_s_mem());
+  PEM_write_bio_PUBKEY(key_bio, public_key);
+  char *key_data = nullptr;
+  const long key_size = BIO_get_mem_data(key_bio, &key_data);
+  Buffer key{0x01};
+  key.insert(key.end(), key_data, key_data + key_size);
+  BIO_free(key_bio);
+  EVP_PKEY_free(public_key);
+  X509_free(cert);
+  BIO_free(cert_bio);
+  send_packets(server, {make_packet(4, key)});
+
+  const Buffer encrypted = read_packet(server);
+  EXPECT_EQ(5, encrypted[3]);
+  BIO *private_bio = BIO_new_file((data_dir + "/tls_server_key.pem").c_str(), "r");
+  EVP_PKEY *private_key = PEM_read_bio_PrivateKey(private_bio, nullptr, nullptr, nullptr);
+  EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(private_key, nullptr);
+  Buffer plain(encrypted.size());
+  size_t plain_size = plain.size();
+  EXPECT_EQ(1, EVP_PKEY_decrypt_init(ctx));
+  EXPECT_EQ(1, EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_OAEP_PADDING));
+  EXPECT_EQ(1, EVP_PKEY_decrypt(ctx, plain.data(), &plain_size,
+                                &encrypted[4], encrypted.size() - 4));
+  plain.resize(plain_size);
+  EVP_PKEY_CTX_free(ctx);
+  EVP_PKEY_free(private_key);
+  BIO_free(private_bio);
+  for (size_t i = 0; i < plain.size(); ++i) plain[i] = static_cast<uint8_t>(plain[i] ^ nonce[i % nonce.size()]);
+  EXPECT_EQ(Buffer({'s', 'e', 'c', 'r', 'e', 't', 0}), plain);
+
+  const Buffer ok = make_packet(6, {0, 0, 0, 2, 0, 0, 0});
+  send_packets(server, {ok});
+  EXPECT_EQ(ok, router.get());
+
+  for (int fd : {router_server, server}) ::close(fd);
+}
+
+#endif // HAVE_YASSL
+
+#endif // !_WIN32
+
+int main(int argc, char *argv[]) {
+  init_test_logger();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
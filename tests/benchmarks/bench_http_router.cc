@@ -0,0 +1,131 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * micro-benchmark of dispatching requests in the http server.
+ *
+ * measures the lookup of the handler by HttpRequestRouter::route() for a
+ * REST-like set of routes, without the I/O of the request, and compares
+ * the HttpRouteMatcher it uses with searching the regex of each route in
+ * turn.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "http_route_matcher.h"
+#include "http_server_plugin.h"
+#include "posix_re.h"
+
+static const char *kResources[] {
+  "clusters", "routes", "metadata", "connections", "health", "status",
+  "config", "users", "sessions", "servers", "replicasets", "statistics",
+};
+
+static const char *kUris[] {
+  "/api/v1/clusters/",
+  "/api/v1/statistics/",
+  "/api/v1/statistics/foo/status",
+  "/api/v2/unknown",
+};
+
+// 3 routes per resource
+static std::vector<std::string> make_routes() {
+  std::vector<std::string> routes;
+  for (const char *resource: kResources) {
+    const std::string base = std::string("^/api/v1/") + resource;
+    routes.push_back(base + "/$");
+    routes.push_back(base + "/([^/]+)$");
+    routes.push_back(base + "/([^/]+)/status$");
+  }
+  return routes;
+}
+
+class NullRequestHandler: public BaseRequestHandler {
+ public:
+  void handle_request(HttpRequest &) override {}
+};
+
+static void BM_HttpRequestRouter_route(benchmark::State &state) {
+  HttpRequestRouter router;
+
+  for (const std::string &url_regex: make_routes()) {
+    router.append(url_regex, std::unique_ptr<BaseRequestHandler>(new NullRequestHandler()));
+  }
+
+  const std::string uri = kUris[state.range(0)];
+  state.SetLabel(uri);
+
+  for (auto _: state) {
+    benchmark::DoNotOptimize(router.find_handler(uri));
+  }
+}
+BENCHMARK(BM_HttpRequestRouter_route)->DenseRange(0, 3);
+
+static void BM_HttpRouteMatcher_match(benchmark::State &state) {
+  HttpRouteMatcher matcher;
+
+  for (const std::string &url_regex: make_routes()) {
+    matcher.add(url_regex, std::make_shared<PosixRE>(url_regex));
+  }
+
+  const std::string uri = kUris[state.range(0)];
+  state.SetLabel(uri);
+
+  for (auto _: state) {
+    size_t ndx = 0;
+    benchmark::DoNotOptimize(matcher.match(uri, ndx));
+    benchmark::DoNotOptimize(ndx);
+  }
+}
+BENCHMARK(BM_HttpRouteMatcher_match)->DenseRange(0, 3);
+
+// searching the regex of each route in turn, the lookup before HttpRouteMatcher
+static void BM_PosixRE_search_each(benchmark::State &state) {
+  std::vector<std::unique_ptr<PosixRE>> regexes;
+
+  for (const std::string &url_regex: make_routes()) {
+    regexes.emplace_back(new PosixRE(url_regex));
+  }
+
+  const std::string uri = kUris[state.range(0)];
+  state.SetLabel(uri);
+
+  for (auto _: state) {
+    size_t found = regexes.size();
+    for (size_t ndx = 0; ndx < regexes.size(); ndx++) {
+      if (regexes[ndx]->search(uri)) {
+        found = ndx;
+        break;
+      }
+    }
+    benchmark::DoNotOptimize(found);
+  }
+}
+BENCHMARK(BM_PosixRE_search_each)->DenseRange(0, 3);
+
+BENCHMARK_MAIN();
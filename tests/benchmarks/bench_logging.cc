@@ -0,0 +1,137 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * micro-benchmarks of log statements.
+ *
+ * log_debug() with the debug level enabled and disabled, the
+ * log_level_is_handled() check which guards disabled statements, and
+ * log_message() which used to be the cost of every log statement, enabled
+ * or not. Enabled messages are formatted and written to a stream which
+ * discards them.
+ */
+
+#define MYSQL_ROUTER_LOG_DOMAIN "bench"
+
+#include <cstdarg>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "dim.h"
+#include "mysql/harness/logging/handler.h"
+#include "mysql/harness/logging/logging.h"
+#include "mysql/harness/logging/registry.h"
+#include "test/helpers.h"
+
+using mysql_harness::logging::LogLevel;
+IMPORT_LOG_FUNCTIONS()
+
+extern "C" void log_message(LogLevel level, const char* module, const char* fmt, va_list ap);
+
+// log_debug() without the level check
+static void log_debug_unchecked(const char *fmt, ...) ATTRIBUTE_GCC_FORMAT(printf, 1, 2);
+
+static void log_debug_unchecked(const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  log_message(LogLevel::kDebug, MYSQL_ROUTER_LOG_DOMAIN, fmt, ap);
+  va_end(ap);
+}
+
+static void set_log_level(LogLevel level) {
+  mysql_harness::logging::set_log_level_for_all_loggers(
+      mysql_harness::DIM::instance().get_LoggingRegistry(), level);
+}
+
+static const std::string kRouteName{"routing:test_default_x_ro"};
+
+static void BM_log_level_is_handled(benchmark::State &state) {
+  set_log_level(LogLevel::kWarning);
+
+  for (auto _: state) {
+    benchmark::DoNotOptimize(log_level_is_handled(LogLevel::kDebug));
+  }
+}
+BENCHMARK(BM_log_level_is_handled);
+
+static void BM_log_debug_disabled(benchmark::State &state) {
+  set_log_level(LogLevel::kWarning);
+
+  size_t n = 0;
+  for (auto _: state) {
+    log_debug("[%s] fd=%zu connected", kRouteName.c_str(), n++);
+  }
+}
+BENCHMARK(BM_log_debug_disabled);
+
+static void BM_log_debug_enabled(benchmark::State &state) {
+  set_log_level(LogLevel::kDebug);
+
+  size_t n = 0;
+  for (auto _: state) {
+    log_debug("[%s] fd=%zu connected", kRouteName.c_str(), n++);
+  }
+}
+BENCHMARK(BM_log_debug_enabled);
+
+static void BM_log_message_disabled(benchmark::State &state) {
+  set_log_level(LogLevel::kWarning);
+
+  size_t n = 0;
+  for (auto _: state) {
+    log_debug_unchecked("[%s] fd=%zu connected", kRouteName.c_str(), n++);
+  }
+}
+BENCHMARK(BM_log_message_disabled);
+
+static void BM_log_message_enabled(benchmark::State &state) {
+  set_log_level(LogLevel::kDebug);
+
+  size_t n = 0;
+  for (auto _: state) {
+    log_debug_unchecked("[%s] fd=%zu connected", kRouteName.c_str(), n++);
+  }
+}
+BENCHMARK(BM_log_message_enabled);
+
+int main(int argc, char *argv[]) {
+  // a stream without buffer discards all that is written to it
+  std::ostream null_stream(nullptr);
+
+  init_test_logger({MYSQL_ROUTER_LOG_DOMAIN});
+
+  auto &registry = mysql_harness::DIM::instance().get_LoggingRegistry();
+  registry.remove_handler(mysql_harness::logging::kMainConsoleHandler);
+  registry.add_handler("bench", std::make_shared<mysql_harness::logging::StreamHandler>(null_stream));
+  mysql_harness::logging::attach_handler_to_all_loggers(registry, "bench");
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+
+  return 0;
+}
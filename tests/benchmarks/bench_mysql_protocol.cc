@@ -0,0 +1,206 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * micro-benchmarks of encoding and decoding mysql_protocol packets.
+ *
+ * Packet copies the buffer it is constructed from and returns copies of
+ * the fields it reads, PacketView returns views into the buffer.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "mysqlrouter/mysql_protocol.h"
+
+using mysql_protocol::Capabilities::Flags;
+using mysql_protocol::ErrorPacket;
+using mysql_protocol::HandshakeResponsePacket;
+using mysql_protocol::Packet;
+using mysql_protocol::PacketView;
+
+static const Flags kServerCapabilities =
+    HandshakeResponsePacket::kDefaultClientCapabilities | mysql_protocol::Capabilities::PLUGIN_AUTH;
+
+// handshake response with the fields the routing looks at
+static std::vector<uint8_t> make_handshake_response() {
+  Packet pkt(1);
+  pkt.seek(0);
+  pkt.write_int<uint32_t>(0x01000000);  // header, size is set below
+  pkt.write_int<uint32_t>(kServerCapabilities.bits());
+  pkt.write_int<uint32_t>(Packet::kMaxAllowedSize);
+  pkt.write_int<uint8_t>(8);
+  pkt.append_bytes(23, 0);
+  pkt.write_string("root");
+  pkt.write_int<uint8_t>(0);
+  pkt.write_int<uint8_t>(20);
+  pkt.append_bytes(20, 'x');
+  pkt.write_string("test");
+  pkt.write_int<uint8_t>(0);
+  pkt.write_string("mysql_native_password");
+  pkt.write_int<uint8_t>(0);
+
+  std::vector<uint8_t> res(pkt.begin(), pkt.end());
+  res[0] = static_cast<uint8_t>(res.size() - Packet::get_header_length());
+  return res;
+}
+
+// row of a text resultset
+static std::vector<uint8_t> make_row(size_t columns) {
+  const std::string value{"value of column"};
+
+  std::vector<uint8_t> row{0, 0, 0, 3};
+  for (size_t col = 0; col < columns; col++) {
+    row.push_back(static_cast<uint8_t>(value.size()));
+    row.insert(row.end(), value.begin(), value.end());
+  }
+  row[0] = static_cast<uint8_t>(row.size() - Packet::get_header_length());
+  return row;
+}
+
+static const size_t kRowColumns = 8;
+
+// handshake response in a net_buffer_length sized receive buffer
+static std::vector<uint8_t> make_net_buffer(const std::vector<uint8_t> &packet) {
+  std::vector<uint8_t> net_buffer(16 * 1024);
+  std::copy(packet.begin(), packet.end(), net_buffer.begin());
+  return net_buffer;
+}
+
+static void BM_ErrorPacket_encode(benchmark::State &state) {
+  for (auto _: state) {
+    ErrorPacket pkt(2, 1045, "Access denied for user 'root'@'localhost'", "28000",
+                    mysql_protocol::Capabilities::PROTOCOL_41);
+    benchmark::DoNotOptimize(pkt.data());
+  }
+}
+BENCHMARK(BM_ErrorPacket_encode);
+
+static void BM_ErrorPacket_decode(benchmark::State &state) {
+  const std::vector<uint8_t> buffer = ErrorPacket(
+      2, 1045, "Access denied for user 'root'@'localhost'", "28000",
+      mysql_protocol::Capabilities::PROTOCOL_41);
+
+  for (auto _: state) {
+    ErrorPacket pkt(buffer, mysql_protocol::Capabilities::PROTOCOL_41);
+    benchmark::DoNotOptimize(pkt.get_code());
+  }
+}
+BENCHMARK(BM_ErrorPacket_decode);
+
+static void BM_HandshakeResponsePacket_encode(benchmark::State &state) {
+  const std::vector<unsigned char> auth_response(20, 'x');
+
+  for (auto _: state) {
+    HandshakeResponsePacket pkt(1, auth_response, "root", "", "test");
+    benchmark::DoNotOptimize(pkt.data());
+  }
+}
+BENCHMARK(BM_HandshakeResponsePacket_encode);
+
+static void BM_HandshakeResponsePacket_decode(benchmark::State &state) {
+  const std::vector<uint8_t> buffer = make_handshake_response();
+
+  for (auto _: state) {
+    HandshakeResponsePacket pkt(buffer, true, kServerCapabilities);
+    benchmark::DoNotOptimize(pkt.get_username().size());
+  }
+}
+BENCHMARK(BM_HandshakeResponsePacket_decode);
+
+// the fields of a handshake response the routing reads
+static void BM_PacketView_parse_handshake_response(benchmark::State &state) {
+  const std::vector<uint8_t> buffer = make_handshake_response();
+
+  for (auto _: state) {
+    PacketView view(buffer);
+    view.seek(Packet::get_header_length());
+    Flags caps(view.read_int<uint32_t>());
+    view.read_int<uint32_t>();  // max-packet-size
+    view.read_int<uint8_t>();   // character set
+    view.read_bytes(23);        // reserved
+    benchmark::DoNotOptimize(view.read_string_nul().size());
+    benchmark::DoNotOptimize(view.read_bytes(view.read_int<uint8_t>()).size());
+    if (caps.test(mysql_protocol::Capabilities::CONNECT_WITH_DB)) {
+      benchmark::DoNotOptimize(view.read_string_nul().size());
+    }
+    if (caps.test(mysql_protocol::Capabilities::PLUGIN_AUTH)) {
+      benchmark::DoNotOptimize(view.read_string_nul().size());
+    }
+  }
+}
+BENCHMARK(BM_PacketView_parse_handshake_response);
+
+static void BM_Packet_read_row(benchmark::State &state) {
+  const std::vector<uint8_t> buffer = make_row(kRowColumns);
+
+  for (auto _: state) {
+    Packet pkt(buffer);
+    pkt.seek(Packet::get_header_length());
+    for (size_t col = 0; col < kRowColumns; col++) {
+      benchmark::DoNotOptimize(pkt.read_lenenc_bytes().size());
+    }
+  }
+}
+BENCHMARK(BM_Packet_read_row);
+
+static void BM_PacketView_read_row(benchmark::State &state) {
+  const std::vector<uint8_t> buffer = make_row(kRowColumns);
+
+  for (auto _: state) {
+    PacketView view(buffer);
+    view.seek(Packet::get_header_length());
+    for (size_t col = 0; col < kRowColumns; col++) {
+      benchmark::DoNotOptimize(view.read_lenenc_bytes().size());
+    }
+  }
+}
+BENCHMARK(BM_PacketView_read_row);
+
+// the capabilities, as the routing read them while forwarding the handshake
+static void BM_Packet_read_capabilities(benchmark::State &state) {
+  const std::vector<uint8_t> net_buffer = make_net_buffer(make_handshake_response());
+
+  for (auto _: state) {
+    benchmark::DoNotOptimize(Packet(net_buffer).read_int_from<uint32_t>(Packet::get_header_length()));
+  }
+}
+BENCHMARK(BM_Packet_read_capabilities);
+
+// the capabilities, as the routing reads them while forwarding the handshake
+static void BM_PacketView_read_capabilities(benchmark::State &state) {
+  const std::vector<uint8_t> packet = make_handshake_response();
+  const std::vector<uint8_t> net_buffer = make_net_buffer(packet);
+
+  for (auto _: state) {
+    PacketView view(net_buffer.data(), packet.size());
+    benchmark::DoNotOptimize(view.read_int_from<uint32_t>(Packet::get_header_length()));
+  }
+}
+BENCHMARK(BM_PacketView_read_capabilities);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,249 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * micro-benchmarks of the routing plugin.
+ *
+ * - copy_packets() of the classic and the X protocol, forwarding payloads
+ *   from one socketpair to another
+ * - put() and erase() of the concurrent_map of the ConnectionContainer,
+ *   with connection threads contending on it
+ * - picking a destination of a DestMetadataCacheGroup, which is dominated
+ *   by filtering the topology in get_available()
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include "connection_container.h"
+#include "dest_metadata_cache.h"
+#include "dim.h"
+#include "mysql/harness/logging/registry.h"
+#include "mysqlrouter/routing.h"
+#include "protocol/classic_protocol.h"
+#include "protocol/x_protocol.h"
+#include "test/helpers.h"
+
+using mysql_harness::logging::LogLevel;
+
+#ifndef _WIN32
+/**
+ * client and server side of a routed connection.
+ *
+ * the client writes to client_[0], the router reads from client_[1] and
+ * writes to server_[0], the server reads from server_[1].
+ */
+class SocketPairs {
+ public:
+  SocketPairs() {
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, client_) != 0 ||
+        socketpair(AF_UNIX, SOCK_STREAM, 0, server_) != 0) {
+      throw std::runtime_error("socketpair() failed");
+    }
+  }
+
+  ~SocketPairs() {
+    for (int fd: {client_[0], client_[1], server_[0], server_[1]}) {
+      close(fd);
+    }
+  }
+
+  int client() const { return client_[0]; }
+  int router_client() const { return client_[1]; }
+  int router_server() const { return server_[0]; }
+  int server() const { return server_[1]; }
+
+ private:
+  int client_[2];
+  int server_[2];
+};
+
+static bool read_exactly(int fd, uint8_t *buf, size_t len) {
+  while (len > 0) {
+    ssize_t res = read(fd, buf, len);
+    if (res <= 0) return false;
+    buf += res;
+    len -= static_cast<size_t>(res);
+  }
+  return true;
+}
+
+// forwards payloads of state.range(0) bytes from client to server
+static void copy_packets(benchmark::State &state, BaseProtocol &protocol) {
+  SocketPairs sockets;
+  const size_t payload_size = static_cast<size_t>(state.range(0));
+
+  std::vector<uint8_t> payload(payload_size, 'x');
+  std::vector<uint8_t> received(payload_size);
+  RoutingProtocolBuffer buffer(routing::kDefaultNetBufferLength);
+
+  int pktnr = 3;
+  bool handshake_done = true;
+
+  for (auto _: state) {
+    size_t bytes_read = 0;
+    if (write(sockets.client(), payload.data(), payload.size()) != static_cast<ssize_t>(payload.size()) ||
+        protocol.copy_packets(sockets.router_client(), sockets.router_server(), true, buffer,
+                              &pktnr, handshake_done, &bytes_read, false) != 0 ||
+        !read_exactly(sockets.server(), received.data(), bytes_read)) {
+      state.SkipWithError("forwarding the payload failed");
+      break;
+    }
+  }
+
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(payload_size));
+}
+
+static void BM_ClassicProtocol_copy_packets(benchmark::State &state) {
+  ClassicProtocol protocol(routing::RoutingSockOps::instance(mysql_harness::SocketOperations::instance()));
+
+  copy_packets(state, protocol);
+}
+BENCHMARK(BM_ClassicProtocol_copy_packets)->Range(64, routing::kDefaultNetBufferLength);
+
+static void BM_XProtocol_copy_packets(benchmark::State &state) {
+  XProtocol protocol(routing::RoutingSockOps::instance(mysql_harness::SocketOperations::instance()));
+
+  copy_packets(state, protocol);
+}
+BENCHMARK(BM_XProtocol_copy_packets)->Range(64, routing::kDefaultNetBufferLength);
+#endif
+
+// same key and value type as the connections_ of the ConnectionContainer
+using ConnectionsMap = concurrent_map<MySQLRoutingConnection*, std::unique_ptr<MySQLRoutingConnection>>;
+
+static ConnectionsMap g_connections;
+
+// each thread adds and removes its own connections, like connection threads do
+static void BM_ConnectionContainer_put_erase(benchmark::State &state) {
+  // only the address is used as key, the connections are never accessed
+  std::vector<char> slots(64);
+
+  for (auto _: state) {
+    for (auto &slot: slots) {
+      g_connections.put(reinterpret_cast<MySQLRoutingConnection*>(&slot), nullptr);
+    }
+    for (auto &slot: slots) {
+      g_connections.erase(reinterpret_cast<MySQLRoutingConnection*>(&slot));
+    }
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(slots.size()));
+}
+BENCHMARK(BM_ConnectionContainer_put_erase)->ThreadRange(1, 16)->UseRealTime();
+
+class MetadataCacheAPIStub: public metadata_cache::MetadataCacheAPIBase {
+ public:
+  explicit MetadataCacheAPIStub(const std::vector<metadata_cache::ManagedInstance> &instances)
+      : instances_(instances) {}
+
+  void cache_init(const std::vector<mysql_harness::TCPAddress>&, const std::string&,
+                  const std::string&, std::chrono::milliseconds, const mysqlrouter::SSLOptions&,
+                  const std::string&, int, int, size_t, const metadata_cache::TopologyFiles&) override {}
+
+  void cache_stop() noexcept override {}
+
+  metadata_cache::LookupResult lookup_replicaset(const std::string&) override {
+    return metadata_cache::LookupResult(instances_);
+  }
+
+  void mark_instance_reachability(const std::string&, metadata_cache::InstanceStatus) override {}
+
+  bool wait_primary_failover(const std::string&, int) override { return false; }
+
+  void add_listener(const std::string&, metadata_cache::ReplicasetStateListenerInterface*) override {}
+
+  void remove_listener(const std::string&, metadata_cache::ReplicasetStateListenerInterface*) override {}
+
+ private:
+  std::vector<metadata_cache::ManagedInstance> instances_;
+};
+
+// "connects" by returning the port as socket
+class RoutingSockOpsStub: public routing::RoutingSockOpsInterface {
+ public:
+  int get_mysql_socket(mysql_harness::TCPAddress addr, std::chrono::milliseconds, bool) noexcept override {
+    return addr.port;
+  }
+
+  int get_mysql_unix_socket(const std::string&, std::chrono::milliseconds, bool) noexcept override {
+    return -1;
+  }
+
+  mysql_harness::SocketOperationsBase* so() const override {
+    return mysql_harness::SocketOperations::instance();
+  }
+};
+
+// picks a secondary of a replicaset of state.range(0) servers
+static void BM_DestMetadataCacheGroup_get_available(benchmark::State &state) {
+  const std::string replicaset{"replicaset-name"};
+
+  std::vector<metadata_cache::ManagedInstance> instances;
+  for (int64_t ndx = 0; ndx < state.range(0); ndx++) {
+    const unsigned int port = static_cast<unsigned int>(3306 + ndx);
+    instances.push_back({replicaset, "uuid" + std::to_string(ndx), "HA",
+                         ndx == 0 ? metadata_cache::ServerMode::ReadWrite : metadata_cache::ServerMode::ReadOnly,
+                         1.0, 1, "location", "127.0.0.1", port, port + 30000, 0});
+  }
+
+  MetadataCacheAPIStub cache_api(instances);
+  RoutingSockOpsStub sock_ops;
+
+  DestMetadataCacheGroup dest(
+      "cache-name", replicaset, routing::RoutingStrategy::kRoundRobin,
+      mysqlrouter::URI("metadata-cache://cache-name/default?role=SECONDARY").query,
+      Protocol::Type::kClassicProtocol, routing::AccessMode::kUndefined,
+      &cache_api, &sock_ops);
+
+  int err;
+  for (auto _: state) {
+    benchmark::DoNotOptimize(dest.get_server_socket(std::chrono::milliseconds(0), &err));
+  }
+}
+BENCHMARK(BM_DestMetadataCacheGroup_get_available)->Arg(3)->Arg(9)->Arg(64);
+
+int main(int argc, char *argv[]) {
+  init_test_logger({"routing"});
+  mysql_harness::logging::set_log_level_for_all_loggers(
+      mysql_harness::DIM::instance().get_LoggingRegistry(), LogLevel::kWarning);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+
+  return 0;
+}
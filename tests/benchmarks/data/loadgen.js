@@ -0,0 +1,30 @@
+// tracefile of mysql_server_mock for router_loadgen
+//
+// echoes the string literal of "SELECT '<payload>'" back as a resultset,
+// returns OK for all other statements.
+
+({
+  stmts: function(stmt) {
+    var prefix = "SELECT '";
+
+    if (stmt.indexOf(prefix) === 0 && stmt.charAt(stmt.length - 1) === "'") {
+      return {
+        result: {
+          columns: [
+            {
+              name: "payload",
+              type: "STRING"
+            }
+          ],
+          rows: [
+            [ stmt.substring(prefix.length, stmt.length - 1) ]
+          ]
+        }
+      }
+    }
+
+    return {
+      ok: {}
+    }
+  }
+})
@@ -0,0 +1,702 @@
+/*
+  Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License, version 2.0,
+  as published by the Free Software Foundation.
+
+  This program is also distributed with certain software (including
+  but not limited to OpenSSL) that is licensed under separate terms,
+  as designated in a particular file or component or in included license
+  documentation.  The authors of MySQL hereby grant you an additional
+  permission to link the program and your derivative works with the
+  separately licensed software that they have included with MySQL.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/**
+ * load generator for a running MySQL Router.
+ *
+ * opens connections through a route of the router and sends statements
+ * over them from concurrent client threads. At the end it reports
+ * connections and statements per second, bytes per second and latency
+ * percentiles as JSON.
+ *
+ * - classic protocol: connects and authenticates, then sends
+ *   "SELECT '<payload>'" for each statement and reads the whole response
+ * - X protocol: connects, then sends CapabilitiesGet for each statement and
+ *   reads the response. The payload size doesn't apply.
+ *
+ * With --queries-per-connection=N each client thread reconnects after N
+ * statements, which measures connection setup. With 0 (the default) it keeps
+ * its connection for the whole run.
+ *
+ * For the classic protocol the backends can be mysql_server_mock with the
+ * tracefile data/loadgen.js, which echoes the payload back:
+ *
+ *     $ mysql_server_mock --filename=data/loadgen.js --port=3307
+ *     $ mysqlrouter -c router.conf     # [routing] to 127.0.0.1:3307
+ *     $ router_loadgen --port=6446 --concurrency=32 --payload-size=1024
+ *
+ * mysql_server_mock only speaks the classic protocol, the X protocol needs
+ * MySQL Servers as backends.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifdef RAPIDJSON_NO_SIZETYPEDEFINE
+// if we build within the server, it will set RAPIDJSON_NO_SIZETYPEDEFINE globally
+// and require to include my_rapidjson_size_t.h
+#include "my_rapidjson_size_t.h"
+#endif
+
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+
+#include "mysql/harness/arg_handler.h"
+#include "mysqlrouter/mysql_protocol.h"
+
+using mysql_protocol::Capabilities::Flags;
+using mysql_protocol::Packet;
+
+constexpr unsigned kHelpScreenWidth = 72;
+constexpr unsigned kHelpScreenIndent = 8;
+
+// timeout of reads and writes, a stalled connection counts as error
+constexpr int kIoTimeoutSeconds = 10;
+
+enum class LoadProtocol {
+  kClassic,
+  kX,
+};
+
+struct LoadgenConfig {
+  std::string host { "127.0.0.1" };
+  uint16_t port { 6446 };
+  LoadProtocol protocol { LoadProtocol::kClassic };
+  std::string user { "root" };
+  unsigned concurrency { 8 };
+  unsigned duration { 10 };  // seconds
+  unsigned queries_per_connection { 0 };
+  size_t payload_size { 16 };
+  std::string output_filename;
+};
+
+/**
+ * results of one client thread, merged at the end of the run.
+ *
+ * latencies are in microseconds.
+ */
+struct LoadgenStats {
+  uint64_t connections { 0 };
+  uint64_t connect_errors { 0 };
+  uint64_t queries { 0 };
+  uint64_t query_errors { 0 };
+  uint64_t bytes_sent { 0 };
+  uint64_t bytes_received { 0 };
+  std::vector<uint64_t> connect_latencies;
+  std::vector<uint64_t> query_latencies;
+
+  void merge(const LoadgenStats &other) {
+    connections += other.connections;
+    connect_errors += other.connect_errors;
+    queries += other.queries;
+    query_errors += other.query_errors;
+    bytes_sent += other.bytes_sent;
+    bytes_received += other.bytes_received;
+    connect_latencies.insert(connect_latencies.end(),
+                             other.connect_latencies.begin(), other.connect_latencies.end());
+    query_latencies.insert(query_latencies.end(),
+                           other.query_latencies.begin(), other.query_latencies.end());
+  }
+};
+
+/**
+ * connection of a client to the router.
+ *
+ * @throws std::runtime_error on all errors
+ */
+class ClientConnection {
+ public:
+  ClientConnection(const std::string &host, uint16_t port, LoadgenStats &stats)
+      : stats_(stats) {
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo *ainfo = nullptr;
+    int err = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &ainfo);
+    if (err != 0) {
+      throw std::runtime_error("getaddrinfo(" + host + ") failed: " + gai_strerror(err));
+    }
+    std::shared_ptr<struct addrinfo> exit_guard(ainfo, &freeaddrinfo);
+
+    for (auto *info = ainfo; info != nullptr; info = info->ai_next) {
+      fd_ = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+      if (fd_ < 0) continue;
+
+      if (connect(fd_, info->ai_addr, info->ai_addrlen) == 0) break;
+
+      close(fd_);
+      fd_ = -1;
+    }
+
+    if (fd_ < 0) {
+      throw std::runtime_error("connecting to " + host + ":" + std::to_string(port) +
+                               " failed: " + std::strerror(errno));
+    }
+
+    struct timeval tv { kIoTimeoutSeconds, 0 };
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    int nodelay = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+  }
+
+  ~ClientConnection() {
+    if (fd_ >= 0) close(fd_);
+  }
+
+  ClientConnection(const ClientConnection &) = delete;
+  ClientConnection &operator=(const ClientConnection &) = delete;
+
+  void write_all(const uint8_t *buf, size_t len) {
+    while (len > 0) {
+      ssize_t res = send(fd_, buf, len, MSG_NOSIGNAL);
+      if (res < 0) {
+        throw std::runtime_error(std::string("write failed: ") + std::strerror(errno));
+      }
+      buf += res;
+      len -= static_cast<size_t>(res);
+      stats_.bytes_sent += static_cast<uint64_t>(res);
+    }
+  }
+
+  void read_exactly(uint8_t *buf, size_t len) {
+    while (len > 0) {
+      ssize_t res = recv(fd_, buf, len, 0);
+      if (res == 0) {
+        throw std::runtime_error("connection closed by peer");
+      } else if (res < 0) {
+        throw std::runtime_error(std::string("read failed: ") + std::strerror(errno));
+      }
+      buf += res;
+      len -= static_cast<size_t>(res);
+      stats_.bytes_received += static_cast<uint64_t>(res);
+    }
+  }
+
+  /** reads a classic protocol packet and returns its payload */
+  std::vector<uint8_t> read_classic_packet() {
+    uint8_t header[4];
+    read_exactly(header, sizeof(header));
+
+    size_t payload_size = static_cast<size_t>(header[0]) |
+                          static_cast<size_t>(header[1]) << 8 |
+                          static_cast<size_t>(header[2]) << 16;
+    std::vector<uint8_t> payload(payload_size);
+    read_exactly(payload.data(), payload.size());
+
+    return payload;
+  }
+
+  /** reads a X protocol message and returns its type */
+  uint8_t read_x_message() {
+    uint8_t header[5];
+    read_exactly(header, sizeof(header));
+
+    uint32_t message_size = static_cast<uint32_t>(header[0]) |
+                            static_cast<uint32_t>(header[1]) << 8 |
+                            static_cast<uint32_t>(header[2]) << 16 |
+                            static_cast<uint32_t>(header[3]) << 24;
+    if (message_size == 0) throw std::runtime_error("invalid X protocol message");
+
+    std::vector<uint8_t> payload(message_size - 1);
+    read_exactly(payload.data(), payload.size());
+
+    return header[4];
+  }
+
+ private:
+  int fd_ { -1 };
+  LoadgenStats &stats_;
+};
+
+class ClientSession {
+ public:
+  virtual ~ClientSession() = default;
+
+  virtual void handshake() = 0;
+  virtual void query() = 0;
+  virtual void quit() = 0;
+};
+
+class ClassicSession: public ClientSession {
+ public:
+  ClassicSession(ClientConnection &conn, const LoadgenConfig &config) : conn_(conn) {
+    query_packet_ = make_query_packet(config.payload_size);
+    user_ = config.user;
+  }
+
+  void handshake() override {
+    auto greeting = conn_.read_classic_packet();
+    if (greeting.empty() || greeting[0] == 0xff) {
+      throw std::runtime_error("server sent an error instead of the greeting");
+    }
+
+    auto response = make_handshake_response();
+    conn_.write_all(response.data(), response.size());
+
+    auto auth_result = conn_.read_classic_packet();
+    if (auth_result.empty() || auth_result[0] != 0x00) {
+      throw std::runtime_error("authentication failed");
+    }
+  }
+
+  void query() override {
+    conn_.write_all(query_packet_.data(), query_packet_.size());
+
+    // OK, ERR or a resultset whose column definitions and rows both are
+    // terminated by an EOF packet, as CLIENT_DEPRECATE_EOF isn't set
+    auto first = conn_.read_classic_packet();
+    if (first.empty() || first[0] == 0xff) {
+      throw std::runtime_error("statement failed");
+    } else if (first[0] == 0x00) {
+      return;
+    }
+
+    for (int eofs = 0; eofs < 2;) {
+      auto pkt = conn_.read_classic_packet();
+      if (pkt.empty() || pkt[0] == 0xff) {
+        throw std::runtime_error("reading the resultset failed");
+      }
+      if (pkt[0] == 0xfe && pkt.size() < 9) eofs++;
+    }
+  }
+
+  void quit() override {
+    const uint8_t com_quit[] { 0x01, 0x00, 0x00, 0x00, 0x01 };
+    conn_.write_all(com_quit, sizeof(com_quit));
+  }
+
+ private:
+  // bytes of the packet, with the payload size set in the header
+  static std::vector<uint8_t> finish_packet(const Packet &pkt) {
+    std::vector<uint8_t> res(pkt.begin(), pkt.end());
+
+    size_t payload_size = res.size() - Packet::get_header_length();
+    res[0] = static_cast<uint8_t>(payload_size);
+    res[1] = static_cast<uint8_t>(payload_size >> 8);
+    res[2] = static_cast<uint8_t>(payload_size >> 16);
+
+    return res;
+  }
+
+  static std::vector<uint8_t> make_query_packet(size_t payload_size) {
+    Packet pkt(0);
+    pkt.seek(0);
+    pkt.write_int<uint32_t>(0);  // header
+    pkt.write_int<uint8_t>(0x03);  // COM_QUERY
+    pkt.write_string("SELECT '" + std::string(payload_size, 'x') + "'");
+
+    return finish_packet(pkt);
+  }
+
+  std::vector<uint8_t> make_handshake_response() const {
+    const Flags caps = mysql_protocol::Capabilities::PROTOCOL_41 |
+                       mysql_protocol::Capabilities::SECURE_CONNECTION |
+                       mysql_protocol::Capabilities::PLUGIN_AUTH;
+
+    Packet pkt(1);
+    pkt.seek(0);
+    pkt.write_int<uint32_t>(0x01000000);  // header
+    pkt.write_int<uint32_t>(caps.bits());
+    pkt.write_int<uint32_t>(Packet::kMaxAllowedSize);
+    pkt.write_int<uint8_t>(8);  // latin1
+    pkt.append_bytes(23, 0);
+    pkt.write_string(user_);
+    pkt.write_int<uint8_t>(0);
+    pkt.write_int<uint8_t>(20);
+    pkt.append_bytes(20, 'x');  // auth-data, the mock doesn't check it
+    pkt.write_string("mysql_native_password");
+    pkt.write_int<uint8_t>(0);
+
+    return finish_packet(pkt);
+  }
+
+  ClientConnection &conn_;
+  std::vector<uint8_t> query_packet_;
+  std::string user_;
+};
+
+class XSession: public ClientSession {
+ public:
+  explicit XSession(ClientConnection &conn) : conn_(conn) {}
+
+  // the client sends the first message, nothing to do
+  void handshake() override {}
+
+  void query() override {
+    const uint8_t capabilities_get[] { 0x01, 0x00, 0x00, 0x00, kConCapabilitiesGet };
+    conn_.write_all(capabilities_get, sizeof(capabilities_get));
+
+    if (conn_.read_x_message() == kError) {
+      throw std::runtime_error("CapabilitiesGet failed");
+    }
+  }
+
+  void quit() override {
+    const uint8_t con_close[] { 0x01, 0x00, 0x00, 0x00, kConClose };
+    conn_.write_all(con_close, sizeof(con_close));
+  }
+
+ private:
+  // Mysqlx::ClientMessages and Mysqlx::ServerMessages
+  static constexpr uint8_t kConCapabilitiesGet = 1;
+  static constexpr uint8_t kConClose = 3;
+  static constexpr uint8_t kError = 1;
+
+  ClientConnection &conn_;
+};
+
+constexpr uint8_t XSession::kConCapabilitiesGet;
+constexpr uint8_t XSession::kConClose;
+constexpr uint8_t XSession::kError;
+
+static uint64_t elapsed_us(std::chrono::steady_clock::time_point start) {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count());
+}
+
+static void client_thread(const LoadgenConfig &config, const std::atomic<bool> &stopped,
+                          LoadgenStats &stats) {
+  while (!stopped) {
+    std::unique_ptr<ClientConnection> conn;
+    std::unique_ptr<ClientSession> session;
+
+    auto connect_start = std::chrono::steady_clock::now();
+    try {
+      conn.reset(new ClientConnection(config.host, config.port, stats));
+      if (config.protocol == LoadProtocol::kClassic) {
+        session.reset(new ClassicSession(*conn, config));
+      } else {
+        session.reset(new XSession(*conn));
+      }
+      session->handshake();
+    } catch (const std::exception &) {
+      stats.connect_errors++;
+      // don't spin if the router is down
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      continue;
+    }
+    stats.connections++;
+    stats.connect_latencies.push_back(elapsed_us(connect_start));
+
+    try {
+      for (unsigned n = 0; !stopped &&
+           (config.queries_per_connection == 0 || n < config.queries_per_connection); n++) {
+        auto query_start = std::chrono::steady_clock::now();
+        session->query();
+        stats.queries++;
+        stats.query_latencies.push_back(elapsed_us(query_start));
+      }
+      session->quit();
+    } catch (const std::exception &) {
+      stats.query_errors++;
+    }
+  }
+}
+
+static uint64_t percentile(const std::vector<uint64_t> &sorted, double pct) {
+  if (sorted.empty()) return 0;
+
+  size_t ndx = static_cast<size_t>(pct / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+  return sorted[std::min(ndx, sorted.size() - 1)];
+}
+
+template <class Writer>
+static void write_latencies(Writer &writer, std::vector<uint64_t> &latencies) {
+  std::sort(latencies.begin(), latencies.end());
+
+  writer.Key("latency_us");
+  writer.StartObject();
+  writer.Key("min");
+  writer.Uint64(latencies.empty() ? 0 : latencies.front());
+  writer.Key("p50");
+  writer.Uint64(percentile(latencies, 50));
+  writer.Key("p90");
+  writer.Uint64(percentile(latencies, 90));
+  writer.Key("p99");
+  writer.Uint64(percentile(latencies, 99));
+  writer.Key("p999");
+  writer.Uint64(percentile(latencies, 99.9));
+  writer.Key("max");
+  writer.Uint64(latencies.empty() ? 0 : latencies.back());
+  writer.EndObject();
+}
+
+static std::string make_report(const LoadgenConfig &config, LoadgenStats &stats, double seconds) {
+  rapidjson::StringBuffer buff;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buff);
+
+  writer.StartObject();
+
+  writer.Key("config");
+  writer.StartObject();
+  writer.Key("host");
+  writer.String(config.host.c_str());
+  writer.Key("port");
+  writer.Uint(config.port);
+  writer.Key("protocol");
+  writer.String(config.protocol == LoadProtocol::kClassic ? "classic" : "x");
+  writer.Key("concurrency");
+  writer.Uint(config.concurrency);
+  writer.Key("duration");
+  writer.Uint(config.duration);
+  writer.Key("queries_per_connection");
+  writer.Uint(config.queries_per_connection);
+  writer.Key("payload_size");
+  writer.Uint64(config.payload_size);
+  writer.EndObject();
+
+  writer.Key("elapsed_seconds");
+  writer.Double(seconds);
+
+  writer.Key("connections");
+  writer.StartObject();
+  writer.Key("count");
+  writer.Uint64(stats.connections);
+  writer.Key("errors");
+  writer.Uint64(stats.connect_errors);
+  writer.Key("per_second");
+  writer.Double(static_cast<double>(stats.connections) / seconds);
+  write_latencies(writer, stats.connect_latencies);
+  writer.EndObject();
+
+  writer.Key("queries");
+  writer.StartObject();
+  writer.Key("count");
+  writer.Uint64(stats.queries);
+  writer.Key("errors");
+  writer.Uint64(stats.query_errors);
+  writer.Key("per_second");
+  writer.Double(static_cast<double>(stats.queries) / seconds);
+  write_latencies(writer, stats.query_latencies);
+  writer.EndObject();
+
+  writer.Key("bytes");
+  writer.StartObject();
+  writer.Key("sent");
+  writer.Uint64(stats.bytes_sent);
+  writer.Key("received");
+  writer.Uint64(stats.bytes_received);
+  writer.Key("per_second");
+  writer.Double(static_cast<double>(stats.bytes_sent + stats.bytes_received) / seconds);
+  writer.EndObject();
+
+  writer.EndObject();
+
+  return buff.GetString();
+}
+
+class LoadgenFrontend {
+ public:
+  std::string get_help() {
+    std::stringstream os;
+
+    for (auto line: arg_handler_.usage_lines("Usage: router_loadgen", "", kHelpScreenWidth)) {
+      os << line << std::endl;
+    }
+
+    os << "\nOptions:" << std::endl;
+    for (auto line: arg_handler_.option_descriptions(kHelpScreenWidth, kHelpScreenIndent)) {
+      os << line << std::endl;
+    }
+
+    return os.str();
+  }
+
+  LoadgenConfig init_from_arguments(const std::vector<std::string> &arguments) {
+    prepare_command_options();
+    arg_handler_.process(std::vector<std::string>{arguments.begin() + 1, arguments.end()});
+
+    if (config_.concurrency == 0) {
+      throw std::invalid_argument("--concurrency must be greater than 0");
+    }
+    if (config_.duration == 0) {
+      throw std::invalid_argument("--duration must be greater than 0");
+    }
+    // the statement has to fit into one packet
+    if (config_.payload_size > Packet::kMaxAllowedSize - 16) {
+      throw std::invalid_argument("--payload-size must be less than " +
+                                  std::to_string(Packet::kMaxAllowedSize - 16));
+    }
+
+    return config_;
+  }
+
+  bool is_print_and_exit() {
+    return do_print_and_exit_;
+  }
+
+  void run() {
+    std::atomic<bool> stopped { false };
+    std::vector<LoadgenStats> thread_stats(config_.concurrency);
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &stats: thread_stats) {
+      threads.emplace_back(client_thread, std::cref(config_), std::cref(stopped), std::ref(stats));
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(config_.duration));
+    stopped = true;
+
+    for (auto &thr: threads) {
+      thr.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    LoadgenStats stats;
+    for (const auto &s: thread_stats) {
+      stats.merge(s);
+    }
+
+    std::string report = make_report(config_, stats, seconds);
+    if (config_.output_filename.empty()) {
+      std::cout << report << std::endl;
+    } else {
+      std::ofstream out(config_.output_filename);
+      out << report << std::endl;
+      if (!out) {
+        throw std::runtime_error("writing " + config_.output_filename + " failed");
+      }
+    }
+  }
+
+ private:
+  void prepare_command_options() {
+    arg_handler_.add_option(CmdOption::OptionNames({"-?", "--help"}), "Display this help and exit.",
+                            CmdOptionValueReq::none, "", [this](const std::string &) {
+          std::cout << this->get_help() << std::endl;
+          this->do_print_and_exit_ = true;
+        });
+
+    arg_handler_.add_option(
+        CmdOption::OptionNames({"-h", "--host"}), "host of the route (default 127.0.0.1).",
+        CmdOptionValueReq::required, "host",
+        [this](const std::string &host) {
+          config_.host = host;
+        });
+    arg_handler_.add_option(
+        CmdOption::OptionNames({"-P", "--port"}), "TCP port of the route (default 6446).",
+        CmdOptionValueReq::required, "int",
+        [this](const std::string &port) {
+          config_.port = static_cast<uint16_t>(std::stoul(port));
+        });
+    arg_handler_.add_option(
+        CmdOption::OptionNames({"--protocol"}), "protocol of the route, classic or x (default classic).",
+        CmdOptionValueReq::required, "name",
+        [this](const std::string &protocol) {
+          if (protocol == "classic") {
+            config_.protocol = LoadProtocol::kClassic;
+          } else if (protocol == "x") {
+            config_.protocol = LoadProtocol::kX;
+          } else {
+            throw std::invalid_argument("--protocol must be classic or x, got " + protocol);
+          }
+        });
+    arg_handler_.add_option(
+        CmdOption::OptionNames({"-u", "--user"}), "user to authenticate as (default root).",
+        CmdOptionValueReq::required, "name",
+        [this](const std::string &user) {
+          config_.user = user;
+        });
+    arg_handler_.add_option(
+        CmdOption::OptionNames({"-c", "--concurrency"}), "number of concurrent clients (default 8).",
+        CmdOptionValueReq::required, "int",
+        [this](const std::string &concurrency) {
+          config_.concurrency = static_cast<unsigned>(std::stoul(concurrency));
+        });
+    arg_handler_.add_option(
+        CmdOption::OptionNames({"-d", "--duration"}), "seconds to run (default 10).",
+        CmdOptionValueReq::required, "int",
+        [this](const std::string &duration) {
+          config_.duration = static_cast<unsigned>(std::stoul(duration));
+        });
+    arg_handler_.add_option(
+        CmdOption::OptionNames({"--queries-per-connection"}),
+        "statements sent before a client reconnects, 0 for no reconnects (default 0).",
+        CmdOptionValueReq::required, "int",
+        [this](const std::string &queries) {
+          config_.queries_per_connection = static_cast<unsigned>(std::stoul(queries));
+        });
+    arg_handler_.add_option(
+        CmdOption::OptionNames({"--payload-size"}),
+        "bytes of payload each statement sends and gets echoed back (default 16).",
+        CmdOptionValueReq::required, "int",
+        [this](const std::string &payload_size) {
+          config_.payload_size = std::stoul(payload_size);
+        });
+    arg_handler_.add_option(
+        CmdOption::OptionNames({"-o", "--output"}), "file to write the JSON report to (default stdout).",
+        CmdOptionValueReq::required, "filename",
+        [this](const std::string &filename) {
+          config_.output_filename = filename;
+        });
+  }
+
+  CmdArgHandler arg_handler_;
+  bool do_print_and_exit_ { false };
+
+  LoadgenConfig config_;
+};
+
+int main(int argc, char* argv[]) {
+  LoadgenFrontend frontend;
+
+  std::vector<std::string> arguments { argv, argv + argc };
+  try {
+    frontend.init_from_arguments(arguments);
+
+    if (frontend.is_print_and_exit()) {
+      return 0;
+    }
+
+    frontend.run();
+  }
+  catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}